@@ -52,6 +52,18 @@ BOARD_TYPE ?= unknown
 # Default to release build
 BUILD_MODE ?= release
 
+# Default to no lock profiling
+# Override in Config.mk or on the command line (eg make LOCK_PROFILE=1)
+LOCK_PROFILE ?= 0
+
+# Default to no scheduler tracing
+# Override in Config.mk or on the command line (eg make SCHED_TRACE=1)
+SCHED_TRACE ?= 0
+
+# Default to no heap profiling
+# Override in Config.mk or on the command line (eg make HEAP_PROFILE=1)
+HEAP_PROFILE ?= 0
+
 # Default to level 2 optimization
 # Override in Config.mk or project Makefile (eg OPT_LEVEL = -O3)
 OPT_LEVEL ?= -O2
@@ -166,6 +178,27 @@ CC_FLAGS += -DRELEASE
 FPC_FLAGS += -dRELEASE
 endif
 
+# Setup lock profiling (Instrument lock functions and include the lock profiler)
+ifeq ($(strip $(LOCK_PROFILE)),1)
+CC_FLAGS += -DLOCK_PROFILE
+OBJS += lockprofile.o
+VPATH += $(API_PATH)/src/threads
+endif
+
+# Setup scheduler tracing (Instrument thread wake and ready and include the trace recorder)
+ifeq ($(strip $(SCHED_TRACE)),1)
+CC_FLAGS += -DSCHED_TRACE
+OBJS += schedtrace.o
+VPATH += $(API_PATH)/src/threads
+endif
+
+# Setup heap profiling (Instrument heap functions and include the heap profiler)
+ifeq ($(strip $(HEAP_PROFILE)),1)
+CC_FLAGS += -DHEAP_PROFILE
+OBJS += heapprofile.o
+VPATH += $(API_PATH)/src/heapmanager
+endif
+
 # Setup default libs if not set
 ifeq ($(strip $(LIBS)),)
 LIBS = c.a
@@ -233,6 +266,9 @@ info:
 	@echo  - ARCH_TYPE = $(ARCH_TYPE)
 	@echo  - BOARD_TYPE = $(BOARD_TYPE)
 	@echo  - BUILD_MODE = $(BUILD_MODE)
+	@echo  - LOCK_PROFILE = $(LOCK_PROFILE)
+	@echo  - SCHED_TRACE = $(SCHED_TRACE)
+	@echo  - HEAP_PROFILE = $(HEAP_PROFILE)
 	@echo  - OBJS = $(OBJS)
 	@echo  - LIBS = $(LIBS)
 	@echo  - AFLAGS = $(AFLAGS)
@@ -0,0 +1,142 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_BENCHMARK_H
+#define _ULTIBO_BENCHMARK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+
+/* ============================================================================== */
+/* Benchmark specific constants */
+#define BENCHMARK_NAME_LENGTH	48 // Maximum length of a benchmark name (Including the null terminator)
+
+#define BENCHMARK_DEFAULT_WARMUP	3 // Default number of runs discarded before measuring
+#define BENCHMARK_DEFAULT_REPEATS	25 // Default number of measured runs
+#define BENCHMARK_DEFAULT_RUN_TIME	10000 // Default minimum duration of a run when the iterations are chosen automatically (Microseconds)
+#define BENCHMARK_DEFAULT_PATH	"C:\\" // Default directory for the filesystem benchmarks
+
+#define BENCHMARK_MAX_REPEATS	10000 // Maximum number of measured runs
+#define BENCHMARK_MAX_ITERATIONS	0x40000000 // Maximum number of iterations in a run when chosen automatically
+#define BENCHMARK_CALIBRATE_TIME	100 // Time used to measure the rate of the clock counter (Milliseconds)
+#define BENCHMARK_PIN_RETRIES	100 // Number of times to yield while waiting to migrate to the requested CPU
+
+/* Benchmark Groups */
+#define BENCHMARK_GROUP_NONE	0x00000000
+#define BENCHMARK_GROUP_THREADS	0x00000001 // Locks, semaphores, events and context switches from threads.h
+#define BENCHMARK_GROUP_HEAP	0x00000002 // Heap allocation and release
+#define BENCHMARK_GROUP_CONSOLE	0x00000004 // Console window text output
+#define BENCHMARK_GROUP_FRAMEBUFFER	0x00000008 // Framebuffer rectangle fill and copy
+#define BENCHMARK_GROUP_FILESYSTEM	0x00000010 // File write and read
+#define BENCHMARK_GROUP_SOCKETS	0x00000020 // UDP and TCP over the loopback interface
+#define BENCHMARK_GROUP_USER	0x00010000 // Benchmarks supplied by the application
+
+#define BENCHMARK_GROUP_ALL	0x0000003F // All groups in the standard suite
+
+/* Benchmark Flags */
+#define BENCHMARK_FLAG_NONE	0x00000000
+#define BENCHMARK_FLAG_LOG	0x00000001 // Write a line to logging_output as each benchmark completes
+
+/* ============================================================================== */
+/* Benchmark specific types */
+typedef struct _BENCHMARK BENCHMARK;
+typedef struct _BENCHMARK_CONFIG BENCHMARK_CONFIG;
+
+/* Benchmark Procedures */
+typedef uint32_t STDCALL (*benchmark_setup_proc)(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, void **data); // Return ERROR_NOT_SUPPORTED to skip the benchmark
+typedef uint32_t STDCALL (*benchmark_run_proc)(void *data, uint32_t iterations);
+typedef void STDCALL (*benchmark_teardown_proc)(void *data);
+
+/* Benchmark */
+struct _BENCHMARK
+{
+	const char *name; // Name of the benchmark (eg "mutex_lock_unlock")
+	uint32_t group; // Group of the benchmark (eg BENCHMARK_GROUP_THREADS)
+	uint32_t iterations; // Operations performed by each run (0 to choose automatically from BENCHMARK_CONFIG.runtime)
+	benchmark_setup_proc setup; // Called once before the runs (Optional)
+	benchmark_run_proc run; // Performs iterations operations, only this call is timed
+	benchmark_teardown_proc teardown; // Called once after the runs (Optional)
+	void *parameter; // Passed to setup in benchmark->parameter
+};
+
+/* Benchmark Config */
+struct _BENCHMARK_CONFIG
+{
+	uint32_t warmup; // Number of runs discarded before measuring (0 for BENCHMARK_DEFAULT_WARMUP)
+	uint32_t repeats; // Number of measured runs (0 for BENCHMARK_DEFAULT_REPEATS)
+	uint32_t runtime; // Minimum duration of a run when choosing the iterations (Microseconds, 0 for BENCHMARK_DEFAULT_RUN_TIME)
+	uint32_t cpu; // CPU to pin the calling thread to while measuring (eg CPU_ID_1, or CPU_ID_ALL to leave the affinity unchanged)
+	uint32_t flags; // Benchmark flags (eg BENCHMARK_FLAG_LOG)
+	const char *path; // Directory for the filesystem benchmarks (Or NULL for BENCHMARK_DEFAULT_PATH)
+};
+
+/* Benchmark Result (All times are nanoseconds per operation) */
+typedef struct _BENCHMARK_RESULT BENCHMARK_RESULT;
+struct _BENCHMARK_RESULT
+{
+	char name[BENCHMARK_NAME_LENGTH]; // Name of the benchmark
+	uint32_t group; // Group of the benchmark (eg BENCHMARK_GROUP_HEAP)
+	uint32_t status; // ERROR_SUCCESS if the benchmark was run or the reason it was not
+	uint32_t cpu; // CPU the runs were measured on (CPU_ID_ALL if not pinned)
+	uint32_t iterations; // Operations performed by each run
+	uint32_t repeats; // Number of measured runs
+	double minimum;
+	double median;
+	double p99; // 99th percentile
+	double maximum;
+	double mean;
+	double stddev; // Standard deviation
+};
+
+/* ============================================================================== */
+/* Benchmark Functions */
+uint32_t STDCALL benchmark_run(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, BENCHMARK_RESULT *result); // Config may be NULL for all defaults
+uint32_t STDCALL benchmark_run_list(const BENCHMARK *benchmarks, uint32_t count, const BENCHMARK_CONFIG *config, BENCHMARK_RESULT *results);
+
+uint32_t STDCALL benchmark_suite_get_count(uint32_t groups);
+uint32_t STDCALL benchmark_suite_run(uint32_t groups, const BENCHMARK_CONFIG *config, BENCHMARK_RESULT *results, uint32_t len, uint32_t *count);
+
+uint32_t STDCALL benchmark_export(const BENCHMARK_RESULT *results, uint32_t count, char *buffer, uint32_t len, uint32_t *size); // Size returns the length of the JSON text (Excluding the null terminator)
+uint32_t STDCALL benchmark_export_file(const BENCHMARK_RESULT *results, uint32_t count, const char *filename);
+uint32_t STDCALL benchmark_export_serial(const BENCHMARK_RESULT *results, uint32_t count); // The default serial device must already be open (See serial_open)
+uint32_t STDCALL benchmark_export_log(const BENCHMARK_RESULT *results, uint32_t count);
+
+/* ============================================================================== */
+/* Benchmark Helper Functions */
+uint64_t STDCALL benchmark_get_clock_rate(void); // Measured rate of clock_get_count (Counts per second)
+
+uint32_t STDCALL benchmark_group_to_string(uint32_t group, char *string, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_BENCHMARK_H
@@ -0,0 +1,134 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_BOOTSTAGE_H
+#define _ULTIBO_BOOTSTAGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+
+/* ============================================================================== */
+/* Boot Stage specific constants */
+#define BOOT_STAGE_SIGNATURE	0x5B0A71C3
+
+#define BOOT_STAGE_THREAD_NAME	"Boot Stage" // Thread name for Boot stage threads
+#define BOOT_STAGE_THREAD_PRIORITY	THREAD_PRIORITY_HIGHER // Thread priority for Boot stage threads
+#define BOOT_STAGE_THREAD_STACK_SIZE	SIZE_32K // Stack size of Boot stage threads
+
+#define BOOT_STAGE_NAME_LENGTH	32 // Maximum length of a Boot stage name (Including the null terminator)
+#define BOOT_STAGE_MAX_DEPENDENCIES	8 // Maximum number of stages a Boot stage can depend on
+
+#define BOOT_STAGE_POLL_INTERVAL	5 // Interval between checks by the core stages (Milliseconds)
+#define BOOT_STAGE_CORE_TIMEOUT	30000 // Time after which a core stage fails if the subsystem has not started (Milliseconds)
+
+/* Core Boot Stages (Created automatically and started when first needed, these follow the asynchronous start of the core subsystems) */
+#define BOOT_STAGE_FILESYSTEM	"filesystem" // Ready when file_sys_start_completed returns TRUE
+#define BOOT_STAGE_DRIVE_C	"drive_c" // Ready when drive C:\ is available (Depends on filesystem)
+#define BOOT_STAGE_NETWORK	"network" // Ready when network_start_completed returns TRUE
+
+/* Boot Stage States */
+#define BOOT_STAGE_STATE_NONE	0 // Declared but not started
+#define BOOT_STAGE_STATE_WAITING	1 // Started and waiting for its dependencies
+#define BOOT_STAGE_STATE_RUNNING	2 // Start function is running
+#define BOOT_STAGE_STATE_READY	3 // Start function succeeded
+#define BOOT_STAGE_STATE_FAILED	4 // Start function or a required dependency failed
+
+/* Boot Stage Flags */
+#define BOOT_STAGE_FLAG_NONE	0x00000000
+#define BOOT_STAGE_FLAG_OPTIONAL	0x00000001 // Stages depending on this stage still start if it fails
+
+/* Boot Timeline Events */
+#define BOOT_EVENT_NONE	0
+#define BOOT_EVENT_INIT	1 // Boot stages initialized (The first entry of the timeline)
+#define BOOT_EVENT_START	2 // Stage start function called (Dependencies are ready)
+#define BOOT_EVENT_READY	3 // Stage ready
+#define BOOT_EVENT_FAILED	4 // Stage failed
+#define BOOT_EVENT_WAIT	5 // Waiting for a stage began (Only recorded if the stage was not yet ready)
+#define BOOT_EVENT_MARK	6 // Application mark (See boot_timeline_mark)
+
+#define BOOT_TIMELINE_MAX_ENTRIES	256 // Maximum entries recorded in the Boot timeline, later entries are counted but not stored
+
+/* ============================================================================== */
+/* Boot Stage specific types */
+typedef struct _BOOT_STAGE BOOT_STAGE;
+
+/* Boot Stage Start Procedure */
+typedef uint32_t STDCALL (*boot_stage_start_proc)(BOOT_STAGE *stage, void *data); // Called on the stage thread once all dependencies are ready, return ERROR_SUCCESS when the stage is ready
+
+/* Boot Timeline Entry */
+typedef struct _BOOT_TIMELINE_ENTRY BOOT_TIMELINE_ENTRY;
+struct _BOOT_TIMELINE_ENTRY
+{
+	char name[BOOT_STAGE_NAME_LENGTH]; // Name of the stage or mark
+	uint32_t event; // Timeline event (eg BOOT_EVENT_READY)
+	uint32_t status; // Status of the stage (BOOT_EVENT_READY and BOOT_EVENT_FAILED only)
+	uint32_t cpu; // CPU that recorded the entry
+	uint32_t count; // Value of clock_get_count when recorded
+	int64_t time; // Value of clock_microseconds when recorded
+};
+
+/* Boot Timeline Output */
+typedef void STDCALL (*boot_timeline_output_cb)(const char *text, void *data);
+
+/* ============================================================================== */
+/* Boot Stage Functions */
+BOOT_STAGE * STDCALL boot_stage_create(const char *name, boot_stage_start_proc start, void *data, uint32_t cpu, uint32_t flags); // Cpu = CPU_ID_ALL to spread stages over the secondary CPUs, returns NULL if the name is already in use
+uint32_t STDCALL boot_stage_depends(BOOT_STAGE *stage, BOOT_STAGE *dependency); // Must be called before the stage is started
+
+uint32_t STDCALL boot_stage_start(BOOT_STAGE *stage); // Also starts any dependencies not yet started
+uint32_t STDCALL boot_stage_start_all(void); // Start every declared stage not yet started
+
+BOOT_STAGE * STDCALL boot_stage_find(const char *name);
+
+uint32_t STDCALL boot_stage_wait(BOOT_STAGE *stage, uint32_t timeout); // Returns ERROR_SUCCESS when ready, ERROR_WAIT_TIMEOUT or the failure status of the stage (Starts the stage if not yet started, Timeout = INFINITE to wait forever)
+uint32_t STDCALL boot_stage_wait_name(const char *name, uint32_t timeout);
+
+uint32_t STDCALL boot_stage_get_state(BOOT_STAGE *stage);
+uint32_t STDCALL boot_stage_get_status(BOOT_STAGE *stage);
+uint32_t STDCALL boot_stage_get_name(BOOT_STAGE *stage, char *name, uint32_t len);
+
+/* ============================================================================== */
+/* Boot Timeline Functions */
+uint32_t STDCALL boot_timeline_mark(const char *name);
+
+uint32_t STDCALL boot_timeline_get(BOOT_TIMELINE_ENTRY *entries, uint32_t len, uint32_t *count); // Count returns the number of entries recorded (May exceed len)
+uint32_t STDCALL boot_timeline_log(boot_timeline_output_cb output, void *data); // Output = NULL to write to logging_output
+
+/* ============================================================================== */
+/* Boot Stage Helper Functions */
+uint32_t STDCALL boot_stage_state_to_string(uint32_t state, char *string, uint32_t len);
+uint32_t STDCALL boot_event_to_string(uint32_t event, char *string, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_BOOTSTAGE_H
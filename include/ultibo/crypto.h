@@ -0,0 +1,384 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_CRYPTO_H
+#define _ULTIBO_CRYPTO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+
+/* ============================================================================== */
+/* Crypto specific constants */
+#define CRYPTO_HASH_SIGNATURE	0x4A8D2C61
+#define CRYPTO_CIPHER_SIGNATURE	0x3B7E95D2
+
+/* Crypto Features (Instructions used when available on the current CPU) */
+#define CRYPTO_FEATURE_NONE	0x00000000
+#define CRYPTO_FEATURE_AES	0x00000001 // ARMv8 AES instructions (AESE/AESD/AESMC/AESIMC)(64bit only)
+#define CRYPTO_FEATURE_PMULL	0x00000002 // ARMv8 64 bit polynomial multiply (PMULL/PMULL2) used for GCM (64bit only)
+#define CRYPTO_FEATURE_SHA1	0x00000004 // ARMv8 SHA1 instructions (64bit only)
+#define CRYPTO_FEATURE_SHA256	0x00000008 // ARMv8 SHA256 instructions (64bit only)
+#define CRYPTO_FEATURE_CRC32	0x00000010 // ARMv8 CRC32 and CRC32C instructions (32bit and 64bit)
+
+#define CRYPTO_FEATURE_ALL	0x0000001F
+
+/* Cipher Algorithms */
+#define CRYPTO_CIPHER_ALG_NONE	0
+#define CRYPTO_CIPHER_ALG_AES	1
+#define CRYPTO_CIPHER_ALG_DES	2
+#define CRYPTO_CIPHER_ALG_3DES	3
+#define CRYPTO_CIPHER_ALG_RC4	4
+
+/* Cipher Modes */
+#define CRYPTO_CIPHER_MODE_NONE	0 // Stream ciphers only (eg CRYPTO_CIPHER_ALG_RC4)
+#define CRYPTO_CIPHER_MODE_ECB	1 // Electronic Codebook (Size must be a multiple of the block size)
+#define CRYPTO_CIPHER_MODE_CBC	2 // Cipher Block Chaining (Size must be a multiple of the block size)
+#define CRYPTO_CIPHER_MODE_CTR	3 // Counter (Any size, the counter is the big endian vector incremented per block)
+
+/* Hash Algorithms */
+#define CRYPTO_HASH_ALG_NONE	0
+#define CRYPTO_HASH_ALG_MD5	1
+#define CRYPTO_HASH_ALG_SHA1	2
+#define CRYPTO_HASH_ALG_SHA256	3
+#define CRYPTO_HASH_ALG_SHA384	4
+#define CRYPTO_HASH_ALG_SHA512	5
+#define CRYPTO_HASH_ALG_HMAC_MD5	6
+#define CRYPTO_HASH_ALG_HMAC_SHA1	7
+#define CRYPTO_HASH_ALG_HMAC_SHA256	8
+#define CRYPTO_HASH_ALG_HMAC_SHA384	9
+#define CRYPTO_HASH_ALG_HMAC_SHA512	10
+#define CRYPTO_HASH_ALG_CRC32	11 // Digest is the 4 byte big endian CRC
+#define CRYPTO_HASH_ALG_CRC32C	12 // Digest is the 4 byte big endian CRC
+
+#define CRYPTO_HASH_MAX_DIGEST_SIZE	64 // Largest digest returned by hash_finish (SHA512)
+
+/* MD5 and SHA constants */
+#define MD5_DIGEST_SIZE	16
+#define SHA1_DIGEST_SIZE	20
+#define SHA256_DIGEST_SIZE	32
+#define SHA384_DIGEST_SIZE	48
+#define SHA512_DIGEST_SIZE	64
+
+#define MD5_CHUNK_SIZE	64 // Size of the blocks processed by the compression function (Bytes)
+#define SHA1_CHUNK_SIZE	64
+#define SHA256_CHUNK_SIZE	64
+#define SHA512_CHUNK_SIZE	128
+
+/* AES constants */
+#define AES_BLOCK_SIZE	16
+#define AES_KEY_SIZE128	16
+#define AES_KEY_SIZE192	24
+#define AES_KEY_SIZE256	32
+#define AES_MAX_ROUNDS	14
+
+#define AES_GCM_TAG_SIZE	16
+#define AES_GCM_IV_SIZE	12 // Recommended IV size for GCM (Other sizes are hashed to form the initial counter)
+
+/* DES constants */
+#define DES_BLOCK_SIZE	8
+#define DES_KEY_SIZE	8
+#define DES3_KEY_SIZE	24 // Three independent keys (16 bytes is also accepted with K3 = K1)
+
+/* RC4 constants */
+#define RC4_MAX_KEY_SIZE	256
+
+/* ============================================================================== */
+/* Crypto specific types */
+/* Data Block (Chain of data blocks passed to the digest data functions) */
+typedef struct _CRYPTO_BLOCK CRYPTO_BLOCK;
+struct _CRYPTO_BLOCK
+{
+	void *data; // Pointer to the data
+	uint32_t size; // Size of the data (Bytes)
+	CRYPTO_BLOCK *next; // Next block in the chain (or NULL)
+};
+
+/* Digests */
+typedef uint8_t MD5_DIGEST[MD5_DIGEST_SIZE];
+typedef uint8_t SHA1_DIGEST[SHA1_DIGEST_SIZE];
+typedef uint8_t SHA256_DIGEST[SHA256_DIGEST_SIZE];
+typedef uint8_t SHA384_DIGEST[SHA384_DIGEST_SIZE];
+typedef uint8_t SHA512_DIGEST[SHA512_DIGEST_SIZE];
+
+/* MD5 Context */
+typedef struct _MD5_CONTEXT MD5_CONTEXT;
+struct _MD5_CONTEXT
+{
+	uint32_t state[4];
+	uint64_t count; // Total bytes hashed
+	uint8_t buffer[MD5_CHUNK_SIZE]; // Partial chunk waiting for more data
+};
+
+/* SHA1 Context */
+typedef struct _SHA1_CONTEXT SHA1_CONTEXT;
+struct _SHA1_CONTEXT
+{
+	uint32_t state[5];
+	uint64_t count;
+	uint8_t buffer[SHA1_CHUNK_SIZE];
+};
+
+/* SHA256 Context */
+typedef struct _SHA256_CONTEXT SHA256_CONTEXT;
+struct _SHA256_CONTEXT
+{
+	uint32_t state[8];
+	uint64_t count;
+	uint8_t buffer[SHA256_CHUNK_SIZE];
+};
+
+/* SHA512 Context (Also used for SHA384) */
+typedef struct _SHA512_CONTEXT SHA512_CONTEXT;
+struct _SHA512_CONTEXT
+{
+	uint64_t state[8];
+	uint64_t count;
+	uint8_t buffer[SHA512_CHUNK_SIZE];
+};
+
+typedef SHA512_CONTEXT SHA384_CONTEXT;
+
+/* Hash Context (Returned by hash_create) */
+typedef struct _HASH_CONTEXT HASH_CONTEXT;
+
+/* AES Key (Round keys are stored in byte order so they can be used by the C path and the AES instructions) */
+typedef struct _AES_KEY AES_KEY;
+struct _AES_KEY
+{
+	uint32_t rounds; // Number of rounds (10, 12 or 14)
+	uint32_t encrypt[4 * (AES_MAX_ROUNDS + 1)]; // Encryption round keys
+	uint32_t decrypt[4 * (AES_MAX_ROUNDS + 1)]; // Decryption round keys (Equivalent inverse cipher)
+};
+
+/* AES CTR Context */
+typedef struct _AES_CTR_CONTEXT AES_CTR_CONTEXT;
+struct _AES_CTR_CONTEXT
+{
+	AES_KEY key;
+	uint8_t counter[AES_BLOCK_SIZE]; // Next counter block (Big endian, the whole block is incremented)
+	uint8_t stream[AES_BLOCK_SIZE]; // Key stream of the current block
+	uint32_t used; // Bytes of stream already used (AES_BLOCK_SIZE if none remain)
+};
+
+/* AES GCM Context */
+typedef struct _AES_GCM_CONTEXT AES_GCM_CONTEXT;
+struct _AES_GCM_CONTEXT
+{
+	AES_KEY key;
+	uint64_t table[16][2]; // GHASH multiplication table for the hash key (4 bit)
+	uint8_t hash[AES_BLOCK_SIZE]; // Hash key H (Encrypted zero block)
+	uint8_t ghash[AES_BLOCK_SIZE]; // Running GHASH value
+	uint8_t partial[AES_BLOCK_SIZE]; // Partial block waiting to be hashed
+	uint8_t initial[AES_BLOCK_SIZE]; // Initial counter block J0 (Used to encrypt the tag)
+	uint8_t counter[AES_BLOCK_SIZE]; // Current counter block
+	uint8_t stream[AES_BLOCK_SIZE]; // Key stream of the current block
+	uint64_t aadsize; // Bytes of additional data hashed
+	uint64_t datasize; // Bytes of data encrypted or decrypted
+	uint32_t partialsize; // Bytes waiting in partial
+	uint32_t used; // Bytes of stream already used
+	uint32_t state; // Internal state (Additional data, data or finished)
+};
+
+/* DES Key (Expanded key schedule, 16 rounds of 2 words) */
+typedef struct _DES_KEY DES_KEY;
+struct _DES_KEY
+{
+	uint32_t keys[32];
+};
+
+/* 3DES Key */
+typedef struct _DES3_KEY DES3_KEY;
+struct _DES3_KEY
+{
+	DES_KEY encrypt[3]; // Schedules applied in order to encrypt (K1 encrypt, K2 decrypt, K3 encrypt)
+	DES_KEY decrypt[3]; // Schedules applied in order to decrypt (K3 decrypt, K2 encrypt, K1 decrypt)
+};
+
+/* RC4 State */
+typedef struct _RC4_STATE RC4_STATE;
+struct _RC4_STATE
+{
+	uint8_t s[256];
+	uint8_t i;
+	uint8_t j;
+};
+
+/* Cipher Context (Returned by cipher_create) */
+typedef struct _CIPHER_CONTEXT CIPHER_CONTEXT;
+
+/* ============================================================================== */
+/* Crypto Functions */
+uint32_t STDCALL crypto_get_features(void); // Return the CRYPTO_FEATURE_* instructions currently in use
+uint32_t STDCALL crypto_set_features(uint32_t features); // Restrict the instructions used to features (Only those detected can be enabled), returns the features now in use
+uint32_t STDCALL crypto_get_available(void); // Return the CRYPTO_FEATURE_* instructions detected on this CPU
+
+/* ============================================================================== */
+/* MD5 Functions */
+void STDCALL md5_init(MD5_CONTEXT *context);
+void STDCALL md5_update(MD5_CONTEXT *context, const void *data, size_t size);
+void STDCALL md5_final(MD5_CONTEXT *context, MD5_DIGEST digest);
+
+BOOL STDCALL md5_digest_data(CRYPTO_BLOCK *data, MD5_DIGEST digest);
+BOOL STDCALL md5_digest_string(const char *value, MD5_DIGEST digest);
+uint32_t STDCALL md5_digest_to_string(const MD5_DIGEST digest, char *string, uint32_t len);
+
+BOOL STDCALL hmac_md5_digest_data(const void *key, uint32_t keysize, CRYPTO_BLOCK *data, MD5_DIGEST digest);
+BOOL STDCALL hmac_md5_digest_string(const char *key, const char *value, MD5_DIGEST digest);
+
+/* ============================================================================== */
+/* SHA1 Functions */
+void STDCALL sha1_init(SHA1_CONTEXT *context);
+void STDCALL sha1_update(SHA1_CONTEXT *context, const void *data, size_t size);
+void STDCALL sha1_final(SHA1_CONTEXT *context, SHA1_DIGEST digest);
+
+BOOL STDCALL sha1_digest_data(CRYPTO_BLOCK *data, SHA1_DIGEST digest);
+BOOL STDCALL sha1_digest_string(const char *value, SHA1_DIGEST digest);
+uint32_t STDCALL sha1_digest_to_string(const SHA1_DIGEST digest, char *string, uint32_t len);
+
+BOOL STDCALL hmac_sha1_digest_data(const void *key, uint32_t keysize, CRYPTO_BLOCK *data, SHA1_DIGEST digest);
+BOOL STDCALL hmac_sha1_digest_string(const char *key, const char *value, SHA1_DIGEST digest);
+
+/* ============================================================================== */
+/* SHA256 Functions */
+void STDCALL sha256_init(SHA256_CONTEXT *context);
+void STDCALL sha256_update(SHA256_CONTEXT *context, const void *data, size_t size);
+void STDCALL sha256_final(SHA256_CONTEXT *context, SHA256_DIGEST digest);
+
+BOOL STDCALL sha256_digest_data(CRYPTO_BLOCK *data, SHA256_DIGEST digest);
+BOOL STDCALL sha256_digest_string(const char *value, SHA256_DIGEST digest);
+uint32_t STDCALL sha256_digest_to_string(const SHA256_DIGEST digest, char *string, uint32_t len);
+
+BOOL STDCALL hmac_sha256_digest_data(const void *key, uint32_t keysize, CRYPTO_BLOCK *data, SHA256_DIGEST digest);
+BOOL STDCALL hmac_sha256_digest_string(const char *key, const char *value, SHA256_DIGEST digest);
+
+/* ============================================================================== */
+/* SHA384 Functions */
+void STDCALL sha384_init(SHA384_CONTEXT *context);
+void STDCALL sha384_update(SHA384_CONTEXT *context, const void *data, size_t size);
+void STDCALL sha384_final(SHA384_CONTEXT *context, SHA384_DIGEST digest);
+
+BOOL STDCALL sha384_digest_data(CRYPTO_BLOCK *data, SHA384_DIGEST digest);
+BOOL STDCALL sha384_digest_string(const char *value, SHA384_DIGEST digest);
+uint32_t STDCALL sha384_digest_to_string(const SHA384_DIGEST digest, char *string, uint32_t len);
+
+/* ============================================================================== */
+/* SHA512 Functions */
+void STDCALL sha512_init(SHA512_CONTEXT *context);
+void STDCALL sha512_update(SHA512_CONTEXT *context, const void *data, size_t size);
+void STDCALL sha512_final(SHA512_CONTEXT *context, SHA512_DIGEST digest);
+
+BOOL STDCALL sha512_digest_data(CRYPTO_BLOCK *data, SHA512_DIGEST digest);
+BOOL STDCALL sha512_digest_string(const char *value, SHA512_DIGEST digest);
+uint32_t STDCALL sha512_digest_to_string(const SHA512_DIGEST digest, char *string, uint32_t len);
+
+/* ============================================================================== */
+/* CRC Functions */
+uint32_t STDCALL crc32_update(uint32_t crc, const void *data, size_t size); // IEEE 802.3 CRC (Compatible with zlib crc32, pass 0 to start)
+uint32_t STDCALL crc32c_update(uint32_t crc, const void *data, size_t size); // Castagnoli CRC (As used by iSCSI and ext4, pass 0 to start)
+
+/* ============================================================================== */
+/* Hash Functions */
+HASH_CONTEXT * STDCALL hash_create(uint32_t algorithm, const void *key, uint32_t keysize); // Key is only used by the HMAC algorithms
+BOOL STDCALL hash_destroy(HASH_CONTEXT *context);
+
+BOOL STDCALL hash_reset(HASH_CONTEXT *context); // Restart the hash keeping the same algorithm and key
+BOOL STDCALL hash_update(HASH_CONTEXT *context, const void *data, size_t size);
+BOOL STDCALL hash_finish(HASH_CONTEXT *context, void *digest, uint32_t size); // Size must be at least the digest size of the algorithm
+
+uint32_t STDCALL hash_get_digest_size(uint32_t algorithm);
+
+/* ============================================================================== */
+/* AES Functions */
+BOOL STDCALL aes_key_setup(const void *key, uint32_t keysize, AES_KEY *aeskey);
+void STDCALL aes_encrypt_block(const void *plain, void *crypt, AES_KEY *aeskey);
+void STDCALL aes_decrypt_block(const void *crypt, void *plain, AES_KEY *aeskey);
+
+BOOL STDCALL aes_ecb_encrypt(AES_KEY *aeskey, const void *plain, void *crypt, size_t size); // Size must be a multiple of AES_BLOCK_SIZE
+BOOL STDCALL aes_ecb_decrypt(AES_KEY *aeskey, const void *crypt, void *plain, size_t size);
+BOOL STDCALL aes_cbc_encrypt(AES_KEY *aeskey, uint8_t *vector, const void *plain, void *crypt, size_t size); // Vector is updated so calls can be chained
+BOOL STDCALL aes_cbc_decrypt(AES_KEY *aeskey, uint8_t *vector, const void *crypt, void *plain, size_t size);
+
+BOOL STDCALL aes_ctr_init(AES_CTR_CONTEXT *context, const void *key, uint32_t keysize, const void *nonce); // Nonce is the initial 16 byte counter block
+void STDCALL aes_ctr_update(AES_CTR_CONTEXT *context, const void *input, void *output, size_t size); // Encrypt and decrypt are the same operation
+
+BOOL STDCALL aes_ctr_encrypt_data(const void *key, uint32_t keysize, const void *nonce, const void *plain, void *crypt, size_t size);
+BOOL STDCALL aes_ctr_decrypt_data(const void *key, uint32_t keysize, const void *nonce, const void *crypt, void *plain, size_t size);
+
+BOOL STDCALL aes_gcm_init(AES_GCM_CONTEXT *context, const void *key, uint32_t keysize, const void *iv, uint32_t ivsize);
+BOOL STDCALL aes_gcm_aad(AES_GCM_CONTEXT *context, const void *aad, size_t size); // All additional data must be passed before any data
+BOOL STDCALL aes_gcm_encrypt(AES_GCM_CONTEXT *context, const void *plain, void *crypt, size_t size);
+BOOL STDCALL aes_gcm_decrypt(AES_GCM_CONTEXT *context, const void *crypt, void *plain, size_t size);
+BOOL STDCALL aes_gcm_final(AES_GCM_CONTEXT *context, void *tag); // Tag is AES_GCM_TAG_SIZE bytes
+BOOL STDCALL aes_gcm_verify(AES_GCM_CONTEXT *context, const void *tag, uint32_t tagsize); // Compare the tag in constant time
+
+BOOL STDCALL aes_gcm_encrypt_data(const void *key, uint32_t keysize, const void *iv, const void *aad, const void *plain, void *crypt, uint32_t ivsize, uint32_t aadsize, size_t size, void *tag);
+BOOL STDCALL aes_gcm_decrypt_data(const void *key, uint32_t keysize, const void *iv, const void *aad, const void *crypt, void *plain, uint32_t ivsize, uint32_t aadsize, size_t size, const void *tag); // Returns FALSE if the tag does not match
+BOOL STDCALL aes_gcm_gmac_data(const void *key, uint32_t keysize, const void *iv, const void *aad, uint32_t ivsize, uint32_t aadsize, void *tag);
+
+/* ============================================================================== */
+/* DES Functions */
+BOOL STDCALL des_key_setup(const void *key, uint32_t keysize, DES_KEY *encryptkey, DES_KEY *decryptkey);
+void STDCALL des_encrypt_block(const void *plain, void *crypt, DES_KEY *key); // Pass the encrypt key to encrypt or the decrypt key to decrypt
+void STDCALL des_decrypt_block(const void *crypt, void *plain, DES_KEY *key); // Key must be the decrypt key from des_key_setup
+
+BOOL STDCALL des3_key_setup(const void *key, uint32_t keysize, DES3_KEY *des3key);
+void STDCALL des3_encrypt_block(const void *plain, void *crypt, DES3_KEY *des3key);
+void STDCALL des3_decrypt_block(const void *crypt, void *plain, DES3_KEY *des3key);
+
+/* ============================================================================== */
+/* RC4 Functions */
+BOOL STDCALL rc4_init(RC4_STATE *state, const void *key, uint32_t keysize);
+void STDCALL rc4_update(RC4_STATE *state, const void *input, void *output, size_t size); // Encrypt and decrypt are the same operation
+
+BOOL STDCALL rc4_encrypt_data(const void *key, uint32_t keysize, const void *plain, void *crypt, size_t size, uint32_t start); // Start is the number of key stream bytes to discard first
+BOOL STDCALL rc4_decrypt_data(const void *key, uint32_t keysize, const void *crypt, void *plain, size_t size, uint32_t start);
+
+/* ============================================================================== */
+/* Cipher Functions */
+CIPHER_CONTEXT * STDCALL cipher_create(uint32_t algorithm, const void *vector, const void *key, uint32_t keysize); // Block ciphers use CBC mode
+CIPHER_CONTEXT * STDCALL cipher_create_ex(uint32_t algorithm, uint32_t mode, const void *vector, const void *key, uint32_t keysize);
+BOOL STDCALL cipher_destroy(CIPHER_CONTEXT *context);
+
+BOOL STDCALL cipher_encrypt(CIPHER_CONTEXT *context, const void *plain, void *crypt, size_t size);
+BOOL STDCALL cipher_decrypt(CIPHER_CONTEXT *context, const void *crypt, void *plain, size_t size);
+
+uint32_t STDCALL cipher_get_block_size(uint32_t algorithm);
+
+/* ============================================================================== */
+/* Crypto Helper Functions */
+uint32_t STDCALL crypto_features_to_string(uint32_t features, char *string, uint32_t len);
+uint32_t STDCALL crypto_cipher_alg_to_string(uint32_t algorithm, char *string, uint32_t len);
+uint32_t STDCALL crypto_hash_alg_to_string(uint32_t algorithm, char *string, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_CRYPTO_H
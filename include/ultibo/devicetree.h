@@ -170,6 +170,12 @@ extern "C" {
 /* DTB Property Types */
 #define DTB_MAX_PROPERTY_TYPE	60
 
+/* Device Tree Index */
+#define DEVICE_TREE_INDEX_SIGNATURE	0x7C3E91A4
+
+#define DEVICE_TREE_INDEX_MAX_PATH	256 // Maximum length of a path passed to device_tree_index_find_node (After alias expansion, including the null terminator)
+#define DEVICE_TREE_INDEX_MAX_DEPTH	64 // Maximum nesting of nodes accepted by device_tree_index_create
+
 /* ============================================================================== */
 /* Device Tree specific types */
 /* DTB Header */
@@ -247,6 +253,21 @@ struct _DTB_PROPERTY_QUADWORD
 	uint64_t value[1]; // The property value as an array of quadwords of value length (big-endian)
 } PACKED;
 
+/* Device Tree Index */
+typedef struct _DEVICE_TREE_INDEX DEVICE_TREE_INDEX;
+
+/* Device Tree Index Info */
+typedef struct _DEVICE_TREE_INDEX_INFO DEVICE_TREE_INDEX_INFO;
+struct _DEVICE_TREE_INDEX_INFO
+{
+	uint32_t nodecount; // Number of nodes in the tree
+	uint32_t propertycount; // Number of properties in the tree
+	uint32_t namecount; // Number of distinct property names
+	uint32_t compatiblecount; // Number of distinct compatible strings
+	uint32_t phandlecount; // Number of nodes with a phandle
+	uint32_t size; // Memory used by the index (Bytes, excluding the blob itself)
+};
+
 /* ============================================================================== */
 /* Device Tree Logging specific types */
 typedef void STDCALL (*dtb_log_output_cb)(const char *text, void *data);
@@ -293,6 +314,31 @@ BOOL STDCALL device_tree_get_reservation(uint32_t index, size_t *address, uint64
 uint32_t STDCALL device_tree_log_tree(void);
 uint32_t STDCALL device_tree_log_tree_ex(HANDLE node, dtb_log_output_cb output, dtb_decode_value_cb decode, void *data);
 
+/* ============================================================================== */
+/* Device Tree Index Functions */
+/* Node and property handles are the same as those of device_tree_next_node and device_tree_next_property when indexing the boot device tree */
+/* Passing NULL for index uses the index of the boot device tree (See device_tree_index_get_default) */
+DEVICE_TREE_INDEX * STDCALL device_tree_index_create(const void *blob, uint32_t size); // The blob must remain valid and unchanged until the index is destroyed
+uint32_t STDCALL device_tree_index_destroy(DEVICE_TREE_INDEX *index);
+
+DEVICE_TREE_INDEX * STDCALL device_tree_index_get_default(void); // Built on the first call, returns NULL if there is no valid boot device tree
+uint32_t STDCALL device_tree_index_get_info(DEVICE_TREE_INDEX *index, DEVICE_TREE_INDEX_INFO *info);
+
+HANDLE STDCALL device_tree_index_find_node(DEVICE_TREE_INDEX *index, const char *path); // Path is a full path (eg "/soc/serial@7e201000") or starts with an alias (eg "serial0" or "i2c1/rtc@68")
+HANDLE STDCALL device_tree_index_find_phandle(DEVICE_TREE_INDEX *index, uint32_t phandle);
+HANDLE STDCALL device_tree_index_find_compatible(DEVICE_TREE_INDEX *index, const char *compatible, uint32_t instance); // Instance 0 is the first matching node in tree order
+uint32_t STDCALL device_tree_index_count_compatible(DEVICE_TREE_INDEX *index, const char *compatible);
+HANDLE STDCALL device_tree_index_find_property(DEVICE_TREE_INDEX *index, HANDLE node, const char *name);
+
+HANDLE STDCALL device_tree_index_next_node(DEVICE_TREE_INDEX *index, HANDLE previous); // Every node in tree order, previous = INVALID_HANDLE_VALUE to start from the root
+HANDLE STDCALL device_tree_index_get_parent(DEVICE_TREE_INDEX *index, HANDLE node);
+
+const char * STDCALL device_tree_index_get_node_name(DEVICE_TREE_INDEX *index, HANDLE node);
+uint32_t STDCALL device_tree_index_get_node_path(DEVICE_TREE_INDEX *index, HANDLE node, char *path, uint32_t len); // Returns the length of the path (Excluding the null terminator) or 0 on failure
+
+const char * STDCALL device_tree_index_get_property_name(DEVICE_TREE_INDEX *index, HANDLE property);
+void * STDCALL device_tree_index_get_property_value(DEVICE_TREE_INDEX *index, HANDLE property, uint32_t *length);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,79 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_FRAMEBUFFERDMA_H
+#define _ULTIBO_FRAMEBUFFERDMA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/framebuffer.h"
+#include "ultibo/dma.h"
+
+/* ============================================================================== */
+/* Framebuffer DMA specific constants */
+#define FRAMEBUFFER_DMA_MAX_DEVICES	4 // Maximum number of framebuffer devices with DMA copy attached
+#define FRAMEBUFFER_DMA_DEFAULT_THRESHOLD	SIZE_32K // Regions smaller than this are copied by the CPU (Bytes)
+#define FRAMEBUFFER_DMA_TIMEOUT	1000 // Maximum time to wait for a DMA copy to complete (Milliseconds)
+
+#define FRAMEBUFFER_DMA_THRESHOLD_NEVER	0xFFFFFFFF // Threshold value to always copy with the CPU
+
+/* ============================================================================== */
+/* Framebuffer DMA specific types */
+
+/* Framebuffer DMA Statistics */
+typedef struct _FRAMEBUFFER_DMA_STATISTICS FRAMEBUFFER_DMA_STATISTICS;
+struct _FRAMEBUFFER_DMA_STATISTICS
+{
+	uint32_t threshold; // Current CPU copy threshold (Bytes)
+	uint32_t stridesupport; // Non zero if the DMA host supports 2D stride (Otherwise one block per row)
+	uint32_t copycount; // Number of copy rect requests
+	uint32_t dmacount; // Number of copies performed by DMA
+	uint32_t cpucount; // Number of copies performed by the CPU
+	uint32_t dmaerrors; // Number of DMA copies that failed and were completed by the CPU
+	uint64_t dmabytes; // Total bytes copied by DMA
+	uint64_t cpubytes; // Total bytes copied by the CPU
+	int64_t dmatime; // Total time spent in DMA copies (Microseconds)
+	int64_t cputime; // Total time spent in CPU copies (Microseconds)
+};
+
+/* ============================================================================== */
+/* Framebuffer DMA Functions */
+uint32_t STDCALL framebuffer_device_dma_attach(FRAMEBUFFER_DEVICE *framebuffer, uint32_t threshold);
+uint32_t STDCALL framebuffer_device_dma_detach(FRAMEBUFFER_DEVICE *framebuffer);
+
+uint32_t STDCALL framebuffer_device_dma_set_threshold(FRAMEBUFFER_DEVICE *framebuffer, uint32_t threshold);
+
+uint32_t STDCALL framebuffer_device_dma_get_statistics(FRAMEBUFFER_DEVICE *framebuffer, FRAMEBUFFER_DMA_STATISTICS *statistics);
+uint32_t STDCALL framebuffer_device_dma_reset_statistics(FRAMEBUFFER_DEVICE *framebuffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_FRAMEBUFFERDMA_H
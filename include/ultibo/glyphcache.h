@@ -0,0 +1,98 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_GLYPHCACHE_H
+#define _ULTIBO_GLYPHCACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/font.h"
+#include "ultibo/framebuffer.h"
+#include "ultibo/console.h"
+
+/* ============================================================================== */
+/* Glyph Cache specific constants */
+#define GLYPH_CACHE_DEFAULT_ENTRIES	8 // Default number of (Font, Forecolor, Backcolor) entries in a Glyph cache
+#define GLYPH_CACHE_MAX_ENTRIES	64 // Maximum number of entries in a Glyph cache
+
+/* Glyph Cache Flags */
+#define GLYPH_CACHE_FLAG_NONE	0x00000000
+#define GLYPH_CACHE_FLAG_TEXT	0x00000001 // Draw console text and characters from the Glyph cache with one blit per line
+#define GLYPH_CACHE_FLAG_SCROLL	0x00000002 // Scroll console regions by moving the framebuffer memory directly
+#define GLYPH_CACHE_FLAG_ALL	(GLYPH_CACHE_FLAG_TEXT | GLYPH_CACHE_FLAG_SCROLL)
+
+/* ============================================================================== */
+/* Glyph Cache specific types */
+
+/* Glyph Cache Statistics */
+typedef struct _GLYPH_CACHE_STATISTICS GLYPH_CACHE_STATISTICS;
+struct _GLYPH_CACHE_STATISTICS
+{
+	uint32_t entrycount; // Number of entries currently in the cache
+	uint32_t memoryused; // Memory allocated for expanded glyphs (Bytes)
+	uint32_t hitcount; // Number of lookups that found an existing entry
+	uint32_t misscount; // Number of lookups that created a new entry
+	uint32_t evictcount; // Number of entries discarded to make room for a new entry
+	uint32_t expandcount; // Number of glyphs expanded to pixels
+	uint32_t textcount; // Number of text runs rendered
+	uint32_t charcount; // Number of characters rendered
+	uint32_t scrollcount; // Number of console scrolls performed by direct copy
+};
+
+/* Glyph Cache */
+typedef struct _GLYPH_CACHE GLYPH_CACHE;
+
+/* ============================================================================== */
+/* Glyph Cache Functions */
+GLYPH_CACHE * STDCALL glyph_cache_create(uint32_t format, uint32_t maxentries);
+uint32_t STDCALL glyph_cache_destroy(GLYPH_CACHE *cache);
+
+uint32_t STDCALL glyph_cache_flush(GLYPH_CACHE *cache);
+
+uint32_t STDCALL glyph_cache_render_text(GLYPH_CACHE *cache, FONT_HANDLE font, const char *text, uint32_t len, uint32_t forecolor, uint32_t backcolor, void *buffer, uint32_t pitch);
+
+uint32_t STDCALL glyph_cache_get_statistics(GLYPH_CACHE *cache, GLYPH_CACHE_STATISTICS *statistics);
+
+/* ============================================================================== */
+/* Console Glyph Cache Functions */
+uint32_t STDCALL console_device_glyph_cache_attach(CONSOLE_DEVICE *console, FRAMEBUFFER_DEVICE *framebuffer, uint32_t flags);
+uint32_t STDCALL console_device_glyph_cache_detach(CONSOLE_DEVICE *console);
+
+GLYPH_CACHE * STDCALL console_device_glyph_cache_get(CONSOLE_DEVICE *console);
+
+/* ============================================================================== */
+/* Glyph Cache Helper Functions */
+uint32_t STDCALL glyph_color_format_bytes(uint32_t format);
+uint32_t STDCALL glyph_color_to_format(uint32_t color, uint32_t format, void *dest, BOOL reverse);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_GLYPHCACHE_H
@@ -353,4 +353,9 @@ uint32_t STDCALL destroy_heap_snapshot(HEAP_SNAPSHOT *snapshot);
 }
 #endif
 
+/* Redirect heap functions to the instrumented versions in heap profiling builds (make HEAP_PROFILE=1) */
+#ifdef HEAP_PROFILE
+#include "ultibo/heapprofile.h"
+#endif
+
 #endif // _ULTIBO_HEAPMANAGER_H
\ No newline at end of file
@@ -0,0 +1,295 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_HEAPPROFILE_H
+#define _ULTIBO_HEAPPROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/heapmanager.h"
+#include "ultibo/threads.h"
+
+/* ============================================================================== */
+/* Heap Profile specific constants */
+#define HEAP_PROFILE_DEFAULT_BLOCKS	32768 // Default maximum number of live blocks tracked (Rounded up to a power of 2)
+#define HEAP_PROFILE_MAX_SITES	1024 // Maximum number of unique allocation sites (Caller and flags) tracked (Must be a power of 2)
+
+/* Heap Profile Types (Index of the per type totals, blocks are counted by their lowest HEAP_FLAG_* bit) */
+#define HEAP_PROFILE_TYPE_NORMAL	0 // HEAP_FLAG_NORMAL
+#define HEAP_PROFILE_TYPE_SHARED	1 // HEAP_FLAG_SHARED
+#define HEAP_PROFILE_TYPE_LOCAL	2 // HEAP_FLAG_LOCAL
+#define HEAP_PROFILE_TYPE_CODE	3 // HEAP_FLAG_CODE
+#define HEAP_PROFILE_TYPE_DEVICE	4 // HEAP_FLAG_DEVICE
+#define HEAP_PROFILE_TYPE_NOCACHE	5 // HEAP_FLAG_NOCACHE
+#define HEAP_PROFILE_TYPE_NONSHARED	6 // HEAP_FLAG_NONSHARED
+#define HEAP_PROFILE_TYPE_LOCKED	7 // HEAP_FLAG_LOCKED
+#define HEAP_PROFILE_TYPE_IRQ	8 // HEAP_FLAG_IRQ
+#define HEAP_PROFILE_TYPE_FIQ	9 // HEAP_FLAG_FIQ
+#define HEAP_PROFILE_TYPE_RECLAIM	10 // HEAP_FLAG_RECLAIM
+#define HEAP_PROFILE_TYPE_OTHER	11 // Any other flags (eg HEAP_FLAG_CUSTOM)
+
+#define HEAP_PROFILE_TYPE_COUNT	12
+
+/* ============================================================================== */
+/* Heap Profile specific types */
+
+/* Heap Profile Block (A live block being tracked) */
+typedef struct _HEAP_PROFILE_BLOCK HEAP_PROFILE_BLOCK;
+struct _HEAP_PROFILE_BLOCK
+{
+	void *address; // Address of the block (NULL if the entry is free)
+	size_t size; // Requested size of the block
+	size_t caller; // Address of the caller that allocated the block
+	uint32_t flags; // Heap flags of the block (eg HEAP_FLAG_SHARED)
+	uint32_t sequence; // Allocation sequence number (Compare with the sequence of a snapshot)
+	THREAD_HANDLE thread; // Thread that allocated the block
+};
+
+/* Heap Profile Site (Live allocations from one caller with one set of flags) */
+typedef struct _HEAP_PROFILE_SITE HEAP_PROFILE_SITE;
+struct _HEAP_PROFILE_SITE
+{
+	size_t caller; // Address of the caller (Use addr2line on the host to find the source line)
+	uint32_t flags; // Heap flags of the allocations (eg HEAP_FLAG_SHARED)
+	uint32_t livecount; // Number of live blocks
+	size_t livebytes; // Total size of live blocks
+	size_t peakbytes; // Largest value of livebytes
+	uint32_t alloccount; // Number of allocations
+	uint32_t freecount; // Number of frees
+};
+
+/* Heap Profile Difference (Change in a site between two snapshots) */
+typedef struct _HEAP_PROFILE_DIFF HEAP_PROFILE_DIFF;
+struct _HEAP_PROFILE_DIFF
+{
+	size_t caller; // Address of the caller
+	uint32_t flags; // Heap flags of the allocations
+	int32_t countdelta; // Change in the number of live blocks
+	int64_t bytesdelta; // Change in the total size of live blocks
+	size_t livebytes; // Total size of live blocks in the later snapshot
+};
+
+/* Heap Profile Snapshot */
+typedef struct _HEAP_PROFILE_SNAPSHOT HEAP_PROFILE_SNAPSHOT;
+struct _HEAP_PROFILE_SNAPSHOT
+{
+	uint32_t sequence; // Allocation sequence number when the snapshot was taken
+	int64_t time; // Time the snapshot was taken (Microseconds)
+	uint32_t sitecount; // Number of sites
+	HEAP_PROFILE_SITE *sites; // Copy of the site table
+	uint32_t typecount[HEAP_PROFILE_TYPE_COUNT]; // Live blocks for each type
+	size_t typebytes[HEAP_PROFILE_TYPE_COUNT]; // Live bytes for each type
+};
+
+/* Heap Profile Statistics */
+typedef struct _HEAP_PROFILE_STATISTICS HEAP_PROFILE_STATISTICS;
+struct _HEAP_PROFILE_STATISTICS
+{
+	BOOL running; // TRUE if tracking is active
+	uint32_t maxblocks; // Maximum number of live blocks tracked
+	uint32_t blockcount; // Number of live blocks tracked
+	uint32_t sitecount; // Number of allocation sites
+	size_t livebytes; // Total size of live blocks tracked
+	uint32_t sequence; // Current allocation sequence number
+	uint32_t overflowcount; // Allocations not tracked because the block or site table was full
+	uint32_t unknowncount; // Frees of blocks not tracked (eg Allocated before tracking started)
+	uint32_t typecount[HEAP_PROFILE_TYPE_COUNT]; // Live blocks for each type
+	size_t typebytes[HEAP_PROFILE_TYPE_COUNT]; // Live bytes for each type
+};
+
+/* Heap Profile Fragmentation */
+typedef struct _HEAP_PROFILE_FRAGMENTATION HEAP_PROFILE_FRAGMENTATION;
+struct _HEAP_PROFILE_FRAGMENTATION
+{
+	uint32_t totalfree; // Total free memory (Bytes)
+	uint32_t freecount; // Number of free blocks
+	uint32_t largestfree; // Largest free block (Bytes)
+	uint32_t smallestfree; // Smallest free block (Bytes)
+	uint32_t fragmentation; // Percentage of free memory not in the largest free block
+};
+
+/* ============================================================================== */
+/* Heap Profile Functions */
+uint32_t STDCALL heap_profile_start(uint32_t maxblocks); // MaxBlocks = 0 for HEAP_PROFILE_DEFAULT_BLOCKS
+uint32_t STDCALL heap_profile_stop(void);
+
+uint32_t STDCALL heap_profile_get_statistics(HEAP_PROFILE_STATISTICS *statistics);
+uint32_t STDCALL heap_profile_get_sites(HEAP_PROFILE_SITE *buffer, uint32_t len, uint32_t *count); // Sites are sorted by live bytes, Count returns the total number of sites
+uint32_t STDCALL heap_profile_get_blocks(uint32_t sequence, HEAP_PROFILE_BLOCK *buffer, uint32_t len, uint32_t *count); // Live blocks allocated after Sequence, Count returns the total number of matching blocks
+uint32_t STDCALL heap_profile_get_fragmentation(HEAP_PROFILE_FRAGMENTATION *fragmentation);
+
+HEAP_PROFILE_SNAPSHOT * STDCALL heap_profile_snapshot_create(void);
+uint32_t STDCALL heap_profile_snapshot_destroy(HEAP_PROFILE_SNAPSHOT *snapshot);
+uint32_t STDCALL heap_profile_snapshot_diff(HEAP_PROFILE_SNAPSHOT *before, HEAP_PROFILE_SNAPSHOT *after, HEAP_PROFILE_DIFF *buffer, uint32_t len, uint32_t *count); // Sites that grew sorted by growth, Count returns the total number of sites that grew
+
+uint32_t STDCALL heap_profile_report(uint32_t limit); // Write types, top sites and fragmentation to logging_output, Limit = 0 for all sites
+uint32_t STDCALL heap_profile_report_diff(HEAP_PROFILE_SNAPSHOT *before, HEAP_PROFILE_SNAPSHOT *after, uint32_t limit); // Write the sites that grew between two snapshots to logging_output
+uint32_t STDCALL heap_profile_report_blocks(uint32_t sequence, uint32_t limit); // Write the live blocks allocated after Sequence to logging_output
+
+/* ============================================================================== */
+/* Heap Profile Instrumented Functions */
+void * STDCALL heap_profile_get_mem(size_t size);
+void * STDCALL heap_profile_get_mem_ex(size_t size, uint32_t flags, uint32_t affinity);
+void * STDCALL heap_profile_get_aligned_mem(size_t size, size_t alignment);
+void * STDCALL heap_profile_get_aligned_mem_ex(size_t size, size_t alignment, uint32_t flags, uint32_t affinity);
+void * STDCALL heap_profile_get_shared_mem(size_t size);
+void * STDCALL heap_profile_get_shared_aligned_mem(size_t size, size_t alignment);
+void * STDCALL heap_profile_get_local_mem(size_t size, uint32_t affinity);
+void * STDCALL heap_profile_get_local_aligned_mem(size_t size, size_t alignment, uint32_t affinity);
+void * STDCALL heap_profile_get_code_mem(size_t size, uint32_t affinity);
+void * STDCALL heap_profile_get_code_aligned_mem(size_t size, size_t alignment, uint32_t affinity);
+void * STDCALL heap_profile_get_device_mem(size_t size);
+void * STDCALL heap_profile_get_device_aligned_mem(size_t size, size_t alignment);
+void * STDCALL heap_profile_get_nocache_mem(size_t size);
+void * STDCALL heap_profile_get_nocache_aligned_mem(size_t size, size_t alignment);
+void * STDCALL heap_profile_get_nonshared_mem(size_t size);
+void * STDCALL heap_profile_get_nonshared_aligned_mem(size_t size, size_t alignment);
+void * STDCALL heap_profile_get_irq_mem(size_t size, uint32_t affinity);
+void * STDCALL heap_profile_get_irq_aligned_mem(size_t size, size_t alignment, uint32_t affinity);
+void * STDCALL heap_profile_get_fiq_mem(size_t size, uint32_t affinity);
+void * STDCALL heap_profile_get_fiq_aligned_mem(size_t size, size_t alignment, uint32_t affinity);
+size_t STDCALL heap_profile_free_mem(void *addr);
+size_t STDCALL heap_profile_free_irq_mem(void *addr);
+size_t STDCALL heap_profile_free_fiq_mem(void *addr);
+void * STDCALL heap_profile_alloc_mem(size_t size);
+void * STDCALL heap_profile_alloc_mem_ex(size_t size, uint32_t flags, uint32_t affinity);
+void * STDCALL heap_profile_realloc_mem(void *addr, size_t size);
+void * STDCALL heap_profile_realloc_mem_ex(void *addr, size_t size, uint32_t flags, uint32_t affinity);
+void * STDCALL heap_profile_alloc_aligned_mem(size_t size, size_t alignment);
+void * STDCALL heap_profile_alloc_aligned_mem_ex(size_t size, size_t alignment, uint32_t flags, uint32_t affinity);
+void * STDCALL heap_profile_realloc_aligned_mem(void *addr, size_t size, size_t alignment);
+void * STDCALL heap_profile_realloc_aligned_mem_ex(void *addr, size_t size, size_t alignment, uint32_t flags, uint32_t affinity);
+void * STDCALL heap_profile_alloc_shared_mem(size_t size);
+void * STDCALL heap_profile_alloc_shared_aligned_mem(size_t size, size_t alignment);
+void * STDCALL heap_profile_realloc_shared_mem(void *addr, size_t size);
+void * STDCALL heap_profile_realloc_shared_aligned_mem(void *addr, size_t size, size_t alignment);
+void * STDCALL heap_profile_alloc_local_mem(size_t size, uint32_t affinity);
+void * STDCALL heap_profile_alloc_local_aligned_mem(size_t size, size_t alignment, uint32_t affinity);
+void * STDCALL heap_profile_realloc_local_mem(void *addr, size_t size, uint32_t affinity);
+void * STDCALL heap_profile_realloc_local_aligned_mem(void *addr, size_t size, size_t alignment, uint32_t affinity);
+void * STDCALL heap_profile_alloc_code_mem(size_t size, uint32_t affinity);
+void * STDCALL heap_profile_alloc_code_aligned_mem(size_t size, size_t alignment, uint32_t affinity);
+void * STDCALL heap_profile_realloc_code_mem(void *addr, size_t size, uint32_t affinity);
+void * STDCALL heap_profile_realloc_code_aligned_mem(void *addr, size_t size, size_t alignment, uint32_t affinity);
+void * STDCALL heap_profile_alloc_device_mem(size_t size);
+void * STDCALL heap_profile_alloc_device_aligned_mem(size_t size, size_t alignment);
+void * STDCALL heap_profile_realloc_device_mem(void *addr, size_t size);
+void * STDCALL heap_profile_realloc_device_aligned_mem(void *addr, size_t size, size_t alignment);
+void * STDCALL heap_profile_alloc_nocache_mem(size_t size);
+void * STDCALL heap_profile_alloc_nocache_aligned_mem(size_t size, size_t alignment);
+void * STDCALL heap_profile_realloc_nocache_mem(void *addr, size_t size);
+void * STDCALL heap_profile_realloc_nocache_aligned_mem(void *addr, size_t size, size_t alignment);
+void * STDCALL heap_profile_alloc_nonshared_mem(size_t size);
+void * STDCALL heap_profile_alloc_nonshared_aligned_mem(size_t size, size_t alignment);
+void * STDCALL heap_profile_realloc_nonshared_mem(void *addr, size_t size);
+void * STDCALL heap_profile_realloc_nonshared_aligned_mem(void *addr, size_t size, size_t alignment);
+void * STDCALL heap_profile_alloc_irq_mem(size_t size, uint32_t affinity);
+void * STDCALL heap_profile_alloc_irq_aligned_mem(size_t size, size_t alignment, uint32_t affinity);
+void * STDCALL heap_profile_realloc_irq_mem(void *addr, size_t size, uint32_t affinity);
+void * STDCALL heap_profile_realloc_irq_aligned_mem(void *addr, size_t size, size_t alignment, uint32_t affinity);
+void * STDCALL heap_profile_alloc_fiq_mem(size_t size, uint32_t affinity);
+void * STDCALL heap_profile_alloc_fiq_aligned_mem(size_t size, size_t alignment, uint32_t affinity);
+void * STDCALL heap_profile_realloc_fiq_mem(void *addr, size_t size, uint32_t affinity);
+void * STDCALL heap_profile_realloc_fiq_aligned_mem(void *addr, size_t size, size_t alignment, uint32_t affinity);
+
+/* ============================================================================== */
+/* Heap Profile Redirection */
+/* When built with HEAP_PROFILE defined (make HEAP_PROFILE=1) calls to the heap functions are
+   redirected to the instrumented versions above, without HEAP_PROFILE nothing is redirected */
+#if defined(HEAP_PROFILE) && !defined(HEAP_PROFILE_INTERNAL)
+#define get_mem(size)	heap_profile_get_mem(size)
+#define get_mem_ex(size, flags, affinity)	heap_profile_get_mem_ex(size, flags, affinity)
+#define get_aligned_mem(size, alignment)	heap_profile_get_aligned_mem(size, alignment)
+#define get_aligned_mem_ex(size, alignment, flags, affinity)	heap_profile_get_aligned_mem_ex(size, alignment, flags, affinity)
+#define get_shared_mem(size)	heap_profile_get_shared_mem(size)
+#define get_shared_aligned_mem(size, alignment)	heap_profile_get_shared_aligned_mem(size, alignment)
+#define get_local_mem(size, affinity)	heap_profile_get_local_mem(size, affinity)
+#define get_local_aligned_mem(size, alignment, affinity)	heap_profile_get_local_aligned_mem(size, alignment, affinity)
+#define get_code_mem(size, affinity)	heap_profile_get_code_mem(size, affinity)
+#define get_code_aligned_mem(size, alignment, affinity)	heap_profile_get_code_aligned_mem(size, alignment, affinity)
+#define get_device_mem(size)	heap_profile_get_device_mem(size)
+#define get_device_aligned_mem(size, alignment)	heap_profile_get_device_aligned_mem(size, alignment)
+#define get_nocache_mem(size)	heap_profile_get_nocache_mem(size)
+#define get_nocache_aligned_mem(size, alignment)	heap_profile_get_nocache_aligned_mem(size, alignment)
+#define get_nonshared_mem(size)	heap_profile_get_nonshared_mem(size)
+#define get_nonshared_aligned_mem(size, alignment)	heap_profile_get_nonshared_aligned_mem(size, alignment)
+#define get_irq_mem(size, affinity)	heap_profile_get_irq_mem(size, affinity)
+#define get_irq_aligned_mem(size, alignment, affinity)	heap_profile_get_irq_aligned_mem(size, alignment, affinity)
+#define get_fiq_mem(size, affinity)	heap_profile_get_fiq_mem(size, affinity)
+#define get_fiq_aligned_mem(size, alignment, affinity)	heap_profile_get_fiq_aligned_mem(size, alignment, affinity)
+#define free_mem(addr)	heap_profile_free_mem(addr)
+#define free_irq_mem(addr)	heap_profile_free_irq_mem(addr)
+#define free_fiq_mem(addr)	heap_profile_free_fiq_mem(addr)
+#define alloc_mem(size)	heap_profile_alloc_mem(size)
+#define alloc_mem_ex(size, flags, affinity)	heap_profile_alloc_mem_ex(size, flags, affinity)
+#define realloc_mem(addr, size)	heap_profile_realloc_mem(addr, size)
+#define realloc_mem_ex(addr, size, flags, affinity)	heap_profile_realloc_mem_ex(addr, size, flags, affinity)
+#define alloc_aligned_mem(size, alignment)	heap_profile_alloc_aligned_mem(size, alignment)
+#define alloc_aligned_mem_ex(size, alignment, flags, affinity)	heap_profile_alloc_aligned_mem_ex(size, alignment, flags, affinity)
+#define realloc_aligned_mem(addr, size, alignment)	heap_profile_realloc_aligned_mem(addr, size, alignment)
+#define realloc_aligned_mem_ex(addr, size, alignment, flags, affinity)	heap_profile_realloc_aligned_mem_ex(addr, size, alignment, flags, affinity)
+#define alloc_shared_mem(size)	heap_profile_alloc_shared_mem(size)
+#define alloc_shared_aligned_mem(size, alignment)	heap_profile_alloc_shared_aligned_mem(size, alignment)
+#define realloc_shared_mem(addr, size)	heap_profile_realloc_shared_mem(addr, size)
+#define realloc_shared_aligned_mem(addr, size, alignment)	heap_profile_realloc_shared_aligned_mem(addr, size, alignment)
+#define alloc_local_mem(size, affinity)	heap_profile_alloc_local_mem(size, affinity)
+#define alloc_local_aligned_mem(size, alignment, affinity)	heap_profile_alloc_local_aligned_mem(size, alignment, affinity)
+#define realloc_local_mem(addr, size, affinity)	heap_profile_realloc_local_mem(addr, size, affinity)
+#define realloc_local_aligned_mem(addr, size, alignment, affinity)	heap_profile_realloc_local_aligned_mem(addr, size, alignment, affinity)
+#define alloc_code_mem(size, affinity)	heap_profile_alloc_code_mem(size, affinity)
+#define alloc_code_aligned_mem(size, alignment, affinity)	heap_profile_alloc_code_aligned_mem(size, alignment, affinity)
+#define realloc_code_mem(addr, size, affinity)	heap_profile_realloc_code_mem(addr, size, affinity)
+#define realloc_code_aligned_mem(addr, size, alignment, affinity)	heap_profile_realloc_code_aligned_mem(addr, size, alignment, affinity)
+#define alloc_device_mem(size)	heap_profile_alloc_device_mem(size)
+#define alloc_device_aligned_mem(size, alignment)	heap_profile_alloc_device_aligned_mem(size, alignment)
+#define realloc_device_mem(addr, size)	heap_profile_realloc_device_mem(addr, size)
+#define realloc_device_aligned_mem(addr, size, alignment)	heap_profile_realloc_device_aligned_mem(addr, size, alignment)
+#define alloc_nocache_mem(size)	heap_profile_alloc_nocache_mem(size)
+#define alloc_nocache_aligned_mem(size, alignment)	heap_profile_alloc_nocache_aligned_mem(size, alignment)
+#define realloc_nocache_mem(addr, size)	heap_profile_realloc_nocache_mem(addr, size)
+#define realloc_nocache_aligned_mem(addr, size, alignment)	heap_profile_realloc_nocache_aligned_mem(addr, size, alignment)
+#define alloc_nonshared_mem(size)	heap_profile_alloc_nonshared_mem(size)
+#define alloc_nonshared_aligned_mem(size, alignment)	heap_profile_alloc_nonshared_aligned_mem(size, alignment)
+#define realloc_nonshared_mem(addr, size)	heap_profile_realloc_nonshared_mem(addr, size)
+#define realloc_nonshared_aligned_mem(addr, size, alignment)	heap_profile_realloc_nonshared_aligned_mem(addr, size, alignment)
+#define alloc_irq_mem(size, affinity)	heap_profile_alloc_irq_mem(size, affinity)
+#define alloc_irq_aligned_mem(size, alignment, affinity)	heap_profile_alloc_irq_aligned_mem(size, alignment, affinity)
+#define realloc_irq_mem(addr, size, affinity)	heap_profile_realloc_irq_mem(addr, size, affinity)
+#define realloc_irq_aligned_mem(addr, size, alignment, affinity)	heap_profile_realloc_irq_aligned_mem(addr, size, alignment, affinity)
+#define alloc_fiq_mem(size, affinity)	heap_profile_alloc_fiq_mem(size, affinity)
+#define alloc_fiq_aligned_mem(size, alignment, affinity)	heap_profile_alloc_fiq_aligned_mem(size, alignment, affinity)
+#define realloc_fiq_mem(addr, size, affinity)	heap_profile_realloc_fiq_mem(addr, size, affinity)
+#define realloc_fiq_aligned_mem(addr, size, alignment, affinity)	heap_profile_realloc_fiq_aligned_mem(addr, size, alignment, affinity)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_HEAPPROFILE_H
@@ -0,0 +1,111 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_INPUT_H
+#define _ULTIBO_INPUT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/keyboard.h"
+#include "ultibo/mouse.h"
+#include "ultibo/touch.h"
+#include "ultibo/joystick.h"
+
+/* ============================================================================== */
+/* Input specific constants */
+#define INPUT_THREAD_NAME	"Input Set" // Thread name for Input set wait threads
+#define INPUT_THREAD_PRIORITY	THREAD_PRIORITY_HIGHER // Thread priority for Input set wait threads
+#define INPUT_THREAD_STACK_SIZE	SIZE_16K // Stack size of Input set wait threads
+
+/* Input Types */
+#define INPUT_TYPE_NONE	0
+#define INPUT_TYPE_KEYBOARD	1
+#define INPUT_TYPE_MOUSE	2
+#define INPUT_TYPE_TOUCH	3
+#define INPUT_TYPE_JOYSTICK	4
+
+#define INPUT_TYPE_MAX	4
+
+/* Input Flags */
+#define INPUT_FLAG_NONE	0x00000000
+#define INPUT_FLAG_NON_BLOCK	0x00000001 // If set reads are non blocking and return ERROR_NO_MORE_ITEMS if no data is available
+#define INPUT_FLAG_COALESCE	0x00000002 // If set consecutive motion records are merged (Last absolute position, sum of relative deltas)
+
+/* Input Set Maximum */
+#define INPUT_SET_MAX_DEVICES	16 // Maximum number of devices in an Input set
+
+/* ============================================================================== */
+/* Input specific types */
+/* Input Event */
+typedef struct _INPUT_EVENT INPUT_EVENT;
+struct _INPUT_EVENT
+{
+	uint32_t inputtype; // The type of the event data (eg INPUT_TYPE_MOUSE)
+	void *device; // The device that produced the event (eg MOUSE_DEVICE)
+	union
+	{
+		KEYBOARD_DATA keyboard; // Keyboard data (If InputType is INPUT_TYPE_KEYBOARD)
+		MOUSE_DATA mouse; // Mouse data (If InputType is INPUT_TYPE_MOUSE)
+		TOUCH_DATA touch; // Touch data (If InputType is INPUT_TYPE_TOUCH)
+		JOYSTICK_DATA joystick; // Joystick data (If InputType is INPUT_TYPE_JOYSTICK)
+	} data;
+};
+
+/* Input Set */
+typedef struct _INPUT_SET INPUT_SET;
+
+/* ============================================================================== */
+/* Input Functions */
+uint32_t STDCALL keyboard_device_read_all(KEYBOARD_DEVICE *keyboard, KEYBOARD_DATA *buffer, uint32_t len, uint32_t flags, uint32_t *count);
+uint32_t STDCALL mouse_device_read_all(MOUSE_DEVICE *mouse, MOUSE_DATA *buffer, uint32_t len, uint32_t flags, uint32_t *count);
+uint32_t STDCALL touch_device_read_all(TOUCH_DEVICE *touch, TOUCH_DATA *buffer, uint32_t len, uint32_t flags, uint32_t *count);
+uint32_t STDCALL joystick_device_read_all(JOYSTICK_DEVICE *joystick, JOYSTICK_DATA *buffer, uint32_t len, uint32_t flags, uint32_t *count);
+
+INPUT_SET * STDCALL input_set_create(void);
+uint32_t STDCALL input_set_destroy(INPUT_SET *set);
+
+uint32_t STDCALL input_set_add(INPUT_SET *set, uint32_t inputtype, void *device);
+uint32_t STDCALL input_set_remove(INPUT_SET *set, void *device);
+
+uint32_t STDCALL input_set_wait(INPUT_SET *set, uint32_t timeout); // Timeout = 0 then No Wait,Timeout = INFINITE then Wait forever
+uint32_t STDCALL input_set_read(INPUT_SET *set, INPUT_EVENT *events, uint32_t len, uint32_t flags, uint32_t timeout, uint32_t *count); // Timeout = 0 then No Wait,Timeout = INFINITE then Wait forever
+
+/* ============================================================================== */
+/* Input Helper Functions */
+uint32_t STDCALL mouse_data_coalesce(MOUSE_DATA *buffer, uint32_t count);
+uint32_t STDCALL touch_data_coalesce(TOUCH_DATA *buffer, uint32_t count);
+uint32_t STDCALL joystick_data_coalesce(JOYSTICK_DATA *buffer, uint32_t count);
+
+uint32_t STDCALL input_type_to_string(uint32_t inputtype, char *string, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_INPUT_H
@@ -0,0 +1,158 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_LATENCY_H
+#define _ULTIBO_LATENCY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/devices.h"
+#include "ultibo/gpio.h"
+
+/* ============================================================================== */
+/* Latency specific constants */
+#define LATENCY_THREAD_NAME	"Latency" // Thread name for the Latency measurement threads
+#define LATENCY_THREAD_STACK_SIZE	SIZE_16K // Stack size of the Latency measurement threads
+#define LATENCY_LOAD_THREAD_NAME	"Latency Load" // Thread name for the Latency load threads
+#define LATENCY_LOAD_THREAD_PRIORITY	THREAD_PRIORITY_NORMAL // Thread priority for the Latency load threads
+
+#define LATENCY_DEFAULT_DURATION	10000 // Default duration of each test (Milliseconds)
+#define LATENCY_DEFAULT_INTERVAL	1000 // Default interval between events in each test (Microseconds)
+#define LATENCY_CALIBRATE_TIME	100 // Time used to measure the rate of the clock counter (Milliseconds)
+#define LATENCY_EVENT_TIMEOUT	100 // Time to wait for a single event before counting it as missed (Milliseconds)
+#define LATENCY_SIGNAL_MAXIMUM	0xFFFFFFFF // Maximum count of the semaphore signalled by the timer and GPIO events (The IPI test may signal again after a missed acknowledgement)
+#define LATENCY_MEMORY_LOAD_SIZE	SIZE_1M // Size of the buffers copied by each memory load thread
+#define LATENCY_NETWORK_LOAD_SIZE	1024 // Size of the datagrams sent by each network load thread
+#define LATENCY_NETWORK_LOAD_PORT	9 // Destination port of the datagrams sent by each network load thread (Discard)
+
+/* Latency Histogram (Log linear, 8 buckets for each power of 2 nanoseconds) */
+#define LATENCY_SUB_BUCKET_BITS	3
+#define LATENCY_SUB_BUCKETS	(1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_BUCKET_COUNT	((32 - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+/* Latency Tests */
+#define LATENCY_TEST_TIMER	0 // Deviation of repeating timer device events from the programmed interval
+#define LATENCY_TEST_TIMER_WAKE	1 // Timer device interrupt to a waiting thread running
+#define LATENCY_TEST_IPI	2 // Thread on one CPU signalling a waiting thread on another CPU
+#define LATENCY_TEST_GPIO	3 // GPIO output set to the input event callback on the connected pin
+#define LATENCY_TEST_WORKER	4 // Timer device interrupt to a task scheduled with worker_schedule_irq starting
+
+#define LATENCY_TEST_COUNT	5
+
+#define LATENCY_TEST_ALL	((1 << LATENCY_TEST_COUNT) - 1) // Mask of all tests for LATENCY_CONFIG.tests
+
+/* Latency Loads */
+#define LATENCY_LOAD_NONE	0x00000000
+#define LATENCY_LOAD_CPU	0x00000001 // Integer and floating point arithmetic
+#define LATENCY_LOAD_MEMORY	0x00000002 // Copying buffers larger than the cache
+#define LATENCY_LOAD_NETWORK	0x00000004 // Sending UDP datagrams to the loopback address
+
+#define LATENCY_LOAD_ALL	(LATENCY_LOAD_CPU | LATENCY_LOAD_MEMORY | LATENCY_LOAD_NETWORK)
+
+/* Latency Flags */
+#define LATENCY_FLAG_NONE	0x00000000
+#define LATENCY_FLAG_GPIO_INTERRUPT	0x00000001 // Request GPIO events with GPIO_EVENT_FLAG_INTERRUPT (Callback from the interrupt handler instead of a worker thread)
+
+/* Latency GPIO Loopback */
+#define LATENCY_LOOPBACK_DESCRIPTION	"Latency GPIO Loopback" // Description of the virtual GPIO loopback device
+#define LATENCY_LOOPBACK_PIN_COUNT	8 // Number of pins on the virtual GPIO loopback device (Connected in pairs, 0 and 1, 2 and 3 etc)
+
+/* ============================================================================== */
+/* Latency specific types */
+
+/* Latency Histogram */
+typedef struct _LATENCY_HISTOGRAM LATENCY_HISTOGRAM;
+struct _LATENCY_HISTOGRAM
+{
+	uint32_t count; // Number of values recorded
+	uint32_t missed; // Number of events that did not occur within LATENCY_EVENT_TIMEOUT
+	uint32_t minimum; // Smallest value recorded (Nanoseconds)
+	uint32_t maximum; // Largest value recorded (Nanoseconds)
+	uint64_t total; // Sum of all values recorded (Nanoseconds)
+	uint32_t buckets[LATENCY_BUCKET_COUNT];
+};
+
+/* Latency Config */
+typedef struct _LATENCY_CONFIG LATENCY_CONFIG;
+struct _LATENCY_CONFIG
+{
+	uint32_t tests; // Mask of tests to run (eg (1 << LATENCY_TEST_TIMER) or LATENCY_TEST_ALL)
+	uint32_t loads; // Loads to run on the other CPUs during each test (eg LATENCY_LOAD_ALL)
+	uint32_t flags; // Latency flags (eg LATENCY_FLAG_GPIO_INTERRUPT)
+	uint32_t duration; // Duration of each test (Milliseconds, 0 for LATENCY_DEFAULT_DURATION)
+	uint32_t interval; // Interval between events in each test (Microseconds, 0 for LATENCY_DEFAULT_INTERVAL)
+	uint32_t cpu; // CPU for the measuring threads, no load is run on this CPU (eg CPU_ID_0)
+	TIMER_DEVICE *timer; // Timer device for the timer and worker tests (Or NULL for the default timer device)
+	GPIO_DEVICE *gpio; // GPIO device for the GPIO test (Or NULL to use a virtual loopback device)
+	uint32_t outputpin; // Pin set by the GPIO test (Must be connected to inputpin, ignored for the loopback device)
+	uint32_t inputpin; // Pin monitored by the GPIO test (Ignored for the loopback device)
+};
+
+/* Latency Result */
+typedef struct _LATENCY_RESULT LATENCY_RESULT;
+struct _LATENCY_RESULT
+{
+	uint32_t test; // The test for this result (eg LATENCY_TEST_TIMER)
+	uint32_t status; // ERROR_SUCCESS if the test was run or the reason it was not
+	uint32_t loads; // Loads that were running during the test
+	uint32_t p50; // Median (Nanoseconds)
+	uint32_t p90; // 90th percentile (Nanoseconds)
+	uint32_t p99; // 99th percentile (Nanoseconds)
+	uint32_t p999; // 99.9th percentile (Nanoseconds)
+	LATENCY_HISTOGRAM histogram;
+};
+
+/* ============================================================================== */
+/* Latency Functions */
+uint32_t STDCALL latency_run(LATENCY_CONFIG *config, LATENCY_RESULT *results, uint32_t count);
+
+uint32_t STDCALL latency_load_start(uint32_t loads, uint32_t affinity);
+uint32_t STDCALL latency_load_stop(void);
+
+GPIO_DEVICE * STDCALL latency_loopback_create(void);
+uint32_t STDCALL latency_loopback_destroy(GPIO_DEVICE *gpio);
+
+/* ============================================================================== */
+/* Latency Helper Functions */
+void STDCALL latency_histogram_clear(LATENCY_HISTOGRAM *histogram);
+void STDCALL latency_histogram_add(LATENCY_HISTOGRAM *histogram, uint32_t value);
+uint32_t STDCALL latency_histogram_percentile(LATENCY_HISTOGRAM *histogram, uint32_t percentile); // Percentile is in hundredths of a percent (eg 9990 for 99.9%)
+
+uint32_t STDCALL latency_test_to_string(uint32_t test, char *string, uint32_t len);
+uint32_t STDCALL latency_result_to_string(LATENCY_RESULT *result, char *string, uint32_t len);
+
+uint32_t STDCALL latency_report_log(LATENCY_RESULT *results, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_LATENCY_H
@@ -0,0 +1,167 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_LOCKPROFILE_H
+#define _ULTIBO_LOCKPROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+
+/* ============================================================================== */
+/* Lock Profile specific constants */
+#define LOCK_PROFILE_MAX_LOCKS	1024 // Maximum number of lock handles recorded (Must be a power of 2)
+#define LOCK_PROFILE_MAX_THREADS	8 // Maximum number of threads recorded for each lock when determining the top waiter and holder
+#define LOCK_PROFILE_SPIN_LIMIT	64 // Number of times a contended Mutex or Critical Section is retried before blocking
+
+/* Lock Profile Types */
+#define LOCK_PROFILE_TYPE_NONE	0
+#define LOCK_PROFILE_TYPE_SPIN	1
+#define LOCK_PROFILE_TYPE_MUTEX	2
+#define LOCK_PROFILE_TYPE_CRITICAL_SECTION	3
+#define LOCK_PROFILE_TYPE_SYNCHRONIZER	4
+
+/* ============================================================================== */
+/* Lock Profile specific types */
+
+/* Lock Profile Entry (Snapshot of the profile for a single lock, all times are in clock_get_count units) */
+typedef struct _LOCK_PROFILE_ENTRY LOCK_PROFILE_ENTRY;
+struct _LOCK_PROFILE_ENTRY
+{
+	HANDLE handle; // Handle of the lock
+	uint32_t locktype; // Type of the lock (eg LOCK_PROFILE_TYPE_MUTEX)
+	uint32_t acquirecount; // Number of times the lock was acquired
+	uint32_t contendedcount; // Number of acquisitions where the lock was already held
+	uint32_t failedcount; // Number of acquisitions that returned an error (eg Timeout)
+	uint64_t spincount; // Total number of retries before acquiring (Mutex and Critical Section only)
+	uint64_t waittime; // Total time spent waiting to acquire
+	uint32_t maxwaittime; // Longest single wait to acquire
+	uint64_t holdtime; // Total time held (Exclusive owners only, not Synchronizer readers)
+	uint32_t maxholdtime; // Longest single hold
+	THREAD_HANDLE maxholder; // Thread that held the lock for the longest single hold
+	THREAD_HANDLE topwaiter; // Thread with the most total wait time (or INVALID_HANDLE_VALUE)
+	uint64_t topwaitertime; // Total wait time of the top waiter
+	THREAD_HANDLE topholder; // Thread with the most total hold time (or INVALID_HANDLE_VALUE)
+	uint64_t topholdertime; // Total hold time of the top holder
+};
+
+/* Lock Profile Statistics */
+typedef struct _LOCK_PROFILE_STATISTICS LOCK_PROFILE_STATISTICS;
+struct _LOCK_PROFILE_STATISTICS
+{
+	uint32_t lockcount; // Number of lock handles recorded (Records are freed when the lock is destroyed)
+	uint32_t overflowcount; // Number of acquisitions not recorded because the lock table was full
+	uint32_t clockrate; // Estimated rate of clock_get_count (Counts per second, 0 if not yet known)
+	int64_t starttime; // Time when recording started or was last reset (Microseconds)
+	int64_t duration; // Time since recording started or was last reset (Microseconds)
+};
+
+/* ============================================================================== */
+/* Lock Profile Functions */
+uint32_t STDCALL lock_profile_snapshot(LOCK_PROFILE_ENTRY *buffer, uint32_t len, uint32_t *count); // Entries are sorted by total wait time, Count returns the total number of locks recorded
+uint32_t STDCALL lock_profile_get_statistics(LOCK_PROFILE_STATISTICS *statistics);
+uint32_t STDCALL lock_profile_reset(void);
+uint32_t STDCALL lock_profile_dump(uint32_t limit); // Write the most contended locks to logging_output, Limit = 0 for all
+
+/* ============================================================================== */
+/* Lock Profile Instrumented Functions */
+uint32_t STDCALL lock_profile_spin_destroy(SPIN_HANDLE spin);
+uint32_t STDCALL lock_profile_spin_lock(SPIN_HANDLE spin);
+uint32_t STDCALL lock_profile_spin_unlock(SPIN_HANDLE spin);
+uint32_t STDCALL lock_profile_spin_lock_irq(SPIN_HANDLE spin);
+uint32_t STDCALL lock_profile_spin_unlock_irq(SPIN_HANDLE spin);
+uint32_t STDCALL lock_profile_spin_lock_fiq(SPIN_HANDLE spin);
+uint32_t STDCALL lock_profile_spin_unlock_fiq(SPIN_HANDLE spin);
+uint32_t STDCALL lock_profile_spin_lock_irq_fiq(SPIN_HANDLE spin);
+uint32_t STDCALL lock_profile_spin_unlock_irq_fiq(SPIN_HANDLE spin);
+uint32_t STDCALL lock_profile_spin_lock_preempt(SPIN_HANDLE spin);
+uint32_t STDCALL lock_profile_spin_unlock_preempt(SPIN_HANDLE spin);
+
+uint32_t STDCALL lock_profile_mutex_destroy(MUTEX_HANDLE mutex);
+uint32_t STDCALL lock_profile_mutex_lock(MUTEX_HANDLE mutex);
+uint32_t STDCALL lock_profile_mutex_unlock(MUTEX_HANDLE mutex);
+uint32_t STDCALL lock_profile_mutex_try_lock(MUTEX_HANDLE mutex);
+
+uint32_t STDCALL lock_profile_critical_section_destroy(CRITICAL_SECTION_HANDLE criticalsection);
+uint32_t STDCALL lock_profile_critical_section_lock(CRITICAL_SECTION_HANDLE criticalsection);
+uint32_t STDCALL lock_profile_critical_section_lock_ex(CRITICAL_SECTION_HANDLE criticalsection, uint32_t timeout);
+uint32_t STDCALL lock_profile_critical_section_unlock(CRITICAL_SECTION_HANDLE criticalsection);
+uint32_t STDCALL lock_profile_critical_section_try_lock(CRITICAL_SECTION_HANDLE criticalsection);
+
+uint32_t STDCALL lock_profile_synchronizer_destroy(SYNCHRONIZER_HANDLE synchronizer);
+uint32_t STDCALL lock_profile_synchronizer_reader_lock(SYNCHRONIZER_HANDLE synchronizer);
+uint32_t STDCALL lock_profile_synchronizer_reader_lock_ex(SYNCHRONIZER_HANDLE synchronizer, uint32_t timeout);
+uint32_t STDCALL lock_profile_synchronizer_reader_unlock(SYNCHRONIZER_HANDLE synchronizer);
+uint32_t STDCALL lock_profile_synchronizer_writer_lock(SYNCHRONIZER_HANDLE synchronizer);
+uint32_t STDCALL lock_profile_synchronizer_writer_lock_ex(SYNCHRONIZER_HANDLE synchronizer, uint32_t timeout);
+uint32_t STDCALL lock_profile_synchronizer_writer_unlock(SYNCHRONIZER_HANDLE synchronizer);
+
+/* ============================================================================== */
+/* Lock Profile Redirection */
+/* When built with LOCK_PROFILE defined (make LOCK_PROFILE=1) calls to the lock functions are
+   redirected to the instrumented versions above, the instrumented functions call the originals */
+#if defined(LOCK_PROFILE) && !defined(LOCK_PROFILE_INTERNAL)
+#define spin_destroy(spin)	lock_profile_spin_destroy(spin)
+#define spin_lock(spin)	lock_profile_spin_lock(spin)
+#define spin_unlock(spin)	lock_profile_spin_unlock(spin)
+#define spin_lock_irq(spin)	lock_profile_spin_lock_irq(spin)
+#define spin_unlock_irq(spin)	lock_profile_spin_unlock_irq(spin)
+#define spin_lock_fiq(spin)	lock_profile_spin_lock_fiq(spin)
+#define spin_unlock_fiq(spin)	lock_profile_spin_unlock_fiq(spin)
+#define spin_lock_irq_fiq(spin)	lock_profile_spin_lock_irq_fiq(spin)
+#define spin_unlock_irq_fiq(spin)	lock_profile_spin_unlock_irq_fiq(spin)
+#define spin_lock_preempt(spin)	lock_profile_spin_lock_preempt(spin)
+#define spin_unlock_preempt(spin)	lock_profile_spin_unlock_preempt(spin)
+
+#define mutex_destroy(mutex)	lock_profile_mutex_destroy(mutex)
+#define mutex_lock(mutex)	lock_profile_mutex_lock(mutex)
+#define mutex_unlock(mutex)	lock_profile_mutex_unlock(mutex)
+#define mutex_try_lock(mutex)	lock_profile_mutex_try_lock(mutex)
+
+#define critical_section_destroy(criticalsection)	lock_profile_critical_section_destroy(criticalsection)
+#define critical_section_lock(criticalsection)	lock_profile_critical_section_lock(criticalsection)
+#define critical_section_lock_ex(criticalsection, timeout)	lock_profile_critical_section_lock_ex(criticalsection, timeout)
+#define critical_section_unlock(criticalsection)	lock_profile_critical_section_unlock(criticalsection)
+#define critical_section_try_lock(criticalsection)	lock_profile_critical_section_try_lock(criticalsection)
+
+#define synchronizer_destroy(synchronizer)	lock_profile_synchronizer_destroy(synchronizer)
+#define synchronizer_reader_lock(synchronizer)	lock_profile_synchronizer_reader_lock(synchronizer)
+#define synchronizer_reader_lock_ex(synchronizer, timeout)	lock_profile_synchronizer_reader_lock_ex(synchronizer, timeout)
+#define synchronizer_reader_unlock(synchronizer)	lock_profile_synchronizer_reader_unlock(synchronizer)
+#define synchronizer_writer_lock(synchronizer)	lock_profile_synchronizer_writer_lock(synchronizer)
+#define synchronizer_writer_lock_ex(synchronizer, timeout)	lock_profile_synchronizer_writer_lock_ex(synchronizer, timeout)
+#define synchronizer_writer_unlock(synchronizer)	lock_profile_synchronizer_writer_unlock(synchronizer)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_LOCKPROFILE_H
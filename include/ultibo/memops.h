@@ -0,0 +1,112 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_MEMOPS_H
+#define _ULTIBO_MEMOPS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+
+/* ============================================================================== */
+/* Memory Operations specific constants */
+#define MEM_OPS_SMALL_SIZE	128 // Copies and fills smaller than this are passed to the C library (Bytes)
+#define MEM_OPS_BLOCK_SIZE	64 // Number of bytes moved by each pass of the block copy and fill loops
+
+#define MEM_OPS_DEFAULT_PREFETCH	256 // Default distance ahead of the source to prefetch (Bytes)
+#define MEM_OPS_MAX_PREFETCH	1024 // Maximum prefetch distance accepted by mem_ops_set_config (Bytes)
+
+#define MEM_OPS_THRESHOLD_NEVER	0xFFFFFFFF // Threshold value to disable DMA copies or non temporal stores
+
+#define MEM_OPS_TUNE_MIN_SIZE	SIZE_4K // Smallest copy size tested when tuning the DMA threshold (Bytes)
+#define MEM_OPS_TUNE_MAX_SIZE	SIZE_4M // Largest copy size tested when tuning the DMA threshold (Bytes)
+#define MEM_OPS_TUNE_REPEATS	8 // Number of copies timed at each size when tuning (Fastest is used)
+
+/* Memory Operations Implementations */
+#define MEM_OPS_IMPL_GENERIC	0 // Load and store multiple with prefetch (ARMv6)
+#define MEM_OPS_IMPL_NEON	1 // NEON 64 byte blocks with prefetch (ARMv7 and ARMv8 in 32bit mode)
+#define MEM_OPS_IMPL_ARM64	2 // SIMD register pairs with prefetch and non temporal stores (ARMv8 in 64bit mode)
+
+/* Memory Operations Flags */
+#define MEM_OPS_FLAG_NONE	0x00000000
+#define MEM_OPS_FLAG_NO_DMA	0x00000001 // Never dispatch copies to the DMA controller
+#define MEM_OPS_FLAG_NO_NON_TEMPORAL	0x00000002 // Do not use non temporal stores for large copies and fills
+
+/* ============================================================================== */
+/* Memory Operations specific types */
+
+/* Memory Operations Configuration */
+typedef struct _MEM_OPS_CONFIG MEM_OPS_CONFIG;
+struct _MEM_OPS_CONFIG
+{
+	uint32_t implementation; // The implementation selected at compile time (eg MEM_OPS_IMPL_NEON)
+	uint32_t flags; // Memory operations flags (eg MEM_OPS_FLAG_NO_DMA)
+	uint32_t prefetch; // Distance ahead of the source to prefetch (Bytes)(0 to prefetch only the block being copied)
+	uint32_t dmathreshold; // Copies of this size or larger are performed by DMA if available (Bytes)(MEM_OPS_THRESHOLD_NEVER to disable)
+	uint32_t nonthreshold; // Copies and fills of this size or larger use non temporal stores if supported (Bytes)(MEM_OPS_THRESHOLD_NEVER to disable)
+	uint32_t linesize; // Data cache line size reported by the platform (Bytes)
+	uint32_t l1size; // Level 1 data cache size reported by the platform (Bytes)
+	uint32_t l2size; // Level 2 cache size reported by the platform (Bytes)
+	uint32_t pagesize; // Memory page size reported by the platform (Bytes)
+};
+
+/* Memory Operations Statistics */
+typedef struct _MEM_OPS_STATISTICS MEM_OPS_STATISTICS;
+struct _MEM_OPS_STATISTICS
+{
+	uint32_t cpucount; // Number of copies performed by the CPU in mem_ops_copy_auto
+	uint32_t dmacount; // Number of copies performed by DMA in mem_ops_copy_auto
+	uint32_t dmaerrors; // Number of DMA copies that failed and were completed by the CPU
+	uint64_t cpubytes; // Total bytes copied by the CPU in mem_ops_copy_auto
+	uint64_t dmabytes; // Total bytes copied by DMA in mem_ops_copy_auto
+};
+
+/* ============================================================================== */
+/* Memory Operations Functions */
+void * STDCALL mem_ops_copy(void *dest, const void *source, size_t size); // Source and dest must not overlap (See mem_ops_move)
+void * STDCALL mem_ops_move(void *dest, const void *source, size_t size);
+void * STDCALL mem_ops_set(void *dest, int value, size_t size);
+
+uint32_t STDCALL mem_ops_copy_auto(void *dest, const void *source, size_t size); // Dispatches to DMA at or above the DMA threshold, otherwise mem_ops_copy
+
+uint32_t STDCALL mem_ops_get_config(MEM_OPS_CONFIG *config);
+uint32_t STDCALL mem_ops_set_config(const MEM_OPS_CONFIG *config);
+
+uint32_t STDCALL mem_ops_tune(MEM_OPS_CONFIG *config); // Measures the prefetch distance and thresholds for this board and applies them (Config may be NULL)
+
+uint32_t STDCALL mem_ops_get_statistics(MEM_OPS_STATISTICS *statistics);
+uint32_t STDCALL mem_ops_reset_statistics(void);
+
+uint32_t STDCALL mem_ops_implementation_to_string(uint32_t implementation, char *string, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_MEMOPS_H
@@ -0,0 +1,95 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_PROFILER_H
+#define _ULTIBO_PROFILER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+
+/* ============================================================================== */
+/* Profiler specific constants */
+#define PROFILER_THREAD_NAME	"Profiler" // Thread name for the Profiler aggregation thread
+#define PROFILER_THREAD_PRIORITY	THREAD_PRIORITY_HIGHER // Thread priority for the Profiler aggregation thread
+#define PROFILER_THREAD_STACK_SIZE	SIZE_16K // Stack size of the Profiler aggregation thread
+
+#define PROFILER_DEFAULT_RATE	1000 // Default sample rate per CPU (Hz, limited to the scheduler interrupt rate)
+#define PROFILER_MAX_DEPTH	16 // Maximum number of addresses in a sampled call stack (Including the interrupted PC)
+#define PROFILER_BUFFER_SAMPLES	256 // Number of samples in the buffer for each CPU (Must be a power of 2)
+#define PROFILER_MAX_STACKS	4096 // Maximum number of unique (Thread, Call stack) entries in the histogram
+#define PROFILER_DRAIN_INTERVAL	10 // Interval between moving samples from the CPU buffers to the histogram (Milliseconds)
+#define PROFILER_SCAN_WORDS	128 // Number of words of the interrupted stack searched for the saved exception return state
+#define PROFILER_PIN_RETRIES	100 // Number of times to yield while waiting to migrate to a CPU to hook or unhook its scheduler interrupt
+
+/* Profiler Flags */
+#define PROFILER_FLAG_NONE	0x00000000
+#define PROFILER_FLAG_PC_ONLY	0x00000001 // Record only the interrupted PC, do not follow the frame pointer call stack
+#define PROFILER_FLAG_NO_HOOK	0x00000002 // Do not hook the scheduler interrupt, samples are supplied by calling profiler_sample from another interrupt handler
+
+/* ============================================================================== */
+/* Profiler specific types */
+
+/* Profiler Statistics */
+typedef struct _PROFILER_STATISTICS PROFILER_STATISTICS;
+struct _PROFILER_STATISTICS
+{
+	uint32_t rate; // Requested sample rate per CPU (Hz)
+	uint32_t flags; // Profiler flags (eg PROFILER_FLAG_PC_ONLY)
+	uint32_t cpucount; // Number of CPUs being sampled
+	uint32_t samplecount; // Number of samples recorded in the histogram
+	uint32_t dropcount; // Number of samples discarded because a CPU buffer was full
+	uint32_t overflowcount; // Number of samples discarded because the histogram was full
+	uint32_t missedcount; // Number of samples where the interrupted PC could not be located
+	uint32_t stackcount; // Number of unique (Thread, Call stack) entries in the histogram
+	int64_t starttime; // Time when profiling was started (Microseconds)
+	int64_t duration; // Total time profiling has been running (Microseconds)
+};
+
+/* ============================================================================== */
+/* Profiler Functions */
+/* Only the 32-bit ARM exception frame can be located, on AArch64 profiler_start returns ERROR_NOT_SUPPORTED */
+uint32_t STDCALL profiler_start(uint32_t rate, uint32_t flags);
+uint32_t STDCALL profiler_stop(void);
+uint32_t STDCALL profiler_clear(void);
+
+uint32_t STDCALL profiler_sample(uint32_t cpuid, THREAD_HANDLE thread);
+
+uint32_t STDCALL profiler_get_statistics(PROFILER_STATISTICS *statistics);
+
+uint32_t STDCALL profiler_export(char *buffer, uint32_t len, uint32_t *count);
+uint32_t STDCALL profiler_export_file(const char *filename);
+uint32_t STDCALL profiler_export_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_PROFILER_H
@@ -0,0 +1,152 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_SCHEDTRACE_H
+#define _ULTIBO_SCHEDTRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+
+/* ============================================================================== */
+/* Scheduler Trace specific constants */
+#define SCHED_TRACE_DEFAULT_EVENTS	16384 // Default number of events in the trace buffer for each CPU (Rounded down to a power of 2)
+#define SCHED_TRACE_PIN_RETRIES	100 // Number of times to yield while waiting to migrate to a CPU to hook or unhook its scheduler interrupt
+#define SCHED_TRACE_MAX_WAKES	256 // Maximum number of pending wakeups tracked when calculating wakeup latency during export
+
+#define SCHED_TRACE_SIGNATURE	0x45434152 // Signature of a binary trace capture ("RACE")
+#define SCHED_TRACE_VERSION	1 // Version of the binary trace capture format
+
+/* Scheduler Trace Flags */
+#define SCHED_TRACE_FLAG_NONE	0x00000000
+#define SCHED_TRACE_FLAG_WRAP	0x00000001 // Overwrite the oldest events when a buffer is full (Flight recorder), otherwise new events are dropped
+#define SCHED_TRACE_FLAG_NO_HOOK	0x00000002 // Do not hook the scheduler interrupt, only events from the instrumented functions and sched_trace_record are captured
+
+/* Scheduler Trace Event Types */
+#define SCHED_TRACE_EVENT_NONE	0
+#define SCHED_TRACE_EVENT_SWITCH	1 // Context switch (Thread = Previous thread, Other = Next thread)
+#define SCHED_TRACE_EVENT_MIGRATE	2 // Thread scheduled on a different CPU from its last run (Thread = Migrated thread, Data = Previous CPU)
+#define SCHED_TRACE_EVENT_IRQ_ENTER	3 // Scheduler interrupt entry (Thread = Interrupted thread, Data = Interrupt number)
+#define SCHED_TRACE_EVENT_IRQ_EXIT	4 // Scheduler interrupt exit (Thread = Interrupted thread, Data = Interrupt number)
+#define SCHED_TRACE_EVENT_WAKE	5 // Thread woken (Thread = Target thread, Other = Calling thread)
+#define SCHED_TRACE_EVENT_READY	6 // Thread made ready (Thread = Target thread, Other = Calling thread)
+#define SCHED_TRACE_EVENT_MIGRATE_REQUEST	7 // Thread migration requested (Thread = Target thread, Other = Calling thread, Data = Requested CPU)
+#define SCHED_TRACE_EVENT_MARK	8 // Application marker (Thread = Calling thread, Data = Value passed to sched_trace_mark)
+
+/* Scheduler Trace Switch Reasons */
+#define SCHED_TRACE_REASON_PREEMPT	0 // Switched by the scheduler interrupt (Quantum expired or higher priority thread ready)
+#define SCHED_TRACE_REASON_INFERRED	1 // Switch not observed directly (Yield, sleep, wait or device interrupt), detected when a different thread was interrupted
+
+/* Scheduler Trace Switch Data (Packed into the Data field of a SWITCH event) */
+#define SCHED_TRACE_SWITCH_DATA(state, prevpriority, nextpriority, reason)	(((state) & 0xFF) | (((prevpriority) & 0xFF) << 8) | (((nextpriority) & 0xFF) << 16) | (((reason) & 0xFF) << 24))
+#define SCHED_TRACE_SWITCH_STATE(data)	((data) & 0xFF) // State of the previous thread (eg THREAD_STATE_READY)
+#define SCHED_TRACE_SWITCH_PREV_PRIORITY(data)	(((data) >> 8) & 0xFF) // Priority of the previous thread
+#define SCHED_TRACE_SWITCH_NEXT_PRIORITY(data)	(((data) >> 16) & 0xFF) // Priority of the next thread
+#define SCHED_TRACE_SWITCH_REASON(data)	(((data) >> 24) & 0xFF) // Reason for the switch (eg SCHED_TRACE_REASON_PREEMPT)
+
+/* ============================================================================== */
+/* Scheduler Trace specific types */
+
+/* Scheduler Trace Event */
+typedef struct _SCHED_TRACE_EVENT SCHED_TRACE_EVENT;
+struct _SCHED_TRACE_EVENT
+{
+	uint64_t timestamp; // Clock count (clock_get_total) when the event occurred
+	uint16_t eventtype; // Type of event (eg SCHED_TRACE_EVENT_SWITCH)
+	uint16_t cpuid; // CPU where the event occurred
+	uint32_t data; // Event specific data
+	THREAD_HANDLE thread; // Event specific thread (See event types)
+	THREAD_HANDLE other; // Event specific thread (See event types)
+};
+
+/* Scheduler Trace Header (Start of a binary trace capture, followed by the events of each CPU in time order) */
+typedef struct _SCHED_TRACE_HEADER SCHED_TRACE_HEADER;
+struct _SCHED_TRACE_HEADER
+{
+	uint32_t signature; // SCHED_TRACE_SIGNATURE
+	uint32_t version; // SCHED_TRACE_VERSION
+	uint32_t eventsize; // Size of each event in bytes
+	uint32_t cpucount; // Number of CPUs traced
+	uint32_t clockrate; // Rate of the timestamps (Counts per second)
+	uint32_t eventcount; // Total number of events following the header
+	uint64_t starttime; // Clock count when tracing was started
+};
+
+/* Scheduler Trace Statistics */
+typedef struct _SCHED_TRACE_STATISTICS SCHED_TRACE_STATISTICS;
+struct _SCHED_TRACE_STATISTICS
+{
+	uint32_t flags; // Trace flags (eg SCHED_TRACE_FLAG_WRAP)
+	uint32_t cpucount; // Number of CPUs traced
+	uint32_t eventsize; // Number of events in the buffer for each CPU
+	uint32_t hookcount; // Number of CPUs with the scheduler interrupt being traced
+	uint32_t eventcount; // Number of events currently in the buffers
+	uint32_t dropcount; // Number of events dropped (or overwritten if SCHED_TRACE_FLAG_WRAP) because a buffer was full
+	uint32_t switchcount; // Number of context switches recorded
+	uint32_t clockrate; // Rate of the timestamps (Counts per second, 0 if not yet known)
+	BOOL running; // TRUE if tracing is active
+};
+
+/* ============================================================================== */
+/* Scheduler Trace Functions */
+uint32_t STDCALL sched_trace_start(uint32_t events, uint32_t flags); // Events = 0 for SCHED_TRACE_DEFAULT_EVENTS
+uint32_t STDCALL sched_trace_stop(void);
+uint32_t STDCALL sched_trace_clear(void);
+
+uint32_t STDCALL sched_trace_get_statistics(SCHED_TRACE_STATISTICS *statistics);
+
+uint32_t STDCALL sched_trace_mark(uint32_t value);
+uint32_t STDCALL sched_trace_record(uint32_t eventtype, THREAD_HANDLE thread, THREAD_HANDLE other, uint32_t data);
+
+uint32_t STDCALL sched_trace_export(void *buffer, uint32_t len, uint32_t *count); // Binary capture (SCHED_TRACE_HEADER followed by events), Count returns the size required
+uint32_t STDCALL sched_trace_export_file(const char *filename); // Binary capture to a file
+uint32_t STDCALL sched_trace_export_json(const char *filename); // Chrome trace event JSON (Load in chrome://tracing or ui.perfetto.dev)
+
+/* ============================================================================== */
+/* Scheduler Trace Instrumented Functions */
+uint32_t STDCALL sched_trace_thread_ready(THREAD_HANDLE thread, BOOL reschedule);
+uint32_t STDCALL sched_trace_thread_wake(THREAD_HANDLE thread);
+uint32_t STDCALL sched_trace_thread_migrate(THREAD_HANDLE thread, uint32_t cpu);
+
+/* ============================================================================== */
+/* Scheduler Trace Redirection */
+/* When built with SCHED_TRACE defined (make SCHED_TRACE=1) calls to the thread functions
+   below are redirected to the instrumented versions which record an event and call the originals */
+#if defined(SCHED_TRACE) && !defined(SCHED_TRACE_INTERNAL)
+#define thread_ready(thread, reschedule)	sched_trace_thread_ready(thread, reschedule)
+#define thread_wake(thread)	sched_trace_thread_wake(thread)
+#define thread_migrate(thread, cpu)	sched_trace_thread_migrate(thread, cpu)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_SCHEDTRACE_H
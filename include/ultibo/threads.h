@@ -1416,4 +1416,14 @@ uint32_t STDCALL worker_get_messageslot_flags(void);
 }
 #endif
 
+/* Redirect lock functions to the instrumented versions in lock profiling builds (make LOCK_PROFILE=1) */
+#ifdef LOCK_PROFILE
+#include "ultibo/lockprofile.h"
+#endif
+
+/* Redirect thread wake and ready functions to the instrumented versions in scheduler trace builds (make SCHED_TRACE=1) */
+#ifdef SCHED_TRACE
+#include "ultibo/schedtrace.h"
+#endif
+
 #endif // _ULTIBO_THREADS_H
\ No newline at end of file
@@ -0,0 +1,94 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_THREADSTATS_H
+#define _ULTIBO_THREADSTATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+
+/* ============================================================================== */
+/* Thread Statistics specific constants */
+#define THREAD_STATS_DEFAULT_THREADS	256 // Default number of threads tracked by a history
+
+/* Thread Statistics Flags */
+#define THREAD_STATS_FLAG_NONE	0x00000000
+#define THREAD_STATS_FLAG_DELTA	0x00000001 // Return only threads that are new or whose kernel time or switch count changed since the last call with the same history
+
+/* ============================================================================== */
+/* Thread Statistics specific types */
+
+/* Thread Statistics (One per thread) */
+typedef struct _THREAD_STATS THREAD_STATS;
+struct _THREAD_STATS
+{
+	THREAD_HANDLE handle; // Handle of the thread
+	uint32_t cpu; // CPU from last ContextSwitch
+	uint32_t state; // State of the Thread (eg THREAD_STATE_RUNNING)
+	uint32_t priority; // Priority of the Thread (eg THREAD_PRIORITY_NORMAL)
+	uint32_t stacksize; // Stack length in bytes
+	uint32_t stackfree; // Stack free in bytes (From the stack pointer saved at the last ContextSwitch, or thread_get_stack_free for the calling thread)
+	int64_t kerneltime; // The total amount of time this thread has been in the running state (Same units as thread_get_times)
+	int64_t switchcount; // The number of times this thread has been selected to run by a context switch
+	int64_t kerneldelta; // Change in kerneltime since the last call with the same history (Or kerneltime if no history or a new thread)
+	int64_t switchdelta; // Change in switchcount since the last call with the same history (Or switchcount if no history or a new thread)
+};
+
+/* Thread Statistics CPU (One per CPU) */
+typedef struct _THREAD_STATS_CPU THREAD_STATS_CPU;
+struct _THREAD_STATS_CPU
+{
+	uint32_t cpu; // The CPU of these statistics
+	uint32_t threadcount; // Number of threads currently scheduled on this CPU
+	uint32_t utilization; // Utilization as reported by cpu_get_utilization
+	int64_t idletime; // Time consumed by the Idle thread of this CPU (Same units as thread_get_times)
+	int64_t irqtime; // Time accounted to the IRQ thread of this CPU
+	int64_t fiqtime; // Time accounted to the FIQ thread of this CPU
+	int64_t switime; // Time accounted to the SWI thread of this CPU
+};
+
+/* Thread Statistics History */
+typedef struct _THREAD_STATS_HISTORY THREAD_STATS_HISTORY;
+
+/* ============================================================================== */
+/* Thread Statistics Functions */
+THREAD_STATS_HISTORY * STDCALL thread_stats_history_create(uint32_t maxthreads); // MaxThreads = 0 for THREAD_STATS_DEFAULT_THREADS
+uint32_t STDCALL thread_stats_history_destroy(THREAD_STATS_HISTORY *history);
+uint32_t STDCALL thread_stats_history_reset(THREAD_STATS_HISTORY *history);
+
+uint32_t STDCALL thread_stats_get(THREAD_STATS *buffer, uint32_t len, uint32_t flags, THREAD_STATS_HISTORY *history, uint32_t *count); // History may be NULL unless flags includes THREAD_STATS_FLAG_DELTA, Count returns the number of matching threads
+uint32_t STDCALL thread_stats_get_cpu(uint32_t cpu, THREAD_STATS_CPU *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_THREADSTATS_H
@@ -0,0 +1,94 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_TIMERWHEEL_H
+#define _ULTIBO_TIMERWHEEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+
+/* ============================================================================== */
+/* Timer Wheel specific constants */
+#define TIMER_WHEEL_THREAD_NAME	"Timer Wheel" // Thread name for the Timer Wheel thread (Advances the wheel and executes TIMER_FLAG_PRIORITY events)
+#define TIMER_WHEEL_THREAD_PRIORITY	TIMER_PRIORITY_THREAD_PRIORITY // Thread priority for the Timer Wheel thread
+#define TIMER_WHEEL_EVENT_THREAD_NAME	"Timer Wheel Event" // Thread name for the Timer Wheel event thread (Executes events without TIMER_FLAG_PRIORITY or TIMER_FLAG_WORKER)
+#define TIMER_WHEEL_EVENT_THREAD_PRIORITY	TIMER_THREAD_PRIORITY // Thread priority for the Timer Wheel event thread
+#define TIMER_WHEEL_THREAD_STACK_SIZE	SIZE_16K // Stack size of the Timer Wheel threads
+
+#define TIMER_WHEEL_SIGNATURE	0x7E3E1A5D
+
+/* Wheel geometry (Each level has 64 slots, each slot of a level covers all 64 slots of the level below) */
+#define TIMER_WHEEL_LEVEL_BITS	6
+#define TIMER_WHEEL_LEVEL_SLOTS	(1 << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_LEVEL_MASK	(TIMER_WHEEL_LEVEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS	6 // Enough levels to hold any 32-bit interval in milliseconds
+
+/* ============================================================================== */
+/* Timer Wheel specific types */
+typedef struct _TIMER_WHEEL_TIMER TIMER_WHEEL_TIMER;
+
+/* Timer Wheel Statistics */
+typedef struct _TIMER_WHEEL_STATISTICS TIMER_WHEEL_STATISTICS;
+struct _TIMER_WHEEL_STATISTICS
+{
+	uint32_t timercount; // Number of timers created
+	uint32_t armedcount; // Number of timers currently in the wheel
+	uint64_t armcount; // Number of times a timer was put in the wheel
+	uint64_t cancelcount; // Number of times a timer was removed from the wheel before it expired
+	uint64_t expirecount; // Number of timers that expired
+	uint64_t cascadecount; // Number of timers moved from a higher level to a lower level
+	uint64_t batchcount; // Number of times the wheel was advanced with at least one timer expiring
+	uint32_t batchmax; // Largest number of timers expiring in one batch
+	uint32_t overruncount; // Number of times a timer expired again before the previous event completed
+	uint64_t wakeupcount; // Number of times the wheel thread woke up
+	uint64_t tick; // Current wheel time (Milliseconds since the wheel started)
+};
+
+/* ============================================================================== */
+/* Timer Wheel Functions */
+TIMER_WHEEL_TIMER * STDCALL timer_wheel_create(uint32_t interval, BOOL enabled, BOOL reschedule, timer_event_proc event, void *data);
+TIMER_WHEEL_TIMER * STDCALL timer_wheel_create_ex(uint32_t interval, uint32_t state, uint32_t flags, timer_event_proc event, void *data);
+uint32_t STDCALL timer_wheel_destroy(TIMER_WHEEL_TIMER *timer);
+
+uint32_t STDCALL timer_wheel_enable(TIMER_WHEEL_TIMER *timer);
+uint32_t STDCALL timer_wheel_enable_ex(TIMER_WHEEL_TIMER *timer, uint32_t interval, timer_event_proc event, void *data);
+uint32_t STDCALL timer_wheel_disable(TIMER_WHEEL_TIMER *timer);
+
+uint32_t STDCALL timer_wheel_get_slack(TIMER_WHEEL_TIMER *timer);
+uint32_t STDCALL timer_wheel_set_slack(TIMER_WHEEL_TIMER *timer, uint32_t slack); // Slack = Milliseconds the timer may be delayed so it expires together with other timers
+
+uint32_t STDCALL timer_wheel_get_statistics(TIMER_WHEEL_STATISTICS *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_TIMERWHEEL_H
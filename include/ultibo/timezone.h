@@ -48,6 +48,9 @@ extern "C" {
 #define TIMEZONE_NAME_LENGTH	SIZE_64 // Length of timezone name
 #define TIMEZONE_DESC_LENGTH	SIZE_128 // Length of timezone description
 
+/* Timezone Cache */
+#define TIMEZONE_CACHE_YEARS	3 // Number of years of transitions held for each timezone (The year of the last lookup and the years either side)
+
 /* ============================================================================== */
 /* Timezone specific types */
 
@@ -146,6 +149,23 @@ uint32_t STDCALL timezone_update_offset(void);
 double_t STDCALL timezone_start_to_date_time(SYSTEMTIME *start, uint16_t year);
 uint32_t STDCALL timezone_start_to_description(SYSTEMTIME *start, char *description, uint32_t len);
 
+/* ============================================================================== */
+/* Timezone Cache Functions */
+/* Transitions are cached per timezone, a lookup is a range check until the next DST boundary. Timezone may be NULL for the default timezone */
+uint32_t STDCALL timezone_cache_get_state(TIMEZONE_ENTRY *timezone, double_t datetime); // Same result as timezone_get_state_ex
+int32_t STDCALL timezone_cache_get_active_bias(TIMEZONE_ENTRY *timezone, double_t datetime); // Same result as timezone_get_active_bias_ex
+int32_t STDCALL timezone_cache_get_universal_bias(TIMEZONE_ENTRY *timezone, int64_t time); // Active bias at a UTC time in 100 nanosecond ticks since 1/1/1601 (Same result as SystemTimeToTzSpecificLocalTime)
+int64_t STDCALL timezone_cache_universal_to_local(TIMEZONE_ENTRY *timezone, int64_t time); // UTC to local time in 100 nanosecond ticks since 1/1/1601 using the bias in effect at that time
+
+int32_t STDCALL timezone_cache_get_active_offset(void); // See GetTimezoneActiveOffset
+BOOL STDCALL timezone_cache_file_time_to_local_file_time(const FILETIME *filetime, FILETIME *localfiletime); // See FileTimeToLocalFileTime
+BOOL STDCALL timezone_cache_local_file_time_to_file_time(const FILETIME *localfiletime, FILETIME *filetime); // See LocalFileTimeToFileTime
+BOOL STDCALL timezone_cache_system_time_to_local_time(TIME_ZONE_INFORMATION *timezoneinformation, const SYSTEMTIME *universaltime, SYSTEMTIME *localtime); // See SystemTimeToTzSpecificLocalTime (Timezone information other than NULL is passed to the RTL)
+
+uint32_t STDCALL timezone_cache_invalidate(TIMEZONE_ENTRY *timezone); // Timezone = NULL then invalidate all, required after changing or deleting an entry directly
+uint32_t STDCALL timezone_cache_update_offset(void); // Calls timezone_update_offset and invalidates all
+BOOL STDCALL timezone_cache_set_information(TIME_ZONE_INFORMATION *timezoneinformation); // Calls SetTimeZoneInformation and invalidates all
+
 #ifdef __cplusplus
 }
 #endif
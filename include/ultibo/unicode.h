@@ -34,6 +34,14 @@ extern "C" {
 #include "ultibo/globalconst.h"
 #include "ultibo/locale.h"
 
+/* ============================================================================== */
+/* Unicode specific constants */
+
+/* Unicode Fast Path Implementations */
+#define UNICODE_IMPL_SCALAR	0 // One character at a time (Reference implementation for testing)
+#define UNICODE_IMPL_WORD	1 // ASCII runs, case mapping and surrogate scans a word at a time (ARMv6 and ARMv7)
+#define UNICODE_IMPL_NEON	2 // NEON 16 byte blocks including UTF-8 validation (ARMv8 in 64bit mode)
+
 /* ============================================================================== */
 /* Unicode Functions */
 int STDCALL MultiByteToWideChar(unsigned int codepage, uint32_t dwflags, char *lpmultibytestr, int cbmultibyte, WCHAR *lpwidecharstr, int cchwidechar);
@@ -80,6 +88,30 @@ BOOL STDCALL OemToCharBuff(char *lpszsrc, char *lpszdst, uint32_t cchdstlength);
 BOOL STDCALL OemToCharBuffA(char *lpszsrc, char *lpszdst, uint32_t cchdstlength);
 BOOL STDCALL OemToCharBuffW(char *lpszsrc, WCHAR *lpszdst, uint32_t cchdstlength);
 
+/* ============================================================================== */
+/* Unicode Fast Path Functions */
+/* These return exactly what the function they replace returns, anything outside the fast paths is passed to that function */
+int STDCALL unicode_multi_byte_to_wide_char(unsigned int codepage, uint32_t dwflags, const char *lpmultibytestr, int cbmultibyte, WCHAR *lpwidecharstr, int cchwidechar); // Fast paths for CP_UTF8 and single byte code pages (See MultiByteToWideChar)
+int STDCALL unicode_wide_char_to_multi_byte(unsigned int codepage, uint32_t dwflags, const WCHAR *lpwidecharstr, int cchwidechar, char *lpmultibytestr, int cbmultibyte, char *lpdefaultchar, BOOL *lpuseddefaultchar); // Fast paths for CP_UTF8 and single byte code pages (See WideCharToMultiByte)
+
+uint32_t STDCALL unicode_char_upper_buff(char *lpsz, uint32_t cchlength); // See CharUpperBuffA
+uint32_t STDCALL unicode_char_upper_buff_w(WCHAR *lpsz, uint32_t cchlength); // See CharUpperBuffW
+uint32_t STDCALL unicode_char_lower_buff(char *lpsz, uint32_t cchlength); // See CharLowerBuffA
+uint32_t STDCALL unicode_char_lower_buff_w(WCHAR *lpsz, uint32_t cchlength); // See CharLowerBuffW
+
+BOOL STDCALL unicode_ansi_to_oem_buff(const char *lpszsrc, char *lpszdst, uint32_t cchdstlength); // See AnsiToOemBuff
+BOOL STDCALL unicode_oem_to_ansi_buff(const char *lpszsrc, char *lpszdst, uint32_t cchdstlength); // See OemToAnsiBuff
+
+BOOL STDCALL unicode_utf8_validate(const char *str, uint32_t len); // Rejects overlong forms, surrogates, values above U+10FFFF and truncated sequences
+BOOL STDCALL unicode_utf16_validate(const WCHAR *str, uint32_t len); // Rejects unpaired surrogates
+
+uint32_t STDCALL unicode_get_implementation(void);
+uint32_t STDCALL unicode_set_implementation(uint32_t implementation); // Returns ERROR_NOT_SUPPORTED if the implementation is not available in this build
+
+/* ============================================================================== */
+/* Unicode Helper Functions */
+uint32_t STDCALL unicode_implementation_to_string(uint32_t implementation, char *string, uint32_t len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,88 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ULTIBO_WORKERPOOL_H
+#define _ULTIBO_WORKERPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+
+/* ============================================================================== */
+/* Worker Pool specific constants */
+#define WORKER_POOL_THREAD_NAME	"CPU Worker" // Thread name for the per CPU worker threads
+#define WORKER_POOL_THREAD_PRIORITY	WORKER_THREAD_PRIORITY // Thread priority for the per CPU worker threads
+#define WORKER_POOL_THREAD_STACK_SIZE	SIZE_32K // Stack size of the per CPU worker threads
+
+#define WORKER_POOL_DEFAULT_THREADS	1 // Default number of worker threads for each CPU
+#define WORKER_POOL_MAX_THREADS	8 // Maximum number of worker threads for each CPU
+#define WORKER_POOL_QUEUE_SIZE	1024 // Number of tasks each CPU queue can hold (Must be a power of 2)
+
+/* Worker Pool Flags */
+#define WORKER_POOL_FLAG_NONE	0x00000000
+#define WORKER_POOL_FLAG_PINNED	0x00000001 // Task must run on the CPU it was scheduled on, it will not be stolen by another CPU
+
+/* ============================================================================== */
+/* Worker Pool specific types */
+
+/* Worker Pool Statistics (One per CPU queue) */
+typedef struct _WORKER_POOL_STATISTICS WORKER_POOL_STATISTICS;
+struct _WORKER_POOL_STATISTICS
+{
+	uint32_t cpu; // The CPU of this queue
+	uint32_t threadcount; // Number of worker threads bound to this CPU
+	uint32_t depth; // Number of tasks currently waiting in the queue
+	uint32_t maxdepth; // Largest number of tasks waiting in the queue
+	uint64_t queuedcount; // Number of tasks added to the queue
+	uint64_t executedcount; // Number of tasks executed by the workers of this CPU (Including stolen tasks)
+	uint64_t stolencount; // Number of tasks the workers of this CPU took from other queues
+	uint64_t donatedcount; // Number of tasks taken from this queue by the workers of other CPUs
+	uint32_t overflowcount; // Number of tasks rejected because the queue was full
+	uint64_t latencytotal; // Total time from schedule to start for executed tasks (Microseconds)
+	uint32_t latencymax; // Longest time from schedule to start for an executed task (Microseconds)
+};
+
+/* ============================================================================== */
+/* Worker Pool Functions */
+uint32_t STDCALL worker_pool_start(uint32_t count); // Count = worker threads for each CPU, 0 for WORKER_POOL_DEFAULT_THREADS
+
+uint32_t STDCALL worker_schedule_on(uint32_t cpu, worker_task_proc task, void *data, worker_cb callback);
+uint32_t STDCALL worker_schedule_on_ex(uint32_t cpu, uint32_t flags, worker_task_proc task, void *data, worker_cb callback);
+uint32_t STDCALL worker_schedule_local(worker_task_proc task, void *data, worker_cb callback);
+
+uint32_t STDCALL worker_pool_get_count(void);
+uint32_t STDCALL worker_pool_get_statistics(uint32_t cpu, WORKER_POOL_STATISTICS *statistics);
+uint32_t STDCALL worker_pool_reset_statistics(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ULTIBO_WORKERPOOL_H
@@ -0,0 +1,990 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/filesystem.h"
+#include "ultibo/workerpool.h"
+
+#include "fftw_port_ultibo.h"
+
+/*
+ * Implementation of the Ultibo spectral analysis port for FFTW (Single precision)
+ *
+ * Samples are written into a single producer, single consumer ring which needs no
+ * lock, so capture code such as an audio DMA completion or an ADC interrupt handler
+ * can feed an analyzer directly. The consumer takes a frame of size samples from
+ * the ring, applies the window and runs the real to complex transform, then moves
+ * on by hop samples so consecutive frames overlap. Samples written while the ring
+ * is full are dropped and counted rather than blocking the producer.
+ *
+ * Plans are shared by every analyzer with the same size and planner rigor and are
+ * executed with the new array interface (fftwf_execute_dft_r2c), which FFTW allows
+ * from any number of threads at once as long as all arrays have the alignment of
+ * the arrays used for planning (Every array here comes from fftwf_malloc). The
+ * FFTW planner itself is not thread safe so all planning and all wisdom import and
+ * export is serialized by one lock.
+ *
+ * Measuring a plan for a large size takes seconds on a Raspberry Pi, the result of
+ * that measurement can be exported as wisdom and imported on the next boot. Each
+ * plan is first requested with FFTW_WISDOM_ONLY so the statistics show whether the
+ * wisdom was used, and FFTW_ULTIBO_FLAG_NO_MEASURE falls back to FFTW_ESTIMATE when
+ * there is no wisdom instead of measuring.
+ *
+ * The prebuilt library does not include the FFTW threads support so a single
+ * transform cannot be split across CPUs. With FFTW_ULTIBO_FLAG_WORKERS whole frames
+ * are instead handed to the per CPU worker pools (ultibo/workerpool.h) in turn, each
+ * frame in its own slot with private buffers, which suits the many small overlapping
+ * frames of streaming analysis better than splitting each transform would.
+ */
+
+/* ============================================================================== */
+/* FFTW Analyzer specific constants */
+#define FFTW_ULTIBO_SIGNATURE	0x46465457
+
+/* ============================================================================== */
+/* FFTW Analyzer specific types */
+/* FFTW Plan (Shared by analyzers of the same size and rigor) */
+typedef struct _FFTW_ULTIBO_PLAN FFTW_ULTIBO_PLAN;
+struct _FFTW_ULTIBO_PLAN
+{
+	uint32_t size; // FFT size (Samples)
+	uint32_t planning; // Planner rigor the plan was created with (eg FFTW_ULTIBO_PLAN_MEASURE)
+	fftwf_plan plan; // FFTW plan
+	uint32_t refcount; // Number of analyzers using the plan
+	BOOL wisdom; // Plan was created from wisdom
+	FFTW_ULTIBO_PLAN *next; // Next plan in the list
+};
+
+/* FFTW Slot (Buffers for one frame) */
+typedef struct _FFTW_ULTIBO_SLOT FFTW_ULTIBO_SLOT;
+struct _FFTW_ULTIBO_SLOT
+{
+	FFTW_ULTIBO_ANALYZER *analyzer; // Analyzer owning this slot
+	uint32_t index; // Slot number
+	uint64_t frame; // Number of the frame in this slot
+	float *input; // Windowed frame (size samples)
+	fftwf_complex *output; // Transform (bins values)
+	float *spectrum; // Power or decibel spectrum (bins values)
+};
+
+/* FFTW Analyzer */
+struct _FFTW_ULTIBO_ANALYZER
+{
+	uint32_t signature; // Signature for entry validation
+	FFTW_ULTIBO_CONFIG config; // Configuration after defaults are applied
+	fftw_ultibo_spectrum_cb callback; // Spectrum callback
+	void *data; // Data for the spectrum callback
+	FFTW_ULTIBO_PLAN *plan; // Shared plan
+	uint32_t bins; // Number of spectrum values (size / 2 + 1)
+	float *window; // Window coefficients
+	float scale; // Power scale for bins 1 to bins - 2 (Bin 0 and the last bin use half)
+	// Ring Properties
+	float *ring; // Sample ring (ringsize samples)
+	uint32_t ringmask; // Ring size - 1
+	uint32_t need; // Samples required in the ring before a frame can be taken
+	volatile uint32_t head; // Total samples written (Updated only by the producer)
+	volatile uint32_t tail; // Start of the next frame (Updated only by the consumer)
+	// Processing Properties
+	MUTEX_HANDLE lock; // Consumer lock (Held while frames are taken from the ring)
+	SEMAPHORE_HANDLE signal; // Signalled by the producer when a frame is available (FFTW_ULTIBO_FLAG_THREAD only)
+	SEMAPHORE_HANDLE finished; // Signalled by the thread when it exits
+	THREAD_HANDLE thread; // Analyzer thread (FFTW_ULTIBO_FLAG_THREAD only)
+	volatile BOOL running; // Analyzer thread should keep running
+	uint64_t frame; // Number of the next frame
+	volatile uint64_t dispatched; // Frames taken from the ring
+	volatile uint64_t completed; // Frames delivered to the callback
+	// Slot Properties
+	uint32_t slotcount; // Number of slots (1 without FFTW_ULTIBO_FLAG_WORKERS)
+	SEMAPHORE_HANDLE slotsfree; // Count of free slots (FFTW_ULTIBO_FLAG_WORKERS only)
+	volatile uint32_t slotmask; // Bit set for each free slot (FFTW_ULTIBO_FLAG_WORKERS only)
+	uint32_t nextcpu; // CPU for the next frame (FFTW_ULTIBO_FLAG_WORKERS only)
+	uint32_t cpucount; // Number of CPUs
+	FFTW_ULTIBO_SLOT slots[FFTW_ULTIBO_MAX_SLOTS];
+	// Statistics Properties
+	FFTW_ULTIBO_STATISTICS statistics;
+};
+
+/* ============================================================================== */
+/* FFTW Analyzer variables */
+static MUTEX_HANDLE fftw_ultibo_planner_lock = INVALID_HANDLE_VALUE;
+static FFTW_ULTIBO_PLAN *fftw_ultibo_plans;
+
+/* ============================================================================== */
+/* FFTW Analyzer Internal Functions */
+static FFTW_ULTIBO_ANALYZER *fftw_ultibo_check(FFTW_ULTIBO_ANALYZER *analyzer)
+{
+	if (!analyzer || analyzer->signature != FFTW_ULTIBO_SIGNATURE)
+		return NULL;
+
+	return analyzer;
+}
+
+/* Lock the planner, creating the lock on first use */
+static uint32_t fftw_ultibo_planner_acquire(void)
+{
+	MUTEX_HANDLE lock;
+
+	if (fftw_ultibo_planner_lock == INVALID_HANDLE_VALUE)
+	{
+		lock = mutex_create();
+		if (lock == INVALID_HANDLE_VALUE)
+			return ERROR_OPERATION_FAILED;
+
+		if (!__sync_bool_compare_and_swap(&fftw_ultibo_planner_lock, INVALID_HANDLE_VALUE, lock))
+			mutex_destroy(lock);
+	}
+
+	return mutex_lock(fftw_ultibo_planner_lock);
+}
+
+static void fftw_ultibo_planner_release(void)
+{
+	mutex_unlock(fftw_ultibo_planner_lock);
+}
+
+static unsigned int fftw_ultibo_rigor(uint32_t planning)
+{
+	switch (planning)
+	{
+		case FFTW_ULTIBO_PLAN_ESTIMATE:
+			return FFTW_ESTIMATE;
+		case FFTW_ULTIBO_PLAN_PATIENT:
+			return FFTW_PATIENT;
+	}
+
+	return FFTW_MEASURE;
+}
+
+/* Find or create a plan, caller must hold the planner lock */
+static FFTW_ULTIBO_PLAN *fftw_ultibo_plan_acquire(uint32_t size, uint32_t planning, BOOL nomeasure)
+{
+	FFTW_ULTIBO_PLAN *plan;
+	fftwf_complex *output;
+	fftwf_plan created;
+	float *input;
+	BOOL wisdom;
+
+	for (plan = fftw_ultibo_plans; plan; plan = plan->next)
+	{
+		if (plan->size == size && plan->planning == planning)
+		{
+			plan->refcount++;
+			return plan;
+		}
+	}
+
+	/* Measuring overwrites the arrays so the plan is created on scratch buffers */
+	input = fftwf_malloc(sizeof(float) * size);
+	output = fftwf_malloc(sizeof(fftwf_complex) * (size / 2 + 1));
+	if (!input || !output)
+	{
+		fftwf_free(output);
+		fftwf_free(input);
+		return NULL;
+	}
+
+	wisdom = TRUE;
+	created = fftwf_plan_dft_r2c_1d(size, input, output, fftw_ultibo_rigor(planning) | FFTW_DESTROY_INPUT | FFTW_WISDOM_ONLY);
+	if (!created)
+	{
+		wisdom = FALSE;
+
+		if (nomeasure && planning != FFTW_ULTIBO_PLAN_ESTIMATE)
+		{
+			fftwf_free(output);
+			fftwf_free(input);
+			return fftw_ultibo_plan_acquire(size, FFTW_ULTIBO_PLAN_ESTIMATE, FALSE);
+		}
+
+		created = fftwf_plan_dft_r2c_1d(size, input, output, fftw_ultibo_rigor(planning) | FFTW_DESTROY_INPUT);
+	}
+
+	fftwf_free(output);
+	fftwf_free(input);
+
+	if (!created)
+		return NULL;
+
+	plan = calloc(1, sizeof(FFTW_ULTIBO_PLAN));
+	if (!plan)
+	{
+		fftwf_destroy_plan(created);
+		return NULL;
+	}
+
+	plan->size = size;
+	plan->planning = planning;
+	plan->plan = created;
+	plan->refcount = 1;
+	plan->wisdom = wisdom;
+	plan->next = fftw_ultibo_plans;
+	fftw_ultibo_plans = plan;
+
+	return plan;
+}
+
+/* Release a plan, caller must hold the planner lock */
+static void fftw_ultibo_plan_release(FFTW_ULTIBO_PLAN *plan)
+{
+	FFTW_ULTIBO_PLAN **link;
+
+	if (--plan->refcount > 0)
+		return;
+
+	/* Destroyed when unused, the wisdom remains so creating it again is quick */
+	for (link = &fftw_ultibo_plans; *link; link = &(*link)->next)
+	{
+		if (*link == plan)
+		{
+			*link = plan->next;
+			break;
+		}
+	}
+
+	fftwf_destroy_plan(plan->plan);
+	free(plan);
+}
+
+static void fftw_ultibo_window_create(float *window, uint32_t size, uint32_t type)
+{
+	uint32_t index;
+	double phase;
+
+	/* Periodic windows, the correct form for overlapping spectral frames */
+	for (index = 0; index < size; index++)
+	{
+		phase = (2.0 * M_PI * index) / size;
+
+		switch (type)
+		{
+			case FFTW_ULTIBO_WINDOW_HAMMING:
+				window[index] = 0.54 - 0.46 * cos(phase);
+				break;
+			case FFTW_ULTIBO_WINDOW_BLACKMAN:
+				window[index] = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2.0 * phase);
+				break;
+			case FFTW_ULTIBO_WINDOW_BLACKMAN_HARRIS:
+				window[index] = 0.35875 - 0.48829 * cos(phase) + 0.14128 * cos(2.0 * phase) - 0.01168 * cos(3.0 * phase);
+				break;
+			case FFTW_ULTIBO_WINDOW_RECTANGULAR:
+				window[index] = 1.0;
+				break;
+			default:
+				window[index] = 0.5 - 0.5 * cos(phase);
+				break;
+		}
+	}
+}
+
+static void fftw_ultibo_statistics_update(FFTW_ULTIBO_ANALYZER *analyzer, uint32_t elapsed)
+{
+	uint32_t current;
+
+	__atomic_add_fetch(&analyzer->statistics.framecount, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&analyzer->statistics.executetime, elapsed, __ATOMIC_RELAXED);
+
+	current = __atomic_load_n(&analyzer->statistics.executemax, __ATOMIC_RELAXED);
+	while (elapsed > current)
+	{
+		if (__atomic_compare_exchange_n(&analyzer->statistics.executemax, &current, elapsed, FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			break;
+	}
+}
+
+/* Transform a windowed frame and deliver the spectrum */
+static void fftw_ultibo_transform(FFTW_ULTIBO_SLOT *slot, int64_t start)
+{
+	FFTW_ULTIBO_ANALYZER *analyzer = slot->analyzer;
+	fftwf_complex *output;
+	uint32_t bin;
+	float *spectrum;
+	float power;
+
+	fftwf_execute_dft_r2c(analyzer->plan->plan, slot->input, slot->output);
+
+	output = slot->output;
+	spectrum = slot->spectrum;
+	for (bin = 0; bin < analyzer->bins; bin++)
+	{
+		power = (output[bin][0] * output[bin][0]) + (output[bin][1] * output[bin][1]);
+		spectrum[bin] = power * analyzer->scale;
+	}
+
+	/* DC and Nyquist have no mirror image in the negative frequencies */
+	spectrum[0] *= 0.5f;
+	if ((analyzer->config.size & 1) == 0)
+		spectrum[analyzer->bins - 1] *= 0.5f;
+
+	if (analyzer->config.flags & FFTW_ULTIBO_FLAG_DECIBEL)
+	{
+		for (bin = 0; bin < analyzer->bins; bin++)
+			spectrum[bin] = 10.0f * log10f(spectrum[bin] + 1e-20f);
+	}
+
+	fftw_ultibo_statistics_update(analyzer, clock_microseconds() - start);
+
+	if (analyzer->callback)
+		analyzer->callback(analyzer, spectrum, analyzer->bins, slot->frame, analyzer->data);
+
+	__atomic_add_fetch(&analyzer->completed, 1, __ATOMIC_RELEASE);
+}
+
+static void STDCALL fftw_ultibo_worker_task(void *data)
+{
+	FFTW_ULTIBO_SLOT *slot = data;
+	FFTW_ULTIBO_ANALYZER *analyzer = slot->analyzer;
+
+	fftw_ultibo_transform(slot, clock_microseconds());
+
+	/* Return the slot */
+	__atomic_or_fetch(&analyzer->slotmask, 1 << slot->index, __ATOMIC_RELEASE);
+	semaphore_signal(analyzer->slotsfree);
+}
+
+/* Copy the next frame from the ring into a slot with the window applied */
+static void fftw_ultibo_frame_take(FFTW_ULTIBO_ANALYZER *analyzer, FFTW_ULTIBO_SLOT *slot)
+{
+	const float *window;
+	uint32_t offset;
+	uint32_t first;
+	uint32_t index;
+	float *input;
+
+	offset = analyzer->tail & analyzer->ringmask;
+	first = analyzer->ringmask + 1 - offset;
+	if (first > analyzer->config.size)
+		first = analyzer->config.size;
+
+	input = slot->input;
+	window = analyzer->window;
+	for (index = 0; index < first; index++)
+		input[index] = analyzer->ring[offset + index] * window[index];
+	for (; index < analyzer->config.size; index++)
+		input[index] = analyzer->ring[index - first] * window[index];
+
+	slot->frame = analyzer->frame++;
+
+	__atomic_add_fetch(&analyzer->dispatched, 1, __ATOMIC_RELAXED);
+
+	/* Publish the new tail only after the samples have been read so the producer cannot overwrite them */
+	__atomic_store_n(&analyzer->tail, analyzer->tail + analyzer->config.hop, __ATOMIC_RELEASE);
+}
+
+/* Take and transform all complete frames, caller must hold the analyzer lock */
+static uint32_t fftw_ultibo_frames_process(FFTW_ULTIBO_ANALYZER *analyzer)
+{
+	FFTW_ULTIBO_SLOT *slot;
+	uint32_t count;
+	uint32_t index;
+	uint32_t mask;
+	int64_t start;
+
+	count = 0;
+	while (__atomic_load_n(&analyzer->head, __ATOMIC_ACQUIRE) - analyzer->tail >= analyzer->need)
+	{
+		if (!(analyzer->config.flags & FFTW_ULTIBO_FLAG_WORKERS))
+		{
+			start = clock_microseconds();
+			fftw_ultibo_frame_take(analyzer, &analyzer->slots[0]);
+			fftw_ultibo_transform(&analyzer->slots[0], start);
+		}
+		else
+		{
+			if (semaphore_wait_ex(analyzer->slotsfree, 0) != ERROR_SUCCESS)
+			{
+				__atomic_add_fetch(&analyzer->statistics.waitcount, 1, __ATOMIC_RELAXED);
+				semaphore_wait(analyzer->slotsfree);
+			}
+
+			/* The semaphore guarantees at least one bit is set */
+			mask = __atomic_load_n(&analyzer->slotmask, __ATOMIC_ACQUIRE);
+			index = __builtin_ctz(mask);
+			__atomic_and_fetch(&analyzer->slotmask, ~(1 << index), __ATOMIC_ACQUIRE);
+
+			slot = &analyzer->slots[index];
+			fftw_ultibo_frame_take(analyzer, slot);
+
+			if (worker_schedule_on(analyzer->nextcpu, fftw_ultibo_worker_task, slot, NULL) != ERROR_SUCCESS)
+				fftw_ultibo_worker_task(slot);
+
+			analyzer->nextcpu = (analyzer->nextcpu + 1) % analyzer->cpucount;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+static ssize_t STDCALL fftw_ultibo_execute(void *parameter)
+{
+	FFTW_ULTIBO_ANALYZER *analyzer = parameter;
+
+	while (analyzer->running)
+	{
+		semaphore_wait(analyzer->signal);
+
+		mutex_lock(analyzer->lock);
+		fftw_ultibo_frames_process(analyzer);
+		mutex_unlock(analyzer->lock);
+	}
+
+	semaphore_signal(analyzer->finished);
+
+	return 0;
+}
+
+/* Space in the ring for the producer */
+static inline uint32_t fftw_ultibo_ring_space(FFTW_ULTIBO_ANALYZER *analyzer, uint32_t count)
+{
+	uint32_t space;
+
+	space = analyzer->ringmask + 1 - (analyzer->head - __atomic_load_n(&analyzer->tail, __ATOMIC_ACQUIRE));
+	if (count > space)
+	{
+		analyzer->statistics.overflowcount += count - space;
+		count = space;
+	}
+
+	return count;
+}
+
+/* Make written samples visible to the consumer */
+static inline void fftw_ultibo_ring_commit(FFTW_ULTIBO_ANALYZER *analyzer, uint32_t count)
+{
+	uint32_t head;
+
+	head = analyzer->head + count;
+	__atomic_store_n(&analyzer->head, head, __ATOMIC_RELEASE);
+
+	analyzer->statistics.samplecount += count;
+
+	if (analyzer->signal != INVALID_HANDLE_VALUE && head - __atomic_load_n(&analyzer->tail, __ATOMIC_ACQUIRE) >= analyzer->need)
+		semaphore_signal(analyzer->signal);
+}
+
+static void fftw_ultibo_analyzer_free(FFTW_ULTIBO_ANALYZER *analyzer)
+{
+	uint32_t index;
+
+	for (index = 0; index < FFTW_ULTIBO_MAX_SLOTS; index++)
+	{
+		fftwf_free(analyzer->slots[index].spectrum);
+		fftwf_free(analyzer->slots[index].output);
+		fftwf_free(analyzer->slots[index].input);
+	}
+
+	if (analyzer->plan)
+	{
+		if (fftw_ultibo_planner_acquire() == ERROR_SUCCESS)
+		{
+			fftw_ultibo_plan_release(analyzer->plan);
+			fftw_ultibo_planner_release();
+		}
+	}
+
+	if (analyzer->slotsfree != INVALID_HANDLE_VALUE)
+		semaphore_destroy(analyzer->slotsfree);
+	if (analyzer->finished != INVALID_HANDLE_VALUE)
+		semaphore_destroy(analyzer->finished);
+	if (analyzer->signal != INVALID_HANDLE_VALUE)
+		semaphore_destroy(analyzer->signal);
+	if (analyzer->lock != INVALID_HANDLE_VALUE)
+		mutex_destroy(analyzer->lock);
+
+	fftwf_free(analyzer->window);
+	fftwf_free(analyzer->ring);
+
+	analyzer->signature = 0;
+	free(analyzer);
+}
+
+/* ============================================================================== */
+/* FFTW Wisdom Functions */
+uint32_t STDCALL fftw_ultibo_wisdom_load(const char *filename)
+{
+	HANDLE handle;
+	int32_t size;
+	uint32_t status;
+	char *wisdom;
+
+	if (!filename)
+		return ERROR_INVALID_PARAMETER;
+
+	handle = FileOpen(filename, fmOpenRead | fmShareDenyNone);
+	if (handle == INVALID_HANDLE_VALUE)
+		return ERROR_FILE_NOT_FOUND;
+
+	size = FileSize(handle);
+	wisdom = (size > 0) ? malloc(size + 1) : NULL;
+	if (!wisdom)
+	{
+		FileClose(handle);
+		return (size > 0) ? ERROR_NOT_ENOUGH_MEMORY : ERROR_INVALID_DATA;
+	}
+
+	if (FileRead(handle, wisdom, size) != size)
+	{
+		FileClose(handle);
+		free(wisdom);
+		return ERROR_READ_FAULT;
+	}
+	wisdom[size] = '\0';
+
+	FileClose(handle);
+
+	status = fftw_ultibo_planner_acquire();
+	if (status == ERROR_SUCCESS)
+	{
+		/* A damaged file is rejected as a whole, the planner simply measures again */
+		if (!fftwf_import_wisdom_from_string(wisdom))
+			status = ERROR_INVALID_DATA;
+
+		fftw_ultibo_planner_release();
+	}
+
+	free(wisdom);
+
+	return status;
+}
+
+uint32_t STDCALL fftw_ultibo_wisdom_save(const char *filename)
+{
+	HANDLE handle;
+	uint32_t status;
+	int32_t size;
+	char *wisdom;
+
+	if (!filename)
+		return ERROR_INVALID_PARAMETER;
+
+	status = fftw_ultibo_planner_acquire();
+	if (status != ERROR_SUCCESS)
+		return status;
+
+	wisdom = fftwf_export_wisdom_to_string();
+
+	fftw_ultibo_planner_release();
+
+	if (!wisdom)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	handle = FileCreate(filename);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		free(wisdom);
+		return ERROR_ACCESS_DENIED;
+	}
+
+	size = strlen(wisdom);
+	status = (FileWrite(handle, wisdom, size) == size) ? ERROR_SUCCESS : ERROR_WRITE_FAULT;
+
+	FileClose(handle);
+	free(wisdom);
+
+	return status;
+}
+
+uint32_t STDCALL fftw_ultibo_wisdom_forget(void)
+{
+	uint32_t status;
+
+	status = fftw_ultibo_planner_acquire();
+	if (status != ERROR_SUCCESS)
+		return status;
+
+	fftwf_forget_wisdom();
+
+	fftw_ultibo_planner_release();
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* FFTW Analyzer Functions */
+FFTW_ULTIBO_ANALYZER * STDCALL fftw_ultibo_analyzer_create(FFTW_ULTIBO_CONFIG *config, fftw_ultibo_spectrum_cb callback, void *data)
+{
+	FFTW_ULTIBO_ANALYZER *analyzer;
+	FFTW_ULTIBO_SLOT *slot;
+	uint32_t ringsize;
+	uint32_t index;
+	int64_t start;
+	double sum;
+
+	analyzer = calloc(1, sizeof(FFTW_ULTIBO_ANALYZER));
+	if (!analyzer)
+		return NULL;
+
+	analyzer->lock = INVALID_HANDLE_VALUE;
+	analyzer->signal = INVALID_HANDLE_VALUE;
+	analyzer->finished = INVALID_HANDLE_VALUE;
+	analyzer->slotsfree = INVALID_HANDLE_VALUE;
+	analyzer->thread = INVALID_HANDLE_VALUE;
+	analyzer->callback = callback;
+	analyzer->data = data;
+
+	/* Apply the defaults */
+	if (config)
+		analyzer->config = *config;
+	if (analyzer->config.size == 0)
+		analyzer->config.size = FFTW_ULTIBO_DEFAULT_SIZE;
+	if (analyzer->config.hop == 0)
+		analyzer->config.hop = analyzer->config.size / 2;
+
+	if (analyzer->config.size < FFTW_ULTIBO_MIN_SIZE || analyzer->config.size > FFTW_ULTIBO_MAX_SIZE
+	 || analyzer->config.hop > FFTW_ULTIBO_MAX_SIZE || analyzer->config.ringsize > FFTW_ULTIBO_MAX_RING_SIZE
+	 || analyzer->config.window > FFTW_ULTIBO_WINDOW_MAX || analyzer->config.planning > FFTW_ULTIBO_PLAN_PATIENT)
+	{
+		free(analyzer);
+		return NULL;
+	}
+
+	analyzer->need = (analyzer->config.hop > analyzer->config.size) ? analyzer->config.hop : analyzer->config.size;
+
+	ringsize = analyzer->config.ringsize;
+	if (ringsize < analyzer->need * 4)
+		ringsize = analyzer->need * 4;
+	for (index = FFTW_ULTIBO_MIN_SIZE; index < ringsize; index <<= 1);
+	analyzer->config.ringsize = index;
+	analyzer->ringmask = index - 1;
+
+	analyzer->bins = (analyzer->config.size / 2) + 1;
+	analyzer->cpucount = cpu_get_count();
+	analyzer->slotcount = 1;
+	if (analyzer->config.flags & FFTW_ULTIBO_FLAG_WORKERS)
+	{
+		analyzer->slotcount = analyzer->cpucount * 2;
+		if (analyzer->slotcount > FFTW_ULTIBO_MAX_SLOTS)
+			analyzer->slotcount = FFTW_ULTIBO_MAX_SLOTS;
+	}
+
+	analyzer->ring = fftwf_malloc(sizeof(float) * analyzer->config.ringsize);
+	analyzer->window = fftwf_malloc(sizeof(float) * analyzer->config.size);
+	if (!analyzer->ring || !analyzer->window)
+		goto failed;
+
+	for (index = 0; index < analyzer->slotcount; index++)
+	{
+		slot = &analyzer->slots[index];
+		slot->analyzer = analyzer;
+		slot->index = index;
+		slot->input = fftwf_malloc(sizeof(float) * analyzer->config.size);
+		slot->output = fftwf_malloc(sizeof(fftwf_complex) * analyzer->bins);
+		slot->spectrum = fftwf_malloc(sizeof(float) * analyzer->bins);
+		if (!slot->input || !slot->output || !slot->spectrum)
+			goto failed;
+	}
+
+	fftw_ultibo_window_create(analyzer->window, analyzer->config.size, analyzer->config.window);
+
+	/* Scale so a sine of amplitude A gives A * A / 2 at its bin regardless of the window */
+	sum = 0;
+	for (index = 0; index < analyzer->config.size; index++)
+		sum += analyzer->window[index];
+	analyzer->scale = 2.0 / (sum * sum);
+
+	analyzer->lock = mutex_create();
+	if (analyzer->lock == INVALID_HANDLE_VALUE)
+		goto failed;
+
+	/* Obtain the plan */
+	start = clock_microseconds();
+	if (fftw_ultibo_planner_acquire() != ERROR_SUCCESS)
+		goto failed;
+	analyzer->plan = fftw_ultibo_plan_acquire(analyzer->config.size, analyzer->config.planning, (analyzer->config.flags & FFTW_ULTIBO_FLAG_NO_MEASURE) != 0);
+	fftw_ultibo_planner_release();
+	if (!analyzer->plan)
+		goto failed;
+
+	analyzer->statistics.plantime = clock_microseconds() - start;
+	analyzer->statistics.wisdom = analyzer->plan->wisdom;
+
+	if (analyzer->config.flags & FFTW_ULTIBO_FLAG_WORKERS)
+	{
+		if (worker_pool_start(0) != ERROR_SUCCESS)
+			goto failed;
+
+		analyzer->slotmask = (1 << analyzer->slotcount) - 1;
+		analyzer->slotsfree = semaphore_create(analyzer->slotcount);
+		if (analyzer->slotsfree == INVALID_HANDLE_VALUE)
+			goto failed;
+	}
+
+	analyzer->signature = FFTW_ULTIBO_SIGNATURE;
+
+	if (analyzer->config.flags & FFTW_ULTIBO_FLAG_THREAD)
+	{
+		/* The producer may signal from an interrupt handler */
+		analyzer->signal = semaphore_create_ex(0, 1, SEMAPHORE_FLAG_IRQ);
+		analyzer->finished = semaphore_create(0);
+		if (analyzer->signal == INVALID_HANDLE_VALUE || analyzer->finished == INVALID_HANDLE_VALUE)
+			goto failed;
+
+		analyzer->running = TRUE;
+
+		analyzer->thread = thread_create(fftw_ultibo_execute, FFTW_ULTIBO_THREAD_STACK_SIZE, FFTW_ULTIBO_THREAD_PRIORITY, FFTW_ULTIBO_THREAD_NAME, analyzer);
+		if (analyzer->thread == INVALID_HANDLE_VALUE)
+			goto failed;
+	}
+
+	return analyzer;
+
+failed:
+	fftw_ultibo_analyzer_free(analyzer);
+
+	return NULL;
+}
+
+uint32_t STDCALL fftw_ultibo_analyzer_destroy(FFTW_ULTIBO_ANALYZER *analyzer)
+{
+	if (!fftw_ultibo_check(analyzer))
+		return ERROR_INVALID_PARAMETER;
+
+	if (analyzer->thread != INVALID_HANDLE_VALUE)
+	{
+		analyzer->running = FALSE;
+
+		semaphore_signal(analyzer->signal);
+		semaphore_wait(analyzer->finished);
+
+		analyzer->thread = INVALID_HANDLE_VALUE;
+	}
+
+	/* Frames still on the worker pools use the slots */
+	while (__atomic_load_n(&analyzer->completed, __ATOMIC_ACQUIRE) != __atomic_load_n(&analyzer->dispatched, __ATOMIC_ACQUIRE))
+		thread_sleep(FFTW_ULTIBO_WAIT_INTERVAL);
+
+	fftw_ultibo_analyzer_free(analyzer);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL fftw_ultibo_analyzer_write(FFTW_ULTIBO_ANALYZER *analyzer, const float *samples, uint32_t count)
+{
+	uint32_t offset;
+	uint32_t first;
+
+	if (!fftw_ultibo_check(analyzer) || !samples)
+		return 0;
+
+	count = fftw_ultibo_ring_space(analyzer, count);
+	if (count == 0)
+		return 0;
+
+	offset = analyzer->head & analyzer->ringmask;
+	first = analyzer->ringmask + 1 - offset;
+	if (first > count)
+		first = count;
+
+	memcpy(analyzer->ring + offset, samples, first * sizeof(float));
+	if (count > first)
+		memcpy(analyzer->ring, samples + first, (count - first) * sizeof(float));
+
+	fftw_ultibo_ring_commit(analyzer, count);
+
+	return count;
+}
+
+uint32_t STDCALL fftw_ultibo_analyzer_write_s16(FFTW_ULTIBO_ANALYZER *analyzer, const int16_t *samples, uint32_t count, uint32_t stride)
+{
+	uint32_t offset;
+	uint32_t index;
+	float *ring;
+
+	if (!fftw_ultibo_check(analyzer) || !samples)
+		return 0;
+
+	if (stride == 0)
+		stride = 1;
+
+	count = fftw_ultibo_ring_space(analyzer, count);
+
+	ring = analyzer->ring;
+	offset = analyzer->head;
+	for (index = 0; index < count; index++, samples += stride)
+		ring[(offset + index) & analyzer->ringmask] = *samples * (1.0f / 32768.0f);
+
+	fftw_ultibo_ring_commit(analyzer, count);
+
+	return count;
+}
+
+uint32_t STDCALL fftw_ultibo_analyzer_write_u16(FFTW_ULTIBO_ANALYZER *analyzer, const uint16_t *samples, uint32_t count, uint32_t bits)
+{
+	uint32_t offset;
+	uint32_t index;
+	float center;
+	float scale;
+	float *ring;
+
+	if (!fftw_ultibo_check(analyzer) || !samples || bits == 0 || bits > 16)
+		return 0;
+
+	/* Midscale of the converter is zero */
+	center = (float)(1 << (bits - 1));
+	scale = 1.0f / center;
+
+	count = fftw_ultibo_ring_space(analyzer, count);
+
+	ring = analyzer->ring;
+	offset = analyzer->head;
+	for (index = 0; index < count; index++)
+		ring[(offset + index) & analyzer->ringmask] = ((float)samples[index] - center) * scale;
+
+	fftw_ultibo_ring_commit(analyzer, count);
+
+	return count;
+}
+
+uint32_t STDCALL fftw_ultibo_analyzer_process(FFTW_ULTIBO_ANALYZER *analyzer, uint32_t *count)
+{
+	uint32_t frames;
+
+	if (!fftw_ultibo_check(analyzer))
+		return ERROR_INVALID_PARAMETER;
+
+	if (analyzer->thread != INVALID_HANDLE_VALUE)
+		return ERROR_NOT_SUPPORTED;
+
+	if (mutex_lock(analyzer->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	frames = fftw_ultibo_frames_process(analyzer);
+
+	mutex_unlock(analyzer->lock);
+
+	if (count)
+		*count = frames;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL fftw_ultibo_analyzer_wait(FFTW_ULTIBO_ANALYZER *analyzer, uint32_t timeout)
+{
+	int64_t start;
+
+	if (!fftw_ultibo_check(analyzer))
+		return ERROR_INVALID_PARAMETER;
+
+	/* Dispatched is counted before the tail moves so a frame is never missed between the two checks */
+	start = clock_milliseconds();
+	while (__atomic_load_n(&analyzer->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&analyzer->tail, __ATOMIC_ACQUIRE) >= analyzer->need
+	 || __atomic_load_n(&analyzer->completed, __ATOMIC_ACQUIRE) != __atomic_load_n(&analyzer->dispatched, __ATOMIC_ACQUIRE))
+	{
+		if (timeout != INFINITE && clock_milliseconds() - start >= timeout)
+			return ERROR_WAIT_TIMEOUT;
+
+		thread_sleep(FFTW_ULTIBO_WAIT_INTERVAL);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL fftw_ultibo_analyzer_get_config(FFTW_ULTIBO_ANALYZER *analyzer, FFTW_ULTIBO_CONFIG *config)
+{
+	if (!fftw_ultibo_check(analyzer) || !config)
+		return ERROR_INVALID_PARAMETER;
+
+	*config = analyzer->config;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL fftw_ultibo_analyzer_get_statistics(FFTW_ULTIBO_ANALYZER *analyzer, FFTW_ULTIBO_STATISTICS *statistics)
+{
+	if (!fftw_ultibo_check(analyzer) || !statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	*statistics = analyzer->statistics;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL fftw_ultibo_analyzer_reset_statistics(FFTW_ULTIBO_ANALYZER *analyzer)
+{
+	if (!fftw_ultibo_check(analyzer))
+		return ERROR_INVALID_PARAMETER;
+
+	/* The plan time and wisdom describe the creation of the analyzer and are kept */
+	analyzer->statistics.samplecount = 0;
+	analyzer->statistics.overflowcount = 0;
+	analyzer->statistics.framecount = 0;
+	analyzer->statistics.waitcount = 0;
+	analyzer->statistics.executetime = 0;
+	analyzer->statistics.executemax = 0;
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* FFTW Helper Functions */
+float STDCALL fftw_ultibo_bin_to_frequency(FFTW_ULTIBO_ANALYZER *analyzer, uint32_t bin)
+{
+	if (!fftw_ultibo_check(analyzer))
+		return 0.0f;
+
+	return ((float)bin * analyzer->config.samplerate) / analyzer->config.size;
+}
+
+uint32_t STDCALL fftw_ultibo_window_to_string(uint32_t window, char *string, uint32_t len)
+{
+	const char *name;
+
+	if (!string || len == 0)
+		return 0;
+
+	switch (window)
+	{
+		case FFTW_ULTIBO_WINDOW_HANN:
+			name = "FFTW_ULTIBO_WINDOW_HANN";
+			break;
+		case FFTW_ULTIBO_WINDOW_HAMMING:
+			name = "FFTW_ULTIBO_WINDOW_HAMMING";
+			break;
+		case FFTW_ULTIBO_WINDOW_BLACKMAN:
+			name = "FFTW_ULTIBO_WINDOW_BLACKMAN";
+			break;
+		case FFTW_ULTIBO_WINDOW_BLACKMAN_HARRIS:
+			name = "FFTW_ULTIBO_WINDOW_BLACKMAN_HARRIS";
+			break;
+		case FFTW_ULTIBO_WINDOW_RECTANGULAR:
+			name = "FFTW_ULTIBO_WINDOW_RECTANGULAR";
+			break;
+		default:
+			name = "FFTW_ULTIBO_WINDOW_UNKNOWN";
+			break;
+	}
+
+	strncpy(string, name, len - 1);
+	string[len - 1] = '\0';
+
+	return strlen(string);
+}
@@ -0,0 +1,145 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _FFTW_PORT_ULTIBO_H
+#define _FFTW_PORT_ULTIBO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+
+#include "fftw3.h"
+
+/* fftw_port_ultibo.c uses the per CPU worker pools, add workerpool.o to the OBJS = line of the project
+   Makefile and $(API_PATH)/src/threads to VPATH as well as fftw_port_ultibo.o (See the FFT Analysis Makefile) */
+
+/* ============================================================================== */
+/* FFTW Analyzer specific constants */
+#define FFTW_ULTIBO_THREAD_NAME	"FFTW Analyzer" // Thread name for FFTW analyzer threads
+#define FFTW_ULTIBO_THREAD_PRIORITY	THREAD_PRIORITY_HIGHER // Thread priority for FFTW analyzer threads
+#define FFTW_ULTIBO_THREAD_STACK_SIZE	SIZE_16K // Stack size of FFTW analyzer threads
+
+#define FFTW_ULTIBO_MIN_SIZE	16 // Smallest FFT size (Samples)
+#define FFTW_ULTIBO_MAX_SIZE	SIZE_64K // Largest FFT size (Samples)
+#define FFTW_ULTIBO_DEFAULT_SIZE	1024 // Default FFT size (Samples)
+#define FFTW_ULTIBO_MAX_RING_SIZE	SIZE_16M // Largest sample ring (Samples)
+#define FFTW_ULTIBO_MAX_SLOTS	8 // Maximum number of frames being transformed at once with FFTW_ULTIBO_FLAG_WORKERS
+#define FFTW_ULTIBO_WAIT_INTERVAL	1 // Interval between checks while waiting for frames to complete (Milliseconds)
+
+/* FFTW Analyzer Windows */
+#define FFTW_ULTIBO_WINDOW_HANN	0 // Hann window (Default)
+#define FFTW_ULTIBO_WINDOW_HAMMING	1 // Hamming window
+#define FFTW_ULTIBO_WINDOW_BLACKMAN	2 // Blackman window
+#define FFTW_ULTIBO_WINDOW_BLACKMAN_HARRIS	3 // 4 term Blackman-Harris window (Lowest leakage)
+#define FFTW_ULTIBO_WINDOW_RECTANGULAR	4 // No window
+
+#define FFTW_ULTIBO_WINDOW_MAX	4
+
+/* FFTW Analyzer Planning */
+#define FFTW_ULTIBO_PLAN_MEASURE	0 // Plan with FFTW_MEASURE (Default, seconds for large sizes without wisdom)
+#define FFTW_ULTIBO_PLAN_ESTIMATE	1 // Plan with FFTW_ESTIMATE (Fast planning, slower transforms)
+#define FFTW_ULTIBO_PLAN_PATIENT	2 // Plan with FFTW_PATIENT (Slow planning, only worthwhile when saved as wisdom)
+
+/* FFTW Analyzer Flags */
+#define FFTW_ULTIBO_FLAG_NONE	0x00000000
+#define FFTW_ULTIBO_FLAG_THREAD	0x00000001 // Frames are processed by a dedicated thread as samples arrive (Otherwise by calling fftw_ultibo_analyzer_process)
+#define FFTW_ULTIBO_FLAG_WORKERS	0x00000002 // Frames are transformed in parallel on the per CPU worker pools (Spectrum callbacks may arrive out of order)
+#define FFTW_ULTIBO_FLAG_DECIBEL	0x00000004 // Spectrum is returned in decibels instead of power
+#define FFTW_ULTIBO_FLAG_NO_MEASURE	0x00000008 // If no wisdom is available plan with FFTW_ESTIMATE instead of measuring (Bounded startup time)
+
+/* ============================================================================== */
+/* FFTW Analyzer specific types */
+
+/* FFTW Analyzer (Opaque) */
+typedef struct _FFTW_ULTIBO_ANALYZER FFTW_ULTIBO_ANALYZER;
+
+/* FFTW Analyzer Spectrum Callback (Bins = size / 2 + 1, power of a sine with amplitude A is A * A / 2 at its bin) */
+typedef void STDCALL (*fftw_ultibo_spectrum_cb)(FFTW_ULTIBO_ANALYZER *analyzer, const float *spectrum, uint32_t bins, uint64_t frame, void *data);
+
+/* FFTW Analyzer Configuration (Zero for any value selects the default) */
+typedef struct _FFTW_ULTIBO_CONFIG FFTW_ULTIBO_CONFIG;
+struct _FFTW_ULTIBO_CONFIG
+{
+	uint32_t size; // FFT size (Samples, FFTW_ULTIBO_MIN_SIZE to FFTW_ULTIBO_MAX_SIZE, powers of 2 are fastest)
+	uint32_t hop; // Samples between the start of each frame (Default size / 2 for 50% overlap)
+	uint32_t window; // Window applied to each frame (eg FFTW_ULTIBO_WINDOW_HANN)
+	uint32_t planning; // Planner rigor (eg FFTW_ULTIBO_PLAN_MEASURE)
+	uint32_t flags; // FFTW analyzer flags (eg FFTW_ULTIBO_FLAG_THREAD)
+	uint32_t ringsize; // Size of the sample ring (Samples, rounded up to a power of 2, default 4 frames)
+	uint32_t samplerate; // Sample rate for fftw_ultibo_bin_to_frequency (Hz)
+};
+
+/* FFTW Analyzer Statistics */
+typedef struct _FFTW_ULTIBO_STATISTICS FFTW_ULTIBO_STATISTICS;
+struct _FFTW_ULTIBO_STATISTICS
+{
+	uint64_t samplecount; // Number of samples accepted into the ring
+	uint64_t overflowcount; // Number of samples dropped because the ring was full
+	uint64_t framecount; // Number of frames transformed
+	uint32_t waitcount; // Number of times a frame waited for a free slot (Only with FFTW_ULTIBO_FLAG_WORKERS)
+	uint64_t executetime; // Total time spent in window, transform and spectrum (Microseconds)
+	uint32_t executemax; // Longest time for a single frame (Microseconds)
+	uint32_t plantime; // Time taken to obtain the plan when the analyzer was created (Microseconds)
+	BOOL wisdom; // The plan was created from wisdom without measuring
+};
+
+/* ============================================================================== */
+/* FFTW Wisdom Functions */
+uint32_t STDCALL fftw_ultibo_wisdom_load(const char *filename); // Import wisdom saved by fftw_ultibo_wisdom_save (Adds to any wisdom already held)
+uint32_t STDCALL fftw_ultibo_wisdom_save(const char *filename); // Export all wisdom accumulated by the planner
+uint32_t STDCALL fftw_ultibo_wisdom_forget(void);
+
+/* ============================================================================== */
+/* FFTW Analyzer Functions */
+FFTW_ULTIBO_ANALYZER * STDCALL fftw_ultibo_analyzer_create(FFTW_ULTIBO_CONFIG *config, fftw_ultibo_spectrum_cb callback, void *data); // Config may be NULL for the defaults
+uint32_t STDCALL fftw_ultibo_analyzer_destroy(FFTW_ULTIBO_ANALYZER *analyzer);
+
+uint32_t STDCALL fftw_ultibo_analyzer_write(FFTW_ULTIBO_ANALYZER *analyzer, const float *samples, uint32_t count); // Returns the number of samples accepted, safe from one producer at a time including interrupt handlers
+uint32_t STDCALL fftw_ultibo_analyzer_write_s16(FFTW_ULTIBO_ANALYZER *analyzer, const int16_t *samples, uint32_t count, uint32_t stride); // Signed 16 bit PCM scaled to +/-1.0, stride is the number of interleaved channels (0 or 1 for mono)
+uint32_t STDCALL fftw_ultibo_analyzer_write_u16(FFTW_ULTIBO_ANALYZER *analyzer, const uint16_t *samples, uint32_t count, uint32_t bits); // Unsigned ADC readings of bits resolution scaled to +/-1.0
+
+uint32_t STDCALL fftw_ultibo_analyzer_process(FFTW_ULTIBO_ANALYZER *analyzer, uint32_t *count); // Transform all complete frames in the ring, count returns the number of frames (Not with FFTW_ULTIBO_FLAG_THREAD)
+uint32_t STDCALL fftw_ultibo_analyzer_wait(FFTW_ULTIBO_ANALYZER *analyzer, uint32_t timeout); // Wait until every complete frame written so far has been delivered (Timeout = 0 then No Wait,Timeout = INFINITE then Wait forever)
+
+uint32_t STDCALL fftw_ultibo_analyzer_get_config(FFTW_ULTIBO_ANALYZER *analyzer, FFTW_ULTIBO_CONFIG *config);
+uint32_t STDCALL fftw_ultibo_analyzer_get_statistics(FFTW_ULTIBO_ANALYZER *analyzer, FFTW_ULTIBO_STATISTICS *statistics);
+uint32_t STDCALL fftw_ultibo_analyzer_reset_statistics(FFTW_ULTIBO_ANALYZER *analyzer);
+
+/* ============================================================================== */
+/* FFTW Helper Functions */
+float STDCALL fftw_ultibo_bin_to_frequency(FFTW_ULTIBO_ANALYZER *analyzer, uint32_t bin);
+
+uint32_t STDCALL fftw_ultibo_window_to_string(uint32_t window, char *string, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _FFTW_PORT_ULTIBO_H
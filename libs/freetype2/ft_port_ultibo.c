@@ -0,0 +1,789 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/font.h"
+#include "ultibo/graphicsconsole.h"
+
+#include "ft_port_ultibo.h"
+
+/*
+ * Implementation of the Ultibo font port for FreeType
+ *
+ * Each cache holds a FreeType library instance and an atlas of glyphs rendered as
+ * 8 bit antialiased alpha masks, keyed by (Font, Glyph index) where a font is a
+ * FreeType face at one pixel size. Glyphs are found by hash and kept in least
+ * recently used order, the oldest glyphs are discarded when the memory used by
+ * the atlas would exceed the budget of the cache
+ *
+ * Text is drawn by blending the cached masks into a 32 bit image, a font can also
+ * be converted to a standard pixel font (ft_ultibo_font_create_handle) which can be
+ * selected with console_window_set_font or graphics_window_set_font and drawn by the
+ * normal console functions at bitmap font speed
+ *
+ * FreeType faces are not thread safe so all FreeType calls are made holding the
+ * cache lock
+ */
+
+/* FreeType Glyph (An entry in the atlas) */
+typedef struct _FT_ULTIBO_GLYPH FT_ULTIBO_GLYPH;
+struct _FT_ULTIBO_GLYPH
+{
+	FT_ULTIBO_FONT *font; // The font this glyph was rendered from
+	uint32_t index; // FreeType glyph index
+	int32_t left; // Horizontal offset from the pen position to the mask
+	int32_t top; // Vertical offset from the baseline to the top of the mask (Positive is up)
+	uint32_t width; // Mask width in pixels
+	uint32_t height; // Mask height in pixels
+	uint32_t advance; // Horizontal advance in pixels
+	uint32_t size; // Memory accounted to this glyph (Bytes)
+	FT_ULTIBO_GLYPH *hashnext; // Next glyph in the hash bucket
+	FT_ULTIBO_GLYPH *prev; // Previous (more recently used) glyph
+	FT_ULTIBO_GLYPH *next; // Next (less recently used) glyph
+	uint8_t mask[]; // Alpha mask (width * height)
+};
+
+/* FreeType Cache */
+struct _FT_ULTIBO_CACHE
+{
+	FT_Library library; // FreeType library instance
+	MUTEX_HANDLE lock; // Cache lock (Also serializes all FreeType calls)
+	FT_ULTIBO_FONT *fonts; // Fonts loaded in this cache
+	FT_ULTIBO_GLYPH *first; // Most recently used glyph
+	FT_ULTIBO_GLYPH *last; // Least recently used glyph
+	FT_ULTIBO_GLYPH *buckets[FT_ULTIBO_HASH_SIZE];
+	FT_ULTIBO_STATISTICS statistics;
+};
+
+/* FreeType Font */
+struct _FT_ULTIBO_FONT
+{
+	FT_ULTIBO_CACHE *cache; // The cache this font belongs to
+	FT_Face face; // FreeType face set to the pixel size
+	void *data; // Copy of the font file data (Only if loaded from memory)
+	uint32_t size; // Pixel size
+	int32_t ascender; // Distance from the top of a line to the baseline in pixels
+	uint32_t height; // Line height in pixels
+	FT_ULTIBO_FONT *next; // Next font in the cache
+};
+
+/* ============================================================================== */
+/* FreeType Port Internal Functions */
+static uint32_t ft_ultibo_hash(FT_ULTIBO_FONT *font, uint32_t index)
+{
+	return (((uint32_t)(size_t)font >> 4) ^ (index * 2654435761U)) & (FT_ULTIBO_HASH_SIZE - 1);
+}
+
+/* Decode the next UTF-8 character, invalid sequences return the replacement character */
+static uint32_t ft_ultibo_next_char(const char **text)
+{
+	const uint8_t *next = (const uint8_t *)*text;
+	uint32_t value;
+	uint32_t count;
+
+	value = *next++;
+	if (value < 0x80)
+		count = 0;
+	else if ((value & 0xE0) == 0xC0)
+	{
+		value &= 0x1F;
+		count = 1;
+	}
+	else if ((value & 0xF0) == 0xE0)
+	{
+		value &= 0x0F;
+		count = 2;
+	}
+	else if ((value & 0xF8) == 0xF0)
+	{
+		value &= 0x07;
+		count = 3;
+	}
+	else
+	{
+		*text = (const char *)next;
+		return 0xFFFD;
+	}
+
+	while (count > 0)
+	{
+		if ((*next & 0xC0) != 0x80)
+		{
+			*text = (const char *)next;
+			return 0xFFFD;
+		}
+
+		value = (value << 6) | (*next++ & 0x3F);
+		count--;
+	}
+
+	*text = (const char *)next;
+	return value;
+}
+
+static void ft_ultibo_glyph_unlink(FT_ULTIBO_CACHE *cache, FT_ULTIBO_GLYPH *glyph)
+{
+	if (glyph->prev)
+		glyph->prev->next = glyph->next;
+	else
+		cache->first = glyph->next;
+
+	if (glyph->next)
+		glyph->next->prev = glyph->prev;
+	else
+		cache->last = glyph->prev;
+
+	glyph->prev = NULL;
+	glyph->next = NULL;
+}
+
+static void ft_ultibo_glyph_link_first(FT_ULTIBO_CACHE *cache, FT_ULTIBO_GLYPH *glyph)
+{
+	glyph->prev = NULL;
+	glyph->next = cache->first;
+	if (cache->first)
+		cache->first->prev = glyph;
+	else
+		cache->last = glyph;
+
+	cache->first = glyph;
+}
+
+static void ft_ultibo_glyph_free(FT_ULTIBO_CACHE *cache, FT_ULTIBO_GLYPH *glyph)
+{
+	FT_ULTIBO_GLYPH **link;
+
+	/* Remove from the hash bucket */
+	link = &cache->buckets[ft_ultibo_hash(glyph->font, glyph->index)];
+	while (*link && *link != glyph)
+		link = &(*link)->hashnext;
+
+	if (*link)
+		*link = glyph->hashnext;
+
+	ft_ultibo_glyph_unlink(cache, glyph);
+
+	cache->statistics.entrycount--;
+	cache->statistics.memoryused -= glyph->size;
+
+	free(glyph);
+}
+
+/* Find a glyph in the atlas or render it with FreeType, caller must hold the cache lock */
+static FT_ULTIBO_GLYPH *ft_ultibo_glyph_get(FT_ULTIBO_FONT *font, uint32_t index)
+{
+	FT_ULTIBO_CACHE *cache = font->cache;
+	FT_ULTIBO_GLYPH *glyph;
+	FT_GlyphSlot slot;
+	FT_Bitmap *bitmap;
+	uint8_t *source;
+	uint32_t bucket;
+	uint32_t size;
+	uint32_t row;
+	uint32_t col;
+
+	bucket = ft_ultibo_hash(font, index);
+	for (glyph = cache->buckets[bucket]; glyph; glyph = glyph->hashnext)
+	{
+		if (glyph->font == font && glyph->index == index)
+		{
+			/* Move to the front of the least recently used list */
+			if (glyph != cache->first)
+			{
+				ft_ultibo_glyph_unlink(cache, glyph);
+				ft_ultibo_glyph_link_first(cache, glyph);
+			}
+
+			cache->statistics.hitcount++;
+
+			return glyph;
+		}
+	}
+
+	cache->statistics.misscount++;
+
+	/* Render the glyph */
+	if (FT_Load_Glyph(font->face, index, FT_LOAD_RENDER) != 0)
+	{
+		cache->statistics.errorcount++;
+		return NULL;
+	}
+
+	slot = font->face->glyph;
+	bitmap = &slot->bitmap;
+	if (bitmap->pixel_mode != FT_PIXEL_MODE_GRAY && bitmap->pixel_mode != FT_PIXEL_MODE_MONO && bitmap->rows > 0)
+	{
+		cache->statistics.errorcount++;
+		return NULL;
+	}
+
+	size = sizeof(FT_ULTIBO_GLYPH) + (bitmap->width * bitmap->rows);
+
+	/* Discard the least recently used glyphs to stay within the budget */
+	while (cache->last && cache->statistics.memoryused + size > cache->statistics.memorybudget)
+	{
+		ft_ultibo_glyph_free(cache, cache->last);
+		cache->statistics.evictcount++;
+	}
+
+	glyph = malloc(size);
+	if (!glyph)
+		return NULL;
+
+	glyph->font = font;
+	glyph->index = index;
+	glyph->left = slot->bitmap_left;
+	glyph->top = slot->bitmap_top;
+	glyph->width = bitmap->width;
+	glyph->height = bitmap->rows;
+	glyph->advance = slot->advance.x >> 6;
+	glyph->size = size;
+
+	/* Copy the bitmap as an 8 bit alpha mask */
+	for (row = 0; row < glyph->height; row++)
+	{
+		source = bitmap->buffer + (row * abs(bitmap->pitch));
+		if (bitmap->pitch < 0)
+			source = bitmap->buffer + ((glyph->height - 1 - row) * -bitmap->pitch);
+
+		if (bitmap->pixel_mode == FT_PIXEL_MODE_GRAY)
+		{
+			memcpy(glyph->mask + (row * glyph->width), source, glyph->width);
+		}
+		else
+		{
+			for (col = 0; col < glyph->width; col++)
+				glyph->mask[(row * glyph->width) + col] = (source[col >> 3] & (0x80 >> (col & 7))) ? 0xFF : 0x00;
+		}
+	}
+
+	glyph->hashnext = cache->buckets[bucket];
+	cache->buckets[bucket] = glyph;
+	ft_ultibo_glyph_link_first(cache, glyph);
+
+	cache->statistics.entrycount++;
+	cache->statistics.memoryused += size;
+
+	return glyph;
+}
+
+static FT_ULTIBO_FONT *ft_ultibo_font_setup(FT_ULTIBO_CACHE *cache, FT_Face face, uint32_t size)
+{
+	FT_ULTIBO_FONT *font;
+
+	if (FT_Set_Pixel_Sizes(face, 0, size) != 0)
+		return NULL;
+
+	font = calloc(1, sizeof(FT_ULTIBO_FONT));
+	if (!font)
+		return NULL;
+
+	font->cache = cache;
+	font->face = face;
+	font->size = size;
+	font->ascender = face->size->metrics.ascender >> 6;
+	font->height = face->size->metrics.height >> 6;
+	if (font->height == 0)
+		font->height = size;
+
+	font->next = cache->fonts;
+	cache->fonts = font;
+	cache->statistics.fontcount++;
+
+	return font;
+}
+
+/* ============================================================================== */
+/* FreeType Cache Functions */
+FT_ULTIBO_CACHE * STDCALL ft_ultibo_cache_create(uint32_t budget)
+{
+	FT_ULTIBO_CACHE *cache;
+
+	cache = calloc(1, sizeof(FT_ULTIBO_CACHE));
+	if (!cache)
+		return NULL;
+
+	if (FT_Init_FreeType(&cache->library) != 0)
+	{
+		free(cache);
+		return NULL;
+	}
+
+	cache->lock = mutex_create();
+	if (cache->lock == INVALID_HANDLE_VALUE)
+	{
+		FT_Done_FreeType(cache->library);
+		free(cache);
+		return NULL;
+	}
+
+	cache->statistics.memorybudget = budget ? budget : FT_ULTIBO_DEFAULT_BUDGET;
+
+	return cache;
+}
+
+uint32_t STDCALL ft_ultibo_cache_destroy(FT_ULTIBO_CACHE *cache)
+{
+	if (!cache)
+		return ERROR_INVALID_PARAMETER;
+
+	/* Unload all fonts (Also discards their glyphs) */
+	while (cache->fonts)
+		ft_ultibo_font_unload(cache->fonts);
+
+	FT_Done_FreeType(cache->library);
+	mutex_destroy(cache->lock);
+	free(cache);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL ft_ultibo_cache_flush(FT_ULTIBO_CACHE *cache)
+{
+	if (!cache)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	while (cache->last)
+		ft_ultibo_glyph_free(cache, cache->last);
+
+	mutex_unlock(cache->lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL ft_ultibo_cache_get_statistics(FT_ULTIBO_CACHE *cache, FT_ULTIBO_STATISTICS *statistics)
+{
+	if (!cache || !statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	memcpy(statistics, &cache->statistics, sizeof(FT_ULTIBO_STATISTICS));
+
+	mutex_unlock(cache->lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL ft_ultibo_cache_reset_statistics(FT_ULTIBO_CACHE *cache)
+{
+	if (!cache)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	/* Reset the counters only, the current state is kept */
+	cache->statistics.hitcount = 0;
+	cache->statistics.misscount = 0;
+	cache->statistics.evictcount = 0;
+	cache->statistics.errorcount = 0;
+
+	mutex_unlock(cache->lock);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* FreeType Font Functions */
+FT_ULTIBO_FONT * STDCALL ft_ultibo_font_load(FT_ULTIBO_CACHE *cache, const char *filename, uint32_t size)
+{
+	FT_ULTIBO_FONT *font;
+	FT_Face face;
+
+	if (!cache || !filename || size == 0)
+		return NULL;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return NULL;
+
+	font = NULL;
+	if (FT_New_Face(cache->library, filename, 0, &face) == 0)
+	{
+		font = ft_ultibo_font_setup(cache, face, size);
+		if (!font)
+			FT_Done_Face(face);
+	}
+
+	mutex_unlock(cache->lock);
+
+	return font;
+}
+
+FT_ULTIBO_FONT * STDCALL ft_ultibo_font_load_ex(FT_ULTIBO_CACHE *cache, const void *data, uint32_t len, uint32_t size)
+{
+	FT_ULTIBO_FONT *font;
+	FT_Face face;
+	void *copy;
+
+	if (!cache || !data || len == 0 || size == 0)
+		return NULL;
+
+	/* FreeType reads the data on demand so keep a copy for the life of the font */
+	copy = malloc(len);
+	if (!copy)
+		return NULL;
+
+	memcpy(copy, data, len);
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+	{
+		free(copy);
+		return NULL;
+	}
+
+	font = NULL;
+	if (FT_New_Memory_Face(cache->library, copy, len, 0, &face) == 0)
+	{
+		font = ft_ultibo_font_setup(cache, face, size);
+		if (font)
+			font->data = copy;
+		else
+			FT_Done_Face(face);
+	}
+
+	mutex_unlock(cache->lock);
+
+	if (!font)
+		free(copy);
+
+	return font;
+}
+
+uint32_t STDCALL ft_ultibo_font_unload(FT_ULTIBO_FONT *font)
+{
+	FT_ULTIBO_CACHE *cache;
+	FT_ULTIBO_FONT **link;
+	FT_ULTIBO_GLYPH *glyph;
+	FT_ULTIBO_GLYPH *next;
+
+	if (!font || !font->cache)
+		return ERROR_INVALID_PARAMETER;
+
+	cache = font->cache;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	/* Discard the glyphs of this font */
+	for (glyph = cache->first; glyph; glyph = next)
+	{
+		next = glyph->next;
+		if (glyph->font == font)
+			ft_ultibo_glyph_free(cache, glyph);
+	}
+
+	/* Remove from the font list */
+	link = &cache->fonts;
+	while (*link && *link != font)
+		link = &(*link)->next;
+
+	if (*link)
+		*link = font->next;
+
+	cache->statistics.fontcount--;
+
+	FT_Done_Face(font->face);
+
+	mutex_unlock(cache->lock);
+
+	free(font->data);
+	free(font);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL ft_ultibo_font_get_height(FT_ULTIBO_FONT *font)
+{
+	if (!font)
+		return 0;
+
+	return font->height;
+}
+
+uint32_t STDCALL ft_ultibo_font_text_width(FT_ULTIBO_FONT *font, const char *text)
+{
+	FT_ULTIBO_GLYPH *glyph;
+	uint32_t width;
+
+	if (!font || !text)
+		return 0;
+
+	if (mutex_lock(font->cache->lock) != ERROR_SUCCESS)
+		return 0;
+
+	width = 0;
+	while (*text)
+	{
+		glyph = ft_ultibo_glyph_get(font, FT_Get_Char_Index(font->face, ft_ultibo_next_char(&text)));
+		if (glyph)
+			width += glyph->advance;
+	}
+
+	mutex_unlock(font->cache->lock);
+
+	return width;
+}
+
+uint32_t STDCALL ft_ultibo_font_draw_text(FT_ULTIBO_FONT *font, const char *text, int32_t x, int32_t y, uint32_t color, void *buffer, uint32_t width, uint32_t height, uint32_t format)
+{
+	FT_ULTIBO_GLYPH *glyph;
+	uint8_t *dest;
+	uint8_t *mask;
+	uint32_t source[4];
+	uint32_t alpha;
+	uint32_t value;
+	int32_t left;
+	int32_t top;
+	int32_t row;
+	int32_t col;
+	int32_t channel;
+
+	if (!font || !text || !buffer)
+		return ERROR_INVALID_PARAMETER;
+
+	/* Get the color bytes in the order of the buffer format (Little endian) */
+	switch (format)
+	{
+		case COLOR_FORMAT_ARGB32:
+		case COLOR_FORMAT_URGB32:
+			value = color;
+			break;
+		case COLOR_FORMAT_ABGR32:
+		case COLOR_FORMAT_UBGR32:
+			value = (color & 0xFF00FF00) | ((color >> 16) & 0xFF) | ((color & 0xFF) << 16);
+			break;
+		default:
+			return ERROR_NOT_SUPPORTED;
+	}
+	for (channel = 0; channel < 4; channel++)
+		source[channel] = (value >> (channel * 8)) & 0xFF;
+
+	if (mutex_lock(font->cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	/* Y is the top of the line, the pen is on the baseline */
+	y += font->ascender;
+	while (*text)
+	{
+		glyph = ft_ultibo_glyph_get(font, FT_Get_Char_Index(font->face, ft_ultibo_next_char(&text)));
+		if (!glyph)
+			continue;
+
+		left = x + glyph->left;
+		top = y - glyph->top;
+		for (row = 0; row < (int32_t)glyph->height; row++)
+		{
+			if (top + row < 0 || top + row >= (int32_t)height)
+				continue;
+
+			mask = glyph->mask + (row * glyph->width);
+			for (col = 0; col < (int32_t)glyph->width; col++)
+			{
+				if (left + col < 0 || left + col >= (int32_t)width)
+					continue;
+
+				alpha = mask[col];
+				if (alpha == 0)
+					continue;
+
+				/* Blend each channel, source alpha is the mask scaled by the color alpha */
+				alpha = (alpha * (source[3] + 1)) >> 8;
+				dest = (uint8_t *)buffer + ((((top + row) * width) + left + col) * 4);
+				for (channel = 0; channel < 4; channel++)
+					dest[channel] = ((source[channel] * alpha) + (dest[channel] * (255 - alpha)) + 127) / 255;
+			}
+		}
+
+		x += glyph->advance;
+	}
+
+	mutex_unlock(font->cache->lock);
+
+	return ERROR_SUCCESS;
+}
+
+FONT_HANDLE STDCALL ft_ultibo_font_create_handle(FT_ULTIBO_FONT *font, uint32_t threshold)
+{
+	FT_ULTIBO_GLYPH *glyph;
+	FONT_HEADER header;
+	FONT_HANDLE handle;
+	uint8_t *data;
+	uint32_t charwidth;
+	uint32_t charheight;
+	uint32_t rowbytes;
+	uint32_t value;
+	uint32_t size;
+	uint32_t ch;
+	int32_t row;
+	int32_t col;
+	int32_t px;
+	int32_t py;
+
+	if (!font)
+		return INVALID_HANDLE_VALUE;
+
+	if (threshold == 0)
+		threshold = FT_ULTIBO_DEFAULT_THRESHOLD;
+
+	if (mutex_lock(font->cache->lock) != ERROR_SUCCESS)
+		return INVALID_HANDLE_VALUE;
+
+	/* Use the widest printable character as the cell width */
+	charwidth = 0;
+	for (ch = 0x20; ch < 0x7F; ch++)
+	{
+		glyph = ft_ultibo_glyph_get(font, FT_Get_Char_Index(font->face, ch));
+		if (glyph && glyph->advance > charwidth)
+			charwidth = glyph->advance;
+	}
+
+	charheight = font->height;
+	if (charwidth < FONT_MIN_WIDTH)
+		charwidth = FONT_MIN_WIDTH;
+	if (charwidth > FONT_MAX_WIDTH)
+		charwidth = FONT_MAX_WIDTH;
+	if (charheight < FONT_MIN_HEIGHT)
+		charheight = FONT_MIN_HEIGHT;
+	if (charheight > FONT_MAX_HEIGHT)
+		charheight = FONT_MAX_HEIGHT;
+
+	/* Pixel fonts use 8, 16 or 32 bit rows according to the width */
+	rowbytes = (charwidth <= 8) ? 1 : (charwidth <= 16) ? 2 : 4;
+	size = FONT_MIN_COUNT * charheight * rowbytes;
+
+	data = calloc(1, size);
+	if (!data)
+	{
+		mutex_unlock(font->cache->lock);
+		return INVALID_HANDLE_VALUE;
+	}
+
+	/* Render the first 256 characters (Latin-1) into the cells, the leftmost pixel is the highest bit */
+	for (ch = 0; ch < FONT_MIN_COUNT; ch++)
+	{
+		glyph = ft_ultibo_glyph_get(font, FT_Get_Char_Index(font->face, ch));
+		if (!glyph)
+			continue;
+
+		for (row = 0; row < (int32_t)glyph->height; row++)
+		{
+			py = font->ascender - glyph->top + row;
+			if (py < 0 || py >= (int32_t)charheight)
+				continue;
+
+			value = 0;
+			for (col = 0; col < (int32_t)glyph->width; col++)
+			{
+				px = glyph->left + col;
+				if (px < 0 || px >= (int32_t)charwidth)
+					continue;
+
+				if (glyph->mask[(row * glyph->width) + col] >= threshold)
+					value |= 1U << (charwidth - 1 - px);
+			}
+
+			switch (rowbytes)
+			{
+				case 1:
+					((uint8_t *)data)[(ch * charheight) + py] |= value;
+					break;
+				case 2:
+					((uint16_t *)data)[(ch * charheight) + py] |= value;
+					break;
+				case 4:
+					((uint32_t *)data)[(ch * charheight) + py] |= value;
+					break;
+			}
+		}
+	}
+
+	mutex_unlock(font->cache->lock);
+
+	/* Name and description are length prefixed */
+	memset(&header, 0, sizeof(FONT_HEADER));
+	header.width = charwidth;
+	header.height = charheight;
+	header.count = FONT_MIN_COUNT;
+	header.mode = FONT_MODE_PIXEL;
+	header.flags = FONT_FLAG_RIGHTALIGN;
+	header.codepage = CP_ACP;
+	snprintf(header.name + 1, sizeof(header.name) - 1, "%s %u", font->face->family_name ? font->face->family_name : "FreeType", (unsigned int)font->size);
+	header.name[0] = strlen(header.name + 1);
+	snprintf(header.description + 1, sizeof(header.description) - 1, "%s %s %ux%u", font->face->family_name ? font->face->family_name : "FreeType", font->face->style_name ? font->face->style_name : "", (unsigned int)charwidth, (unsigned int)charheight);
+	header.description[0] = strlen(header.description + 1);
+
+	/* Load the font, the character data is copied */
+	handle = font_load_ex(&header, (FONT_DATA *)data, NULL, size, NULL);
+
+	free(data);
+
+	return handle;
+}
+
+/* ============================================================================== */
+/* FreeType Graphics Console Functions */
+uint32_t STDCALL ft_ultibo_graphics_window_draw_text(WINDOW_HANDLE handle, FT_ULTIBO_FONT *font, const char *text, uint32_t x, uint32_t y, uint32_t forecolor, uint32_t backcolor)
+{
+	uint32_t *image;
+	uint32_t width;
+	uint32_t height;
+	uint32_t status;
+	uint32_t count;
+
+	if (handle == INVALID_HANDLE_VALUE || !font || !text)
+		return ERROR_INVALID_PARAMETER;
+
+	width = ft_ultibo_font_text_width(font, text);
+	height = font->height;
+	if (width == 0)
+		return ERROR_SUCCESS;
+
+	image = malloc(width * height * sizeof(uint32_t));
+	if (!image)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	/* Fill with the background and blend the text over it */
+	for (count = 0; count < width * height; count++)
+		image[count] = backcolor;
+
+	status = ft_ultibo_font_draw_text(font, text, 0, 0, forecolor, image, width, height, COLOR_FORMAT_ARGB32);
+	if (status == ERROR_SUCCESS)
+		status = graphics_window_draw_image(handle, x, y, image, width, height, COLOR_FORMAT_ARGB32);
+
+	free(image);
+
+	return status;
+}
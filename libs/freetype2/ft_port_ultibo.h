@@ -0,0 +1,103 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _FT_PORT_ULTIBO_H
+#define _FT_PORT_ULTIBO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/font.h"
+#include "ultibo/graphicsconsole.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+/* ============================================================================== */
+/* FreeType Port specific constants */
+#define FT_ULTIBO_DEFAULT_BUDGET	SIZE_1M // Default memory budget for the glyph atlas of a FreeType cache (Bytes)
+#define FT_ULTIBO_HASH_SIZE	256 // Number of hash buckets in the glyph atlas (Must be a power of 2)
+#define FT_ULTIBO_DEFAULT_THRESHOLD	128 // Default alpha threshold for pixels set when converting to a bitmap font
+
+/* ============================================================================== */
+/* FreeType Port specific types */
+
+/* FreeType Cache Statistics */
+typedef struct _FT_ULTIBO_STATISTICS FT_ULTIBO_STATISTICS;
+struct _FT_ULTIBO_STATISTICS
+{
+	uint32_t fontcount; // Number of fonts loaded in the cache
+	uint32_t entrycount; // Number of glyphs currently in the atlas
+	uint32_t memorybudget; // Memory budget of the atlas (Bytes)
+	uint32_t memoryused; // Memory currently used by glyphs in the atlas (Bytes)
+	uint32_t hitcount; // Number of glyph lookups found in the atlas
+	uint32_t misscount; // Number of glyph lookups rendered by FreeType
+	uint32_t evictcount; // Number of glyphs discarded to stay within the budget
+	uint32_t errorcount; // Number of glyphs FreeType failed to render
+};
+
+/* FreeType Cache */
+typedef struct _FT_ULTIBO_CACHE FT_ULTIBO_CACHE;
+
+/* FreeType Font (A face at a specific pixel size) */
+typedef struct _FT_ULTIBO_FONT FT_ULTIBO_FONT;
+
+/* ============================================================================== */
+/* FreeType Cache Functions */
+FT_ULTIBO_CACHE * STDCALL ft_ultibo_cache_create(uint32_t budget);
+uint32_t STDCALL ft_ultibo_cache_destroy(FT_ULTIBO_CACHE *cache);
+
+uint32_t STDCALL ft_ultibo_cache_flush(FT_ULTIBO_CACHE *cache);
+
+uint32_t STDCALL ft_ultibo_cache_get_statistics(FT_ULTIBO_CACHE *cache, FT_ULTIBO_STATISTICS *statistics);
+uint32_t STDCALL ft_ultibo_cache_reset_statistics(FT_ULTIBO_CACHE *cache);
+
+/* ============================================================================== */
+/* FreeType Font Functions */
+FT_ULTIBO_FONT * STDCALL ft_ultibo_font_load(FT_ULTIBO_CACHE *cache, const char *filename, uint32_t size);
+FT_ULTIBO_FONT * STDCALL ft_ultibo_font_load_ex(FT_ULTIBO_CACHE *cache, const void *data, uint32_t len, uint32_t size);
+uint32_t STDCALL ft_ultibo_font_unload(FT_ULTIBO_FONT *font);
+
+uint32_t STDCALL ft_ultibo_font_get_height(FT_ULTIBO_FONT *font);
+uint32_t STDCALL ft_ultibo_font_text_width(FT_ULTIBO_FONT *font, const char *text);
+
+uint32_t STDCALL ft_ultibo_font_draw_text(FT_ULTIBO_FONT *font, const char *text, int32_t x, int32_t y, uint32_t color, void *buffer, uint32_t width, uint32_t height, uint32_t format);
+
+FONT_HANDLE STDCALL ft_ultibo_font_create_handle(FT_ULTIBO_FONT *font, uint32_t threshold);
+
+/* ============================================================================== */
+/* FreeType Graphics Console Functions */
+uint32_t STDCALL ft_ultibo_graphics_window_draw_text(WINDOW_HANDLE handle, FT_ULTIBO_FONT *font, const char *text, uint32_t x, uint32_t y, uint32_t forecolor, uint32_t backcolor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _FT_PORT_ULTIBO_H
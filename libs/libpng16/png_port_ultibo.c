@@ -0,0 +1,1314 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/filesystem.h"
+#include "ultibo/framebuffer.h"
+#include "ultibo/graphicsconsole.h"
+
+#include "png_port_ultibo.h"
+
+/*
+ * Implementation of the Ultibo image port for libpng
+ *
+ * Images are decoded one row at a time and each row is converted straight into the
+ * color format of the destination, so drawing a full screen image needs a handful
+ * of rows of working memory rather than a copy of the whole image. Converted rows
+ * are gathered into a strip of PNG_ULTIBO_STRIP_ROWS rows for each transfer to a
+ * framebuffer or graphics window, when decoding into a memory buffer the rows are
+ * written in place with no strip at all.
+ *
+ * Most of the conversion is done by the libpng transformations as each row is
+ * unpacked (Expansion of palette and gray images, 16 to 8 bit, channel order, alpha
+ * position, filler and compositing over a background color) so 32 bit, 24 bit and
+ * 8 bit gray destinations receive rows from libpng already in their final layout.
+ * The 16 bit and 15 bit formats are packed from 24 bit rows, 8 pixels at a time
+ * with NEON on ARMv7 and ARMv8 (Using only d0 to d7 so the code is safe with the
+ * VFPv3-D16 context saved by the scheduler).
+ *
+ * Scaling is nearest neighbour, the source column of each visible destination
+ * column is calculated once per image and source rows are skipped or repeated as
+ * they are decoded. Clipping is applied before conversion and decoding stops after
+ * the last visible row. Interlaced images cannot be streamed and are decoded into
+ * a temporary copy of the whole image before the same conversion is applied.
+ *
+ * A cache keeps decoded images keyed by file name, color format, scaled size and
+ * background, in least recently used order within a memory budget. Images in use
+ * are never discarded and the cache lock is held while an image is decoded so the
+ * same file is never decoded twice at once.
+ */
+
+/* ============================================================================== */
+/* PNG Port specific constants */
+/* Target Kinds */
+#define PNG_ULTIBO_TARGET_FRAMEBUFFER	0
+#define PNG_ULTIBO_TARGET_WINDOW	1
+#define PNG_ULTIBO_TARGET_BUFFER	2 // Caller supplied memory buffer
+#define PNG_ULTIBO_TARGET_IMAGE	3 // Memory buffer allocated once the scaled size is known
+
+/* Signature size checked before libpng is started */
+#define PNG_ULTIBO_SIGNATURE_SIZE	8
+
+/* ============================================================================== */
+/* PNG Port specific types */
+/* Decode Target */
+typedef struct _PNG_ULTIBO_TARGET PNG_ULTIBO_TARGET;
+struct _PNG_ULTIBO_TARGET
+{
+	uint32_t kind; // Target kind (eg PNG_ULTIBO_TARGET_FRAMEBUFFER)
+	FRAMEBUFFER_DEVICE *framebuffer; // Framebuffer device (PNG_ULTIBO_TARGET_FRAMEBUFFER)
+	WINDOW_HANDLE window; // Graphics window (PNG_ULTIBO_TARGET_WINDOW)
+	uint8_t *buffer; // Memory buffer (PNG_ULTIBO_TARGET_BUFFER or PNG_ULTIBO_TARGET_IMAGE)
+	uint32_t pitch; // Bytes per row of the memory buffer
+	uint32_t width; // Width of the target (Pixels)
+	uint32_t height; // Height of the target (Pixels)
+	uint32_t format; // Color format of the target
+	uint32_t bytes; // Bytes per pixel of the target format
+};
+
+/* Decoder (State of a single decode) */
+typedef struct _PNG_ULTIBO_DECODER PNG_ULTIBO_DECODER;
+struct _PNG_ULTIBO_DECODER
+{
+	png_structp png; // libpng read structure
+	png_infop info; // libpng info structure
+	PNG_ULTIBO_TARGET *target; // Destination of the decoded rows
+	// File Properties
+	HANDLE handle; // Source file handle
+	uint8_t *readbuffer; // File read buffer
+	uint32_t readcount; // Bytes in the read buffer
+	uint32_t readoffset; // Next byte in the read buffer
+	// Memory Properties
+	uint32_t memorycurrent; // Bytes currently allocated by this decode (Including libpng)
+	uint32_t memorypeak; // Highest value of memorycurrent
+	// Geometry Properties
+	uint32_t sourcewidth; // Image width (Pixels)
+	uint32_t sourceheight; // Image height (Pixels)
+	uint32_t destwidth; // Scaled width (Pixels)
+	uint32_t destheight; // Scaled height (Pixels)
+	int32_t x; // Position of the scaled image on the target
+	int32_t y;
+	uint32_t visleft; // Visible columns of the scaled image (Right exclusive)
+	uint32_t visright;
+	uint32_t vistop; // Visible rows of the scaled image (Bottom exclusive)
+	uint32_t visbottom;
+	// Row Properties
+	uint32_t layoutbytes; // Bytes per pixel of the rows produced by libpng
+	BOOL convert; // Rows from libpng are packed into the target format
+	uint32_t *xmap; // Source column of each visible column (NULL if not scaled horizontally)
+	uint8_t *row; // Row from libpng
+	uint8_t *scaled; // Visible part of a row after horizontal scaling
+	uint8_t **rows; // Row pointers of the whole image (Interlaced images only)
+	uint8_t *image; // Whole image (Interlaced images only)
+	// Strip Properties
+	uint8_t *strip; // Converted rows waiting for transfer (Not used for memory targets)
+	uint32_t stripcount; // Rows in the strip
+	uint32_t striptop; // Scaled row of the first row in the strip
+	uint8_t *lastrow; // Last converted row (For repeating rows when scaling up)
+	uint32_t lastsource; // Source row of the last converted row
+	uint32_t status; // First error returned by a transfer
+};
+
+/* Cache Entry */
+typedef struct _PNG_ULTIBO_ENTRY PNG_ULTIBO_ENTRY;
+struct _PNG_ULTIBO_ENTRY
+{
+	PNG_ULTIBO_IMAGE image; // Decoded image (Must be first)
+	char *filename; // File the image was decoded from
+	uint32_t width; // Requested width and height (Zero for natural size)
+	uint32_t height;
+	uint32_t flags; // Requested flags
+	uint32_t backcolor; // Requested background color
+	uint32_t size; // Memory used by the decoded pixels (Bytes)
+	uint32_t refcount; // Number of loads not yet released
+	PNG_ULTIBO_ENTRY *prev; // Previous (More recently used) entry
+	PNG_ULTIBO_ENTRY *next; // Next (Less recently used) entry
+};
+
+/* PNG Cache */
+struct _PNG_ULTIBO_CACHE
+{
+	MUTEX_HANDLE lock; // Cache lock (Held while decoding)
+	uint32_t budget; // Memory budget (Bytes)
+	PNG_ULTIBO_ENTRY *first; // Most recently used entry
+	PNG_ULTIBO_ENTRY *last; // Least recently used entry
+	PNG_ULTIBO_STATISTICS statistics;
+};
+
+/* ============================================================================== */
+/* PNG Port Internal Functions */
+static void *png_ultibo_alloc(PNG_ULTIBO_DECODER *decoder, size_t size)
+{
+	size_t *block;
+
+	/* Each block records its size so the memory in use can be tracked */
+	block = malloc(size + sizeof(size_t) * 2);
+	if (!block)
+		return NULL;
+
+	block[0] = size;
+	decoder->memorycurrent += size;
+	if (decoder->memorycurrent > decoder->memorypeak)
+		decoder->memorypeak = decoder->memorycurrent;
+
+	return block + 2;
+}
+
+static void png_ultibo_free(PNG_ULTIBO_DECODER *decoder, void *address)
+{
+	size_t *block;
+
+	if (!address)
+		return;
+
+	block = (size_t *)address - 2;
+	decoder->memorycurrent -= block[0];
+
+	free(block);
+}
+
+static png_voidp png_ultibo_malloc_fn(png_structp png, png_alloc_size_t size)
+{
+	return png_ultibo_alloc((PNG_ULTIBO_DECODER *)png_get_mem_ptr(png), size);
+}
+
+static void png_ultibo_free_fn(png_structp png, png_voidp address)
+{
+	png_ultibo_free((PNG_ULTIBO_DECODER *)png_get_mem_ptr(png), address);
+}
+
+static void png_ultibo_error_fn(png_structp png, png_const_charp message)
+{
+	png_longjmp(png, 1);
+}
+
+static void png_ultibo_warning_fn(png_structp png, png_const_charp message)
+{
+}
+
+static void png_ultibo_read_fn(png_structp png, png_bytep data, png_size_t length)
+{
+	PNG_ULTIBO_DECODER *decoder = (PNG_ULTIBO_DECODER *)png_get_io_ptr(png);
+	uint32_t count;
+	int32_t result;
+
+	while (length > 0)
+	{
+		if (decoder->readoffset == decoder->readcount)
+		{
+			result = FileRead(decoder->handle, decoder->readbuffer, PNG_ULTIBO_READ_BUFFER_SIZE);
+			if (result <= 0)
+				png_error(png, "Read failed");
+
+			decoder->readcount = result;
+			decoder->readoffset = 0;
+		}
+
+		count = decoder->readcount - decoder->readoffset;
+		if (count > length)
+			count = length;
+
+		memcpy(data, decoder->readbuffer + decoder->readoffset, count);
+		decoder->readoffset += count;
+		data += count;
+		length -= count;
+	}
+}
+
+/* Return the row layout bytes libpng must produce for a format, setting BGR order where required */
+static uint32_t png_ultibo_layout(uint32_t format, BOOL *bgr, BOOL *alphafirst, BOOL *alpha)
+{
+	*bgr = FALSE;
+	*alphafirst = FALSE;
+	*alpha = FALSE;
+
+	/* The 32 bit formats are named from the most significant byte, memory order is the reverse */
+	switch (format)
+	{
+		case COLOR_FORMAT_ARGB32:
+			*alpha = TRUE;
+		case COLOR_FORMAT_URGB32:
+			*bgr = TRUE;
+			return 4;
+		case COLOR_FORMAT_ABGR32:
+			*alpha = TRUE;
+		case COLOR_FORMAT_UBGR32:
+			return 4;
+		case COLOR_FORMAT_RGBA32:
+			*alpha = TRUE;
+		case COLOR_FORMAT_RGBU32:
+			*bgr = TRUE;
+			*alphafirst = TRUE;
+			return 4;
+		case COLOR_FORMAT_BGRA32:
+			*alpha = TRUE;
+		case COLOR_FORMAT_BGRU32:
+			*alphafirst = TRUE;
+			return 4;
+		case COLOR_FORMAT_RGB24:
+			*bgr = TRUE;
+			return 3;
+		case COLOR_FORMAT_BGR24:
+		case COLOR_FORMAT_RGB16:
+		case COLOR_FORMAT_RGB15:
+			return 3;
+		case COLOR_FORMAT_BGR16:
+		case COLOR_FORMAT_BGR15:
+			*bgr = TRUE;
+			return 3;
+		case COLOR_FORMAT_GRAY8:
+			return 1;
+	}
+
+	return 0;
+}
+
+#if defined(__aarch64__)
+/* Pack 24 bit rows into 5/6/5 or 5/5/5, the first byte of each pixel is the high channel */
+static uint32_t png_ultibo_pack_simd(const uint8_t *source, uint8_t *dest, uint32_t count, BOOL fifteen)
+{
+	uint32_t blocks;
+
+	blocks = count & ~7;
+	if (blocks == 0)
+		return 0;
+
+	if (fifteen)
+	{
+		__asm__ __volatile__(
+			"1:\n"
+			"ld3 {v0.8b, v1.8b, v2.8b}, [%[source]], #24\n"
+			"ushll v4.8h, v0.8b, #7\n"
+			"shll v5.8h, v1.8b, #8\n"
+			"sri v4.8h, v5.8h, #6\n"
+			"shll v5.8h, v2.8b, #8\n"
+			"sri v4.8h, v5.8h, #11\n"
+			"st1 {v4.8h}, [%[dest]], #16\n"
+			"subs %w[count], %w[count], #8\n"
+			"b.ne 1b\n"
+			: [dest] "+r" (dest), [source] "+r" (source), [count] "+r" (blocks)
+			:
+			: "v0", "v1", "v2", "v4", "v5", "cc", "memory");
+	}
+	else
+	{
+		__asm__ __volatile__(
+			"1:\n"
+			"ld3 {v0.8b, v1.8b, v2.8b}, [%[source]], #24\n"
+			"shll v4.8h, v0.8b, #8\n"
+			"shll v5.8h, v1.8b, #8\n"
+			"sri v4.8h, v5.8h, #5\n"
+			"shll v5.8h, v2.8b, #8\n"
+			"sri v4.8h, v5.8h, #11\n"
+			"st1 {v4.8h}, [%[dest]], #16\n"
+			"subs %w[count], %w[count], #8\n"
+			"b.ne 1b\n"
+			: [dest] "+r" (dest), [source] "+r" (source), [count] "+r" (blocks)
+			:
+			: "v0", "v1", "v2", "v4", "v5", "cc", "memory");
+	}
+
+	return count & ~7;
+}
+#elif defined(__arm__) && defined(__ARM_ARCH) && (__ARM_ARCH >= 7)
+/* Pack 24 bit rows into 5/6/5 or 5/5/5, the first byte of each pixel is the high channel */
+static uint32_t png_ultibo_pack_simd(const uint8_t *source, uint8_t *dest, uint32_t count, BOOL fifteen)
+{
+	uint32_t blocks;
+
+	blocks = count & ~7;
+	if (blocks == 0)
+		return 0;
+
+	if (fifteen)
+	{
+		__asm__ __volatile__(
+			".fpu neon\n"
+			"1:\n"
+			"vld3.8 {d0, d1, d2}, [%[source]]!\n"
+			"vshll.u8 q2, d0, #7\n"
+			"vshll.u8 q3, d1, #8\n"
+			"vsri.16 q2, q3, #6\n"
+			"vshll.u8 q3, d2, #8\n"
+			"vsri.16 q2, q3, #11\n"
+			"vst1.16 {d4, d5}, [%[dest]]!\n"
+			"subs %[count], %[count], #8\n"
+			"bne 1b\n"
+			: [dest] "+r" (dest), [source] "+r" (source), [count] "+r" (blocks)
+			:
+			: "d0", "d1", "d2", "d4", "d5", "d6", "d7", "cc", "memory");
+	}
+	else
+	{
+		__asm__ __volatile__(
+			".fpu neon\n"
+			"1:\n"
+			"vld3.8 {d0, d1, d2}, [%[source]]!\n"
+			"vshll.u8 q2, d0, #8\n"
+			"vshll.u8 q3, d1, #8\n"
+			"vsri.16 q2, q3, #5\n"
+			"vshll.u8 q3, d2, #8\n"
+			"vsri.16 q2, q3, #11\n"
+			"vst1.16 {d4, d5}, [%[dest]]!\n"
+			"subs %[count], %[count], #8\n"
+			"bne 1b\n"
+			: [dest] "+r" (dest), [source] "+r" (source), [count] "+r" (blocks)
+			:
+			: "d0", "d1", "d2", "d4", "d5", "d6", "d7", "cc", "memory");
+	}
+
+	return count & ~7;
+}
+#endif
+
+/* Pack a 24 bit row into a 16 or 15 bit format */
+static void png_ultibo_pack(const uint8_t *source, uint8_t *dest, uint32_t count, uint32_t format)
+{
+	uint16_t *output;
+	uint32_t index;
+	BOOL fifteen;
+
+	fifteen = (format == COLOR_FORMAT_RGB15 || format == COLOR_FORMAT_BGR15);
+
+	index = 0;
+	#if defined(__aarch64__) || (defined(__arm__) && defined(__ARM_ARCH) && (__ARM_ARCH >= 7))
+	index = png_ultibo_pack_simd(source, dest, count, fifteen);
+	#endif
+
+	/* Remaining pixels (Or all pixels without NEON) */
+	source += index * 3;
+	output = (uint16_t *)dest + index;
+	if (fifteen)
+	{
+		for (; index < count; index++, source += 3)
+			*output++ = ((source[0] >> 3) << 10) | ((source[1] >> 3) << 5) | (source[2] >> 3);
+	}
+	else
+	{
+		for (; index < count; index++, source += 3)
+			*output++ = ((source[0] >> 3) << 11) | ((source[1] >> 2) << 5) | (source[2] >> 3);
+	}
+}
+
+/* Set the libpng transformations that produce rows in the layout for the target format */
+static uint32_t png_ultibo_transforms(PNG_ULTIBO_DECODER *decoder, uint32_t format, uint32_t flags, uint32_t backcolor)
+{
+	png_color_16 background;
+	png_byte colortype;
+	BOOL alphafirst;
+	BOOL hasalpha;
+	BOOL alpha;
+	BOOL bgr;
+
+	decoder->layoutbytes = png_ultibo_layout(format, &bgr, &alphafirst, &alpha);
+	if (decoder->layoutbytes == 0)
+		return ERROR_NOT_SUPPORTED;
+
+	decoder->convert = (decoder->layoutbytes != png_ultibo_format_bytes(format));
+
+	colortype = png_get_color_type(decoder->png, decoder->info);
+	hasalpha = ((colortype & PNG_COLOR_MASK_ALPHA) || png_get_valid(decoder->png, decoder->info, PNG_INFO_tRNS));
+
+	/* Palette, low bit depth gray and transparency to 8 bit channels */
+	png_set_expand(decoder->png);
+	if (png_get_bit_depth(decoder->png, decoder->info) == 16)
+		png_set_scale_16(decoder->png);
+
+	if (format == COLOR_FORMAT_GRAY8)
+	{
+		if (colortype & PNG_COLOR_MASK_COLOR)
+			png_set_rgb_to_gray_fixed(decoder->png, PNG_ERROR_ACTION_NONE, -1, -1);
+	}
+	else if (!(colortype & PNG_COLOR_MASK_COLOR))
+	{
+		png_set_gray_to_rgb(decoder->png);
+	}
+
+	if (hasalpha)
+	{
+		if (flags & PNG_ULTIBO_FLAG_BACKGROUND)
+		{
+			memset(&background, 0, sizeof(png_color_16));
+			background.red = (backcolor >> 16) & 0xFF;
+			background.green = (backcolor >> 8) & 0xFF;
+			background.blue = backcolor & 0xFF;
+			background.gray = ((background.red * 77) + (background.green * 150) + (background.blue * 29)) >> 8;
+			if (format == COLOR_FORMAT_GRAY8)
+				background.red = background.green = background.blue = background.gray;
+
+			png_set_background(decoder->png, &background, PNG_BACKGROUND_GAMMA_SCREEN, 0, 1.0);
+			hasalpha = FALSE;
+		}
+		else if (!alpha)
+		{
+			png_set_strip_alpha(decoder->png);
+			hasalpha = FALSE;
+		}
+	}
+
+	if (bgr)
+		png_set_bgr(decoder->png);
+
+	if (decoder->layoutbytes == 4)
+	{
+		if (hasalpha)
+		{
+			if (alphafirst)
+				png_set_swap_alpha(decoder->png);
+		}
+		else
+		{
+			png_set_filler(decoder->png, 0xFF, alphafirst ? PNG_FILLER_BEFORE : PNG_FILLER_AFTER);
+		}
+	}
+
+	return ERROR_SUCCESS;
+}
+
+/* Calculate the scaled size and the visible part of the scaled image on the target */
+static BOOL png_ultibo_geometry(PNG_ULTIBO_DECODER *decoder, PNG_ULTIBO_OPTIONS *options)
+{
+	int64_t left;
+	int64_t top;
+	int64_t right;
+	int64_t bottom;
+
+	decoder->destwidth = decoder->sourcewidth;
+	decoder->destheight = decoder->sourceheight;
+	if (options)
+	{
+		if (options->width && options->height)
+		{
+			decoder->destwidth = options->width;
+			decoder->destheight = options->height;
+		}
+		else if (options->width)
+		{
+			decoder->destwidth = options->width;
+			decoder->destheight = ((uint64_t)decoder->sourceheight * options->width + (decoder->sourcewidth / 2)) / decoder->sourcewidth;
+		}
+		else if (options->height)
+		{
+			decoder->destheight = options->height;
+			decoder->destwidth = ((uint64_t)decoder->sourcewidth * options->height + (decoder->sourceheight / 2)) / decoder->sourceheight;
+		}
+		if (decoder->destwidth == 0)
+			decoder->destwidth = 1;
+		if (decoder->destheight == 0)
+			decoder->destheight = 1;
+	}
+
+	/* An image target is sized to fit the scaled image */
+	if (decoder->target->kind == PNG_ULTIBO_TARGET_IMAGE)
+	{
+		decoder->target->width = decoder->destwidth;
+		decoder->target->height = decoder->destheight;
+	}
+
+	left = 0;
+	top = 0;
+	right = decoder->target->width;
+	bottom = decoder->target->height;
+	if (options && decoder->target->kind != PNG_ULTIBO_TARGET_IMAGE && (options->clipleft || options->cliptop || options->clipright || options->clipbottom))
+	{
+		if (options->clipleft > left)
+			left = options->clipleft;
+		if (options->cliptop > top)
+			top = options->cliptop;
+		if (options->clipright < right)
+			right = options->clipright;
+		if (options->clipbottom < bottom)
+			bottom = options->clipbottom;
+	}
+
+	/* Convert to columns and rows of the scaled image */
+	left -= decoder->x;
+	right -= decoder->x;
+	top -= decoder->y;
+	bottom -= decoder->y;
+	if (left < 0)
+		left = 0;
+	if (top < 0)
+		top = 0;
+	if (right > decoder->destwidth)
+		right = decoder->destwidth;
+	if (bottom > decoder->destheight)
+		bottom = decoder->destheight;
+	if (left >= right || top >= bottom)
+		return FALSE;
+
+	decoder->visleft = left;
+	decoder->visright = right;
+	decoder->vistop = top;
+	decoder->visbottom = bottom;
+
+	return TRUE;
+}
+
+/* Source row or column sampled by a scaled row or column (Nearest to the center) */
+static inline uint32_t png_ultibo_sample(uint32_t dest, uint32_t sourcesize, uint32_t destsize)
+{
+	return (((uint64_t)dest * 2 + 1) * sourcesize) / ((uint64_t)destsize * 2);
+}
+
+static void png_ultibo_strip_flush(PNG_ULTIBO_DECODER *decoder)
+{
+	PNG_ULTIBO_TARGET *target = decoder->target;
+	uint32_t width;
+	uint32_t status;
+
+	if (decoder->stripcount == 0)
+		return;
+
+	width = decoder->visright - decoder->visleft;
+
+	if (target->kind == PNG_ULTIBO_TARGET_FRAMEBUFFER)
+		status = framebuffer_device_put_rect(target->framebuffer, decoder->x + decoder->visleft, decoder->y + decoder->striptop, decoder->strip, width, decoder->stripcount, 0, FRAMEBUFFER_TRANSFER_NONE);
+	else
+		status = graphics_window_draw_image(target->window, decoder->x + decoder->visleft, decoder->y + decoder->striptop, decoder->strip, width, decoder->stripcount, target->format);
+
+	if (status != ERROR_SUCCESS && decoder->status == ERROR_SUCCESS)
+		decoder->status = status;
+
+	decoder->stripcount = 0;
+}
+
+/* Convert the visible part of a source row into scaled row dest of the target */
+static void png_ultibo_emit(PNG_ULTIBO_DECODER *decoder, const uint8_t *source, uint32_t sourcerow, uint32_t dest)
+{
+	PNG_ULTIBO_TARGET *target = decoder->target;
+	const uint8_t *input;
+	uint32_t layout;
+	uint32_t width;
+	uint32_t index;
+	uint8_t *output;
+
+	width = decoder->visright - decoder->visleft;
+
+	if (target->kind == PNG_ULTIBO_TARGET_BUFFER || target->kind == PNG_ULTIBO_TARGET_IMAGE)
+	{
+		output = target->buffer + ((decoder->y + dest) * target->pitch) + ((decoder->x + decoder->visleft) * target->bytes);
+	}
+	else
+	{
+		if (decoder->stripcount == 0)
+			decoder->striptop = dest;
+		output = decoder->strip + (decoder->stripcount * width * target->bytes);
+	}
+
+	/* Rows repeated by scaling up are copied from the previous row */
+	if (decoder->lastrow && decoder->lastsource == sourcerow)
+	{
+		memcpy(output, decoder->lastrow, width * target->bytes);
+	}
+	else
+	{
+		layout = decoder->layoutbytes;
+		input = source + (decoder->visleft * layout);
+
+		if (decoder->xmap)
+		{
+			switch (layout)
+			{
+				case 4:
+					for (index = 0; index < width; index++)
+						((uint32_t *)decoder->scaled)[index] = ((const uint32_t *)source)[decoder->xmap[index]];
+					break;
+				case 3:
+					for (index = 0; index < width; index++)
+						memcpy(decoder->scaled + (index * 3), source + (decoder->xmap[index] * 3), 3);
+					break;
+				default:
+					for (index = 0; index < width; index++)
+						decoder->scaled[index] = source[decoder->xmap[index]];
+					break;
+			}
+			input = decoder->scaled;
+		}
+
+		if (decoder->convert)
+			png_ultibo_pack(input, output, width, target->format);
+		else
+			memcpy(output, input, width * layout);
+	}
+
+	decoder->lastrow = output;
+	decoder->lastsource = sourcerow;
+
+	if (target->kind == PNG_ULTIBO_TARGET_FRAMEBUFFER || target->kind == PNG_ULTIBO_TARGET_WINDOW)
+	{
+		decoder->stripcount++;
+		if (decoder->stripcount == PNG_ULTIBO_STRIP_ROWS)
+			png_ultibo_strip_flush(decoder);
+	}
+}
+
+/* Decode rows until the last visible row, must be called after setjmp */
+static void png_ultibo_rows(PNG_ULTIBO_DECODER *decoder)
+{
+	uint32_t source;
+	uint32_t dest;
+	uint8_t *row;
+
+	if (decoder->rows)
+	{
+		png_read_image(decoder->png, decoder->rows);
+	}
+
+	dest = decoder->vistop;
+	for (source = 0; source < decoder->sourceheight && dest < decoder->visbottom; source++)
+	{
+		if (decoder->rows)
+		{
+			row = decoder->rows[source];
+		}
+		else
+		{
+			png_read_row(decoder->png, decoder->row, NULL);
+			row = decoder->row;
+		}
+
+		while (dest < decoder->visbottom && png_ultibo_sample(dest, decoder->sourceheight, decoder->destheight) == source)
+		{
+			png_ultibo_emit(decoder, row, source, dest);
+			dest++;
+		}
+	}
+
+	png_ultibo_strip_flush(decoder);
+}
+
+/* Open a file and start libpng, reading the image header */
+static uint32_t png_ultibo_open(PNG_ULTIBO_DECODER *decoder, const char *filename)
+{
+	uint8_t signature[PNG_ULTIBO_SIGNATURE_SIZE];
+
+	decoder->handle = FileOpen(filename, fmOpenRead | fmShareDenyNone);
+	if (decoder->handle == INVALID_HANDLE_VALUE)
+		return ERROR_FILE_NOT_FOUND;
+
+	if (FileRead(decoder->handle, signature, PNG_ULTIBO_SIGNATURE_SIZE) != PNG_ULTIBO_SIGNATURE_SIZE || png_sig_cmp(signature, 0, PNG_ULTIBO_SIGNATURE_SIZE) != 0)
+		return ERROR_INVALID_DATA;
+
+	decoder->readbuffer = png_ultibo_alloc(decoder, PNG_ULTIBO_READ_BUFFER_SIZE);
+	if (!decoder->readbuffer)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	decoder->png = png_create_read_struct_2(PNG_LIBPNG_VER_STRING, decoder, png_ultibo_error_fn, png_ultibo_warning_fn, decoder, png_ultibo_malloc_fn, png_ultibo_free_fn);
+	if (!decoder->png)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	decoder->info = png_create_info_struct(decoder->png);
+	if (!decoder->info)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	if (setjmp(png_jmpbuf(decoder->png)))
+		return ERROR_INVALID_DATA;
+
+	png_set_read_fn(decoder->png, decoder, png_ultibo_read_fn);
+	png_set_sig_bytes(decoder->png, PNG_ULTIBO_SIGNATURE_SIZE);
+	png_read_info(decoder->png, decoder->info);
+
+	decoder->sourcewidth = png_get_image_width(decoder->png, decoder->info);
+	decoder->sourceheight = png_get_image_height(decoder->png, decoder->info);
+
+	return ERROR_SUCCESS;
+}
+
+static void png_ultibo_close(PNG_ULTIBO_DECODER *decoder)
+{
+	if (decoder->png)
+		png_destroy_read_struct(&decoder->png, decoder->info ? &decoder->info : NULL, NULL);
+
+	png_ultibo_free(decoder, decoder->image);
+	png_ultibo_free(decoder, decoder->rows);
+	png_ultibo_free(decoder, decoder->strip);
+	png_ultibo_free(decoder, decoder->scaled);
+	png_ultibo_free(decoder, decoder->row);
+	png_ultibo_free(decoder, decoder->xmap);
+	png_ultibo_free(decoder, decoder->readbuffer);
+
+	if (decoder->handle != INVALID_HANDLE_VALUE)
+		FileClose(decoder->handle);
+}
+
+/* Decode a file onto a target */
+static uint32_t png_ultibo_decode_target(PNG_ULTIBO_TARGET *target, const char *filename, int32_t x, int32_t y, PNG_ULTIBO_OPTIONS *options)
+{
+	PNG_ULTIBO_DECODER decoder;
+	uint32_t rowbytes;
+	uint32_t status;
+	uint32_t width;
+	uint32_t index;
+	uint32_t passes;
+
+	if (!filename)
+		return ERROR_INVALID_PARAMETER;
+
+	target->bytes = png_ultibo_format_bytes(target->format);
+	if (target->bytes == 0)
+		return ERROR_NOT_SUPPORTED;
+
+	memset(&decoder, 0, sizeof(PNG_ULTIBO_DECODER));
+	decoder.handle = INVALID_HANDLE_VALUE;
+	decoder.target = target;
+	decoder.x = x;
+	decoder.y = y;
+
+	status = png_ultibo_open(&decoder, filename);
+	if (status != ERROR_SUCCESS)
+		goto done;
+
+	if (!png_ultibo_geometry(&decoder, options))
+		goto done;
+
+	width = decoder.visright - decoder.visleft;
+
+	if (target->kind == PNG_ULTIBO_TARGET_IMAGE)
+	{
+		/* Allocated with the C library since the image outlives the decode */
+		target->pitch = target->width * target->bytes;
+		target->buffer = malloc(target->pitch * target->height);
+		if (!target->buffer)
+		{
+			status = ERROR_NOT_ENOUGH_MEMORY;
+			goto done;
+		}
+	}
+
+	if (setjmp(png_jmpbuf(decoder.png)))
+	{
+		status = ERROR_INVALID_DATA;
+		goto done;
+	}
+
+	status = png_ultibo_transforms(&decoder, target->format, options ? options->flags : PNG_ULTIBO_FLAG_NONE, options ? options->backcolor : 0);
+	if (status != ERROR_SUCCESS)
+		goto done;
+
+	passes = png_set_interlace_handling(decoder.png);
+	png_read_update_info(decoder.png, decoder.info);
+
+	rowbytes = png_get_rowbytes(decoder.png, decoder.info);
+	if (rowbytes != decoder.sourcewidth * decoder.layoutbytes)
+	{
+		status = ERROR_NOT_SUPPORTED;
+		goto done;
+	}
+
+	/* Working memory */
+	if (passes > 1)
+	{
+		decoder.image = png_ultibo_alloc(&decoder, (size_t)rowbytes * decoder.sourceheight);
+		decoder.rows = png_ultibo_alloc(&decoder, sizeof(uint8_t *) * decoder.sourceheight);
+		if (!decoder.image || !decoder.rows)
+		{
+			status = ERROR_NOT_ENOUGH_MEMORY;
+			goto done;
+		}
+		for (index = 0; index < decoder.sourceheight; index++)
+			decoder.rows[index] = decoder.image + (index * rowbytes);
+	}
+	else
+	{
+		decoder.row = png_ultibo_alloc(&decoder, rowbytes);
+		if (!decoder.row)
+		{
+			status = ERROR_NOT_ENOUGH_MEMORY;
+			goto done;
+		}
+	}
+
+	if (decoder.destwidth != decoder.sourcewidth)
+	{
+		decoder.xmap = png_ultibo_alloc(&decoder, sizeof(uint32_t) * width);
+		decoder.scaled = png_ultibo_alloc(&decoder, width * decoder.layoutbytes);
+		if (!decoder.xmap || !decoder.scaled)
+		{
+			status = ERROR_NOT_ENOUGH_MEMORY;
+			goto done;
+		}
+		for (index = 0; index < width; index++)
+			decoder.xmap[index] = png_ultibo_sample(decoder.visleft + index, decoder.sourcewidth, decoder.destwidth);
+	}
+
+	if (target->kind == PNG_ULTIBO_TARGET_FRAMEBUFFER || target->kind == PNG_ULTIBO_TARGET_WINDOW)
+	{
+		decoder.strip = png_ultibo_alloc(&decoder, width * target->bytes * PNG_ULTIBO_STRIP_ROWS);
+		if (!decoder.strip)
+		{
+			status = ERROR_NOT_ENOUGH_MEMORY;
+			goto done;
+		}
+	}
+
+	png_ultibo_rows(&decoder);
+
+	status = decoder.status;
+
+done:
+	png_ultibo_close(&decoder);
+
+	if (options)
+		options->memoryused = decoder.memorypeak;
+
+	if (status != ERROR_SUCCESS && target->kind == PNG_ULTIBO_TARGET_IMAGE)
+	{
+		free(target->buffer);
+		target->buffer = NULL;
+	}
+
+	return status;
+}
+
+static void png_ultibo_entry_unlink(PNG_ULTIBO_CACHE *cache, PNG_ULTIBO_ENTRY *entry)
+{
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		cache->first = entry->next;
+
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		cache->last = entry->prev;
+
+	entry->prev = NULL;
+	entry->next = NULL;
+}
+
+static void png_ultibo_entry_insert(PNG_ULTIBO_CACHE *cache, PNG_ULTIBO_ENTRY *entry)
+{
+	entry->prev = NULL;
+	entry->next = cache->first;
+
+	if (cache->first)
+		cache->first->prev = entry;
+	else
+		cache->last = entry;
+
+	cache->first = entry;
+}
+
+static void png_ultibo_entry_free(PNG_ULTIBO_CACHE *cache, PNG_ULTIBO_ENTRY *entry)
+{
+	png_ultibo_entry_unlink(cache, entry);
+
+	cache->statistics.imagecount--;
+	cache->statistics.memoryused -= entry->size;
+
+	free(entry->image.data);
+	free(entry->filename);
+	free(entry);
+}
+
+/* Discard least recently used images not in use until the cache is within the budget, caller must hold the cache lock */
+static void png_ultibo_cache_trim(PNG_ULTIBO_CACHE *cache)
+{
+	PNG_ULTIBO_ENTRY *entry;
+	PNG_ULTIBO_ENTRY *prev;
+
+	entry = cache->last;
+	while (entry && cache->statistics.memoryused > cache->budget)
+	{
+		prev = entry->prev;
+		if (entry->refcount == 0)
+		{
+			png_ultibo_entry_free(cache, entry);
+			cache->statistics.evictcount++;
+		}
+		entry = prev;
+	}
+}
+
+/* ============================================================================== */
+/* PNG Decode Functions */
+uint32_t STDCALL png_ultibo_get_info(const char *filename, PNG_ULTIBO_INFO *info)
+{
+	PNG_ULTIBO_DECODER decoder;
+	uint32_t status;
+
+	if (!filename || !info)
+		return ERROR_INVALID_PARAMETER;
+
+	memset(&decoder, 0, sizeof(PNG_ULTIBO_DECODER));
+	decoder.handle = INVALID_HANDLE_VALUE;
+
+	status = png_ultibo_open(&decoder, filename);
+	if (status == ERROR_SUCCESS)
+	{
+		info->width = decoder.sourcewidth;
+		info->height = decoder.sourceheight;
+		info->bitdepth = png_get_bit_depth(decoder.png, decoder.info);
+		info->colortype = png_get_color_type(decoder.png, decoder.info);
+		info->interlaced = (png_get_interlace_type(decoder.png, decoder.info) != PNG_INTERLACE_NONE);
+	}
+
+	png_ultibo_close(&decoder);
+
+	return status;
+}
+
+uint32_t STDCALL png_ultibo_framebuffer_draw(FRAMEBUFFER_DEVICE *framebuffer, const char *filename, int32_t x, int32_t y, PNG_ULTIBO_OPTIONS *options)
+{
+	FRAMEBUFFER_PROPERTIES properties;
+	PNG_ULTIBO_TARGET target;
+	uint32_t status;
+
+	if (!framebuffer)
+		return ERROR_INVALID_PARAMETER;
+
+	status = framebuffer_device_get_properties(framebuffer, &properties);
+	if (status != ERROR_SUCCESS)
+		return status;
+
+	memset(&target, 0, sizeof(PNG_ULTIBO_TARGET));
+	target.kind = PNG_ULTIBO_TARGET_FRAMEBUFFER;
+	target.framebuffer = framebuffer;
+	target.width = properties.physicalwidth;
+	target.height = properties.physicalheight;
+	target.format = properties.format;
+
+	return png_ultibo_decode_target(&target, filename, x, y, options);
+}
+
+uint32_t STDCALL png_ultibo_graphics_window_draw(WINDOW_HANDLE handle, const char *filename, int32_t x, int32_t y, PNG_ULTIBO_OPTIONS *options)
+{
+	PNG_ULTIBO_TARGET target;
+
+	if (handle == INVALID_HANDLE_VALUE)
+		return ERROR_INVALID_PARAMETER;
+
+	memset(&target, 0, sizeof(PNG_ULTIBO_TARGET));
+	target.kind = PNG_ULTIBO_TARGET_WINDOW;
+	target.window = handle;
+	target.width = graphics_window_get_width(handle);
+	target.height = graphics_window_get_height(handle);
+	target.format = graphics_window_get_format(handle);
+
+	return png_ultibo_decode_target(&target, filename, x, y, options);
+}
+
+uint32_t STDCALL png_ultibo_decode(const char *filename, void *buffer, uint32_t width, uint32_t height, uint32_t pitch, uint32_t format, int32_t x, int32_t y, PNG_ULTIBO_OPTIONS *options)
+{
+	PNG_ULTIBO_TARGET target;
+
+	if (!buffer || pitch < width * png_ultibo_format_bytes(format))
+		return ERROR_INVALID_PARAMETER;
+
+	memset(&target, 0, sizeof(PNG_ULTIBO_TARGET));
+	target.kind = PNG_ULTIBO_TARGET_BUFFER;
+	target.buffer = buffer;
+	target.pitch = pitch;
+	target.width = width;
+	target.height = height;
+	target.format = format;
+
+	return png_ultibo_decode_target(&target, filename, x, y, options);
+}
+
+/* ============================================================================== */
+/* PNG Cache Functions */
+PNG_ULTIBO_CACHE * STDCALL png_ultibo_cache_create(uint32_t budget)
+{
+	PNG_ULTIBO_CACHE *cache;
+
+	cache = calloc(1, sizeof(PNG_ULTIBO_CACHE));
+	if (!cache)
+		return NULL;
+
+	cache->lock = mutex_create();
+	if (cache->lock == INVALID_HANDLE_VALUE)
+	{
+		free(cache);
+		return NULL;
+	}
+
+	cache->budget = budget ? budget : PNG_ULTIBO_DEFAULT_BUDGET;
+	cache->statistics.memorybudget = cache->budget;
+
+	return cache;
+}
+
+uint32_t STDCALL png_ultibo_cache_destroy(PNG_ULTIBO_CACHE *cache)
+{
+	if (!cache)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	while (cache->first)
+		png_ultibo_entry_free(cache, cache->first);
+
+	mutex_unlock(cache->lock);
+	mutex_destroy(cache->lock);
+
+	free(cache);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL png_ultibo_cache_flush(PNG_ULTIBO_CACHE *cache)
+{
+	PNG_ULTIBO_ENTRY *entry;
+	PNG_ULTIBO_ENTRY *next;
+
+	if (!cache)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	entry = cache->first;
+	while (entry)
+	{
+		next = entry->next;
+		if (entry->refcount == 0)
+			png_ultibo_entry_free(cache, entry);
+		entry = next;
+	}
+
+	mutex_unlock(cache->lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL png_ultibo_cache_get_statistics(PNG_ULTIBO_CACHE *cache, PNG_ULTIBO_STATISTICS *statistics)
+{
+	if (!cache || !statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	*statistics = cache->statistics;
+
+	mutex_unlock(cache->lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL png_ultibo_cache_reset_statistics(PNG_ULTIBO_CACHE *cache)
+{
+	if (!cache)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	cache->statistics.hitcount = 0;
+	cache->statistics.misscount = 0;
+	cache->statistics.evictcount = 0;
+	cache->statistics.errorcount = 0;
+
+	mutex_unlock(cache->lock);
+
+	return ERROR_SUCCESS;
+}
+
+PNG_ULTIBO_IMAGE * STDCALL png_ultibo_image_load(PNG_ULTIBO_CACHE *cache, const char *filename, uint32_t format, PNG_ULTIBO_OPTIONS *options)
+{
+	PNG_ULTIBO_OPTIONS defaults;
+	PNG_ULTIBO_TARGET target;
+	PNG_ULTIBO_ENTRY *entry;
+
+	if (!cache || !filename || png_ultibo_format_bytes(format) == 0)
+		return NULL;
+
+	if (!options)
+	{
+		memset(&defaults, 0, sizeof(PNG_ULTIBO_OPTIONS));
+		options = &defaults;
+	}
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return NULL;
+
+	for (entry = cache->first; entry; entry = entry->next)
+	{
+		if (entry->image.format == format
+		 && entry->width == options->width
+		 && entry->height == options->height
+		 && entry->flags == options->flags
+		 && (!(options->flags & PNG_ULTIBO_FLAG_BACKGROUND) || entry->backcolor == options->backcolor)
+		 && strcmp(entry->filename, filename) == 0)
+		{
+			png_ultibo_entry_unlink(cache, entry);
+			png_ultibo_entry_insert(cache, entry);
+
+			entry->refcount++;
+			cache->statistics.hitcount++;
+
+			mutex_unlock(cache->lock);
+
+			return &entry->image;
+		}
+	}
+
+	cache->statistics.misscount++;
+
+	entry = calloc(1, sizeof(PNG_ULTIBO_ENTRY));
+	if (!entry)
+		goto failed;
+
+	entry->filename = strdup(filename);
+	if (!entry->filename)
+		goto failed;
+
+	memset(&target, 0, sizeof(PNG_ULTIBO_TARGET));
+	target.kind = PNG_ULTIBO_TARGET_IMAGE;
+	target.format = format;
+
+	if (png_ultibo_decode_target(&target, filename, 0, 0, options) != ERROR_SUCCESS)
+		goto failed;
+
+	entry->image.width = target.width;
+	entry->image.height = target.height;
+	entry->image.format = format;
+	entry->image.pitch = target.pitch;
+	entry->image.data = target.buffer;
+	entry->width = options->width;
+	entry->height = options->height;
+	entry->flags = options->flags;
+	entry->backcolor = options->backcolor;
+	entry->size = target.pitch * target.height;
+	entry->refcount = 1;
+
+	png_ultibo_entry_insert(cache, entry);
+
+	cache->statistics.imagecount++;
+	cache->statistics.memoryused += entry->size;
+
+	png_ultibo_cache_trim(cache);
+
+	mutex_unlock(cache->lock);
+
+	return &entry->image;
+
+failed:
+	cache->statistics.errorcount++;
+
+	if (entry)
+		free(entry->filename);
+	free(entry);
+
+	mutex_unlock(cache->lock);
+
+	return NULL;
+}
+
+uint32_t STDCALL png_ultibo_image_release(PNG_ULTIBO_CACHE *cache, PNG_ULTIBO_IMAGE *image)
+{
+	PNG_ULTIBO_ENTRY *entry = (PNG_ULTIBO_ENTRY *)image;
+
+	if (!cache || !image)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	if (entry->refcount > 0)
+		entry->refcount--;
+
+	png_ultibo_cache_trim(cache);
+
+	mutex_unlock(cache->lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL png_ultibo_image_draw(FRAMEBUFFER_DEVICE *framebuffer, PNG_ULTIBO_IMAGE *image, int32_t x, int32_t y)
+{
+	FRAMEBUFFER_PROPERTIES properties;
+	uint32_t status;
+	int64_t left;
+	int64_t top;
+	int64_t right;
+	int64_t bottom;
+	uint8_t *data;
+
+	if (!framebuffer || !image)
+		return ERROR_INVALID_PARAMETER;
+
+	status = framebuffer_device_get_properties(framebuffer, &properties);
+	if (status != ERROR_SUCCESS)
+		return status;
+
+	if (properties.format != image->format)
+		return ERROR_NOT_COMPATIBLE;
+
+	/* Visible part of the image */
+	left = (x < 0) ? -(int64_t)x : 0;
+	top = (y < 0) ? -(int64_t)y : 0;
+	right = image->width;
+	bottom = image->height;
+	if ((int64_t)x + right > properties.physicalwidth)
+		right = (int64_t)properties.physicalwidth - x;
+	if ((int64_t)y + bottom > properties.physicalheight)
+		bottom = (int64_t)properties.physicalheight - y;
+	if (left >= right || top >= bottom)
+		return ERROR_SUCCESS;
+
+	data = (uint8_t *)image->data + (top * image->pitch) + (left * png_ultibo_format_bytes(image->format));
+
+	return framebuffer_device_put_rect(framebuffer, x + left, y + top, data, right - left, bottom - top, image->width - (right - left), FRAMEBUFFER_TRANSFER_NONE);
+}
+
+/* ============================================================================== */
+/* PNG Helper Functions */
+uint32_t STDCALL png_ultibo_format_bytes(uint32_t format)
+{
+	switch (format)
+	{
+		case COLOR_FORMAT_ARGB32:
+		case COLOR_FORMAT_ABGR32:
+		case COLOR_FORMAT_RGBA32:
+		case COLOR_FORMAT_BGRA32:
+		case COLOR_FORMAT_URGB32:
+		case COLOR_FORMAT_UBGR32:
+		case COLOR_FORMAT_RGBU32:
+		case COLOR_FORMAT_BGRU32:
+			return 4;
+		case COLOR_FORMAT_RGB24:
+		case COLOR_FORMAT_BGR24:
+			return 3;
+		case COLOR_FORMAT_RGB16:
+		case COLOR_FORMAT_BGR16:
+		case COLOR_FORMAT_RGB15:
+		case COLOR_FORMAT_BGR15:
+			return 2;
+		case COLOR_FORMAT_GRAY8:
+			return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _PNG_PORT_ULTIBO_H
+#define _PNG_PORT_ULTIBO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/framebuffer.h"
+#include "ultibo/graphicsconsole.h"
+
+#include "png.h"
+
+/* ============================================================================== */
+/* PNG Port specific constants */
+#define PNG_ULTIBO_STRIP_ROWS	16 // Number of converted rows gathered before each transfer to a framebuffer or window
+#define PNG_ULTIBO_READ_BUFFER_SIZE	SIZE_16K // Size of the file read buffer (Bytes)
+#define PNG_ULTIBO_DEFAULT_BUDGET	SIZE_8M // Default memory budget for the decoded images of a PNG cache (Bytes)
+
+/* PNG Flags */
+#define PNG_ULTIBO_FLAG_NONE	0x00000000
+#define PNG_ULTIBO_FLAG_BACKGROUND	0x00000001 // Composite transparent pixels over the background color (Otherwise alpha is kept for formats with alpha and discarded for others)
+
+/* ============================================================================== */
+/* PNG Port specific types */
+
+/* PNG Information */
+typedef struct _PNG_ULTIBO_INFO PNG_ULTIBO_INFO;
+struct _PNG_ULTIBO_INFO
+{
+	uint32_t width; // Image width (Pixels)
+	uint32_t height; // Image height (Pixels)
+	uint32_t bitdepth; // Bits per channel (1, 2, 4, 8 or 16)
+	uint32_t colortype; // PNG color type (eg PNG_COLOR_TYPE_RGB_ALPHA)
+	BOOL interlaced; // Image is Adam7 interlaced (Decoded as a whole image instead of row by row)
+};
+
+/* PNG Decode Options (All zero for the natural size with no extra clipping) */
+typedef struct _PNG_ULTIBO_OPTIONS PNG_ULTIBO_OPTIONS;
+struct _PNG_ULTIBO_OPTIONS
+{
+	uint32_t flags; // PNG flags (eg PNG_ULTIBO_FLAG_BACKGROUND)
+	uint32_t width; // Width to scale the image to (Pixels, 0 for the image width or to keep the aspect ratio when only height is given)
+	uint32_t height; // Height to scale the image to (Pixels, 0 for the image height or to keep the aspect ratio when only width is given)
+	uint32_t backcolor; // Background color for PNG_ULTIBO_FLAG_BACKGROUND (COLOR_FORMAT_DEFAULT eg COLOR_BLACK)
+	int32_t clipleft; // Clip rectangle in destination coordinates (Pixels, all zero for no clipping inside the destination)
+	int32_t cliptop;
+	int32_t clipright; // Right and bottom are exclusive
+	int32_t clipbottom;
+	uint32_t memoryused; // Peak memory used by the decode including libpng (Bytes, returned by the decode functions)
+};
+
+/* PNG Image (A decoded image held in a PNG cache) */
+typedef struct _PNG_ULTIBO_IMAGE PNG_ULTIBO_IMAGE;
+struct _PNG_ULTIBO_IMAGE
+{
+	uint32_t width; // Width of the decoded image (Pixels)
+	uint32_t height; // Height of the decoded image (Pixels)
+	uint32_t format; // Color format of the decoded image (eg COLOR_FORMAT_RGB16)
+	uint32_t pitch; // Bytes per row of the decoded image
+	void *data; // Decoded pixels
+};
+
+/* PNG Cache Statistics */
+typedef struct _PNG_ULTIBO_STATISTICS PNG_ULTIBO_STATISTICS;
+struct _PNG_ULTIBO_STATISTICS
+{
+	uint32_t imagecount; // Number of images in the cache
+	uint32_t memorybudget; // Memory budget of the cache (Bytes)
+	uint32_t memoryused; // Memory currently used by decoded images (Bytes)
+	uint32_t hitcount; // Number of loads found in the cache
+	uint32_t misscount; // Number of loads decoded from file
+	uint32_t evictcount; // Number of images discarded to stay within the budget
+	uint32_t errorcount; // Number of loads that failed to decode
+};
+
+/* PNG Cache */
+typedef struct _PNG_ULTIBO_CACHE PNG_ULTIBO_CACHE;
+
+/* ============================================================================== */
+/* PNG Decode Functions */
+uint32_t STDCALL png_ultibo_get_info(const char *filename, PNG_ULTIBO_INFO *info);
+
+uint32_t STDCALL png_ultibo_framebuffer_draw(FRAMEBUFFER_DEVICE *framebuffer, const char *filename, int32_t x, int32_t y, PNG_ULTIBO_OPTIONS *options); // Options may be NULL
+uint32_t STDCALL png_ultibo_graphics_window_draw(WINDOW_HANDLE handle, const char *filename, int32_t x, int32_t y, PNG_ULTIBO_OPTIONS *options); // Options may be NULL
+uint32_t STDCALL png_ultibo_decode(const char *filename, void *buffer, uint32_t width, uint32_t height, uint32_t pitch, uint32_t format, int32_t x, int32_t y, PNG_ULTIBO_OPTIONS *options); // Buffer is width x height pixels of format with pitch bytes per row
+
+/* ============================================================================== */
+/* PNG Cache Functions */
+PNG_ULTIBO_CACHE * STDCALL png_ultibo_cache_create(uint32_t budget);
+uint32_t STDCALL png_ultibo_cache_destroy(PNG_ULTIBO_CACHE *cache);
+
+uint32_t STDCALL png_ultibo_cache_flush(PNG_ULTIBO_CACHE *cache); // Discard all images not currently loaded
+
+uint32_t STDCALL png_ultibo_cache_get_statistics(PNG_ULTIBO_CACHE *cache, PNG_ULTIBO_STATISTICS *statistics);
+uint32_t STDCALL png_ultibo_cache_reset_statistics(PNG_ULTIBO_CACHE *cache);
+
+PNG_ULTIBO_IMAGE * STDCALL png_ultibo_image_load(PNG_ULTIBO_CACHE *cache, const char *filename, uint32_t format, PNG_ULTIBO_OPTIONS *options); // Options may be NULL, clipping is ignored
+uint32_t STDCALL png_ultibo_image_release(PNG_ULTIBO_CACHE *cache, PNG_ULTIBO_IMAGE *image);
+
+uint32_t STDCALL png_ultibo_image_draw(FRAMEBUFFER_DEVICE *framebuffer, PNG_ULTIBO_IMAGE *image, int32_t x, int32_t y); // Image format must match the framebuffer format
+
+/* ============================================================================== */
+/* PNG Helper Functions */
+uint32_t STDCALL png_ultibo_format_bytes(uint32_t format); // Bytes per pixel of a supported color format (0 if the format is not supported)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _PNG_PORT_ULTIBO_H
@@ -0,0 +1,2034 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "ultibo/winsock2.h" // Must be included before any header that includes sys/types.h
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/filesystem.h"
+#include "ultibo/spi.h"
+#include "ultibo/i2c.h"
+
+#include "lua_port_ultibo.h"
+
+/*
+ * Implementation of the Ultibo API bindings port for Lua 5.4
+ *
+ * The bindings are registered as a global table (ultibo) with a subtable for each
+ * group of functions (gpio, spi, i2c, console, file, socket and buffer). Each binding
+ * follows the C function it wraps, taking the same parameters in the same order and
+ * returning the same result followed by any output parameters. Devices are passed as
+ * light userdata (nil selects the default device) and handles and sockets as integers.
+ * The GPIO functions all take and return plain integers so their wrappers are generated
+ * by the LUA_ULTIBO_BIND macros from a single list.
+ *
+ * Data is passed to and from the I/O functions without copying through an Ultibo
+ * buffer, a userdata whose memory is handed directly to the device, file or socket.
+ * A buffer may either own its memory or be a view of memory owned by C code, and
+ * anywhere a buffer is accepted a light userdata pointer followed by a size may be
+ * passed instead so C code can give a script a pointer to a DMA buffer or a packet
+ * without allocating anything. Functions that only read data also accept a string,
+ * and file.read and socket.recv still return a string when passed a count instead of
+ * a buffer for scripts that prefer it.
+ *
+ * An arena supplies all memory for one state through lua_ultibo_arena_alloc. Blocks
+ * up to LUA_ULTIBO_ARENA_SMALL_MAX bytes are rounded to a multiple of 16 and carved
+ * from large chunks, with a free list per size so most allocations by the interpreter
+ * are a pointer pop with no heap lock. Larger blocks come from the heap. Because Lua
+ * passes the size of every block it frees no header is needed on any block. An arena
+ * is only ever used by the thread running its state so it has no lock, and the memory
+ * limit causes Lua to collect garbage and then raise a memory error instead of using
+ * the whole heap.
+ *
+ * A pool keeps states that are already created and initialized with a script so a
+ * handler can be run without paying for state creation, which takes far longer than
+ * a typical handler. Each state belongs to one CPU and acquiring a state takes one
+ * belonging to the current CPU, so the state and its arena are normally still in the
+ * caches of that CPU from the last time they were used. A pointer to the pool entry
+ * is kept in the extra space of each state (lua_getextraspace) to find it on release.
+ */
+
+/* ============================================================================== */
+/* Lua Ultibo specific constants */
+#define LUA_ULTIBO_ARENA_SIGNATURE	0x4C415245
+#define LUA_ULTIBO_POOL_SIGNATURE	0x4C504F4C
+
+#define LUA_ULTIBO_ARENA_CLASSES	(LUA_ULTIBO_ARENA_SMALL_MAX / LUA_ULTIBO_ARENA_GRANULE) // Number of small block sizes
+#define LUA_ULTIBO_ARENA_CHUNK_MIN	SIZE_4K // Smallest chunk size accepted
+
+/* ============================================================================== */
+/* Lua Ultibo specific types */
+/* Lua Constant (Name and value registered in a binding table) */
+typedef struct _LUA_ULTIBO_CONSTANT LUA_ULTIBO_CONSTANT;
+struct _LUA_ULTIBO_CONSTANT
+{
+	const char *name;
+	lua_Integer value;
+};
+
+/* Lua Arena Chunk (Header at the start of each chunk) */
+typedef struct _LUA_ULTIBO_ARENA_CHUNK LUA_ULTIBO_ARENA_CHUNK;
+struct _LUA_ULTIBO_ARENA_CHUNK
+{
+	LUA_ULTIBO_ARENA_CHUNK *next; // Next chunk in the arena
+	uint32_t size; // Size of the chunk including this header
+};
+
+/* Lua Arena */
+struct _LUA_ULTIBO_ARENA
+{
+	uint32_t signature; // Signature for entry validation
+	uint32_t chunksize; // Size of each chunk
+	uint32_t limit; // Limit on memory allocated to Lua
+	LUA_ULTIBO_ARENA_CHUNK *chunks; // List of chunks
+	uint8_t *next; // Next unused byte in the current chunk
+	uint8_t *end; // End of the current chunk
+	void *free[LUA_ULTIBO_ARENA_CLASSES]; // Free list for each small block size (First word of each free block is the next block)
+	LUA_ULTIBO_ARENA_STATISTICS statistics;
+};
+
+/* Lua Pool Entry (One state) */
+typedef struct _LUA_ULTIBO_POOL_ENTRY LUA_ULTIBO_POOL_ENTRY;
+struct _LUA_ULTIBO_POOL_ENTRY
+{
+	LUA_ULTIBO_POOL *pool; // Pool owning this entry
+	lua_State *state; // Lua state
+	LUA_ULTIBO_ARENA *arena; // Arena of the state
+	uint32_t cpu; // CPU the state belongs to
+	BOOL acquired; // State is currently acquired
+	LUA_ULTIBO_POOL_ENTRY *next; // Next available entry of the same CPU
+	LUA_ULTIBO_POOL_ENTRY *link; // Next entry in the pool
+};
+
+/* Lua Pool CPU (States belonging to one CPU) */
+typedef struct _LUA_ULTIBO_POOL_CPU LUA_ULTIBO_POOL_CPU;
+struct _LUA_ULTIBO_POOL_CPU
+{
+	SPIN_HANDLE lock; // Lock protecting this CPU (Only held to add or remove an entry)
+	LUA_ULTIBO_POOL_ENTRY *available; // List of available entries
+	uint32_t count; // Number of states belonging to this CPU (Including those in use)
+};
+
+/* Lua Pool */
+struct _LUA_ULTIBO_POOL
+{
+	uint32_t signature; // Signature for entry validation
+	LUA_ULTIBO_POOL_CONFIG config; // Configuration after defaults are applied
+	char *script; // Copy of the initialization script
+	char *name; // Copy of the script chunk name
+	uint32_t cpucount; // Number of CPUs
+	LUA_ULTIBO_POOL_CPU *cpus; // State lists for each CPU
+	MUTEX_HANDLE lock; // Pool lock (Protects the entry list)
+	LUA_ULTIBO_POOL_ENTRY *entries; // List of all entries
+	uint64_t createtotal; // Total time taken to create states (Microseconds)
+	LUA_ULTIBO_POOL_STATISTICS statistics;
+};
+
+/* ============================================================================== */
+/* Lua Binding Internal Functions */
+static inline uint32_t lua_ultibo_u32(lua_State *L, int arg)
+{
+	return (uint32_t)luaL_checkinteger(L, arg);
+}
+
+static inline uint32_t lua_ultibo_optu32(lua_State *L, int arg, uint32_t value)
+{
+	return (uint32_t)luaL_optinteger(L, arg, value);
+}
+
+static inline HANDLE lua_ultibo_handle(lua_State *L, int arg)
+{
+	return (HANDLE)luaL_checkinteger(L, arg);
+}
+
+static void lua_ultibo_push_handle(lua_State *L, HANDLE handle)
+{
+	if (handle == INVALID_HANDLE_VALUE)
+		lua_pushnil(L);
+	else
+		lua_pushinteger(L, (lua_Integer)handle);
+}
+
+/* Return the device at arg, or the default device if arg is nil or absent */
+static void *lua_ultibo_device(lua_State *L, int arg, void *device)
+{
+	if (lua_isnoneornil(L, arg))
+	{
+		if (!device)
+			luaL_argerror(L, arg, "no default device");
+
+		return device;
+	}
+
+	luaL_checktype(L, arg, LUA_TLIGHTUSERDATA);
+
+	return lua_touserdata(L, arg);
+}
+
+static void lua_ultibo_push_device(lua_State *L, void *device)
+{
+	if (device)
+		lua_pushlightuserdata(L, device);
+	else
+		lua_pushnil(L);
+}
+
+/* Convert a string.sub style range (1 based, negative from the end) to a start and count */
+static uint32_t lua_ultibo_range(lua_State *L, int arg, uint32_t size, uint32_t *count)
+{
+	lua_Integer first;
+	lua_Integer last;
+
+	first = luaL_optinteger(L, arg, 1);
+	last = luaL_optinteger(L, arg + 1, -1);
+
+	if (first < 0)
+		first = (-first > (lua_Integer)size) ? 1 : (lua_Integer)size + first + 1;
+	else if (first == 0)
+		first = 1;
+
+	if (last < 0)
+		last = (lua_Integer)size + last + 1;
+	else if (last > (lua_Integer)size)
+		last = size;
+
+	*count = (first > last) ? 0 : (uint32_t)(last - first + 1);
+
+	return (uint32_t)(first - 1);
+}
+
+/*
+ * Get the data for an I/O function starting at *arg and advance *arg past it
+ *
+ * Accepts a buffer, or a light userdata followed by the size, or a string if the data
+ * is only read. A buffer or string may be followed by a count to use only the start
+ * of it (nil skips the count).
+ */
+static uint8_t *lua_ultibo_data(lua_State *L, int *arg, uint32_t *size, BOOL readonly)
+{
+	uint8_t *data;
+	uint32_t length;
+	size_t len;
+	lua_Integer count;
+
+	data = lua_ultibo_buffer_check(L, *arg, &length);
+	if (!data)
+	{
+		if (lua_islightuserdata(L, *arg))
+		{
+			data = lua_touserdata(L, *arg);
+			(*arg)++;
+
+			count = luaL_checkinteger(L, *arg);
+			luaL_argcheck(L, count >= 0 && count <= 0xFFFFFFFF, *arg, "size out of range");
+			(*arg)++;
+
+			*size = (uint32_t)count;
+			return data;
+		}
+
+		if (!readonly || lua_type(L, *arg) != LUA_TSTRING)
+			luaL_typeerror(L, *arg, readonly ? LUA_ULTIBO_BUFFER_TYPE " or string" : LUA_ULTIBO_BUFFER_TYPE);
+
+		data = (uint8_t *)lua_tolstring(L, *arg, &len);
+		length = (uint32_t)len;
+	}
+	(*arg)++;
+
+	if (lua_type(L, *arg) == LUA_TNUMBER)
+	{
+		count = luaL_checkinteger(L, *arg);
+		luaL_argcheck(L, count >= 0 && count <= length, *arg, "count out of range");
+		length = (uint32_t)count;
+		(*arg)++;
+	}
+	else if (lua_isnil(L, *arg))
+	{
+		(*arg)++;
+	}
+
+	*size = length;
+	return data;
+}
+
+static void lua_ultibo_constants(lua_State *L, const LUA_ULTIBO_CONSTANT *constants)
+{
+	for (; constants->name; constants++)
+	{
+		lua_pushinteger(L, constants->value);
+		lua_setfield(L, -2, constants->name);
+	}
+}
+
+/* ============================================================================== */
+/* Lua Binding Generators */
+#define LUA_ULTIBO_ARGS_1	lua_ultibo_u32(L, 1)
+#define LUA_ULTIBO_ARGS_2	LUA_ULTIBO_ARGS_1, lua_ultibo_u32(L, 2)
+#define LUA_ULTIBO_ARGS_3	LUA_ULTIBO_ARGS_2, lua_ultibo_u32(L, 3)
+
+/* Wrapper for a function taking and returning uint32_t values */
+#define LUA_ULTIBO_BIND(group, name, args) \
+	static int lua_ultibo_##group##_##name(lua_State *L) \
+	{ \
+		lua_pushinteger(L, group##_##name(LUA_ULTIBO_ARGS_##args)); \
+		return 1; \
+	}
+
+/* Registration entry for a generated wrapper */
+#define LUA_ULTIBO_ENTRY(group, name, args)	{#name, lua_ultibo_##group##_##name},
+
+#define LUA_ULTIBO_GPIO_FUNCTIONS(X) \
+	X(gpio, input_get, 1) \
+	X(gpio, input_wait, 3) \
+	X(gpio, output_set, 2) \
+	X(gpio, level_get, 1) \
+	X(gpio, level_set, 2) \
+	X(gpio, pull_get, 1) \
+	X(gpio, pull_select, 2) \
+	X(gpio, function_get, 1) \
+	X(gpio, function_select, 2)
+
+LUA_ULTIBO_GPIO_FUNCTIONS(LUA_ULTIBO_BIND)
+
+/* ============================================================================== */
+/* Lua GPIO Bindings */
+static const luaL_Reg lua_ultibo_gpio_functions[] =
+{
+	LUA_ULTIBO_GPIO_FUNCTIONS(LUA_ULTIBO_ENTRY)
+	{NULL, NULL}
+};
+
+static const LUA_ULTIBO_CONSTANT lua_ultibo_gpio_constants[] =
+{
+	{"LEVEL_LOW", GPIO_LEVEL_LOW},
+	{"LEVEL_HIGH", GPIO_LEVEL_HIGH},
+	{"LEVEL_UNKNOWN", GPIO_LEVEL_UNKNOWN},
+	{"PULL_NONE", GPIO_PULL_NONE},
+	{"PULL_UP", GPIO_PULL_UP},
+	{"PULL_DOWN", GPIO_PULL_DOWN},
+	{"FUNCTION_IN", GPIO_FUNCTION_IN},
+	{"FUNCTION_OUT", GPIO_FUNCTION_OUT},
+	{"FUNCTION_ALT0", GPIO_FUNCTION_ALT0},
+	{"TRIGGER_NONE", GPIO_TRIGGER_NONE},
+	{"TRIGGER_LOW", GPIO_TRIGGER_LOW},
+	{"TRIGGER_HIGH", GPIO_TRIGGER_HIGH},
+	{"TRIGGER_RISING", GPIO_TRIGGER_RISING},
+	{"TRIGGER_FALLING", GPIO_TRIGGER_FALLING},
+	{"TRIGGER_EDGE", GPIO_TRIGGER_EDGE},
+	{NULL, 0}
+};
+
+/* ============================================================================== */
+/* Lua SPI Bindings */
+static int lua_ultibo_spi_default(lua_State *L)
+{
+	lua_ultibo_push_device(L, spi_device_get_default());
+	return 1;
+}
+
+static int lua_ultibo_spi_find(lua_State *L)
+{
+	lua_ultibo_push_device(L, spi_device_find_by_name(luaL_checkstring(L, 1)));
+	return 1;
+}
+
+static int lua_ultibo_spi_start(lua_State *L)
+{
+	SPI_DEVICE *spi = lua_ultibo_device(L, 1, spi_device_get_default());
+
+	lua_pushinteger(L, spi_device_start(spi, lua_ultibo_u32(L, 2), lua_ultibo_u32(L, 3), lua_ultibo_u32(L, 4), lua_ultibo_u32(L, 5)));
+	return 1;
+}
+
+static int lua_ultibo_spi_stop(lua_State *L)
+{
+	lua_pushinteger(L, spi_device_stop(lua_ultibo_device(L, 1, spi_device_get_default())));
+	return 1;
+}
+
+/* spi.read(device, chipselect, buffer [, count [, flags]]) returns status, count */
+static int lua_ultibo_spi_read(lua_State *L)
+{
+	SPI_DEVICE *spi = lua_ultibo_device(L, 1, spi_device_get_default());
+	uint16_t chipselect = (uint16_t)lua_ultibo_u32(L, 2);
+	uint32_t count = 0;
+	uint32_t size;
+	uint8_t *data;
+	int arg = 3;
+
+	data = lua_ultibo_data(L, &arg, &size, FALSE);
+
+	lua_pushinteger(L, spi_device_read(spi, chipselect, data, size, lua_ultibo_optu32(L, arg, SPI_TRANSFER_NONE), &count));
+	lua_pushinteger(L, count);
+	return 2;
+}
+
+/* spi.write(device, chipselect, data [, count [, flags]]) returns status, count */
+static int lua_ultibo_spi_write(lua_State *L)
+{
+	SPI_DEVICE *spi = lua_ultibo_device(L, 1, spi_device_get_default());
+	uint16_t chipselect = (uint16_t)lua_ultibo_u32(L, 2);
+	uint32_t count = 0;
+	uint32_t size;
+	uint8_t *data;
+	int arg = 3;
+
+	data = lua_ultibo_data(L, &arg, &size, TRUE);
+
+	lua_pushinteger(L, spi_device_write(spi, chipselect, data, size, lua_ultibo_optu32(L, arg, SPI_TRANSFER_NONE), &count));
+	lua_pushinteger(L, count);
+	return 2;
+}
+
+/* spi.write_read(device, chipselect, source [, count], dest [, count] [, flags]) returns status, count */
+static int lua_ultibo_spi_write_read(lua_State *L)
+{
+	SPI_DEVICE *spi = lua_ultibo_device(L, 1, spi_device_get_default());
+	uint16_t chipselect = (uint16_t)lua_ultibo_u32(L, 2);
+	uint32_t count = 0;
+	uint32_t size;
+	uint32_t destsize;
+	uint8_t *source;
+	uint8_t *dest;
+	int arg = 3;
+
+	source = lua_ultibo_data(L, &arg, &size, TRUE);
+	dest = lua_ultibo_data(L, &arg, &destsize, FALSE);
+	luaL_argcheck(L, destsize >= size, arg - 1, "destination smaller than source");
+
+	lua_pushinteger(L, spi_device_write_read(spi, chipselect, source, dest, size, lua_ultibo_optu32(L, arg, SPI_TRANSFER_NONE), &count));
+	lua_pushinteger(L, count);
+	return 2;
+}
+
+static int lua_ultibo_spi_set_clock_rate(lua_State *L)
+{
+	SPI_DEVICE *spi = lua_ultibo_device(L, 1, spi_device_get_default());
+
+	lua_pushinteger(L, spi_device_set_clock_rate(spi, (uint16_t)lua_ultibo_u32(L, 2), lua_ultibo_u32(L, 3)));
+	return 1;
+}
+
+static const luaL_Reg lua_ultibo_spi_functions[] =
+{
+	{"default", lua_ultibo_spi_default},
+	{"find", lua_ultibo_spi_find},
+	{"start", lua_ultibo_spi_start},
+	{"stop", lua_ultibo_spi_stop},
+	{"read", lua_ultibo_spi_read},
+	{"write", lua_ultibo_spi_write},
+	{"write_read", lua_ultibo_spi_write_read},
+	{"set_clock_rate", lua_ultibo_spi_set_clock_rate},
+	{NULL, NULL}
+};
+
+static const LUA_ULTIBO_CONSTANT lua_ultibo_spi_constants[] =
+{
+	{"MODE_4WIRE", SPI_MODE_4WIRE},
+	{"MODE_3WIRE", SPI_MODE_3WIRE},
+	{"MODE_LOSSI", SPI_MODE_LOSSI},
+	{"CS_0", SPI_CS_0},
+	{"CS_1", SPI_CS_1},
+	{"CS_2", SPI_CS_2},
+	{"CS_3", SPI_CS_3},
+	{"CLOCK_PHASE_LOW", SPI_CLOCK_PHASE_LOW},
+	{"CLOCK_PHASE_HIGH", SPI_CLOCK_PHASE_HIGH},
+	{"CLOCK_POLARITY_LOW", SPI_CLOCK_POLARITY_LOW},
+	{"CLOCK_POLARITY_HIGH", SPI_CLOCK_POLARITY_HIGH},
+	{"TRANSFER_NONE", SPI_TRANSFER_NONE},
+	{"TRANSFER_DMA", SPI_TRANSFER_DMA},
+	{"TRANSFER_PIO", SPI_TRANSFER_PIO},
+	{"TRANSFER_DELAY", SPI_TRANSFER_DELAY},
+	{NULL, 0}
+};
+
+/* ============================================================================== */
+/* Lua I2C Bindings */
+static int lua_ultibo_i2c_default(lua_State *L)
+{
+	lua_ultibo_push_device(L, i2c_device_get_default());
+	return 1;
+}
+
+static int lua_ultibo_i2c_find(lua_State *L)
+{
+	lua_ultibo_push_device(L, i2c_device_find_by_name(luaL_checkstring(L, 1)));
+	return 1;
+}
+
+static int lua_ultibo_i2c_start(lua_State *L)
+{
+	I2C_DEVICE *i2c = lua_ultibo_device(L, 1, i2c_device_get_default());
+
+	lua_pushinteger(L, i2c_device_start(i2c, lua_ultibo_u32(L, 2)));
+	return 1;
+}
+
+static int lua_ultibo_i2c_stop(lua_State *L)
+{
+	lua_pushinteger(L, i2c_device_stop(lua_ultibo_device(L, 1, i2c_device_get_default())));
+	return 1;
+}
+
+/* i2c.read(device, address, buffer [, count]) returns status, count */
+static int lua_ultibo_i2c_read(lua_State *L)
+{
+	I2C_DEVICE *i2c = lua_ultibo_device(L, 1, i2c_device_get_default());
+	uint16_t address = (uint16_t)lua_ultibo_u32(L, 2);
+	uint32_t count = 0;
+	uint32_t size;
+	uint8_t *data;
+	int arg = 3;
+
+	data = lua_ultibo_data(L, &arg, &size, FALSE);
+
+	lua_pushinteger(L, i2c_device_read(i2c, address, data, size, &count));
+	lua_pushinteger(L, count);
+	return 2;
+}
+
+/* i2c.write(device, address, data [, count]) returns status, count */
+static int lua_ultibo_i2c_write(lua_State *L)
+{
+	I2C_DEVICE *i2c = lua_ultibo_device(L, 1, i2c_device_get_default());
+	uint16_t address = (uint16_t)lua_ultibo_u32(L, 2);
+	uint32_t count = 0;
+	uint32_t size;
+	uint8_t *data;
+	int arg = 3;
+
+	data = lua_ultibo_data(L, &arg, &size, TRUE);
+
+	lua_pushinteger(L, i2c_device_write(i2c, address, data, size, &count));
+	lua_pushinteger(L, count);
+	return 2;
+}
+
+/* i2c.write_read(device, address, initial [, count], buffer [, count]) returns status, count */
+static int lua_ultibo_i2c_write_read(lua_State *L)
+{
+	I2C_DEVICE *i2c = lua_ultibo_device(L, 1, i2c_device_get_default());
+	uint16_t address = (uint16_t)lua_ultibo_u32(L, 2);
+	uint32_t count = 0;
+	uint32_t initialsize;
+	uint32_t size;
+	uint8_t *initial;
+	uint8_t *data;
+	int arg = 3;
+
+	initial = lua_ultibo_data(L, &arg, &initialsize, TRUE);
+	data = lua_ultibo_data(L, &arg, &size, FALSE);
+
+	lua_pushinteger(L, i2c_device_write_read(i2c, address, initial, initialsize, data, size, &count));
+	lua_pushinteger(L, count);
+	return 2;
+}
+
+static const luaL_Reg lua_ultibo_i2c_functions[] =
+{
+	{"default", lua_ultibo_i2c_default},
+	{"find", lua_ultibo_i2c_find},
+	{"start", lua_ultibo_i2c_start},
+	{"stop", lua_ultibo_i2c_stop},
+	{"read", lua_ultibo_i2c_read},
+	{"write", lua_ultibo_i2c_write},
+	{"write_read", lua_ultibo_i2c_write_read},
+	{NULL, NULL}
+};
+
+/* ============================================================================== */
+/* Lua Console Bindings */
+/* Return the console window at arg, or the default window if arg is nil or absent */
+static WINDOW_HANDLE lua_ultibo_window(lua_State *L, int arg)
+{
+	WINDOW_HANDLE handle;
+
+	if (!lua_isnoneornil(L, arg))
+		return lua_ultibo_handle(L, arg);
+
+	handle = console_window_get_default(console_device_get_default());
+	if (handle == INVALID_HANDLE_VALUE)
+		luaL_argerror(L, arg, "no default console window");
+
+	return handle;
+}
+
+static int lua_ultibo_console_window_create(lua_State *L)
+{
+	lua_ultibo_push_handle(L, console_window_create(console_device_get_default(), lua_ultibo_optu32(L, 1, CONSOLE_POSITION_FULL), lua_toboolean(L, 2)));
+	return 1;
+}
+
+static int lua_ultibo_console_window_destroy(lua_State *L)
+{
+	lua_pushinteger(L, console_window_destroy(lua_ultibo_handle(L, 1)));
+	return 1;
+}
+
+static int lua_ultibo_console_write(lua_State *L)
+{
+	WINDOW_HANDLE handle = lua_ultibo_window(L, 1);
+
+	lua_pushinteger(L, console_window_write(handle, luaL_checkstring(L, 2)));
+	return 1;
+}
+
+static int lua_ultibo_console_write_ln(lua_State *L)
+{
+	WINDOW_HANDLE handle = lua_ultibo_window(L, 1);
+
+	lua_pushinteger(L, console_window_write_ln(handle, luaL_optstring(L, 2, "")));
+	return 1;
+}
+
+static int lua_ultibo_console_clear(lua_State *L)
+{
+	lua_pushinteger(L, console_window_clear(lua_ultibo_window(L, 1)));
+	return 1;
+}
+
+static int lua_ultibo_console_set_xy(lua_State *L)
+{
+	WINDOW_HANDLE handle = lua_ultibo_window(L, 1);
+
+	lua_pushinteger(L, console_window_set_xy(handle, lua_ultibo_u32(L, 2), lua_ultibo_u32(L, 3)));
+	return 1;
+}
+
+static const luaL_Reg lua_ultibo_console_functions[] =
+{
+	{"window_create", lua_ultibo_console_window_create},
+	{"window_destroy", lua_ultibo_console_window_destroy},
+	{"write", lua_ultibo_console_write},
+	{"write_ln", lua_ultibo_console_write_ln},
+	{"clear", lua_ultibo_console_clear},
+	{"set_xy", lua_ultibo_console_set_xy},
+	{NULL, NULL}
+};
+
+static const LUA_ULTIBO_CONSTANT lua_ultibo_console_constants[] =
+{
+	{"POSITION_FULL", CONSOLE_POSITION_FULL},
+	{"POSITION_TOP", CONSOLE_POSITION_TOP},
+	{"POSITION_BOTTOM", CONSOLE_POSITION_BOTTOM},
+	{"POSITION_LEFT", CONSOLE_POSITION_LEFT},
+	{"POSITION_RIGHT", CONSOLE_POSITION_RIGHT},
+	{"POSITION_TOPLEFT", CONSOLE_POSITION_TOPLEFT},
+	{"POSITION_TOPRIGHT", CONSOLE_POSITION_TOPRIGHT},
+	{"POSITION_BOTTOMLEFT", CONSOLE_POSITION_BOTTOMLEFT},
+	{"POSITION_BOTTOMRIGHT", CONSOLE_POSITION_BOTTOMRIGHT},
+	{NULL, 0}
+};
+
+/* ============================================================================== */
+/* Lua File Bindings */
+static int lua_ultibo_file_open(lua_State *L)
+{
+	lua_ultibo_push_handle(L, FileOpen(luaL_checkstring(L, 1), (int)luaL_optinteger(L, 2, fmOpenRead | fmShareDenyNone)));
+	return 1;
+}
+
+static int lua_ultibo_file_create(lua_State *L)
+{
+	lua_ultibo_push_handle(L, FileCreate(luaL_checkstring(L, 1)));
+	return 1;
+}
+
+static int lua_ultibo_file_close(lua_State *L)
+{
+	FileClose(lua_ultibo_handle(L, 1));
+	return 0;
+}
+
+/* file.read(handle, buffer [, count]) returns the count read, file.read(handle, count) returns a string */
+static int lua_ultibo_file_read(lua_State *L)
+{
+	HANDLE handle = lua_ultibo_handle(L, 1);
+	luaL_Buffer buffer;
+	lua_Integer count;
+	uint32_t size;
+	uint8_t *data;
+	int32_t result;
+	int arg = 2;
+
+	if (lua_type(L, arg) == LUA_TNUMBER)
+	{
+		count = luaL_checkinteger(L, arg);
+		luaL_argcheck(L, count >= 0 && count <= 0x7FFFFFFF, arg, "count out of range");
+
+		data = (uint8_t *)luaL_buffinitsize(L, &buffer, (size_t)count);
+		result = FileRead(handle, data, (int32_t)count);
+		if (result < 0)
+		{
+			lua_pushnil(L);
+			return 1;
+		}
+
+		luaL_pushresultsize(&buffer, result);
+		return 1;
+	}
+
+	data = lua_ultibo_data(L, &arg, &size, FALSE);
+
+	lua_pushinteger(L, FileRead(handle, data, (int32_t)size));
+	return 1;
+}
+
+/* file.write(handle, data [, count]) returns the count written */
+static int lua_ultibo_file_write(lua_State *L)
+{
+	HANDLE handle = lua_ultibo_handle(L, 1);
+	uint32_t size;
+	uint8_t *data;
+	int arg = 2;
+
+	data = lua_ultibo_data(L, &arg, &size, TRUE);
+
+	lua_pushinteger(L, FileWrite(handle, data, (int32_t)size));
+	return 1;
+}
+
+static int lua_ultibo_file_seek(lua_State *L)
+{
+	HANDLE handle = lua_ultibo_handle(L, 1);
+
+	lua_pushinteger(L, FileSeekEx(handle, luaL_checkinteger(L, 2), (int32_t)luaL_optinteger(L, 3, FILE_BEGIN)));
+	return 1;
+}
+
+static int lua_ultibo_file_size(lua_State *L)
+{
+	lua_pushinteger(L, FileSize(lua_ultibo_handle(L, 1)));
+	return 1;
+}
+
+static const luaL_Reg lua_ultibo_file_functions[] =
+{
+	{"open", lua_ultibo_file_open},
+	{"create", lua_ultibo_file_create},
+	{"close", lua_ultibo_file_close},
+	{"read", lua_ultibo_file_read},
+	{"write", lua_ultibo_file_write},
+	{"seek", lua_ultibo_file_seek},
+	{"size", lua_ultibo_file_size},
+	{NULL, NULL}
+};
+
+static const LUA_ULTIBO_CONSTANT lua_ultibo_file_constants[] =
+{
+	{"OPEN_READ", fmOpenRead},
+	{"OPEN_WRITE", fmOpenWrite},
+	{"OPEN_READ_WRITE", fmOpenReadWrite},
+	{"SHARE_DENY_NONE", fmShareDenyNone},
+	{"SEEK_BEGIN", 0},
+	{"SEEK_CURRENT", 1},
+	{"SEEK_END", 2},
+	{NULL, 0}
+};
+
+/* ============================================================================== */
+/* Lua Socket Bindings */
+static inline SOCKET lua_ultibo_socket(lua_State *L, int arg)
+{
+	return (SOCKET)luaL_checkinteger(L, arg);
+}
+
+static void lua_ultibo_push_socket(lua_State *L, SOCKET s)
+{
+	if (s == INVALID_SOCKET)
+		lua_pushnil(L);
+	else
+		lua_pushinteger(L, (lua_Integer)s);
+}
+
+/* Fill an IPv4 address from a dotted address (nil for any address) and a port */
+static void lua_ultibo_address(lua_State *L, int arg, sockaddr_in *address)
+{
+	memset(address, 0, sizeof(sockaddr_in));
+
+	address->sin_family = AF_INET;
+	if (!lua_isnoneornil(L, arg))
+	{
+		if (inet_pton(AF_INET, luaL_checkstring(L, arg), &address->sin_addr) != 1)
+			luaL_argerror(L, arg, "invalid address");
+	}
+	address->sin_port = htons((u_short)luaL_checkinteger(L, arg + 1));
+}
+
+static int lua_ultibo_push_address(lua_State *L, sockaddr_in *address)
+{
+	lua_pushstring(L, inet_ntoa(address->sin_addr));
+	lua_pushinteger(L, ntohs(address->sin_port));
+	return 2;
+}
+
+static int lua_ultibo_socket_tcp(lua_State *L)
+{
+	lua_ultibo_push_socket(L, socket(AF_INET, SOCK_STREAM, IPPROTO_TCP));
+	return 1;
+}
+
+static int lua_ultibo_socket_udp(lua_State *L)
+{
+	lua_ultibo_push_socket(L, socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+	return 1;
+}
+
+static int lua_ultibo_socket_close(lua_State *L)
+{
+	lua_pushinteger(L, closesocket(lua_ultibo_socket(L, 1)));
+	return 1;
+}
+
+/* socket.connect(socket, address, port) */
+static int lua_ultibo_socket_connect(lua_State *L)
+{
+	sockaddr_in address;
+
+	lua_ultibo_address(L, 2, &address);
+
+	lua_pushinteger(L, connect(lua_ultibo_socket(L, 1), (SOCKADDR *)&address, sizeof(sockaddr_in)));
+	return 1;
+}
+
+/* socket.bind(socket, address, port) with nil address for any */
+static int lua_ultibo_socket_bind(lua_State *L)
+{
+	sockaddr_in address;
+
+	lua_ultibo_address(L, 2, &address);
+
+	lua_pushinteger(L, bind(lua_ultibo_socket(L, 1), (SOCKADDR *)&address, sizeof(sockaddr_in)));
+	return 1;
+}
+
+static int lua_ultibo_socket_listen(lua_State *L)
+{
+	lua_pushinteger(L, listen(lua_ultibo_socket(L, 1), (int32_t)luaL_optinteger(L, 2, SOMAXCONN)));
+	return 1;
+}
+
+/* socket.accept(socket) returns socket, address, port */
+static int lua_ultibo_socket_accept(lua_State *L)
+{
+	sockaddr_in address;
+	int32_t length = sizeof(sockaddr_in);
+	SOCKET s;
+
+	s = accept(lua_ultibo_socket(L, 1), (SOCKADDR *)&address, &length);
+	lua_ultibo_push_socket(L, s);
+	if (s == INVALID_SOCKET)
+		return 1;
+
+	return 1 + lua_ultibo_push_address(L, &address);
+}
+
+/* socket.send(socket, data [, count]) returns the count sent */
+static int lua_ultibo_socket_send(lua_State *L)
+{
+	SOCKET s = lua_ultibo_socket(L, 1);
+	uint32_t size;
+	uint8_t *data;
+	int arg = 2;
+
+	data = lua_ultibo_data(L, &arg, &size, TRUE);
+
+	lua_pushinteger(L, send(s, (const char *)data, (int32_t)size, 0));
+	return 1;
+}
+
+/* socket.recv(socket, buffer [, count]) returns the count received, socket.recv(socket, count) returns a string */
+static int lua_ultibo_socket_recv(lua_State *L)
+{
+	SOCKET s = lua_ultibo_socket(L, 1);
+	luaL_Buffer buffer;
+	lua_Integer count;
+	uint32_t size;
+	uint8_t *data;
+	int32_t result;
+	int arg = 2;
+
+	if (lua_type(L, arg) == LUA_TNUMBER)
+	{
+		count = luaL_checkinteger(L, arg);
+		luaL_argcheck(L, count >= 0 && count <= 0x7FFFFFFF, arg, "count out of range");
+
+		data = (uint8_t *)luaL_buffinitsize(L, &buffer, (size_t)count);
+		result = recv(s, (char *)data, (int32_t)count, 0);
+		if (result < 0)
+		{
+			lua_pushnil(L);
+			return 1;
+		}
+
+		luaL_pushresultsize(&buffer, result);
+		return 1;
+	}
+
+	data = lua_ultibo_data(L, &arg, &size, FALSE);
+
+	lua_pushinteger(L, recv(s, (char *)data, (int32_t)size, 0));
+	return 1;
+}
+
+/* socket.sendto(socket, address, port, data [, count]) returns the count sent */
+static int lua_ultibo_socket_sendto(lua_State *L)
+{
+	SOCKET s = lua_ultibo_socket(L, 1);
+	sockaddr_in address;
+	uint32_t size;
+	uint8_t *data;
+	int arg = 4;
+
+	lua_ultibo_address(L, 2, &address);
+	data = lua_ultibo_data(L, &arg, &size, TRUE);
+
+	lua_pushinteger(L, sendto(s, (const char *)data, (int32_t)size, 0, (SOCKADDR *)&address, sizeof(sockaddr_in)));
+	return 1;
+}
+
+/* socket.recvfrom(socket, buffer [, count]) returns count, address, port */
+static int lua_ultibo_socket_recvfrom(lua_State *L)
+{
+	SOCKET s = lua_ultibo_socket(L, 1);
+	sockaddr_in address;
+	int32_t length = sizeof(sockaddr_in);
+	int32_t result;
+	uint32_t size;
+	uint8_t *data;
+	int arg = 2;
+
+	data = lua_ultibo_data(L, &arg, &size, FALSE);
+
+	result = recvfrom(s, (char *)data, (int32_t)size, 0, (SOCKADDR *)&address, &length);
+	lua_pushinteger(L, result);
+	if (result < 0)
+		return 1;
+
+	return 1 + lua_ultibo_push_address(L, &address);
+}
+
+static const luaL_Reg lua_ultibo_socket_functions[] =
+{
+	{"tcp", lua_ultibo_socket_tcp},
+	{"udp", lua_ultibo_socket_udp},
+	{"close", lua_ultibo_socket_close},
+	{"connect", lua_ultibo_socket_connect},
+	{"bind", lua_ultibo_socket_bind},
+	{"listen", lua_ultibo_socket_listen},
+	{"accept", lua_ultibo_socket_accept},
+	{"send", lua_ultibo_socket_send},
+	{"recv", lua_ultibo_socket_recv},
+	{"sendto", lua_ultibo_socket_sendto},
+	{"recvfrom", lua_ultibo_socket_recvfrom},
+	{NULL, NULL}
+};
+
+/* ============================================================================== */
+/* Lua Buffer Bindings */
+static LUA_ULTIBO_BUFFER *lua_ultibo_buffer_get(lua_State *L, int arg)
+{
+	return (LUA_ULTIBO_BUFFER *)luaL_checkudata(L, arg, LUA_ULTIBO_BUFFER_TYPE);
+}
+
+/* Convert a 1 based position of a value of size bytes to an offset, raising an error if outside the buffer */
+static uint32_t lua_ultibo_buffer_offset(lua_State *L, LUA_ULTIBO_BUFFER *buffer, int arg, uint32_t size)
+{
+	lua_Integer position = luaL_checkinteger(L, arg);
+
+	luaL_argcheck(L, position >= 1 && position - 1 + size <= buffer->size, arg, "position out of range");
+
+	return (uint32_t)(position - 1);
+}
+
+/* ultibo.buffer.new(size) */
+static int lua_ultibo_buffer_create(lua_State *L)
+{
+	lua_Integer size = luaL_checkinteger(L, 1);
+
+	luaL_argcheck(L, size >= 0 && size <= 0x7FFFFFFF, 1, "size out of range");
+
+	lua_ultibo_buffer_new(L, (uint32_t)size);
+	return 1;
+}
+
+/* ultibo.buffer.wrap(pointer, size) */
+static int lua_ultibo_buffer_view(lua_State *L)
+{
+	lua_Integer size;
+
+	luaL_checktype(L, 1, LUA_TLIGHTUSERDATA);
+	size = luaL_checkinteger(L, 2);
+	luaL_argcheck(L, size >= 0 && size <= 0xFFFFFFFF, 2, "size out of range");
+
+	lua_ultibo_buffer_wrap(L, lua_touserdata(L, 1), (uint32_t)size);
+	return 1;
+}
+
+/* ultibo.buffer.from(string) */
+static int lua_ultibo_buffer_from(lua_State *L)
+{
+	const char *text;
+	size_t len;
+
+	text = luaL_checklstring(L, 1, &len);
+	luaL_argcheck(L, len <= 0x7FFFFFFF, 1, "string too long");
+
+	memcpy(lua_ultibo_buffer_new(L, (uint32_t)len), text, len);
+	return 1;
+}
+
+static int lua_ultibo_buffer_index(lua_State *L)
+{
+	LUA_ULTIBO_BUFFER *buffer = lua_ultibo_buffer_get(L, 1);
+	lua_Integer position;
+
+	if (lua_type(L, 2) == LUA_TNUMBER)
+	{
+		position = luaL_checkinteger(L, 2);
+		if (position < 1 || position > buffer->size)
+			return 0;
+
+		lua_pushinteger(L, buffer->data[position - 1]);
+		return 1;
+	}
+
+	/* Methods are in the upvalue table */
+	lua_gettable(L, lua_upvalueindex(1));
+	return 1;
+}
+
+static int lua_ultibo_buffer_newindex(lua_State *L)
+{
+	LUA_ULTIBO_BUFFER *buffer = lua_ultibo_buffer_get(L, 1);
+
+	buffer->data[lua_ultibo_buffer_offset(L, buffer, 2, 1)] = (uint8_t)luaL_checkinteger(L, 3);
+	return 0;
+}
+
+static int lua_ultibo_buffer_len(lua_State *L)
+{
+	lua_pushinteger(L, lua_ultibo_buffer_get(L, 1)->size);
+	return 1;
+}
+
+static int lua_ultibo_buffer_tostring(lua_State *L)
+{
+	LUA_ULTIBO_BUFFER *buffer = lua_ultibo_buffer_get(L, 1);
+
+	lua_pushfstring(L, "%s: %p (%d bytes%s)", LUA_ULTIBO_BUFFER_TYPE, buffer->data, (int)buffer->size, buffer->view ? ", view" : "");
+	return 1;
+}
+
+/* buffer:ptr() returns the buffer memory as a light userdata */
+static int lua_ultibo_buffer_ptr(lua_State *L)
+{
+	lua_pushlightuserdata(L, lua_ultibo_buffer_get(L, 1)->data);
+	return 1;
+}
+
+/* buffer:fill(value [, i [, j]]) */
+static int lua_ultibo_buffer_fill(lua_State *L)
+{
+	LUA_ULTIBO_BUFFER *buffer = lua_ultibo_buffer_get(L, 1);
+	int value = (int)luaL_checkinteger(L, 2);
+	uint32_t offset;
+	uint32_t count;
+
+	offset = lua_ultibo_range(L, 3, buffer->size, &count);
+	memset(buffer->data + offset, value, count);
+	return 0;
+}
+
+/* buffer:string([i [, j]]) returns a copy of the bytes from i to j */
+static int lua_ultibo_buffer_string(lua_State *L)
+{
+	LUA_ULTIBO_BUFFER *buffer = lua_ultibo_buffer_get(L, 1);
+	uint32_t offset;
+	uint32_t count;
+
+	offset = lua_ultibo_range(L, 2, buffer->size, &count);
+	lua_pushlstring(L, (const char *)buffer->data + offset, count);
+	return 1;
+}
+
+/* buffer:copy(source [, position]) copies a buffer or string into the buffer, returns the count copied */
+static int lua_ultibo_buffer_copy(lua_State *L)
+{
+	LUA_ULTIBO_BUFFER *buffer = lua_ultibo_buffer_get(L, 1);
+	lua_Integer position;
+	uint32_t size;
+	uint8_t *data;
+	int arg = 2;
+
+	data = lua_ultibo_data(L, &arg, &size, TRUE);
+	position = luaL_optinteger(L, arg, 1);
+	luaL_argcheck(L, position >= 1 && position <= (lua_Integer)buffer->size + 1, arg, "position out of range");
+
+	if (size > buffer->size - (position - 1))
+		size = buffer->size - (uint32_t)(position - 1);
+
+	memmove(buffer->data + position - 1, data, size);
+	lua_pushinteger(L, size);
+	return 1;
+}
+
+/* buffer:u16(position [, value]) gets or sets a little endian 16 bit value */
+static int lua_ultibo_buffer_u16(lua_State *L)
+{
+	LUA_ULTIBO_BUFFER *buffer = lua_ultibo_buffer_get(L, 1);
+	uint8_t *data = buffer->data + lua_ultibo_buffer_offset(L, buffer, 2, 2);
+	uint32_t value;
+
+	if (lua_isnoneornil(L, 3))
+	{
+		lua_pushinteger(L, data[0] | (data[1] << 8));
+		return 1;
+	}
+
+	value = lua_ultibo_u32(L, 3);
+	data[0] = value & 0xFF;
+	data[1] = (value >> 8) & 0xFF;
+	return 0;
+}
+
+/* buffer:u32(position [, value]) gets or sets a little endian 32 bit value */
+static int lua_ultibo_buffer_u32(lua_State *L)
+{
+	LUA_ULTIBO_BUFFER *buffer = lua_ultibo_buffer_get(L, 1);
+	uint8_t *data = buffer->data + lua_ultibo_buffer_offset(L, buffer, 2, 4);
+	uint32_t value;
+
+	if (lua_isnoneornil(L, 3))
+	{
+		lua_pushinteger(L, (uint32_t)(data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24)));
+		return 1;
+	}
+
+	value = lua_ultibo_u32(L, 3);
+	data[0] = value & 0xFF;
+	data[1] = (value >> 8) & 0xFF;
+	data[2] = (value >> 16) & 0xFF;
+	data[3] = (value >> 24) & 0xFF;
+	return 0;
+}
+
+static const luaL_Reg lua_ultibo_buffer_functions[] =
+{
+	{"new", lua_ultibo_buffer_create},
+	{"wrap", lua_ultibo_buffer_view},
+	{"from", lua_ultibo_buffer_from},
+	{NULL, NULL}
+};
+
+static const luaL_Reg lua_ultibo_buffer_methods[] =
+{
+	{"ptr", lua_ultibo_buffer_ptr},
+	{"fill", lua_ultibo_buffer_fill},
+	{"string", lua_ultibo_buffer_string},
+	{"copy", lua_ultibo_buffer_copy},
+	{"u16", lua_ultibo_buffer_u16},
+	{"u32", lua_ultibo_buffer_u32},
+	{NULL, NULL}
+};
+
+static const luaL_Reg lua_ultibo_buffer_metamethods[] =
+{
+	{"__newindex", lua_ultibo_buffer_newindex},
+	{"__len", lua_ultibo_buffer_len},
+	{"__tostring", lua_ultibo_buffer_tostring},
+	{NULL, NULL}
+};
+
+/* ============================================================================== */
+/* Lua General Bindings */
+static int lua_ultibo_sleep(lua_State *L)
+{
+	thread_sleep(lua_ultibo_u32(L, 1));
+	return 0;
+}
+
+static int lua_ultibo_microseconds(lua_State *L)
+{
+	lua_pushinteger(L, (lua_Integer)clock_microseconds());
+	return 1;
+}
+
+static int lua_ultibo_cpu(lua_State *L)
+{
+	lua_pushinteger(L, cpu_get_current());
+	return 1;
+}
+
+static const luaL_Reg lua_ultibo_functions[] =
+{
+	{"sleep", lua_ultibo_sleep},
+	{"microseconds", lua_ultibo_microseconds},
+	{"cpu", lua_ultibo_cpu},
+	{NULL, NULL}
+};
+
+/* ============================================================================== */
+/* Lua Binding Functions */
+static void lua_ultibo_group(lua_State *L, const char *name, const luaL_Reg *functions, const LUA_ULTIBO_CONSTANT *constants)
+{
+	lua_newtable(L);
+	luaL_setfuncs(L, functions, 0);
+	if (constants)
+		lua_ultibo_constants(L, constants);
+	lua_setfield(L, -2, name);
+}
+
+int luaopen_ultibo(lua_State *L)
+{
+	/* Buffer metatable with the methods table as the upvalue of __index */
+	if (luaL_newmetatable(L, LUA_ULTIBO_BUFFER_TYPE))
+	{
+		luaL_setfuncs(L, lua_ultibo_buffer_metamethods, 0);
+		luaL_newlib(L, lua_ultibo_buffer_methods);
+		lua_pushcclosure(L, lua_ultibo_buffer_index, 1);
+		lua_setfield(L, -2, "__index");
+	}
+	lua_pop(L, 1);
+
+	luaL_newlib(L, lua_ultibo_functions);
+	lua_ultibo_group(L, "gpio", lua_ultibo_gpio_functions, lua_ultibo_gpio_constants);
+	lua_ultibo_group(L, "spi", lua_ultibo_spi_functions, lua_ultibo_spi_constants);
+	lua_ultibo_group(L, "i2c", lua_ultibo_i2c_functions, NULL);
+	lua_ultibo_group(L, "console", lua_ultibo_console_functions, lua_ultibo_console_constants);
+	lua_ultibo_group(L, "file", lua_ultibo_file_functions, lua_ultibo_file_constants);
+	lua_ultibo_group(L, "socket", lua_ultibo_socket_functions, NULL);
+	lua_ultibo_group(L, "buffer", lua_ultibo_buffer_functions, NULL);
+
+	return 1;
+}
+
+static int lua_ultibo_require(lua_State *L)
+{
+	luaL_requiref(L, LUA_ULTIBO_LIBRARY_NAME, luaopen_ultibo, 1);
+	return 0;
+}
+
+uint32_t STDCALL lua_ultibo_open(lua_State *L)
+{
+	if (!L)
+		return ERROR_INVALID_PARAMETER;
+
+	/* Protected so a memory error is returned instead of reaching the panic function */
+	lua_pushcfunction(L, lua_ultibo_require);
+	if (lua_pcall(L, 0, 0, 0) != LUA_OK)
+	{
+		lua_pop(L, 1);
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Lua Buffer Functions */
+uint8_t * STDCALL lua_ultibo_buffer_new(lua_State *L, uint32_t size)
+{
+	LUA_ULTIBO_BUFFER *buffer;
+
+	buffer = (LUA_ULTIBO_BUFFER *)lua_newuserdatauv(L, sizeof(LUA_ULTIBO_BUFFER) + size, 0);
+	buffer->data = (uint8_t *)(buffer + 1);
+	buffer->size = size;
+	buffer->view = FALSE;
+	memset(buffer->data, 0, size);
+
+	luaL_setmetatable(L, LUA_ULTIBO_BUFFER_TYPE);
+
+	return buffer->data;
+}
+
+uint8_t * STDCALL lua_ultibo_buffer_wrap(lua_State *L, void *data, uint32_t size)
+{
+	LUA_ULTIBO_BUFFER *buffer;
+
+	buffer = (LUA_ULTIBO_BUFFER *)lua_newuserdatauv(L, sizeof(LUA_ULTIBO_BUFFER), 0);
+	buffer->data = (uint8_t *)data;
+	buffer->size = size;
+	buffer->view = TRUE;
+
+	luaL_setmetatable(L, LUA_ULTIBO_BUFFER_TYPE);
+
+	return buffer->data;
+}
+
+uint8_t * STDCALL lua_ultibo_buffer_check(lua_State *L, int index, uint32_t *size)
+{
+	LUA_ULTIBO_BUFFER *buffer;
+
+	buffer = (LUA_ULTIBO_BUFFER *)luaL_testudata(L, index, LUA_ULTIBO_BUFFER_TYPE);
+	if (!buffer)
+		return NULL;
+
+	if (size)
+		*size = buffer->size;
+
+	return buffer->data;
+}
+
+/* ============================================================================== */
+/* Lua Arena Internal Functions */
+static LUA_ULTIBO_ARENA *lua_ultibo_arena_check(LUA_ULTIBO_ARENA *arena)
+{
+	if (!arena || arena->signature != LUA_ULTIBO_ARENA_SIGNATURE)
+		return NULL;
+
+	return arena;
+}
+
+/* Size actually used by a block of size bytes */
+static inline uint32_t lua_ultibo_arena_block(size_t size)
+{
+	if (size > LUA_ULTIBO_ARENA_SMALL_MAX)
+		return (uint32_t)size;
+
+	return (size + LUA_ULTIBO_ARENA_GRANULE - 1) & ~(LUA_ULTIBO_ARENA_GRANULE - 1);
+}
+
+static inline void lua_ultibo_arena_push(LUA_ULTIBO_ARENA *arena, void *block, uint32_t size)
+{
+	uint32_t index = (size / LUA_ULTIBO_ARENA_GRANULE) - 1;
+
+	*(void **)block = arena->free[index];
+	arena->free[index] = block;
+}
+
+/* Add a new chunk, moving what is left of the current chunk to the free lists */
+static BOOL lua_ultibo_arena_grow(LUA_ULTIBO_ARENA *arena)
+{
+	LUA_ULTIBO_ARENA_CHUNK *chunk;
+	uint32_t remain;
+	uint32_t size;
+
+	chunk = malloc(arena->chunksize);
+	if (!chunk)
+		return FALSE;
+
+	remain = arena->end - arena->next;
+	while (remain >= LUA_ULTIBO_ARENA_GRANULE)
+	{
+		size = (remain > LUA_ULTIBO_ARENA_SMALL_MAX) ? LUA_ULTIBO_ARENA_SMALL_MAX : remain;
+		lua_ultibo_arena_push(arena, arena->next, size);
+		arena->next += size;
+		remain -= size;
+	}
+
+	chunk->next = arena->chunks;
+	chunk->size = arena->chunksize;
+	arena->chunks = chunk;
+
+	/* Blocks start on a granule boundary after the header */
+	arena->next = (uint8_t *)chunk + lua_ultibo_arena_block(sizeof(LUA_ULTIBO_ARENA_CHUNK));
+	arena->end = (uint8_t *)chunk + arena->chunksize;
+
+	arena->statistics.reserved += arena->chunksize;
+	arena->statistics.chunkcount++;
+
+	return TRUE;
+}
+
+static void *lua_ultibo_arena_get(LUA_ULTIBO_ARENA *arena, uint32_t size)
+{
+	void *block;
+	uint32_t index;
+
+	if (size > LUA_ULTIBO_ARENA_SMALL_MAX)
+	{
+		block = malloc(size);
+		if (block)
+			arena->statistics.largecount++;
+
+		return block;
+	}
+
+	index = (size / LUA_ULTIBO_ARENA_GRANULE) - 1;
+	block = arena->free[index];
+	if (block)
+	{
+		arena->free[index] = *(void **)block;
+		return block;
+	}
+
+	if (arena->end - arena->next < size && !lua_ultibo_arena_grow(arena))
+		return NULL;
+
+	block = arena->next;
+	arena->next += size;
+
+	return block;
+}
+
+static void lua_ultibo_arena_put(LUA_ULTIBO_ARENA *arena, void *block, uint32_t size)
+{
+	if (size > LUA_ULTIBO_ARENA_SMALL_MAX)
+	{
+		free(block);
+		arena->statistics.largecount--;
+		return;
+	}
+
+	lua_ultibo_arena_push(arena, block, size);
+}
+
+static inline void lua_ultibo_arena_account(LUA_ULTIBO_ARENA *arena, uint32_t oldsize, uint32_t newsize)
+{
+	arena->statistics.used = arena->statistics.used - oldsize + newsize;
+	if (arena->statistics.used > arena->statistics.peak)
+		arena->statistics.peak = arena->statistics.used;
+}
+
+/* ============================================================================== */
+/* Lua Arena Functions */
+LUA_ULTIBO_ARENA * STDCALL lua_ultibo_arena_create(uint32_t chunksize, uint32_t limit)
+{
+	LUA_ULTIBO_ARENA *arena;
+
+	if (chunksize == 0)
+		chunksize = LUA_ULTIBO_ARENA_CHUNK_SIZE;
+	if (limit == 0)
+		limit = LUA_ULTIBO_ARENA_LIMIT;
+
+	if (chunksize < LUA_ULTIBO_ARENA_CHUNK_MIN)
+		chunksize = LUA_ULTIBO_ARENA_CHUNK_MIN;
+
+	arena = calloc(1, sizeof(LUA_ULTIBO_ARENA));
+	if (!arena)
+		return NULL;
+
+	arena->signature = LUA_ULTIBO_ARENA_SIGNATURE;
+	arena->chunksize = lua_ultibo_arena_block(chunksize);
+	arena->limit = limit;
+	arena->statistics.limit = limit;
+
+	return arena;
+}
+
+uint32_t STDCALL lua_ultibo_arena_destroy(LUA_ULTIBO_ARENA *arena)
+{
+	LUA_ULTIBO_ARENA_CHUNK *chunk;
+
+	if (!lua_ultibo_arena_check(arena))
+		return ERROR_INVALID_PARAMETER;
+
+	/* Large blocks are only freed by Lua so the state must be closed first */
+	if (arena->statistics.largecount != 0)
+		return ERROR_IN_USE;
+
+	while (arena->chunks)
+	{
+		chunk = arena->chunks;
+		arena->chunks = chunk->next;
+		free(chunk);
+	}
+
+	arena->signature = 0;
+	free(arena);
+
+	return ERROR_SUCCESS;
+}
+
+void *lua_ultibo_arena_alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+	LUA_ULTIBO_ARENA *arena = (LUA_ULTIBO_ARENA *)ud;
+	uint32_t oldsize;
+	uint32_t newsize;
+	void *block;
+
+	/* When ptr is NULL osize is the type of object being allocated, not a size */
+	oldsize = ptr ? lua_ultibo_arena_block(osize) : 0;
+
+	if (nsize == 0)
+	{
+		if (ptr)
+		{
+			lua_ultibo_arena_put(arena, ptr, oldsize);
+			lua_ultibo_arena_account(arena, oldsize, 0);
+			arena->statistics.freecount++;
+		}
+		return NULL;
+	}
+
+	if (nsize > 0x7FFFFFFF)
+	{
+		arena->statistics.failcount++;
+		return NULL;
+	}
+
+	newsize = lua_ultibo_arena_block(nsize);
+	arena->statistics.allocatecount++;
+
+	/* Same small size, or a heap block the heap can resize */
+	if (ptr && (newsize == oldsize || (oldsize > LUA_ULTIBO_ARENA_SMALL_MAX && newsize > LUA_ULTIBO_ARENA_SMALL_MAX)))
+	{
+		if (newsize == oldsize)
+			return ptr;
+
+		if (newsize > oldsize && arena->statistics.used - oldsize + newsize > arena->limit)
+		{
+			arena->statistics.failcount++;
+			return NULL;
+		}
+
+		block = realloc(ptr, newsize);
+		if (!block)
+		{
+			if (newsize > oldsize)
+			{
+				arena->statistics.failcount++;
+				return NULL;
+			}
+			block = ptr;
+		}
+
+		lua_ultibo_arena_account(arena, oldsize, newsize);
+		return block;
+	}
+
+	if (newsize > oldsize && arena->statistics.used - oldsize + newsize > arena->limit)
+	{
+		/* Lua collects garbage and tries again before raising a memory error */
+		arena->statistics.failcount++;
+		return NULL;
+	}
+
+	block = lua_ultibo_arena_get(arena, newsize);
+	if (!block)
+	{
+		/* A shrinking small block stays where it is (Only the smaller size is reused when it is freed) */
+		if (ptr && newsize < oldsize && oldsize <= LUA_ULTIBO_ARENA_SMALL_MAX)
+		{
+			lua_ultibo_arena_account(arena, oldsize, newsize);
+			return ptr;
+		}
+
+		arena->statistics.failcount++;
+		return NULL;
+	}
+
+	if (ptr)
+	{
+		memcpy(block, ptr, (osize < nsize) ? osize : nsize);
+		lua_ultibo_arena_put(arena, ptr, oldsize);
+	}
+
+	lua_ultibo_arena_account(arena, oldsize, newsize);
+
+	return block;
+}
+
+uint32_t STDCALL lua_ultibo_arena_get_statistics(LUA_ULTIBO_ARENA *arena, LUA_ULTIBO_ARENA_STATISTICS *statistics)
+{
+	if (!lua_ultibo_arena_check(arena) || !statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	memcpy(statistics, &arena->statistics, sizeof(LUA_ULTIBO_ARENA_STATISTICS));
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Lua State Functions */
+static int lua_ultibo_state_panic(lua_State *L)
+{
+	const char *message = lua_tostring(L, -1);
+
+	console_window_write_ln(console_window_get_default(console_device_get_default()), message ? message : "Lua panic");
+
+	return 0;
+}
+
+static int lua_ultibo_state_init(lua_State *L)
+{
+	luaL_openlibs(L);
+	luaL_requiref(L, LUA_ULTIBO_LIBRARY_NAME, luaopen_ultibo, 1);
+	return 0;
+}
+
+lua_State * STDCALL lua_ultibo_state_create(LUA_ULTIBO_ARENA *arena)
+{
+	lua_State *L;
+
+	if (arena && !lua_ultibo_arena_check(arena))
+		return NULL;
+
+	L = arena ? lua_newstate(lua_ultibo_arena_alloc, arena) : luaL_newstate();
+	if (!L)
+		return NULL;
+
+	lua_atpanic(L, lua_ultibo_state_panic);
+
+	lua_pushcfunction(L, lua_ultibo_state_init);
+	if (lua_pcall(L, 0, 0, 0) != LUA_OK)
+	{
+		lua_close(L);
+		return NULL;
+	}
+
+	return L;
+}
+
+uint32_t STDCALL lua_ultibo_state_destroy(lua_State *L, LUA_ULTIBO_ARENA *arena)
+{
+	if (!L)
+		return ERROR_INVALID_PARAMETER;
+
+	lua_close(L);
+
+	if (arena)
+		return lua_ultibo_arena_destroy(arena);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Lua Pool Internal Functions */
+static LUA_ULTIBO_POOL *lua_ultibo_pool_check(LUA_ULTIBO_POOL *pool)
+{
+	if (!pool || pool->signature != LUA_ULTIBO_POOL_SIGNATURE)
+		return NULL;
+
+	return pool;
+}
+
+static void lua_ultibo_entry_destroy(LUA_ULTIBO_POOL_ENTRY *entry)
+{
+	if (entry->state)
+		lua_ultibo_state_destroy(entry->state, entry->arena);
+	else if (entry->arena)
+		lua_ultibo_arena_destroy(entry->arena);
+
+	free(entry);
+}
+
+/* Create a state for the CPU, count must already include it */
+static LUA_ULTIBO_POOL_ENTRY *lua_ultibo_entry_create(LUA_ULTIBO_POOL *pool, uint32_t cpu)
+{
+	LUA_ULTIBO_POOL_ENTRY *entry;
+	int64_t start;
+
+	start = clock_microseconds();
+
+	entry = calloc(1, sizeof(LUA_ULTIBO_POOL_ENTRY));
+	if (!entry)
+		return NULL;
+
+	entry->pool = pool;
+	entry->cpu = cpu;
+
+	entry->arena = lua_ultibo_arena_create(pool->config.chunksize, pool->config.limit);
+	if (!entry->arena)
+	{
+		free(entry);
+		return NULL;
+	}
+
+	entry->state = lua_ultibo_state_create(entry->arena);
+	if (!entry->state)
+	{
+		lua_ultibo_entry_destroy(entry);
+		return NULL;
+	}
+
+	*(LUA_ULTIBO_POOL_ENTRY **)lua_getextraspace(entry->state) = entry;
+
+	if (pool->script)
+	{
+		if (luaL_loadbufferx(entry->state, pool->script, strlen(pool->script), pool->name ? pool->name : "=pool", "t") != LUA_OK
+		 || lua_pcall(entry->state, 0, 0, 0) != LUA_OK)
+		{
+			lua_ultibo_entry_destroy(entry);
+			return NULL;
+		}
+	}
+
+	/* Add to the pool */
+	mutex_lock(pool->lock);
+
+	entry->link = pool->entries;
+	pool->entries = entry;
+	pool->createtotal += clock_microseconds() - start;
+	pool->statistics.statecount++;
+
+	mutex_unlock(pool->lock);
+
+	return entry;
+}
+
+static LUA_ULTIBO_POOL_ENTRY *lua_ultibo_entry_take(LUA_ULTIBO_POOL *pool, uint32_t cpu)
+{
+	LUA_ULTIBO_POOL_CPU *poolcpu = &pool->cpus[cpu];
+	LUA_ULTIBO_POOL_ENTRY *entry;
+
+	spin_lock(poolcpu->lock);
+
+	entry = poolcpu->available;
+	if (entry)
+		poolcpu->available = entry->next;
+
+	spin_unlock(poolcpu->lock);
+
+	return entry;
+}
+
+static void lua_ultibo_entry_give(LUA_ULTIBO_POOL *pool, LUA_ULTIBO_POOL_ENTRY *entry)
+{
+	LUA_ULTIBO_POOL_CPU *poolcpu = &pool->cpus[entry->cpu];
+
+	spin_lock(poolcpu->lock);
+
+	entry->next = poolcpu->available;
+	poolcpu->available = entry;
+
+	spin_unlock(poolcpu->lock);
+}
+
+/* Reserve a place for a new state on the CPU if it is below the maximum */
+static BOOL lua_ultibo_entry_reserve(LUA_ULTIBO_POOL *pool, uint32_t cpu)
+{
+	LUA_ULTIBO_POOL_CPU *poolcpu = &pool->cpus[cpu];
+	BOOL result = FALSE;
+
+	spin_lock(poolcpu->lock);
+
+	if (poolcpu->count < pool->config.maxpercpu)
+	{
+		poolcpu->count++;
+		result = TRUE;
+	}
+
+	spin_unlock(poolcpu->lock);
+
+	return result;
+}
+
+static void lua_ultibo_entry_unreserve(LUA_ULTIBO_POOL *pool, uint32_t cpu)
+{
+	LUA_ULTIBO_POOL_CPU *poolcpu = &pool->cpus[cpu];
+
+	spin_lock(poolcpu->lock);
+	poolcpu->count--;
+	spin_unlock(poolcpu->lock);
+}
+
+/* Run a handler inside a protected call (upvalues are the function name, buffer and size) */
+static int lua_ultibo_pool_handler(lua_State *L)
+{
+	lua_getglobal(L, (const char *)lua_touserdata(L, lua_upvalueindex(1)));
+	lua_pushvalue(L, lua_upvalueindex(2));
+	lua_pushvalue(L, lua_upvalueindex(3));
+	lua_call(L, 2, 1);
+	return 1;
+}
+
+static void lua_ultibo_pool_free(LUA_ULTIBO_POOL *pool)
+{
+	LUA_ULTIBO_POOL_ENTRY *entry;
+	uint32_t cpu;
+
+	while (pool->entries)
+	{
+		entry = pool->entries;
+		pool->entries = entry->link;
+		lua_ultibo_entry_destroy(entry);
+	}
+
+	if (pool->cpus)
+	{
+		for (cpu = 0; cpu < pool->cpucount; cpu++)
+		{
+			if (pool->cpus[cpu].lock != INVALID_HANDLE_VALUE)
+				spin_destroy(pool->cpus[cpu].lock);
+		}
+		free(pool->cpus);
+	}
+
+	if (pool->lock != INVALID_HANDLE_VALUE)
+		mutex_destroy(pool->lock);
+
+	free(pool->script);
+	free(pool->name);
+
+	pool->signature = 0;
+	free(pool);
+}
+
+/* ============================================================================== */
+/* Lua Pool Functions */
+LUA_ULTIBO_POOL * STDCALL lua_ultibo_pool_create(LUA_ULTIBO_POOL_CONFIG *config)
+{
+	LUA_ULTIBO_POOL_ENTRY *entry;
+	LUA_ULTIBO_POOL *pool;
+	uint32_t count;
+	uint32_t cpu;
+
+	pool = calloc(1, sizeof(LUA_ULTIBO_POOL));
+	if (!pool)
+		return NULL;
+
+	pool->signature = LUA_ULTIBO_POOL_SIGNATURE;
+	pool->lock = INVALID_HANDLE_VALUE;
+
+	if (config)
+		memcpy(&pool->config, config, sizeof(LUA_ULTIBO_POOL_CONFIG));
+
+	if (pool->config.statespercpu == 0)
+		pool->config.statespercpu = LUA_ULTIBO_POOL_STATES_PER_CPU;
+	if (pool->config.maxpercpu == 0)
+		pool->config.maxpercpu = LUA_ULTIBO_POOL_MAX_PER_CPU;
+	if (pool->config.maxpercpu < pool->config.statespercpu)
+		pool->config.maxpercpu = pool->config.statespercpu;
+	if (pool->config.chunksize == 0)
+		pool->config.chunksize = LUA_ULTIBO_ARENA_CHUNK_SIZE;
+	if (pool->config.limit == 0)
+		pool->config.limit = LUA_ULTIBO_ARENA_LIMIT;
+
+	/* Keep a copy of the script so states can be created later */
+	if (pool->config.script)
+	{
+		pool->script = strdup(pool->config.script);
+		if (!pool->script)
+			goto failed;
+	}
+	if (pool->config.name)
+	{
+		pool->name = strdup(pool->config.name);
+		if (!pool->name)
+			goto failed;
+	}
+	pool->config.script = pool->script;
+	pool->config.name = pool->name;
+
+	pool->lock = mutex_create();
+	if (pool->lock == INVALID_HANDLE_VALUE)
+		goto failed;
+
+	pool->cpucount = cpu_get_count();
+	pool->cpus = calloc(pool->cpucount, sizeof(LUA_ULTIBO_POOL_CPU));
+	if (!pool->cpus)
+		goto failed;
+
+	for (cpu = 0; cpu < pool->cpucount; cpu++)
+		pool->cpus[cpu].lock = INVALID_HANDLE_VALUE;
+
+	for (cpu = 0; cpu < pool->cpucount; cpu++)
+	{
+		pool->cpus[cpu].lock = spin_create();
+		if (pool->cpus[cpu].lock == INVALID_HANDLE_VALUE)
+			goto failed;
+
+		for (count = 0; count < pool->config.statespercpu; count++)
+		{
+			pool->cpus[cpu].count++;
+
+			entry = lua_ultibo_entry_create(pool, cpu);
+			if (!entry)
+				goto failed;
+
+			lua_ultibo_entry_give(pool, entry);
+		}
+	}
+
+	pool->statistics.createtime = pool->createtotal / pool->statistics.statecount;
+
+	return pool;
+
+failed:
+	lua_ultibo_pool_free(pool);
+	return NULL;
+}
+
+uint32_t STDCALL lua_ultibo_pool_destroy(LUA_ULTIBO_POOL *pool)
+{
+	LUA_ULTIBO_POOL_ENTRY *entry;
+
+	if (!lua_ultibo_pool_check(pool))
+		return ERROR_INVALID_PARAMETER;
+
+	mutex_lock(pool->lock);
+
+	for (entry = pool->entries; entry; entry = entry->link)
+	{
+		if (entry->acquired)
+		{
+			mutex_unlock(pool->lock);
+			return ERROR_IN_USE;
+		}
+	}
+
+	mutex_unlock(pool->lock);
+
+	lua_ultibo_pool_free(pool);
+
+	return ERROR_SUCCESS;
+}
+
+lua_State * STDCALL lua_ultibo_pool_acquire(LUA_ULTIBO_POOL *pool)
+{
+	LUA_ULTIBO_POOL_ENTRY *entry;
+	uint32_t cpu;
+	uint32_t count;
+
+	if (!lua_ultibo_pool_check(pool))
+		return NULL;
+
+	/* The thread may move to another CPU at any time, which only costs locality */
+	cpu = cpu_get_current();
+	if (cpu >= pool->cpucount)
+		cpu = 0;
+
+	entry = lua_ultibo_entry_take(pool, cpu);
+
+	/* Borrowing a state from another CPU is far quicker than creating one */
+	if (!entry && !(pool->config.flags & LUA_ULTIBO_POOL_FLAG_LOCAL))
+	{
+		for (count = 1; count < pool->cpucount && !entry; count++)
+			entry = lua_ultibo_entry_take(pool, (cpu + count) % pool->cpucount);
+
+		if (entry)
+			__atomic_add_fetch(&pool->statistics.remotecount, 1, __ATOMIC_RELAXED);
+	}
+
+	if (!entry && !(pool->config.flags & LUA_ULTIBO_POOL_FLAG_NO_GROW) && lua_ultibo_entry_reserve(pool, cpu))
+	{
+		entry = lua_ultibo_entry_create(pool, cpu);
+		if (entry)
+			__atomic_add_fetch(&pool->statistics.createcount, 1, __ATOMIC_RELAXED);
+		else
+			lua_ultibo_entry_unreserve(pool, cpu);
+	}
+
+	if (!entry)
+	{
+		__atomic_add_fetch(&pool->statistics.failcount, 1, __ATOMIC_RELAXED);
+		return NULL;
+	}
+
+	entry->acquired = TRUE;
+	__atomic_add_fetch(&pool->statistics.acquirecount, 1, __ATOMIC_RELAXED);
+
+	return entry->state;
+}
+
+uint32_t STDCALL lua_ultibo_pool_release(LUA_ULTIBO_POOL *pool, lua_State *L)
+{
+	LUA_ULTIBO_POOL_ENTRY *entry;
+
+	if (!lua_ultibo_pool_check(pool) || !L)
+		return ERROR_INVALID_PARAMETER;
+
+	entry = *(LUA_ULTIBO_POOL_ENTRY **)lua_getextraspace(L);
+	if (!entry || entry->pool != pool || entry->state != L || !entry->acquired)
+		return ERROR_INVALID_PARAMETER;
+
+	/* Anything left on the stack becomes garbage */
+	lua_settop(L, 0);
+
+	if (pool->config.flags & LUA_ULTIBO_POOL_FLAG_COLLECT)
+		lua_gc(L, LUA_GCCOLLECT);
+	else
+		lua_gc(L, LUA_GCSTEP, 0);
+
+	entry->acquired = FALSE;
+	lua_ultibo_entry_give(pool, entry);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL lua_ultibo_pool_call(LUA_ULTIBO_POOL *pool, const char *function, void *buffer, uint32_t size, int64_t *result)
+{
+	lua_State *L;
+	uint32_t status = ERROR_SUCCESS;
+
+	if (!lua_ultibo_pool_check(pool) || !function)
+		return ERROR_INVALID_PARAMETER;
+
+	L = lua_ultibo_pool_acquire(pool);
+	if (!L)
+		return ERROR_NOT_READY;
+
+	/* The handler gets the buffer as a light userdata, nothing is copied or allocated for it */
+	lua_pushlightuserdata(L, (void *)function);
+	lua_pushlightuserdata(L, buffer);
+	lua_pushinteger(L, size);
+	lua_pushcclosure(L, lua_ultibo_pool_handler, 3);
+
+	if (lua_pcall(L, 0, 1, 0) != LUA_OK)
+	{
+		__atomic_add_fetch(&pool->statistics.errorcount, 1, __ATOMIC_RELAXED);
+		status = ERROR_FUNCTION_FAILED;
+	}
+	else if (result)
+	{
+		*result = lua_tointeger(L, -1);
+	}
+
+	__atomic_add_fetch(&pool->statistics.callcount, 1, __ATOMIC_RELAXED);
+
+	lua_ultibo_pool_release(pool, L);
+
+	return status;
+}
+
+uint32_t STDCALL lua_ultibo_pool_get_statistics(LUA_ULTIBO_POOL *pool, LUA_ULTIBO_POOL_STATISTICS *statistics)
+{
+	if (!lua_ultibo_pool_check(pool) || !statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	mutex_lock(pool->lock);
+
+	memcpy(statistics, &pool->statistics, sizeof(LUA_ULTIBO_POOL_STATISTICS));
+	statistics->createtime = pool->statistics.statecount ? pool->createtotal / pool->statistics.statecount : 0;
+
+	mutex_unlock(pool->lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL lua_ultibo_pool_reset_statistics(LUA_ULTIBO_POOL *pool)
+{
+	if (!lua_ultibo_pool_check(pool))
+		return ERROR_INVALID_PARAMETER;
+
+	mutex_lock(pool->lock);
+
+	pool->statistics.createcount = 0;
+	pool->statistics.acquirecount = 0;
+	pool->statistics.remotecount = 0;
+	pool->statistics.failcount = 0;
+	pool->statistics.callcount = 0;
+	pool->statistics.errorcount = 0;
+
+	mutex_unlock(pool->lock);
+
+	return ERROR_SUCCESS;
+}
@@ -0,0 +1,161 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _LUA_PORT_ULTIBO_H
+#define _LUA_PORT_ULTIBO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+
+#include "lua.h"
+#include "lauxlib.h"
+#include "lualib.h"
+
+/* ============================================================================== */
+/* Lua Ultibo specific constants */
+#define LUA_ULTIBO_LIBRARY_NAME	"ultibo" // Name of the global table holding the Ultibo bindings
+#define LUA_ULTIBO_BUFFER_TYPE	"ultibo.buffer" // Metatable name of Ultibo buffer userdata
+
+#define LUA_ULTIBO_ARENA_CHUNK_SIZE	SIZE_64K // Default size of each block of memory carved up by an arena
+#define LUA_ULTIBO_ARENA_LIMIT	SIZE_4M // Default limit on the memory an arena will allocate
+#define LUA_ULTIBO_ARENA_GRANULE	16 // Allocation granularity for small blocks (Bytes)
+#define LUA_ULTIBO_ARENA_SMALL_MAX	512 // Largest block served from the arena size classes, larger blocks come from the heap (Bytes)
+
+#define LUA_ULTIBO_POOL_STATES_PER_CPU	2 // Default number of states created for each CPU when a pool is created
+#define LUA_ULTIBO_POOL_MAX_PER_CPU	8 // Default maximum number of states belonging to each CPU
+
+/* Lua Pool Flags */
+#define LUA_ULTIBO_POOL_FLAG_NONE	0x00000000
+#define LUA_ULTIBO_POOL_FLAG_LOCAL	0x00000001 // Only use states belonging to the current CPU (Never borrow from another CPU)
+#define LUA_ULTIBO_POOL_FLAG_COLLECT	0x00000002 // Perform a full garbage collection when a state is released (Otherwise a single incremental step)
+#define LUA_ULTIBO_POOL_FLAG_NO_GROW	0x00000004 // Do not create additional states when all states of a CPU are in use
+
+/* ============================================================================== */
+/* Lua Ultibo specific types */
+
+/* Lua Buffer (Userdata of type LUA_ULTIBO_BUFFER_TYPE) */
+typedef struct _LUA_ULTIBO_BUFFER LUA_ULTIBO_BUFFER;
+struct _LUA_ULTIBO_BUFFER
+{
+	uint8_t *data; // Buffer memory (Follows this structure unless the buffer is a view)
+	uint32_t size; // Size of the buffer in bytes
+	BOOL view; // Buffer refers to memory owned by the caller (See lua_ultibo_buffer_wrap)
+};
+
+/* Lua Arena (Opaque) */
+typedef struct _LUA_ULTIBO_ARENA LUA_ULTIBO_ARENA;
+
+/* Lua Arena Statistics */
+typedef struct _LUA_ULTIBO_ARENA_STATISTICS LUA_ULTIBO_ARENA_STATISTICS;
+struct _LUA_ULTIBO_ARENA_STATISTICS
+{
+	uint32_t reserved; // Bytes allocated from the heap for arena chunks
+	uint32_t used; // Bytes currently allocated to Lua (Including large blocks)
+	uint32_t peak; // Highest value of used
+	uint32_t limit; // Limit on used
+	uint32_t chunkcount; // Number of arena chunks
+	uint32_t largecount; // Number of blocks currently allocated from the heap
+	uint64_t allocatecount; // Number of allocations and reallocations
+	uint64_t freecount; // Number of blocks freed
+	uint32_t failcount; // Number of allocations refused because of the limit or lack of memory
+};
+
+/* Lua Pool (Opaque) */
+typedef struct _LUA_ULTIBO_POOL LUA_ULTIBO_POOL;
+
+/* Lua Pool Configuration (Zero for any value selects the default) */
+typedef struct _LUA_ULTIBO_POOL_CONFIG LUA_ULTIBO_POOL_CONFIG;
+struct _LUA_ULTIBO_POOL_CONFIG
+{
+	uint32_t statespercpu; // Number of states created for each CPU when the pool is created
+	uint32_t maxpercpu; // Maximum number of states belonging to each CPU
+	uint32_t chunksize; // Size of the arena chunks for each state (Bytes)
+	uint32_t limit; // Memory limit for each state (Bytes)
+	uint32_t flags; // Lua pool flags (eg LUA_ULTIBO_POOL_FLAG_LOCAL)
+	const char *script; // Lua source run in every new state, normally defining the handler functions (May be NULL)
+	const char *name; // Chunk name used in error messages for script (May be NULL)
+};
+
+/* Lua Pool Statistics */
+typedef struct _LUA_ULTIBO_POOL_STATISTICS LUA_ULTIBO_POOL_STATISTICS;
+struct _LUA_ULTIBO_POOL_STATISTICS
+{
+	uint32_t statecount; // Number of states in the pool
+	uint32_t createcount; // Number of states created after the pool was created
+	uint64_t acquirecount; // Number of states acquired
+	uint64_t remotecount; // Number of states borrowed from another CPU
+	uint32_t failcount; // Number of acquires that found no state available
+	uint64_t callcount; // Number of handlers run by lua_ultibo_pool_call
+	uint32_t errorcount; // Number of handlers that raised an error
+	uint32_t createtime; // Average time to create and initialize a state (Microseconds)
+};
+
+/* ============================================================================== */
+/* Lua Binding Functions */
+int luaopen_ultibo(lua_State *L); // Standard module entry, returns the Ultibo bindings table (For luaL_requiref or package.preload)
+uint32_t STDCALL lua_ultibo_open(lua_State *L); // Register the Ultibo bindings as the global table LUA_ULTIBO_LIBRARY_NAME
+
+/* ============================================================================== */
+/* Lua Buffer Functions */
+uint8_t * STDCALL lua_ultibo_buffer_new(lua_State *L, uint32_t size); // Push a new zero filled buffer of size bytes owned by Lua, returns the buffer memory
+uint8_t * STDCALL lua_ultibo_buffer_wrap(lua_State *L, void *data, uint32_t size); // Push a buffer referring to memory owned by the caller which must remain valid while Lua holds the buffer
+uint8_t * STDCALL lua_ultibo_buffer_check(lua_State *L, int index, uint32_t *size); // Return the memory and size of the buffer at index, or NULL if the value is not a buffer
+
+/* ============================================================================== */
+/* Lua Arena Functions */
+LUA_ULTIBO_ARENA * STDCALL lua_ultibo_arena_create(uint32_t chunksize, uint32_t limit); // Zero for either value selects the default
+uint32_t STDCALL lua_ultibo_arena_destroy(LUA_ULTIBO_ARENA *arena); // The state using the arena must already be closed
+
+void *lua_ultibo_arena_alloc(void *ud, void *ptr, size_t osize, size_t nsize); // Allocation function (lua_Alloc) for lua_newstate with the arena as ud
+
+uint32_t STDCALL lua_ultibo_arena_get_statistics(LUA_ULTIBO_ARENA *arena, LUA_ULTIBO_ARENA_STATISTICS *statistics);
+
+lua_State * STDCALL lua_ultibo_state_create(LUA_ULTIBO_ARENA *arena); // Create a state allocating from arena (or the heap if NULL) with the standard libraries and the Ultibo bindings open
+uint32_t STDCALL lua_ultibo_state_destroy(lua_State *L, LUA_ULTIBO_ARENA *arena); // Close the state and destroy its arena (if not NULL)
+
+/* ============================================================================== */
+/* Lua Pool Functions */
+LUA_ULTIBO_POOL * STDCALL lua_ultibo_pool_create(LUA_ULTIBO_POOL_CONFIG *config); // Config may be NULL for the defaults
+uint32_t STDCALL lua_ultibo_pool_destroy(LUA_ULTIBO_POOL *pool); // All states must have been released
+
+lua_State * STDCALL lua_ultibo_pool_acquire(LUA_ULTIBO_POOL *pool); // Take a state belonging to the current CPU (Or another CPU unless LUA_ULTIBO_POOL_FLAG_LOCAL), returns NULL if none are available
+uint32_t STDCALL lua_ultibo_pool_release(LUA_ULTIBO_POOL *pool, lua_State *L); // Return a state to the CPU it belongs to
+
+uint32_t STDCALL lua_ultibo_pool_call(LUA_ULTIBO_POOL *pool, const char *function, void *buffer, uint32_t size, int64_t *result); // Call the global function with a light userdata for buffer and the size, result is the integer it returns (May be NULL)
+
+uint32_t STDCALL lua_ultibo_pool_get_statistics(LUA_ULTIBO_POOL *pool, LUA_ULTIBO_POOL_STATISTICS *statistics);
+uint32_t STDCALL lua_ultibo_pool_reset_statistics(LUA_ULTIBO_POOL *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _LUA_PORT_ULTIBO_H
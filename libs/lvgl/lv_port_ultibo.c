@@ -0,0 +1,1219 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/framebuffer.h"
+#include "ultibo/dma.h"
+#include "ultibo/console.h"
+#include "ultibo/input.h"
+
+#include "lv_port_ultibo.h"
+
+/* Private LVGL headers needed to locate the software draw unit threads */
+#include "lvgl/src/core/lv_global.h"
+#include "lvgl/src/draw/lv_draw_private.h"
+#include "lvgl/src/draw/sw/lv_draw_sw_private.h"
+
+/*
+ * Implementation of the Ultibo display and input port for LVGL
+ *
+ * The display driver renders in LV_DISPLAY_RENDER_MODE_PARTIAL and flushes each area
+ * to the framebuffer with an asynchronous DMA request, lv_display_flush_ready() is
+ * called from the DMA completion callback so LVGL can render the next area into the
+ * second buffer while the transfer of the first is still in progress
+ *
+ * Where the framebuffer is not in the ARGB8888 format used by LVGL each area is
+ * converted (using NEON where available) into a DMA buffer before the transfer
+ *
+ * Framebuffers that require mark or commit, rotated framebuffers and framebuffers
+ * with a software cursor showing are flushed synchronously by framebuffer_device_put_rect
+ */
+
+/* ============================================================================== */
+/* LVGL Display */
+typedef struct _LV_ULTIBO_DISPLAY LV_ULTIBO_DISPLAY;
+struct _LV_ULTIBO_DISPLAY
+{
+	lv_display_t *display; // The LVGL display for this port
+	uint32_t flags; // Display flags (eg LV_ULTIBO_DISPLAY_FLAG_DOUBLE_BUFFER)
+	// Framebuffer Properties
+	FRAMEBUFFER_DEVICE *framebuffer; // The framebuffer device for the display
+	FRAMEBUFFER_PROPERTIES properties; // Properties of the framebuffer device
+	uint32_t width; // Display Width (Pixels)
+	uint32_t height; // Display Height (Pixels)
+	uint32_t bytes; // Framebuffer Bytes per Pixel
+	BOOL convert; // True if rendered areas must be converted to the framebuffer color format
+	// Buffer Properties
+	uint32_t buffersize; // Size of each render buffer (Bytes)
+	void *buffer1; // LVGL Render Buffer 1
+	void *buffer2; // LVGL Render Buffer 2 (Or NULL if not double buffered)
+	void *convertbuffer; // Color conversion buffer (Or NULL if no conversion required)
+	BOOL dmabuffers; // True if the buffers were allocated with dma_allocate_buffer
+	// Flush Properties
+	uint32_t flushmode; // The flush mode for the display (eg LV_ULTIBO_FLUSH_MODE_DMA_STRIDE)
+	DMA_HOST *dma; // DMA host used for asynchronous flushes
+	DMA_DATA *data; // DMA data blocks for the current flush (One per row for LV_ULTIBO_FLUSH_MODE_DMA_ROWS)
+	uint32_t datacount; // Number of DMA data blocks allocated
+	EVENT_HANDLE completed; // Event signalled when an asynchronous flush completes
+	volatile BOOL pending; // True if an asynchronous flush is in progress
+	// Cursor Properties
+	volatile BOOL cursorshow; // True if the pointer is showing the cursor
+	volatile int32_t cursorx; // Current X position of the cursor
+	volatile int32_t cursory; // Current Y position of the cursor
+	// Statistics Properties
+	lv_timer_t *timer; // Timer for updating the FPS and CPU statistics
+	int64_t reporttime; // Time of the last statistics update (Microseconds)
+	uint32_t reportframes; // Frame count at the last statistics update
+	LV_ULTIBO_STATISTICS statistics;
+};
+
+/* LVGL Pointer */
+typedef struct _LV_ULTIBO_POINTER LV_ULTIBO_POINTER;
+struct _LV_ULTIBO_POINTER
+{
+	LV_ULTIBO_DISPLAY *port; // The display port for this pointer
+	TOUCH_DEVICE *touch; // Device for touch data, NULL if using mouse only
+	uint32_t maxx; // Maximum X value for the current touch device (if applicable)
+	uint32_t maxy; // Maximum Y value for the current touch device (if applicable)
+	BOOL usemouse; // Get mouse data if False or touch data if True
+	BOOL configdelay; // If True then delay touch configuration due to USB touch
+	int32_t lastx; // Last X position of the touch or mouse data
+	int32_t lasty; // Last Y position of the touch or mouse data
+	lv_indev_state_t laststate; // Last touch or mouse button state
+	MOUSE_DATA mousebuffer[LV_ULTIBO_INPUT_READ_BATCH];
+	TOUCH_DATA touchbuffer[LV_ULTIBO_INPUT_READ_BATCH];
+};
+
+/* LVGL Keypad */
+typedef struct _LV_ULTIBO_KEYPAD LV_ULTIBO_KEYPAD;
+struct _LV_ULTIBO_KEYPAD
+{
+	uint32_t lastkey; // Last key pressed on keyboard
+};
+
+/* ============================================================================== */
+/* LVGL Port Internal Functions */
+static uint32_t lv_ultibo_tick_get(void)
+{
+	return get_tick_count();
+}
+
+static void STDCALL lv_ultibo_flush_completed(DMA_REQUEST *request)
+{
+	LV_ULTIBO_DISPLAY *port = (LV_ULTIBO_DISPLAY *)request->driverdata;
+
+	if (!port)
+		return;
+
+	if (request->status != ERROR_SUCCESS)
+		port->statistics.dmaerrors++;
+
+	/* Signal LVGL that the render buffer is free (Only clears a flag, safe from any context) */
+	port->pending = FALSE;
+	lv_display_flush_ready(port->display);
+
+	event_set(port->completed);
+}
+
+static uint32_t lv_ultibo_flush_submit(LV_ULTIBO_DISPLAY *port, uint32_t x, uint32_t y, uint8_t *source, uint32_t width, uint32_t height, uint32_t sourcepitch)
+{
+	uint32_t status;
+	uint32_t rowbytes;
+	uint32_t row;
+	uint32_t dataflags;
+	uint8_t *dest;
+	DMA_DATA *data;
+
+	rowbytes = width * port->bytes;
+	dest = (uint8_t *)port->properties.address + (y * port->properties.pitch) + (x * port->bytes);
+
+	/* The display reads the framebuffer directly, only invalidate if the CPU also caches it */
+	dataflags = DMA_DATA_FLAG_NONE;
+	if (!(port->properties.flags & FRAMEBUFFER_FLAG_CACHED))
+		dataflags |= DMA_DATA_FLAG_NOINVALIDATE;
+
+	if (port->flushmode == LV_ULTIBO_FLUSH_MODE_DMA_STRIDE)
+	{
+		/* Single block, one row per stride */
+		data = port->data;
+		memset(data, 0, sizeof(DMA_DATA));
+		data->source = source;
+		data->dest = dest;
+		data->size = rowbytes * height;
+		data->flags = dataflags | DMA_DATA_FLAG_STRIDE;
+		data->stridelength = rowbytes;
+		data->sourcestride = sourcepitch - rowbytes;
+		data->deststride = port->properties.pitch - rowbytes;
+		data->next = NULL;
+	} else {
+		/* One block per row */
+		if (height > port->datacount)
+			return ERROR_INSUFFICIENT_BUFFER;
+
+		for (row = 0; row < height; row++)
+		{
+			data = &port->data[row];
+			memset(data, 0, sizeof(DMA_DATA));
+			data->source = source + (row * sourcepitch);
+			data->dest = dest + (row * port->properties.pitch);
+			data->size = rowbytes;
+			data->flags = dataflags;
+			data->next = (row + 1 < height) ? &port->data[row + 1] : NULL;
+		}
+	}
+
+	event_reset(port->completed);
+	port->pending = TRUE;
+
+	status = dma_transfer_request_ex(port->dma, port->data, lv_ultibo_flush_completed, port, DMA_DIR_MEM_TO_MEM, DMA_DREQ_ID_NONE, DMA_REQUEST_FLAG_NONE);
+	if (status != ERROR_SUCCESS)
+	{
+		port->pending = FALSE;
+		event_set(port->completed);
+	}
+
+	return status;
+}
+
+static void lv_ultibo_flush_callback(lv_display_t *display, const lv_area_t *area, uint8_t *px_map)
+{
+	LV_ULTIBO_DISPLAY *port = (LV_ULTIBO_DISPLAY *)lv_display_get_driver_data(display);
+	BOOL softcursor;
+	uint32_t stride;
+	uint32_t width;
+	uint32_t height;
+	uint32_t row;
+	uint32_t sourcepitch;
+	uint8_t *source;
+
+	/* Check for valid parameters */
+	if (port == NULL ||
+		area->x2 < 0 ||
+		area->y2 < 0 ||
+		area->x1 > (int32_t)port->width - 1 ||
+		area->y1 > (int32_t)port->height - 1)
+	{
+		lv_display_flush_ready(display);
+
+		return;
+	}
+
+	/* Clip the drawing area to the screen */
+	int32_t act_x1 = area->x1 < 0 ? 0 : area->x1;
+	int32_t act_y1 = area->y1 < 0 ? 0 : area->y1;
+	int32_t act_x2 = area->x2 > (int32_t)port->width - 1 ? (int32_t)port->width - 1 : area->x2;
+	int32_t act_y2 = area->y2 > (int32_t)port->height - 1 ? (int32_t)port->height - 1 : area->y2;
+
+	width = act_x2 - act_x1 + 1;
+	height = act_y2 - act_y1 + 1;
+
+	/* Locate the first pixel of the clipped area in the render buffer */
+	stride = lv_draw_buf_width_to_stride(lv_area_get_width(area), lv_display_get_color_format(display));
+	source = px_map + ((act_y1 - area->y1) * stride) + ((act_x1 - area->x1) * (LV_COLOR_DEPTH / 8));
+	sourcepitch = stride;
+
+	/* Update statistics */
+	port->statistics.flushcount++;
+	if (lv_display_flush_is_last(display))
+		port->statistics.framecount++;
+
+	/* Convert the area to the framebuffer color format if required */
+	if (port->convert)
+	{
+		for (row = 0; row < height; row++)
+		{
+			lv_ultibo_color_convert(source + (row * stride), (uint8_t *)port->convertbuffer + (row * width * port->bytes), width, port->properties.format);
+		}
+
+		port->statistics.convertcount += width * height;
+
+		source = port->convertbuffer;
+		sourcepitch = width * port->bytes;
+	}
+
+	/* A software cursor must be hidden while the area is written */
+	softcursor = port->cursorshow && !(port->properties.flags & FRAMEBUFFER_FLAG_CURSOR);
+
+	/* Start an asynchronous flush, the DMA completion callback signals LVGL */
+	if (port->flushmode != LV_ULTIBO_FLUSH_MODE_CPU && !softcursor)
+	{
+		if (lv_ultibo_flush_submit(port, act_x1, act_y1, source, width, height, sourcepitch) == ERROR_SUCCESS)
+		{
+			port->statistics.dmacount++;
+
+			return;
+		}
+
+		port->statistics.dmaerrors++;
+	}
+
+	/* Hide the cursor if needed */
+	if (softcursor)
+		framebuffer_device_update_cursor(port->framebuffer, FALSE, port->cursorx, port->cursory, FALSE);
+
+	/* Render the area synchronously to the display device */
+	framebuffer_device_put_rect(port->framebuffer, act_x1, act_y1, (void *)source, width, height, (sourcepitch / port->bytes) - width, port->dmabuffers ? FRAMEBUFFER_TRANSFER_DMA : FRAMEBUFFER_TRANSFER_NONE);
+
+	/* Show the cursor if needed */
+	if (softcursor)
+		framebuffer_device_update_cursor(port->framebuffer, TRUE, port->cursorx, port->cursory, FALSE);
+
+	port->statistics.cpucount++;
+
+	/* Indicate to LVGL we are ready with the flushing */
+	lv_display_flush_ready(display);
+}
+
+static void lv_ultibo_flush_wait_callback(lv_display_t *display)
+{
+	LV_ULTIBO_DISPLAY *port = (LV_ULTIBO_DISPLAY *)lv_display_get_driver_data(display);
+	int64_t start;
+
+	if (port == NULL || !port->pending)
+		return;
+
+	start = clock_microseconds();
+
+	/* Sleep until the DMA completion callback signals the event */
+	while (port->pending)
+	{
+		if (event_wait_ex(port->completed, LV_ULTIBO_FLUSH_TIMEOUT) != ERROR_SUCCESS)
+		{
+			#ifdef DEBUG
+			logging_output("LVGL: Timeout waiting for DMA flush, falling back to CPU flush");
+			#endif
+
+			/* Stop using DMA for this display */
+			port->statistics.dmaerrors++;
+			port->flushmode = LV_ULTIBO_FLUSH_MODE_CPU;
+			break;
+		}
+	}
+
+	port->statistics.waitcount++;
+	port->statistics.waittime += clock_microseconds() - start;
+}
+
+static void lv_ultibo_report_callback(lv_timer_t *timer)
+{
+	LV_ULTIBO_DISPLAY *port = (LV_ULTIBO_DISPLAY *)lv_timer_get_user_data(timer);
+	double_t total;
+	uint32_t cpucount;
+	uint32_t cpuid;
+	uint32_t frames;
+	int64_t current;
+	int64_t elapsed;
+
+	current = clock_microseconds();
+	elapsed = current - port->reporttime;
+	if (elapsed <= 0)
+		return;
+
+	/* Frames per second since the last update */
+	frames = port->statistics.framecount - port->reportframes;
+	port->statistics.fps = ((int64_t)frames * 1000000 + (elapsed / 2)) / elapsed;
+
+	/* Utilization of all CPUs and of the CPU running LVGL */
+	total = 0;
+	cpucount = cpu_get_count();
+	for (cpuid = 0; cpuid < cpucount; cpuid++)
+	{
+		total += cpu_get_percentage(cpuid);
+	}
+	port->statistics.cpuusage = (uint32_t)(total / cpucount);
+	port->statistics.cpucurrent = (uint32_t)cpu_get_percentage(cpu_get_current());
+
+	port->reporttime = current;
+	port->reportframes = port->statistics.framecount;
+
+	if (port->flags & LV_ULTIBO_DISPLAY_FLAG_REPORT)
+	{
+		logging_outputf("LVGL: FPS %u CPU %u%% (LVGL CPU %u%%) Flushes %u (DMA %u CPU %u) Wait %u us\n",
+			(unsigned int)port->statistics.fps,
+			(unsigned int)port->statistics.cpuusage,
+			(unsigned int)port->statistics.cpucurrent,
+			(unsigned int)port->statistics.flushcount,
+			(unsigned int)port->statistics.dmacount,
+			(unsigned int)port->statistics.cpucount,
+			(unsigned int)port->statistics.waittime);
+	}
+}
+
+static void lv_ultibo_buffer_release(LV_ULTIBO_DISPLAY *port, void *buffer)
+{
+	if (!buffer)
+		return;
+
+	if (port->dmabuffers)
+		dma_release_buffer(buffer);
+	else
+		free(buffer);
+}
+
+static void *lv_ultibo_buffer_allocate(LV_ULTIBO_DISPLAY *port, uint32_t size)
+{
+	if (port->dmabuffers)
+		return dma_allocate_buffer(size);
+
+	return malloc(size);
+}
+
+static void lv_ultibo_display_free(LV_ULTIBO_DISPLAY *port)
+{
+	/* Wait for any pending flush */
+	if (port->pending && port->completed != INVALID_HANDLE_VALUE)
+		event_wait_ex(port->completed, LV_ULTIBO_FLUSH_TIMEOUT);
+
+	if (port->timer)
+		lv_timer_delete(port->timer);
+
+	if (port->completed != INVALID_HANDLE_VALUE)
+		event_destroy(port->completed);
+
+	lv_ultibo_buffer_release(port, port->buffer1);
+	lv_ultibo_buffer_release(port, port->buffer2);
+	lv_ultibo_buffer_release(port, port->convertbuffer);
+
+	free(port->data);
+	free(port);
+}
+
+static void lv_ultibo_display_delete_callback(lv_event_t *event)
+{
+	LV_ULTIBO_DISPLAY *port = (LV_ULTIBO_DISPLAY *)lv_event_get_user_data(event);
+
+	if (port)
+		lv_ultibo_display_free(port);
+}
+
+static void lv_ultibo_flush_mode_init(LV_ULTIBO_DISPLAY *port)
+{
+	DMA_PROPERTIES dmaproperties;
+	uint32_t rowbytes;
+
+	port->flushmode = LV_ULTIBO_FLUSH_MODE_CPU;
+
+	/* Check the framebuffer can be written directly by DMA without mark, commit or rotation */
+	if (port->flags & LV_ULTIBO_DISPLAY_FLAG_NO_DMA)
+		return;
+	if (!port->dmabuffers || port->properties.address == 0)
+		return;
+	if (!(port->properties.flags & FRAMEBUFFER_FLAG_DMA))
+		return;
+	if (port->properties.flags & (FRAMEBUFFER_FLAG_MARK | FRAMEBUFFER_FLAG_COMMIT))
+		return;
+	if (port->properties.rotation != FRAMEBUFFER_ROTATION_0)
+		return;
+
+	port->dma = dma_host_get_default();
+	if (!port->dma)
+		return;
+	if (dma_host_properties(port->dma, &dmaproperties) != ERROR_SUCCESS)
+		return;
+
+	/* Use 2D stride if the host can cover a full screen width and height in one block */
+	rowbytes = port->width * port->bytes;
+	if ((dmaproperties.flags & DMA_FLAG_STRIDE) &&
+		rowbytes <= dmaproperties.maxlength &&
+		port->height <= dmaproperties.maxcount &&
+		port->properties.pitch <= dmaproperties.maxstride)
+	{
+		port->datacount = 1;
+		port->flushmode = LV_ULTIBO_FLUSH_MODE_DMA_STRIDE;
+	} else {
+		port->datacount = port->height;
+		port->flushmode = LV_ULTIBO_FLUSH_MODE_DMA_ROWS;
+	}
+
+	port->data = calloc(port->datacount, sizeof(DMA_DATA));
+	port->completed = event_create(TRUE, TRUE);
+	if (!port->data || port->completed == INVALID_HANDLE_VALUE)
+	{
+		port->flushmode = LV_ULTIBO_FLUSH_MODE_CPU;
+		port->datacount = 0;
+	}
+}
+
+/* ============================================================================== */
+/* LVGL Display Functions */
+lv_display_t *lv_ultibo_display_create(FRAMEBUFFER_DEVICE *framebuffer, uint32_t flags)
+{
+	LV_ULTIBO_DISPLAY *port;
+	uint32_t pixels;
+
+	/* Get default framebuffer device */
+	if (!framebuffer)
+		framebuffer = framebuffer_device_get_default();
+	if (!framebuffer)
+		return NULL;
+
+	port = calloc(1, sizeof(LV_ULTIBO_DISPLAY));
+	if (!port)
+		return NULL;
+
+	port->flags = flags;
+	port->framebuffer = framebuffer;
+	port->completed = INVALID_HANDLE_VALUE;
+
+	/* Get the properties of the framebuffer device */
+	if (framebuffer_device_get_properties(framebuffer, &port->properties) != ERROR_SUCCESS)
+	{
+		free(port);
+		return NULL;
+	}
+
+	port->width = port->properties.physicalwidth;
+	port->height = port->properties.physicalheight;
+	port->bytes = lv_ultibo_color_format_bytes(port->properties.format);
+	if (port->bytes == 0)
+	{
+		#ifdef DEBUG
+		logging_outputf("LVGL: Unsupported framebuffer color format %u\n", (unsigned int)port->properties.format);
+		#endif
+		free(port);
+		return NULL;
+	}
+
+	/* LVGL renders ARGB8888 which is COLOR_FORMAT_ARGB32 (or URGB32) in Ultibo */
+	port->convert = (port->properties.format != COLOR_FORMAT_ARGB32 && port->properties.format != COLOR_FORMAT_URGB32);
+
+	/* Allocate render buffers (1/LV_ULTIBO_BUFFER_DIVISOR of screen size) */
+	port->dmabuffers = dma_available();
+	pixels = (port->width * port->height) / LV_ULTIBO_BUFFER_DIVISOR;
+	if (pixels < port->width)
+		pixels = port->width;
+
+	port->buffersize = pixels * (LV_COLOR_DEPTH / 8);
+	port->buffer1 = lv_ultibo_buffer_allocate(port, port->buffersize);
+	if (flags & LV_ULTIBO_DISPLAY_FLAG_DOUBLE_BUFFER)
+		port->buffer2 = lv_ultibo_buffer_allocate(port, port->buffersize);
+	if (port->convert)
+		port->convertbuffer = lv_ultibo_buffer_allocate(port, pixels * port->bytes);
+
+	if (!port->buffer1 || ((flags & LV_ULTIBO_DISPLAY_FLAG_DOUBLE_BUFFER) && !port->buffer2) || (port->convert && !port->convertbuffer))
+	{
+		lv_ultibo_display_free(port);
+		return NULL;
+	}
+
+	/* Select the flush mode */
+	lv_ultibo_flush_mode_init(port);
+
+	/* Create the LVGL display */
+	port->display = lv_display_create(port->width, port->height);
+	if (!port->display)
+	{
+		lv_ultibo_display_free(port);
+		return NULL;
+	}
+
+	lv_display_set_driver_data(port->display, port);
+	lv_display_set_flush_cb(port->display, lv_ultibo_flush_callback);
+	if (port->flushmode != LV_ULTIBO_FLUSH_MODE_CPU)
+		lv_display_set_flush_wait_cb(port->display, lv_ultibo_flush_wait_callback);
+	lv_display_set_buffers(port->display, port->buffer1, port->buffer2, port->buffersize, LV_DISPLAY_RENDER_MODE_PARTIAL);
+	lv_display_add_event_cb(port->display, lv_ultibo_display_delete_callback, LV_EVENT_DELETE, port);
+
+	/* Start the statistics timer */
+	port->reporttime = clock_microseconds();
+	port->timer = lv_timer_create(lv_ultibo_report_callback, LV_ULTIBO_REPORT_INTERVAL, port);
+
+	/* Spread the software draw units across the secondary CPUs */
+	port->statistics.flushmode = port->flushmode;
+	if (!(flags & LV_ULTIBO_DISPLAY_FLAG_NO_AFFINITY) && cpu_get_count() > 1)
+		lv_ultibo_draw_set_affinity(CPU_ID_1, &port->statistics.drawunits);
+
+	#ifdef DEBUG
+	logging_output("LVGL display created");
+	logging_outputf(" Width = %u Height = %u Format = %u\n", (unsigned int)port->width, (unsigned int)port->height, (unsigned int)port->properties.format);
+	logging_outputf(" Buffer Size = %u Double Buffer = %u Convert = %u\n", (unsigned int)port->buffersize, (unsigned int)(port->buffer2 != NULL), (unsigned int)port->convert);
+	logging_outputf(" Flush Mode = %u Draw Units = %u\n", (unsigned int)port->flushmode, (unsigned int)port->statistics.drawunits);
+	#endif
+
+	return port->display;
+}
+
+uint32_t lv_ultibo_display_get_statistics(lv_display_t *display, LV_ULTIBO_STATISTICS *statistics)
+{
+	LV_ULTIBO_DISPLAY *port;
+
+	if (!display || !statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	port = (LV_ULTIBO_DISPLAY *)lv_display_get_driver_data(display);
+	if (!port)
+		return ERROR_INVALID_PARAMETER;
+
+	memcpy(statistics, &port->statistics, sizeof(LV_ULTIBO_STATISTICS));
+	statistics->flushmode = port->flushmode;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t lv_ultibo_display_reset_statistics(lv_display_t *display)
+{
+	LV_ULTIBO_DISPLAY *port;
+
+	if (!display)
+		return ERROR_INVALID_PARAMETER;
+
+	port = (LV_ULTIBO_DISPLAY *)lv_display_get_driver_data(display);
+	if (!port)
+		return ERROR_INVALID_PARAMETER;
+
+	port->statistics.framecount = 0;
+	port->statistics.flushcount = 0;
+	port->statistics.dmacount = 0;
+	port->statistics.cpucount = 0;
+	port->statistics.dmaerrors = 0;
+	port->statistics.waitcount = 0;
+	port->statistics.waittime = 0;
+	port->statistics.convertcount = 0;
+
+	port->reporttime = clock_microseconds();
+	port->reportframes = 0;
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* LVGL Input Internal Functions */
+static void lv_ultibo_pointer_configure(LV_ULTIBO_POINTER *pointer)
+{
+	TOUCH_PROPERTIES properties;
+	size_t argument2;
+
+	/* Set the rotation of the touch device if required */
+	if (touch_device_control(pointer->touch, TOUCH_CONTROL_SET_ROTATION, TOUCH_ROTATION_0, &argument2) != ERROR_SUCCESS)
+	{
+		#ifdef DEBUG
+		logging_output("LVGL: Failed to set rotation for touch device");
+		#endif
+	}
+
+	/* Get the properties of the touch device */
+	if (touch_device_get_properties(pointer->touch, &properties) == ERROR_SUCCESS)
+	{
+		/* Save the maximum X and Y values from the touch device */
+		pointer->maxx = properties.maxx;
+		pointer->maxy = properties.maxy;
+
+		/* Check if the touch device sends touch or mouse data */
+		pointer->usemouse = (properties.flags & TOUCH_FLAG_MOUSE_DATA) != 0;
+
+		/* Don't show the cursor for a touch device */
+		pointer->port->cursorshow = FALSE;
+	} else {
+		/* No touch properties, use mouse instead and show the cursor */
+		pointer->usemouse = TRUE;
+		pointer->port->cursorshow = TRUE;
+	}
+}
+
+static int32_t lv_ultibo_pointer_clamp(int32_t value, uint32_t limit)
+{
+	if (value < 0)
+		return 0;
+	if (value >= (int32_t)limit)
+		return limit - 1;
+
+	return value;
+}
+
+static void lv_ultibo_pointer_read_callback(lv_indev_t *indev, lv_indev_data_t *data)
+{
+	LV_ULTIBO_POINTER *pointer = (LV_ULTIBO_POINTER *)lv_indev_get_driver_data(indev);
+	LV_ULTIBO_DISPLAY *port = pointer->port;
+	double_t scaling_x;
+	double_t scaling_y;
+	uint32_t received;
+	uint32_t count;
+	uint32_t index;
+
+	/* Check if configuration was delayed for USB touch devices and if so try to configure the device now */
+	if (pointer->configdelay)
+	{
+		pointer->touch = touch_device_get_default();
+		if (pointer->touch)
+		{
+			/* Hide the cursor if previously shown */
+			if (port->cursorshow)
+				framebuffer_device_update_cursor(port->framebuffer, FALSE, pointer->lastx, pointer->lasty, FALSE);
+
+			pointer->usemouse = FALSE;
+			lv_ultibo_pointer_configure(pointer);
+
+			pointer->configdelay = FALSE;
+		}
+	}
+
+	if (pointer->usemouse)
+	{
+		/* Read all pending mouse records, merging consecutive movements */
+		while (mouse_device_read_all(NULL, pointer->mousebuffer, LV_ULTIBO_INPUT_READ_BATCH, INPUT_FLAG_NON_BLOCK, &received) == ERROR_SUCCESS)
+		{
+			/* Coalesce after the read so the number of records taken from the queue is still known */
+			count = mouse_data_coalesce(pointer->mousebuffer, received);
+
+			for (index = 0; index < count; index++)
+			{
+				MOUSE_DATA *mousedata = &pointer->mousebuffer[index];
+
+				/* Check for absolute X value */
+				if (mousedata->buttons & MOUSE_ABSOLUTE_X)
+				{
+					scaling_x = (double_t)mousedata->maximumx / (double_t)port->width;
+					if (scaling_x <= 0.0)
+						scaling_x = 1.0;
+
+					pointer->lastx = (double_t)(mousedata->offsetx / scaling_x);
+				} else
+					pointer->lastx += mousedata->offsetx;
+
+				/* Check for absolute Y value */
+				if (mousedata->buttons & MOUSE_ABSOLUTE_Y)
+				{
+					scaling_y = (double_t)mousedata->maximumy / (double_t)port->height;
+					if (scaling_y <= 0.0)
+						scaling_y = 1.0;
+
+					pointer->lasty = (double_t)(mousedata->offsety / scaling_y);
+				} else
+					pointer->lasty += mousedata->offsety;
+
+				pointer->lastx = lv_ultibo_pointer_clamp(pointer->lastx, port->width);
+				pointer->lasty = lv_ultibo_pointer_clamp(pointer->lasty, port->height);
+
+				/* Update the current touch state */
+				if (mousedata->buttons & (MOUSE_LEFT_BUTTON | MOUSE_TOUCH_BUTTON))
+					pointer->laststate = LV_INDEV_STATE_PRESSED;
+				else
+					pointer->laststate = LV_INDEV_STATE_RELEASED;
+			}
+
+			/* Stop once the queue has been emptied (A full batch may have coalesced to fewer records) */
+			if (received < LV_ULTIBO_INPUT_READ_BATCH)
+				break;
+		}
+	} else {
+		/* Read all pending touch records, keeping the latest position of each touch point */
+		while (touch_device_read_all(pointer->touch, pointer->touchbuffer, LV_ULTIBO_INPUT_READ_BATCH, INPUT_FLAG_NON_BLOCK, &received) == ERROR_SUCCESS)
+		{
+			count = touch_data_coalesce(pointer->touchbuffer, received);
+
+			for (index = 0; index < count; index++)
+			{
+				TOUCH_DATA *touchdata = &pointer->touchbuffer[index];
+
+				/* Check for the first touch point */
+				if (touchdata->pointid != 1)
+					continue;
+
+				/* Scale the X and Y values to the display */
+				scaling_x = (double_t)pointer->maxx / (double_t)port->width;
+				if (scaling_x <= 0.0)
+					scaling_x = 1.0;
+
+				scaling_y = (double_t)pointer->maxy / (double_t)port->height;
+				if (scaling_y <= 0.0)
+					scaling_y = 1.0;
+
+				pointer->lastx = lv_ultibo_pointer_clamp((double_t)(touchdata->positionx / scaling_x), port->width);
+				pointer->lasty = lv_ultibo_pointer_clamp((double_t)(touchdata->positiony / scaling_y), port->height);
+
+				/* Update the current touch state */
+				if (touchdata->info & TOUCH_FINGER)
+					pointer->laststate = LV_INDEV_STATE_PRESSED;
+				else
+					pointer->laststate = LV_INDEV_STATE_RELEASED;
+			}
+
+			/* Stop once the queue has been emptied (A full batch may have coalesced to fewer records) */
+			if (received < LV_ULTIBO_INPUT_READ_BATCH)
+				break;
+		}
+	}
+
+	data->state = pointer->laststate;
+	data->point.x = pointer->lastx;
+	data->point.y = pointer->lasty;
+
+	/* Update the cursor if needed */
+	if (port->cursorshow)
+	{
+		port->cursorx = pointer->lastx;
+		port->cursory = pointer->lasty;
+
+		framebuffer_device_update_cursor(port->framebuffer, TRUE, pointer->lastx, pointer->lasty, FALSE);
+	}
+}
+
+static void lv_ultibo_keypad_read_callback(lv_indev_t *indev, lv_indev_data_t *data)
+{
+	LV_ULTIBO_KEYPAD *keypad = (LV_ULTIBO_KEYPAD *)lv_indev_get_driver_data(indev);
+	uint32_t key;
+	lv_indev_state_t state;
+
+	/* Check for keypress */
+	if (console_keypressed())
+	{
+		/* Get key press */
+		key = (uint8_t)console_read_key();
+		if (key != 0)
+		{
+			state = LV_INDEV_STATE_PRESSED;
+		} else {
+			/* Get and translate extended key */
+			key = (uint8_t)console_read_key();
+
+			state = LV_INDEV_STATE_PRESSED;
+			switch (key)
+			{
+				case 0x48 :
+					key = LV_KEY_UP;
+					break;
+				case 0x50 :
+					key = LV_KEY_DOWN;
+					break;
+				case 0x4D :
+					key = LV_KEY_RIGHT;
+					break;
+				case 0x4B :
+					key = LV_KEY_LEFT;
+					break;
+				case 0x53 :
+					key = LV_KEY_DEL;
+					break;
+				case KEY_CODE_ENTER :
+					key = LV_KEY_ENTER;
+					break;
+				case 0x0F :
+					key = LV_KEY_PREV;
+					break;
+				case 0x47 :
+					key = LV_KEY_HOME;
+					break;
+				case 0x4F :
+					key = LV_KEY_END;
+					break;
+				default :
+					key = keypad->lastkey;
+					state = LV_INDEV_STATE_RELEASED;
+			}
+		}
+
+		data->key = key;
+		data->state = state;
+
+		/* Update last key */
+		keypad->lastkey = key;
+	} else {
+		/* Store key release */
+		data->key = keypad->lastkey;
+		data->state = LV_INDEV_STATE_RELEASED;
+
+		/* Clear last key */
+		keypad->lastkey = 0;
+	}
+}
+
+static void lv_ultibo_indev_delete_callback(lv_event_t *event)
+{
+	free(lv_event_get_user_data(event));
+}
+
+/* ============================================================================== */
+/* LVGL Input Functions */
+lv_indev_t *lv_ultibo_pointer_create(lv_display_t *display, TOUCH_DEVICE *touch)
+{
+	LV_ULTIBO_POINTER *pointer;
+	lv_indev_t *indev;
+
+	if (!display || !lv_display_get_driver_data(display))
+		return NULL;
+
+	pointer = calloc(1, sizeof(LV_ULTIBO_POINTER));
+	if (!pointer)
+		return NULL;
+
+	pointer->port = (LV_ULTIBO_DISPLAY *)lv_display_get_driver_data(display);
+
+	/* Get default touch device */
+	pointer->touch = touch ? touch : touch_device_get_default();
+	if (pointer->touch)
+	{
+		lv_ultibo_pointer_configure(pointer);
+	} else {
+		/* No touch device, use mouse instead and show the cursor */
+		pointer->usemouse = TRUE;
+		pointer->port->cursorshow = TRUE;
+
+		/* For USB touch screen devices it may be necessary to delay the configuration
+		 * to allow time for the USB device enumeration, initialization and binding */
+		pointer->configdelay = TRUE;
+	}
+
+	/* Setup last position */
+	pointer->lastx = pointer->port->width / 2;
+	pointer->lasty = pointer->port->height / 2;
+	pointer->laststate = LV_INDEV_STATE_RELEASED;
+
+	/* Enable cursor if needed */
+	if (pointer->port->cursorshow)
+	{
+		pointer->port->cursorx = pointer->lastx;
+		pointer->port->cursory = pointer->lasty;
+
+		framebuffer_device_set_cursor(pointer->port->framebuffer, 0, 0, 0, 0, NULL, 0);
+		framebuffer_device_update_cursor(pointer->port->framebuffer, TRUE, pointer->lastx, pointer->lasty, FALSE);
+	}
+
+	indev = lv_indev_create();
+	if (!indev)
+	{
+		free(pointer);
+		return NULL;
+	}
+
+	lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
+	lv_indev_set_read_cb(indev, lv_ultibo_pointer_read_callback);
+	lv_indev_set_driver_data(indev, pointer);
+	lv_indev_set_display(indev, display);
+	lv_indev_add_event_cb(indev, lv_ultibo_indev_delete_callback, LV_EVENT_DELETE, pointer);
+
+	return indev;
+}
+
+lv_indev_t *lv_ultibo_keypad_create(lv_display_t *display)
+{
+	LV_ULTIBO_KEYPAD *keypad;
+	lv_indev_t *indev;
+
+	keypad = calloc(1, sizeof(LV_ULTIBO_KEYPAD));
+	if (!keypad)
+		return NULL;
+
+	indev = lv_indev_create();
+	if (!indev)
+	{
+		free(keypad);
+		return NULL;
+	}
+
+	lv_indev_set_type(indev, LV_INDEV_TYPE_KEYPAD);
+	lv_indev_set_read_cb(indev, lv_ultibo_keypad_read_callback);
+	lv_indev_set_driver_data(indev, keypad);
+	if (display)
+		lv_indev_set_display(indev, display);
+	lv_indev_add_event_cb(indev, lv_ultibo_indev_delete_callback, LV_EVENT_DELETE, keypad);
+
+	return indev;
+}
+
+/* ============================================================================== */
+/* LVGL Port Helper Functions */
+uint32_t lv_ultibo_tick_init(void)
+{
+	/* Use the system tick count directly instead of a tick thread calling lv_tick_inc */
+	lv_tick_set_cb(lv_ultibo_tick_get);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t lv_ultibo_draw_set_affinity(uint32_t firstcpu, uint32_t *count)
+{
+	/* Only valid when every draw unit is a software unit running on a POSIX thread */
+	#if LV_USE_OS == LV_OS_PTHREAD && LV_USE_DRAW_SW && !(LV_USE_DRAW_VGLITE || LV_USE_DRAW_PXP || LV_USE_DRAW_DAVE2D || LV_USE_DRAW_SDL || LV_USE_DRAW_VG_LITE)
+	lv_draw_unit_t *unit;
+	lv_draw_sw_unit_t *swunit;
+	THREAD_HANDLE thread;
+	uint32_t cpucount;
+	uint32_t cpuid;
+
+	if (count)
+		*count = 0;
+
+	cpucount = cpu_get_count();
+	if (firstcpu >= cpucount)
+		return ERROR_INVALID_PARAMETER;
+
+	/* Assign each draw unit thread to the next CPU, wrapping back to the first */
+	cpuid = firstcpu;
+	unit = LV_GLOBAL_DEFAULT()->draw_info.unit_head;
+	while (unit)
+	{
+		swunit = (lv_draw_sw_unit_t *)unit;
+
+		/* On Ultibo a pthread_t is the same value as the THREAD_HANDLE */
+		thread = (THREAD_HANDLE)swunit->thread.thread;
+		if (thread != INVALID_HANDLE_VALUE && thread != 0)
+		{
+			if (thread_set_affinity(thread, 1 << cpuid) == ERROR_SUCCESS)
+			{
+				thread_migrate(thread, cpuid);
+
+				if (count)
+					(*count)++;
+			}
+
+			cpuid++;
+			if (cpuid >= cpucount)
+				cpuid = firstcpu;
+		}
+
+		unit = unit->next;
+	}
+
+	return ERROR_SUCCESS;
+	#else
+	if (count)
+		*count = 0;
+
+	return ERROR_NOT_SUPPORTED;
+	#endif
+}
+
+uint32_t lv_ultibo_color_format_bytes(uint32_t format)
+{
+	switch (format)
+	{
+		case COLOR_FORMAT_ARGB32:
+		case COLOR_FORMAT_ABGR32:
+		case COLOR_FORMAT_RGBA32:
+		case COLOR_FORMAT_BGRA32:
+		case COLOR_FORMAT_URGB32:
+		case COLOR_FORMAT_UBGR32:
+		case COLOR_FORMAT_RGBU32:
+		case COLOR_FORMAT_BGRU32:
+			return 4;
+		case COLOR_FORMAT_RGB24:
+		case COLOR_FORMAT_BGR24:
+			return 3;
+		case COLOR_FORMAT_RGB16:
+		case COLOR_FORMAT_BGR16:
+		case COLOR_FORMAT_RGB15:
+		case COLOR_FORMAT_BGR15:
+			return 2;
+	}
+
+	return 0;
+}
+
+#if defined(__ARM_NEON)
+/* Pack 8 bit channels into 5/6/5 bits, high channel in bits 15..11 */
+static inline uint16x8_t lv_ultibo_pack_565(uint8x8_t high, uint8x8_t middle, uint8x8_t low)
+{
+	uint16x8_t result = vshll_n_u8(high, 8);
+	result = vsriq_n_u16(result, vshll_n_u8(middle, 8), 5);
+	result = vsriq_n_u16(result, vshll_n_u8(low, 8), 11);
+	return result;
+}
+
+/* Pack 8 bit channels into 5/5/5 bits, high channel in bits 14..10 */
+static inline uint16x8_t lv_ultibo_pack_555(uint8x8_t high, uint8x8_t middle, uint8x8_t low)
+{
+	uint16x8_t result = vshll_n_u8(high, 7);
+	result = vsriq_n_u16(result, vshll_n_u8(middle, 8), 6);
+	result = vsriq_n_u16(result, vshll_n_u8(low, 8), 11);
+	return result;
+}
+
+/* Convert 16 pixels at a time, returns the number of pixels converted */
+static uint32_t lv_ultibo_color_convert_neon(const uint8_t *source, uint8_t *dest, uint32_t count, uint32_t format)
+{
+	uint32_t index;
+	uint8x16x4_t pixels;
+	uint8x16x4_t output4;
+	uint8x16x3_t output3;
+	uint16x8x2_t output2;
+
+	/* LVGL ARGB8888 in memory is B,G,R,A so val[0] = Blue, val[1] = Green, val[2] = Red, val[3] = Alpha */
+	for (index = 0; index + 16 <= count; index += 16)
+	{
+		pixels = vld4q_u8(source + (index * 4));
+
+		switch (format)
+		{
+			case COLOR_FORMAT_ABGR32:
+			case COLOR_FORMAT_UBGR32:
+				output4.val[0] = pixels.val[2];
+				output4.val[1] = pixels.val[1];
+				output4.val[2] = pixels.val[0];
+				output4.val[3] = pixels.val[3];
+				vst4q_u8(dest + (index * 4), output4);
+				break;
+			case COLOR_FORMAT_RGBA32:
+			case COLOR_FORMAT_RGBU32:
+				output4.val[0] = pixels.val[3];
+				output4.val[1] = pixels.val[0];
+				output4.val[2] = pixels.val[1];
+				output4.val[3] = pixels.val[2];
+				vst4q_u8(dest + (index * 4), output4);
+				break;
+			case COLOR_FORMAT_BGRA32:
+			case COLOR_FORMAT_BGRU32:
+				output4.val[0] = pixels.val[3];
+				output4.val[1] = pixels.val[2];
+				output4.val[2] = pixels.val[1];
+				output4.val[3] = pixels.val[0];
+				vst4q_u8(dest + (index * 4), output4);
+				break;
+			case COLOR_FORMAT_RGB24:
+				output3.val[0] = pixels.val[0];
+				output3.val[1] = pixels.val[1];
+				output3.val[2] = pixels.val[2];
+				vst3q_u8(dest + (index * 3), output3);
+				break;
+			case COLOR_FORMAT_BGR24:
+				output3.val[0] = pixels.val[2];
+				output3.val[1] = pixels.val[1];
+				output3.val[2] = pixels.val[0];
+				vst3q_u8(dest + (index * 3), output3);
+				break;
+			case COLOR_FORMAT_RGB16:
+				output2.val[0] = lv_ultibo_pack_565(vget_low_u8(pixels.val[2]), vget_low_u8(pixels.val[1]), vget_low_u8(pixels.val[0]));
+				output2.val[1] = lv_ultibo_pack_565(vget_high_u8(pixels.val[2]), vget_high_u8(pixels.val[1]), vget_high_u8(pixels.val[0]));
+				vst1q_u16((uint16_t *)(dest + (index * 2)), output2.val[0]);
+				vst1q_u16((uint16_t *)(dest + (index * 2) + 16), output2.val[1]);
+				break;
+			case COLOR_FORMAT_BGR16:
+				output2.val[0] = lv_ultibo_pack_565(vget_low_u8(pixels.val[0]), vget_low_u8(pixels.val[1]), vget_low_u8(pixels.val[2]));
+				output2.val[1] = lv_ultibo_pack_565(vget_high_u8(pixels.val[0]), vget_high_u8(pixels.val[1]), vget_high_u8(pixels.val[2]));
+				vst1q_u16((uint16_t *)(dest + (index * 2)), output2.val[0]);
+				vst1q_u16((uint16_t *)(dest + (index * 2) + 16), output2.val[1]);
+				break;
+			case COLOR_FORMAT_RGB15:
+				output2.val[0] = lv_ultibo_pack_555(vget_low_u8(pixels.val[2]), vget_low_u8(pixels.val[1]), vget_low_u8(pixels.val[0]));
+				output2.val[1] = lv_ultibo_pack_555(vget_high_u8(pixels.val[2]), vget_high_u8(pixels.val[1]), vget_high_u8(pixels.val[0]));
+				vst1q_u16((uint16_t *)(dest + (index * 2)), output2.val[0]);
+				vst1q_u16((uint16_t *)(dest + (index * 2) + 16), output2.val[1]);
+				break;
+			case COLOR_FORMAT_BGR15:
+				output2.val[0] = lv_ultibo_pack_555(vget_low_u8(pixels.val[0]), vget_low_u8(pixels.val[1]), vget_low_u8(pixels.val[2]));
+				output2.val[1] = lv_ultibo_pack_555(vget_high_u8(pixels.val[0]), vget_high_u8(pixels.val[1]), vget_high_u8(pixels.val[2]));
+				vst1q_u16((uint16_t *)(dest + (index * 2)), output2.val[0]);
+				vst1q_u16((uint16_t *)(dest + (index * 2) + 16), output2.val[1]);
+				break;
+			default:
+				return index;
+		}
+	}
+
+	return index;
+}
+#endif
+
+uint32_t lv_ultibo_color_convert(const void *source, void *dest, uint32_t count, uint32_t format)
+{
+	const uint32_t *input;
+	uint8_t *output;
+	uint32_t bytes;
+	uint32_t index;
+	uint32_t pixel;
+	uint32_t red;
+	uint32_t green;
+	uint32_t blue;
+
+	if (!source || !dest)
+		return ERROR_INVALID_PARAMETER;
+
+	bytes = lv_ultibo_color_format_bytes(format);
+	if (bytes == 0)
+		return ERROR_NOT_SUPPORTED;
+
+	/* No conversion required */
+	if (format == COLOR_FORMAT_ARGB32 || format == COLOR_FORMAT_URGB32)
+	{
+		memcpy(dest, source, count * 4);
+		return ERROR_SUCCESS;
+	}
+
+	index = 0;
+	#if defined(__ARM_NEON)
+	index = lv_ultibo_color_convert_neon((const uint8_t *)source, (uint8_t *)dest, count, format);
+	#endif
+
+	/* Convert remaining pixels (or all pixels without NEON) */
+	input = (const uint32_t *)source;
+	output = (uint8_t *)dest + (index * bytes);
+	for (; index < count; index++)
+	{
+		pixel = input[index];
+		red = (pixel >> 16) & 0xFF;
+		green = (pixel >> 8) & 0xFF;
+		blue = pixel & 0xFF;
+
+		switch (format)
+		{
+			case COLOR_FORMAT_ABGR32:
+			case COLOR_FORMAT_UBGR32:
+				*(uint32_t *)output = (pixel & 0xFF00FF00) | (blue << 16) | red;
+				break;
+			case COLOR_FORMAT_RGBA32:
+			case COLOR_FORMAT_RGBU32:
+				*(uint32_t *)output = (pixel << 8) | (pixel >> 24);
+				break;
+			case COLOR_FORMAT_BGRA32:
+			case COLOR_FORMAT_BGRU32:
+				*(uint32_t *)output = (blue << 24) | (green << 16) | (red << 8) | (pixel >> 24);
+				break;
+			case COLOR_FORMAT_RGB24:
+				output[0] = blue;
+				output[1] = green;
+				output[2] = red;
+				break;
+			case COLOR_FORMAT_BGR24:
+				output[0] = red;
+				output[1] = green;
+				output[2] = blue;
+				break;
+			case COLOR_FORMAT_RGB16:
+				*(uint16_t *)output = ((red >> 3) << 11) | ((green >> 2) << 5) | (blue >> 3);
+				break;
+			case COLOR_FORMAT_BGR16:
+				*(uint16_t *)output = ((blue >> 3) << 11) | ((green >> 2) << 5) | (red >> 3);
+				break;
+			case COLOR_FORMAT_RGB15:
+				*(uint16_t *)output = ((red >> 3) << 10) | ((green >> 3) << 5) | (blue >> 3);
+				break;
+			case COLOR_FORMAT_BGR15:
+				*(uint16_t *)output = ((blue >> 3) << 10) | ((green >> 3) << 5) | (red >> 3);
+				break;
+		}
+
+		output += bytes;
+	}
+
+	return ERROR_SUCCESS;
+}
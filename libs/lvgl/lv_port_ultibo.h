@@ -0,0 +1,111 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _LV_PORT_ULTIBO_H
+#define _LV_PORT_ULTIBO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/framebuffer.h"
+#include "ultibo/dma.h"
+#include "ultibo/mouse.h"
+#include "ultibo/touch.h"
+
+#include "lv_conf.h"
+#include "lvgl/lvgl.h"
+
+/* ============================================================================== */
+/* LVGL Port specific constants */
+#define LV_ULTIBO_BUFFER_DIVISOR	10 // Size of each render buffer as a fraction of the screen size
+#define LV_ULTIBO_FLUSH_TIMEOUT	1000 // Maximum time to wait for an asynchronous flush to complete (Milliseconds)
+#define LV_ULTIBO_REPORT_INTERVAL	1000 // Interval between updates of the FPS and CPU statistics (Milliseconds)
+#define LV_ULTIBO_INPUT_READ_BATCH	32 // Maximum number of mouse or touch records to read in each call from the pointer read callback
+
+/* LVGL Display Flags */
+#define LV_ULTIBO_DISPLAY_FLAG_NONE	0x00000000
+#define LV_ULTIBO_DISPLAY_FLAG_DOUBLE_BUFFER	0x00000001 // Allocate two render buffers so rendering of one overlaps the flush of the other
+#define LV_ULTIBO_DISPLAY_FLAG_NO_DMA	0x00000002 // Do not use asynchronous DMA, flush synchronously with framebuffer_device_put_rect
+#define LV_ULTIBO_DISPLAY_FLAG_NO_AFFINITY	0x00000004 // Do not pin the software draw unit threads to separate CPUs (Only has an effect if LVGL was built with LV_DRAW_SW_DRAW_UNIT_CNT > 1)
+#define LV_ULTIBO_DISPLAY_FLAG_REPORT	0x00000008 // Log the FPS and CPU statistics every LV_ULTIBO_REPORT_INTERVAL
+
+/* LVGL Flush Modes */
+#define LV_ULTIBO_FLUSH_MODE_CPU	0 // Synchronous flush using framebuffer_device_put_rect
+#define LV_ULTIBO_FLUSH_MODE_DMA_STRIDE	1 // Asynchronous DMA flush using a single 2D stride data block
+#define LV_ULTIBO_FLUSH_MODE_DMA_ROWS	2 // Asynchronous DMA flush using one data block per row (Host does not support 2D stride)
+
+/* ============================================================================== */
+/* LVGL Port specific types */
+
+/* LVGL Display Statistics */
+typedef struct _LV_ULTIBO_STATISTICS LV_ULTIBO_STATISTICS;
+struct _LV_ULTIBO_STATISTICS
+{
+	uint32_t flushmode; // The flush mode selected for the display (eg LV_ULTIBO_FLUSH_MODE_DMA_STRIDE)
+	uint32_t drawunits; // Number of software draw units pinned to a CPU
+	uint32_t framecount; // Number of complete frames flushed to the display
+	uint32_t flushcount; // Number of areas flushed to the display
+	uint32_t dmacount; // Number of areas flushed by asynchronous DMA
+	uint32_t cpucount; // Number of areas flushed synchronously by the CPU
+	uint32_t dmaerrors; // Number of asynchronous DMA flushes that failed
+	uint32_t waitcount; // Number of times LVGL had to wait for an asynchronous flush to complete
+	int64_t waittime; // Total time LVGL spent waiting for asynchronous flushes to complete (Microseconds)
+	int64_t convertcount; // Number of pixels converted to the framebuffer color format
+	uint32_t fps; // Frames per second during the last report interval
+	uint32_t cpuusage; // Average utilization of all CPUs during the last report interval (Percent)
+	uint32_t cpucurrent; // Utilization of the CPU running LVGL during the last report interval (Percent)
+};
+
+/* ============================================================================== */
+/* LVGL Display Functions */
+lv_display_t *lv_ultibo_display_create(FRAMEBUFFER_DEVICE *framebuffer, uint32_t flags);
+
+uint32_t lv_ultibo_display_get_statistics(lv_display_t *display, LV_ULTIBO_STATISTICS *statistics);
+uint32_t lv_ultibo_display_reset_statistics(lv_display_t *display);
+
+/* ============================================================================== */
+/* LVGL Input Functions */
+lv_indev_t *lv_ultibo_pointer_create(lv_display_t *display, TOUCH_DEVICE *touch);
+lv_indev_t *lv_ultibo_keypad_create(lv_display_t *display);
+
+/* ============================================================================== */
+/* LVGL Port Helper Functions */
+uint32_t lv_ultibo_tick_init(void);
+
+uint32_t lv_ultibo_draw_set_affinity(uint32_t firstcpu, uint32_t *count);
+
+uint32_t lv_ultibo_color_convert(const void *source, void *dest, uint32_t count, uint32_t format);
+uint32_t lv_ultibo_color_format_bytes(uint32_t format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _LV_PORT_ULTIBO_H
@@ -0,0 +1,1486 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/heapmanager.h"
+#include "ultibo/filesystem.h"
+#include "ultibo/storage.h"
+
+#include "sqlite3_port_ultibo.h"
+
+/*
+ * Implementation of the Ultibo VFS port for SQLite
+ *
+ * The file VFS (SQLITE3_ULTIBO_VFS_NAME) reads and writes database, journal and
+ * WAL files with the Ultibo file handle functions, the page sized and page aligned
+ * requests from SQLite are passed straight to FileRead and FileWrite without the
+ * C library buffering and a seek is only made when a request does not follow on
+ * from the previous one. A sync flushes only the handle of the file being synced.
+ *
+ * A storage VFS places one database directly on a range of blocks of a storage
+ * device (For example a partition without a filesystem), the first block holds a
+ * header describing three fixed extents for the rollback journal, the WAL and the
+ * database itself. Requests that cover whole blocks are passed straight to the
+ * device, only the partial blocks at either end of a request are read and written
+ * through a block buffer. The header is written when a file is created, deleted,
+ * synced or closed, so the size of each extent is durable at the same points that
+ * SQLite expects a file size to be durable. A transaction that needs more space
+ * than the journal extent holds fails with SQLITE_FULL, in WAL mode the extent
+ * must also hold every frame written between checkpoints.
+ *
+ * Temporary files are held in memory with both VFS types.
+ *
+ * Locking is within this process only, which on Ultibo covers every thread. The
+ * lock levels of each database follow the same rules as the unix VFS, and the WAL
+ * index used by WAL mode is kept in regions of shared memory (alloc_shared_mem)
+ * with the eight WAL locks counted per database.
+ */
+
+/* ============================================================================== */
+/* SQLite Port specific constants */
+#define SQLITE3_ULTIBO_SIGNATURE	0x51534C55 // Signature for VFS validation
+
+#define SQLITE3_ULTIBO_HEADER_MAGIC	0x56514C53 // Magic number of the storage header block
+#define SQLITE3_ULTIBO_HEADER_VERSION	1
+
+/* File Kinds */
+#define SQLITE3_ULTIBO_KIND_FILE	0 // Ultibo file handle
+#define SQLITE3_ULTIBO_KIND_STORAGE	1 // Extent of a storage device
+#define SQLITE3_ULTIBO_KIND_MEMORY	2 // Temporary file in memory
+
+/* Storage Extents */
+#define SQLITE3_ULTIBO_EXTENT_MAIN	0
+#define SQLITE3_ULTIBO_EXTENT_JOURNAL	1
+#define SQLITE3_ULTIBO_EXTENT_WAL	2
+#define SQLITE3_ULTIBO_EXTENT_COUNT	3
+
+#define SQLITE3_ULTIBO_EXTENT_NONE	0xFFFFFFFF
+
+#define SQLITE3_ULTIBO_STORAGE_NODE	"main" // Lock node name of the database on a storage device
+
+/* ============================================================================== */
+/* SQLite Port specific types */
+
+/* WAL Index (Shared memory of one database) */
+typedef struct _SQLITE3_ULTIBO_SHM SQLITE3_ULTIBO_SHM;
+struct _SQLITE3_ULTIBO_SHM
+{
+	void **regions; // Mapped regions
+	int regioncount; // Number of regions mapped
+	int regionsize; // Size of each region (Bytes)
+	int16_t locks[SQLITE_SHM_NLOCK]; // Count of shared holders of each lock or -1 if held exclusive
+	uint32_t refcount; // Number of connections with the index mapped
+};
+
+/* Lock Node (One per open database) */
+typedef struct _SQLITE3_ULTIBO_NODE SQLITE3_ULTIBO_NODE;
+struct _SQLITE3_ULTIBO_NODE
+{
+	char *path; // Full path of the database (Or SQLITE3_ULTIBO_STORAGE_NODE)
+	uint32_t refcount; // Number of files open on this database
+	int locktype; // Highest lock held on the database (eg SQLITE_LOCK_SHARED)
+	int sharedcount; // Number of files holding at least a shared lock
+	SQLITE3_ULTIBO_SHM *shm; // WAL index (NULL if not mapped)
+	SQLITE3_ULTIBO_NODE *next;
+};
+
+/* Storage Extent */
+typedef struct _SQLITE3_ULTIBO_EXTENT SQLITE3_ULTIBO_EXTENT;
+struct _SQLITE3_ULTIBO_EXTENT
+{
+	int64_t start; // First block of the extent (Relative to the start of the region)
+	int64_t capacity; // Number of blocks in the extent
+	int64_t size; // Current size of the file held in the extent (Bytes)
+	uint32_t exists; // Non zero if the file exists
+	uint32_t reserved;
+};
+
+/* Storage Header (Block 0 of the region) */
+typedef struct _SQLITE3_ULTIBO_HEADER SQLITE3_ULTIBO_HEADER;
+struct _SQLITE3_ULTIBO_HEADER
+{
+	uint32_t magic; // SQLITE3_ULTIBO_HEADER_MAGIC
+	uint32_t version; // SQLITE3_ULTIBO_HEADER_VERSION
+	uint32_t blocksize; // Block size of the device when formatted
+	uint32_t extentcount; // SQLITE3_ULTIBO_EXTENT_COUNT
+	int64_t blockcount; // Number of blocks in the region when formatted
+	SQLITE3_ULTIBO_EXTENT extents[SQLITE3_ULTIBO_EXTENT_COUNT];
+};
+
+/* Ultibo VFS */
+typedef struct _SQLITE3_ULTIBO_VFS SQLITE3_ULTIBO_VFS;
+struct _SQLITE3_ULTIBO_VFS
+{
+	sqlite3_vfs base; // SQLite VFS (Must be first)
+	uint32_t signature; // SQLITE3_ULTIBO_SIGNATURE
+	uint32_t kind; // SQLITE3_ULTIBO_KIND_FILE or SQLITE3_ULTIBO_KIND_STORAGE
+	char *name; // VFS name
+	MUTEX_HANDLE lock; // Lock protecting the nodes, lock levels and WAL indexes
+	SQLITE3_ULTIBO_NODE *nodes; // Open databases
+	SPIN_HANDLE statisticslock;
+	SQLITE3_ULTIBO_STATISTICS statistics;
+	/* Storage Properties */
+	STORAGE_DEVICE *storage; // Storage device
+	int64_t start; // First block of the region
+	int64_t count; // Number of blocks in the region
+	uint32_t blocksize; // Block size of the device (Bytes)
+	MUTEX_HANDLE iolock; // Lock protecting the block buffer and header
+	uint8_t *block; // Block buffer for partial block requests
+	SQLITE3_ULTIBO_HEADER header; // Current header
+	BOOL headerdirty; // Header has changed since it was last written
+};
+
+/* Ultibo File */
+typedef struct _SQLITE3_ULTIBO_FILE SQLITE3_ULTIBO_FILE;
+struct _SQLITE3_ULTIBO_FILE
+{
+	sqlite3_file base; // SQLite file (Must be first)
+	SQLITE3_ULTIBO_VFS *vfs; // VFS that opened the file
+	uint32_t kind; // File kind (eg SQLITE3_ULTIBO_KIND_FILE)
+	/* File Properties */
+	HANDLE handle; // Ultibo file handle
+	int64_t position; // Current position of the handle (-1 if unknown)
+	char *deletepath; // Path to delete on close (NULL if not delete on close)
+	/* Storage Properties */
+	uint32_t extent; // Extent holding the file (eg SQLITE3_ULTIBO_EXTENT_WAL)
+	/* Memory Properties */
+	uint8_t *data; // File content
+	int64_t size; // File size (Bytes)
+	int64_t capacity; // Allocated size of data (Bytes)
+	/* Lock Properties */
+	SQLITE3_ULTIBO_NODE *node; // Lock node (NULL for files other than a main database)
+	int locktype; // Lock held by this file (eg SQLITE_LOCK_RESERVED)
+	uint16_t sharedmask; // WAL locks held shared by this file
+	uint16_t exclusivemask; // WAL locks held exclusive by this file
+	BOOL shmmapped; // This file has the WAL index mapped
+};
+
+static const sqlite3_io_methods sqlite3_ultibo_io_methods;
+
+/* ============================================================================== */
+/* SQLite Port Internal Functions */
+static SQLITE3_ULTIBO_VFS *sqlite3_ultibo_vfs_check(const char *name)
+{
+	sqlite3_vfs *base;
+	SQLITE3_ULTIBO_VFS *vfs;
+
+	base = sqlite3_vfs_find(name);
+	if (!base)
+		return NULL;
+
+	vfs = (SQLITE3_ULTIBO_VFS *)base->pAppData;
+	if (vfs != (SQLITE3_ULTIBO_VFS *)base || vfs->signature != SQLITE3_ULTIBO_SIGNATURE)
+		return NULL;
+
+	return vfs;
+}
+
+static void sqlite3_ultibo_account(SQLITE3_ULTIBO_VFS *vfs, uint32_t *counter, uint64_t *bytes, uint64_t amount)
+{
+	spin_lock(vfs->statisticslock);
+	if (counter)
+		(*counter)++;
+	if (bytes)
+		*bytes += amount;
+	spin_unlock(vfs->statisticslock);
+}
+
+static SQLITE3_ULTIBO_NODE *sqlite3_ultibo_node_acquire(SQLITE3_ULTIBO_VFS *vfs, const char *path)
+{
+	SQLITE3_ULTIBO_NODE *node;
+
+	mutex_lock(vfs->lock);
+
+	/* FAT and NTFS names are not case sensitive */
+	for (node = vfs->nodes; node; node = node->next)
+	{
+		if (strcasecmp(node->path, path) == 0)
+		{
+			node->refcount++;
+			mutex_unlock(vfs->lock);
+			return node;
+		}
+	}
+
+	node = calloc(1, sizeof(SQLITE3_ULTIBO_NODE));
+	if (node)
+		node->path = strdup(path);
+	if (!node || !node->path)
+	{
+		free(node);
+		mutex_unlock(vfs->lock);
+		return NULL;
+	}
+
+	node->refcount = 1;
+	node->next = vfs->nodes;
+	vfs->nodes = node;
+
+	mutex_unlock(vfs->lock);
+
+	return node;
+}
+
+static void sqlite3_ultibo_node_release(SQLITE3_ULTIBO_VFS *vfs, SQLITE3_ULTIBO_NODE *node)
+{
+	SQLITE3_ULTIBO_NODE **link;
+
+	mutex_lock(vfs->lock);
+
+	node->refcount--;
+	if (node->refcount == 0)
+	{
+		for (link = &vfs->nodes; *link; link = &(*link)->next)
+		{
+			if (*link == node)
+			{
+				*link = node->next;
+				break;
+			}
+		}
+
+		free(node->path);
+		free(node);
+	}
+
+	mutex_unlock(vfs->lock);
+}
+
+/* Extent of a storage file from its name (SQLITE3_ULTIBO_EXTENT_NONE for a super journal) */
+static uint32_t sqlite3_ultibo_extent_from_name(const char *name)
+{
+	size_t length;
+
+	if (!name)
+		return SQLITE3_ULTIBO_EXTENT_NONE;
+
+	length = strlen(name);
+	if (length >= 8 && strcmp(name + length - 8, "-journal") == 0)
+		return SQLITE3_ULTIBO_EXTENT_JOURNAL;
+	if (length >= 4 && strcmp(name + length - 4, "-wal") == 0)
+		return SQLITE3_ULTIBO_EXTENT_WAL;
+	if (strstr(name, "-mj"))
+		return SQLITE3_ULTIBO_EXTENT_NONE;
+
+	return SQLITE3_ULTIBO_EXTENT_MAIN;
+}
+
+/* Write the storage header, caller must hold the io lock */
+static int sqlite3_ultibo_header_write(SQLITE3_ULTIBO_VFS *vfs)
+{
+	memset(vfs->block, 0, vfs->blocksize);
+	memcpy(vfs->block, &vfs->header, sizeof(SQLITE3_ULTIBO_HEADER));
+
+	if (storage_device_write(vfs->storage, vfs->start, 1, vfs->block) != ERROR_SUCCESS)
+		return SQLITE_IOERR_WRITE;
+
+	vfs->headerdirty = FALSE;
+
+	return SQLITE_OK;
+}
+
+/* Transfer between a buffer and an extent, caller must hold the io lock */
+static int sqlite3_ultibo_storage_transfer(SQLITE3_ULTIBO_VFS *vfs, uint32_t extent, int64_t offset, uint8_t *buffer, int amount, BOOL write)
+{
+	int64_t block;
+	int64_t count;
+	uint32_t within;
+	uint32_t length;
+	uint32_t status;
+
+	while (amount > 0)
+	{
+		block = vfs->start + vfs->header.extents[extent].start + (offset / vfs->blocksize);
+		within = offset % vfs->blocksize;
+
+		if (within == 0 && (uint32_t)amount >= vfs->blocksize)
+		{
+			/* Whole blocks go straight to the device */
+			count = amount / vfs->blocksize;
+			length = count * vfs->blocksize;
+
+			if (write)
+				status = storage_device_write(vfs->storage, block, count, buffer);
+			else
+				status = storage_device_read(vfs->storage, block, count, buffer);
+			if (status != ERROR_SUCCESS)
+				return write ? SQLITE_IOERR_WRITE : SQLITE_IOERR_READ;
+		}
+		else
+		{
+			/* Partial block through the block buffer */
+			length = vfs->blocksize - within;
+			if (length > (uint32_t)amount)
+				length = amount;
+
+			if (storage_device_read(vfs->storage, block, 1, vfs->block) != ERROR_SUCCESS)
+				return write ? SQLITE_IOERR_WRITE : SQLITE_IOERR_READ;
+
+			if (write)
+			{
+				memcpy(vfs->block + within, buffer, length);
+				if (storage_device_write(vfs->storage, block, 1, vfs->block) != ERROR_SUCCESS)
+					return SQLITE_IOERR_WRITE;
+
+				sqlite3_ultibo_account(vfs, &vfs->statistics.partialcount, NULL, 0);
+			}
+			else
+			{
+				memcpy(buffer, vfs->block + within, length);
+			}
+		}
+
+		offset += length;
+		buffer += length;
+		amount -= length;
+	}
+
+	return SQLITE_OK;
+}
+
+static int sqlite3_ultibo_seek(SQLITE3_ULTIBO_FILE *file, int64_t offset)
+{
+	if (file->position == offset)
+		return SQLITE_OK;
+
+	if (FileSeekEx(file->handle, offset, fsFromBeginning) != offset)
+	{
+		file->position = -1;
+		return SQLITE_IOERR_SEEK;
+	}
+
+	file->position = offset;
+
+	sqlite3_ultibo_account(file->vfs, &file->vfs->statistics.seekcount, NULL, 0);
+
+	return SQLITE_OK;
+}
+
+/* ============================================================================== */
+/* SQLite IO Methods */
+static int sqlite3_ultibo_close(sqlite3_file *id)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_VFS *vfs = file->vfs;
+	int result = SQLITE_OK;
+
+	if (file->shmmapped)
+		id->pMethods->xShmUnmap(id, 0);
+
+	if (file->node)
+	{
+		id->pMethods->xUnlock(id, SQLITE_LOCK_NONE);
+		sqlite3_ultibo_node_release(vfs, file->node);
+		file->node = NULL;
+	}
+
+	switch (file->kind)
+	{
+		case SQLITE3_ULTIBO_KIND_FILE:
+			FileClose(file->handle);
+			if (file->deletepath)
+			{
+				DeleteFile(file->deletepath);
+				free(file->deletepath);
+			}
+			break;
+		case SQLITE3_ULTIBO_KIND_STORAGE:
+			mutex_lock(vfs->iolock);
+			if (vfs->headerdirty)
+				result = sqlite3_ultibo_header_write(vfs);
+			mutex_unlock(vfs->iolock);
+			break;
+		case SQLITE3_ULTIBO_KIND_MEMORY:
+			free(file->data);
+			break;
+	}
+
+	return result;
+}
+
+static int sqlite3_ultibo_read(sqlite3_file *id, void *buffer, int amount, sqlite3_int64 offset)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_VFS *vfs = file->vfs;
+	SQLITE3_ULTIBO_EXTENT *extent;
+	int32_t count = 0;
+	int result;
+
+	switch (file->kind)
+	{
+		case SQLITE3_ULTIBO_KIND_FILE:
+			result = sqlite3_ultibo_seek(file, offset);
+			if (result != SQLITE_OK)
+				return SQLITE_IOERR_READ;
+
+			count = FileRead(file->handle, buffer, amount);
+			if (count < 0)
+			{
+				file->position = -1;
+				return SQLITE_IOERR_READ;
+			}
+			file->position += count;
+			break;
+		case SQLITE3_ULTIBO_KIND_STORAGE:
+			mutex_lock(vfs->iolock);
+			extent = &vfs->header.extents[file->extent];
+			if (offset < extent->size)
+			{
+				count = (extent->size - offset < amount) ? (int32_t)(extent->size - offset) : amount;
+
+				result = sqlite3_ultibo_storage_transfer(vfs, file->extent, offset, (uint8_t *)buffer, count, FALSE);
+				if (result != SQLITE_OK)
+				{
+					mutex_unlock(vfs->iolock);
+					return result;
+				}
+			}
+			mutex_unlock(vfs->iolock);
+			break;
+		case SQLITE3_ULTIBO_KIND_MEMORY:
+			if (offset < file->size)
+			{
+				count = (file->size - offset < amount) ? (int32_t)(file->size - offset) : amount;
+				memcpy(buffer, file->data + offset, count);
+			}
+			break;
+	}
+
+	sqlite3_ultibo_account(vfs, &vfs->statistics.readcount, &vfs->statistics.readbytes, count);
+
+	/* SQLite requires the unread part of the buffer to be zero filled */
+	if (count < amount)
+	{
+		memset((uint8_t *)buffer + count, 0, amount - count);
+		return SQLITE_IOERR_SHORT_READ;
+	}
+
+	return SQLITE_OK;
+}
+
+static int sqlite3_ultibo_write(sqlite3_file *id, const void *buffer, int amount, sqlite3_int64 offset)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_VFS *vfs = file->vfs;
+	SQLITE3_ULTIBO_EXTENT *extent;
+	uint8_t *data;
+	int64_t capacity;
+	int32_t count;
+	int result;
+
+	switch (file->kind)
+	{
+		case SQLITE3_ULTIBO_KIND_FILE:
+			result = sqlite3_ultibo_seek(file, offset);
+			if (result != SQLITE_OK)
+				return SQLITE_IOERR_WRITE;
+
+			count = FileWrite(file->handle, (void *)buffer, amount);
+			if (count < 0)
+			{
+				file->position = -1;
+				return SQLITE_IOERR_WRITE;
+			}
+			file->position += count;
+
+			if (count < amount)
+				return SQLITE_FULL;
+			break;
+		case SQLITE3_ULTIBO_KIND_STORAGE:
+			mutex_lock(vfs->iolock);
+			extent = &vfs->header.extents[file->extent];
+			if (offset + amount > extent->capacity * vfs->blocksize)
+			{
+				mutex_unlock(vfs->iolock);
+				return SQLITE_FULL;
+			}
+
+			result = sqlite3_ultibo_storage_transfer(vfs, file->extent, offset, (uint8_t *)buffer, amount, TRUE);
+			if (result == SQLITE_OK && offset + amount > extent->size)
+			{
+				extent->size = offset + amount;
+				vfs->headerdirty = TRUE;
+			}
+			mutex_unlock(vfs->iolock);
+
+			if (result != SQLITE_OK)
+				return result;
+			break;
+		case SQLITE3_ULTIBO_KIND_MEMORY:
+			if (offset + amount > file->capacity)
+			{
+				capacity = file->capacity ? file->capacity : SIZE_64K;
+				while (capacity < offset + amount)
+					capacity *= 2;
+
+				data = realloc(file->data, capacity);
+				if (!data)
+					return SQLITE_IOERR_NOMEM;
+
+				file->data = data;
+				file->capacity = capacity;
+			}
+
+			if (offset > file->size)
+				memset(file->data + file->size, 0, offset - file->size);
+			memcpy(file->data + offset, buffer, amount);
+
+			if (offset + amount > file->size)
+				file->size = offset + amount;
+			break;
+	}
+
+	sqlite3_ultibo_account(vfs, &vfs->statistics.writecount, &vfs->statistics.writebytes, amount);
+
+	return SQLITE_OK;
+}
+
+static int sqlite3_ultibo_truncate(sqlite3_file *id, sqlite3_int64 size)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_VFS *vfs = file->vfs;
+	SQLITE3_ULTIBO_EXTENT *extent;
+
+	switch (file->kind)
+	{
+		case SQLITE3_ULTIBO_KIND_FILE:
+			if (sqlite3_ultibo_seek(file, size) != SQLITE_OK || !SetEndOfFile(file->handle))
+				return SQLITE_IOERR_TRUNCATE;
+			break;
+		case SQLITE3_ULTIBO_KIND_STORAGE:
+			mutex_lock(vfs->iolock);
+			extent = &vfs->header.extents[file->extent];
+			if (size < extent->size)
+			{
+				extent->size = size;
+				vfs->headerdirty = TRUE;
+			}
+			mutex_unlock(vfs->iolock);
+			break;
+		case SQLITE3_ULTIBO_KIND_MEMORY:
+			if (size < file->size)
+				file->size = size;
+			break;
+	}
+
+	return SQLITE_OK;
+}
+
+static int sqlite3_ultibo_sync(sqlite3_file *id, int flags)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_VFS *vfs = file->vfs;
+	int result = SQLITE_OK;
+
+	switch (file->kind)
+	{
+		case SQLITE3_ULTIBO_KIND_FILE:
+			/* Only this handle, not every buffer of the volume */
+			if (!FileFlush(file->handle))
+				result = SQLITE_IOERR_FSYNC;
+			break;
+		case SQLITE3_ULTIBO_KIND_STORAGE:
+			/* Storage writes are not cached, only the extent sizes need to be written */
+			mutex_lock(vfs->iolock);
+			if (vfs->headerdirty)
+				result = sqlite3_ultibo_header_write(vfs);
+			mutex_unlock(vfs->iolock);
+
+			if (result != SQLITE_OK)
+				result = SQLITE_IOERR_FSYNC;
+			break;
+	}
+
+	sqlite3_ultibo_account(vfs, &vfs->statistics.synccount, NULL, 0);
+
+	return result;
+}
+
+static int sqlite3_ultibo_file_size(sqlite3_file *id, sqlite3_int64 *size)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_VFS *vfs = file->vfs;
+	int64_t value = 0;
+
+	switch (file->kind)
+	{
+		case SQLITE3_ULTIBO_KIND_FILE:
+			value = FileSizeEx(file->handle);
+			if (value < 0)
+				return SQLITE_IOERR_FSTAT;
+			break;
+		case SQLITE3_ULTIBO_KIND_STORAGE:
+			mutex_lock(vfs->iolock);
+			value = vfs->header.extents[file->extent].size;
+			mutex_unlock(vfs->iolock);
+			break;
+		case SQLITE3_ULTIBO_KIND_MEMORY:
+			value = file->size;
+			break;
+	}
+
+	*size = value;
+
+	return SQLITE_OK;
+}
+
+static int sqlite3_ultibo_lock(sqlite3_file *id, int locktype)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_VFS *vfs = file->vfs;
+	SQLITE3_ULTIBO_NODE *node = file->node;
+	int result = SQLITE_OK;
+
+	if (file->locktype >= locktype)
+		return SQLITE_OK;
+
+	/* Only a main database has other connections to lock against */
+	if (!node)
+	{
+		file->locktype = locktype;
+		return SQLITE_OK;
+	}
+
+	mutex_lock(vfs->lock);
+
+	/* Another connection holds a pending or greater lock, or a lock other than shared when more than shared is wanted */
+	if (node->locktype != file->locktype && (node->locktype >= SQLITE_LOCK_PENDING || locktype > SQLITE_LOCK_SHARED))
+	{
+		result = SQLITE_BUSY;
+	}
+	else if (locktype == SQLITE_LOCK_SHARED)
+	{
+		if (node->locktype == SQLITE_LOCK_NONE)
+			node->locktype = SQLITE_LOCK_SHARED;
+		node->sharedcount++;
+		file->locktype = SQLITE_LOCK_SHARED;
+	}
+	else if (locktype == SQLITE_LOCK_RESERVED)
+	{
+		node->locktype = SQLITE_LOCK_RESERVED;
+		file->locktype = SQLITE_LOCK_RESERVED;
+	}
+	else
+	{
+		/* Exclusive waits for the other readers to leave, pending stops new ones arriving */
+		if (node->sharedcount > 1)
+		{
+			node->locktype = SQLITE_LOCK_PENDING;
+			file->locktype = SQLITE_LOCK_PENDING;
+			result = SQLITE_BUSY;
+		}
+		else
+		{
+			node->locktype = locktype;
+			file->locktype = locktype;
+		}
+	}
+
+	mutex_unlock(vfs->lock);
+
+	return result;
+}
+
+static int sqlite3_ultibo_unlock(sqlite3_file *id, int locktype)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_VFS *vfs = file->vfs;
+	SQLITE3_ULTIBO_NODE *node = file->node;
+
+	if (file->locktype <= locktype)
+		return SQLITE_OK;
+
+	if (!node)
+	{
+		file->locktype = locktype;
+		return SQLITE_OK;
+	}
+
+	mutex_lock(vfs->lock);
+
+	if (file->locktype > SQLITE_LOCK_SHARED)
+		node->locktype = SQLITE_LOCK_SHARED;
+
+	if (locktype == SQLITE_LOCK_NONE)
+	{
+		node->sharedcount--;
+		if (node->sharedcount == 0)
+			node->locktype = SQLITE_LOCK_NONE;
+	}
+
+	file->locktype = locktype;
+
+	mutex_unlock(vfs->lock);
+
+	return SQLITE_OK;
+}
+
+static int sqlite3_ultibo_check_reserved_lock(sqlite3_file *id, int *result)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_VFS *vfs = file->vfs;
+
+	*result = 0;
+	if (file->locktype > SQLITE_LOCK_SHARED)
+	{
+		*result = 1;
+	}
+	else if (file->node)
+	{
+		mutex_lock(vfs->lock);
+		*result = (file->node->locktype > SQLITE_LOCK_SHARED);
+		mutex_unlock(vfs->lock);
+	}
+
+	return SQLITE_OK;
+}
+
+static int sqlite3_ultibo_file_control(sqlite3_file *id, int op, void *arg)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+
+	switch (op)
+	{
+		case SQLITE_FCNTL_LOCKSTATE:
+			*(int *)arg = file->locktype;
+			return SQLITE_OK;
+		case SQLITE_FCNTL_VFSNAME:
+			*(char **)arg = sqlite3_mprintf("%s", file->vfs->name);
+			return SQLITE_OK;
+		case SQLITE_FCNTL_SIZE_HINT:
+			/* Fail early if the database will not fit in its extent */
+			if (file->kind == SQLITE3_ULTIBO_KIND_STORAGE && *(sqlite3_int64 *)arg > file->vfs->header.extents[file->extent].capacity * file->vfs->blocksize)
+				return SQLITE_FULL;
+			return SQLITE_OK;
+	}
+
+	return SQLITE_NOTFOUND;
+}
+
+static int sqlite3_ultibo_sector_size(sqlite3_file *id)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+
+	if (file->kind == SQLITE3_ULTIBO_KIND_STORAGE)
+		return file->vfs->blocksize;
+
+	return SQLITE3_ULTIBO_SECTOR_SIZE;
+}
+
+static int sqlite3_ultibo_device_characteristics(sqlite3_file *id)
+{
+	return 0;
+}
+
+static int sqlite3_ultibo_shm_map(sqlite3_file *id, int region, int regionsize, int extend, void volatile **address)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_VFS *vfs = file->vfs;
+	SQLITE3_ULTIBO_NODE *node = file->node;
+	SQLITE3_ULTIBO_SHM *shm;
+	void **regions;
+	int result = SQLITE_OK;
+
+	*address = NULL;
+
+	if (!node)
+		return SQLITE_IOERR_SHMOPEN;
+
+	mutex_lock(vfs->lock);
+
+	shm = node->shm;
+	if (!shm)
+	{
+		shm = calloc(1, sizeof(SQLITE3_ULTIBO_SHM));
+		if (!shm)
+		{
+			mutex_unlock(vfs->lock);
+			return SQLITE_IOERR_NOMEM;
+		}
+
+		shm->regionsize = regionsize;
+		node->shm = shm;
+	}
+
+	if (!file->shmmapped)
+	{
+		file->shmmapped = TRUE;
+		shm->refcount++;
+	}
+
+	if (region >= shm->regioncount && extend)
+	{
+		regions = realloc(shm->regions, (region + 1) * sizeof(void *));
+		if (!regions)
+		{
+			mutex_unlock(vfs->lock);
+			return SQLITE_IOERR_NOMEM;
+		}
+		shm->regions = regions;
+
+		while (shm->regioncount <= region)
+		{
+			/* Shared memory is visible to every CPU regardless of the thread that maps it */
+			regions[shm->regioncount] = alloc_shared_mem(shm->regionsize);
+			if (!regions[shm->regioncount])
+			{
+				result = SQLITE_IOERR_SHMMAP;
+				break;
+			}
+			memset(regions[shm->regioncount], 0, shm->regionsize);
+			shm->regioncount++;
+		}
+	}
+
+	if (region < shm->regioncount)
+		*address = shm->regions[region];
+
+	mutex_unlock(vfs->lock);
+
+	return result;
+}
+
+static int sqlite3_ultibo_shm_lock(sqlite3_file *id, int offset, int count, int flags)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_VFS *vfs = file->vfs;
+	SQLITE3_ULTIBO_SHM *shm;
+	uint16_t mask;
+	int index;
+	int result = SQLITE_OK;
+
+	if (!file->node || !file->node->shm)
+		return SQLITE_IOERR_SHMLOCK;
+
+	mask = (uint16_t)((1 << (offset + count)) - (1 << offset));
+
+	mutex_lock(vfs->lock);
+
+	shm = file->node->shm;
+	if (flags & SQLITE_SHM_UNLOCK)
+	{
+		for (index = offset; index < offset + count; index++)
+		{
+			if (file->exclusivemask & (1 << index))
+				shm->locks[index] = 0;
+			else if (file->sharedmask & (1 << index))
+				shm->locks[index]--;
+		}
+
+		file->exclusivemask &= ~mask;
+		file->sharedmask &= ~mask;
+	}
+	else if (flags & SQLITE_SHM_SHARED)
+	{
+		if (!(file->sharedmask & mask))
+		{
+			if (shm->locks[offset] < 0)
+			{
+				result = SQLITE_BUSY;
+			}
+			else
+			{
+				shm->locks[offset]++;
+				file->sharedmask |= mask;
+			}
+		}
+	}
+	else
+	{
+		for (index = offset; index < offset + count; index++)
+		{
+			if (!(file->exclusivemask & (1 << index)) && shm->locks[index] != 0)
+			{
+				result = SQLITE_BUSY;
+				break;
+			}
+		}
+
+		if (result == SQLITE_OK)
+		{
+			for (index = offset; index < offset + count; index++)
+				shm->locks[index] = -1;
+
+			file->exclusivemask |= mask;
+		}
+	}
+
+	mutex_unlock(vfs->lock);
+
+	return result;
+}
+
+static void sqlite3_ultibo_shm_barrier(sqlite3_file *id)
+{
+	__sync_synchronize();
+}
+
+static int sqlite3_ultibo_shm_unmap(sqlite3_file *id, int deleteflag)
+{
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_VFS *vfs = file->vfs;
+	SQLITE3_ULTIBO_SHM *shm;
+	int region;
+
+	if (!file->shmmapped)
+		return SQLITE_OK;
+
+	/* Release any WAL locks still held */
+	sqlite3_ultibo_shm_lock(id, 0, SQLITE_SHM_NLOCK, SQLITE_SHM_UNLOCK);
+
+	mutex_lock(vfs->lock);
+
+	file->shmmapped = FALSE;
+
+	shm = file->node->shm;
+	shm->refcount--;
+	if (shm->refcount == 0)
+	{
+		for (region = 0; region < shm->regioncount; region++)
+			free_mem(shm->regions[region]);
+
+		free(shm->regions);
+		free(shm);
+		file->node->shm = NULL;
+	}
+
+	mutex_unlock(vfs->lock);
+
+	return SQLITE_OK;
+}
+
+static const sqlite3_io_methods sqlite3_ultibo_io_methods =
+{
+	2, // Version 2 adds the WAL index methods
+	sqlite3_ultibo_close,
+	sqlite3_ultibo_read,
+	sqlite3_ultibo_write,
+	sqlite3_ultibo_truncate,
+	sqlite3_ultibo_sync,
+	sqlite3_ultibo_file_size,
+	sqlite3_ultibo_lock,
+	sqlite3_ultibo_unlock,
+	sqlite3_ultibo_check_reserved_lock,
+	sqlite3_ultibo_file_control,
+	sqlite3_ultibo_sector_size,
+	sqlite3_ultibo_device_characteristics,
+	sqlite3_ultibo_shm_map,
+	sqlite3_ultibo_shm_lock,
+	sqlite3_ultibo_shm_barrier,
+	sqlite3_ultibo_shm_unmap,
+	NULL,
+	NULL
+};
+
+/* ============================================================================== */
+/* SQLite VFS Methods */
+static int sqlite3_ultibo_open(sqlite3_vfs *base, sqlite3_filename name, sqlite3_file *id, int flags, int *outflags)
+{
+	SQLITE3_ULTIBO_VFS *vfs = (SQLITE3_ULTIBO_VFS *)base;
+	SQLITE3_ULTIBO_FILE *file = (SQLITE3_ULTIBO_FILE *)id;
+	SQLITE3_ULTIBO_EXTENT *extent;
+	BOOL exists;
+	int result;
+
+	memset(file, 0, sizeof(SQLITE3_ULTIBO_FILE));
+	file->vfs = vfs;
+	file->handle = INVALID_HANDLE_VALUE;
+	file->position = -1;
+	file->extent = SQLITE3_ULTIBO_EXTENT_NONE;
+
+	/* Only a main database, its journal and its WAL are kept on the device or filesystem */
+	if (!name || !(flags & (SQLITE_OPEN_MAIN_DB | SQLITE_OPEN_MAIN_JOURNAL | SQLITE_OPEN_WAL)))
+		file->kind = SQLITE3_ULTIBO_KIND_MEMORY;
+	else
+		file->kind = vfs->kind;
+
+	if (file->kind == SQLITE3_ULTIBO_KIND_FILE)
+	{
+		exists = FileExists(name);
+		if (exists && (flags & SQLITE_OPEN_EXCLUSIVE) && (flags & SQLITE_OPEN_CREATE))
+			return SQLITE_CANTOPEN;
+
+		if (!exists)
+		{
+			if (!(flags & SQLITE_OPEN_CREATE))
+				return SQLITE_CANTOPEN;
+
+			file->handle = FileCreate(name);
+			if (file->handle == INVALID_HANDLE_VALUE)
+				return SQLITE_CANTOPEN;
+			FileClose(file->handle);
+		}
+
+		if (flags & SQLITE_OPEN_READWRITE)
+			file->handle = FileOpen(name, fmOpenReadWrite | fmShareDenyNone);
+		if (file->handle == INVALID_HANDLE_VALUE)
+		{
+			/* Fall back to read only as SQLite expects */
+			file->handle = FileOpen(name, fmOpenRead | fmShareDenyNone);
+			if (file->handle == INVALID_HANDLE_VALUE)
+				return SQLITE_CANTOPEN;
+
+			flags = (flags & ~(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE)) | SQLITE_OPEN_READONLY;
+		}
+		file->position = 0;
+
+		if (flags & SQLITE_OPEN_DELETEONCLOSE)
+			file->deletepath = strdup(name);
+	}
+	else if (file->kind == SQLITE3_ULTIBO_KIND_STORAGE)
+	{
+		file->extent = (flags & SQLITE_OPEN_MAIN_DB) ? SQLITE3_ULTIBO_EXTENT_MAIN : ((flags & SQLITE_OPEN_WAL) ? SQLITE3_ULTIBO_EXTENT_WAL : SQLITE3_ULTIBO_EXTENT_JOURNAL);
+
+		mutex_lock(vfs->iolock);
+		extent = &vfs->header.extents[file->extent];
+		if (!extent->exists)
+		{
+			if (!(flags & SQLITE_OPEN_CREATE))
+			{
+				mutex_unlock(vfs->iolock);
+				return SQLITE_CANTOPEN;
+			}
+
+			extent->exists = 1;
+			extent->size = 0;
+
+			result = sqlite3_ultibo_header_write(vfs);
+			if (result != SQLITE_OK)
+			{
+				extent->exists = 0;
+				mutex_unlock(vfs->iolock);
+				return SQLITE_CANTOPEN;
+			}
+		}
+		mutex_unlock(vfs->iolock);
+	}
+
+	/* Lock against other connections to the same database */
+	if (file->kind != SQLITE3_ULTIBO_KIND_MEMORY && (flags & SQLITE_OPEN_MAIN_DB))
+	{
+		file->node = sqlite3_ultibo_node_acquire(vfs, (file->kind == SQLITE3_ULTIBO_KIND_STORAGE) ? SQLITE3_ULTIBO_STORAGE_NODE : name);
+		if (!file->node)
+		{
+			if (file->kind == SQLITE3_ULTIBO_KIND_FILE)
+			{
+				FileClose(file->handle);
+				free(file->deletepath);
+			}
+			return SQLITE_NOMEM;
+		}
+	}
+
+	if (outflags)
+		*outflags = flags;
+
+	sqlite3_ultibo_account(vfs, &vfs->statistics.opencount, NULL, 0);
+
+	file->base.pMethods = &sqlite3_ultibo_io_methods;
+
+	return SQLITE_OK;
+}
+
+static int sqlite3_ultibo_delete(sqlite3_vfs *base, const char *name, int syncdir)
+{
+	SQLITE3_ULTIBO_VFS *vfs = (SQLITE3_ULTIBO_VFS *)base;
+	SQLITE3_ULTIBO_EXTENT *extent;
+	uint32_t index;
+	int result = SQLITE_OK;
+
+	if (vfs->kind == SQLITE3_ULTIBO_KIND_FILE)
+	{
+		if (!DeleteFile(name))
+			return FileExists(name) ? SQLITE_IOERR_DELETE : SQLITE_IOERR_DELETE_NOENT;
+
+		return SQLITE_OK;
+	}
+
+	index = sqlite3_ultibo_extent_from_name(name);
+	if (index == SQLITE3_ULTIBO_EXTENT_NONE)
+		return SQLITE_IOERR_DELETE_NOENT;
+
+	mutex_lock(vfs->iolock);
+	extent = &vfs->header.extents[index];
+	if (!extent->exists)
+	{
+		result = SQLITE_IOERR_DELETE_NOENT;
+	}
+	else
+	{
+		extent->exists = 0;
+		extent->size = 0;
+
+		if (sqlite3_ultibo_header_write(vfs) != SQLITE_OK)
+			result = SQLITE_IOERR_DELETE;
+	}
+	mutex_unlock(vfs->iolock);
+
+	return result;
+}
+
+static int sqlite3_ultibo_access(sqlite3_vfs *base, const char *name, int flags, int *result)
+{
+	SQLITE3_ULTIBO_VFS *vfs = (SQLITE3_ULTIBO_VFS *)base;
+	uint32_t index;
+
+	*result = 0;
+
+	if (vfs->kind == SQLITE3_ULTIBO_KIND_FILE)
+	{
+		if (!FileExists(name))
+			return SQLITE_OK;
+
+		if (flags == SQLITE_ACCESS_READWRITE)
+			*result = (FileGetAttr(name) & faReadOnly) == 0;
+		else
+			*result = 1;
+
+		return SQLITE_OK;
+	}
+
+	index = sqlite3_ultibo_extent_from_name(name);
+	if (index == SQLITE3_ULTIBO_EXTENT_NONE)
+		return SQLITE_OK;
+
+	/* Like the unix VFS an empty journal or WAL is treated as not existing */
+	mutex_lock(vfs->iolock);
+	*result = vfs->header.extents[index].exists && (index == SQLITE3_ULTIBO_EXTENT_MAIN || vfs->header.extents[index].size > 0);
+	mutex_unlock(vfs->iolock);
+
+	return SQLITE_OK;
+}
+
+static int sqlite3_ultibo_full_pathname(sqlite3_vfs *base, const char *name, int count, char *output)
+{
+	SQLITE3_ULTIBO_VFS *vfs = (SQLITE3_ULTIBO_VFS *)base;
+	uint32_t length;
+
+	if (vfs->kind == SQLITE3_ULTIBO_KIND_FILE)
+	{
+		length = GetFullPathName(name, count, output, NULL);
+		if (length > 0 && length < (uint32_t)count)
+			return SQLITE_OK;
+	}
+
+	sqlite3_snprintf(count, output, "%s", name);
+
+	return SQLITE_OK;
+}
+
+static int sqlite3_ultibo_randomness(sqlite3_vfs *base, int count, char *output)
+{
+	int index;
+
+	for (index = 0; index < count; index++)
+		output[index] = (char)random_read_longint(256);
+
+	return count;
+}
+
+static int sqlite3_ultibo_sleep(sqlite3_vfs *base, int microseconds)
+{
+	thread_sleep((microseconds + 999) / 1000);
+
+	return microseconds;
+}
+
+static int sqlite3_ultibo_current_time_int64(sqlite3_vfs *base, sqlite3_int64 *now)
+{
+	struct timeval value;
+
+	/* Julian day number in milliseconds, 210866760000000 is the Unix epoch */
+	gettimeofday(&value, NULL);
+	*now = ((sqlite3_int64)value.tv_sec * 1000) + (value.tv_usec / 1000) + 210866760000000LL;
+
+	return SQLITE_OK;
+}
+
+static int sqlite3_ultibo_current_time(sqlite3_vfs *base, double *now)
+{
+	sqlite3_int64 value;
+
+	sqlite3_ultibo_current_time_int64(base, &value);
+	*now = value / 86400000.0;
+
+	return SQLITE_OK;
+}
+
+static int sqlite3_ultibo_get_last_error(sqlite3_vfs *base, int count, char *output)
+{
+	return 0;
+}
+
+static SQLITE3_ULTIBO_VFS *sqlite3_ultibo_vfs_create(const char *name, uint32_t kind)
+{
+	SQLITE3_ULTIBO_VFS *vfs;
+
+	vfs = calloc(1, sizeof(SQLITE3_ULTIBO_VFS));
+	if (!vfs)
+		return NULL;
+
+	vfs->name = strdup(name);
+	if (!vfs->name)
+	{
+		free(vfs);
+		return NULL;
+	}
+
+	vfs->signature = SQLITE3_ULTIBO_SIGNATURE;
+	vfs->kind = kind;
+	vfs->lock = mutex_create();
+	vfs->statisticslock = spin_create();
+	vfs->iolock = INVALID_HANDLE_VALUE;
+
+	vfs->base.iVersion = 2;
+	vfs->base.szOsFile = sizeof(SQLITE3_ULTIBO_FILE);
+	vfs->base.mxPathname = SQLITE3_ULTIBO_MAX_PATHNAME;
+	vfs->base.zName = vfs->name;
+	vfs->base.pAppData = vfs;
+	vfs->base.xOpen = sqlite3_ultibo_open;
+	vfs->base.xDelete = sqlite3_ultibo_delete;
+	vfs->base.xAccess = sqlite3_ultibo_access;
+	vfs->base.xFullPathname = sqlite3_ultibo_full_pathname;
+	vfs->base.xRandomness = sqlite3_ultibo_randomness;
+	vfs->base.xSleep = sqlite3_ultibo_sleep;
+	vfs->base.xCurrentTime = sqlite3_ultibo_current_time;
+	vfs->base.xGetLastError = sqlite3_ultibo_get_last_error;
+	vfs->base.xCurrentTimeInt64 = sqlite3_ultibo_current_time_int64;
+
+	return vfs;
+}
+
+static void sqlite3_ultibo_vfs_destroy(SQLITE3_ULTIBO_VFS *vfs)
+{
+	vfs->signature = 0;
+
+	if (vfs->iolock != INVALID_HANDLE_VALUE)
+		mutex_destroy(vfs->iolock);
+	mutex_destroy(vfs->lock);
+	spin_destroy(vfs->statisticslock);
+
+	free(vfs->block);
+	free(vfs->name);
+	free(vfs);
+}
+
+/* ============================================================================== */
+/* SQLite VFS Functions */
+uint32_t STDCALL sqlite3_ultibo_register(BOOL makedefault)
+{
+	SQLITE3_ULTIBO_VFS *vfs;
+
+	/* Registering again only changes the default */
+	vfs = sqlite3_ultibo_vfs_check(SQLITE3_ULTIBO_VFS_NAME);
+	if (!vfs)
+	{
+		if (sqlite3_vfs_find(SQLITE3_ULTIBO_VFS_NAME))
+			return ERROR_ALREADY_EXISTS;
+
+		vfs = sqlite3_ultibo_vfs_create(SQLITE3_ULTIBO_VFS_NAME, SQLITE3_ULTIBO_KIND_FILE);
+		if (!vfs)
+			return ERROR_NOT_ENOUGH_MEMORY;
+	}
+
+	if (sqlite3_vfs_register(&vfs->base, makedefault) != SQLITE_OK)
+	{
+		if (!sqlite3_ultibo_vfs_check(SQLITE3_ULTIBO_VFS_NAME))
+			sqlite3_ultibo_vfs_destroy(vfs);
+		return ERROR_OPERATION_FAILED;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL sqlite3_ultibo_unregister(void)
+{
+	return sqlite3_ultibo_storage_unregister(SQLITE3_ULTIBO_VFS_NAME);
+}
+
+uint32_t STDCALL sqlite3_ultibo_storage_register(const char *name, STORAGE_DEVICE *storage, int64_t start, int64_t count, uint32_t journalsize, uint32_t flags, BOOL makedefault)
+{
+	SQLITE3_ULTIBO_VFS *vfs;
+	SQLITE3_ULTIBO_HEADER header;
+	int64_t journalblocks;
+	uint32_t index;
+
+	if (!name || !storage || start < 0 || count <= 0)
+		return ERROR_INVALID_PARAMETER;
+
+	if (storage->blocksize < sizeof(SQLITE3_ULTIBO_HEADER) || start + count > storage->blockcount)
+		return ERROR_INVALID_PARAMETER;
+
+	if (sqlite3_vfs_find(name))
+		return ERROR_ALREADY_EXISTS;
+
+	if (journalsize == 0)
+		journalsize = SQLITE3_ULTIBO_DEFAULT_JOURNAL_SIZE;
+
+	/* Header block, journal extent, WAL extent and the rest for the database */
+	journalblocks = (journalsize + storage->blocksize - 1) / storage->blocksize;
+	if (1 + (journalblocks * 2) >= count)
+		return ERROR_INVALID_PARAMETER;
+
+	memset(&header, 0, sizeof(SQLITE3_ULTIBO_HEADER));
+	header.magic = SQLITE3_ULTIBO_HEADER_MAGIC;
+	header.version = SQLITE3_ULTIBO_HEADER_VERSION;
+	header.blocksize = storage->blocksize;
+	header.extentcount = SQLITE3_ULTIBO_EXTENT_COUNT;
+	header.blockcount = count;
+	header.extents[SQLITE3_ULTIBO_EXTENT_JOURNAL].start = 1;
+	header.extents[SQLITE3_ULTIBO_EXTENT_JOURNAL].capacity = journalblocks;
+	header.extents[SQLITE3_ULTIBO_EXTENT_WAL].start = 1 + journalblocks;
+	header.extents[SQLITE3_ULTIBO_EXTENT_WAL].capacity = journalblocks;
+	header.extents[SQLITE3_ULTIBO_EXTENT_MAIN].start = 1 + (journalblocks * 2);
+	header.extents[SQLITE3_ULTIBO_EXTENT_MAIN].capacity = count - header.extents[SQLITE3_ULTIBO_EXTENT_MAIN].start;
+
+	vfs = sqlite3_ultibo_vfs_create(name, SQLITE3_ULTIBO_KIND_STORAGE);
+	if (!vfs)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	vfs->storage = storage;
+	vfs->start = start;
+	vfs->count = count;
+	vfs->blocksize = storage->blocksize;
+	vfs->iolock = mutex_create();
+	vfs->block = malloc(storage->blocksize);
+	if (!vfs->block)
+	{
+		sqlite3_ultibo_vfs_destroy(vfs);
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
+
+	/* Keep an existing database if the layout matches */
+	if (storage_device_read(storage, start, 1, vfs->block) != ERROR_SUCCESS)
+	{
+		sqlite3_ultibo_vfs_destroy(vfs);
+		return ERROR_READ_FAULT;
+	}
+	memcpy(&vfs->header, vfs->block, sizeof(SQLITE3_ULTIBO_HEADER));
+
+	if (vfs->header.magic == SQLITE3_ULTIBO_HEADER_MAGIC && !(flags & SQLITE3_ULTIBO_STORAGE_FLAG_FORMAT))
+	{
+		if (vfs->header.version != header.version || vfs->header.blocksize != header.blocksize || vfs->header.extentcount != header.extentcount || vfs->header.blockcount != header.blockcount)
+		{
+			sqlite3_ultibo_vfs_destroy(vfs);
+			return ERROR_INVALID_DATA;
+		}
+
+		for (index = 0; index < SQLITE3_ULTIBO_EXTENT_COUNT; index++)
+		{
+			if (vfs->header.extents[index].start != header.extents[index].start || vfs->header.extents[index].capacity != header.extents[index].capacity)
+			{
+				sqlite3_ultibo_vfs_destroy(vfs);
+				return ERROR_INVALID_DATA;
+			}
+		}
+	}
+	else
+	{
+		vfs->header = header;
+		if (sqlite3_ultibo_header_write(vfs) != SQLITE_OK)
+		{
+			sqlite3_ultibo_vfs_destroy(vfs);
+			return ERROR_WRITE_FAULT;
+		}
+	}
+
+	if (sqlite3_vfs_register(&vfs->base, makedefault) != SQLITE_OK)
+	{
+		sqlite3_ultibo_vfs_destroy(vfs);
+		return ERROR_OPERATION_FAILED;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL sqlite3_ultibo_storage_unregister(const char *name)
+{
+	SQLITE3_ULTIBO_VFS *vfs;
+
+	if (!name)
+		return ERROR_INVALID_PARAMETER;
+
+	vfs = sqlite3_ultibo_vfs_check(name);
+	if (!vfs)
+		return ERROR_NOT_FOUND;
+
+	/* Databases must be closed first */
+	mutex_lock(vfs->lock);
+	if (vfs->nodes)
+	{
+		mutex_unlock(vfs->lock);
+		return ERROR_IN_USE;
+	}
+	mutex_unlock(vfs->lock);
+
+	sqlite3_vfs_unregister(&vfs->base);
+
+	sqlite3_ultibo_vfs_destroy(vfs);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL sqlite3_ultibo_get_statistics(const char *name, SQLITE3_ULTIBO_STATISTICS *statistics)
+{
+	SQLITE3_ULTIBO_VFS *vfs;
+
+	if (!name || !statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	vfs = sqlite3_ultibo_vfs_check(name);
+	if (!vfs)
+		return ERROR_NOT_FOUND;
+
+	spin_lock(vfs->statisticslock);
+	*statistics = vfs->statistics;
+	spin_unlock(vfs->statisticslock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL sqlite3_ultibo_reset_statistics(const char *name)
+{
+	SQLITE3_ULTIBO_VFS *vfs;
+
+	if (!name)
+		return ERROR_INVALID_PARAMETER;
+
+	vfs = sqlite3_ultibo_vfs_check(name);
+	if (!vfs)
+		return ERROR_NOT_FOUND;
+
+	spin_lock(vfs->statisticslock);
+	memset(&vfs->statistics, 0, sizeof(SQLITE3_ULTIBO_STATISTICS));
+	spin_unlock(vfs->statisticslock);
+
+	return ERROR_SUCCESS;
+}
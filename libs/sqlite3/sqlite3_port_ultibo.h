@@ -0,0 +1,87 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _SQLITE3_PORT_ULTIBO_H
+#define _SQLITE3_PORT_ULTIBO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/sysutils.h"
+#include "ultibo/filesystem.h"
+#include "ultibo/storage.h"
+
+#include "sqlite3.h"
+
+/* ============================================================================== */
+/* SQLite Port specific constants */
+#define SQLITE3_ULTIBO_VFS_NAME	"ultibo" // Name of the VFS for files accessed by Ultibo file handles
+#define SQLITE3_ULTIBO_SECTOR_SIZE	512 // Sector size reported to SQLite for files (Bytes)
+#define SQLITE3_ULTIBO_MAX_PATHNAME	MAX_PATH // Maximum length of a full path name
+
+#define SQLITE3_ULTIBO_DEFAULT_JOURNAL_SIZE	SIZE_4M // Default space reserved on a storage device for each of the rollback journal and the WAL (Bytes)
+
+/* SQLite Storage Flags */
+#define SQLITE3_ULTIBO_STORAGE_FLAG_NONE	0x00000000
+#define SQLITE3_ULTIBO_STORAGE_FLAG_FORMAT	0x00000001 // Discard any database already present in the storage region
+
+/* ============================================================================== */
+/* SQLite Port specific types */
+
+/* SQLite VFS Statistics */
+typedef struct _SQLITE3_ULTIBO_STATISTICS SQLITE3_ULTIBO_STATISTICS;
+struct _SQLITE3_ULTIBO_STATISTICS
+{
+	uint32_t opencount; // Number of files opened (Including temporary files held in memory)
+	uint32_t readcount; // Number of read requests from SQLite
+	uint32_t writecount; // Number of write requests from SQLite
+	uint32_t synccount; // Number of sync requests from SQLite
+	uint32_t seekcount; // Number of file seeks performed (Sequential requests do not seek)
+	uint32_t partialcount; // Number of storage blocks read and rewritten for writes smaller than a block
+	uint64_t readbytes; // Total bytes read
+	uint64_t writebytes; // Total bytes written
+};
+
+/* ============================================================================== */
+/* SQLite VFS Functions */
+uint32_t STDCALL sqlite3_ultibo_register(BOOL makedefault);
+uint32_t STDCALL sqlite3_ultibo_unregister(void);
+
+uint32_t STDCALL sqlite3_ultibo_storage_register(const char *name, STORAGE_DEVICE *storage, int64_t start, int64_t count, uint32_t journalsize, uint32_t flags, BOOL makedefault); // Start and count are in blocks of the storage device
+uint32_t STDCALL sqlite3_ultibo_storage_unregister(const char *name);
+
+uint32_t STDCALL sqlite3_ultibo_get_statistics(const char *name, SQLITE3_ULTIBO_STATISTICS *statistics); // Name is the VFS name (eg SQLITE3_ULTIBO_VFS_NAME)
+uint32_t STDCALL sqlite3_ultibo_reset_statistics(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _SQLITE3_PORT_ULTIBO_H
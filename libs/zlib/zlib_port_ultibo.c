@@ -0,0 +1,1028 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/filesystem.h"
+#include "ultibo/logging.h"
+#include "ultibo/serial.h"
+
+#include "zlib_port_ultibo.h"
+
+/*
+ * Implementation of the Ultibo compressed logging port for zlib
+ *
+ * A Zlib logging device is a standard logging device whose output is compressed
+ * before being written to a file or a serial device. Callers of logging_device_output
+ * only copy the message into a buffer, a background thread swaps the buffer for an
+ * empty one and compresses everything that arrived since the last pass as a single
+ * batch, so the cost of deflate is paid at low priority and never by the thread that
+ * logged the message.
+ *
+ * Compressed data is written whenever the output buffer fills and at flush points,
+ * a flush point ends the current deflate block on a byte boundary (Z_SYNC_FLUSH) so
+ * that a reader can decompress every message written so far. Flush points occur when
+ * the configured interval has passed since the oldest unflushed message, when the
+ * configured amount of message data has been compressed, when a message at or above
+ * the flush severity is logged and when zlib_logging_flush is called. Infrequent flush
+ * points give the best compression ratio, each one costs a few bytes of padding.
+ *
+ * Output is divided into segments, each segment is a complete gzip member (Or zlib
+ * stream) and a new segment is started after the configured amount of message data
+ * or time. When the file name contains %u each segment is written to a new file with
+ * the segment number in the name (eg C:\Logs\system%u.log.gz), otherwise segments are
+ * appended to the same file which remains a valid gzip file since gzip allows members
+ * to be concatenated.
+ */
+
+/* ============================================================================== */
+/* Zlib Logging specific constants */
+#define ZLIB_LOGGING_SIGNATURE	0x5A4C4F47 // Signature for device validation
+
+#define ZLIB_LOGGING_LINE_END	"\r\n" // Line ending appended to each message
+
+#define ZLIB_LOGGING_SPACE_WAIT	1 // Time between checks for space in the buffer when waiting (Milliseconds)
+
+/* Zlib Window Bits for each Format */
+#define ZLIB_LOGGING_WINDOW_BITS	15
+#define ZLIB_LOGGING_MEMORY_LEVEL	8
+
+/* ============================================================================== */
+/* Zlib Logging specific types */
+typedef struct _ZLIB_LOGGING_DEVICE ZLIB_LOGGING_DEVICE;
+struct _ZLIB_LOGGING_DEVICE
+{
+	LOGGING_DEVICE logging; // Logging device entry (Must be first)
+	uint32_t signature; // Signature for device validation
+	ZLIB_LOGGING_CONFIG config; // Configuration with defaults applied
+	// Shared Properties (Protected by the logging device lock)
+	char target[ZLIB_LOGGING_MAX_TARGET]; // Current target file name or serial device name
+	char nexttarget[ZLIB_LOGGING_MAX_TARGET]; // Target requested by logging_device_set_target (Empty if none)
+	char *buffer; // Messages waiting for compression
+	uint32_t used; // Bytes used in the buffer
+	uint32_t flushrequest; // Sequence number of the last flush point requested
+	volatile uint32_t flushcomplete; // Sequence number of the last flush point written
+	BOOL rotaterequest; // A new segment has been requested
+	volatile BOOL running; // The compression thread should continue
+	// Thread Properties (Owned by the compression thread while running)
+	char *spare; // Buffer being compressed
+	uint8_t *output; // Compressed output buffer
+	z_stream stream; // Deflate state
+	HANDLE handle; // File handle for file output
+	SERIAL_DEVICE *serial; // Serial device for serial output
+	BOOL numbered; // The target contains %u
+	uint32_t segment; // Current segment number
+	uint32_t pendinginput; // Message data compressed since the last flush point
+	uint32_t segmentinput; // Message data compressed in the current segment
+	int64_t pendingtime; // Time of the oldest unflushed message (Milliseconds)
+	int64_t segmenttime; // Time that the current segment started (Milliseconds)
+	// Synchronization
+	SEMAPHORE_HANDLE signal; // Wakes the compression thread
+	SEMAPHORE_HANDLE finished; // Signalled when the compression thread exits
+	THREAD_HANDLE thread; // Compression thread
+	// Statistics
+	SPIN_HANDLE statisticslock;
+	ZLIB_LOGGING_STATISTICS statistics;
+};
+
+/* ============================================================================== */
+/* Zlib Logging Internal Functions */
+static ZLIB_LOGGING_DEVICE *zlib_logging_check(LOGGING_DEVICE *logging)
+{
+	ZLIB_LOGGING_DEVICE *device = (ZLIB_LOGGING_DEVICE *)logging;
+
+	if (!device || device->signature != ZLIB_LOGGING_SIGNATURE)
+		return NULL;
+
+	return device;
+}
+
+/* Check that a target contains no format specifiers other than a single %u */
+static BOOL zlib_logging_target_valid(uint32_t output, const char *target, BOOL *numbered)
+{
+	const char *percent;
+
+	*numbered = FALSE;
+
+	if (output == ZLIB_LOGGING_OUTPUT_NONE)
+		return TRUE;
+
+	if (!target || strlen(target) >= ZLIB_LOGGING_MAX_TARGET)
+		return FALSE;
+
+	if (output == ZLIB_LOGGING_OUTPUT_SERIAL)
+		return TRUE;
+
+	if (*target == '\0')
+		return FALSE;
+
+	percent = strchr(target, '%');
+	if (!percent)
+		return TRUE;
+
+	if (percent[1] != 'u' || strchr(percent + 1, '%'))
+		return FALSE;
+
+	*numbered = TRUE;
+
+	return TRUE;
+}
+
+static void zlib_logging_segment_name(ZLIB_LOGGING_DEVICE *device, uint32_t segment, char *name)
+{
+	if (device->numbered)
+		snprintf(name, ZLIB_LOGGING_MAX_TARGET, device->target, segment);
+	else
+		strcpy(name, device->target);
+}
+
+/* Find the segment number following the highest numbered segment file that already exists */
+static uint32_t zlib_logging_segment_scan(ZLIB_LOGGING_DEVICE *device)
+{
+	WIN32_FIND_DATAA data;
+	char wildcard[ZLIB_LOGGING_MAX_TARGET];
+	const char *pattern;
+	const char *separator;
+	uint32_t segment;
+	uint32_t next;
+	HANDLE find;
+	char *percent;
+
+	strcpy(wildcard, device->target);
+	percent = strchr(wildcard, '%');
+	percent[0] = '*';
+	memmove(percent + 1, percent + 2, strlen(percent + 2) + 1);
+
+	/* Match against the file name only, FindFirstFile does not return the path */
+	pattern = device->target;
+	separator = strrchr(pattern, '\\');
+	if (separator)
+		pattern = separator + 1;
+	separator = strrchr(pattern, '/');
+	if (separator)
+		pattern = separator + 1;
+
+	next = 0;
+
+	find = FindFirstFile(wildcard, &data);
+	if (find == INVALID_HANDLE_VALUE)
+		return next;
+
+	do
+	{
+		if (sscanf(data.cFileName, pattern, &segment) == 1 && segment >= next)
+			next = segment + 1;
+	} while (FindNextFile(find, &data));
+
+	FindCloseFile(find);
+
+	return next;
+}
+
+static void zlib_logging_account_error(ZLIB_LOGGING_DEVICE *device)
+{
+	spin_lock(device->statisticslock);
+	device->statistics.errorcount++;
+	spin_unlock(device->statisticslock);
+}
+
+static uint32_t zlib_logging_sink_open(ZLIB_LOGGING_DEVICE *device)
+{
+	char name[ZLIB_LOGGING_MAX_TARGET];
+	uint32_t status;
+	uint32_t old;
+
+	switch (device->config.output)
+	{
+		case ZLIB_LOGGING_OUTPUT_FILE:
+			zlib_logging_segment_name(device, device->segment, name);
+
+			if (device->numbered || !FileExists(name))
+			{
+				device->handle = FileCreate(name);
+			}
+			else
+			{
+				/* Append a new gzip member to the existing file */
+				device->handle = FileOpen(name, fmOpenReadWrite | fmShareDenyWrite);
+				if (device->handle != INVALID_HANDLE_VALUE)
+					FileSeek(device->handle, 0, fsFromEnd);
+			}
+			if (device->handle == INVALID_HANDLE_VALUE)
+				return ERROR_OPEN_FAILED;
+
+			/* Remove the oldest segment once the limit is reached */
+			if (device->numbered && device->config.maxsegments > 0 && device->segment >= device->config.maxsegments)
+			{
+				old = device->segment - device->config.maxsegments;
+				zlib_logging_segment_name(device, old, name);
+				DeleteFile(name);
+			}
+			break;
+		case ZLIB_LOGGING_OUTPUT_SERIAL:
+			if (device->target[0] == '\0')
+				device->serial = serial_device_get_default();
+			else
+				device->serial = serial_device_find_by_name(device->target);
+			if (!device->serial)
+				return ERROR_NOT_FOUND;
+
+			status = serial_device_open(device->serial, device->config.baudrate, SERIAL_DATA_8BIT, SERIAL_STOP_1BIT, SERIAL_PARITY_NONE, SERIAL_FLOW_NONE, 0, 0);
+			if (status != ERROR_SUCCESS && status != ERROR_ALREADY_OPEN)
+			{
+				device->serial = NULL;
+				return status;
+			}
+			break;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static void zlib_logging_sink_close(ZLIB_LOGGING_DEVICE *device)
+{
+	if (device->handle != INVALID_HANDLE_VALUE)
+	{
+		FileClose(device->handle);
+		device->handle = INVALID_HANDLE_VALUE;
+	}
+
+	/* The serial device is left open since it may be shared with other users */
+	device->serial = NULL;
+}
+
+static void zlib_logging_sink_write(ZLIB_LOGGING_DEVICE *device, uint8_t *data, uint32_t size)
+{
+	uint32_t count;
+	int64_t start;
+
+	start = clock_microseconds();
+
+	switch (device->config.output)
+	{
+		case ZLIB_LOGGING_OUTPUT_FILE:
+			if (device->handle == INVALID_HANDLE_VALUE || FileWrite(device->handle, data, size) != (int32_t)size)
+				zlib_logging_account_error(device);
+			break;
+		case ZLIB_LOGGING_OUTPUT_SERIAL:
+			if (!device->serial || serial_device_write(device->serial, data, size, SERIAL_WRITE_NONE, &count) != ERROR_SUCCESS || count != size)
+				zlib_logging_account_error(device);
+			break;
+	}
+
+	spin_lock(device->statisticslock);
+	device->statistics.outputbytes += size;
+	device->statistics.writetime += clock_microseconds() - start;
+	spin_unlock(device->statisticslock);
+}
+
+/* Compress data with the given flush mode and write all output produced */
+static void zlib_logging_deflate(ZLIB_LOGGING_DEVICE *device, char *data, uint32_t size, int flush)
+{
+	uint32_t available;
+	int64_t start;
+	int64_t elapsed;
+
+	device->stream.next_in = (Bytef *)data;
+	device->stream.avail_in = size;
+
+	elapsed = 0;
+	do
+	{
+		device->stream.next_out = device->output;
+		device->stream.avail_out = ZLIB_LOGGING_OUTPUT_SIZE;
+
+		start = clock_microseconds();
+		deflate(&device->stream, flush);
+		elapsed += clock_microseconds() - start;
+
+		available = ZLIB_LOGGING_OUTPUT_SIZE - device->stream.avail_out;
+		if (available > 0)
+			zlib_logging_sink_write(device, device->output, available);
+	} while (device->stream.avail_out == 0);
+
+	spin_lock(device->statisticslock);
+	device->statistics.inputbytes += size;
+	device->statistics.compresstime += elapsed;
+	spin_unlock(device->statisticslock);
+}
+
+static void zlib_logging_flush_point(ZLIB_LOGGING_DEVICE *device)
+{
+	zlib_logging_deflate(device, NULL, 0, (device->config.flags & ZLIB_LOGGING_FLAG_FULL_FLUSH) ? Z_FULL_FLUSH : Z_SYNC_FLUSH);
+
+	if (device->handle != INVALID_HANDLE_VALUE && !(device->config.flags & ZLIB_LOGGING_FLAG_NO_SYNC))
+		FileFlush(device->handle);
+
+	device->pendinginput = 0;
+
+	spin_lock(device->statisticslock);
+	device->statistics.flushcount++;
+	spin_unlock(device->statisticslock);
+}
+
+static uint32_t zlib_logging_segment_start(ZLIB_LOGGING_DEVICE *device)
+{
+	uint32_t status;
+
+	status = zlib_logging_sink_open(device);
+
+	device->segmentinput = 0;
+	device->segmenttime = clock_milliseconds();
+
+	spin_lock(device->statisticslock);
+	device->statistics.segmentcount++;
+	spin_unlock(device->statisticslock);
+
+	return status;
+}
+
+/* Finish the gzip member or zlib stream of the current segment and close the output */
+static void zlib_logging_segment_finish(ZLIB_LOGGING_DEVICE *device)
+{
+	zlib_logging_deflate(device, NULL, 0, Z_FINISH);
+
+	if (device->handle != INVALID_HANDLE_VALUE && !(device->config.flags & ZLIB_LOGGING_FLAG_NO_SYNC))
+		FileFlush(device->handle);
+
+	deflateReset(&device->stream);
+
+	device->pendinginput = 0;
+
+	zlib_logging_sink_close(device);
+}
+
+static void zlib_logging_segment_rotate(ZLIB_LOGGING_DEVICE *device, const char *target)
+{
+	zlib_logging_segment_finish(device);
+
+	if (target)
+	{
+		strcpy(device->target, target);
+		device->numbered = (device->config.output == ZLIB_LOGGING_OUTPUT_FILE && strchr(target, '%') != NULL);
+		device->segment = device->numbered ? zlib_logging_segment_scan(device) : 0;
+	}
+	else
+	{
+		device->segment++;
+	}
+
+	if (zlib_logging_segment_start(device) != ERROR_SUCCESS)
+		zlib_logging_account_error(device);
+}
+
+/* Time until the next time based flush point or rotation, INFINITE if none is due */
+static uint32_t zlib_logging_timeout(ZLIB_LOGGING_DEVICE *device)
+{
+	int64_t deadline;
+	int64_t remain;
+	int64_t now;
+
+	deadline = -1;
+
+	if (device->pendinginput > 0 && device->config.flushinterval != INFINITE)
+		deadline = device->pendingtime + device->config.flushinterval;
+
+	if (device->segmentinput > 0 && device->config.segmenttime > 0)
+	{
+		if (deadline < 0 || device->segmenttime + ((int64_t)device->config.segmenttime * 1000) < deadline)
+			deadline = device->segmenttime + ((int64_t)device->config.segmenttime * 1000);
+	}
+
+	if (deadline < 0)
+		return INFINITE;
+
+	now = clock_milliseconds();
+	remain = deadline - now;
+	if (remain <= 0)
+		return 0;
+
+	return (uint32_t)remain;
+}
+
+static ssize_t STDCALL zlib_logging_execute(void *parameter)
+{
+	ZLIB_LOGGING_DEVICE *device = parameter;
+	char target[ZLIB_LOGGING_MAX_TARGET];
+	uint32_t flushrequest;
+	BOOL rotaterequest;
+	BOOL running;
+	uint32_t size;
+	int64_t now;
+	char *data;
+
+	do
+	{
+		semaphore_wait_ex(device->signal, zlib_logging_timeout(device));
+
+		/* Take the batch of messages and give the callers the empty buffer */
+		mutex_lock(device->logging.lock);
+
+		data = device->buffer;
+		size = device->used;
+		device->buffer = device->spare;
+		device->spare = data;
+		device->used = 0;
+
+		flushrequest = device->flushrequest;
+		rotaterequest = device->rotaterequest;
+		device->rotaterequest = FALSE;
+		running = device->running;
+
+		target[0] = '\0';
+		if (device->nexttarget[0] != '\0')
+		{
+			strcpy(target, device->nexttarget);
+			device->nexttarget[0] = '\0';
+		}
+
+		mutex_unlock(device->logging.lock);
+
+		if (size > 0)
+		{
+			if (device->pendinginput == 0)
+				device->pendingtime = clock_milliseconds();
+
+			zlib_logging_deflate(device, data, size, Z_NO_FLUSH);
+
+			device->pendinginput += size;
+			device->segmentinput += size;
+		}
+
+		if (!running)
+			break;
+
+		now = clock_milliseconds();
+
+		if (rotaterequest
+		 || target[0] != '\0'
+		 || (device->config.segmentsize > 0 && device->segmentinput >= device->config.segmentsize)
+		 || (device->config.segmenttime > 0 && device->segmentinput > 0 && now - device->segmenttime >= (int64_t)device->config.segmenttime * 1000))
+		{
+			zlib_logging_segment_rotate(device, (target[0] != '\0') ? target : NULL);
+		}
+		else if (device->pendinginput > 0)
+		{
+			if (flushrequest != device->flushcomplete
+			 || (device->config.flushsize != INFINITE && device->pendinginput >= device->config.flushsize)
+			 || (device->config.flushinterval != INFINITE && now - device->pendingtime >= device->config.flushinterval))
+			{
+				zlib_logging_flush_point(device);
+			}
+		}
+
+		__atomic_store_n(&device->flushcomplete, flushrequest, __ATOMIC_RELEASE);
+	} while (TRUE);
+
+	zlib_logging_segment_finish(device);
+
+	__atomic_store_n(&device->flushcomplete, flushrequest, __ATOMIC_RELEASE);
+
+	semaphore_signal(device->finished);
+
+	return 0;
+}
+
+/* Copy a message into the buffer, waiting for space unless ZLIB_LOGGING_FLAG_DROP is set */
+static uint32_t zlib_logging_append(ZLIB_LOGGING_DEVICE *device, const char *prefix, const char *separator, const char *data, BOOL flush)
+{
+	uint32_t prefixsize;
+	uint32_t separatorsize;
+	uint32_t datasize;
+	uint32_t total;
+	BOOL waited;
+	BOOL wake;
+	char *next;
+
+	prefixsize = prefix ? strlen(prefix) : 0;
+	separatorsize = separator ? strlen(separator) : 0;
+	datasize = data ? strlen(data) : 0;
+	if (prefixsize == 0)
+		separatorsize = 0;
+
+	/* Truncate any message larger than the whole buffer */
+	total = prefixsize + separatorsize + datasize + (sizeof(ZLIB_LOGGING_LINE_END) - 1);
+	if (total > device->config.buffersize)
+	{
+		if (prefixsize + separatorsize + (sizeof(ZLIB_LOGGING_LINE_END) - 1) > device->config.buffersize)
+			return ERROR_INVALID_PARAMETER;
+
+		datasize = device->config.buffersize - (prefixsize + separatorsize + (sizeof(ZLIB_LOGGING_LINE_END) - 1));
+		total = device->config.buffersize;
+	}
+
+	if (mutex_lock(device->logging.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	waited = FALSE;
+	while (device->used + total > device->config.buffersize)
+	{
+		if (!device->running || (device->config.flags & ZLIB_LOGGING_FLAG_DROP))
+		{
+			mutex_unlock(device->logging.lock);
+
+			spin_lock(device->statisticslock);
+			device->statistics.droppedcount++;
+			spin_unlock(device->statisticslock);
+
+			return device->running ? ERROR_SUCCESS : ERROR_NOT_READY;
+		}
+
+		/* Wake the compression thread and wait for it to take the buffer */
+		mutex_unlock(device->logging.lock);
+
+		waited = TRUE;
+		semaphore_signal(device->signal);
+		thread_sleep(ZLIB_LOGGING_SPACE_WAIT);
+
+		mutex_lock(device->logging.lock);
+	}
+
+	next = device->buffer + device->used;
+	if (prefixsize > 0)
+	{
+		memcpy(next, prefix, prefixsize);
+		next += prefixsize;
+		memcpy(next, separator, separatorsize);
+		next += separatorsize;
+	}
+	memcpy(next, data, datasize);
+	next += datasize;
+	memcpy(next, ZLIB_LOGGING_LINE_END, sizeof(ZLIB_LOGGING_LINE_END) - 1);
+
+	device->used += total;
+	if (flush)
+		device->flushrequest++;
+
+	/* Wake the thread once the buffer is half full, otherwise messages are batched until the next timeout */
+	wake = (flush || device->used >= (device->config.buffersize / 2));
+
+	mutex_unlock(device->logging.lock);
+
+	spin_lock(device->statisticslock);
+	device->statistics.messagecount++;
+	if (waited)
+		device->statistics.waitcount++;
+	spin_unlock(device->statisticslock);
+
+	if (wake)
+		semaphore_signal(device->signal);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Zlib Logging Device Methods */
+static uint32_t STDCALL zlib_logging_device_start(LOGGING_DEVICE *logging)
+{
+	ZLIB_LOGGING_DEVICE *device;
+	int windowbits;
+	uint32_t status;
+
+	device = zlib_logging_check(logging);
+	if (!device)
+		return ERROR_INVALID_PARAMETER;
+
+	if (device->thread != INVALID_HANDLE_VALUE)
+		return ERROR_SUCCESS;
+
+	switch (device->config.format)
+	{
+		case ZLIB_LOGGING_FORMAT_ZLIB:
+			windowbits = ZLIB_LOGGING_WINDOW_BITS;
+			break;
+		case ZLIB_LOGGING_FORMAT_RAW:
+			windowbits = -ZLIB_LOGGING_WINDOW_BITS;
+			break;
+		default:
+			windowbits = ZLIB_LOGGING_WINDOW_BITS + 16;
+			break;
+	}
+
+	memset(&device->stream, 0, sizeof(z_stream));
+	if (deflateInit2(&device->stream, device->config.level, Z_DEFLATED, windowbits, ZLIB_LOGGING_MEMORY_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	if (device->numbered)
+		device->segment = zlib_logging_segment_scan(device);
+
+	device->used = 0;
+	device->pendinginput = 0;
+	device->rotaterequest = FALSE;
+	device->flushcomplete = device->flushrequest;
+
+	status = zlib_logging_segment_start(device);
+	if (status != ERROR_SUCCESS)
+	{
+		deflateEnd(&device->stream);
+		return status;
+	}
+
+	device->running = TRUE;
+
+	device->thread = thread_create(zlib_logging_execute, ZLIB_LOGGING_THREAD_STACK_SIZE, ZLIB_LOGGING_THREAD_PRIORITY, ZLIB_LOGGING_THREAD_NAME, device);
+	if (device->thread == INVALID_HANDLE_VALUE)
+	{
+		device->running = FALSE;
+		zlib_logging_sink_close(device);
+		deflateEnd(&device->stream);
+		return ERROR_OPERATION_FAILED;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL zlib_logging_device_stop(LOGGING_DEVICE *logging)
+{
+	ZLIB_LOGGING_DEVICE *device;
+
+	device = zlib_logging_check(logging);
+	if (!device)
+		return ERROR_INVALID_PARAMETER;
+
+	if (device->thread == INVALID_HANDLE_VALUE)
+		return ERROR_SUCCESS;
+
+	/* The thread compresses any remaining messages and finishes the segment before exiting */
+	mutex_lock(device->logging.lock);
+	device->running = FALSE;
+	mutex_unlock(device->logging.lock);
+
+	semaphore_signal(device->signal);
+	semaphore_wait(device->finished);
+
+	device->thread = INVALID_HANDLE_VALUE;
+
+	deflateEnd(&device->stream);
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL zlib_logging_device_output(LOGGING_DEVICE *logging, const char *data)
+{
+	ZLIB_LOGGING_DEVICE *device;
+	uint32_t status;
+
+	device = zlib_logging_check(logging);
+	if (!device)
+		return ERROR_INVALID_PARAMETER;
+
+	status = zlib_logging_append(device, NULL, NULL, data, FALSE);
+	if (status == ERROR_SUCCESS)
+		logging->outputcount++;
+
+	return status;
+}
+
+static uint32_t STDCALL zlib_logging_device_output_ex(LOGGING_DEVICE *logging, uint32_t facility, uint32_t severity, const char *tag, const char *content)
+{
+	ZLIB_LOGGING_DEVICE *device;
+	uint32_t status;
+	BOOL flush;
+
+	device = zlib_logging_check(logging);
+	if (!device)
+		return ERROR_INVALID_PARAMETER;
+
+	/* Lower severity values are more severe (eg LOGGING_SEVERITY_ERROR is 0) */
+	flush = (device->config.flushseverity != LOGGING_SEVERITY_INVALID && severity <= device->config.flushseverity);
+
+	if (tag && *tag != '\0')
+		status = zlib_logging_append(device, tag, ": ", content, flush);
+	else
+		status = zlib_logging_append(device, NULL, NULL, content, flush);
+	if (status == ERROR_SUCCESS)
+		logging->outputcount++;
+
+	return status;
+}
+
+static char * STDCALL zlib_logging_device_get_target(LOGGING_DEVICE *logging)
+{
+	ZLIB_LOGGING_DEVICE *device;
+
+	device = zlib_logging_check(logging);
+	if (!device)
+		return NULL;
+
+	return device->target;
+}
+
+/* Switch to a new target, the current segment is finished and the next one starts on the new target */
+static uint32_t STDCALL zlib_logging_device_set_target(LOGGING_DEVICE *logging, const char *target)
+{
+	ZLIB_LOGGING_DEVICE *device;
+	BOOL numbered;
+
+	device = zlib_logging_check(logging);
+	if (!device)
+		return ERROR_INVALID_PARAMETER;
+
+	if (device->config.output == ZLIB_LOGGING_OUTPUT_NONE || !zlib_logging_target_valid(device->config.output, target, &numbered))
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(device->logging.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	if (device->thread == INVALID_HANDLE_VALUE)
+	{
+		strcpy(device->target, target);
+		device->numbered = numbered;
+	}
+	else
+	{
+		strcpy(device->nexttarget, target);
+	}
+
+	mutex_unlock(device->logging.lock);
+
+	semaphore_signal(device->signal);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Zlib Logging Functions */
+LOGGING_DEVICE * STDCALL zlib_logging_create(const char *target, ZLIB_LOGGING_CONFIG *config, BOOL _default)
+{
+	ZLIB_LOGGING_DEVICE *device;
+	ZLIB_LOGGING_CONFIG defaults;
+	BOOL numbered;
+
+	if (!config)
+	{
+		memset(&defaults, 0, sizeof(ZLIB_LOGGING_CONFIG));
+		config = &defaults;
+	}
+
+	if (config->output > ZLIB_LOGGING_OUTPUT_NONE || config->format > ZLIB_LOGGING_FORMAT_RAW || config->level > Z_BEST_COMPRESSION)
+		return NULL;
+
+	if (!zlib_logging_target_valid(config->output, target, &numbered))
+		return NULL;
+
+	device = (ZLIB_LOGGING_DEVICE *)logging_device_create_ex(sizeof(ZLIB_LOGGING_DEVICE), _default);
+	if (!device)
+		return NULL;
+
+	device->signature = ZLIB_LOGGING_SIGNATURE;
+	device->config = *config;
+	if (device->config.level == 0)
+		device->config.level = ZLIB_LOGGING_DEFAULT_LEVEL;
+	if (device->config.buffersize == 0)
+		device->config.buffersize = ZLIB_LOGGING_DEFAULT_BUFFER_SIZE;
+	if (device->config.flushinterval == 0)
+		device->config.flushinterval = ZLIB_LOGGING_DEFAULT_FLUSH_INTERVAL;
+	if (device->config.flushsize == 0)
+		device->config.flushsize = ZLIB_LOGGING_DEFAULT_FLUSH_SIZE;
+
+	if (target)
+		strcpy(device->target, target);
+	device->numbered = numbered;
+
+	device->handle = INVALID_HANDLE_VALUE;
+	device->thread = INVALID_HANDLE_VALUE;
+
+	device->buffer = malloc(device->config.buffersize);
+	device->spare = malloc(device->config.buffersize);
+	device->output = malloc(ZLIB_LOGGING_OUTPUT_SIZE);
+	device->signal = semaphore_create(0);
+	device->finished = semaphore_create(0);
+	device->statisticslock = spin_create();
+	if (!device->buffer || !device->spare || !device->output || device->signal == INVALID_HANDLE_VALUE || device->finished == INVALID_HANDLE_VALUE || device->statisticslock == INVALID_HANDLE_VALUE)
+		goto failed;
+
+	/* Update Logging */
+	/* Device */
+	device->logging.device.devicebus = DEVICE_BUS_NONE;
+	device->logging.device.devicetype = (config->output == ZLIB_LOGGING_OUTPUT_SERIAL) ? LOGGING_TYPE_SERIAL : LOGGING_TYPE_FILE;
+	device->logging.device.deviceflags = LOGGING_FLAG_NONE;
+	device->logging.device.devicedata = NULL;
+	strncpy(device->logging.device.devicedescription, ZLIB_LOGGING_DESCRIPTION, DEVICE_DESC_LENGTH - 1);
+	/* Logging */
+	device->logging.loggingstate = LOGGING_STATE_DISABLED;
+	device->logging.devicestart = zlib_logging_device_start;
+	device->logging.devicestop = zlib_logging_device_stop;
+	device->logging.deviceoutput = zlib_logging_device_output;
+	device->logging.deviceoutputex = zlib_logging_device_output_ex;
+	device->logging.devicegettarget = zlib_logging_device_get_target;
+	device->logging.devicesettarget = zlib_logging_device_set_target;
+
+	if (logging_device_register(&device->logging) != ERROR_SUCCESS)
+		goto failed;
+
+	if (logging_device_start(&device->logging) != ERROR_SUCCESS)
+	{
+		logging_device_deregister(&device->logging);
+		goto failed;
+	}
+
+	if (_default)
+		logging_device_set_default(&device->logging);
+
+	return &device->logging;
+
+failed:
+	if (device->statisticslock != INVALID_HANDLE_VALUE)
+		spin_destroy(device->statisticslock);
+	if (device->finished != INVALID_HANDLE_VALUE)
+		semaphore_destroy(device->finished);
+	if (device->signal != INVALID_HANDLE_VALUE)
+		semaphore_destroy(device->signal);
+	free(device->output);
+	free(device->spare);
+	free(device->buffer);
+	device->signature = 0;
+	logging_device_destroy(&device->logging);
+
+	return NULL;
+}
+
+uint32_t STDCALL zlib_logging_destroy(LOGGING_DEVICE *logging)
+{
+	ZLIB_LOGGING_DEVICE *device;
+	uint32_t status;
+
+	device = zlib_logging_check(logging);
+	if (!device)
+		return ERROR_INVALID_PARAMETER;
+
+	logging_device_stop(logging);
+
+	status = logging_device_deregister(logging);
+	if (status != ERROR_SUCCESS)
+		return status;
+
+	/* Stop directly in case the device was already disabled */
+	zlib_logging_device_stop(logging);
+
+	spin_destroy(device->statisticslock);
+	semaphore_destroy(device->finished);
+	semaphore_destroy(device->signal);
+	free(device->output);
+	free(device->spare);
+	free(device->buffer);
+	device->signature = 0;
+
+	return logging_device_destroy(logging);
+}
+
+uint32_t STDCALL zlib_logging_flush(LOGGING_DEVICE *logging, uint32_t timeout)
+{
+	ZLIB_LOGGING_DEVICE *device;
+	uint32_t sequence;
+	int64_t start;
+
+	device = zlib_logging_check(logging);
+	if (!device)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(device->logging.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	if (device->thread == INVALID_HANDLE_VALUE)
+	{
+		mutex_unlock(device->logging.lock);
+		return ERROR_NOT_READY;
+	}
+
+	sequence = ++device->flushrequest;
+
+	mutex_unlock(device->logging.lock);
+
+	semaphore_signal(device->signal);
+
+	if (timeout == 0)
+		return ERROR_SUCCESS;
+
+	/* Wait for the thread to write a flush point covering this request */
+	start = clock_milliseconds();
+	while ((int32_t)(__atomic_load_n(&device->flushcomplete, __ATOMIC_ACQUIRE) - sequence) < 0)
+	{
+		if (timeout != INFINITE && clock_milliseconds() - start >= timeout)
+			return ERROR_WAIT_TIMEOUT;
+
+		thread_sleep(ZLIB_LOGGING_SPACE_WAIT);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL zlib_logging_rotate(LOGGING_DEVICE *logging)
+{
+	ZLIB_LOGGING_DEVICE *device;
+
+	device = zlib_logging_check(logging);
+	if (!device)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(device->logging.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	device->rotaterequest = TRUE;
+
+	mutex_unlock(device->logging.lock);
+
+	semaphore_signal(device->signal);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL zlib_logging_get_config(LOGGING_DEVICE *logging, ZLIB_LOGGING_CONFIG *config)
+{
+	ZLIB_LOGGING_DEVICE *device;
+
+	device = zlib_logging_check(logging);
+	if (!device || !config)
+		return ERROR_INVALID_PARAMETER;
+
+	*config = device->config;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL zlib_logging_get_statistics(LOGGING_DEVICE *logging, ZLIB_LOGGING_STATISTICS *statistics)
+{
+	ZLIB_LOGGING_DEVICE *device;
+
+	device = zlib_logging_check(logging);
+	if (!device || !statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	spin_lock(device->statisticslock);
+	*statistics = device->statistics;
+	spin_unlock(device->statisticslock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL zlib_logging_reset_statistics(LOGGING_DEVICE *logging)
+{
+	ZLIB_LOGGING_DEVICE *device;
+
+	device = zlib_logging_check(logging);
+	if (!device)
+		return ERROR_INVALID_PARAMETER;
+
+	spin_lock(device->statisticslock);
+	memset(&device->statistics, 0, sizeof(ZLIB_LOGGING_STATISTICS));
+	spin_unlock(device->statisticslock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL zlib_logging_format_to_string(uint32_t format, char *string, uint32_t len)
+{
+	const char *name;
+
+	if (!string || len == 0)
+		return 0;
+
+	switch (format)
+	{
+		case ZLIB_LOGGING_FORMAT_GZIP:
+			name = "ZLIB_LOGGING_FORMAT_GZIP";
+			break;
+		case ZLIB_LOGGING_FORMAT_ZLIB:
+			name = "ZLIB_LOGGING_FORMAT_ZLIB";
+			break;
+		case ZLIB_LOGGING_FORMAT_RAW:
+			name = "ZLIB_LOGGING_FORMAT_RAW";
+			break;
+		default:
+			name = "ZLIB_LOGGING_FORMAT_UNKNOWN";
+			break;
+	}
+
+	strncpy(string, name, len - 1);
+	string[len - 1] = '\0';
+
+	return strlen(string);
+}
@@ -0,0 +1,131 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef _ZLIB_PORT_ULTIBO_H
+#define _ZLIB_PORT_ULTIBO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ultibo/globaltypes.h"
+#include "ultibo/globalconst.h"
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/sysutils.h"
+#include "ultibo/devices.h"
+#include "ultibo/logging.h"
+#include "ultibo/serial.h"
+
+#include "zlib.h"
+
+/* ============================================================================== */
+/* Zlib Logging specific constants */
+#define ZLIB_LOGGING_DESCRIPTION	"Zlib Compressed Logging" // Description of Zlib logging devices
+
+#define ZLIB_LOGGING_THREAD_NAME	"Zlib Logging" // Thread name for Zlib logging compression threads
+#define ZLIB_LOGGING_THREAD_PRIORITY	THREAD_PRIORITY_LOWER // Thread priority for Zlib logging compression threads
+#define ZLIB_LOGGING_THREAD_STACK_SIZE	SIZE_16K // Stack size of Zlib logging compression threads
+
+#define ZLIB_LOGGING_DEFAULT_LEVEL	6 // Default compression level (1 = fastest to 9 = smallest)
+#define ZLIB_LOGGING_DEFAULT_BUFFER_SIZE	SIZE_32K // Default size of the buffer of messages waiting for compression (Bytes)
+#define ZLIB_LOGGING_DEFAULT_FLUSH_INTERVAL	1000 // Default maximum time that compressed output is held before a flush point (Milliseconds)
+#define ZLIB_LOGGING_DEFAULT_FLUSH_SIZE	SIZE_16K // Default amount of message data compressed between flush points (Bytes)
+
+#define ZLIB_LOGGING_OUTPUT_SIZE	SIZE_16K // Size of the compressed output buffer (Bytes)
+#define ZLIB_LOGGING_MAX_TARGET	MAX_PATH // Maximum length of a target file name or serial device name
+
+/* Zlib Logging Output */
+#define ZLIB_LOGGING_OUTPUT_FILE	0 // Compressed output to a file (Target is the file name)
+#define ZLIB_LOGGING_OUTPUT_SERIAL	1 // Compressed output to a serial device (Target is the device name, or empty for the default device)
+#define ZLIB_LOGGING_OUTPUT_NONE	2 // Compressed output is discarded (For measuring the cost of compression)
+
+/* Zlib Logging Format */
+#define ZLIB_LOGGING_FORMAT_GZIP	0 // Gzip framing, each segment is one gzip member (Readable by gunzip and zcat)
+#define ZLIB_LOGGING_FORMAT_ZLIB	1 // Zlib framing (RFC 1950)
+#define ZLIB_LOGGING_FORMAT_RAW	2 // Raw deflate data without a header or trailer (RFC 1951)
+
+/* Zlib Logging Flags */
+#define ZLIB_LOGGING_FLAG_NONE	0x00000000
+#define ZLIB_LOGGING_FLAG_FULL_FLUSH	0x00000001 // Flush points reset the compression dictionary so a reader can start decompressing from any flush point (Costs compression ratio)
+#define ZLIB_LOGGING_FLAG_DROP	0x00000002 // Messages are dropped when the buffer is full instead of waiting for space
+#define ZLIB_LOGGING_FLAG_NO_SYNC	0x00000004 // Do not flush file buffers to the disk at each flush point
+
+/* ============================================================================== */
+/* Zlib Logging specific types */
+
+/* Zlib Logging Configuration (Zero for any value selects the default) */
+typedef struct _ZLIB_LOGGING_CONFIG ZLIB_LOGGING_CONFIG;
+struct _ZLIB_LOGGING_CONFIG
+{
+	uint32_t output; // Where compressed data is written (eg ZLIB_LOGGING_OUTPUT_FILE)
+	uint32_t format; // Framing of the compressed data (eg ZLIB_LOGGING_FORMAT_GZIP)
+	uint32_t flags; // Zlib logging flags (eg ZLIB_LOGGING_FLAG_DROP)
+	uint32_t level; // Compression level from 1 to 9
+	uint32_t buffersize; // Size of the buffer of messages waiting for compression (Bytes)
+	uint32_t flushinterval; // Maximum time that compressed output is held before a flush point (Milliseconds, INFINITE for no time based flush)
+	uint32_t flushsize; // Amount of message data compressed between flush points (Bytes, INFINITE for no size based flush)
+	uint32_t flushseverity; // Messages at or above this severity force a flush point (eg LOGGING_SEVERITY_ERROR, LOGGING_SEVERITY_INVALID for none, applies to logging_device_output_ex only)
+	uint32_t segmentsize; // Amount of message data in each segment before rotation (Bytes, 0 for no size based rotation)
+	uint32_t segmenttime; // Time that each segment is open before rotation (Seconds, 0 for no time based rotation)
+	uint32_t maxsegments; // Number of segment files kept when the target contains %u, older segments are deleted (0 to keep all segments)
+	uint32_t baudrate; // Baud rate for serial output (eg SERIAL_BAUD_RATE_115200, zero selects SERIAL_BAUD_RATE_DEFAULT)
+};
+
+/* Zlib Logging Statistics */
+typedef struct _ZLIB_LOGGING_STATISTICS ZLIB_LOGGING_STATISTICS;
+struct _ZLIB_LOGGING_STATISTICS
+{
+	uint32_t messagecount; // Number of messages accepted
+	uint32_t droppedcount; // Number of messages dropped because the buffer was full (Only with ZLIB_LOGGING_FLAG_DROP)
+	uint32_t waitcount; // Number of times a caller waited for space in the buffer
+	uint32_t flushcount; // Number of flush points written
+	uint32_t segmentcount; // Number of segments started
+	uint32_t errorcount; // Number of errors writing compressed data
+	uint64_t inputbytes; // Total bytes of message data compressed
+	uint64_t outputbytes; // Total bytes of compressed data produced
+	uint64_t compresstime; // Total time spent compressing (Microseconds)
+	uint64_t writetime; // Total time spent writing compressed data (Microseconds)
+};
+
+/* ============================================================================== */
+/* Zlib Logging Functions */
+LOGGING_DEVICE * STDCALL zlib_logging_create(const char *target, ZLIB_LOGGING_CONFIG *config, BOOL _default); // Config may be NULL for the defaults, the device is registered and started
+uint32_t STDCALL zlib_logging_destroy(LOGGING_DEVICE *logging);
+
+uint32_t STDCALL zlib_logging_flush(LOGGING_DEVICE *logging, uint32_t timeout); // Write a flush point and wait until all messages accepted so far have been written (Timeout = 0 then No Wait,Timeout = INFINITE then Wait forever)
+uint32_t STDCALL zlib_logging_rotate(LOGGING_DEVICE *logging); // Finish the current segment and start a new one
+
+uint32_t STDCALL zlib_logging_get_config(LOGGING_DEVICE *logging, ZLIB_LOGGING_CONFIG *config);
+uint32_t STDCALL zlib_logging_get_statistics(LOGGING_DEVICE *logging, ZLIB_LOGGING_STATISTICS *statistics);
+uint32_t STDCALL zlib_logging_reset_statistics(LOGGING_DEVICE *logging);
+
+uint32_t STDCALL zlib_logging_format_to_string(uint32_t format, char *string, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ZLIB_PORT_ULTIBO_H
@@ -54,6 +54,7 @@
 #include "ultibo/console.h"
 #include "ultibo/pwm.h"
 #include "ultibo/filesystem.h"
+#include "ultibo/bootstage.h"
 
 #include "pwmsound.h"
 
@@ -419,6 +420,7 @@ static uint32_t pwmsound_play_sample(PWM_DEVICE * pwm, void *data, uint32_t size
 static uint32_t pwmsound_play_file(PWM_DEVICE * pwm, char *filename, uint32_t channel_count, uint32_t bit_count)
 {
   char value[256];
+  uint32_t status;
   uint32_t res = ERROR_INVALID_PARAMETER;
 
   /* Check PWM */
@@ -438,9 +440,14 @@ static uint32_t pwmsound_play_file(PWM_DEVICE * pwm, char *filename, uint32_t ch
   sprintf(value, "Playing %s on %u channel(s) at %u bits per channel", filename, (unsigned int)channel_count, (unsigned int)bit_count);
   console_write_ln(value);
 
-  /* Wait for SD Card */
-  while (!DirectoryExists("C:\\"))
-    thread_sleep(100);
+  /* Wait for SD Card (The drive_c stage fails if no drive C:\ appears within BOOT_STAGE_CORE_TIMEOUT) */
+  status = boot_stage_wait_name(BOOT_STAGE_DRIVE_C, INFINITE);
+  if (status != ERROR_SUCCESS)
+  {
+    sprintf(value, "Drive C:\\ not available (Status %u)", (unsigned int)status);
+    console_write_ln(value);
+    return res;
+  }
 
   /* Check File */
   if (!FileExists(filename))
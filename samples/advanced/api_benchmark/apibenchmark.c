@@ -0,0 +1,137 @@
+/*
+ *
+ * API Benchmark advanced example project for Ultibo API
+ *
+ * This example runs the standard benchmark suite (src/benchmark/benchsuite.c)
+ * which measures the thread primitives, heap, console, framebuffer, filesystem
+ * and loopback sockets with the benchmark harness (src/benchmark/benchmark.c).
+ *
+ * Each benchmark is pinned to CPU 0, warmed up and then repeated, the median,
+ * 99th percentile and standard deviation of each are shown in a console window.
+ * The full results are written as JSON to the default serial port and to the
+ * file C:\benchmark.json so that runs on different boards or with different
+ * versions of Ultibo core can be captured and compared.
+ *
+ * The project builds for every board type supported by Rules.mk, benchmarks
+ * that need a device the board does not have are reported as not supported.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/benchmark.h"
+
+/* File for the JSON results */
+#define RESULTS_FILE "C:\\benchmark.json"
+
+int apimain(int argc, char **argv)
+{
+	BENCHMARK_CONFIG config;
+	BENCHMARK_RESULT *results;
+	WINDOW_HANDLE window;
+	uint32_t status;
+	uint32_t count;
+	uint32_t index;
+	char group[32];
+	char text[256];
+
+	/* Create a console window for the results, the console benchmarks use a second window */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_LEFT, TRUE);
+
+	console_window_write_ln(window, "API Benchmark advanced example");
+	console_window_write_ln(window, "");
+
+	/* Wait for the system to settle and the network and drive C:\ to become available */
+	sleep(5);
+
+	snprintf(text, sizeof(text), "Clock rate %llu Hz, %u CPUs", (unsigned long long)benchmark_get_clock_rate(), (unsigned int)cpu_get_count());
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	count = benchmark_suite_get_count(BENCHMARK_GROUP_ALL);
+	results = calloc(count, sizeof(BENCHMARK_RESULT));
+	if (!results)
+	{
+		console_window_write_ln(window, "Failed to allocate results");
+		thread_halt(0);
+	}
+
+	/* Defaults for everything except the CPU */
+	memset(&config, 0, sizeof(BENCHMARK_CONFIG));
+	config.cpu = CPU_ID_0;
+	config.flags = BENCHMARK_FLAG_LOG;
+
+	status = benchmark_suite_run(BENCHMARK_GROUP_ALL, &config, results, count, &count);
+	if (status != ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), "Benchmark suite failed (Status %u)", (unsigned int)status);
+		console_window_write_ln(window, text);
+		thread_halt(0);
+	}
+
+	for (index = 0; index < count; index++)
+	{
+		benchmark_group_to_string(results[index].group, group, sizeof(group));
+
+		if (results[index].status == ERROR_SUCCESS)
+			snprintf(text, sizeof(text), "%-11s %-28s %10.1f ns p99 %10.1f sd %8.1f", group, results[index].name, results[index].median, results[index].p99, results[index].stddev);
+		else if (results[index].status == ERROR_NOT_SUPPORTED)
+			snprintf(text, sizeof(text), "%-11s %-28s not supported", group, results[index].name);
+		else
+			snprintf(text, sizeof(text), "%-11s %-28s failed (Status %u)", group, results[index].name, (unsigned int)results[index].status);
+
+		console_window_write_ln(window, text);
+	}
+	console_window_write_ln(window, "");
+
+	/* Send the JSON results to the serial port */
+	if (serial_open(115200, SERIAL_DATA_8BIT, SERIAL_STOP_1BIT, SERIAL_PARITY_NONE, SERIAL_FLOW_NONE, 0, 0) == ERROR_SUCCESS)
+	{
+		benchmark_export_serial(results, count);
+		serial_close();
+
+		console_window_write_ln(window, "Results sent to the serial port");
+	}
+
+	if (benchmark_export_file(results, count, RESULTS_FILE) == ERROR_SUCCESS)
+		console_window_write_ln(window, "Results written to " RESULTS_FILE);
+
+	free(results);
+
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
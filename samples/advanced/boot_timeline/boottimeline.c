@@ -0,0 +1,158 @@
+/*
+ *
+ * Boot Timeline advanced example project for Ultibo API
+ *
+ * Declares the startup work of a small application as boot stages which run in
+ * parallel on the secondary CPUs as soon as their dependencies are ready, while
+ * the main thread shows the console straight away. When the application stage is
+ * ready the time since the clock started is shown followed by the boot timeline.
+ *
+ * The settings stage depends on the core drive_c stage and is optional, without
+ * an SD card it fails once the core stage times out and the application still
+ * becomes ready, the failure is recorded in the timeline.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/bootstage.h"
+
+#define TABLE_SIZE	65536
+#define SETTINGS_FILE	"C:\\cmdline.txt"
+#define NETWORK_TIMEOUT	10000
+
+WINDOW_HANDLE window;
+
+static float table[TABLE_SIZE];
+static char settings[1024];
+
+/* Stand in for CPU bound startup work such as building lookup tables */
+static uint32_t STDCALL tables_start(BOOT_STAGE *stage, void *data)
+{
+	uint32_t index;
+
+	for (index = 0; index < TABLE_SIZE; index++)
+		table[index] = sinf((2.0f * 3.14159265f * index) / TABLE_SIZE);
+
+	return ERROR_SUCCESS;
+}
+
+/* Read the settings once drive C:\ is ready */
+static uint32_t STDCALL settings_start(BOOT_STAGE *stage, void *data)
+{
+	FILE *file;
+	size_t count;
+
+	file = fopen(SETTINGS_FILE, "r");
+	if (!file)
+		return ERROR_FILE_NOT_FOUND;
+
+	count = fread(settings, 1, sizeof(settings) - 1, file);
+	settings[count] = '\0';
+	fclose(file);
+
+	return ERROR_SUCCESS;
+}
+
+/* Runs only after the tables and settings stages have finished */
+static uint32_t STDCALL application_start(BOOT_STAGE *stage, void *data)
+{
+	if (table[TABLE_SIZE / 4] < 0.99f)
+		return ERROR_OPERATION_FAILED;
+
+	return ERROR_SUCCESS;
+}
+
+static void STDCALL timeline_output(const char *text, void *data)
+{
+	console_window_write_ln((WINDOW_HANDLE)data, text);
+}
+
+int apimain(int argc, char **argv)
+{
+	BOOT_STAGE *tables;
+	BOOT_STAGE *settingsstage;
+	BOOT_STAGE *application;
+	uint32_t status;
+	char state[32];
+	char text[256];
+
+	boot_timeline_mark("apimain");
+
+	/* Create a console window, nothing here waits for the file system or network */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "Boot Timeline");
+	console_window_write_ln(window, "");
+
+	boot_timeline_mark("console");
+
+	/* Declare the stages, CPU_ID_ALL spreads them over the secondary CPUs */
+	tables = boot_stage_create("tables", tables_start, NULL, CPU_ID_ALL, BOOT_STAGE_FLAG_NONE);
+	settingsstage = boot_stage_create("settings", settings_start, NULL, CPU_ID_ALL, BOOT_STAGE_FLAG_OPTIONAL);
+	application = boot_stage_create("application", application_start, NULL, CPU_ID_ALL, BOOT_STAGE_FLAG_NONE);
+	if (!tables || !settingsstage || !application)
+	{
+		console_window_write_ln(window, "Failed to create boot stages");
+		thread_halt(0);
+	}
+
+	boot_stage_depends(settingsstage, boot_stage_find(BOOT_STAGE_DRIVE_C));
+	boot_stage_depends(application, tables);
+	boot_stage_depends(application, settingsstage);
+
+	/* Starting the application stage also starts the stages it depends on */
+	status = boot_stage_wait(application, INFINITE);
+	boot_timeline_mark("application ready");
+
+	snprintf(text, sizeof(text), "Application ready after %lld ms (Status %u)", (long long)(clock_microseconds() / 1000), (unsigned int)status);
+	console_window_write_ln(window, text);
+
+	boot_stage_state_to_string(boot_stage_get_state(settingsstage), state, sizeof(state));
+	snprintf(text, sizeof(text), "Settings stage is %s (Status %u)", state, (unsigned int)boot_stage_get_status(settingsstage));
+	console_window_write_ln(window, text);
+
+	/* The network is not needed by the application, it is waited for here only to show it in the timeline */
+	status = boot_stage_wait_name(BOOT_STAGE_NETWORK, NETWORK_TIMEOUT);
+	snprintf(text, sizeof(text), "Network stage wait returned %u", (unsigned int)status);
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	boot_timeline_log(timeline_output, (void *)window);
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
@@ -0,0 +1,175 @@
+/*
+ *
+ * Console Text advanced example project for Ultibo API
+ *
+ * This example measures the speed of writing text to a console window and of
+ * scrolling the window, first using the standard console device methods and
+ * then again after attaching a glyph cache (src/console/glyphcache.c) to the
+ * console device.
+ *
+ * With the glyph cache attached each line of text is built from glyphs that
+ * are already expanded to framebuffer pixels and written with a single blit,
+ * scrolling moves the framebuffer memory directly.
+ *
+ * The results are shown in a second console window on the right side of the
+ * screen.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/framebuffer.h"
+#include "ultibo/glyphcache.h"
+
+/* Number of lines written for each test */
+#define TEST_LINES 2000
+
+/* Test results */
+typedef struct
+{
+	double charspersec;
+	double linespersec;
+} TEST_RESULT;
+
+/* Write lines to the window until it scrolls and measure the rate */
+static void run_test(WINDOW_HANDLE window, TEST_RESULT *result)
+{
+	char line[256];
+	uint32_t cols;
+	uint32_t count;
+	uint32_t chars;
+	int64_t start;
+	int64_t elapsed;
+
+	cols = console_window_get_cols(window);
+	if (cols >= sizeof(line))
+		cols = sizeof(line) - 1;
+
+	console_window_clear(window);
+
+	chars = 0;
+	start = clock_microseconds();
+	for (count = 0; count < TEST_LINES; count++)
+	{
+		/* Fill each line so the whole window width is drawn */
+		memset(line, 'A' + (count % 26), cols);
+		snprintf(line, cols, "Line %u ", (unsigned int)count);
+		line[strlen(line)] = ' ';
+		line[cols] = '\0';
+
+		console_window_write_ln(window, line);
+		chars += cols;
+	}
+	elapsed = clock_microseconds() - start;
+	if (elapsed < 1)
+		elapsed = 1;
+
+	result->charspersec = ((double)chars * 1000000.0) / elapsed;
+	result->linespersec = ((double)TEST_LINES * 1000000.0) / elapsed;
+}
+
+int apimain(int argc, char **argv)
+{
+	CONSOLE_DEVICE *console;
+	WINDOW_HANDLE testwindow;
+	WINDOW_HANDLE resultwindow;
+	GLYPH_CACHE_STATISTICS statistics;
+	TEST_RESULT before;
+	TEST_RESULT after;
+	uint32_t status;
+	char text[256];
+
+	/* Get the default console device */
+	console = console_device_get_default();
+	if (!console)
+		return -1;
+
+	/* Create a window for the results and a window for the test */
+	resultwindow = console_window_create(console, CONSOLE_POSITION_RIGHT, TRUE);
+	testwindow = console_window_create(console, CONSOLE_POSITION_LEFT, FALSE);
+
+	console_window_write_ln(resultwindow, "Console Text advanced example");
+	console_window_write_ln(resultwindow, "");
+
+	/* Wait a moment for the system to settle */
+	sleep(2);
+
+	/* Test using the standard console methods */
+	console_window_write_ln(resultwindow, "Testing standard console text");
+	run_test(testwindow, &before);
+
+	snprintf(text, sizeof(text), " %.0f chars/sec %.0f lines/sec", before.charspersec, before.linespersec);
+	console_window_write_ln(resultwindow, text);
+	console_window_write_ln(resultwindow, "");
+
+	/* Attach a glyph cache to the console and test again */
+	status = console_device_glyph_cache_attach(console, NULL, GLYPH_CACHE_FLAG_ALL);
+	if (status != ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), "Glyph cache attach failed (Status=%u)", (unsigned int)status);
+		console_window_write_ln(resultwindow, text);
+
+		thread_halt(0);
+	}
+
+	console_window_write_ln(resultwindow, "Testing glyph cache console text");
+	run_test(testwindow, &after);
+
+	snprintf(text, sizeof(text), " %.0f chars/sec %.0f lines/sec", after.charspersec, after.linespersec);
+	console_window_write_ln(resultwindow, text);
+	console_window_write_ln(resultwindow, "");
+
+	snprintf(text, sizeof(text), "Speedup %.2fx", after.charspersec / before.charspersec);
+	console_window_write_ln(resultwindow, text);
+	console_window_write_ln(resultwindow, "");
+
+	/* Show the glyph cache statistics */
+	if (glyph_cache_get_statistics(console_device_glyph_cache_get(console), &statistics) == ERROR_SUCCESS)
+	{
+		console_window_write_ln(resultwindow, "Glyph cache statistics");
+
+		snprintf(text, sizeof(text), " Entries = %u Memory = %u bytes", (unsigned int)statistics.entrycount, (unsigned int)statistics.memoryused);
+		console_window_write_ln(resultwindow, text);
+		snprintf(text, sizeof(text), " Hits = %u Misses = %u Evictions = %u", (unsigned int)statistics.hitcount, (unsigned int)statistics.misscount, (unsigned int)statistics.evictcount);
+		console_window_write_ln(resultwindow, text);
+		snprintf(text, sizeof(text), " Expanded = %u Runs = %u Chars = %u", (unsigned int)statistics.expandcount, (unsigned int)statistics.textcount, (unsigned int)statistics.charcount);
+		console_window_write_ln(resultwindow, text);
+		snprintf(text, sizeof(text), " Scrolls = %u", (unsigned int)statistics.scrollcount);
+		console_window_write_ln(resultwindow, text);
+	}
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
@@ -0,0 +1,787 @@
+/*
+ *
+ * Crypto Benchmark advanced example project for Ultibo API
+ *
+ * Checks the hashes and ciphers of the crypto API against known answer vectors,
+ * first with the portable C code and then with the ARMv8 instructions (If present),
+ * then measures the throughput of each in MB/s with and without the instructions.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/benchmark.h"
+#include "ultibo/crypto.h"
+
+/* File for the JSON results */
+#define RESULTS_FILE "C:\\cryptobenchmark.json"
+
+/* Size of the buffer processed by each benchmark iteration (Bytes) */
+#define BUFFER_SIZE SIZE_16K
+
+/* Test kinds */
+#define TEST_MD5 0
+#define TEST_SHA1 1
+#define TEST_SHA256 2
+#define TEST_SHA512 3
+#define TEST_HMAC_SHA256 4
+#define TEST_CRC32 5
+#define TEST_CRC32C 6
+#define TEST_AES128_ECB 7
+#define TEST_AES128_CBC_ENCRYPT 8
+#define TEST_AES128_CBC_DECRYPT 9
+#define TEST_AES128_CTR 10
+#define TEST_AES256_CTR 11
+#define TEST_AES128_GCM 12
+#define TEST_DES_CBC 13
+#define TEST_3DES_CBC 14
+#define TEST_RC4 15
+
+#define TEST_KIND_COUNT 16
+
+#define MAX_TESTS (TEST_KIND_COUNT * 2)
+
+/* Test parameters, one per benchmark */
+typedef struct
+{
+	uint32_t kind;
+	uint32_t features; // Crypto features to enable while the test runs (eg CRYPTO_FEATURE_NONE for the C path)
+} TEST_PARAMETER;
+
+/* Test data, allocated by setup */
+typedef struct
+{
+	const TEST_PARAMETER *parameter;
+	uint8_t *source;
+	uint8_t *dest;
+	uint8_t vector[AES_BLOCK_SIZE];
+	uint8_t tag[AES_GCM_TAG_SIZE];
+	AES_KEY aeskey;
+	AES_CTR_CONTEXT ctr;
+	HASH_CONTEXT *hash;
+	CIPHER_CONTEXT *cipher;
+	RC4_STATE rc4;
+	volatile uint32_t crc;
+} TEST_DATA;
+
+/* Benchmark names and the feature which accelerates each kind (If any) */
+static const char *test_names[] = {"md5", "sha1", "sha256", "sha512", "hmac_sha256", "crc32", "crc32c", "aes128_ecb", "aes128_cbc_encrypt", "aes128_cbc_decrypt",
+	"aes128_ctr", "aes256_ctr", "aes128_gcm", "des_cbc", "3des_cbc", "rc4"};
+static const uint32_t test_features[] = {CRYPTO_FEATURE_NONE, CRYPTO_FEATURE_SHA1, CRYPTO_FEATURE_SHA256, CRYPTO_FEATURE_NONE, CRYPTO_FEATURE_SHA256, CRYPTO_FEATURE_CRC32, CRYPTO_FEATURE_CRC32,
+	CRYPTO_FEATURE_AES, CRYPTO_FEATURE_AES, CRYPTO_FEATURE_AES, CRYPTO_FEATURE_AES, CRYPTO_FEATURE_AES, CRYPTO_FEATURE_AES | CRYPTO_FEATURE_PMULL, CRYPTO_FEATURE_NONE, CRYPTO_FEATURE_NONE, CRYPTO_FEATURE_NONE};
+
+static const uint8_t test_key[32] = {
+	0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+	0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4};
+
+static TEST_PARAMETER parameters[MAX_TESTS];
+static char names[MAX_TESTS][BENCHMARK_NAME_LENGTH];
+static BENCHMARK tests[MAX_TESTS];
+static BENCHMARK_RESULT results[MAX_TESTS];
+
+static WINDOW_HANDLE window;
+
+/* Self test counts */
+static uint32_t group_passed;
+static uint32_t group_count;
+static uint32_t total_passed;
+static uint32_t total_count;
+
+/* ============================================================================== */
+/* Self test of the vectors from tests/APICrypto.pas */
+static void hex_to_bytes(const char *hex, uint8_t *bytes)
+{
+	unsigned int value;
+
+	while (hex[0] && hex[1])
+	{
+		sscanf(hex, "%2x", &value);
+		*bytes++ = value;
+		hex += 2;
+	}
+}
+
+static void group_begin(void)
+{
+	group_passed = 0;
+	group_count = 0;
+}
+
+static void group_end(const char *name)
+{
+	char text[128];
+
+	snprintf(text, sizeof(text), "%-12s %u of %u correct", name, (unsigned int)group_passed, (unsigned int)group_count);
+	console_window_write_ln(window, text);
+
+	total_passed += group_passed;
+	total_count += group_count;
+}
+
+/* Compare a result with the expected hex string, failures are shown with both values */
+static void check(const char *name, const uint8_t *result, uint32_t size, const char *expected)
+{
+	static const char hex[] = "0123456789abcdef";
+	char actual[SIZE_256];
+	char text[SIZE_512];
+	uint32_t count;
+
+	for (count = 0; count < size && count < (sizeof(actual) - 1) / 2; count++)
+	{
+		actual[count * 2] = hex[result[count] >> 4];
+		actual[(count * 2) + 1] = hex[result[count] & 0xF];
+	}
+	actual[count * 2] = '\0';
+
+	group_count++;
+	if (strcasecmp(actual, expected) == 0)
+	{
+		group_passed++;
+		return;
+	}
+
+	snprintf(text, sizeof(text), "%s incorrect, expected %s got %s", name, expected, actual);
+	console_window_write_ln(window, text);
+}
+
+static void check_bool(const char *name, BOOL result)
+{
+	group_count++;
+	if (result)
+	{
+		group_passed++;
+		return;
+	}
+
+	console_window_write_ln(window, name);
+}
+
+/* Digest of a single block, count copies of value or an explicit size of data */
+static BOOL digest_block(uint32_t algorithm, const void *data, uint32_t size, uint8_t *digest)
+{
+	CRYPTO_BLOCK block;
+
+	block.data = (void *)data;
+	block.size = size;
+	block.next = NULL;
+
+	switch (algorithm)
+	{
+		case CRYPTO_HASH_ALG_MD5:
+			return md5_digest_data(&block, digest);
+		case CRYPTO_HASH_ALG_SHA1:
+			return sha1_digest_data(&block, digest);
+		case CRYPTO_HASH_ALG_SHA256:
+			return sha256_digest_data(&block, digest);
+		case CRYPTO_HASH_ALG_SHA384:
+			return sha384_digest_data(&block, digest);
+		case CRYPTO_HASH_ALG_SHA512:
+			return sha512_digest_data(&block, digest);
+	}
+
+	return FALSE;
+}
+
+static void test_hashes(void)
+{
+	static const char *abc = "abc";
+	static const char *long_text = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	static const char *fox = "The quick brown fox jumps over the lazy dog";
+	uint8_t digest[SHA512_DIGEST_SIZE];
+	uint8_t bytes[256];
+	uint8_t *million;
+	uint32_t count;
+	HASH_CONTEXT *context;
+
+	million = malloc(1000000);
+	if (!million)
+		return;
+	memset(million, 'a', 1000000);
+
+	for (count = 0; count < sizeof(bytes); count++)
+		bytes[count] = count;
+
+	group_begin();
+	md5_digest_string(abc, digest);
+	check("MD5 abc", digest, MD5_DIGEST_SIZE, "900150983cd24fb0d6963f7d28e17f72");
+	md5_digest_string(long_text, digest);
+	check("MD5 abcdbcde", digest, MD5_DIGEST_SIZE, "8215ef0796a20bcaaae116d3876c664a");
+	digest_block(CRYPTO_HASH_ALG_MD5, million, 1000000, digest);
+	check("MD5 million a", digest, MD5_DIGEST_SIZE, "7707d6ae4e027c70eea2a935c2296f21");
+	md5_digest_string(fox, digest);
+	check("MD5 fox", digest, MD5_DIGEST_SIZE, "9e107d9d372bb6826bd81d3542a419d6");
+	md5_digest_string("", digest);
+	check("MD5 empty", digest, MD5_DIGEST_SIZE, "d41d8cd98f00b204e9800998ecf8427e");
+	hmac_md5_digest_string("key", fox, digest);
+	check("HMAC-MD5 fox", digest, MD5_DIGEST_SIZE, "80070713463e7749b90c2dc24911e275");
+	hmac_md5_digest_string("", "", digest);
+	check("HMAC-MD5 empty", digest, MD5_DIGEST_SIZE, "74e6f7298a9c2d168935f58c001bad88");
+	group_end("MD5");
+
+	group_begin();
+	sha1_digest_string(abc, digest);
+	check("SHA1 abc", digest, SHA1_DIGEST_SIZE, "a9993e364706816aba3e25717850c26c9cd0d89d");
+	sha1_digest_string(long_text, digest);
+	check("SHA1 abcdbcde", digest, SHA1_DIGEST_SIZE, "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+	digest_block(CRYPTO_HASH_ALG_SHA1, million, 1000000, digest);
+	check("SHA1 million a", digest, SHA1_DIGEST_SIZE, "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+	sha1_digest_string(fox, digest);
+	check("SHA1 fox", digest, SHA1_DIGEST_SIZE, "2fd4e1c67a2d28fced849ee1bb76e7391b93eb12");
+	sha1_digest_string("", digest);
+	check("SHA1 empty", digest, SHA1_DIGEST_SIZE, "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+	hmac_sha1_digest_string("key", fox, digest);
+	check("HMAC-SHA1 fox", digest, SHA1_DIGEST_SIZE, "de7c9b85b8b78aa6bc8a7a36f70a90701c9db4d9");
+	hmac_sha1_digest_string("", "", digest);
+	check("HMAC-SHA1 empty", digest, SHA1_DIGEST_SIZE, "fbdb1d1b18aa6c08324b7d64b71fb76370690e1d");
+	group_end("SHA1");
+
+	group_begin();
+	sha256_digest_string(abc, digest);
+	check("SHA256 abc", digest, SHA256_DIGEST_SIZE, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+	sha256_digest_string(long_text, digest);
+	check("SHA256 abcdbcde", digest, SHA256_DIGEST_SIZE, "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+	digest_block(CRYPTO_HASH_ALG_SHA256, million, 1000000, digest);
+	check("SHA256 million a", digest, SHA256_DIGEST_SIZE, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+	sha256_digest_string("", digest);
+	check("SHA256 empty", digest, SHA256_DIGEST_SIZE, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	digest_block(CRYPTO_HASH_ALG_SHA256, bytes, 128, digest);
+	check("SHA256 bytes", digest, SHA256_DIGEST_SIZE, "471fb943aa23c511f6f72f8d1652d9c880cfa392ad80503120547703e56a2be5");
+	hmac_sha256_digest_string("key", fox, digest);
+	check("HMAC-SHA256 fox", digest, SHA256_DIGEST_SIZE, "f7bc83f430538424b13298e6aa6fb143ef4d59a14946175997479dbc2d1a3cd8");
+	hmac_sha256_digest_string("", "", digest);
+	check("HMAC-SHA256 empty", digest, SHA256_DIGEST_SIZE, "b613679a0814d9ec772f95d778c35fc5ff1697c493715653c6c712144292c5ad");
+	group_end("SHA256");
+
+	group_begin();
+	digest_block(CRYPTO_HASH_ALG_SHA384, bytes, 128, digest);
+	check("SHA384 128 bytes", digest, SHA384_DIGEST_SIZE, "ca2385773319124534111a36d0581fc3f00815e907034b90cff9c3a861e126a741d5dfcff65a417b6d7296863ac0ec17");
+	digest_block(CRYPTO_HASH_ALG_SHA384, bytes, 256, digest);
+	check("SHA384 256 bytes", digest, SHA384_DIGEST_SIZE, "ffdaebff65ed05cf400f0221c4ccfb4b2104fb6a51f87e40be6c4309386bfdec2892e9179b34632331a59592737db5c5");
+	group_end("SHA384");
+
+	group_begin();
+	digest_block(CRYPTO_HASH_ALG_SHA512, bytes, 128, digest);
+	check("SHA512 128 bytes", digest, SHA512_DIGEST_SIZE, "1dffd5e3adb71d45d2245939665521ae001a317a03720a45732ba1900ca3b8351fc5c9b4ca513eba6f80bc7b1d1fdad4abd13491cb824d61b08d8c0e1561b3f7");
+	digest_block(CRYPTO_HASH_ALG_SHA512, bytes, 256, digest);
+	check("SHA512 256 bytes", digest, SHA512_DIGEST_SIZE, "1e7b80bc8edc552c8feeb2780e111477e5bc70465fac1a77b29b35980c3f0ce4a036a6c9462036824bd56801e62af7e9feba5c22ed8a5af877bf7de117dcac6d");
+	group_end("SHA512");
+
+	/* Streaming interface with a key longer than the block size */
+	group_begin();
+	memset(bytes, 0xAA, 80);
+	context = hash_create(CRYPTO_HASH_ALG_HMAC_MD5, bytes, 80);
+	hash_update(context, "Test Using Larger Than Block-Size Key and Larger Than One Block-Size Data", 73);
+	hash_finish(context, digest, sizeof(digest));
+	check("HMAC-MD5 long key", digest, MD5_DIGEST_SIZE, "6f630fad67cda0ee1fb1f562db3aa53e");
+	hash_destroy(context);
+
+	context = hash_create(CRYPTO_HASH_ALG_HMAC_SHA1, bytes, 80);
+	hash_update(context, "Test Using Larger Than Block-Size Key and Larger Than One Block-Size Data", 73);
+	hash_finish(context, digest, sizeof(digest));
+	check("HMAC-SHA1 long key", digest, SHA1_DIGEST_SIZE, "e8e99d0f45237d786d6bbaa7965c7808bbff1a91");
+	hash_destroy(context);
+
+	context = hash_create(CRYPTO_HASH_ALG_HMAC_MD5, "key", 3);
+	for (count = 0; count < strlen(fox); count += 7)
+		hash_update(context, fox + count, (strlen(fox) - count < 7) ? strlen(fox) - count : 7);
+	hash_finish(context, digest, sizeof(digest));
+	check("Hash HMAC-MD5", digest, MD5_DIGEST_SIZE, "80070713463e7749b90c2dc24911e275");
+	hash_update(context, fox, strlen(fox));
+	hash_finish(context, digest, sizeof(digest));
+	check("Hash HMAC-MD5 again", digest, MD5_DIGEST_SIZE, "80070713463e7749b90c2dc24911e275");
+	hash_destroy(context);
+
+	/* Check values for CRC32 and CRC32C are the CRC of "123456789" */
+	context = hash_create(CRYPTO_HASH_ALG_CRC32, NULL, 0);
+	hash_update(context, "123456789", 9);
+	hash_finish(context, digest, sizeof(digest));
+	check("CRC32", digest, 4, "cbf43926");
+	hash_destroy(context);
+	check_bool("CRC32C incorrect", crc32c_update(0, "123456789", 9) == 0xE3069283);
+	check_bool("CRC32 split incorrect", crc32_update(crc32_update(0, million, 1001), million, 99999) == crc32_update(0, million, 101000));
+	group_end("Hash");
+
+	free(million);
+}
+
+static void test_ciphers(void)
+{
+	static const char *message = "This is the message to encrypt!!";
+	uint8_t key[32];
+	uint8_t vector[AES_BLOCK_SIZE];
+	uint8_t plain[64];
+	uint8_t crypt[64];
+	uint8_t result[64];
+	AES_KEY aeskey;
+	DES_KEY encryptkey;
+	DES_KEY decryptkey;
+	CIPHER_CONTEXT *context;
+
+	/* RC4 with the stream offsets from RFC 6229 */
+	group_begin();
+	memset(plain, 0, sizeof(plain));
+	hex_to_bytes("0102030405", key);
+	rc4_encrypt_data(key, 5, plain, crypt, 32, 0);
+	check("RC4 40 bit offset 0", crypt, 32, "b2396305f03dc027ccc3524a0a1118a86982944f18fc82d589c403a47a0d0919");
+	rc4_encrypt_data(key, 5, plain, crypt, 32, 1520);
+	check("RC4 40 bit offset 1520", crypt, 32, "3294f744d8f9790507e70f62e5bbceead8729db41882259bee4f825325f5a130");
+	hex_to_bytes("0102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f20", key);
+	rc4_encrypt_data(key, 32, plain, crypt, 32, 0);
+	check("RC4 256 bit offset 0", crypt, 32, "eaa6bd25880bf93d3f5d1e4ca2611d91cfa45c9f7e714b54bdfa80027cb14380");
+	group_end("RC4");
+
+	group_begin();
+	context = cipher_create(CRYPTO_CIPHER_ALG_DES, "abcdefgh", "12345678", DES_KEY_SIZE);
+	cipher_encrypt(context, message, crypt, 32);
+	check("DES CBC encrypt", crypt, 32, "6ca9470c849d1cc1a59ffc148f1cb5e9cf1f5c0328a7e8756387ff4d0fe46050");
+	cipher_destroy(context);
+	context = cipher_create(CRYPTO_CIPHER_ALG_DES, "abcdefgh", "12345678", DES_KEY_SIZE);
+	cipher_decrypt(context, crypt, result, 32);
+	check_bool("DES CBC decrypt incorrect", memcmp(result, message, 32) == 0);
+	cipher_destroy(context);
+
+	memset(key, 0, DES_KEY_SIZE);
+	memset(plain, 0, DES_BLOCK_SIZE);
+	des_key_setup(key, DES_KEY_SIZE, &encryptkey, &decryptkey);
+	des_encrypt_block(plain, crypt, &encryptkey);
+	check("DES zero key", crypt, DES_BLOCK_SIZE, "8ca64de9c1b123a7");
+	des_decrypt_block(crypt, result, &decryptkey);
+	check_bool("DES zero key decrypt incorrect", memcmp(result, plain, DES_BLOCK_SIZE) == 0);
+
+	memset(key, 0xFF, DES_KEY_SIZE);
+	memset(plain, 0xFF, DES_BLOCK_SIZE);
+	des_key_setup(key, DES_KEY_SIZE, &encryptkey, &decryptkey);
+	des_encrypt_block(plain, crypt, &encryptkey);
+	check("DES ones key", crypt, DES_BLOCK_SIZE, "7359b2163e4edc58");
+
+	context = cipher_create(CRYPTO_CIPHER_ALG_3DES, "abcdefgh", "12345678abcdefghstuvwxyz", DES3_KEY_SIZE);
+	cipher_encrypt(context, message, crypt, 32);
+	check("3DES CBC encrypt", crypt, 32, "61b0cefb60b56d1885fcf647d7ebf44c9031b2f2c2c06018f5871bd6278919f7");
+	cipher_destroy(context);
+	context = cipher_create(CRYPTO_CIPHER_ALG_3DES, "abcdefgh", "12345678abcdefghstuvwxyz", DES3_KEY_SIZE);
+	cipher_decrypt(context, crypt, result, 32);
+	check_bool("3DES CBC decrypt incorrect", memcmp(result, message, 32) == 0);
+	cipher_destroy(context);
+	group_end("DES");
+
+	/* AES from FIPS 197 and SP 800-38A */
+	group_begin();
+	hex_to_bytes("6bc1bee22e409f96e93d7e117393172a", plain);
+	hex_to_bytes("2b7e151628aed2a6abf7158809cf4f3c", key);
+	aes_key_setup(key, AES_KEY_SIZE128, &aeskey);
+	aes_encrypt_block(plain, crypt, &aeskey);
+	check("AES128 encrypt", crypt, AES_BLOCK_SIZE, "3ad77bb40d7a3660a89ecaf32466ef97");
+	aes_decrypt_block(crypt, result, &aeskey);
+	check("AES128 decrypt", result, AES_BLOCK_SIZE, "6bc1bee22e409f96e93d7e117393172a");
+
+	hex_to_bytes("8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b", key);
+	aes_key_setup(key, AES_KEY_SIZE192, &aeskey);
+	aes_encrypt_block(plain, crypt, &aeskey);
+	check("AES192 encrypt", crypt, AES_BLOCK_SIZE, "bd334f1d6e45f25ff712a214571fa5cc");
+	aes_decrypt_block(crypt, result, &aeskey);
+	check("AES192 decrypt", result, AES_BLOCK_SIZE, "6bc1bee22e409f96e93d7e117393172a");
+
+	hex_to_bytes("603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4", key);
+	aes_key_setup(key, AES_KEY_SIZE256, &aeskey);
+	aes_encrypt_block(plain, crypt, &aeskey);
+	check("AES256 encrypt", crypt, AES_BLOCK_SIZE, "f3eed1bdb5d2a03c064b5a7e3db181f8");
+	aes_decrypt_block(crypt, result, &aeskey);
+	check("AES256 decrypt", result, AES_BLOCK_SIZE, "6bc1bee22e409f96e93d7e117393172a");
+
+	hex_to_bytes("2b7e151628aed2a6abf7158809cf4f3c", key);
+	hex_to_bytes("000102030405060708090a0b0c0d0e0f", vector);
+	context = cipher_create(CRYPTO_CIPHER_ALG_AES, vector, key, AES_KEY_SIZE128);
+	cipher_encrypt(context, plain, crypt, AES_BLOCK_SIZE);
+	check("AES128 CBC encrypt", crypt, AES_BLOCK_SIZE, "7649abac8119b246cee98e9b12e9197d");
+	cipher_destroy(context);
+	context = cipher_create(CRYPTO_CIPHER_ALG_AES, vector, key, AES_KEY_SIZE128);
+	cipher_decrypt(context, crypt, result, AES_BLOCK_SIZE);
+	check("AES128 CBC decrypt", result, AES_BLOCK_SIZE, "6bc1bee22e409f96e93d7e117393172a");
+	cipher_destroy(context);
+
+	hex_to_bytes("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff", vector);
+	aes_ctr_encrypt_data(key, AES_KEY_SIZE128, vector, plain, crypt, AES_BLOCK_SIZE);
+	check("AES128 CTR encrypt", crypt, AES_BLOCK_SIZE, "874d6191b620e3261bef6864990db6ce");
+	aes_ctr_decrypt_data(key, AES_KEY_SIZE128, vector, crypt, result, AES_BLOCK_SIZE);
+	check("AES128 CTR decrypt", result, AES_BLOCK_SIZE, "6bc1bee22e409f96e93d7e117393172a");
+	group_end("AES");
+}
+
+/* AES GCM chained vectors from LibTomCrypt (The tag of each test is the key of the next) */
+static void test_gcm(void)
+{
+	static const char *expected[32][2] = {
+		{"3A", "03C32E0E9D7E07A410B9BEE40A8F0D26"},
+		{"26AE", "3A635BBDC1A17CA40B58CEEA78105CDC"},
+		{"142FAC", "7E8922E8FA6F1E41E4339F0B52176DE4"},
+		{"20C1863F", "A1D12620C22EA7A0AA0E74667A20B8E1"},
+		{"B3B796AA54", "53F0F9F03791BBD76BC99D1B5639F3C0"},
+		{"FDCFF8EA82D8", "B56076B42E3EEAC73DD42FC83B9220F9"},
+		{"4695E719E67849", "B4A1A2E29AAD713D5677CF425E65A400"},
+		{"EE5BA3309D417697", "146EA95CED151F8C40DF98C1CC54930B"},
+		{"13FF05ABB084FA608F", "55550AADC3461CC190CA22F29C6246CD"},
+		{"008B0102208A22D3A562", "7178534BC7145754BAE525CC06E14A6B"},
+		{"3536DBBB07B026E78E94C8", "AB27183AEA2240B0166D702EEB2A7BFA"},
+		{"00739D5A27AE82AC7D6A40EC", "4354578C3D241074D3C1F6496420F239"},
+		{"DA41A5F458400C94B84026C052", "DC6CB036FCAE9765A69F5B8C38B0B767"},
+		{"4C99797C7EDCEA9D5425565522E2", "3FFEEC557F0D5FA73472D2A3F8E71389"},
+		{"D381E7AD2E5BE2C97FB4BD958BC2EB", "6BF713D4E7DA7C4290967A1D23F97EDD"},
+		{"5016C127F16A4787734AF3A3E6F6F0F7", "8CD8458531E94BC8160E2176F63F8D0B"},
+		{"BDF3D0F24D9415AB5CF9B87BB45B4A8AE4", "D81A3D56451313742ACE53D41223F6AF"},
+		{"68C1FCBE22FBDB296C246F2E34D871A6902E", "7AFD64D4EB0DE7E2A842B518AC6D483F"},
+		{"7D8D3C31E643611B0B557F29B437F635FE3FD0", "8501B61DBF4A4DD19B87E95055B95962"},
+		{"4185EEB0B9B480F69B3EC7A162810073A36AD95A", "B9BCA6D9CA0AC2B4B35D7BFF4DB27D25"},
+		{"F991F4A481E322FEEC6FE9302D010AC4C811B23B4A", "54FA4DDA92E57509F4D48D206A03624F"},
+		{"B288424FF96596B2A30A1EB9480F5EADC2F6D8551B9A", "2C998C8DFDC7663C8DE677B2F1CBCB57"},
+		{"1066FE3DCB9F8AE0DC0693F7179F111E0A7A1FFE944FF4", "65402D1F8AFBDC819D6D1ADB5375AFD0"},
+		{"0A8772CCDE122EFF01D7C187C77F07BDA50997B4320CD0D8", "F55823AFC3D9FE6E749E70E82C823925"},
+		{"E6E2FBB3E2238BC8CB396F463C2F488B4B4933087728D39815", "F06DA35A9AEE65F9AD0DAD5B99AB4DF6"},
+		{"569BD39CB1693CB89B88923ABE0D8CFA0B4F22A48A15E2EACD4A", "661AF51FF0E0E363406AB278BFC9176D"},
+		{"199EED81C2428170EB089060FF9676596EADD2270895A0C8650903", "90AA9C634469D45E7BDD9AB955B90130"},
+		{"B5200497A0654009B9F5B0D45FFDCF192F3042D6B05C6D6A8191A7EA", "71F6C4982AA50705D5FFC60512FC674C"},
+		{"E39DA262C0E851B5CB5BD55A8B19D0AC0ABDC6FF3F32DF3B1896242D9E", "B58AA05F594FC9779E185353CC52B8FB"},
+		{"AF349B91BAD4BE2F2D5E4DDE28A1AA74115A9059A5EBBF9E38F341DC368B", "966B04FE43A2A9D94004E756F7DBFEFA"},
+		{"8C87861DFFDE72FA64E926BF741330F64E2B30837650F309A3F979AE43BA2E", "A5C825AE1B844D6A8D531077C881BD36"},
+		{"924E178A17FA1CA0E7486F0404123B91DBF797BB9DBDE9B1D48D5C7F53165912", "10F972B6F9E0A3C1CF9CCF56543DCA79"}};
+	uint8_t key[AES_KEY_SIZE128];
+	uint8_t data[32];
+	uint8_t crypt[32];
+	uint8_t result[32];
+	uint8_t tag[AES_GCM_TAG_SIZE];
+	uint32_t count;
+	char name[32];
+
+	group_begin();
+
+	for (count = 0; count < 16; count++)
+		key[count] = count;
+	for (count = 0; count < 32; count++)
+		data[count] = count;
+
+	/* IV, additional data and plain text are all the first count bytes of data */
+	for (count = 1; count <= 32; count++)
+	{
+		snprintf(name, sizeof(name), "AES GCM %u", (unsigned int)count);
+
+		aes_gcm_encrypt_data(key, AES_KEY_SIZE128, data, data, data, crypt, count, count, count, tag);
+		check(name, crypt, count, expected[count - 1][0]);
+		check(name, tag, AES_GCM_TAG_SIZE, expected[count - 1][1]);
+
+		check_bool("AES GCM decrypt incorrect", aes_gcm_decrypt_data(key, AES_KEY_SIZE128, data, data, crypt, result, count, count, count, tag) && memcmp(result, data, count) == 0);
+
+		memcpy(key, tag, AES_KEY_SIZE128);
+	}
+
+	/* A modified tag must be rejected */
+	tag[0] ^= 1;
+	check_bool("AES GCM bad tag accepted", !aes_gcm_decrypt_data(key, AES_KEY_SIZE128, data, data, crypt, result, 32, 32, 32, tag));
+
+	group_end("AES GCM");
+}
+
+/* Run the self test with the given features, returns TRUE if every vector was correct */
+static BOOL self_test(uint32_t features)
+{
+	char text[128];
+	char names[64];
+
+	crypto_set_features(features);
+	crypto_features_to_string(crypto_get_features(), names, sizeof(names));
+
+	snprintf(text, sizeof(text), "Self test with features: %s", names);
+	console_window_write_ln(window, text);
+
+	total_passed = 0;
+	total_count = 0;
+
+	test_hashes();
+	test_ciphers();
+	test_gcm();
+
+	snprintf(text, sizeof(text), "Total %u of %u correct", (unsigned int)total_passed, (unsigned int)total_count);
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	return (total_passed == total_count);
+}
+
+/* ============================================================================== */
+/* Throughput benchmarks */
+static uint32_t STDCALL test_setup(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, void **data)
+{
+	const TEST_PARAMETER *parameter = (const TEST_PARAMETER *)benchmark->parameter;
+	TEST_DATA *test;
+
+	test = calloc(1, sizeof(TEST_DATA));
+	if (!test)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	test->parameter = parameter;
+	test->source = malloc(BUFFER_SIZE);
+	test->dest = malloc(BUFFER_SIZE);
+	if (!test->source || !test->dest)
+	{
+		free(test->source);
+		free(test->dest);
+		free(test);
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
+	memset(test->source, 0x5A, BUFFER_SIZE);
+	memset(test->dest, 0, BUFFER_SIZE);
+
+	/* Select the accelerated or C path for this test */
+	crypto_set_features(parameter->features);
+
+	switch (parameter->kind)
+	{
+		case TEST_HMAC_SHA256:
+			test->hash = hash_create(CRYPTO_HASH_ALG_HMAC_SHA256, test_key, 32);
+			break;
+		case TEST_AES128_ECB:
+		case TEST_AES128_CBC_ENCRYPT:
+		case TEST_AES128_CBC_DECRYPT:
+			aes_key_setup(test_key, AES_KEY_SIZE128, &test->aeskey);
+			break;
+		case TEST_AES128_CTR:
+			aes_ctr_init(&test->ctr, test_key, AES_KEY_SIZE128, test->vector);
+			break;
+		case TEST_AES256_CTR:
+			aes_ctr_init(&test->ctr, test_key, AES_KEY_SIZE256, test->vector);
+			break;
+		case TEST_DES_CBC:
+			test->cipher = cipher_create(CRYPTO_CIPHER_ALG_DES, test->vector, test_key, DES_KEY_SIZE);
+			break;
+		case TEST_3DES_CBC:
+			test->cipher = cipher_create(CRYPTO_CIPHER_ALG_3DES, test->vector, test_key, DES3_KEY_SIZE);
+			break;
+		case TEST_RC4:
+			rc4_init(&test->rc4, test_key, 16);
+			break;
+	}
+
+	*data = test;
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL test_run(void *data, uint32_t iterations)
+{
+	TEST_DATA *test = (TEST_DATA *)data;
+	uint8_t digest[SHA512_DIGEST_SIZE];
+	MD5_CONTEXT md5;
+	SHA1_CONTEXT sha1;
+	SHA256_CONTEXT sha256;
+	SHA512_CONTEXT sha512;
+	uint32_t count;
+
+	for (count = 0; count < iterations; count++)
+	{
+		switch (test->parameter->kind)
+		{
+			case TEST_MD5:
+				md5_init(&md5);
+				md5_update(&md5, test->source, BUFFER_SIZE);
+				md5_final(&md5, digest);
+				break;
+			case TEST_SHA1:
+				sha1_init(&sha1);
+				sha1_update(&sha1, test->source, BUFFER_SIZE);
+				sha1_final(&sha1, digest);
+				break;
+			case TEST_SHA256:
+				sha256_init(&sha256);
+				sha256_update(&sha256, test->source, BUFFER_SIZE);
+				sha256_final(&sha256, digest);
+				break;
+			case TEST_SHA512:
+				sha512_init(&sha512);
+				sha512_update(&sha512, test->source, BUFFER_SIZE);
+				sha512_final(&sha512, digest);
+				break;
+			case TEST_HMAC_SHA256:
+				hash_update(test->hash, test->source, BUFFER_SIZE);
+				hash_finish(test->hash, digest, sizeof(digest));
+				break;
+			case TEST_CRC32:
+				test->crc = crc32_update(0, test->source, BUFFER_SIZE);
+				break;
+			case TEST_CRC32C:
+				test->crc = crc32c_update(0, test->source, BUFFER_SIZE);
+				break;
+			case TEST_AES128_ECB:
+				aes_ecb_encrypt(&test->aeskey, test->source, test->dest, BUFFER_SIZE);
+				break;
+			case TEST_AES128_CBC_ENCRYPT:
+				aes_cbc_encrypt(&test->aeskey, test->vector, test->source, test->dest, BUFFER_SIZE);
+				break;
+			case TEST_AES128_CBC_DECRYPT:
+				aes_cbc_decrypt(&test->aeskey, test->vector, test->source, test->dest, BUFFER_SIZE);
+				break;
+			case TEST_AES128_CTR:
+			case TEST_AES256_CTR:
+				aes_ctr_update(&test->ctr, test->source, test->dest, BUFFER_SIZE);
+				break;
+			case TEST_AES128_GCM:
+				aes_gcm_encrypt_data(test_key, AES_KEY_SIZE128, test->vector, NULL, test->source, test->dest, AES_GCM_IV_SIZE, 0, BUFFER_SIZE, test->tag);
+				break;
+			case TEST_DES_CBC:
+			case TEST_3DES_CBC:
+				cipher_encrypt(test->cipher, test->source, test->dest, BUFFER_SIZE);
+				break;
+			case TEST_RC4:
+				rc4_update(&test->rc4, test->source, test->dest, BUFFER_SIZE);
+				break;
+		}
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static void STDCALL test_teardown(void *data)
+{
+	TEST_DATA *test = (TEST_DATA *)data;
+
+	if (test->hash)
+		hash_destroy(test->hash);
+	if (test->cipher)
+		cipher_destroy(test->cipher);
+
+	free(test->source);
+	free(test->dest);
+	free(test);
+}
+
+static void add_test(uint32_t *count, uint32_t kind, uint32_t features, BOOL portable)
+{
+	TEST_PARAMETER *parameter = &parameters[*count];
+	BENCHMARK *test = &tests[*count];
+
+	parameter->kind = kind;
+	parameter->features = features;
+
+	snprintf(names[*count], BENCHMARK_NAME_LENGTH, "%s%s", test_names[kind], portable ? "_c" : "");
+
+	test->name = names[*count];
+	test->group = BENCHMARK_GROUP_USER;
+	test->iterations = 0;
+	test->setup = test_setup;
+	test->run = test_run;
+	test->teardown = test_teardown;
+	test->parameter = parameter;
+
+	(*count)++;
+}
+
+int apimain(int argc, char **argv)
+{
+	BENCHMARK_CONFIG config;
+	uint32_t available;
+	uint32_t status;
+	uint32_t count;
+	uint32_t index;
+	char features[64];
+	char text[256];
+
+	/* Create a console window for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "Crypto Benchmark advanced example");
+	console_window_write_ln(window, "");
+
+	/* Wait for the system to settle and drive C:\ to become available */
+	sleep(5);
+
+	available = crypto_get_available();
+	crypto_features_to_string(available, features, sizeof(features));
+
+	snprintf(text, sizeof(text), "Board type %u, %u CPUs, crypto instructions: %s", (unsigned int)board_get_type(), (unsigned int)cpu_get_count(), features);
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	/* Check the C path and (If different) the accelerated path against the known answers */
+	if (!self_test(CRYPTO_FEATURE_NONE) || (available != CRYPTO_FEATURE_NONE && !self_test(available)))
+	{
+		console_window_write_ln(window, "Self test failed, benchmarks not run");
+		thread_halt(0);
+	}
+
+	/* Each kind with everything available, then with the C path if the kind can be accelerated */
+	count = 0;
+	for (index = 0; index < TEST_KIND_COUNT; index++)
+	{
+		add_test(&count, index, available, FALSE);
+
+		if ((available & test_features[index]) != 0)
+			add_test(&count, index, CRYPTO_FEATURE_NONE, TRUE);
+	}
+
+	/* Defaults for everything except the CPU and the number of repeats */
+	memset(&config, 0, sizeof(BENCHMARK_CONFIG));
+	config.cpu = CPU_ID_0;
+	config.repeats = 10;
+
+	console_window_write_ln(window, "Running, this may take a minute");
+	console_window_write_ln(window, "");
+
+	status = benchmark_run_list(tests, count, &config, results);
+	crypto_set_features(available);
+	if (status != ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), "Benchmark failed (Status %u)", (unsigned int)status);
+		console_window_write_ln(window, text);
+		thread_halt(0);
+	}
+
+	for (index = 0; index < count; index++)
+	{
+		if (results[index].status != ERROR_SUCCESS)
+			snprintf(text, sizeof(text), "%-24s failed (Status %u)", results[index].name, (unsigned int)results[index].status);
+		else
+			snprintf(text, sizeof(text), "%-24s %10.1f MB/s", results[index].name, (BUFFER_SIZE * 1000.0) / results[index].median);
+
+		console_window_write_ln(window, text);
+	}
+	console_window_write_ln(window, "");
+
+	if (benchmark_export_file(results, count, RESULTS_FILE) == ERROR_SUCCESS)
+		console_window_write_ln(window, "Results written to " RESULTS_FILE);
+
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
@@ -36,6 +36,7 @@
 #include "ultibo/platform.h"
 #include "ultibo/threads.h"
 #include "ultibo/console.h"
+#include "ultibo/bootstage.h"
 
 volatile uint32_t counter;
 WINDOW_HANDLE right_window;
@@ -56,11 +57,14 @@ void start_dedicated_thread(WINDOW_HANDLE handle)
     THREAD_SNAPSHOT *thread_snapshot;
 
     /* Because parts of Ultibo core like the file system and network start in asynchronous mode
-     * we'll stop here for a second just to make sure they are done. You've seen in other examples
-     * how to wait for the network to have a valid IP and how to wait for drive C:\ to be ready, 
-     * to keep this example simple we'll just sleep for three seconds which should be enough for now
+     * we'll stop here just to make sure they are done. The boot stages for the file system and
+     * network are completed as soon as each of them has started, so we wait for both of them
+     * instead of sleeping for a fixed time. A board without networking would otherwise wait for
+     * the network stage to fail, so we give it no more than the three seconds we used to sleep
+     * and carry on either way since this example doesn't need the network
      */
-    thread_sleep(3000);
+    boot_stage_wait_name(BOOT_STAGE_FILESYSTEM, INFINITE);
+    boot_stage_wait_name(BOOT_STAGE_NETWORK, 3000);
 
     /* Create another console window so we can track the progress of our thread later */
     right_window = console_window_create(console_device_get_default(), CONSOLE_POSITION_RIGHT, FALSE);
@@ -0,0 +1,470 @@
+/*
+ *
+ * Device Tree Index advanced example project for Ultibo API
+ *
+ * Indexes the boot device tree and compares lookups by path, phandle, compatible
+ * string and property name with the linear device tree functions, then measures
+ * the time to build the index for each Raspberry Pi device tree file on the SD card.
+ *
+ * The firmware passes the device tree for the board to Ultibo unless config.txt
+ * contains device_tree= and the .dtb files are normally present in the root
+ * directory of the SD card alongside the firmware.
+ *
+ * The same lookups can be checked, timed and fuzzed on the development host with
+ * src/devicetree/devicetreeindextest.c (See the comment at the top of that file).
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/devicetree.h"
+#include "ultibo/benchmark.h"
+
+/* File for the JSON results */
+#define RESULTS_FILE "C:\\devicetreeindex.json"
+
+/* Maximum number of nodes and compatible strings used by the lookup tests */
+#define MAX_NODES 4096
+#define MAX_COMPATIBLES 512
+
+/* Maximum size of a device tree file loaded from the SD card */
+#define MAX_FILE_SIZE SIZE_1M
+
+/* Test kinds */
+#define TEST_PATH_LINEAR 0
+#define TEST_PATH_INDEX 1
+#define TEST_PHANDLE_LINEAR 2
+#define TEST_PHANDLE_INDEX 3
+#define TEST_COMPATIBLE_LINEAR 4
+#define TEST_COMPATIBLE_INDEX 5
+#define TEST_PROPERTY_LINEAR 6
+#define TEST_PROPERTY_INDEX 7
+#define TEST_CREATE 8
+
+#define TEST_LOOKUP_COUNT 8
+
+/* Device tree files supplied with the Raspberry Pi firmware */
+static const char *dtb_files[] = {"bcm2708-rpi-b-plus.dtb", "bcm2708-rpi-zero-w.dtb", "bcm2709-rpi-2-b.dtb", "bcm2710-rpi-3-b.dtb", "bcm2710-rpi-3-b-plus.dtb", "bcm2710-rpi-zero-2-w.dtb", "bcm2711-rpi-4-b.dtb", "bcm2711-rpi-400.dtb", "bcm2712-rpi-5-b.dtb"};
+
+#define DTB_FILE_COUNT (sizeof(dtb_files) / sizeof(dtb_files[0]))
+
+static const char *test_names[] = {"path_linear", "path_index", "phandle_linear", "phandle_index", "compatible_linear", "compatible_index", "property_linear", "property_index"};
+
+/* Test parameters, one per benchmark */
+typedef struct
+{
+	uint32_t kind;
+	const void *blob; // Device tree to index (TEST_CREATE only)
+	uint32_t size;
+} TEST_PARAMETER;
+
+/* Test data, allocated by setup */
+typedef struct
+{
+	const TEST_PARAMETER *parameter;
+	uint32_t next; // Next entry to look up, each iteration moves to the next node or string
+	volatile HANDLE result;
+} TEST_DATA;
+
+/* Nodes of the boot device tree, collected from the index */
+static char *node_paths[MAX_NODES];
+static HANDLE node_handles[MAX_NODES];
+static uint32_t node_count;
+
+static uint32_t phandles[MAX_NODES];
+static uint32_t phandle_count;
+
+static const char *compatibles[MAX_COMPATIBLES];
+static uint32_t compatible_count;
+
+static TEST_PARAMETER parameters[TEST_LOOKUP_COUNT + DTB_FILE_COUNT];
+static char names[TEST_LOOKUP_COUNT + DTB_FILE_COUNT][BENCHMARK_NAME_LENGTH];
+static BENCHMARK tests[TEST_LOOKUP_COUNT + DTB_FILE_COUNT];
+static BENCHMARK_RESULT results[TEST_LOOKUP_COUNT + DTB_FILE_COUNT];
+
+static WINDOW_HANDLE window;
+
+/* ============================================================================== */
+/* Linear lookups using the device tree functions, as callers without an index do them */
+static HANDLE linear_find_phandle(uint32_t phandle)
+{
+	HANDLE node = INVALID_HANDLE_VALUE;
+	HANDLE property;
+
+	while ((node = device_tree_next_node(INVALID_HANDLE_VALUE, node)) != INVALID_HANDLE_VALUE)
+	{
+		property = device_tree_get_property(node, DTB_PROPERTY_PHANDLE);
+		if (property != INVALID_HANDLE_VALUE && device_tree_get_property_length(property) == 4 && device_tree_get_property_longword(property) == phandle)
+			return node;
+	}
+
+	return INVALID_HANDLE_VALUE;
+}
+
+static HANDLE linear_find_compatible(const char *compatible)
+{
+	HANDLE node = INVALID_HANDLE_VALUE;
+	HANDLE property;
+	const char *value;
+	uint32_t length;
+	uint32_t offset;
+
+	while ((node = device_tree_next_node(INVALID_HANDLE_VALUE, node)) != INVALID_HANDLE_VALUE)
+	{
+		property = device_tree_get_property(node, DTB_PROPERTY_COMPATIBLE);
+		if (property == INVALID_HANDLE_VALUE)
+			continue;
+
+		value = device_tree_get_property_value(property);
+		length = device_tree_get_property_length(property);
+		for (offset = 0; offset < length; offset += strnlen(value + offset, length - offset) + 1)
+		{
+			if (strncmp(value + offset, compatible, length - offset) == 0)
+				return node;
+		}
+	}
+
+	return INVALID_HANDLE_VALUE;
+}
+
+/* ============================================================================== */
+/* Collect the paths, phandles and compatible strings of the boot device tree from the index */
+static BOOL collect_nodes(void)
+{
+	HANDLE node = INVALID_HANDLE_VALUE;
+	HANDLE property;
+	char path[DEVICE_TREE_INDEX_MAX_PATH];
+	const char *compatible;
+	uint32_t count;
+	uint32_t entry;
+
+	while ((node = device_tree_index_next_node(NULL, node)) != INVALID_HANDLE_VALUE && node_count < MAX_NODES)
+	{
+		if (device_tree_index_get_node_path(NULL, node, path, sizeof(path)) == 0)
+			continue;
+
+		node_paths[node_count] = strdup(path);
+		node_handles[node_count] = node;
+		if (!node_paths[node_count])
+			return FALSE;
+		node_count++;
+
+		property = device_tree_index_find_property(NULL, node, DTB_PROPERTY_PHANDLE);
+		if (property != INVALID_HANDLE_VALUE)
+			phandles[phandle_count++] = device_tree_get_property_longword(property);
+
+		/* The first string of each compatible property, once each */
+		property = device_tree_index_find_property(NULL, node, DTB_PROPERTY_COMPATIBLE);
+		if (property != INVALID_HANDLE_VALUE && compatible_count < MAX_COMPATIBLES)
+		{
+			compatible = device_tree_index_get_property_value(NULL, property, NULL);
+			if (device_tree_index_find_compatible(NULL, compatible, 0) == node)
+				compatibles[compatible_count++] = compatible;
+		}
+	}
+
+	/* Check that the index agrees with the device tree functions */
+	count = 0;
+	for (entry = 0; entry < node_count; entry++)
+	{
+		if (device_tree_get_node(node_paths[entry], INVALID_HANDLE_VALUE) == node_handles[entry])
+			count++;
+	}
+
+	snprintf(path, sizeof(path), "Paths matching device_tree_get_node: %u of %u", (unsigned int)count, (unsigned int)node_count);
+	console_window_write_ln(window, path);
+
+	count = 0;
+	for (entry = 0; entry < phandle_count; entry++)
+	{
+		if (linear_find_phandle(phandles[entry]) == device_tree_index_find_phandle(NULL, phandles[entry]))
+			count++;
+	}
+
+	snprintf(path, sizeof(path), "Phandles matching linear search: %u of %u", (unsigned int)count, (unsigned int)phandle_count);
+	console_window_write_ln(window, path);
+
+	return (node_count > 0);
+}
+
+/* ============================================================================== */
+/* Benchmarks */
+static uint32_t STDCALL test_setup(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, void **data)
+{
+	const TEST_PARAMETER *parameter = (const TEST_PARAMETER *)benchmark->parameter;
+	TEST_DATA *test;
+
+	if ((parameter->kind == TEST_PHANDLE_LINEAR || parameter->kind == TEST_PHANDLE_INDEX) && phandle_count == 0)
+		return ERROR_NOT_SUPPORTED;
+	if ((parameter->kind == TEST_COMPATIBLE_LINEAR || parameter->kind == TEST_COMPATIBLE_INDEX) && compatible_count == 0)
+		return ERROR_NOT_SUPPORTED;
+
+	test = calloc(1, sizeof(TEST_DATA));
+	if (!test)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	test->parameter = parameter;
+
+	*data = test;
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL test_run(void *data, uint32_t iterations)
+{
+	TEST_DATA *test = (TEST_DATA *)data;
+	DEVICE_TREE_INDEX *index;
+	uint32_t count;
+	uint32_t next;
+
+	for (count = 0; count < iterations; count++)
+	{
+		next = test->next++;
+
+		switch (test->parameter->kind)
+		{
+			case TEST_PATH_LINEAR:
+				test->result = device_tree_get_node(node_paths[next % node_count], INVALID_HANDLE_VALUE);
+				break;
+			case TEST_PATH_INDEX:
+				test->result = device_tree_index_find_node(NULL, node_paths[next % node_count]);
+				break;
+			case TEST_PHANDLE_LINEAR:
+				test->result = linear_find_phandle(phandles[next % phandle_count]);
+				break;
+			case TEST_PHANDLE_INDEX:
+				test->result = device_tree_index_find_phandle(NULL, phandles[next % phandle_count]);
+				break;
+			case TEST_COMPATIBLE_LINEAR:
+				test->result = linear_find_compatible(compatibles[next % compatible_count]);
+				break;
+			case TEST_COMPATIBLE_INDEX:
+				test->result = device_tree_index_find_compatible(NULL, compatibles[next % compatible_count], 0);
+				break;
+			case TEST_PROPERTY_LINEAR:
+				test->result = device_tree_get_property(node_handles[next % node_count], DTB_PROPERTY_STATUS);
+				break;
+			case TEST_PROPERTY_INDEX:
+				test->result = device_tree_index_find_property(NULL, node_handles[next % node_count], DTB_PROPERTY_STATUS);
+				break;
+			case TEST_CREATE:
+				index = device_tree_index_create(test->parameter->blob, test->parameter->size);
+				if (!index)
+					return ERROR_INVALID_DATA;
+				device_tree_index_destroy(index);
+				break;
+		}
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static void STDCALL test_teardown(void *data)
+{
+	free(data);
+}
+
+static void add_test(uint32_t *count, const char *name, uint32_t kind, const void *blob, uint32_t size)
+{
+	TEST_PARAMETER *parameter = &parameters[*count];
+	BENCHMARK *test = &tests[*count];
+
+	parameter->kind = kind;
+	parameter->blob = blob;
+	parameter->size = size;
+
+	snprintf(names[*count], BENCHMARK_NAME_LENGTH, "%s", name);
+
+	test->name = names[*count];
+	test->group = BENCHMARK_GROUP_USER;
+	test->iterations = 0;
+	test->setup = test_setup;
+	test->run = test_run;
+	test->teardown = test_teardown;
+	test->parameter = parameter;
+
+	(*count)++;
+}
+
+/* Load a device tree file from the SD card and show the size of its index */
+static void *load_file(const char *name, uint32_t *size)
+{
+	DEVICE_TREE_INDEX *index;
+	DEVICE_TREE_INDEX_INFO info;
+	char filename[64];
+	char text[256];
+	void *blob;
+	FILE *file;
+	long length;
+
+	snprintf(filename, sizeof(filename), "C:\\%s", name);
+	file = fopen(filename, "rb");
+	if (!file)
+		return NULL;
+
+	blob = NULL;
+	if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) > 0 && length <= MAX_FILE_SIZE)
+	{
+		rewind(file);
+		blob = malloc(length);
+		if (blob && fread(blob, 1, length, file) != (size_t)length)
+		{
+			free(blob);
+			blob = NULL;
+		}
+	}
+	fclose(file);
+
+	if (!blob)
+		return NULL;
+
+	index = device_tree_index_create(blob, length);
+	if (!index)
+	{
+		snprintf(text, sizeof(text), "%s is not a valid device tree", name);
+		console_window_write_ln(window, text);
+		free(blob);
+		return NULL;
+	}
+
+	device_tree_index_get_info(index, &info);
+	snprintf(text, sizeof(text), "%-26s %6ld bytes, %4u nodes, %5u properties, index %6u bytes", name, length, (unsigned int)info.nodecount, (unsigned int)info.propertycount, (unsigned int)info.size);
+	console_window_write_ln(window, text);
+	device_tree_index_destroy(index);
+
+	*size = length;
+
+	return blob;
+}
+
+int apimain(int argc, char **argv)
+{
+	BENCHMARK_CONFIG config;
+	DEVICE_TREE_INDEX_INFO info;
+	uint32_t status;
+	uint32_t count;
+	uint32_t index;
+	uint32_t size;
+	void *blob;
+	char text[256];
+
+	/* Create a console window for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "Device Tree Index advanced example");
+	console_window_write_ln(window, "");
+
+	/* Wait for the system to settle and drive C:\ to become available */
+	sleep(5);
+
+	if (device_tree_index_get_info(NULL, &info) != ERROR_SUCCESS)
+	{
+		console_window_write_ln(window, "No valid boot device tree, check the device_tree= setting in config.txt");
+		thread_halt(0);
+	}
+
+	snprintf(text, sizeof(text), "Boot device tree: %u bytes, %u nodes, %u properties, %u names, %u compatible strings, %u phandles",
+		(unsigned int)device_tree_get_size(), (unsigned int)info.nodecount, (unsigned int)info.propertycount, (unsigned int)info.namecount, (unsigned int)info.compatiblecount, (unsigned int)info.phandlecount);
+	console_window_write_ln(window, text);
+	snprintf(text, sizeof(text), "Index size: %u bytes", (unsigned int)info.size);
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	if (!collect_nodes())
+	{
+		console_window_write_ln(window, "Failed to collect nodes");
+		thread_halt(0);
+	}
+	console_window_write_ln(window, "");
+
+	/* Lookups in the boot device tree, then building the index of each file found */
+	count = 0;
+	for (index = 0; index < TEST_LOOKUP_COUNT; index++)
+		add_test(&count, test_names[index], index, NULL, 0);
+
+	add_test(&count, "create_boot", TEST_CREATE, (const void *)device_tree_get_base(), device_tree_get_size());
+
+	for (index = 0; index < DTB_FILE_COUNT && count < TEST_LOOKUP_COUNT + DTB_FILE_COUNT; index++)
+	{
+		blob = load_file(dtb_files[index], &size);
+		if (blob)
+		{
+			snprintf(text, sizeof(text), "create_%s", dtb_files[index]);
+			add_test(&count, text, TEST_CREATE, blob, size);
+		}
+	}
+	console_window_write_ln(window, "");
+
+	/* Defaults for everything except the CPU and the number of repeats */
+	memset(&config, 0, sizeof(BENCHMARK_CONFIG));
+	config.cpu = CPU_ID_0;
+	config.repeats = 10;
+
+	console_window_write_ln(window, "Running, this may take a minute");
+	console_window_write_ln(window, "");
+
+	status = benchmark_run_list(tests, count, &config, results);
+	if (status != ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), "Benchmark failed (Status %u)", (unsigned int)status);
+		console_window_write_ln(window, text);
+		thread_halt(0);
+	}
+
+	/* Lookups are shown per call, index builds per tree */
+	for (index = 0; index < count; index++)
+	{
+		if (results[index].status == ERROR_NOT_SUPPORTED)
+			snprintf(text, sizeof(text), "%-36s skipped", results[index].name);
+		else if (results[index].status != ERROR_SUCCESS)
+			snprintf(text, sizeof(text), "%-36s failed (Status %u)", results[index].name, (unsigned int)results[index].status);
+		else if (parameters[index].kind == TEST_CREATE)
+			snprintf(text, sizeof(text), "%-36s %10.1f us", results[index].name, results[index].median / 1000.0);
+		else
+			snprintf(text, sizeof(text), "%-36s %10.0f ns", results[index].name, results[index].median);
+
+		console_window_write_ln(window, text);
+	}
+	console_window_write_ln(window, "");
+
+	if (benchmark_export_file(results, count, RESULTS_FILE) == ERROR_SUCCESS)
+		console_window_write_ln(window, "Results written to " RESULTS_FILE);
+
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
@@ -0,0 +1,214 @@
+/*
+ *
+ * DMA Scroll advanced example project for Ultibo API
+ *
+ * This example measures the rate of scrolling a console window and the CPU
+ * usage while scrolling, first with CPU copies and then with the DMA copy
+ * (src/framebuffer/framebufferdma.c) attached to the framebuffer device.
+ *
+ * It then times framebuffer_device_copy_rect for a range of region sizes using
+ * the CPU and DMA to show where the DMA threshold should be set for the board.
+ *
+ * The test runs on CPU 1 (where available) so the CPU usage shown is only for
+ * the copies, the results are shown in a console window at the bottom of the
+ * screen.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/framebuffer.h"
+#include "ultibo/framebufferdma.h"
+
+/* Duration of each scroll test (Milliseconds) */
+#define SCROLL_TIME 3000
+
+/* Number of copies for each size in the copy rect test */
+#define COPY_COUNT 20
+
+/* Scroll results */
+typedef struct
+{
+	double scrollspersec;
+	double cpuusage;
+} SCROLL_RESULT;
+
+/* Scroll the window one line at a time for SCROLL_TIME and measure the rate */
+static void run_scroll(WINDOW_HANDLE window, uint32_t cpuid, SCROLL_RESULT *result)
+{
+	uint32_t count;
+	int64_t start;
+	int64_t elapsed;
+
+	count = 0;
+	start = clock_microseconds();
+	do
+	{
+		console_window_scroll_up(window, 1, 1);
+		count++;
+
+		elapsed = clock_microseconds() - start;
+	} while (elapsed < (SCROLL_TIME * 1000));
+
+	/* The CPU percentage covers the last second of the test */
+	result->cpuusage = cpu_get_percentage(cpuid);
+	result->scrollspersec = ((double)count * 1000000.0) / elapsed;
+}
+
+/* Copy a full width region of rows down by one row and return the average time (Microseconds) */
+static double run_copy(FRAMEBUFFER_DEVICE *framebuffer, uint32_t width, uint32_t rows)
+{
+	uint32_t count;
+	int64_t start;
+
+	start = clock_microseconds();
+	for (count = 0; count < COPY_COUNT; count++)
+	{
+		framebuffer_device_copy_rect(framebuffer, 0, 0, 0, 1, width, rows, FRAMEBUFFER_TRANSFER_NONE);
+	}
+
+	return (double)(clock_microseconds() - start) / COPY_COUNT;
+}
+
+int apimain(int argc, char **argv)
+{
+	CONSOLE_DEVICE *console;
+	FRAMEBUFFER_DEVICE *framebuffer;
+	FRAMEBUFFER_PROPERTIES properties;
+	FRAMEBUFFER_DMA_STATISTICS statistics;
+	WINDOW_HANDLE testwindow;
+	WINDOW_HANDLE resultwindow;
+	SCROLL_RESULT cpuresult;
+	SCROLL_RESULT dmaresult;
+	uint32_t cpuid;
+	uint32_t rows;
+	uint32_t status;
+	uint32_t crossover;
+	double cputime;
+	double dmatime;
+	char text[256];
+
+	/* Get the default console and framebuffer devices */
+	console = console_device_get_default();
+	framebuffer = framebuffer_device_get_default();
+	if (!console || !framebuffer)
+		return -1;
+
+	if (framebuffer_device_get_properties(framebuffer, &properties) != ERROR_SUCCESS)
+		return -1;
+
+	/* Create a window for the results and a window for the test */
+	resultwindow = console_window_create(console, CONSOLE_POSITION_BOTTOM, TRUE);
+	testwindow = console_window_create(console, CONSOLE_POSITION_TOP, FALSE);
+
+	console_window_write_ln(resultwindow, "DMA Scroll advanced example");
+	console_window_write_ln(resultwindow, "");
+
+	/* Run the test on CPU 1 if there is more than one CPU */
+	cpuid = CPU_ID_0;
+	if (cpu_get_count() > 1)
+	{
+		cpuid = CPU_ID_1;
+		thread_set_affinity(thread_get_current(), CPU_AFFINITY_1);
+	}
+
+	/* Attach the DMA copy, start with all copies done by the CPU */
+	status = framebuffer_device_dma_attach(framebuffer, FRAMEBUFFER_DMA_THRESHOLD_NEVER);
+	if (status != ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), "Framebuffer DMA attach failed (Status=%u)", (unsigned int)status);
+		console_window_write_ln(resultwindow, text);
+
+		thread_halt(0);
+	}
+
+	/* Wait a moment for the system to settle */
+	sleep(2);
+
+	/* Fill the test window so there is something to scroll */
+	for (rows = 0; rows < console_window_get_rows(testwindow); rows++)
+	{
+		snprintf(text, sizeof(text), "Line %u The quick brown fox jumps over the lazy dog", (unsigned int)rows);
+		console_window_write_ln(testwindow, text);
+	}
+
+	/* Scroll with CPU copies */
+	run_scroll(testwindow, cpuid, &cpuresult);
+
+	/* Scroll with DMA copies */
+	framebuffer_device_dma_set_threshold(framebuffer, FRAMEBUFFER_DMA_DEFAULT_THRESHOLD);
+	framebuffer_device_dma_reset_statistics(framebuffer);
+	run_scroll(testwindow, cpuid, &dmaresult);
+
+	snprintf(text, sizeof(text), "Scroll %ux%u CPU: %.1f scrolls/sec CPU usage %.1f%%", (unsigned int)properties.physicalwidth, (unsigned int)properties.physicalheight, cpuresult.scrollspersec, cpuresult.cpuusage);
+	console_window_write_ln(resultwindow, text);
+	snprintf(text, sizeof(text), "Scroll %ux%u DMA: %.1f scrolls/sec CPU usage %.1f%%", (unsigned int)properties.physicalwidth, (unsigned int)properties.physicalheight, dmaresult.scrollspersec, dmaresult.cpuusage);
+	console_window_write_ln(resultwindow, text);
+
+	if (framebuffer_device_dma_get_statistics(framebuffer, &statistics) == ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), " DMA copies = %u CPU copies = %u DMA errors = %u 2D stride = %s", (unsigned int)statistics.dmacount, (unsigned int)statistics.cpucount, (unsigned int)statistics.dmaerrors, statistics.stridesupport ? "Yes" : "No");
+		console_window_write_ln(resultwindow, text);
+	}
+	console_window_write_ln(resultwindow, "");
+
+	/* Time copies of increasing size using the CPU and DMA to find the crossover */
+	crossover = 0;
+	for (rows = 1; rows < properties.physicalheight / 2; rows *= 2)
+	{
+		framebuffer_device_dma_set_threshold(framebuffer, FRAMEBUFFER_DMA_THRESHOLD_NEVER);
+		cputime = run_copy(framebuffer, properties.physicalwidth, rows);
+
+		framebuffer_device_dma_set_threshold(framebuffer, 0);
+		dmatime = run_copy(framebuffer, properties.physicalwidth, rows);
+
+		snprintf(text, sizeof(text), "Copy %u bytes CPU %.1f us DMA %.1f us", (unsigned int)(rows * properties.pitch), cputime, dmatime);
+		console_window_write_ln(resultwindow, text);
+
+		if (crossover == 0 && dmatime < cputime)
+			crossover = rows * properties.pitch;
+	}
+
+	if (crossover)
+		snprintf(text, sizeof(text), "DMA is faster from %u bytes (Default threshold %u bytes)", (unsigned int)crossover, (unsigned int)FRAMEBUFFER_DMA_DEFAULT_THRESHOLD);
+	else
+		snprintf(text, sizeof(text), "DMA was not faster for any size tested (CPU usage is still reduced)");
+	console_window_write_ln(resultwindow, text);
+
+	framebuffer_device_dma_set_threshold(framebuffer, FRAMEBUFFER_DMA_DEFAULT_THRESHOLD);
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
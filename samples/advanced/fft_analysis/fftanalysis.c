@@ -0,0 +1,309 @@
+/*
+ *
+ * FFT Analysis advanced example project for Ultibo API
+ *
+ * This example measures the streaming spectral analyzer built on FFTW single
+ * precision (libs/fftw3f/fftw_port_ultibo.c).
+ *
+ * The first test shows the startup cost of planning. Plans for several FFT sizes
+ * are measured with no wisdom, the wisdom is saved to drive C:\ (If available),
+ * forgotten and loaded again, then the same plans are created from the wisdom. The
+ * time to create them with FFTW_ESTIMATE is shown for comparison.
+ *
+ * The second test feeds one second of a 1 kHz test tone at 48 kHz through an
+ * analyzer with 50% overlapping Hann windowed frames, repeatedly, and shows the
+ * frames per second, the samples per second and how many times faster than real
+ * time that is for each FFT size. Each size is run with frames transformed in the
+ * calling thread and with frames spread across the per CPU worker pools, and the
+ * frequency of the strongest bin is shown as a check of the results.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/filesystem.h"
+
+#include "fftw_port_ultibo.h"
+
+/* Sample rate of the test signal (Hz) */
+#define SAMPLE_RATE 48000
+
+/* Frequency of the test tone (Hz) */
+#define TONE_FREQUENCY 1000
+
+/* Seconds of test signal passed through each analyzer */
+#define TEST_SECONDS 10
+
+/* Samples written to the analyzer at a time (10 ms) */
+#define CHUNK_SIZE 480
+
+/* File name for the saved wisdom */
+#define WISDOM_FILE "C:\\fftwf.wisdom"
+
+static const uint32_t sizes[] = {256, 1024, 4096, 16384};
+
+#define SIZE_COUNT (sizeof(sizes) / sizeof(uint32_t))
+
+static WINDOW_HANDLE window;
+
+static float *signal;
+
+/* Strongest bin of the last spectrum */
+static volatile uint32_t peakbin;
+
+static void STDCALL spectrum_callback(FFTW_ULTIBO_ANALYZER *analyzer, const float *spectrum, uint32_t bins, uint64_t frame, void *data)
+{
+	uint32_t bin;
+	uint32_t peak;
+
+	peak = 1;
+	for (bin = 2; bin < bins; bin++)
+	{
+		if (spectrum[bin] > spectrum[peak])
+			peak = bin;
+	}
+
+	peakbin = peak;
+}
+
+/* Create analyzers for all sizes and return the total time taken (Microseconds) */
+static int64_t plan_all(uint32_t planning, uint32_t *wisdomcount)
+{
+	FFTW_ULTIBO_ANALYZER *analyzers[SIZE_COUNT];
+	FFTW_ULTIBO_STATISTICS statistics;
+	FFTW_ULTIBO_CONFIG config;
+	uint32_t index;
+	int64_t start;
+	int64_t elapsed;
+
+	*wisdomcount = 0;
+
+	start = clock_microseconds();
+	for (index = 0; index < SIZE_COUNT; index++)
+	{
+		memset(&config, 0, sizeof(FFTW_ULTIBO_CONFIG));
+		config.size = sizes[index];
+		config.planning = planning;
+
+		analyzers[index] = fftw_ultibo_analyzer_create(&config, NULL, NULL);
+		if (analyzers[index] && fftw_ultibo_analyzer_get_statistics(analyzers[index], &statistics) == ERROR_SUCCESS && statistics.wisdom)
+			(*wisdomcount)++;
+	}
+	elapsed = clock_microseconds() - start;
+
+	/* Destroying the analyzers also destroys the plans, the wisdom is kept */
+	for (index = 0; index < SIZE_COUNT; index++)
+	{
+		if (analyzers[index])
+			fftw_ultibo_analyzer_destroy(analyzers[index]);
+	}
+
+	return elapsed;
+}
+
+static void run_startup(void)
+{
+	uint32_t wisdomcount;
+	uint32_t status;
+	int64_t start;
+	int64_t elapsed;
+	char text[256];
+
+	fftw_ultibo_wisdom_forget();
+
+	elapsed = plan_all(FFTW_ULTIBO_PLAN_ESTIMATE, &wisdomcount);
+	snprintf(text, sizeof(text), "FFTW_ESTIMATE, no wisdom      %10.1f ms", (double)elapsed / 1000.0);
+	console_window_write_ln(window, text);
+
+	elapsed = plan_all(FFTW_ULTIBO_PLAN_MEASURE, &wisdomcount);
+	snprintf(text, sizeof(text), "FFTW_MEASURE, no wisdom       %10.1f ms", (double)elapsed / 1000.0);
+	console_window_write_ln(window, text);
+
+	if (DirectoryExists("C:\\"))
+	{
+		status = fftw_ultibo_wisdom_save(WISDOM_FILE);
+		if (status != ERROR_SUCCESS)
+		{
+			snprintf(text, sizeof(text), "Failed to save wisdom to " WISDOM_FILE " (Error %u)", (unsigned int)status);
+			console_window_write_ln(window, text);
+			return;
+		}
+
+		fftw_ultibo_wisdom_forget();
+
+		start = clock_microseconds();
+		status = fftw_ultibo_wisdom_load(WISDOM_FILE);
+		elapsed = clock_microseconds() - start;
+		if (status != ERROR_SUCCESS)
+		{
+			snprintf(text, sizeof(text), "Failed to load wisdom from " WISDOM_FILE " (Error %u)", (unsigned int)status);
+			console_window_write_ln(window, text);
+			return;
+		}
+
+		snprintf(text, sizeof(text), "Load wisdom from " WISDOM_FILE " %8.1f ms", (double)elapsed / 1000.0);
+		console_window_write_ln(window, text);
+	}
+	else
+	{
+		console_window_write_ln(window, "Drive C:\\ not available, using the wisdom in memory");
+	}
+
+	elapsed = plan_all(FFTW_ULTIBO_PLAN_MEASURE, &wisdomcount);
+	snprintf(text, sizeof(text), "FFTW_MEASURE, with wisdom     %10.1f ms (%u of %u from wisdom)", (double)elapsed / 1000.0, (unsigned int)wisdomcount, (unsigned int)SIZE_COUNT);
+	console_window_write_ln(window, text);
+}
+
+static void run_throughput(uint32_t size, uint32_t flags, const char *mode)
+{
+	FFTW_ULTIBO_STATISTICS statistics;
+	FFTW_ULTIBO_ANALYZER *analyzer;
+	FFTW_ULTIBO_CONFIG config;
+	uint32_t accepted;
+	uint32_t offset;
+	uint32_t second;
+	uint32_t count;
+	int64_t start;
+	double elapsed;
+	char text[256];
+
+	memset(&config, 0, sizeof(FFTW_ULTIBO_CONFIG));
+	config.size = size;
+	config.window = FFTW_ULTIBO_WINDOW_HANN;
+	config.flags = flags | FFTW_ULTIBO_FLAG_DECIBEL;
+	config.samplerate = SAMPLE_RATE;
+
+	analyzer = fftw_ultibo_analyzer_create(&config, spectrum_callback, NULL);
+	if (!analyzer)
+	{
+		console_window_write_ln(window, "Failed to create the analyzer");
+		return;
+	}
+
+	start = clock_microseconds();
+	for (second = 0; second < TEST_SECONDS; second++)
+	{
+		offset = 0;
+		while (offset < SAMPLE_RATE)
+		{
+			count = (SAMPLE_RATE - offset < CHUNK_SIZE) ? SAMPLE_RATE - offset : CHUNK_SIZE;
+
+			accepted = fftw_ultibo_analyzer_write(analyzer, signal + offset, count);
+			offset += accepted;
+
+			if (flags & FFTW_ULTIBO_FLAG_THREAD)
+			{
+				/* Give the analyzer thread time to empty the ring */
+				if (accepted < count)
+					thread_yield();
+			}
+			else
+			{
+				fftw_ultibo_analyzer_process(analyzer, NULL);
+			}
+		}
+	}
+	fftw_ultibo_analyzer_wait(analyzer, INFINITE);
+	elapsed = (double)(clock_microseconds() - start);
+
+	fftw_ultibo_analyzer_get_statistics(analyzer, &statistics);
+
+	/* The full rate the analyzer can sustain, the overflow retries of the producer are not counted */
+	snprintf(text, sizeof(text), "%6u %-16s %10.0f %8.2f %9.1f %8.1f %8u %8.1f",
+	 (unsigned int)size,
+	 mode,
+	 (double)statistics.framecount * 1000000.0 / elapsed,
+	 (double)statistics.samplecount / elapsed,
+	 ((double)statistics.samplecount / elapsed) * 1000000.0 / SAMPLE_RATE,
+	 (double)statistics.executetime / (double)statistics.framecount,
+	 (unsigned int)statistics.executemax,
+	 fftw_ultibo_bin_to_frequency(analyzer, peakbin));
+	console_window_write_ln(window, text);
+
+	fftw_ultibo_analyzer_destroy(analyzer);
+}
+
+int apimain(int argc, char **argv)
+{
+	uint32_t index;
+	uint32_t sample;
+	uint32_t noise;
+
+	/* Create a console window for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "FFT Analysis advanced example");
+	console_window_write_ln(window, "");
+
+	/* Wait for the system to settle and drive C:\ to become available */
+	sleep(5);
+
+	/* One second of the test tone with a little noise */
+	signal = malloc(sizeof(float) * SAMPLE_RATE);
+	if (!signal)
+	{
+		console_window_write_ln(window, "Failed to allocate the test signal");
+		thread_halt(0);
+	}
+
+	noise = 0x2545F491;
+	for (sample = 0; sample < SAMPLE_RATE; sample++)
+	{
+		noise = noise * 1664525 + 1013904223;
+		signal[sample] = 0.5f * sinf((2.0f * (float)M_PI * TONE_FREQUENCY * sample) / SAMPLE_RATE) + ((float)(noise >> 16) / 65536.0f - 0.5f) * 0.01f;
+	}
+
+	console_window_write_ln(window, "Startup planning for sizes 256, 1024, 4096 and 16384");
+	run_startup();
+	console_window_write_ln(window, "");
+
+	console_window_write_ln(window, "  Size Mode               Frames/s     MS/s  Realtime us/frame  us(max) Peak(Hz)");
+
+	for (index = 0; index < SIZE_COUNT; index++)
+	{
+		run_throughput(sizes[index], FFTW_ULTIBO_FLAG_NONE, "Calling thread");
+		run_throughput(sizes[index], FFTW_ULTIBO_FLAG_THREAD | FFTW_ULTIBO_FLAG_WORKERS, "Worker pools");
+	}
+
+	free(signal);
+
+	console_window_write_ln(window, "");
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ *
+ * IRQ Latency advanced example project for Ultibo API
+ *
+ * This example measures interrupt latency and jitter using the latency suite
+ * (src/latency/latency.c) for timer device events, the wakeup of a thread by a
+ * timer interrupt, a thread waking a thread on another CPU, GPIO input events
+ * and tasks scheduled by an interrupt handler with worker_schedule_irq.
+ *
+ * Each test is run first on an idle system and then with CPU, memory and network
+ * load on the other CPUs, the percentiles for both runs are shown in a console
+ * window and the full histograms are written to the log.
+ *
+ * By default the GPIO test uses a virtual loopback device so it runs on any
+ * board including QEMU, to measure a real GPIO device connect GPIO_OUTPUT_PIN to
+ * GPIO_INPUT_PIN with a jumper wire and define USE_GPIO_PINS.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/gpio.h"
+#include "ultibo/latency.h"
+
+/* Duration of each test (Milliseconds) */
+#define TEST_DURATION 5000
+
+/* Interval between events in each test (Microseconds) */
+#define TEST_INTERVAL 1000
+
+/* Pins for the GPIO test when USE_GPIO_PINS is defined (Connect with a jumper wire) */
+#define GPIO_OUTPUT_PIN GPIO_PIN_23
+#define GPIO_INPUT_PIN GPIO_PIN_24
+
+/* Run all tests with the given loads and show the results */
+static void run_tests(WINDOW_HANDLE window, LATENCY_CONFIG *config, uint32_t loads, const char *title)
+{
+	LATENCY_RESULT results[LATENCY_TEST_COUNT];
+	uint32_t status;
+	uint32_t index;
+	char text[256];
+
+	console_window_write_ln(window, title);
+
+	config->loads = loads;
+
+	status = latency_run(config, results, LATENCY_TEST_COUNT);
+	if (status != ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), " Latency run failed (Status=%u)", (unsigned int)status);
+		console_window_write_ln(window, text);
+		return;
+	}
+
+	for (index = 0; index < LATENCY_TEST_COUNT; index++)
+	{
+		latency_result_to_string(&results[index], text, sizeof(text));
+		console_window_write(window, " ");
+		console_window_write_ln(window, text);
+	}
+	console_window_write_ln(window, "");
+
+	logging_output(title);
+	latency_report_log(results, LATENCY_TEST_COUNT);
+}
+
+int apimain(int argc, char **argv)
+{
+	WINDOW_HANDLE window;
+	LATENCY_CONFIG config;
+	char text[256];
+
+	/* Create a console window for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "IRQ Latency advanced example");
+	console_window_write_ln(window, "");
+
+	/* Measure on CPU 0 (Where interrupts are routed) with load on every other CPU */
+	memset(&config, 0, sizeof(config));
+	config.tests = LATENCY_TEST_ALL;
+	config.duration = TEST_DURATION;
+	config.interval = TEST_INTERVAL;
+	config.cpu = CPU_ID_0;
+#ifdef USE_GPIO_PINS
+	config.gpio = gpio_device_get_default();
+	config.outputpin = GPIO_OUTPUT_PIN;
+	config.inputpin = GPIO_INPUT_PIN;
+#endif
+
+	snprintf(text, sizeof(text), "CPUs = %u, %u ms per test, %u us interval", (unsigned int)cpu_get_count(), TEST_DURATION, TEST_INTERVAL);
+	console_window_write_ln(window, text);
+	snprintf(text, sizeof(text), "GPIO = %s", config.gpio ? "Jumpered pins" : "Virtual loopback");
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	/* Wait a moment for the system to settle */
+	sleep(2);
+
+	run_tests(window, &config, LATENCY_LOAD_NONE, "Idle");
+	run_tests(window, &config, LATENCY_LOAD_ALL, "Load (CPU, memory, network)");
+
+	console_window_write_ln(window, "Completed, histograms have been written to the log");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
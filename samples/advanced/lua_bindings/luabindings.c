@@ -0,0 +1,383 @@
+/*
+ *
+ * Lua Bindings advanced example project for Ultibo API
+ *
+ * This example measures the Lua bindings, arenas and state pools of the Ultibo
+ * port for Lua (libs/lua/lua_port_ultibo.c).
+ *
+ * The first test shows the cost of starting an interpreter. A state is created
+ * with the standard libraries on the heap, then with the standard libraries and
+ * the Ultibo bindings in an arena, and finally a state initialized in advance is
+ * taken from a pool and returned to it.
+ *
+ * The second test runs a script that times calls from Lua to an empty Lua function,
+ * to a minimal binding, to a generated GPIO binding and to the buffer methods, and
+ * compares reading a file into a reused buffer with reading it as strings. The
+ * file test needs drive C:\ and writes a 4 MB file called luabench.dat to it.
+ *
+ * The third test calls a script handler with a packet from one thread on each CPU
+ * using the pool, and compares the rate with creating a new state for every call.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/filesystem.h"
+
+#include "lua_port_ultibo.h"
+
+/* Number of states created by the startup test */
+#define STARTUP_COUNT 100
+
+/* Number of pool acquires by the startup test */
+#define ACQUIRE_COUNT 100000
+
+/* Number of handler calls by each thread of the handler test */
+#define HANDLER_COUNT 20000
+
+/* Number of handler calls with a new state each time */
+#define NEW_STATE_COUNT 100
+
+/* Size of the packet passed to the handler */
+#define PACKET_SIZE 1500
+
+/* Script loaded into every pooled state */
+static const char script[] =
+	"local u = ultibo\n"
+	"local function report(name, ns)\n"
+	"  u.console.write_ln(nil, string.format('%-34s %10.1f', name, ns))\n"
+	"end\n"
+	"local function time(f, count)\n"
+	"  local start = u.microseconds()\n"
+	"  for i = 1, count do f() end\n"
+	"  return (u.microseconds() - start) * 1000 / count\n"
+	"end\n"
+	"function bench_calls(count)\n"
+	"  local b = u.buffer.new(64)\n"
+	"  local cpu, level_get, empty = u.cpu, u.gpio.level_get, function() end\n"
+	"  local base = time(empty, count)\n"
+	"  report('Empty Lua function', base)\n"
+	"  report('ultibo.cpu()', time(function() cpu() end, count))\n"
+	"  report('ultibo.gpio.level_get(18)', time(function() level_get(18) end, count))\n"
+	"  report('buffer[1]', time(function() local v = b[1] end, count))\n"
+	"  report('buffer:u32(1)', time(function() b:u32(1) end, count))\n"
+	"  report('buffer:u32(1, value)', time(function() b:u32(1, 0x12345678) end, count))\n"
+	"end\n"
+	"function bench_file(name, size, block)\n"
+	"  local f = u.file\n"
+	"  local b = u.buffer.new(block)\n"
+	"  for i = 1, block do b[i] = i % 256 end\n"
+	"  local h = f.create(name)\n"
+	"  if not h then return false end\n"
+	"  for i = 1, size // block do f.write(h, b) end\n"
+	"  f.close(h)\n"
+	"  local function run(label, read)\n"
+	"    collectgarbage('collect')\n"
+	"    h = f.open(name)\n"
+	"    local start, total = u.microseconds(), 0\n"
+	"    while true do\n"
+	"      local count = read(h)\n"
+	"      if count <= 0 then break end\n"
+	"      total = total + count\n"
+	"    end\n"
+	"    local elapsed = u.microseconds() - start\n"
+	"    f.close(h)\n"
+	"    u.console.write_ln(nil, string.format('%-34s %10.1f MB/s %8.0f KB', label, total / elapsed, collectgarbage('count')))\n"
+	"  end\n"
+	"  run('file.read(handle, buffer)', function(h) return f.read(h, b) end)\n"
+	"  run('file.read(handle, count)', function(h) local s = f.read(h, block) return s and #s or 0 end)\n"
+	"  return true\n"
+	"end\n"
+	"function handler(packet, size)\n"
+	"  local b = u.buffer.wrap(packet, size)\n"
+	"  if b[13] ~= 0x08 or b[14] ~= 0x00 then return 0 end\n"
+	"  return b:u16(17) + b:u32(27) + b:u32(31)\n"
+	"end\n";
+
+static WINDOW_HANDLE window;
+
+static LUA_ULTIBO_POOL *pool;
+
+static uint8_t packet[PACKET_SIZE];
+
+static void write_result(const char *name, int64_t elapsed, uint32_t count)
+{
+	char text[256];
+
+	snprintf(text, sizeof(text), "%-34s %10.1f us", name, (double)elapsed / (double)count);
+	console_window_write_ln(window, text);
+}
+
+static void run_startup(void)
+{
+	LUA_ULTIBO_ARENA_STATISTICS statistics;
+	LUA_ULTIBO_ARENA *arena;
+	lua_State *L;
+	uint32_t count;
+	uint32_t peak;
+	int64_t start;
+	char text[256];
+
+	start = clock_microseconds();
+	for (count = 0; count < STARTUP_COUNT; count++)
+	{
+		L = luaL_newstate();
+		luaL_openlibs(L);
+		lua_close(L);
+	}
+	write_result("luaL_newstate and luaL_openlibs", clock_microseconds() - start, STARTUP_COUNT);
+
+	peak = 0;
+	start = clock_microseconds();
+	for (count = 0; count < STARTUP_COUNT; count++)
+	{
+		arena = lua_ultibo_arena_create(0, 0);
+		L = lua_ultibo_state_create(arena);
+		lua_close(L);
+
+		lua_ultibo_arena_get_statistics(arena, &statistics);
+		peak = statistics.peak;
+
+		lua_ultibo_arena_destroy(arena);
+	}
+	write_result("lua_ultibo_state_create (Arena)", clock_microseconds() - start, STARTUP_COUNT);
+
+	start = clock_microseconds();
+	for (count = 0; count < ACQUIRE_COUNT; count++)
+	{
+		L = lua_ultibo_pool_acquire(pool);
+		lua_ultibo_pool_release(pool, L);
+	}
+	write_result("lua_ultibo_pool_acquire and release", clock_microseconds() - start, ACQUIRE_COUNT);
+
+	snprintf(text, sizeof(text), "Arena peak for a new state %u bytes", (unsigned int)peak);
+	console_window_write_ln(window, text);
+}
+
+/* Take a pooled state and push a global function of the benchmark script */
+static lua_State *script_begin(const char *function)
+{
+	lua_State *L;
+
+	L = lua_ultibo_pool_acquire(pool);
+	if (!L)
+	{
+		console_window_write_ln(window, "Failed to acquire a state");
+		return NULL;
+	}
+
+	lua_getglobal(L, function);
+
+	return L;
+}
+
+/* Call the function with the arguments pushed and return the state to the pool */
+static void script_end(lua_State *L, int nargs)
+{
+	if (lua_pcall(L, nargs, 1, 0) != LUA_OK)
+		console_window_write_ln(window, lua_tostring(L, -1));
+	else if (lua_isboolean(L, -1) && !lua_toboolean(L, -1))
+		console_window_write_ln(window, "Failed to create the test file");
+
+	lua_ultibo_pool_release(pool, L);
+}
+
+static void run_calls(void)
+{
+	lua_State *L;
+
+	L = script_begin("bench_calls");
+	if (!L)
+		return;
+
+	lua_pushinteger(L, 1000000);
+	script_end(L, 1);
+}
+
+static void run_file(void)
+{
+	lua_State *L;
+
+	L = script_begin("bench_file");
+	if (!L)
+		return;
+
+	lua_pushstring(L, "C:\\luabench.dat");
+	lua_pushinteger(L, SIZE_4M);
+	lua_pushinteger(L, SIZE_4K);
+	script_end(L, 3);
+}
+
+static ssize_t STDCALL handler_execute(void *parameter)
+{
+	uint32_t count;
+	int64_t result;
+
+	for (count = 0; count < HANDLER_COUNT; count++)
+		lua_ultibo_pool_call(pool, "handler", packet, PACKET_SIZE, &result);
+
+	return 0;
+}
+
+static void run_handlers(void)
+{
+	LUA_ULTIBO_POOL_STATISTICS statistics;
+	THREAD_HANDLE threads[CPU_ID_MAX + 1];
+	LUA_ULTIBO_ARENA *arena;
+	lua_State *L;
+	uint32_t cpucount;
+	uint32_t cpu;
+	uint32_t count;
+	int64_t start;
+	int64_t elapsed;
+	char text[256];
+
+	/* An IPv4 UDP packet for the handler to pick apart */
+	memset(packet, 0, PACKET_SIZE);
+	packet[12] = 0x08;
+	packet[23] = 17;
+
+	cpucount = cpu_get_count();
+
+	lua_ultibo_pool_reset_statistics(pool);
+
+	start = clock_microseconds();
+	for (cpu = 0; cpu < cpucount; cpu++)
+		threads[cpu] = thread_create_ex(handler_execute, SIZE_64K, THREAD_PRIORITY_NORMAL, 1 << cpu, cpu, "Lua Handler", NULL);
+
+	for (cpu = 0; cpu < cpucount; cpu++)
+	{
+		if (threads[cpu] != INVALID_HANDLE_VALUE)
+			thread_wait_terminate(threads[cpu], INFINITE);
+	}
+	elapsed = clock_microseconds() - start;
+
+	lua_ultibo_pool_get_statistics(pool, &statistics);
+
+	snprintf(text, sizeof(text), "Pool, %u threads %21.0f calls/s (%u errors, %u borrowed, %u created)",
+	 (unsigned int)cpucount,
+	 (double)statistics.callcount * 1000000.0 / (double)elapsed,
+	 (unsigned int)statistics.errorcount,
+	 (unsigned int)statistics.remotecount,
+	 (unsigned int)statistics.createcount);
+	console_window_write_ln(window, text);
+
+	start = clock_microseconds();
+	for (count = 0; count < NEW_STATE_COUNT; count++)
+	{
+		arena = lua_ultibo_arena_create(0, 0);
+		L = lua_ultibo_state_create(arena);
+		if (!L || luaL_dostring(L, script) != LUA_OK)
+		{
+			console_window_write_ln(window, "Failed to create a state");
+			break;
+		}
+
+		lua_getglobal(L, "handler");
+		lua_pushlightuserdata(L, packet);
+		lua_pushinteger(L, PACKET_SIZE);
+		lua_pcall(L, 2, 1, 0);
+
+		lua_ultibo_state_destroy(L, arena);
+	}
+	elapsed = clock_microseconds() - start;
+
+	snprintf(text, sizeof(text), "New state, 1 thread %20.0f calls/s", (double)count * 1000000.0 / (double)elapsed);
+	console_window_write_ln(window, text);
+}
+
+int apimain(int argc, char **argv)
+{
+	LUA_ULTIBO_POOL_STATISTICS statistics;
+	LUA_ULTIBO_POOL_CONFIG config;
+	char text[256];
+
+	/* Create a console window for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "Lua Bindings advanced example");
+	console_window_write_ln(window, "");
+
+	/* Wait for the system to settle and drive C:\ to become available */
+	sleep(5);
+
+	memset(&config, 0, sizeof(LUA_ULTIBO_POOL_CONFIG));
+	config.statespercpu = 2;
+	config.script = script;
+	config.name = "=benchmark";
+
+	pool = lua_ultibo_pool_create(&config);
+	if (!pool)
+	{
+		console_window_write_ln(window, "Failed to create the state pool");
+		thread_halt(0);
+	}
+
+	lua_ultibo_pool_get_statistics(pool, &statistics);
+	snprintf(text, sizeof(text), "Created %u states in the pool, %u us each", (unsigned int)statistics.statecount, (unsigned int)statistics.createtime);
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	console_window_write_ln(window, "Interpreter startup");
+	run_startup();
+	console_window_write_ln(window, "");
+
+	console_window_write_ln(window, "Call from Lua                         ns/call");
+	run_calls();
+	console_window_write_ln(window, "");
+
+	if (DirectoryExists("C:\\"))
+	{
+		console_window_write_ln(window, "Read 4 MB in 4 KB blocks               Rate      Lua heap");
+		run_file();
+	}
+	else
+	{
+		console_window_write_ln(window, "Drive C:\\ not available, skipping the file test");
+	}
+	console_window_write_ln(window, "");
+
+	console_window_write_ln(window, "Handler calls with a 1500 byte packet");
+	run_handlers();
+
+	lua_ultibo_pool_destroy(pool);
+
+	console_window_write_ln(window, "");
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
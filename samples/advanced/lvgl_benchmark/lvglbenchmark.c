@@ -0,0 +1,168 @@
+/*
+ *
+ * LVGL Benchmark advanced example project for Ultibo API
+ *
+ * This example runs the LVGL benchmark demo using the Ultibo port for LVGL
+ * (libs/lvgl/lv_port_ultibo.c) and reports the frames per second and CPU
+ * usage to the serial log once per second.
+ *
+ * The port flushes each rendered area to the framebuffer using asynchronous
+ * DMA so rendering of the next area overlaps the transfer, the software draw
+ * units are pinned to separate CPUs and areas are converted using NEON where
+ * the framebuffer is not ARGB8888.
+ *
+ * The precompiled LVGL library uses a single software draw unit and has the
+ * system monitor disabled. To render with one draw unit per CPU and show the
+ * LVGL performance monitor on screen, set LV_DRAW_SW_DRAW_UNIT_CNT (eg 3) and
+ * LV_USE_SYSMON / LV_USE_PERF_MONITOR in libs/lvgl/lv_conf.h, then rebuild
+ * liblvgl.a and this example. Both are detected when this example is built.
+ *
+ * To compare configurations add any of the following to the command line
+ * (cmdline.txt):
+ *
+ *  nodma       - Flush synchronously using framebuffer_device_put_rect
+ *  single      - Use a single render buffer (No overlap of render and flush)
+ *  noaffinity  - Don't pin the draw units to separate CPUs
+ *
+ * Connect a serial cable to the default serial port to see the results.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/serial.h"
+#include "ultibo/logging.h"
+#include "ultibo/framebuffer.h"
+
+#include "lv_conf.h"
+#include "lvgl/lvgl.h"
+
+#include "lv_port_ultibo.h"
+
+#include "lvgl/demos/lv_demos.h"
+
+/* Interval between summary reports (Milliseconds) */
+#define SUMMARY_INTERVAL 10000
+
+/* Summary timer callback, logs the totals collected by the display port */
+static void summary_callback(lv_timer_t *timer)
+{
+	lv_display_t *display = (lv_display_t *)lv_timer_get_user_data(timer);
+	LV_ULTIBO_STATISTICS statistics;
+
+	if (lv_ultibo_display_get_statistics(display, &statistics) != ERROR_SUCCESS)
+		return;
+
+	logging_output("LVGL Benchmark Summary");
+	logging_outputf(" Frames = %u Flushes = %u\n", (unsigned int)statistics.framecount, (unsigned int)statistics.flushcount);
+	logging_outputf(" DMA Flushes = %u CPU Flushes = %u DMA Errors = %u\n", (unsigned int)statistics.dmacount, (unsigned int)statistics.cpucount, (unsigned int)statistics.dmaerrors);
+	logging_outputf(" Flush Waits = %u Wait Time = %u ms\n", (unsigned int)statistics.waitcount, (unsigned int)(statistics.waittime / 1000));
+	logging_outputf(" Pixels Converted = %u\n", (unsigned int)statistics.convertcount);
+	logging_outputf(" FPS = %u CPU = %u%% LVGL CPU = %u%%\n", (unsigned int)statistics.fps, (unsigned int)statistics.cpuusage, (unsigned int)statistics.cpucurrent);
+}
+
+/* The main function for our app, called after system initialization */
+int apimain(int argc, char **argv)
+{
+	lv_display_t *display;
+	LV_ULTIBO_STATISTICS statistics;
+	uint32_t flags;
+	int count;
+
+	/* Enable logging to the default serial device */
+	serial_logging_device_add(serial_device_get_default());
+
+	/* Make the serial logging device the default */
+	logging_device_set_default(logging_device_find_by_type(LOGGING_TYPE_SERIAL));
+
+	/* Check the command line for configuration options */
+	flags = LV_ULTIBO_DISPLAY_FLAG_DOUBLE_BUFFER | LV_ULTIBO_DISPLAY_FLAG_REPORT;
+	for (count = 1; count < argc; count++)
+	{
+		if (strcmp(argv[count], "nodma") == 0)
+			flags |= LV_ULTIBO_DISPLAY_FLAG_NO_DMA;
+		else if (strcmp(argv[count], "single") == 0)
+			flags &= ~LV_ULTIBO_DISPLAY_FLAG_DOUBLE_BUFFER;
+		else if (strcmp(argv[count], "noaffinity") == 0)
+			flags |= LV_ULTIBO_DISPLAY_FLAG_NO_AFFINITY;
+	}
+
+	/* Initialize LVGL */
+	lv_init();
+	lv_ultibo_tick_init();
+
+	/* Create the display, pointer and keypad drivers */
+	display = lv_ultibo_display_create(NULL, flags);
+	if (!display)
+	{
+		logging_output("Failed to create LVGL display");
+		return -1;
+	}
+
+	lv_ultibo_pointer_create(display, NULL);
+	lv_ultibo_keypad_create(display);
+
+	/* Report the configuration */
+	lv_ultibo_display_get_statistics(display, &statistics);
+
+	logging_output("LVGL Benchmark");
+	logging_outputf(" CPU Count = %u\n", (unsigned int)cpu_get_count());
+	logging_outputf(" Draw Units = %u (Pinned = %u)\n", (unsigned int)LV_DRAW_SW_DRAW_UNIT_CNT, (unsigned int)statistics.drawunits);
+	#if LV_DRAW_SW_DRAW_UNIT_CNT < 2
+	if (cpu_get_count() > 1)
+		logging_output(" Rebuild liblvgl.a with LV_DRAW_SW_DRAW_UNIT_CNT > 1 to render on the other CPUs");
+	#endif
+	logging_outputf(" Flush Mode = %s\n", statistics.flushmode == LV_ULTIBO_FLUSH_MODE_DMA_STRIDE ? "DMA (2D Stride)" : statistics.flushmode == LV_ULTIBO_FLUSH_MODE_DMA_ROWS ? "DMA (Rows)" : "CPU");
+	logging_outputf(" Double Buffer = %s\n", (flags & LV_ULTIBO_DISPLAY_FLAG_DOUBLE_BUFFER) ? "Yes" : "No");
+
+	#if LV_USE_PERF_MONITOR
+	/* Show the LVGL performance monitor if the library includes it */
+	lv_sysmon_show_performance(display);
+	#endif
+
+	/* Start the benchmark and the summary timer */
+	lv_demo_benchmark();
+
+	lv_timer_create(summary_callback, SUMMARY_INTERVAL, display);
+
+	/* Start the main loop, running the LVGL timer */
+	while (1)
+	{
+		/* Process LVGL events */
+		uint32_t time_till_next = lv_timer_handler();
+
+		/* Wait for next event time */
+		usleep(time_till_next * 1000);
+	}
+
+	return 0;
+}
@@ -0,0 +1,340 @@
+/*
+ *
+ * Memory Bandwidth advanced example project for Ultibo API
+ *
+ * This example measures the memory system of the board with the benchmark
+ * harness (src/benchmark/benchmark.c) and the tuned memory operations library
+ * (src/platform/memops.c).
+ *
+ * Read, write and copy bandwidth are measured for buffers from 4KB to 16MB so
+ * the change from the level 1 cache to the level 2 cache to main memory can be
+ * seen. Copies are done with the C library memcpy, with mem_ops_copy and with
+ * dma_copy_memory. A strided read over a buffer larger than the level 2 cache
+ * shows the cost of each new cache line and each new page.
+ *
+ * Finally mem_ops_tune chooses the prefetch distance and the size at which
+ * mem_ops_copy_auto hands copies to the DMA controller for this board.
+ *
+ * The results are shown in a console window and written as JSON (which includes
+ * the board type) to the default serial port and to C:\membandwidth.json so
+ * runs on different boards can be compared.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/benchmark.h"
+#include "ultibo/memops.h"
+
+/* File for the JSON results */
+#define RESULTS_FILE "C:\\membandwidth.json"
+
+/* Buffer read by the stride test (Bytes) */
+#define STRIDE_BUFFER_SIZE SIZE_16M
+
+/* Test kinds */
+#define TEST_READ 0
+#define TEST_WRITE 1
+#define TEST_COPY_LIBC 2
+#define TEST_COPY_MEMOPS 3
+#define TEST_COPY_DMA 4
+#define TEST_STRIDE 5
+
+#define TEST_KIND_COUNT 5 // Kinds measured at every buffer size
+
+#define MAX_TESTS 64
+
+/* Test parameters, one per benchmark */
+typedef struct
+{
+	uint32_t kind;
+	uint32_t size; // Buffer size (Bytes)
+	uint32_t stride; // Distance between reads in the stride test (Bytes)
+} TEST_PARAMETER;
+
+/* Test data, allocated by setup */
+typedef struct
+{
+	const TEST_PARAMETER *parameter;
+	uint8_t *source;
+	uint8_t *dest;
+	uint32_t offset; // Current offset of the stride test
+} TEST_DATA;
+
+static const uint32_t buffer_sizes[] = {SIZE_4K, SIZE_16K, SIZE_64K, SIZE_256K, SIZE_1M, SIZE_4M, SIZE_16M};
+static const uint32_t stride_sizes[] = {4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384};
+static const char *test_names[] = {"read", "write", "memcpy", "mem_ops_copy", "dma_copy", "stride"};
+
+static TEST_PARAMETER parameters[MAX_TESTS];
+static char names[MAX_TESTS][BENCHMARK_NAME_LENGTH];
+static BENCHMARK tests[MAX_TESTS];
+static BENCHMARK_RESULT results[MAX_TESTS];
+
+static volatile uint32_t read_sink;
+
+static uint32_t STDCALL test_setup(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, void **data)
+{
+	const TEST_PARAMETER *parameter = (const TEST_PARAMETER *)benchmark->parameter;
+	TEST_DATA *test;
+
+	if (parameter->kind == TEST_COPY_DMA && !dma_available())
+		return ERROR_NOT_SUPPORTED;
+
+	test = calloc(1, sizeof(TEST_DATA));
+	if (!test)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	test->parameter = parameter;
+	test->source = malloc(parameter->size);
+	test->dest = malloc(parameter->size);
+	if (!test->source || !test->dest)
+	{
+		free(test->source);
+		free(test->dest);
+		free(test);
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
+
+	/* Touch every page so the first run does not include the cost of mapping it */
+	memset(test->source, 0x5A, parameter->size);
+	memset(test->dest, 0, parameter->size);
+
+	*data = test;
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL test_run(void *data, uint32_t iterations)
+{
+	TEST_DATA *test = (TEST_DATA *)data;
+	const TEST_PARAMETER *parameter = test->parameter;
+	const uint32_t *words;
+	uint32_t count;
+	uint32_t index;
+	uint32_t sum = 0;
+	uint32_t mask;
+	uint32_t offset;
+
+	switch (parameter->kind)
+	{
+		case TEST_READ:
+			words = (const uint32_t *)test->source;
+			for (count = 0; count < iterations; count++)
+			{
+				for (index = 0; index < parameter->size / 4; index += 4)
+					sum += words[index] + words[index + 1] + words[index + 2] + words[index + 3];
+			}
+			read_sink = sum;
+			break;
+		case TEST_WRITE:
+			for (count = 0; count < iterations; count++)
+				mem_ops_set(test->dest, count, parameter->size);
+			break;
+		case TEST_COPY_LIBC:
+			for (count = 0; count < iterations; count++)
+				memcpy(test->dest, test->source, parameter->size);
+			break;
+		case TEST_COPY_MEMOPS:
+			for (count = 0; count < iterations; count++)
+				mem_ops_copy(test->dest, test->source, parameter->size);
+			break;
+		case TEST_COPY_DMA:
+			for (count = 0; count < iterations; count++)
+			{
+				if (dma_copy_memory(test->source, test->dest, parameter->size) != ERROR_SUCCESS)
+					return ERROR_OPERATION_FAILED;
+			}
+			break;
+		case TEST_STRIDE:
+			/* One read per iteration, wrapping within the buffer */
+			words = (const uint32_t *)test->source;
+			mask = parameter->size - 1;
+			offset = test->offset;
+			for (count = 0; count < iterations; count++)
+			{
+				sum += words[offset / 4];
+				offset = (offset + parameter->stride) & mask;
+			}
+			test->offset = offset;
+			read_sink = sum;
+			break;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static void STDCALL test_teardown(void *data)
+{
+	TEST_DATA *test = (TEST_DATA *)data;
+
+	free(test->source);
+	free(test->dest);
+	free(test);
+}
+
+static void add_test(uint32_t *count, uint32_t kind, uint32_t size, uint32_t stride)
+{
+	TEST_PARAMETER *parameter = &parameters[*count];
+	BENCHMARK *test = &tests[*count];
+
+	parameter->kind = kind;
+	parameter->size = size;
+	parameter->stride = stride;
+
+	if (kind == TEST_STRIDE)
+		snprintf(names[*count], BENCHMARK_NAME_LENGTH, "%s_%u", test_names[kind], (unsigned int)stride);
+	else
+		snprintf(names[*count], BENCHMARK_NAME_LENGTH, "%s_%uk", test_names[kind], (unsigned int)(size / 1024));
+
+	test->name = names[*count];
+	test->group = BENCHMARK_GROUP_USER;
+	test->iterations = 0;
+	test->setup = test_setup;
+	test->run = test_run;
+	test->teardown = test_teardown;
+	test->parameter = parameter;
+
+	(*count)++;
+}
+
+int apimain(int argc, char **argv)
+{
+	BENCHMARK_CONFIG config;
+	MEM_OPS_CONFIG memconfig;
+	WINDOW_HANDLE window;
+	uint32_t status;
+	uint32_t count;
+	uint32_t index;
+	uint32_t kind;
+	char implementation[32];
+	char text[256];
+
+	/* Create a console window for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "Memory Bandwidth advanced example");
+	console_window_write_ln(window, "");
+
+	/* Wait for the system to settle and drive C:\ to become available */
+	sleep(5);
+
+	mem_ops_get_config(&memconfig);
+	mem_ops_implementation_to_string(memconfig.implementation, implementation, sizeof(implementation));
+
+	snprintf(text, sizeof(text), "Board type %u, %u CPUs, memory operations %s", (unsigned int)board_get_type(), (unsigned int)cpu_get_count(), implementation);
+	console_window_write_ln(window, text);
+	snprintf(text, sizeof(text), "L1 data cache %u bytes (line %u), L2 cache %u bytes, page %u bytes", (unsigned int)memconfig.l1size, (unsigned int)memconfig.linesize, (unsigned int)memconfig.l2size, (unsigned int)memconfig.pagesize);
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	/* Bandwidth tests for every size then the stride tests */
+	count = 0;
+	for (index = 0; index < sizeof(buffer_sizes) / sizeof(buffer_sizes[0]); index++)
+	{
+		for (kind = 0; kind < TEST_KIND_COUNT; kind++)
+			add_test(&count, kind, buffer_sizes[index], 0);
+	}
+	for (index = 0; index < sizeof(stride_sizes) / sizeof(stride_sizes[0]); index++)
+		add_test(&count, TEST_STRIDE, STRIDE_BUFFER_SIZE, stride_sizes[index]);
+
+	/* Defaults for everything except the CPU and the number of repeats */
+	memset(&config, 0, sizeof(BENCHMARK_CONFIG));
+	config.cpu = CPU_ID_0;
+	config.repeats = 10;
+
+	console_window_write_ln(window, "Running, this may take a minute");
+	console_window_write_ln(window, "");
+
+	status = benchmark_run_list(tests, count, &config, results);
+	if (status != ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), "Benchmark failed (Status %u)", (unsigned int)status);
+		console_window_write_ln(window, text);
+		thread_halt(0);
+	}
+
+	for (index = 0; index < count; index++)
+	{
+		if (results[index].status == ERROR_NOT_SUPPORTED)
+			snprintf(text, sizeof(text), "%-24s not supported", results[index].name);
+		else if (results[index].status != ERROR_SUCCESS)
+			snprintf(text, sizeof(text), "%-24s failed (Status %u)", results[index].name, (unsigned int)results[index].status);
+		else if (parameters[index].kind == TEST_STRIDE)
+			snprintf(text, sizeof(text), "%-24s %10.2f ns per read", results[index].name, results[index].median);
+		else
+			snprintf(text, sizeof(text), "%-24s %10.1f MB/s", results[index].name, (parameters[index].size * 1000.0) / results[index].median);
+
+		console_window_write_ln(window, text);
+	}
+	console_window_write_ln(window, "");
+
+	/* Tune the memory operations for this board */
+	if (mem_ops_tune(&memconfig) == ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), "Tuned prefetch distance %u bytes", (unsigned int)memconfig.prefetch);
+		console_window_write_ln(window, text);
+
+		if (memconfig.dmathreshold == MEM_OPS_THRESHOLD_NEVER)
+			snprintf(text, sizeof(text), "DMA copy threshold: never (DMA was not faster at any size)");
+		else
+			snprintf(text, sizeof(text), "DMA copy threshold: %u bytes", (unsigned int)memconfig.dmathreshold);
+		console_window_write_ln(window, text);
+
+		if (memconfig.nonthreshold != MEM_OPS_THRESHOLD_NEVER)
+		{
+			snprintf(text, sizeof(text), "Non temporal store threshold: %u bytes", (unsigned int)memconfig.nonthreshold);
+			console_window_write_ln(window, text);
+		}
+		console_window_write_ln(window, "");
+	}
+
+	/* Send the JSON results to the serial port */
+	if (serial_open(115200, SERIAL_DATA_8BIT, SERIAL_STOP_1BIT, SERIAL_PARITY_NONE, SERIAL_FLOW_NONE, 0, 0) == ERROR_SUCCESS)
+	{
+		benchmark_export_serial(results, count);
+		serial_close();
+
+		console_window_write_ln(window, "Results sent to the serial port");
+	}
+
+	if (benchmark_export_file(results, count, RESULTS_FILE) == ERROR_SUCCESS)
+		console_window_write_ln(window, "Results written to " RESULTS_FILE);
+
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
@@ -0,0 +1,447 @@
+/*
+ *
+ * PNG Decode advanced example project for Ultibo API
+ *
+ * This example compares two ways of showing a PNG image on the framebuffer, the
+ * usual approach of decoding the whole image to 32 bit pixels, converting it to the
+ * framebuffer format and copying it to the screen, against the row streaming decode
+ * in libs/libpng16/png_port_ultibo.c which converts each row straight into the
+ * framebuffer format and never holds more than a strip of rows.
+ *
+ * Four test images are written to drive C:\ the first time the example runs, a
+ * 1920x1080 RGB image in the style of a photograph, a 1024x768 RGBA image with
+ * transparent areas, a 1280x720 palette image and the same RGB image as an Adam7
+ * interlaced file which cannot be streamed.
+ *
+ * Each image is drawn in the bottom half of the screen at its natural size (Clipped
+ * to the area) and scaled to fit, then loaded into a PNG cache and drawn from the
+ * cache. The time taken and the peak memory used by each method are shown in a
+ * console window in the top half of the screen.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/filesystem.h"
+#include "ultibo/framebuffer.h"
+
+#include "png_port_ultibo.h"
+
+/* Number of draws averaged for each cached image */
+#define CACHE_DRAWS 10
+
+/* Test Image */
+typedef struct
+{
+	const char *name;
+	const char *filename;
+	uint32_t width;
+	uint32_t height;
+	int colortype;
+	int interlace;
+} TEST_IMAGE;
+
+static const TEST_IMAGE images[] =
+{
+	{"Photo RGB", "C:\\pngphoto.png", 1920, 1080, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE},
+	{"Icons RGBA", "C:\\pngicons.png", 1024, 768, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE},
+	{"Palette", "C:\\pngpalette.png", 1280, 720, PNG_COLOR_TYPE_PALETTE, PNG_INTERLACE_NONE},
+	{"Interlaced RGB", "C:\\pnginterlaced.png", 1920, 1080, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_ADAM7}
+};
+
+#define IMAGE_COUNT (sizeof(images) / sizeof(TEST_IMAGE))
+
+static WINDOW_HANDLE window;
+
+static FRAMEBUFFER_DEVICE *framebuffer;
+static FRAMEBUFFER_PROPERTIES properties;
+
+/* Drawing area in the bottom half of the screen */
+static uint32_t area_top;
+static uint32_t area_width;
+static uint32_t area_height;
+
+static uint32_t random_state;
+
+static uint32_t random_next(void)
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+
+	return random_state;
+}
+
+/* Fill one row of a test image, channels are in PNG order */
+static void image_row(const TEST_IMAGE *image, uint8_t *row, uint32_t y)
+{
+	uint32_t x;
+	uint32_t noise;
+	uint8_t *pixel;
+
+	pixel = row;
+	for (x = 0; x < image->width; x++)
+	{
+		switch (image->colortype)
+		{
+			case PNG_COLOR_TYPE_PALETTE:
+				/* Bands of color with a pattern */
+				*pixel++ = ((x / 40) * 16 + (y / 30) + (((x ^ y) >> 3) & 3)) & 0xFF;
+				break;
+			case PNG_COLOR_TYPE_RGB_ALPHA:
+				/* Rounded tiles on a transparent background */
+				pixel[0] = (x * 255) / image->width;
+				pixel[1] = (y * 255) / image->height;
+				pixel[2] = ((x / 64) + (y / 64)) * 16;
+				pixel[3] = (((x % 64) > 8) && ((y % 64) > 8)) ? 255 : (((x % 64) + (y % 64)) * 8);
+				pixel += 4;
+				break;
+			default:
+				/* Smooth gradients with some noise, compresses much like a photograph */
+				noise = random_next() & 0x0F;
+				pixel[0] = ((x * 200) / image->width) + noise;
+				pixel[1] = ((y * 200) / image->height) + noise;
+				pixel[2] = (((x + y) * 100) / (image->width + image->height)) + 128 - noise;
+				pixel += 3;
+				break;
+		}
+	}
+}
+
+static BOOL image_create(const TEST_IMAGE *image)
+{
+	png_color palette[256];
+	png_structp png;
+	png_infop info;
+	uint32_t passes;
+	uint32_t pass;
+	uint32_t index;
+	uint32_t y;
+	uint8_t *row;
+	FILE *file;
+
+	file = fopen(image->filename, "wb");
+	if (!file)
+		return FALSE;
+
+	row = malloc(image->width * 4);
+	png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	info = png ? png_create_info_struct(png) : NULL;
+	if (!row || !info || setjmp(png_jmpbuf(png)))
+	{
+		png_destroy_write_struct(&png, &info);
+		free(row);
+		fclose(file);
+		return FALSE;
+	}
+
+	png_init_io(png, file);
+	png_set_IHDR(png, info, image->width, image->height, 8, image->colortype, image->interlace, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+	if (image->colortype == PNG_COLOR_TYPE_PALETTE)
+	{
+		for (index = 0; index < 256; index++)
+		{
+			palette[index].red = index;
+			palette[index].green = (index * 3) & 0xFF;
+			palette[index].blue = 255 - index;
+		}
+		png_set_PLTE(png, info, palette, 256);
+	}
+
+	png_write_info(png, info);
+
+	/* Interlaced images are written by passing every row once for each pass */
+	passes = png_set_interlace_handling(png);
+	for (pass = 0; pass < passes; pass++)
+	{
+		random_state = 0x2545F491;
+
+		for (y = 0; y < image->height; y++)
+		{
+			image_row(image, row, y);
+			png_write_row(png, row);
+		}
+	}
+
+	png_write_end(png, NULL);
+	png_destroy_write_struct(&png, &info);
+
+	free(row);
+	fclose(file);
+
+	return TRUE;
+}
+
+/* Convert 32 bit pixels (COLOR_FORMAT_ARGB32) to the framebuffer format */
+static BOOL baseline_convert(const uint32_t *source, void *dest, uint32_t count)
+{
+	uint32_t index;
+	uint32_t color;
+	uint8_t *output;
+
+	switch (properties.format)
+	{
+		case COLOR_FORMAT_ARGB32:
+		case COLOR_FORMAT_URGB32:
+			memcpy(dest, source, count * 4);
+			return TRUE;
+		case COLOR_FORMAT_RGB24:
+			output = dest;
+			for (index = 0; index < count; index++)
+			{
+				color = source[index];
+				*output++ = color & 0xFF;
+				*output++ = (color >> 8) & 0xFF;
+				*output++ = (color >> 16) & 0xFF;
+			}
+			return TRUE;
+		case COLOR_FORMAT_RGB16:
+			for (index = 0; index < count; index++)
+			{
+				color = source[index];
+				((uint16_t *)dest)[index] = ((color >> 8) & 0xF800) | ((color >> 5) & 0x07E0) | ((color >> 3) & 0x001F);
+			}
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Decode the whole image, convert it and copy the visible part to the screen */
+static uint32_t run_baseline(const TEST_IMAGE *image, uint32_t *memoryused)
+{
+	png_image decode;
+	uint32_t *pixels;
+	uint32_t width;
+	uint32_t height;
+	uint32_t bytes;
+	void *converted;
+
+	memset(&decode, 0, sizeof(png_image));
+	decode.version = PNG_IMAGE_VERSION;
+	if (!png_image_begin_read_from_file(&decode, image->filename))
+		return ERROR_INVALID_DATA;
+
+	/* BGRA in memory is COLOR_FORMAT_ARGB32 */
+	decode.format = PNG_FORMAT_BGRA;
+
+	bytes = png_ultibo_format_bytes(properties.format);
+	pixels = malloc(PNG_IMAGE_SIZE(decode));
+	converted = malloc(decode.width * decode.height * bytes);
+	if (!pixels || !converted)
+	{
+		png_image_free(&decode);
+		free(converted);
+		free(pixels);
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
+
+	*memoryused = PNG_IMAGE_SIZE(decode) + (decode.width * decode.height * bytes);
+
+	if (!png_image_finish_read(&decode, NULL, pixels, 0, NULL) || !baseline_convert(pixels, converted, decode.width * decode.height))
+	{
+		free(converted);
+		free(pixels);
+		return ERROR_NOT_SUPPORTED;
+	}
+
+	width = (decode.width < area_width) ? decode.width : area_width;
+	height = (decode.height < area_height) ? decode.height : area_height;
+
+	framebuffer_device_put_rect(framebuffer, 0, area_top, converted, width, height, decode.width - width, FRAMEBUFFER_TRANSFER_NONE);
+
+	free(converted);
+	free(pixels);
+
+	return ERROR_SUCCESS;
+}
+
+static void show_result(const TEST_IMAGE *image, const char *method, uint32_t status, int64_t elapsed, uint32_t memoryused)
+{
+	char text[256];
+
+	if (status != ERROR_SUCCESS)
+		snprintf(text, sizeof(text), "%-15s %-26s failed (Error %u)", image->name, method, (unsigned int)status);
+	else
+		snprintf(text, sizeof(text), "%-15s %-26s %9.2f %10u", image->name, method, (double)elapsed / 1000.0, (unsigned int)(memoryused / 1024));
+
+	console_window_write_ln(window, text);
+}
+
+static void run_benchmark(PNG_ULTIBO_CACHE *cache, const TEST_IMAGE *image)
+{
+	PNG_ULTIBO_OPTIONS options;
+	PNG_ULTIBO_IMAGE *cached;
+	uint32_t memoryused;
+	uint32_t status;
+	uint32_t count;
+	int64_t start;
+	int64_t elapsed;
+
+	/* Whole image decode and conversion */
+	memoryused = 0;
+	start = clock_microseconds();
+	status = run_baseline(image, &memoryused);
+	elapsed = clock_microseconds() - start;
+	show_result(image, "Full decode and convert", status, elapsed, memoryused);
+
+	/* Streaming decode at the natural size, clipped to the drawing area */
+	memset(&options, 0, sizeof(PNG_ULTIBO_OPTIONS));
+	options.clipleft = 0;
+	options.cliptop = area_top;
+	options.clipright = area_width;
+	options.clipbottom = area_top + area_height;
+	start = clock_microseconds();
+	status = png_ultibo_framebuffer_draw(framebuffer, image->filename, 0, area_top, &options);
+	elapsed = clock_microseconds() - start;
+	show_result(image, "Streaming draw", status, elapsed, options.memoryused);
+
+	/* Streaming decode scaled to the height of the drawing area */
+	options.height = area_height;
+	start = clock_microseconds();
+	status = png_ultibo_framebuffer_draw(framebuffer, image->filename, 0, area_top, &options);
+	elapsed = clock_microseconds() - start;
+	show_result(image, "Streaming draw scaled", status, elapsed, options.memoryused);
+
+	/* Decode into the cache, then draw from the cache */
+	memset(&options, 0, sizeof(PNG_ULTIBO_OPTIONS));
+	options.height = area_height;
+	start = clock_microseconds();
+	cached = png_ultibo_image_load(cache, image->filename, properties.format, &options);
+	elapsed = clock_microseconds() - start;
+	if (!cached)
+	{
+		show_result(image, "Cache load", ERROR_INVALID_DATA, 0, 0);
+		return;
+	}
+	show_result(image, "Cache load", ERROR_SUCCESS, elapsed, options.memoryused + (cached->pitch * cached->height));
+
+	start = clock_microseconds();
+	for (count = 0; count < CACHE_DRAWS; count++)
+		status = png_ultibo_image_draw(framebuffer, cached, 0, area_top);
+	elapsed = (clock_microseconds() - start) / CACHE_DRAWS;
+	show_result(image, "Cached draw", status, elapsed, 0);
+
+	png_ultibo_image_release(cache, cached);
+}
+
+int apimain(int argc, char **argv)
+{
+	PNG_ULTIBO_STATISTICS statistics;
+	PNG_ULTIBO_CACHE *cache;
+	uint32_t index;
+	char text[256];
+
+	/* Create a console window in the top half of the screen for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_TOP, TRUE);
+
+	console_window_write_ln(window, "PNG Decode advanced example");
+	console_window_write_ln(window, "");
+
+	framebuffer = framebuffer_device_get_default();
+	if (!framebuffer || framebuffer_device_get_properties(framebuffer, &properties) != ERROR_SUCCESS)
+	{
+		console_window_write_ln(window, "No framebuffer device available");
+		thread_halt(0);
+	}
+
+	area_top = properties.physicalheight / 2;
+	area_width = properties.physicalwidth;
+	area_height = properties.physicalheight - area_top;
+
+	if (png_ultibo_format_bytes(properties.format) == 0)
+	{
+		console_window_write_ln(window, "The framebuffer color format is not supported");
+		thread_halt(0);
+	}
+
+	/* Wait for the system to settle and drive C:\ to become available */
+	sleep(5);
+
+	if (!DirectoryExists("C:\\"))
+	{
+		console_window_write_ln(window, "Drive C:\\ not available, the test images cannot be created");
+		thread_halt(0);
+	}
+
+	for (index = 0; index < IMAGE_COUNT; index++)
+	{
+		if (FileExists(images[index].filename))
+			continue;
+
+		snprintf(text, sizeof(text), "Creating %s", images[index].filename);
+		console_window_write_ln(window, text);
+
+		if (!image_create(&images[index]))
+		{
+			console_window_write_ln(window, "Failed to create the test image");
+			thread_halt(0);
+		}
+	}
+
+	cache = png_ultibo_cache_create(0);
+	if (!cache)
+	{
+		console_window_write_ln(window, "Failed to create the PNG cache");
+		thread_halt(0);
+	}
+
+	console_window_write_ln(window, "");
+	console_window_write_ln(window, "Image           Method                           ms  Peak(KB)");
+
+	for (index = 0; index < IMAGE_COUNT; index++)
+		run_benchmark(cache, &images[index]);
+
+	png_ultibo_cache_get_statistics(cache, &statistics);
+
+	snprintf(text, sizeof(text), "Cache holds %u images in %u KB, %u hits, %u misses, %u evicted",
+	 (unsigned int)statistics.imagecount,
+	 (unsigned int)(statistics.memoryused / 1024),
+	 (unsigned int)statistics.hitcount,
+	 (unsigned int)statistics.misscount,
+	 (unsigned int)statistics.evictcount);
+	console_window_write_ln(window, "");
+	console_window_write_ln(window, text);
+
+	png_ultibo_cache_destroy(cache);
+
+	console_window_write_ln(window, "");
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
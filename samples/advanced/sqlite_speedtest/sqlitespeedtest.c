@@ -0,0 +1,631 @@
+/*
+ *
+ * SQLite Speedtest advanced example project for Ultibo API
+ *
+ * This example runs a set of tests modelled on the SQLite speedtest1 program
+ * using the Ultibo VFS port for SQLite (libs/sqlite3/sqlite3_port_ultibo.c).
+ *
+ * A RAM backed storage device is created and registered, a storage VFS places
+ * the database directly on its blocks with no filesystem in between, and the
+ * tests are run first in rollback journal mode and then in WAL mode. If drive
+ * C:\ is available the same tests are also run on a file, once with the VFS that
+ * SQLite was started with and once with the Ultibo file VFS.
+ *
+ * The time taken by each test and the I/O counts of each VFS are shown in a
+ * console window.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/filesystem.h"
+#include "ultibo/storage.h"
+
+#include "sqlite3.h"
+#include "sqlite3_port_ultibo.h"
+
+/* Number of rows in the main table (speedtest1 uses 1000 times --size) */
+#define ROW_COUNT 10000
+
+/* Size of the RAM storage device (Bytes) */
+#define RAM_DISK_SIZE SIZE_64M
+
+/* First block of the database region on the RAM storage device */
+#define RAM_DISK_START 2048
+
+/* Name of the storage VFS */
+#define RAM_VFS_NAME "ramdisk"
+
+/* Database file for the file tests */
+#define DATABASE_FILE "C:\\speedtest.db"
+
+/* Speedtest */
+typedef struct
+{
+	uint32_t id;
+	const char *name;
+	int (*run)(sqlite3 *db);
+} SPEEDTEST;
+
+static uint8_t *ram_disk;
+static uint32_t random_state;
+
+static WINDOW_HANDLE window;
+
+static uint32_t STDCALL ram_disk_read(STORAGE_DEVICE *storage, int64_t start, int64_t count, void *buffer)
+{
+	if (start < 0 || start + count > storage->blockcount)
+		return ERROR_INVALID_PARAMETER;
+
+	memcpy(buffer, ram_disk + (start << storage->blockshift), count << storage->blockshift);
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL ram_disk_write(STORAGE_DEVICE *storage, int64_t start, int64_t count, void *buffer)
+{
+	if (start < 0 || start + count > storage->blockcount)
+		return ERROR_INVALID_PARAMETER;
+
+	memcpy(ram_disk + (start << storage->blockshift), buffer, count << storage->blockshift);
+
+	return ERROR_SUCCESS;
+}
+
+static STORAGE_DEVICE *ram_disk_create(void)
+{
+	STORAGE_DEVICE *storage;
+
+	ram_disk = calloc(1, RAM_DISK_SIZE);
+	if (!ram_disk)
+		return NULL;
+
+	storage = storage_device_create();
+	if (!storage)
+		return NULL;
+
+	storage->device.devicebus = DEVICE_BUS_NONE;
+	storage->device.devicetype = STORAGE_TYPE_HDD;
+	storage->device.deviceflags = STORAGE_FLAG_NONE;
+	strncpy(storage->device.devicedescription, "SQLite Speedtest RAM Disk", DEVICE_DESC_LENGTH - 1);
+	storage->deviceread = ram_disk_read;
+	storage->devicewrite = ram_disk_write;
+	storage->blocksize = 512;
+	storage->blockshift = 9;
+	storage->blockcount = RAM_DISK_SIZE / 512;
+
+	if (storage_device_register(storage) != ERROR_SUCCESS)
+	{
+		storage_device_destroy(storage);
+		return NULL;
+	}
+
+	storage_device_set_state(storage, STORAGE_STATE_INSERTED);
+
+	return storage;
+}
+
+static uint32_t random_next(void)
+{
+	random_state = (random_state * 1103515245) + 12345;
+
+	return random_state >> 1;
+}
+
+/* Spell out a number in words like speedtest1 so the text columns vary in length */
+static void number_name(uint32_t value, char *text, size_t len)
+{
+	static const char *ones[] = {"zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine", "ten", "eleven", "twelve", "thirteen", "fourteen", "fifteen", "sixteen", "seventeen", "eighteen", "nineteen"};
+	static const char *tens[] = {"", "ten", "twenty", "thirty", "forty", "fifty", "sixty", "seventy", "eighty", "ninety"};
+	size_t used = 0;
+
+	text[0] = '\0';
+
+	if (value >= 1000000000)
+	{
+		number_name(value / 1000000000, text, len);
+		used = strlen(text);
+		used += snprintf(text + used, len - used, " billion");
+		value %= 1000000000;
+	}
+	if (value >= 1000000 && used < len)
+	{
+		number_name(value / 1000000, text + used, len - used);
+		used = strlen(text);
+		used += snprintf(text + used, len - used, " million");
+		value %= 1000000;
+	}
+	if (value >= 1000 && used < len)
+	{
+		number_name(value / 1000, text + used, len - used);
+		used = strlen(text);
+		used += snprintf(text + used, len - used, " thousand");
+		value %= 1000;
+	}
+	if (value >= 100 && used < len)
+	{
+		used += snprintf(text + used, len - used, "%s%s hundred", used ? " " : "", ones[value / 100]);
+		value %= 100;
+	}
+	if (value >= 20 && used < len)
+	{
+		used += snprintf(text + used, len - used, "%s%s", used ? " " : "", tens[value / 10]);
+		value %= 10;
+	}
+	if ((value > 0 || used == 0) && used < len)
+		snprintf(text + used, len - used, "%s%s", used ? " " : "", ones[value]);
+}
+
+static int exec_sql(sqlite3 *db, const char *sql)
+{
+	return sqlite3_exec(db, sql, NULL, NULL, NULL);
+}
+
+/* Run a prepared statement to completion */
+static int step_all(sqlite3_stmt *statement)
+{
+	int result;
+
+	while ((result = sqlite3_step(statement)) == SQLITE_ROW)
+		;
+
+	sqlite3_reset(statement);
+
+	return (result == SQLITE_DONE) ? SQLITE_OK : result;
+}
+
+static int test_insert_unindexed(sqlite3 *db)
+{
+	sqlite3_stmt *statement;
+	uint32_t count;
+	uint32_t value;
+	char text[200];
+	int result;
+
+	exec_sql(db, "CREATE TABLE t1(a INTEGER, b INTEGER, c TEXT)");
+
+	result = sqlite3_prepare_v2(db, "INSERT INTO t1 VALUES(?1, ?2, ?3)", -1, &statement, NULL);
+	if (result != SQLITE_OK)
+		return result;
+
+	exec_sql(db, "BEGIN");
+	for (count = 1; count <= ROW_COUNT && result == SQLITE_OK; count++)
+	{
+		value = random_next() % (ROW_COUNT * 2);
+		number_name(value, text, sizeof(text));
+
+		sqlite3_bind_int64(statement, 1, value);
+		sqlite3_bind_int(statement, 2, count);
+		sqlite3_bind_text(statement, 3, text, -1, SQLITE_STATIC);
+		result = step_all(statement);
+	}
+	sqlite3_finalize(statement);
+
+	if (result != SQLITE_OK)
+	{
+		exec_sql(db, "ROLLBACK");
+		return result;
+	}
+
+	return exec_sql(db, "COMMIT");
+}
+
+static int test_insert_ordered(sqlite3 *db)
+{
+	sqlite3_stmt *statement;
+	uint32_t count;
+	char text[200];
+	int result;
+
+	exec_sql(db, "CREATE TABLE t2(a INTEGER PRIMARY KEY, b INTEGER, c TEXT)");
+
+	result = sqlite3_prepare_v2(db, "INSERT INTO t2 VALUES(?1, ?2, ?3)", -1, &statement, NULL);
+	if (result != SQLITE_OK)
+		return result;
+
+	exec_sql(db, "BEGIN");
+	for (count = 1; count <= ROW_COUNT && result == SQLITE_OK; count++)
+	{
+		number_name(count, text, sizeof(text));
+
+		sqlite3_bind_int(statement, 1, count);
+		sqlite3_bind_int64(statement, 2, random_next() % (ROW_COUNT * 2));
+		sqlite3_bind_text(statement, 3, text, -1, SQLITE_STATIC);
+		result = step_all(statement);
+	}
+	sqlite3_finalize(statement);
+
+	if (result != SQLITE_OK)
+	{
+		exec_sql(db, "ROLLBACK");
+		return result;
+	}
+
+	return exec_sql(db, "COMMIT");
+}
+
+static int test_insert_indexed(sqlite3 *db)
+{
+	sqlite3_stmt *statement;
+	uint32_t count;
+	uint32_t value;
+	char text[200];
+	int result;
+
+	exec_sql(db, "CREATE TABLE t3(a INTEGER, b INTEGER, c TEXT); CREATE INDEX t3c ON t3(c)");
+
+	result = sqlite3_prepare_v2(db, "INSERT INTO t3 VALUES(?1, ?2, ?3)", -1, &statement, NULL);
+	if (result != SQLITE_OK)
+		return result;
+
+	exec_sql(db, "BEGIN");
+	for (count = 1; count <= ROW_COUNT && result == SQLITE_OK; count++)
+	{
+		value = random_next() % (ROW_COUNT * 2);
+		number_name(value, text, sizeof(text));
+
+		sqlite3_bind_int(statement, 1, count);
+		sqlite3_bind_int64(statement, 2, value);
+		sqlite3_bind_text(statement, 3, text, -1, SQLITE_STATIC);
+		result = step_all(statement);
+	}
+	sqlite3_finalize(statement);
+
+	if (result != SQLITE_OK)
+	{
+		exec_sql(db, "ROLLBACK");
+		return result;
+	}
+
+	return exec_sql(db, "COMMIT");
+}
+
+static int test_select_between(sqlite3 *db, const char *sql, uint32_t queries)
+{
+	sqlite3_stmt *statement;
+	uint32_t count;
+	uint32_t value;
+	int result;
+
+	result = sqlite3_prepare_v2(db, sql, -1, &statement, NULL);
+	if (result != SQLITE_OK)
+		return result;
+
+	exec_sql(db, "BEGIN");
+	for (count = 0; count < queries && result == SQLITE_OK; count++)
+	{
+		value = random_next() % (ROW_COUNT * 2);
+
+		sqlite3_bind_int64(statement, 1, value);
+		sqlite3_bind_int64(statement, 2, value + (ROW_COUNT / 10));
+		result = step_all(statement);
+	}
+	sqlite3_finalize(statement);
+
+	exec_sql(db, "COMMIT");
+
+	return result;
+}
+
+static int test_select_unindexed(sqlite3 *db)
+{
+	return test_select_between(db, "SELECT count(*), avg(b), sum(length(c)) FROM t1 WHERE b BETWEEN ?1 AND ?2", ROW_COUNT / 100);
+}
+
+static int test_select_like(sqlite3 *db)
+{
+	sqlite3_stmt *statement;
+	uint32_t count;
+	char text[200];
+	char pattern[210];
+	int result;
+
+	result = sqlite3_prepare_v2(db, "SELECT count(*), avg(b), sum(length(c)) FROM t1 WHERE c LIKE ?1", -1, &statement, NULL);
+	if (result != SQLITE_OK)
+		return result;
+
+	exec_sql(db, "BEGIN");
+	for (count = 0; count < ROW_COUNT / 100 && result == SQLITE_OK; count++)
+	{
+		number_name(random_next() % 1000, text, sizeof(text));
+		snprintf(pattern, sizeof(pattern), "%%%s%%", text);
+
+		sqlite3_bind_text(statement, 1, pattern, -1, SQLITE_STATIC);
+		result = step_all(statement);
+	}
+	sqlite3_finalize(statement);
+
+	exec_sql(db, "COMMIT");
+
+	return result;
+}
+
+static int test_create_index(sqlite3 *db)
+{
+	return exec_sql(db, "BEGIN; CREATE UNIQUE INDEX t1b ON t1(b); CREATE INDEX t1c ON t1(c); CREATE UNIQUE INDEX t2b ON t2(b, a); COMMIT");
+}
+
+static int test_select_indexed(sqlite3 *db)
+{
+	return test_select_between(db, "SELECT count(*), avg(b), sum(length(c)) FROM t1 WHERE b BETWEEN ?1 AND ?2", ROW_COUNT / 5);
+}
+
+static int test_update_range(sqlite3 *db)
+{
+	sqlite3_stmt *statement;
+	uint32_t count;
+	uint32_t value;
+	int result;
+
+	result = sqlite3_prepare_v2(db, "UPDATE t2 SET b = b * 2 WHERE a BETWEEN ?1 AND ?2", -1, &statement, NULL);
+	if (result != SQLITE_OK)
+		return result;
+
+	exec_sql(db, "BEGIN");
+	for (count = 0; count < ROW_COUNT / 20 && result == SQLITE_OK; count++)
+	{
+		value = random_next() % ROW_COUNT;
+
+		sqlite3_bind_int64(statement, 1, value);
+		sqlite3_bind_int64(statement, 2, value + 10);
+		result = step_all(statement);
+	}
+	sqlite3_finalize(statement);
+
+	if (result != SQLITE_OK)
+	{
+		exec_sql(db, "ROLLBACK");
+		return result;
+	}
+
+	return exec_sql(db, "COMMIT");
+}
+
+static int test_update_rows(sqlite3 *db)
+{
+	sqlite3_stmt *statement;
+	uint32_t count;
+	char text[200];
+	int result;
+
+	result = sqlite3_prepare_v2(db, "UPDATE t2 SET c = ?1 WHERE a = ?2", -1, &statement, NULL);
+	if (result != SQLITE_OK)
+		return result;
+
+	exec_sql(db, "BEGIN");
+	for (count = 0; count < ROW_COUNT && result == SQLITE_OK; count++)
+	{
+		number_name(random_next() % (ROW_COUNT * 10), text, sizeof(text));
+
+		sqlite3_bind_text(statement, 1, text, -1, SQLITE_STATIC);
+		sqlite3_bind_int64(statement, 2, (random_next() % ROW_COUNT) + 1);
+		result = step_all(statement);
+	}
+	sqlite3_finalize(statement);
+
+	if (result != SQLITE_OK)
+	{
+		exec_sql(db, "ROLLBACK");
+		return result;
+	}
+
+	return exec_sql(db, "COMMIT");
+}
+
+static int test_delete_refill(sqlite3 *db)
+{
+	return exec_sql(db, "BEGIN; DELETE FROM t3 WHERE a % 3 = 0; INSERT INTO t3 SELECT a + 1000000, b, c FROM t3 WHERE a % 3 = 1; COMMIT");
+}
+
+static int test_small_transactions(sqlite3 *db)
+{
+	sqlite3_stmt *statement;
+	uint32_t count;
+	int result;
+
+	/* One commit per row, the cost is dominated by journal writes and syncs */
+	result = sqlite3_prepare_v2(db, "INSERT INTO t2(b, c) VALUES(?1, 'small transaction')", -1, &statement, NULL);
+	if (result != SQLITE_OK)
+		return result;
+
+	for (count = 0; count < ROW_COUNT / 20 && result == SQLITE_OK; count++)
+	{
+		sqlite3_bind_int64(statement, 1, random_next());
+		result = step_all(statement);
+	}
+	sqlite3_finalize(statement);
+
+	return result;
+}
+
+static const SPEEDTEST speedtests[] =
+{
+	{100, "INSERTs into table with no index", test_insert_unindexed},
+	{110, "Ordered INSERTs with INTEGER PRIMARY KEY", test_insert_ordered},
+	{120, "Unordered INSERTs with one index", test_insert_indexed},
+	{130, "SELECTs, numeric BETWEEN, unindexed", test_select_unindexed},
+	{140, "SELECTs, LIKE, unindexed", test_select_like},
+	{150, "CREATE INDEX three times", test_create_index},
+	{160, "SELECTs, numeric BETWEEN, indexed", test_select_indexed},
+	{170, "UPDATEs, numeric BETWEEN, indexed", test_update_range},
+	{180, "UPDATEs of individual rows", test_update_rows},
+	{190, "DELETE and REFILL one third", test_delete_refill},
+	{200, "Single row transactions", test_small_transactions}
+};
+
+static void run_speedtests(const char *title, const char *filename, const char *vfsname, const char *journalmode)
+{
+	sqlite3 *db;
+	uint32_t index;
+	int64_t start;
+	int64_t elapsed;
+	int64_t total;
+	int result;
+	char sql[64];
+	char text[256];
+
+	snprintf(text, sizeof(text), "%s (journal_mode=%s)", title, journalmode);
+	console_window_write_ln(window, text);
+
+	result = sqlite3_open_v2(filename, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, vfsname);
+	if (result != SQLITE_OK)
+	{
+		snprintf(text, sizeof(text), " Open failed (%s)", sqlite3_errstr(result));
+		console_window_write_ln(window, text);
+		sqlite3_close(db);
+		return;
+	}
+
+	snprintf(sql, sizeof(sql), "PRAGMA journal_mode=%s", journalmode);
+	exec_sql(db, sql);
+	exec_sql(db, "PRAGMA page_size=4096; PRAGMA cache_size=500");
+
+	random_state = 1;
+	total = 0;
+	for (index = 0; index < sizeof(speedtests) / sizeof(speedtests[0]); index++)
+	{
+		start = clock_microseconds();
+		result = speedtests[index].run(db);
+		elapsed = clock_microseconds() - start;
+		total += elapsed;
+
+		if (result == SQLITE_OK)
+			snprintf(text, sizeof(text), " %3u - %-42s %8.3fs", (unsigned int)speedtests[index].id, speedtests[index].name, elapsed / 1000000.0);
+		else
+			snprintf(text, sizeof(text), " %3u - %-42s failed (%s)", (unsigned int)speedtests[index].id, speedtests[index].name, sqlite3_errstr(result));
+		console_window_write_ln(window, text);
+	}
+
+	snprintf(text, sizeof(text), "       %-42s %8.3fs", "TOTAL", total / 1000000.0);
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	sqlite3_close(db);
+}
+
+static void show_statistics(const char *vfsname)
+{
+	SQLITE3_ULTIBO_STATISTICS statistics;
+	char text[256];
+
+	if (sqlite3_ultibo_get_statistics(vfsname, &statistics) != ERROR_SUCCESS)
+		return;
+
+	snprintf(text, sizeof(text), "VFS %s: reads %u (%llu bytes) writes %u (%llu bytes) syncs %u seeks %u partial blocks %u", vfsname, (unsigned int)statistics.readcount, (unsigned long long)statistics.readbytes, (unsigned int)statistics.writecount, (unsigned long long)statistics.writebytes, (unsigned int)statistics.synccount, (unsigned int)statistics.seekcount, (unsigned int)statistics.partialcount);
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+}
+
+int apimain(int argc, char **argv)
+{
+	STORAGE_DEVICE *storage;
+	sqlite3_vfs *original;
+	uint32_t status;
+	char text[256];
+
+	/* Create a console window for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "SQLite Speedtest advanced example");
+	console_window_write_ln(window, "");
+
+	/* Wait for the system to settle and drive C:\ to become available */
+	sleep(5);
+
+	snprintf(text, sizeof(text), "SQLite %s, %u rows", sqlite3_libversion(), (unsigned int)ROW_COUNT);
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	/* Remember the VFS SQLite started with before registering the Ultibo VFS */
+	sqlite3_initialize();
+	original = sqlite3_vfs_find(NULL);
+
+	status = sqlite3_ultibo_register(FALSE);
+	if (status != ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), "Failed to register the Ultibo VFS (Status %u)", (unsigned int)status);
+		console_window_write_ln(window, text);
+		thread_halt(0);
+	}
+
+	/* Database directly on the blocks of a RAM disk */
+	storage = ram_disk_create();
+	if (!storage)
+	{
+		console_window_write_ln(window, "Failed to create the RAM storage device");
+		thread_halt(0);
+	}
+
+	status = sqlite3_ultibo_storage_register(RAM_VFS_NAME, storage, RAM_DISK_START, storage->blockcount - RAM_DISK_START, SIZE_16M, SQLITE3_ULTIBO_STORAGE_FLAG_FORMAT, FALSE);
+	if (status != ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), "Failed to register the storage VFS (Status %u)", (unsigned int)status);
+		console_window_write_ln(window, text);
+		thread_halt(0);
+	}
+
+	run_speedtests("RAM storage device", "speedtest.db", RAM_VFS_NAME, "delete");
+	show_statistics(RAM_VFS_NAME);
+
+	/* Start again with an empty database for WAL mode */
+	sqlite3_ultibo_storage_unregister(RAM_VFS_NAME);
+	sqlite3_ultibo_storage_register(RAM_VFS_NAME, storage, RAM_DISK_START, storage->blockcount - RAM_DISK_START, SIZE_16M, SQLITE3_ULTIBO_STORAGE_FLAG_FORMAT, FALSE);
+
+	run_speedtests("RAM storage device", "speedtest.db", RAM_VFS_NAME, "wal");
+	show_statistics(RAM_VFS_NAME);
+
+	/* Compare the original VFS and the Ultibo file VFS on drive C:\ */
+	if (DirectoryExists("C:\\"))
+	{
+		if (original)
+		{
+			DeleteFile(DATABASE_FILE);
+			snprintf(text, sizeof(text), "File with the %s VFS", original->zName);
+			run_speedtests(text, DATABASE_FILE, original->zName, "delete");
+		}
+
+		DeleteFile(DATABASE_FILE);
+		run_speedtests("File with the Ultibo VFS", DATABASE_FILE, SQLITE3_ULTIBO_VFS_NAME, "delete");
+		show_statistics(SQLITE3_ULTIBO_VFS_NAME);
+
+		DeleteFile(DATABASE_FILE);
+	}
+
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
@@ -0,0 +1,339 @@
+/*
+ *
+ * Timer Wheel advanced example project for Ultibo API
+ *
+ * This example compares the kernel timers (timer_create_ex, timer_enable_ex and
+ * timer_disable) with the hierarchical timer wheel (src/threads/timerwheel.c)
+ * for the pattern used by network protocols, a large number of retransmit and
+ * keepalive timers that are armed and cancelled far more often than they expire.
+ *
+ * For each implementation it measures the rate of arming TIMER_COUNT timers,
+ * rearming them with new intervals and cancelling them, then it lets a smaller
+ * set of short timers expire and measures how late each event was. The wheel is
+ * measured again with slack to show the effect of coalescing on the number of
+ * expiry batches.
+ *
+ * The results are shown in a console window.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/timerwheel.h"
+
+/* Number of timers for the arm, rearm and cancel tests */
+#define TIMER_COUNT 20000
+
+/* Number of times every timer is rearmed */
+#define REARM_ROUNDS 5
+
+/* Number of timers for the expiry test and the range of their intervals (Milliseconds) */
+#define EXPIRE_COUNT 1000
+#define EXPIRE_MIN 10
+#define EXPIRE_RANGE 500
+
+/* Slack for the second wheel expiry test (Milliseconds) */
+#define EXPIRE_SLACK 8
+
+/* Timer implementation under test */
+typedef struct
+{
+	const char *name;
+	HANDLE (*create)(uint32_t interval, timer_event_proc event, void *data);
+	uint32_t (*enable)(HANDLE timer, uint32_t interval, timer_event_proc event, void *data);
+	uint32_t (*disable)(HANDLE timer);
+	uint32_t (*destroy)(HANDLE timer);
+	uint32_t slack;
+} TIMER_OPS;
+
+/* Expiry record for one timer */
+typedef struct
+{
+	int64_t due; // Time the event should occur (Milliseconds)
+	int64_t actual; // Time the event occurred (Milliseconds, 0 if it has not)
+} EXPIRY;
+
+/* Kernel timers */
+static HANDLE kernel_create(uint32_t interval, timer_event_proc event, void *data)
+{
+	return timer_create_ex(interval, TIMER_STATE_DISABLED, TIMER_FLAG_NONE, event, data);
+}
+
+static uint32_t kernel_enable(HANDLE timer, uint32_t interval, timer_event_proc event, void *data)
+{
+	return timer_enable_ex(timer, interval, event, data);
+}
+
+static uint32_t kernel_disable(HANDLE timer)
+{
+	return timer_disable(timer);
+}
+
+static uint32_t kernel_destroy(HANDLE timer)
+{
+	return timer_destroy(timer);
+}
+
+/* Timer wheel timers */
+static uint32_t wheel_slack;
+
+static HANDLE wheel_create(uint32_t interval, timer_event_proc event, void *data)
+{
+	TIMER_WHEEL_TIMER *timer;
+
+	timer = timer_wheel_create_ex(interval, TIMER_STATE_DISABLED, TIMER_FLAG_NONE, event, data);
+	if (!timer)
+		return INVALID_HANDLE_VALUE;
+
+	timer_wheel_set_slack(timer, wheel_slack);
+
+	return (HANDLE)timer;
+}
+
+static uint32_t wheel_enable(HANDLE timer, uint32_t interval, timer_event_proc event, void *data)
+{
+	return timer_wheel_enable_ex((TIMER_WHEEL_TIMER *)timer, interval, event, data);
+}
+
+static uint32_t wheel_disable(HANDLE timer)
+{
+	return timer_wheel_disable((TIMER_WHEEL_TIMER *)timer);
+}
+
+static uint32_t wheel_destroy(HANDLE timer)
+{
+	return timer_wheel_destroy((TIMER_WHEEL_TIMER *)timer);
+}
+
+static const TIMER_OPS kernel_ops = {"Kernel", kernel_create, kernel_enable, kernel_disable, kernel_destroy, 0};
+static const TIMER_OPS wheel_ops = {"Wheel", wheel_create, wheel_enable, wheel_disable, wheel_destroy, 0};
+static const TIMER_OPS wheel_slack_ops = {"Wheel+slack", wheel_create, wheel_enable, wheel_disable, wheel_destroy, EXPIRE_SLACK};
+
+static void STDCALL idle_event(void *data)
+{
+}
+
+static void STDCALL expiry_event(void *data)
+{
+	EXPIRY *expiry = (EXPIRY *)data;
+
+	expiry->actual = clock_milliseconds();
+}
+
+/* Return the rate in operations per second for count operations since start (Microseconds) */
+static double rate(uint32_t count, int64_t start)
+{
+	int64_t elapsed = clock_microseconds() - start;
+
+	if (elapsed <= 0)
+		elapsed = 1;
+
+	return ((double)count * 1000000.0) / elapsed;
+}
+
+/* Arm, rearm and cancel TIMER_COUNT timers with intervals long enough that none expire */
+static void run_churn(WINDOW_HANDLE window, const TIMER_OPS *ops)
+{
+	HANDLE *timers;
+	double armrate;
+	double rearmrate;
+	double cancelrate;
+	int64_t start;
+	uint32_t count;
+	uint32_t round;
+	uint32_t index;
+	char text[256];
+
+	timers = malloc(TIMER_COUNT * sizeof(HANDLE));
+	if (!timers)
+		return;
+
+	wheel_slack = ops->slack;
+
+	for (count = 0; count < TIMER_COUNT; count++)
+	{
+		timers[count] = ops->create(1000, idle_event, NULL);
+		if (timers[count] == INVALID_HANDLE_VALUE)
+			break;
+	}
+
+	/* Retransmit and keepalive range, 60 to 120 seconds */
+	srand(1);
+
+	start = clock_microseconds();
+	for (index = 0; index < count; index++)
+		ops->enable(timers[index], 60000 + (rand() % 60000), idle_event, NULL);
+	armrate = rate(count, start);
+
+	start = clock_microseconds();
+	for (round = 0; round < REARM_ROUNDS; round++)
+	{
+		for (index = 0; index < count; index++)
+		{
+			ops->disable(timers[index]);
+			ops->enable(timers[index], 60000 + (rand() % 60000), idle_event, NULL);
+		}
+	}
+	rearmrate = rate(count * REARM_ROUNDS, start);
+
+	start = clock_microseconds();
+	for (index = 0; index < count; index++)
+		ops->disable(timers[index]);
+	cancelrate = rate(count, start);
+
+	for (index = 0; index < count; index++)
+		ops->destroy(timers[index]);
+
+	free(timers);
+
+	snprintf(text, sizeof(text), "%-11s %u timers: arm %.0f/s rearm %.0f/s cancel %.0f/s", ops->name, (unsigned int)count, armrate, rearmrate, cancelrate);
+	console_window_write_ln(window, text);
+}
+
+/* Let EXPIRE_COUNT short timers expire and report how late the events were */
+static void run_expire(WINDOW_HANDLE window, const TIMER_OPS *ops)
+{
+	TIMER_WHEEL_STATISTICS before;
+	TIMER_WHEEL_STATISTICS after;
+	HANDLE *timers;
+	EXPIRY *expiries;
+	uint32_t interval;
+	uint32_t missed;
+	uint32_t count;
+	uint32_t index;
+	int64_t late;
+	int64_t total;
+	int64_t worst;
+	int64_t now;
+	char text[256];
+
+	timers = malloc(EXPIRE_COUNT * sizeof(HANDLE));
+	expiries = calloc(EXPIRE_COUNT, sizeof(EXPIRY));
+	if (!timers || !expiries)
+	{
+		free(timers);
+		free(expiries);
+		return;
+	}
+
+	wheel_slack = ops->slack;
+
+	for (count = 0; count < EXPIRE_COUNT; count++)
+	{
+		timers[count] = ops->create(1000, expiry_event, &expiries[count]);
+		if (timers[count] == INVALID_HANDLE_VALUE)
+			break;
+	}
+
+	timer_wheel_get_statistics(&before);
+
+	srand(2);
+	for (index = 0; index < count; index++)
+	{
+		interval = EXPIRE_MIN + (rand() % EXPIRE_RANGE);
+
+		now = clock_milliseconds();
+		expiries[index].due = now + interval;
+		ops->enable(timers[index], interval, expiry_event, &expiries[index]);
+	}
+
+	/* Wait for all events with a generous margin */
+	sleep(((EXPIRE_MIN + EXPIRE_RANGE) / 1000) + 2);
+
+	timer_wheel_get_statistics(&after);
+
+	missed = 0;
+	total = 0;
+	worst = 0;
+	for (index = 0; index < count; index++)
+	{
+		if (expiries[index].actual == 0)
+		{
+			missed++;
+			continue;
+		}
+
+		late = expiries[index].actual - expiries[index].due;
+		total += late;
+		if (late > worst)
+			worst = late;
+	}
+
+	for (index = 0; index < count; index++)
+		ops->destroy(timers[index]);
+
+	snprintf(text, sizeof(text), "%-11s %u timers: average late %.2f ms, worst %d ms, missed %u", ops->name, (unsigned int)count, (count > missed) ? (double)total / (count - missed) : 0.0, (int)worst, (unsigned int)missed);
+	console_window_write_ln(window, text);
+
+	if (ops->destroy == wheel_destroy)
+	{
+		snprintf(text, sizeof(text), "            batches %u (largest %u) cascades %u", (unsigned int)(after.batchcount - before.batchcount), (unsigned int)after.batchmax, (unsigned int)(after.cascadecount - before.cascadecount));
+		console_window_write_ln(window, text);
+	}
+
+	free(timers);
+	free(expiries);
+}
+
+int apimain(int argc, char **argv)
+{
+	WINDOW_HANDLE window;
+
+	/* Create a console window for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "Timer Wheel advanced example");
+	console_window_write_ln(window, "");
+
+	/* Wait a moment for the system to settle */
+	sleep(2);
+
+	console_window_write_ln(window, "Arm, rearm and cancel");
+	run_churn(window, &kernel_ops);
+	run_churn(window, &wheel_ops);
+	console_window_write_ln(window, "");
+
+	console_window_write_ln(window, "Expiry");
+	run_expire(window, &kernel_ops);
+	run_expire(window, &wheel_ops);
+	run_expire(window, &wheel_slack_ops);
+	console_window_write_ln(window, "");
+
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
@@ -0,0 +1,562 @@
+/*
+ *
+ * Timezone Cache advanced example project for Ultibo API
+ *
+ * Checks the timezone cache against the RTL at and around every transition of a
+ * set of built in timezones and at random dates, then measures the time of each
+ * local time conversion with and without the cache for a logger style sequence.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/benchmark.h"
+#include "ultibo/timezone.h"
+#include "ultibo/ultibo.h"
+
+/* File for the JSON results */
+#define RESULTS_FILE "C:\\timezonecache.json"
+
+/* Years checked around each transition by the self test */
+#define FIRST_YEAR 2000
+#define LAST_YEAR 2050
+
+/* Number of random dates checked for each timezone */
+#define RANDOM_DATES 2000
+
+/* Step between the times converted by each benchmark iteration, as a logger timestamping records would */
+#define TIME_STEP (TIME_TICKS_PER_MILLISECOND * 7)
+
+/* Test kinds */
+#define TEST_ACTIVE_BIAS 0
+#define TEST_STATE 1
+#define TEST_ACTIVE_OFFSET 2
+#define TEST_FILE_TIME_TO_LOCAL 3
+#define TEST_SYSTEM_TIME_TO_LOCAL 4
+
+#define TEST_KIND_COUNT 5
+
+#define MAX_TESTS (TEST_KIND_COUNT * 2)
+
+/* Test parameters, one per benchmark */
+typedef struct
+{
+	uint32_t kind;
+	BOOL cached; // Use the cache functions instead of the RTL functions
+} TEST_PARAMETER;
+
+/* Test data, allocated by setup */
+typedef struct
+{
+	const TEST_PARAMETER *parameter;
+	TIMEZONE_ENTRY *timezone;
+	int64_t time; // UTC time of the next conversion (100 nanosecond ticks since 1/1/1601)
+	double_t datetime; // Local date and time of the next lookup
+	volatile int32_t result;
+	FILETIME filetime;
+	SYSTEMTIME systemtime;
+} TEST_DATA;
+
+/* Timezones with northern, southern and no daylight saving (Names as built into the RTL) */
+static const char *timezone_names[] = {"Central Standard Time", "GMT Standard Time", "W. Europe Standard Time", "AUS Eastern Standard Time", "New Zealand Standard Time", "India Standard Time", "Tokyo Standard Time"};
+
+#define TIMEZONE_COUNT (sizeof(timezone_names) / sizeof(timezone_names[0]))
+
+/* Offsets either side of each transition (Seconds) */
+static const double edge_offsets[] = {0, 0.001, 1, 59, 60, 61, 1799, 3599, 3600, 3601, 7200, 86400};
+
+#define EDGE_COUNT (sizeof(edge_offsets) / sizeof(edge_offsets[0]))
+
+static const char *test_names[] = {"active_bias", "state", "active_offset", "file_time_to_local", "system_time_to_local"};
+
+static TEST_PARAMETER parameters[MAX_TESTS];
+static char names[MAX_TESTS][BENCHMARK_NAME_LENGTH];
+static BENCHMARK tests[MAX_TESTS];
+static BENCHMARK_RESULT results[MAX_TESTS];
+
+static WINDOW_HANDLE window;
+
+/* Self test counts */
+static uint32_t group_passed;
+static uint32_t group_count;
+static uint32_t total_passed;
+static uint32_t total_count;
+
+/* ============================================================================== */
+/* Self test of the cache against the RTL at and around each transition */
+static uint32_t random_next(void)
+{
+	static uint32_t seed = 0x2545F491;
+
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed;
+}
+
+static void group_begin(void)
+{
+	group_passed = 0;
+	group_count = 0;
+}
+
+static void group_end(const char *name)
+{
+	char text[128];
+
+	snprintf(text, sizeof(text), "%-28s %u of %u correct", name, (unsigned int)group_passed, (unsigned int)group_count);
+	console_window_write_ln(window, text);
+
+	total_passed += group_passed;
+	total_count += group_count;
+}
+
+static void check(const char *name, BOOL result, double_t datetime)
+{
+	char text[128];
+	char value[64];
+
+	group_count++;
+	if (result)
+	{
+		group_passed++;
+		return;
+	}
+
+	/* Show only the first few failures */
+	if (group_count - group_passed > 5)
+		return;
+
+	system_date_time_to_string(datetime, value, sizeof(value));
+	snprintf(text, sizeof(text), "%s incorrect at %s", name, value);
+	console_window_write_ln(window, text);
+}
+
+static double_t ticks_to_date_time(int64_t time)
+{
+	return (double_t)(time - TIME_TICKS_TO_1899) / TIME_TICKS_PER_DAY;
+}
+
+static int64_t date_time_to_ticks(double_t datetime)
+{
+	return ((int64_t)((datetime * PASCAL_TIME_MILLISECONDS_PER_DAY) + 0.5) * TIME_TICKS_PER_MILLISECOND) + TIME_TICKS_TO_1899;
+}
+
+/* Bias at a UTC time from SystemTimeToTzSpecificLocalTime with the rules of a timezone */
+static int32_t universal_bias(TIMEZONE_ENTRY *timezone, int64_t time)
+{
+	TIME_ZONE_INFORMATION information;
+	SYSTEMTIME universaltime;
+	SYSTEMTIME localtime;
+	FILETIME filetime;
+
+	memset(&information, 0, sizeof(TIME_ZONE_INFORMATION));
+	information.bias = timezone_get_bias(timezone);
+	information.standarddate = timezone_get_standard_start(timezone);
+	information.standardbias = timezone_get_standard_bias(timezone);
+	information.daylightdate = timezone_get_daylight_start(timezone);
+	information.daylightbias = timezone_get_daylight_bias(timezone);
+
+	/* System times hold whole milliseconds */
+	time -= time % TIME_TICKS_PER_MILLISECOND;
+
+	filetime.dwLowDateTime = (uint32_t)time;
+	filetime.dwHighDateTime = (uint32_t)(time >> 32);
+	FileTimeToSystemTime(&filetime, &universaltime);
+	SystemTimeToTzSpecificLocalTime(&information, &universaltime, &localtime);
+	SystemTimeToFileTime(&localtime, &filetime);
+
+	return (int32_t)((time - (int64_t)(((uint64_t)filetime.dwHighDateTime << 32) | filetime.dwLowDateTime)) / TIME_TICKS_PER_MINUTE);
+}
+
+static void check_local(TIMEZONE_ENTRY *timezone, double_t datetime)
+{
+	check("state", timezone_cache_get_state(timezone, datetime) == timezone_get_state_ex(timezone, datetime), datetime);
+	check("active_bias", timezone_cache_get_active_bias(timezone, datetime) == timezone_get_active_bias_ex(timezone, datetime), datetime);
+}
+
+static void check_universal(TIMEZONE_ENTRY *timezone, int64_t time)
+{
+	int32_t expected = universal_bias(timezone, time);
+
+	check("universal_bias", timezone_cache_get_universal_bias(timezone, time) == expected, ticks_to_date_time(time));
+	check("universal_to_local", timezone_cache_universal_to_local(timezone, time) == time - ((int64_t)expected * TIME_TICKS_PER_MINUTE), ticks_to_date_time(time));
+}
+
+static void test_timezone(TIMEZONE_ENTRY *timezone, const char *name)
+{
+	SYSTEMTIME daylightstart = timezone_get_daylight_start(timezone);
+	SYSTEMTIME standardstart = timezone_get_standard_start(timezone);
+	double_t boundaries[2];
+	double_t datetime;
+	int64_t bias[2];
+	int64_t time;
+	uint32_t year;
+	uint32_t index;
+	uint32_t edge;
+	int sign;
+
+	/* A transition happens in UTC when the local time under the bias before it reaches the rule */
+	bias[0] = (int64_t)(timezone_get_bias(timezone) + timezone_get_standard_bias(timezone)) * TIME_TICKS_PER_MINUTE;
+	bias[1] = (int64_t)(timezone_get_bias(timezone) + timezone_get_daylight_bias(timezone)) * TIME_TICKS_PER_MINUTE;
+
+	group_begin();
+	for (year = FIRST_YEAR; year <= LAST_YEAR; year++)
+	{
+		boundaries[0] = timezone_start_to_date_time(&daylightstart, year);
+		boundaries[1] = timezone_start_to_date_time(&standardstart, year);
+
+		for (index = 0; index < 2; index++)
+		{
+			if (boundaries[index] <= 0)
+				continue;
+
+			for (edge = 0; edge < EDGE_COUNT; edge++)
+			{
+				for (sign = -1; sign <= 1; sign += 2)
+				{
+					datetime = boundaries[index] + ((sign * edge_offsets[edge]) / PASCAL_TIME_SECONDS_PER_DAY);
+					check_local(timezone, datetime);
+
+					time = date_time_to_ticks(boundaries[index]) + bias[index] + (int64_t)(sign * edge_offsets[edge] * TIME_TICKS_PER_SECOND);
+					check_universal(timezone, time);
+				}
+			}
+		}
+	}
+
+	/* Random dates in 2000 to 2099, each far from the last so most of them rebuild the table */
+	for (index = 0; index < RANDOM_DATES; index++)
+	{
+		datetime = 36526.0 + ((random_next() % (PASCAL_TIME_SECONDS_PER_DAY * 36524U)) / (double_t)PASCAL_TIME_SECONDS_PER_DAY);
+		check_local(timezone, datetime);
+		check_universal(timezone, date_time_to_ticks(datetime));
+	}
+	group_end(name);
+}
+
+/* The current time conversions against the RTL for the default timezone */
+static void test_current(void)
+{
+	SYSTEMTIME universaltime;
+	SYSTEMTIME expected;
+	SYSTEMTIME actual;
+	FILETIME filetime;
+	FILETIME localexpected;
+	FILETIME localactual;
+	FILETIME universal;
+	double_t now;
+	uint32_t count;
+
+	group_begin();
+	for (count = 0; count < 100; count++)
+	{
+		GetSystemTimeAsFileTime(&filetime);
+		now = ticks_to_date_time((int64_t)(((uint64_t)filetime.dwHighDateTime << 32) | filetime.dwLowDateTime));
+
+		check("active_offset", timezone_cache_get_active_offset() == GetTimezoneActiveOffset(), now);
+
+		FileTimeToLocalFileTime(&filetime, &localexpected);
+		timezone_cache_file_time_to_local_file_time(&filetime, &localactual);
+		check("file_time_to_local", memcmp(&localexpected, &localactual, sizeof(FILETIME)) == 0, now);
+
+		timezone_cache_local_file_time_to_file_time(&localactual, &universal);
+		check("local_to_file_time", memcmp(&filetime, &universal, sizeof(FILETIME)) == 0, now);
+
+		FileTimeToSystemTime(&filetime, &universaltime);
+		SystemTimeToTzSpecificLocalTime(NULL, &universaltime, &expected);
+		timezone_cache_system_time_to_local_time(NULL, &universaltime, &actual);
+		check("system_time_to_local", memcmp(&expected, &actual, sizeof(SYSTEMTIME)) == 0, now);
+
+		thread_sleep(1);
+	}
+	group_end("Current time");
+}
+
+/* Change the rules of the default timezone, the cache must follow after timezone_cache_set_information */
+static void test_invalidate(void)
+{
+	TIME_ZONE_INFORMATION original;
+	TIME_ZONE_INFORMATION changed;
+	TIMEZONE_ENTRY *timezone = timezone_get_default();
+	double_t datetime;
+	uint32_t count;
+
+	if (!timezone || GetTimeZoneInformation(&original) == TIME_ZONE_ID_INVALID)
+		return;
+
+	group_begin();
+
+	/* Fill the cache, then move the daylight bias by 30 minutes */
+	for (count = 0; count < 100; count++)
+		timezone_cache_get_active_bias(timezone, 36526.0 + (count * 365.25));
+
+	changed = original;
+	changed.daylightbias -= 30;
+	timezone_cache_set_information(&changed);
+
+	for (count = 0; count < 1000; count++)
+	{
+		datetime = 36526.0 + ((random_next() % (PASCAL_TIME_SECONDS_PER_DAY * 18262U)) / (double_t)PASCAL_TIME_SECONDS_PER_DAY);
+		check("active_bias_changed", timezone_cache_get_active_bias(NULL, datetime) == timezone_get_active_bias_ex(timezone_get_default(), datetime), datetime);
+	}
+
+	timezone_cache_set_information(&original);
+
+	for (count = 0; count < 1000; count++)
+	{
+		datetime = 36526.0 + ((random_next() % (PASCAL_TIME_SECONDS_PER_DAY * 18262U)) / (double_t)PASCAL_TIME_SECONDS_PER_DAY);
+		check("active_bias_restored", timezone_cache_get_active_bias(NULL, datetime) == timezone_get_active_bias_ex(timezone_get_default(), datetime), datetime);
+	}
+	group_end("Invalidate");
+}
+
+static BOOL self_test(void)
+{
+	TIMEZONE_ENTRY *timezone;
+	char text[128];
+	uint32_t index;
+
+	console_window_write_ln(window, "Self test against the RTL");
+
+	total_passed = 0;
+	total_count = 0;
+
+	for (index = 0; index < TIMEZONE_COUNT; index++)
+	{
+		timezone = timezone_find(timezone_names[index]);
+		if (timezone)
+			test_timezone(timezone, timezone_names[index]);
+	}
+
+	test_current();
+	test_invalidate();
+
+	snprintf(text, sizeof(text), "Total %u of %u correct", (unsigned int)total_passed, (unsigned int)total_count);
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	return (total_passed == total_count);
+}
+
+/* ============================================================================== */
+/* Conversion benchmarks */
+static uint32_t STDCALL test_setup(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, void **data)
+{
+	const TEST_PARAMETER *parameter = (const TEST_PARAMETER *)benchmark->parameter;
+	TEST_DATA *test;
+	FILETIME filetime;
+
+	test = calloc(1, sizeof(TEST_DATA));
+	if (!test)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	test->parameter = parameter;
+	test->timezone = timezone_get_default();
+	if (!test->timezone)
+	{
+		free(test);
+		return ERROR_NOT_SUPPORTED;
+	}
+
+	GetSystemTimeAsFileTime(&filetime);
+	test->time = (int64_t)(((uint64_t)filetime.dwHighDateTime << 32) | filetime.dwLowDateTime);
+	test->datetime = ticks_to_date_time(test->time);
+
+	*data = test;
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL test_run(void *data, uint32_t iterations)
+{
+	TEST_DATA *test = (TEST_DATA *)data;
+	BOOL cached = test->parameter->cached;
+	FILETIME local;
+	uint32_t count;
+
+	for (count = 0; count < iterations; count++)
+	{
+		switch (test->parameter->kind)
+		{
+			case TEST_ACTIVE_BIAS:
+				if (cached)
+					test->result = timezone_cache_get_active_bias(test->timezone, test->datetime);
+				else
+					test->result = timezone_get_active_bias_ex(test->timezone, test->datetime);
+				test->datetime += (double_t)TIME_STEP / TIME_TICKS_PER_DAY;
+				break;
+			case TEST_STATE:
+				if (cached)
+					test->result = timezone_cache_get_state(test->timezone, test->datetime);
+				else
+					test->result = timezone_get_state_ex(test->timezone, test->datetime);
+				test->datetime += (double_t)TIME_STEP / TIME_TICKS_PER_DAY;
+				break;
+			case TEST_ACTIVE_OFFSET:
+				if (cached)
+					test->result = timezone_cache_get_active_offset();
+				else
+					test->result = GetTimezoneActiveOffset();
+				break;
+			case TEST_FILE_TIME_TO_LOCAL:
+				test->filetime.dwLowDateTime = (uint32_t)test->time;
+				test->filetime.dwHighDateTime = (uint32_t)(test->time >> 32);
+				if (cached)
+					test->result = timezone_cache_file_time_to_local_file_time(&test->filetime, &local);
+				else
+					test->result = FileTimeToLocalFileTime(&test->filetime, &local);
+				test->time += TIME_STEP;
+				break;
+			case TEST_SYSTEM_TIME_TO_LOCAL:
+				test->filetime.dwLowDateTime = (uint32_t)test->time;
+				test->filetime.dwHighDateTime = (uint32_t)(test->time >> 32);
+				FileTimeToSystemTime(&test->filetime, &test->systemtime);
+				if (cached)
+					test->result = timezone_cache_system_time_to_local_time(NULL, &test->systemtime, &test->systemtime);
+				else
+					test->result = SystemTimeToTzSpecificLocalTime(NULL, &test->systemtime, &test->systemtime);
+				test->time += TIME_STEP;
+				break;
+		}
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static void STDCALL test_teardown(void *data)
+{
+	free(data);
+}
+
+static void add_test(uint32_t *count, uint32_t kind, BOOL cached)
+{
+	TEST_PARAMETER *parameter = &parameters[*count];
+	BENCHMARK *test = &tests[*count];
+
+	parameter->kind = kind;
+	parameter->cached = cached;
+
+	snprintf(names[*count], BENCHMARK_NAME_LENGTH, "%s%s", test_names[kind], cached ? "_cache" : "_rtl");
+
+	test->name = names[*count];
+	test->group = BENCHMARK_GROUP_USER;
+	test->iterations = 0;
+	test->setup = test_setup;
+	test->run = test_run;
+	test->teardown = test_teardown;
+	test->parameter = parameter;
+
+	(*count)++;
+}
+
+int apimain(int argc, char **argv)
+{
+	BENCHMARK_CONFIG config;
+	uint32_t status;
+	uint32_t count;
+	uint32_t index;
+	char name[TIMEZONE_NAME_LENGTH];
+	char text[256];
+
+	/* Create a console window for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "Timezone Cache advanced example");
+	console_window_write_ln(window, "");
+
+	/* Wait for the system to settle and drive C:\ to become available */
+	sleep(5);
+
+	if (GetCurrentTimezone(name, sizeof(name)) == 0)
+		strcpy(name, "None");
+
+	snprintf(text, sizeof(text), "Default timezone: %s, active offset %d minutes", name, (int)GetTimezoneActiveOffset());
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	if (!self_test())
+	{
+		console_window_write_ln(window, "Self test failed, benchmarks not run");
+		thread_halt(0);
+	}
+
+	/* Each conversion with the RTL then with the cache */
+	count = 0;
+	for (index = 0; index < TEST_KIND_COUNT; index++)
+	{
+		add_test(&count, index, FALSE);
+		add_test(&count, index, TRUE);
+	}
+
+	/* Defaults for everything except the CPU and the number of repeats */
+	memset(&config, 0, sizeof(BENCHMARK_CONFIG));
+	config.cpu = CPU_ID_0;
+	config.repeats = 10;
+
+	console_window_write_ln(window, "Running, this may take a minute");
+	console_window_write_ln(window, "");
+
+	status = benchmark_run_list(tests, count, &config, results);
+	if (status != ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), "Benchmark failed (Status %u)", (unsigned int)status);
+		console_window_write_ln(window, text);
+		thread_halt(0);
+	}
+
+	for (index = 0; index < count; index++)
+	{
+		if (results[index].status == ERROR_NOT_SUPPORTED)
+			snprintf(text, sizeof(text), "%-28s skipped (No default timezone)", results[index].name);
+		else if (results[index].status != ERROR_SUCCESS)
+			snprintf(text, sizeof(text), "%-28s failed (Status %u)", results[index].name, (unsigned int)results[index].status);
+		else
+			snprintf(text, sizeof(text), "%-28s %10.1f ns", results[index].name, results[index].median);
+
+		console_window_write_ln(window, text);
+	}
+	console_window_write_ln(window, "");
+
+	if (benchmark_export_file(results, count, RESULTS_FILE) == ERROR_SUCCESS)
+		console_window_write_ln(window, "Results written to " RESULTS_FILE);
+
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
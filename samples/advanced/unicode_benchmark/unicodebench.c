@@ -0,0 +1,852 @@
+/*
+ *
+ * Unicode Benchmark advanced example project for Ultibo API
+ *
+ * Checks the Unicode fast paths against the RTL conversion functions using random
+ * valid and invalid text, once for each implementation available in this build,
+ * then measures the throughput in MB/s of the RTL, scalar and default versions.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/benchmark.h"
+#include "ultibo/locale.h"
+#include "ultibo/unicode.h"
+
+/* File for the JSON results */
+#define RESULTS_FILE "C:\\unicodebenchmark.json"
+
+/* Size of the UTF-8 text converted by each benchmark iteration (Bytes) */
+#define BUFFER_SIZE SIZE_16K
+
+/* Number of random strings checked by the self test for each implementation */
+#define SELF_TEST_ROUNDS 500
+
+/* Largest random string used by the self test (Characters) */
+#define SELF_TEST_LENGTH 600
+
+/* Test kinds */
+#define TEST_UTF8_TO_UTF16_HTML 0
+#define TEST_UTF8_TO_UTF16_MIXED 1
+#define TEST_UTF16_TO_UTF8_HTML 2
+#define TEST_UTF16_TO_UTF8_MIXED 3
+#define TEST_UTF8_VALIDATE_HTML 4
+#define TEST_UTF8_VALIDATE_MIXED 5
+#define TEST_CP1252_TO_UTF16 6
+#define TEST_UPPER_ANSI 7
+#define TEST_UPPER_WIDE 8
+
+#define TEST_KIND_COUNT 9
+
+/* Test paths */
+#define TEST_PATH_RTL 0 // The RTL function
+#define TEST_PATH_SCALAR 1 // The fast path function with UNICODE_IMPL_SCALAR
+#define TEST_PATH_DEFAULT 2 // The fast path function with the default implementation
+
+#define MAX_TESTS (TEST_KIND_COUNT * 3)
+
+/* Test parameters, one per benchmark */
+typedef struct
+{
+	uint32_t kind;
+	uint32_t path;
+	uint32_t implementation; // Fast path implementation to select while the test runs
+} TEST_PARAMETER;
+
+/* Test data, allocated by setup */
+typedef struct
+{
+	const TEST_PARAMETER *parameter;
+	const char *source; // UTF-8 or code page 1252 source
+	const WCHAR *sourcew; // UTF-16 source
+	int count; // Length of source or sourcew
+	char *dest;
+	WCHAR *destw;
+	volatile int result;
+} TEST_DATA;
+
+/* Benchmark names */
+static const char *test_names[] = {"utf8_to_utf16_html", "utf8_to_utf16_mixed", "utf16_to_utf8_html", "utf16_to_utf8_mixed", "utf8_validate_html", "utf8_validate_mixed",
+	"cp1252_to_utf16", "upper_ansi", "upper_wide"};
+static const char *path_names[] = {"_rtl", "_scalar", ""};
+
+/* Fragments of mostly ASCII markup and of mixed Latin, Greek, CJK and emoji text (UTF-8) */
+static const char *html_fragments[] = {
+	"<div class=\"entry\"><a href=\"/news/2025/05/index.html\">Latest news</a></div>\n",
+	"<p>The quick brown fox jumps over the lazy dog, 0123456789.</p>\n",
+	"<p>Caf\xC3\xA9 men\xC3\xBC: cr\xC3\xA8me br\xC3\xBBl\xC3\xA9" "e \xE2\x80\x94 \xE2\x82\xAC" "4.50</p>\n",
+	"<td style=\"text-align: right; padding: 2px 8px;\">42</td>\n",
+	"<li>\xE2\x80\x9CQuoted\xE2\x80\x9D text with \xC2\xA9 and \xC2\xAE marks</li>\n"};
+static const char *mixed_fragments[] = {
+	"\xCE\x91\xCE\xBB\xCF\x86\xCE\xAC\xCE\xB2\xCE\xB7\xCF\x84\xCE\xBF \xCE\xB5\xCE\xBB\xCE\xBB\xCE\xB7\xCE\xBD\xCE\xB9\xCE\xBA\xCF\x8C. ",
+	"\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87\xE7\xAB\xA0\xE3\x81\xA7\xE3\x81\x99\xE3\x80\x82",
+	"Stra\xC3\x9F" "e und Pl\xC3\xA4tze, ",
+	"\xF0\x9F\x98\x80\xF0\x9F\x8D\x95 ",
+	"\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82 \xD0\xBC\xD0\xB8\xD1\x80! "};
+
+/* Text shared by all benchmarks, built once before the benchmarks run */
+static char html_text[BUFFER_SIZE];
+static char mixed_text[BUFFER_SIZE];
+static char latin_text[BUFFER_SIZE];
+static WCHAR html_textw[BUFFER_SIZE];
+static WCHAR mixed_textw[BUFFER_SIZE];
+static WCHAR latin_textw[BUFFER_SIZE];
+static int html_length;
+static int mixed_length;
+static int latin_length;
+static int html_lengthw;
+static int mixed_lengthw;
+static int latin_lengthw;
+
+static TEST_PARAMETER parameters[MAX_TESTS];
+static char names[MAX_TESTS][BENCHMARK_NAME_LENGTH];
+static uint32_t sizes[MAX_TESTS];
+static BENCHMARK tests[MAX_TESTS];
+static BENCHMARK_RESULT results[MAX_TESTS];
+
+static WINDOW_HANDLE window;
+
+/* Self test counts */
+static uint32_t group_passed;
+static uint32_t group_count;
+static uint32_t total_passed;
+static uint32_t total_count;
+
+/* Self test buffers */
+static char source8[SELF_TEST_LENGTH * 4 + 16];
+static WCHAR source16[SELF_TEST_LENGTH * 2 + 16];
+static char result8[2][SELF_TEST_LENGTH * 4 + 16];
+static WCHAR result16[2][SELF_TEST_LENGTH * 4 + 16];
+
+/* ============================================================================== */
+/* Self test of the fast paths against the RTL functions */
+static uint32_t random_next(void)
+{
+	static uint32_t seed = 0x9E3779B9;
+
+	/* Xorshift, the same sequence on every run so failures can be repeated */
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	return seed;
+}
+
+static void group_begin(void)
+{
+	group_passed = 0;
+	group_count = 0;
+}
+
+static void group_end(const char *name)
+{
+	char text[128];
+
+	snprintf(text, sizeof(text), "%-12s %u of %u correct", name, (unsigned int)group_passed, (unsigned int)group_count);
+	console_window_write_ln(window, text);
+
+	total_passed += group_passed;
+	total_count += group_count;
+}
+
+static void check(const char *name, BOOL result, int length)
+{
+	char text[128];
+
+	group_count++;
+	if (result)
+	{
+		group_passed++;
+		return;
+	}
+
+	/* Show only the first few failures */
+	if (group_count - group_passed > 5)
+		return;
+
+	snprintf(text, sizeof(text), "%s incorrect, length %d", name, length);
+	console_window_write_ln(window, text);
+}
+
+static int put_utf8(char *dest, uint32_t value)
+{
+	uint8_t *buffer = (uint8_t *)dest;
+
+	if (value < 0x80)
+	{
+		buffer[0] = value;
+		return 1;
+	}
+	if (value < 0x800)
+	{
+		buffer[0] = 0xC0 | (value >> 6);
+		buffer[1] = 0x80 | (value & 0x3F);
+		return 2;
+	}
+	if (value < 0x10000)
+	{
+		buffer[0] = 0xE0 | (value >> 12);
+		buffer[1] = 0x80 | ((value >> 6) & 0x3F);
+		buffer[2] = 0x80 | (value & 0x3F);
+		return 3;
+	}
+
+	buffer[0] = 0xF0 | (value >> 18);
+	buffer[1] = 0x80 | ((value >> 12) & 0x3F);
+	buffer[2] = 0x80 | ((value >> 6) & 0x3F);
+	buffer[3] = 0x80 | (value & 0x3F);
+	return 4;
+}
+
+/* Random UTF-8 with runs of ASCII, if invalid is set also stray bytes, overlong forms, surrogates and truncated sequences */
+static int random_utf8(char *dest, int count, BOOL invalid)
+{
+	static const char *errors[] = {"\xC0\x80", "\xE0\x80\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xC2", "\xE2\x82"};
+	uint32_t value;
+	int length = 0;
+	int run;
+
+	while (count-- > 0)
+	{
+		switch (random_next() % 8)
+		{
+			case 0:
+				value = 0x80 + (random_next() % 0x780);
+				break;
+			case 1:
+				value = 0x800 + (random_next() % 0xF800);
+				if (value >= 0xD800 && value < 0xE000)
+					value -= 0x1000;
+				break;
+			case 2:
+				value = 0x10000 + (random_next() % 0x100000);
+				break;
+			case 3:
+				if (invalid)
+				{
+					strcpy(dest + length, errors[random_next() % 7]);
+					length += strlen(dest + length);
+					continue;
+				}
+				/* Fall through */
+			default:
+				for (run = random_next() % 32; run > 0; run--)
+					dest[length++] = 0x20 + (random_next() % 0x5F);
+				continue;
+		}
+		length += put_utf8(dest + length, value);
+	}
+
+	return length;
+}
+
+/* Random UTF-16, if invalid is set also unpaired surrogates */
+static int random_utf16(WCHAR *dest, int count, BOOL invalid)
+{
+	uint32_t value;
+	int length = 0;
+
+	while (count-- > 0)
+	{
+		switch (random_next() % 8)
+		{
+			case 0:
+				dest[length++] = 0x80 + (random_next() % 0x780);
+				break;
+			case 1:
+				value = 0x800 + (random_next() % 0xF800);
+				if (value >= 0xD800 && value < 0xE000)
+					value -= 0x1000;
+				dest[length++] = value;
+				break;
+			case 2:
+				value = random_next() % 0x100000;
+				dest[length++] = 0xD800 + (value >> 10);
+				dest[length++] = 0xDC00 + (value & 0x3FF);
+				break;
+			case 3:
+				dest[length++] = invalid ? 0xD800 + (random_next() % 0x800) : 0xA0 + (random_next() % 0x60);
+				break;
+			default:
+				dest[length++] = 0x20 + (random_next() % 0x5F);
+				break;
+		}
+	}
+
+	return length;
+}
+
+/* Random Latin 1 text with a few characters outside the ANSI and OEM code pages */
+static int random_latin(WCHAR *dest, int count)
+{
+	static const WCHAR extra[] = {0x20AC, 0x201C, 0x201D, 0x2022, 0x0152, 0x0160, 0x2591, 0x03B1, 0x03A3, 0x0101, 0x4E00};
+	int length;
+
+	for (length = 0; length < count; length++)
+	{
+		switch (random_next() % 8)
+		{
+			case 0:
+				dest[length] = 0xA0 + (random_next() % 0x60);
+				break;
+			case 1:
+				dest[length] = extra[random_next() % 11];
+				break;
+			default:
+				dest[length] = 0x20 + (random_next() % 0x5F);
+				break;
+		}
+	}
+
+	return length;
+}
+
+/* Compare a conversion to UTF-16 with the RTL, once to size the result and once with a buffer one character too small */
+static BOOL compare_to_wide(unsigned int codepage, uint32_t flags, const char *source, int count)
+{
+	int required;
+	int expected;
+	int actual;
+
+	required = MultiByteToWideChar(codepage, flags, (char *)source, count, NULL, 0);
+	if (unicode_multi_byte_to_wide_char(codepage, flags, source, count, NULL, 0) != required)
+		return FALSE;
+
+	expected = MultiByteToWideChar(codepage, flags, (char *)source, count, result16[0], required);
+	actual = unicode_multi_byte_to_wide_char(codepage, flags, source, count, result16[1], required);
+	if (actual != expected || memcmp(result16[0], result16[1], expected * sizeof(WCHAR)) != 0)
+		return FALSE;
+
+	if (required < 2)
+		return TRUE;
+
+	expected = MultiByteToWideChar(codepage, flags, (char *)source, count, result16[0], required - 1);
+	actual = unicode_multi_byte_to_wide_char(codepage, flags, source, count, result16[1], required - 1);
+
+	return (actual == expected);
+}
+
+/* Compare a conversion from UTF-16 with the RTL including whether the default character was used */
+static BOOL compare_from_wide(unsigned int codepage, uint32_t flags, const WCHAR *source, int count)
+{
+	BOOL *used[2] = {NULL, NULL};
+	BOOL useddefault[2];
+	int required;
+	int expected;
+	int actual;
+
+	/* The RTL does not accept lpuseddefaultchar for UTF-8 */
+	if (codepage != CP_UTF8)
+	{
+		used[0] = &useddefault[0];
+		used[1] = &useddefault[1];
+	}
+
+	required = WideCharToMultiByte(codepage, flags, (WCHAR *)source, count, NULL, 0, NULL, NULL);
+	if (unicode_wide_char_to_multi_byte(codepage, flags, source, count, NULL, 0, NULL, NULL) != required)
+		return FALSE;
+
+	expected = WideCharToMultiByte(codepage, flags, (WCHAR *)source, count, result8[0], required, NULL, used[0]);
+	actual = unicode_wide_char_to_multi_byte(codepage, flags, source, count, result8[1], required, NULL, used[1]);
+	if (actual != expected || memcmp(result8[0], result8[1], expected) != 0)
+		return FALSE;
+
+	return (used[0] == NULL || useddefault[0] == useddefault[1]);
+}
+
+static void test_utf8(void)
+{
+	uint32_t round;
+	BOOL valid;
+	int length;
+
+	group_begin();
+	for (round = 0; round < SELF_TEST_ROUNDS; round++)
+	{
+		length = random_utf8(source8, 1 + (random_next() % (SELF_TEST_LENGTH / 8)), (round % 3) == 0);
+
+		check("utf8_to_utf16", compare_to_wide(CP_UTF8, 0, source8, length), length);
+		check("utf8_to_utf16_strict", compare_to_wide(CP_UTF8, MB_ERR_INVALID_CHARS, source8, length), length);
+
+		valid = (length == 0 || MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, source8, length, NULL, 0) != 0);
+		check("utf8_validate", unicode_utf8_validate(source8, length) == valid, length);
+
+		/* Null terminated */
+		source8[length] = '\0';
+		if (strlen(source8) == (size_t)length)
+			check("utf8_to_utf16_null", compare_to_wide(CP_UTF8, 0, source8, -1), length);
+	}
+	group_end("UTF-8");
+}
+
+static void test_utf16(void)
+{
+	uint32_t round;
+	uint32_t index;
+	BOOL valid;
+	int length;
+
+	group_begin();
+	for (round = 0; round < SELF_TEST_ROUNDS; round++)
+	{
+		length = random_utf16(source16, 1 + (random_next() % (SELF_TEST_LENGTH / 2)), (round % 3) == 0);
+
+		check("utf16_to_utf8", compare_from_wide(CP_UTF8, 0, source16, length), length);
+
+		/* A high surrogate must be followed by a low surrogate, a low surrogate must follow a high one */
+		valid = TRUE;
+		for (index = 0; index < (uint32_t)length; index++)
+		{
+			if (source16[index] >= 0xD800 && source16[index] < 0xDC00 && index + 1 < (uint32_t)length && source16[index + 1] >= 0xDC00 && source16[index + 1] < 0xE000)
+				index++;
+			else if (source16[index] >= 0xD800 && source16[index] < 0xE000)
+				valid = FALSE;
+		}
+		check("utf16_validate", unicode_utf16_validate(source16, length) == valid, length);
+	}
+	group_end("UTF-16");
+}
+
+static void test_codepages(void)
+{
+	uint32_t round;
+	uint32_t index;
+	int length;
+
+	group_begin();
+	for (round = 0; round < SELF_TEST_ROUNDS; round++)
+	{
+		/* Every byte value, then every character of random Latin text */
+		length = 1 + (random_next() % SELF_TEST_LENGTH);
+		for (index = 0; index < (uint32_t)length; index++)
+			source8[index] = random_next();
+
+		check("acp_to_utf16", compare_to_wide(CP_ACP, 0, source8, length), length);
+		check("oemcp_to_utf16", compare_to_wide(CP_OEMCP, 0, source8, length), length);
+		check("cp1252_to_utf16", compare_to_wide(1252, MB_PRECOMPOSED, source8, length), length);
+
+		length = random_latin(source16, length);
+
+		check("utf16_to_acp", compare_from_wide(CP_ACP, 0, source16, length), length);
+		check("utf16_to_oemcp", compare_from_wide(CP_OEMCP, 0, source16, length), length);
+		check("utf16_to_cp1252", compare_from_wide(1252, WC_NO_BEST_FIT_CHARS, source16, length), length);
+	}
+	group_end("Code pages");
+}
+
+static void test_case(void)
+{
+	uint32_t round;
+	uint32_t index;
+	uint32_t expected;
+	uint32_t actual;
+	int length;
+
+	group_begin();
+	for (round = 0; round < SELF_TEST_ROUNDS; round++)
+	{
+		length = 1 + (random_next() % SELF_TEST_LENGTH);
+		for (index = 0; index < (uint32_t)length; index++)
+			source8[index] = (random_next() % 4) ? 0x20 + (random_next() % 0x5F) : random_next();
+
+		memcpy(result8[0], source8, length);
+		memcpy(result8[1], source8, length);
+		expected = CharUpperBuffA(result8[0], length);
+		actual = unicode_char_upper_buff(result8[1], length);
+		check("upper_ansi", actual == expected && memcmp(result8[0], result8[1], length) == 0, length);
+
+		expected = CharLowerBuffA(result8[0], length);
+		actual = unicode_char_lower_buff(result8[1], length);
+		check("lower_ansi", actual == expected && memcmp(result8[0], result8[1], length) == 0, length);
+
+		expected = AnsiToOemBuff(source8, result8[0], length);
+		actual = unicode_ansi_to_oem_buff(source8, result8[1], length);
+		check("ansi_to_oem", actual == expected && memcmp(result8[0], result8[1], length) == 0, length);
+
+		expected = OemToAnsiBuff(source8, result8[0], length);
+		actual = unicode_oem_to_ansi_buff(source8, result8[1], length);
+		check("oem_to_ansi", actual == expected && memcmp(result8[0], result8[1], length) == 0, length);
+
+		length = random_latin(source16, length);
+
+		memcpy(result16[0], source16, length * sizeof(WCHAR));
+		memcpy(result16[1], source16, length * sizeof(WCHAR));
+		expected = CharUpperBuffW(result16[0], length);
+		actual = unicode_char_upper_buff_w(result16[1], length);
+		check("upper_wide", actual == expected && memcmp(result16[0], result16[1], length * sizeof(WCHAR)) == 0, length);
+
+		expected = CharLowerBuffW(result16[0], length);
+		actual = unicode_char_lower_buff_w(result16[1], length);
+		check("lower_wide", actual == expected && memcmp(result16[0], result16[1], length * sizeof(WCHAR)) == 0, length);
+	}
+	group_end("Case");
+}
+
+static BOOL self_test(uint32_t implementation)
+{
+	char text[128];
+	char name[32];
+
+	unicode_set_implementation(implementation);
+	unicode_implementation_to_string(implementation, name, sizeof(name));
+
+	snprintf(text, sizeof(text), "Self test with implementation: %s", name);
+	console_window_write_ln(window, text);
+
+	total_passed = 0;
+	total_count = 0;
+
+	test_utf8();
+	test_utf16();
+	test_codepages();
+	test_case();
+
+	snprintf(text, sizeof(text), "Total %u of %u correct", (unsigned int)total_passed, (unsigned int)total_count);
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	return (total_passed == total_count);
+}
+
+/* ============================================================================== */
+/* Throughput benchmarks */
+static int build_text(char *dest, const char **fragments, uint32_t count)
+{
+	uint32_t index = 0;
+	int length = 0;
+	int size;
+
+	/* Whole fragments only so the text is always valid UTF-8 */
+	for (;;)
+	{
+		size = strlen(fragments[index]);
+		if (length + size > BUFFER_SIZE)
+			break;
+
+		memcpy(dest + length, fragments[index], size);
+		length += size;
+		index = (index + 1) % count;
+	}
+
+	return length;
+}
+
+static void build_texts(void)
+{
+	int index;
+
+	html_length = build_text(html_text, html_fragments, sizeof(html_fragments) / sizeof(html_fragments[0]));
+	mixed_length = build_text(mixed_text, mixed_fragments, sizeof(mixed_fragments) / sizeof(mixed_fragments[0]));
+
+	/* The same text in UTF-16 for the conversions to UTF-8 */
+	html_lengthw = MultiByteToWideChar(CP_UTF8, 0, html_text, html_length, html_textw, BUFFER_SIZE);
+	mixed_lengthw = MultiByteToWideChar(CP_UTF8, 0, mixed_text, mixed_length, mixed_textw, BUFFER_SIZE);
+
+	/* Code page 1252 text, the markup with every byte above 0x7F replaced by a printable one */
+	latin_length = html_length;
+	for (index = 0; index < latin_length; index++)
+		latin_text[index] = ((uint8_t)html_text[index] < 0x80) ? html_text[index] : 0xC0 + (index % 0x40);
+	latin_lengthw = MultiByteToWideChar(1252, 0, latin_text, latin_length, latin_textw, BUFFER_SIZE);
+}
+
+static uint32_t STDCALL test_setup(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, void **data)
+{
+	const TEST_PARAMETER *parameter = (const TEST_PARAMETER *)benchmark->parameter;
+	TEST_DATA *test;
+
+	test = calloc(1, sizeof(TEST_DATA));
+	if (!test)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	test->parameter = parameter;
+	test->dest = malloc(BUFFER_SIZE * 4);
+	test->destw = malloc(BUFFER_SIZE * sizeof(WCHAR));
+	if (!test->dest || !test->destw)
+	{
+		free(test->dest);
+		free(test->destw);
+		free(test);
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
+
+	switch (parameter->kind)
+	{
+		case TEST_UTF8_TO_UTF16_HTML:
+		case TEST_UTF8_VALIDATE_HTML:
+			test->source = html_text;
+			test->count = html_length;
+			break;
+		case TEST_UTF8_TO_UTF16_MIXED:
+		case TEST_UTF8_VALIDATE_MIXED:
+			test->source = mixed_text;
+			test->count = mixed_length;
+			break;
+		case TEST_UTF16_TO_UTF8_HTML:
+			test->sourcew = html_textw;
+			test->count = html_lengthw;
+			break;
+		case TEST_UTF16_TO_UTF8_MIXED:
+			test->sourcew = mixed_textw;
+			test->count = mixed_lengthw;
+			break;
+		case TEST_CP1252_TO_UTF16:
+		case TEST_UPPER_ANSI:
+			test->source = latin_text;
+			test->count = latin_length;
+			break;
+		case TEST_UPPER_WIDE:
+			test->sourcew = latin_textw;
+			test->count = latin_lengthw;
+			break;
+	}
+
+	/* Case mapping works in place, start from a copy of the text */
+	if (parameter->kind == TEST_UPPER_ANSI)
+		memcpy(test->dest, test->source, test->count);
+	if (parameter->kind == TEST_UPPER_WIDE)
+		memcpy(test->destw, test->sourcew, test->count * sizeof(WCHAR));
+
+	/* Select the implementation for this test */
+	unicode_set_implementation(parameter->implementation);
+
+	*data = test;
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL test_run(void *data, uint32_t iterations)
+{
+	TEST_DATA *test = (TEST_DATA *)data;
+	BOOL rtl = (test->parameter->path == TEST_PATH_RTL);
+	uint32_t count;
+
+	for (count = 0; count < iterations; count++)
+	{
+		switch (test->parameter->kind)
+		{
+			case TEST_UTF8_TO_UTF16_HTML:
+			case TEST_UTF8_TO_UTF16_MIXED:
+				if (rtl)
+					test->result = MultiByteToWideChar(CP_UTF8, 0, (char *)test->source, test->count, test->destw, BUFFER_SIZE);
+				else
+					test->result = unicode_multi_byte_to_wide_char(CP_UTF8, 0, test->source, test->count, test->destw, BUFFER_SIZE);
+				break;
+			case TEST_UTF16_TO_UTF8_HTML:
+			case TEST_UTF16_TO_UTF8_MIXED:
+				if (rtl)
+					test->result = WideCharToMultiByte(CP_UTF8, 0, (WCHAR *)test->sourcew, test->count, test->dest, BUFFER_SIZE * 4, NULL, NULL);
+				else
+					test->result = unicode_wide_char_to_multi_byte(CP_UTF8, 0, test->sourcew, test->count, test->dest, BUFFER_SIZE * 4, NULL, NULL);
+				break;
+			case TEST_UTF8_VALIDATE_HTML:
+			case TEST_UTF8_VALIDATE_MIXED:
+				/* The nearest RTL equivalent is sizing a strict conversion */
+				if (rtl)
+					test->result = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, (char *)test->source, test->count, NULL, 0);
+				else
+					test->result = unicode_utf8_validate(test->source, test->count);
+				break;
+			case TEST_CP1252_TO_UTF16:
+				if (rtl)
+					test->result = MultiByteToWideChar(1252, 0, (char *)test->source, test->count, test->destw, BUFFER_SIZE);
+				else
+					test->result = unicode_multi_byte_to_wide_char(1252, 0, test->source, test->count, test->destw, BUFFER_SIZE);
+				break;
+			case TEST_UPPER_ANSI:
+				if (rtl)
+					test->result = CharUpperBuffA(test->dest, test->count);
+				else
+					test->result = unicode_char_upper_buff(test->dest, test->count);
+				break;
+			case TEST_UPPER_WIDE:
+				if (rtl)
+					test->result = CharUpperBuffW(test->destw, test->count);
+				else
+					test->result = unicode_char_upper_buff_w(test->destw, test->count);
+				break;
+		}
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static void STDCALL test_teardown(void *data)
+{
+	TEST_DATA *test = (TEST_DATA *)data;
+
+	free(test->dest);
+	free(test->destw);
+	free(test);
+}
+
+static void add_test(uint32_t *count, uint32_t kind, uint32_t path, uint32_t implementation)
+{
+	TEST_PARAMETER *parameter = &parameters[*count];
+	BENCHMARK *test = &tests[*count];
+
+	parameter->kind = kind;
+	parameter->path = path;
+	parameter->implementation = implementation;
+
+	snprintf(names[*count], BENCHMARK_NAME_LENGTH, "%s%s", test_names[kind], path_names[path]);
+
+	/* Throughput is reported against the size of the source text */
+	switch (kind)
+	{
+		case TEST_UTF8_TO_UTF16_HTML:
+		case TEST_UTF8_VALIDATE_HTML:
+			sizes[*count] = html_length;
+			break;
+		case TEST_UTF8_TO_UTF16_MIXED:
+		case TEST_UTF8_VALIDATE_MIXED:
+			sizes[*count] = mixed_length;
+			break;
+		case TEST_UTF16_TO_UTF8_HTML:
+			sizes[*count] = html_lengthw * sizeof(WCHAR);
+			break;
+		case TEST_UTF16_TO_UTF8_MIXED:
+			sizes[*count] = mixed_lengthw * sizeof(WCHAR);
+			break;
+		case TEST_CP1252_TO_UTF16:
+		case TEST_UPPER_ANSI:
+			sizes[*count] = latin_length;
+			break;
+		case TEST_UPPER_WIDE:
+			sizes[*count] = latin_lengthw * sizeof(WCHAR);
+			break;
+	}
+
+	test->name = names[*count];
+	test->group = BENCHMARK_GROUP_USER;
+	test->iterations = 0;
+	test->setup = test_setup;
+	test->run = test_run;
+	test->teardown = test_teardown;
+	test->parameter = parameter;
+
+	(*count)++;
+}
+
+int apimain(int argc, char **argv)
+{
+	BENCHMARK_CONFIG config;
+	uint32_t implementation;
+	uint32_t status;
+	uint32_t count;
+	uint32_t index;
+	char name[32];
+	char text[256];
+
+	/* Create a console window for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "Unicode Benchmark advanced example");
+	console_window_write_ln(window, "");
+
+	/* Wait for the system to settle and drive C:\ to become available */
+	sleep(5);
+
+	implementation = unicode_get_implementation();
+	unicode_implementation_to_string(implementation, name, sizeof(name));
+
+	snprintf(text, sizeof(text), "Board type %u, ANSI code page %u, OEM code page %u, default implementation: %s", (unsigned int)board_get_type(), GetACP(), GetOEMCP(), name);
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	/* Check every implementation available in this build against the RTL */
+	for (index = UNICODE_IMPL_SCALAR; index <= UNICODE_IMPL_NEON; index++)
+	{
+		if (unicode_set_implementation(index) != ERROR_SUCCESS)
+			continue;
+
+		if (!self_test(index))
+		{
+			console_window_write_ln(window, "Self test failed, benchmarks not run");
+			thread_halt(0);
+		}
+	}
+	unicode_set_implementation(implementation);
+
+	/* Each kind with the RTL, the scalar implementation and (If different) the default implementation */
+	build_texts();
+
+	count = 0;
+	for (index = 0; index < TEST_KIND_COUNT; index++)
+	{
+		add_test(&count, index, TEST_PATH_RTL, implementation);
+		add_test(&count, index, TEST_PATH_SCALAR, UNICODE_IMPL_SCALAR);
+
+		if (implementation != UNICODE_IMPL_SCALAR)
+			add_test(&count, index, TEST_PATH_DEFAULT, implementation);
+	}
+
+	/* Defaults for everything except the CPU and the number of repeats */
+	memset(&config, 0, sizeof(BENCHMARK_CONFIG));
+	config.cpu = CPU_ID_0;
+	config.repeats = 10;
+
+	console_window_write_ln(window, "Running, this may take a minute");
+	console_window_write_ln(window, "");
+
+	status = benchmark_run_list(tests, count, &config, results);
+	unicode_set_implementation(implementation);
+	if (status != ERROR_SUCCESS)
+	{
+		snprintf(text, sizeof(text), "Benchmark failed (Status %u)", (unsigned int)status);
+		console_window_write_ln(window, text);
+		thread_halt(0);
+	}
+
+	for (index = 0; index < count; index++)
+	{
+		if (results[index].status != ERROR_SUCCESS)
+			snprintf(text, sizeof(text), "%-26s failed (Status %u)", results[index].name, (unsigned int)results[index].status);
+		else
+			snprintf(text, sizeof(text), "%-26s %10.1f MB/s", results[index].name, (sizes[index] * 1000.0) / results[index].median);
+
+		console_window_write_ln(window, text);
+	}
+	console_window_write_ln(window, "");
+
+	if (benchmark_export_file(results, count, RESULTS_FILE) == ERROR_SUCCESS)
+		console_window_write_ln(window, "Results written to " RESULTS_FILE);
+
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
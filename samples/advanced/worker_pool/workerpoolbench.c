@@ -0,0 +1,245 @@
+/*
+ *
+ * Worker Pool advanced example project for Ultibo API
+ *
+ * This example compares the kernel worker pool (worker_schedule) with the per
+ * CPU worker pools (src/threads/workerpool.c) where each CPU has its own queue
+ * and worker threads and only takes tasks from other CPUs when it runs dry.
+ *
+ * One producer thread is bound to each CPU and schedules tasks as fast as the
+ * pool accepts them. The first test uses empty tasks to measure the overhead of
+ * queuing and dispatching, the second gives every producer a buffer sized to fit
+ * in the level 1 data cache which each task reads, so a task that runs on the
+ * CPU that scheduled it finds the buffer already in the cache.
+ *
+ * The results and the per CPU queue statistics are shown in a console window.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/workerpool.h"
+
+/* Number of tasks scheduled by each producer */
+#define TASK_COUNT 20000
+
+/* Size of the buffer read by each task in the cache test (Bytes) */
+#define BUFFER_SIZE SIZE_16K
+
+/* Producer state, one per CPU */
+typedef struct
+{
+	uint32_t cpu;
+	BOOL local; // Use worker_schedule_local instead of worker_schedule
+	BOOL cache; // Tasks read the buffer
+	volatile uint32_t completed; // Number of tasks completed
+	volatile uint32_t sum; // Result of the buffer reads to prevent them being optimised away
+	uint32_t *buffer;
+	volatile BOOL done; // The producer has scheduled all of its tasks
+} PRODUCER;
+
+static PRODUCER producers[CPU_ID_MAX + 1];
+
+static void STDCALL empty_task(void *data)
+{
+}
+
+static void STDCALL cache_task(void *data)
+{
+	PRODUCER *producer = (PRODUCER *)data;
+	uint32_t count;
+	uint32_t sum;
+
+	sum = 0;
+	for (count = 0; count < BUFFER_SIZE / sizeof(uint32_t); count++)
+		sum += producer->buffer[count];
+
+	producer->sum += sum;
+}
+
+static void STDCALL task_completed(void *data)
+{
+	PRODUCER *producer = (PRODUCER *)data;
+
+	__sync_fetch_and_add(&producer->completed, 1);
+}
+
+static ssize_t STDCALL producer_execute(void *parameter)
+{
+	PRODUCER *producer = (PRODUCER *)parameter;
+	worker_task_proc task;
+	uint32_t status;
+	uint32_t count;
+
+	task = producer->cache ? cache_task : empty_task;
+
+	for (count = 0; count < TASK_COUNT; count++)
+	{
+		/* Refresh the buffer from time to time as a real producer would */
+		if (producer->cache && (count & 0xFF) == 0)
+			memset(producer->buffer, count & 0xFF, BUFFER_SIZE);
+
+		/* Retry while the queue is full */
+		do
+		{
+			if (producer->local)
+				status = worker_schedule_local(task, producer, task_completed);
+			else
+				status = worker_schedule(0, task, producer, task_completed);
+
+			if (status != ERROR_SUCCESS)
+				thread_yield();
+		} while (status != ERROR_SUCCESS);
+	}
+
+	producer->done = TRUE;
+
+	return 0;
+}
+
+/* Run one producer on each CPU and report the task rate */
+static void run_test(WINDOW_HANDLE window, const char *name, BOOL local, BOOL cache)
+{
+	PRODUCER *producer;
+	uint32_t cpucount;
+	uint32_t total;
+	uint32_t cpu;
+	int64_t start;
+	int64_t elapsed;
+	char text[256];
+
+	cpucount = cpu_get_count();
+	if (cpucount > CPU_ID_MAX + 1)
+		cpucount = CPU_ID_MAX + 1;
+
+	if (local)
+		worker_pool_reset_statistics();
+
+	for (cpu = 0; cpu < cpucount; cpu++)
+	{
+		producer = &producers[cpu];
+
+		producer->cpu = cpu;
+		producer->local = local;
+		producer->cache = cache;
+		producer->completed = 0;
+		producer->done = FALSE;
+		if (!producer->buffer)
+			producer->buffer = malloc(BUFFER_SIZE);
+	}
+
+	start = clock_microseconds();
+
+	for (cpu = 0; cpu < cpucount; cpu++)
+		thread_create_ex(producer_execute, SIZE_16K, THREAD_PRIORITY_NORMAL, 1 << cpu, cpu, "Producer", &producers[cpu]);
+
+	/* Wait for every task to complete */
+	do
+	{
+		thread_yield();
+
+		total = 0;
+		for (cpu = 0; cpu < cpucount; cpu++)
+			total += producers[cpu].completed;
+	} while (total < cpucount * TASK_COUNT);
+
+	elapsed = clock_microseconds() - start;
+	if (elapsed <= 0)
+		elapsed = 1;
+
+	snprintf(text, sizeof(text), "%-22s %u tasks in %u ms, %.0f tasks/s", name, (unsigned int)total, (unsigned int)(elapsed / 1000), ((double)total * 1000000.0) / elapsed);
+	console_window_write_ln(window, text);
+}
+
+/* Show the queue statistics of the per CPU pools */
+static void show_statistics(WINDOW_HANDLE window)
+{
+	WORKER_POOL_STATISTICS statistics;
+	uint32_t cpu;
+	char text[256];
+
+	for (cpu = 0; cpu < cpu_get_count() && cpu <= CPU_ID_MAX; cpu++)
+	{
+		if (worker_pool_get_statistics(cpu, &statistics) != ERROR_SUCCESS)
+			break;
+
+		snprintf(text, sizeof(text), "  CPU%u executed %u stolen %u donated %u max depth %u latency avg %u us max %u us", (unsigned int)cpu, (unsigned int)statistics.executedcount, (unsigned int)statistics.stolencount, (unsigned int)statistics.donatedcount, (unsigned int)statistics.maxdepth, (unsigned int)(statistics.executedcount ? statistics.latencytotal / statistics.executedcount : 0), (unsigned int)statistics.latencymax);
+		console_window_write_ln(window, text);
+	}
+}
+
+int apimain(int argc, char **argv)
+{
+	WINDOW_HANDLE window;
+	char text[256];
+
+	/* Create a console window for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "Worker Pool advanced example");
+	console_window_write_ln(window, "");
+
+	/* Start the per CPU pools before measuring so thread creation is not included */
+	if (worker_pool_start(0) != ERROR_SUCCESS)
+	{
+		console_window_write_ln(window, "Failed to start the per CPU worker pools");
+		thread_halt(0);
+	}
+
+	snprintf(text, sizeof(text), "Kernel workers %u, per CPU workers %u", (unsigned int)worker_get_count(), (unsigned int)worker_pool_get_count());
+	console_window_write_ln(window, text);
+	console_window_write_ln(window, "");
+
+	/* Wait a moment for the system to settle */
+	sleep(2);
+
+	console_window_write_ln(window, "Empty tasks");
+	run_test(window, "Kernel worker_schedule", FALSE, FALSE);
+	run_test(window, "worker_schedule_local", TRUE, FALSE);
+	show_statistics(window);
+	console_window_write_ln(window, "");
+
+	console_window_write_ln(window, "Cache sensitive tasks");
+	run_test(window, "Kernel worker_schedule", FALSE, TRUE);
+	run_test(window, "worker_schedule_local", TRUE, TRUE);
+	show_statistics(window);
+	console_window_write_ln(window, "");
+
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
@@ -0,0 +1,359 @@
+/*
+ *
+ * Zlib Logging advanced example project for Ultibo API
+ *
+ * This example measures the cost of compressing log and telemetry output with
+ * the Zlib logging device (libs/zlib/zlib_port_ultibo.c).
+ *
+ * Four canned corpora are generated in memory, a system log in the style of the
+ * kernel boot messages, telemetry records as CSV and as JSON, and a hex dump of
+ * random data which shows the worst case. Each corpus is passed one line at a time
+ * through logging_device_output to a Zlib logging device that discards its output,
+ * so only the cost of buffering and compression is measured.
+ *
+ * For each compression level and flush setting the compression ratio, the CPU time
+ * spent in deflate per megabyte of messages and the time taken by the logging call
+ * itself are shown in a console window. If drive C:\ is available a compressed log
+ * is also written to a set of rotating gzip files which can be read with zcat.
+ *
+ *
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/filesystem.h"
+#include "ultibo/logging.h"
+
+#include "zlib_port_ultibo.h"
+
+/* Number of lines in each corpus */
+#define CORPUS_LINES 20000
+
+/* Maximum length of a corpus line */
+#define CORPUS_LINE_LENGTH 128
+
+/* File name for the rotating log (Each segment gets its own number) */
+#define LOG_FILE "C:\\zliblog%u.log.gz"
+
+/* Corpus */
+typedef struct
+{
+	const char *name;
+	void (*generate)(char *line, uint32_t index);
+} CORPUS;
+
+/* Compression settings */
+typedef struct
+{
+	const char *name;
+	uint32_t level;
+	uint32_t flushsize;
+	uint32_t flags;
+} SETTING;
+
+static uint32_t random_state;
+
+static WINDOW_HANDLE window;
+
+static uint32_t random_next(void)
+{
+	/* Xorshift, the corpora must be the same on every run */
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+
+	return random_state;
+}
+
+static const char *system_sources[] =
+{
+	"usb 1-1.3", "mmc0", "dwc_otg", "bcm2835-dma", "eth0", "vchiq", "thermal", "i2c-1", "spi0.0", "cpufreq"
+};
+
+static const char *system_messages[] =
+{
+	"new high-speed USB device number %u using dwc_otg",
+	"new device found at address %u",
+	"link up, 100Mbps, full-duplex, lpa 0x%04X",
+	"DMA channel %u allocated",
+	"temperature %u millidegrees, throttling not required",
+	"transfer of %u bytes completed",
+	"frequency changed to %u kHz",
+	"queue %u stalled, resetting endpoint",
+	"card inserted, %u blocks of 512 bytes",
+	"timeout waiting for interrupt %u"
+};
+
+static void system_generate(char *line, uint32_t index)
+{
+	char message[CORPUS_LINE_LENGTH];
+	uint32_t source;
+	uint32_t timestamp;
+
+	source = random_next() % 10;
+	timestamp = index * 731 + (random_next() % 500);
+
+	snprintf(message, sizeof(message), system_messages[source], (unsigned int)(random_next() % 4096));
+	snprintf(line, CORPUS_LINE_LENGTH, "[%5u.%06u] %s: %s", (unsigned int)(timestamp / 1000000), (unsigned int)(timestamp % 1000000), system_sources[source], message);
+}
+
+static void csv_generate(char *line, uint32_t index)
+{
+	uint32_t node;
+
+	node = index % 8;
+
+	snprintf(line, CORPUS_LINE_LENGTH, "2026-10-19T10:%02u:%02u.%03u,node%02u,temp=%u.%02u,vcore=1.%04u,rpm=%u,rssi=-%u",
+	 (unsigned int)((index / 6000) % 60), (unsigned int)((index / 100) % 60), (unsigned int)((index * 10) % 1000), (unsigned int)node,
+	 (unsigned int)(40 + node), (unsigned int)(random_next() % 100), (unsigned int)(1900 + random_next() % 300),
+	 (unsigned int)(3000 + random_next() % 250), (unsigned int)(60 + random_next() % 15));
+}
+
+static void json_generate(char *line, uint32_t index)
+{
+	uint32_t node;
+
+	node = index % 8;
+
+	snprintf(line, CORPUS_LINE_LENGTH, "{\"ts\":%u,\"node\":\"node%02u\",\"temp\":%u.%02u,\"vcore\":1.%04u,\"rpm\":%u,\"rssi\":-%u}",
+	 (unsigned int)(1760868900 + index / 10), (unsigned int)node,
+	 (unsigned int)(40 + node), (unsigned int)(random_next() % 100), (unsigned int)(1900 + random_next() % 300),
+	 (unsigned int)(3000 + random_next() % 250), (unsigned int)(60 + random_next() % 15));
+}
+
+static void hex_generate(char *line, uint32_t index)
+{
+	uint32_t offset;
+	uint32_t count;
+
+	offset = snprintf(line, CORPUS_LINE_LENGTH, "%08X:", (unsigned int)(index * 16));
+
+	for (count = 0; count < 16; count++)
+		offset += snprintf(line + offset, CORPUS_LINE_LENGTH - offset, " %02X", (unsigned int)(random_next() & 0xFF));
+}
+
+static const CORPUS corpora[] =
+{
+	{"System log", system_generate},
+	{"Telemetry CSV", csv_generate},
+	{"Telemetry JSON", json_generate},
+	{"Random hex", hex_generate}
+};
+
+static const SETTING settings[] =
+{
+	{"Level 1", 1, INFINITE, ZLIB_LOGGING_FLAG_NONE},
+	{"Level 6", 6, INFINITE, ZLIB_LOGGING_FLAG_NONE},
+	{"Level 9", 9, INFINITE, ZLIB_LOGGING_FLAG_NONE},
+	{"Level 6, flush 4K", 6, SIZE_4K, ZLIB_LOGGING_FLAG_NONE},
+	{"Level 6, full flush 4K", 6, SIZE_4K, ZLIB_LOGGING_FLAG_FULL_FLUSH}
+};
+
+#define CORPUS_COUNT (sizeof(corpora) / sizeof(CORPUS))
+#define SETTING_COUNT (sizeof(settings) / sizeof(SETTING))
+
+static char *corpus_create(const CORPUS *corpus)
+{
+	uint32_t index;
+	char *lines;
+
+	lines = malloc(CORPUS_LINES * CORPUS_LINE_LENGTH);
+	if (!lines)
+		return NULL;
+
+	random_state = 0x2545F491;
+
+	for (index = 0; index < CORPUS_LINES; index++)
+		corpus->generate(lines + (index * CORPUS_LINE_LENGTH), index);
+
+	return lines;
+}
+
+static void run_benchmark(const CORPUS *corpus, const SETTING *setting, char *lines)
+{
+	ZLIB_LOGGING_STATISTICS statistics;
+	ZLIB_LOGGING_CONFIG config;
+	LOGGING_DEVICE *logging;
+	uint32_t index;
+	int64_t start;
+	int64_t elapsed;
+	char text[256];
+
+	memset(&config, 0, sizeof(ZLIB_LOGGING_CONFIG));
+	config.output = ZLIB_LOGGING_OUTPUT_NONE;
+	config.format = ZLIB_LOGGING_FORMAT_GZIP;
+	config.flags = setting->flags;
+	config.level = setting->level;
+	config.flushinterval = INFINITE;
+	config.flushsize = setting->flushsize;
+	config.flushseverity = LOGGING_SEVERITY_INVALID;
+
+	logging = zlib_logging_create(NULL, &config, FALSE);
+	if (!logging)
+	{
+		console_window_write_ln(window, "Failed to create the Zlib logging device");
+		return;
+	}
+
+	/* Time the logging calls, compression happens in the background thread */
+	start = clock_microseconds();
+	for (index = 0; index < CORPUS_LINES; index++)
+		logging_device_output(logging, lines + (index * CORPUS_LINE_LENGTH));
+	elapsed = clock_microseconds() - start;
+
+	zlib_logging_flush(logging, INFINITE);
+	zlib_logging_get_statistics(logging, &statistics);
+
+	zlib_logging_destroy(logging);
+
+	if (statistics.outputbytes == 0 || statistics.inputbytes == 0)
+		return;
+
+	snprintf(text, sizeof(text), "%-15s %-23s %7u %7u %6.2f %8.1f %8.2f",
+	 corpus->name,
+	 setting->name,
+	 (unsigned int)(statistics.inputbytes / 1024),
+	 (unsigned int)(statistics.outputbytes / 1024),
+	 (double)statistics.inputbytes / (double)statistics.outputbytes,
+	 (double)statistics.compresstime * 1048576.0 / (double)statistics.inputbytes / 1000.0,
+	 (double)elapsed / (double)CORPUS_LINES);
+	console_window_write_ln(window, text);
+}
+
+static void run_rotation(void)
+{
+	ZLIB_LOGGING_STATISTICS statistics;
+	ZLIB_LOGGING_CONFIG config;
+	LOGGING_DEVICE *logging;
+	uint32_t repeat;
+	uint32_t index;
+	char *lines;
+	char text[256];
+
+	lines = corpus_create(&corpora[0]);
+	if (!lines)
+		return;
+
+	/* Segments of 256KB of messages, only the newest four files are kept */
+	memset(&config, 0, sizeof(ZLIB_LOGGING_CONFIG));
+	config.output = ZLIB_LOGGING_OUTPUT_FILE;
+	config.format = ZLIB_LOGGING_FORMAT_GZIP;
+	config.segmentsize = SIZE_256K;
+	config.maxsegments = 4;
+
+	logging = zlib_logging_create(LOG_FILE, &config, FALSE);
+	if (!logging)
+	{
+		console_window_write_ln(window, "Failed to create the Zlib logging device for " LOG_FILE);
+		free(lines);
+		return;
+	}
+
+	for (repeat = 0; repeat < 4; repeat++)
+	{
+		for (index = 0; index < CORPUS_LINES; index++)
+			logging_device_output(logging, lines + (index * CORPUS_LINE_LENGTH));
+
+		/* Errors are flushed immediately by the default flush severity */
+		logging_device_output_ex(logging, LOGGING_FACILITY_USER, LOGGING_SEVERITY_ERROR, "zliblogging", "end of pass");
+	}
+
+	zlib_logging_flush(logging, INFINITE);
+	zlib_logging_get_statistics(logging, &statistics);
+
+	zlib_logging_destroy(logging);
+	free(lines);
+
+	snprintf(text, sizeof(text), "Wrote %u messages in %u segments, %u KB compressed to %u KB with %u flush points, %u errors",
+	 (unsigned int)statistics.messagecount,
+	 (unsigned int)statistics.segmentcount,
+	 (unsigned int)(statistics.inputbytes / 1024),
+	 (unsigned int)(statistics.outputbytes / 1024),
+	 (unsigned int)statistics.flushcount,
+	 (unsigned int)statistics.errorcount);
+	console_window_write_ln(window, text);
+}
+
+int apimain(int argc, char **argv)
+{
+	uint32_t corpus;
+	uint32_t setting;
+	char *lines;
+
+	/* Create a console window for the results */
+	window = console_window_create(console_device_get_default(), CONSOLE_POSITION_FULL, TRUE);
+
+	console_window_write_ln(window, "Zlib Logging advanced example");
+	console_window_write_ln(window, "");
+
+	/* Wait for the system to settle and drive C:\ to become available */
+	sleep(5);
+
+	console_window_write_ln(window, "Corpus          Setting                  In(KB) Out(KB)  Ratio ms/MB(in) us/call");
+
+	for (corpus = 0; corpus < CORPUS_COUNT; corpus++)
+	{
+		lines = corpus_create(&corpora[corpus]);
+		if (!lines)
+		{
+			console_window_write_ln(window, "Failed to allocate the corpus");
+			break;
+		}
+
+		for (setting = 0; setting < SETTING_COUNT; setting++)
+			run_benchmark(&corpora[corpus], &settings[setting], lines);
+
+		free(lines);
+	}
+
+	console_window_write_ln(window, "");
+
+	/* Rotating gzip files on drive C:\ */
+	if (DirectoryExists("C:\\"))
+	{
+		console_window_write_ln(window, "Writing rotating log files to " LOG_FILE);
+		run_rotation();
+	}
+	else
+	{
+		console_window_write_ln(window, "Drive C:\\ not available, skipping the rotating log files");
+	}
+
+	console_window_write_ln(window, "");
+	console_window_write_ln(window, "Completed");
+
+	/* Halt the main thread here */
+	thread_halt(0);
+
+	return 0;
+}
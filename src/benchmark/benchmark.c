@@ -0,0 +1,599 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/benchmark.h"
+
+/* Implementation of the benchmark harness for Ultibo API
+ *
+ * Each run of a benchmark calls its run function once to perform a number of
+ * operations and is timed with clock_get_count, only the difference between two
+ * readings is used so a run must be shorter than one wrap of the 32 bit counter.
+ * The rate of the counter is measured against clock_microseconds on first use
+ * since it depends on the board and the clock source (See clock_get_rate for the
+ * rate of the hardware clocks instead).
+ *
+ * When a benchmark does not fix the number of operations the harness starts with
+ * one and increases it until a run lasts at least the configured run time, these
+ * runs also warm the caches and branch predictors before the warmup runs proper.
+ * The measured runs are sorted to give the minimum, median, 99th percentile and
+ * maximum, all results are reported as nanoseconds per operation.
+ *
+ * Results are exported as one JSON object with one line per result so that the
+ * output can be captured from a serial port or log and compared between boards
+ * and releases without further processing.
+ */
+
+/* Benchmark State */
+typedef struct _BENCHMARK_STATE BENCHMARK_STATE;
+struct _BENCHMARK_STATE
+{
+	uint64_t clockrate; // Measured rate of clock_get_count (Counts per second)
+};
+
+static BENCHMARK_STATE harness = {0};
+
+/* ============================================================================== */
+/* Benchmark Internal Functions */
+/* Measure the rate of the clock counter */
+static void benchmark_calibrate(void)
+{
+	int64_t starttotal;
+	int64_t endtotal;
+	int64_t starttime;
+	int64_t endtime;
+	uint64_t rate;
+
+	starttotal = clock_get_total();
+	starttime = clock_microseconds();
+
+	thread_sleep(BENCHMARK_CALIBRATE_TIME);
+
+	endtotal = clock_get_total();
+	endtime = clock_microseconds();
+
+	if (endtime <= starttime || endtotal <= starttotal)
+		rate = 1000000;
+	else
+		rate = ((uint64_t)(endtotal - starttotal) * 1000000) / (uint64_t)(endtime - starttime);
+
+	harness.clockrate = rate;
+}
+
+/* Square root by Newton iteration so the harness does not need libm */
+static double benchmark_sqrt(double value)
+{
+	double result;
+	uint32_t count;
+
+	if (value <= 0.0)
+		return 0.0;
+
+	result = (value > 1.0) ? value / 2.0 : 1.0;
+	for (count = 0; count < 64; count++)
+	{
+		double next = (result + value / result) / 2.0;
+
+		if (next == result)
+			break;
+
+		result = next;
+	}
+
+	return result;
+}
+
+static int benchmark_compare(const void *value1, const void *value2)
+{
+	uint32_t count1 = *(const uint32_t *)value1;
+	uint32_t count2 = *(const uint32_t *)value2;
+
+	return (count1 > count2) - (count1 < count2);
+}
+
+static uint32_t benchmark_time(const BENCHMARK *benchmark, void *data, uint32_t iterations, uint32_t *counts)
+{
+	uint32_t start;
+	uint32_t status;
+
+	start = clock_get_count();
+	status = benchmark->run(data, iterations);
+	*counts = clock_get_count() - start;
+
+	return status;
+}
+
+/* Increase the iterations until one run lasts at least mincounts */
+static uint32_t benchmark_scale(const BENCHMARK *benchmark, void *data, uint32_t mincounts, uint32_t *iterations)
+{
+	uint64_t estimate;
+	uint32_t counts;
+	uint32_t status;
+	uint32_t value;
+
+	value = 1;
+	while (TRUE)
+	{
+		status = benchmark_time(benchmark, data, value, &counts);
+		if (status != ERROR_SUCCESS)
+			return status;
+
+		if (counts >= mincounts || value >= BENCHMARK_MAX_ITERATIONS)
+			break;
+
+		/* Jump straight to the estimate with a margin once the run is long enough to measure */
+		if (counts < mincounts / 10)
+			estimate = (uint64_t)value * 10;
+		else
+			estimate = ((uint64_t)value * mincounts * 11) / ((uint64_t)counts * 10) + 1;
+
+		if (estimate > BENCHMARK_MAX_ITERATIONS)
+			estimate = BENCHMARK_MAX_ITERATIONS;
+
+		value = (uint32_t)estimate;
+	}
+
+	*iterations = value;
+
+	return ERROR_SUCCESS;
+}
+
+static void benchmark_statistics(BENCHMARK_RESULT *result, uint32_t *samples, uint32_t count)
+{
+	double scale;
+	double total;
+	double sumsquares;
+	double value;
+	uint32_t index;
+
+	qsort(samples, count, sizeof(uint32_t), benchmark_compare);
+
+	/* Nanoseconds per operation for one count */
+	scale = 1000000000.0 / ((double)harness.clockrate * result->iterations);
+
+	total = 0.0;
+	for (index = 0; index < count; index++)
+		total += samples[index];
+
+	result->mean = (total / count) * scale;
+
+	sumsquares = 0.0;
+	for (index = 0; index < count; index++)
+	{
+		value = (samples[index] * scale) - result->mean;
+		sumsquares += value * value;
+	}
+
+	result->stddev = (count > 1) ? benchmark_sqrt(sumsquares / (count - 1)) : 0.0;
+
+	result->minimum = samples[0] * scale;
+	result->maximum = samples[count - 1] * scale;
+
+	if (count & 1)
+		result->median = samples[count / 2] * scale;
+	else
+		result->median = (((double)samples[(count / 2) - 1] + samples[count / 2]) / 2.0) * scale;
+
+	/* Nearest rank */
+	index = (uint32_t)(((uint64_t)count * 99 + 99) / 100);
+	if (index > 0)
+		index--;
+	result->p99 = samples[index] * scale;
+}
+
+static const char *benchmark_board_name(void)
+{
+#if defined(RPIB)
+	return "rpib";
+#elif defined(RPI2B)
+	return "rpi2b";
+#elif defined(RPI3B)
+	return "rpi3b";
+#elif defined(RPI4B)
+	return "rpi4b";
+#elif defined(QEMUVPB)
+	return "qemuvpb";
+#else
+	return "unknown";
+#endif
+}
+
+static const char *benchmark_arch_name(void)
+{
+#if defined(__aarch64__)
+	return "aarch64";
+#else
+	return "arm";
+#endif
+}
+
+/* Copy a name into a JSON string with quotes and control characters escaped */
+static void benchmark_escape(const char *name, char *string, uint32_t len)
+{
+	uint32_t count = 0;
+
+	while (*name && count + 3 < len)
+	{
+		if (*name == '"' || *name == '\\')
+			string[count++] = '\\';
+
+		string[count++] = ((unsigned char)*name < 0x20) ? ' ' : *name;
+		name++;
+	}
+
+	string[count] = '\0';
+}
+
+/* Export Line Procedure */
+typedef uint32_t (*benchmark_line_proc)(const char *line, void *data);
+
+static uint32_t benchmark_format(const BENCHMARK_RESULT *results, uint32_t count, benchmark_line_proc proc, void *data)
+{
+	const BENCHMARK_RESULT *result;
+	char line[BENCHMARK_NAME_LENGTH * 2 + 384];
+	char name[BENCHMARK_NAME_LENGTH * 2];
+	char group[32];
+	uint32_t status;
+	uint32_t index;
+
+	snprintf(line, sizeof(line), "{\"board\":\"%s\",\"arch\":\"%s\",\"boardtype\":%u,\"cpucount\":%u,\"clockrate\":%llu,\"results\":[\n", benchmark_board_name(), benchmark_arch_name(), (unsigned int)board_get_type(), (unsigned int)cpu_get_count(), (unsigned long long)benchmark_get_clock_rate());
+
+	status = proc(line, data);
+	if (status != ERROR_SUCCESS)
+		return status;
+
+	for (index = 0; index < count; index++)
+	{
+		result = &results[index];
+
+		benchmark_escape(result->name, name, sizeof(name));
+		benchmark_group_to_string(result->group, group, sizeof(group));
+
+		snprintf(line, sizeof(line), "{\"name\":\"%s\",\"group\":\"%s\",\"status\":%u,\"cpu\":%d,\"iterations\":%u,\"repeats\":%u,\"min\":%.3f,\"median\":%.3f,\"p99\":%.3f,\"max\":%.3f,\"mean\":%.3f,\"stddev\":%.3f}%s\n",
+			name, group, (unsigned int)result->status, (result->cpu == CPU_ID_ALL) ? -1 : (int)result->cpu, (unsigned int)result->iterations, (unsigned int)result->repeats,
+			result->minimum, result->median, result->p99, result->maximum, result->mean, result->stddev, (index + 1 < count) ? "," : "");
+
+		status = proc(line, data);
+		if (status != ERROR_SUCCESS)
+			return status;
+	}
+
+	return proc("]}\n", data);
+}
+
+/* Export Buffer */
+typedef struct _BENCHMARK_EXPORT BENCHMARK_EXPORT;
+struct _BENCHMARK_EXPORT
+{
+	char *buffer;
+	uint32_t len;
+	uint32_t count;
+};
+
+static uint32_t benchmark_line_buffer(const char *line, void *data)
+{
+	BENCHMARK_EXPORT *export = (BENCHMARK_EXPORT *)data;
+	uint32_t size = strlen(line);
+
+	/* Count the full size even when the buffer is too small */
+	if (export->buffer && export->count + size < export->len)
+		memcpy(export->buffer + export->count, line, size);
+
+	export->count += size;
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t benchmark_line_file(const char *line, void *data)
+{
+	if (fputs(line, (FILE *)data) < 0)
+		return ERROR_WRITE_FAULT;
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t benchmark_line_serial(const char *line, void *data)
+{
+	uint32_t size;
+	uint32_t count;
+	uint32_t status;
+
+	/* Serial terminals expect a carriage return before each line feed */
+	size = strlen(line);
+	if (size > 0 && line[size - 1] == '\n')
+		size--;
+
+	status = serial_write((void *)line, size, &count);
+	if (status != ERROR_SUCCESS)
+		return status;
+
+	return serial_write("\r\n", 2, &count);
+}
+
+static uint32_t benchmark_line_log(const char *line, void *data)
+{
+	char text[BENCHMARK_NAME_LENGTH * 2 + 384];
+	uint32_t size;
+
+	/* Logging adds its own line ending */
+	size = strlen(line);
+	if (size >= sizeof(text))
+		size = sizeof(text) - 1;
+
+	memcpy(text, line, size);
+	if (size > 0 && text[size - 1] == '\n')
+		size--;
+	text[size] = '\0';
+
+	logging_output(text);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Benchmark Functions */
+uint32_t STDCALL benchmark_run(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, BENCHMARK_RESULT *result)
+{
+	BENCHMARK_CONFIG defaults;
+	THREAD_HANDLE thread;
+	uint32_t *samples;
+	uint32_t mincounts;
+	uint32_t affinity;
+	uint32_t retries;
+	uint32_t status;
+	uint32_t index;
+	void *data;
+	char text[BENCHMARK_NAME_LENGTH + 128];
+
+	if (!benchmark || !benchmark->run || !result)
+		return ERROR_INVALID_PARAMETER;
+
+	if (!config)
+	{
+		memset(&defaults, 0, sizeof(BENCHMARK_CONFIG));
+		defaults.cpu = CPU_ID_ALL;
+		config = &defaults;
+	}
+
+	if (config->repeats > BENCHMARK_MAX_REPEATS)
+		return ERROR_INVALID_PARAMETER;
+
+	if (config->cpu != CPU_ID_ALL && config->cpu >= cpu_get_count())
+		return ERROR_INVALID_PARAMETER;
+
+	memset(result, 0, sizeof(BENCHMARK_RESULT));
+	strncpy(result->name, benchmark->name ? benchmark->name : "", BENCHMARK_NAME_LENGTH - 1);
+	result->group = benchmark->group;
+	result->cpu = config->cpu;
+	result->repeats = config->repeats ? config->repeats : BENCHMARK_DEFAULT_REPEATS;
+
+	if (harness.clockrate == 0)
+		benchmark_calibrate();
+
+	samples = malloc(result->repeats * sizeof(uint32_t));
+	if (!samples)
+	{
+		result->status = ERROR_NOT_ENOUGH_MEMORY;
+		return result->status;
+	}
+
+	data = NULL;
+	if (benchmark->setup)
+	{
+		status = benchmark->setup(benchmark, config, &data);
+		if (status != ERROR_SUCCESS)
+		{
+			free(samples);
+			result->status = status;
+			return status;
+		}
+	}
+
+	/* Pin the calling thread and wait for it to migrate */
+	thread = thread_get_current();
+	affinity = thread_get_affinity(thread);
+	if (config->cpu != CPU_ID_ALL)
+	{
+		thread_set_affinity(thread, 1 << config->cpu);
+
+		for (retries = 0; retries < BENCHMARK_PIN_RETRIES && cpu_get_current() != config->cpu; retries++)
+			thread_yield();
+	}
+
+	if (benchmark->iterations)
+	{
+		result->iterations = benchmark->iterations;
+		status = ERROR_SUCCESS;
+	}
+	else
+	{
+		mincounts = (uint32_t)((harness.clockrate * (config->runtime ? config->runtime : BENCHMARK_DEFAULT_RUN_TIME)) / 1000000);
+		status = benchmark_scale(benchmark, data, mincounts ? mincounts : 1, &result->iterations);
+	}
+
+	for (index = 0; status == ERROR_SUCCESS && index < (config->warmup ? config->warmup : BENCHMARK_DEFAULT_WARMUP); index++)
+		status = benchmark_time(benchmark, data, result->iterations, &samples[0]);
+
+	for (index = 0; status == ERROR_SUCCESS && index < result->repeats; index++)
+		status = benchmark_time(benchmark, data, result->iterations, &samples[index]);
+
+	if (config->cpu != CPU_ID_ALL)
+		thread_set_affinity(thread, affinity);
+
+	if (benchmark->teardown)
+		benchmark->teardown(data);
+
+	if (status == ERROR_SUCCESS)
+		benchmark_statistics(result, samples, result->repeats);
+
+	free(samples);
+
+	result->status = status;
+
+	if (config->flags & BENCHMARK_FLAG_LOG)
+	{
+		if (status == ERROR_SUCCESS)
+			snprintf(text, sizeof(text), "Benchmark: %s median %.3f ns p99 %.3f ns stddev %.3f ns (%u x %u)", result->name, result->median, result->p99, result->stddev, (unsigned int)result->repeats, (unsigned int)result->iterations);
+		else
+			snprintf(text, sizeof(text), "Benchmark: %s not run (Status %u)", result->name, (unsigned int)status);
+
+		logging_output(text);
+	}
+
+	return status;
+}
+
+uint32_t STDCALL benchmark_run_list(const BENCHMARK *benchmarks, uint32_t count, const BENCHMARK_CONFIG *config, BENCHMARK_RESULT *results)
+{
+	uint32_t index;
+
+	if (!benchmarks || !results)
+		return ERROR_INVALID_PARAMETER;
+
+	/* A benchmark that cannot run records its status in the result, the rest still run */
+	for (index = 0; index < count; index++)
+		benchmark_run(&benchmarks[index], config, &results[index]);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL benchmark_export(const BENCHMARK_RESULT *results, uint32_t count, char *buffer, uint32_t len, uint32_t *size)
+{
+	BENCHMARK_EXPORT export;
+	uint32_t status;
+
+	if ((!results && count > 0) || !size)
+		return ERROR_INVALID_PARAMETER;
+
+	export.buffer = buffer;
+	export.len = len;
+	export.count = 0;
+
+	status = benchmark_format(results, count, benchmark_line_buffer, &export);
+
+	/* Size is the size required (Excluding the null terminator) */
+	*size = export.count;
+	if (status != ERROR_SUCCESS)
+		return status;
+
+	if (!buffer || export.count >= len)
+		return ERROR_INSUFFICIENT_BUFFER;
+
+	buffer[export.count] = '\0';
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL benchmark_export_file(const BENCHMARK_RESULT *results, uint32_t count, const char *filename)
+{
+	uint32_t status;
+	FILE *file;
+
+	if ((!results && count > 0) || !filename)
+		return ERROR_INVALID_PARAMETER;
+
+	file = fopen(filename, "w");
+	if (!file)
+		return ERROR_OPEN_FAILED;
+
+	status = benchmark_format(results, count, benchmark_line_file, file);
+
+	if (fclose(file) != 0 && status == ERROR_SUCCESS)
+		status = ERROR_WRITE_FAULT;
+
+	return status;
+}
+
+uint32_t STDCALL benchmark_export_serial(const BENCHMARK_RESULT *results, uint32_t count)
+{
+	if (!results && count > 0)
+		return ERROR_INVALID_PARAMETER;
+
+	return benchmark_format(results, count, benchmark_line_serial, NULL);
+}
+
+uint32_t STDCALL benchmark_export_log(const BENCHMARK_RESULT *results, uint32_t count)
+{
+	if (!results && count > 0)
+		return ERROR_INVALID_PARAMETER;
+
+	return benchmark_format(results, count, benchmark_line_log, NULL);
+}
+
+/* ============================================================================== */
+/* Benchmark Helper Functions */
+uint64_t STDCALL benchmark_get_clock_rate(void)
+{
+	if (harness.clockrate == 0)
+		benchmark_calibrate();
+
+	return harness.clockrate;
+}
+
+uint32_t STDCALL benchmark_group_to_string(uint32_t group, char *string, uint32_t len)
+{
+	const char *value;
+
+	if (!string || len == 0)
+		return 0;
+
+	switch (group)
+	{
+		case BENCHMARK_GROUP_THREADS:
+			value = "threads";
+			break;
+		case BENCHMARK_GROUP_HEAP:
+			value = "heap";
+			break;
+		case BENCHMARK_GROUP_CONSOLE:
+			value = "console";
+			break;
+		case BENCHMARK_GROUP_FRAMEBUFFER:
+			value = "framebuffer";
+			break;
+		case BENCHMARK_GROUP_FILESYSTEM:
+			value = "filesystem";
+			break;
+		case BENCHMARK_GROUP_SOCKETS:
+			value = "sockets";
+			break;
+		case BENCHMARK_GROUP_USER:
+			value = "user";
+			break;
+		default:
+			value = "unknown";
+			break;
+	}
+
+	strncpy(string, value, len - 1);
+	string[len - 1] = '\0';
+
+	return strlen(string);
+}
@@ -0,0 +1,795 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/console.h"
+#include "ultibo/framebuffer.h"
+#include "ultibo/benchmark.h"
+
+/* Implementation of the standard benchmark suite for Ultibo API
+ *
+ * One operation of each benchmark is the smallest useful unit of work, a lock
+ * and unlock, an allocation and release, a line of console text, a 4KB file
+ * write and so on, so that results can be compared directly between boards and
+ * between releases of Ultibo core.
+ *
+ * Benchmarks that need something which is not present (no console or framebuffer
+ * device, no filesystem at the configured path, no network) return the status
+ * ERROR_NOT_SUPPORTED from setup and are reported as not run.
+ */
+
+#define BENCHSUITE_THREAD_NAME	"Benchmark Partner" // Thread name for the context switch partner thread
+#define BENCHSUITE_THREAD_STACK_SIZE	SIZE_16K // Stack size of the context switch partner thread
+
+#define BENCHSUITE_RECT_SIZE	64 // Width and height of the framebuffer rectangles (Pixels)
+#define BENCHSUITE_FILE_NAME	"benchmark.tmp" // Name of the file used by the filesystem benchmarks
+#define BENCHSUITE_FILE_BLOCK	SIZE_4K // Size of each file read or write
+#define BENCHSUITE_FILE_SIZE	SIZE_1M // Size reached before the file position wraps to the start
+#define BENCHSUITE_UDP_SIZE	64 // Size of each UDP datagram
+#define BENCHSUITE_TCP_SIZE	1024 // Size of each TCP send
+#define BENCHSUITE_HEAP_BLOCKS	64 // Number of blocks in each mixed allocation operation
+
+/* Thread Primitives */
+#define BENCHSUITE_SYNC_SPIN	0
+#define BENCHSUITE_SYNC_MUTEX	1
+#define BENCHSUITE_SYNC_CRITICAL_SECTION	2
+#define BENCHSUITE_SYNC_SEMAPHORE	3
+#define BENCHSUITE_SYNC_SWITCH	4
+
+/* ============================================================================== */
+/* Threads Benchmarks */
+typedef struct _BENCHSUITE_SYNC BENCHSUITE_SYNC;
+struct _BENCHSUITE_SYNC
+{
+	uint32_t primitive; // Primitive under test (eg BENCHSUITE_SYNC_MUTEX)
+	HANDLE handle; // Handle of the primitive (Not used by BENCHSUITE_SYNC_SWITCH)
+	SEMAPHORE_HANDLE ping; // Signalled by the benchmark thread for the partner thread
+	SEMAPHORE_HANDLE pong; // Signalled by the partner thread for the benchmark thread
+	volatile BOOL stopping;
+};
+
+static ssize_t STDCALL benchsuite_partner_execute(void *parameter)
+{
+	BENCHSUITE_SYNC *sync = (BENCHSUITE_SYNC *)parameter;
+
+	while (TRUE)
+	{
+		semaphore_wait(sync->ping);
+
+		if (sync->stopping)
+			break;
+
+		semaphore_signal(sync->pong);
+	}
+
+	/* Tell teardown the partner has finished with the semaphores */
+	semaphore_signal(sync->pong);
+
+	return 0;
+}
+
+static uint32_t STDCALL benchsuite_sync_setup(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, void **data)
+{
+	BENCHSUITE_SYNC *sync;
+
+	sync = calloc(1, sizeof(BENCHSUITE_SYNC));
+	if (!sync)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	sync->primitive = (uint32_t)(uintptr_t)benchmark->parameter;
+	sync->handle = INVALID_HANDLE_VALUE;
+	sync->ping = INVALID_HANDLE_VALUE;
+	sync->pong = INVALID_HANDLE_VALUE;
+
+	switch (sync->primitive)
+	{
+		case BENCHSUITE_SYNC_SPIN:
+			sync->handle = spin_create();
+			break;
+		case BENCHSUITE_SYNC_MUTEX:
+			sync->handle = mutex_create();
+			break;
+		case BENCHSUITE_SYNC_CRITICAL_SECTION:
+			sync->handle = critical_section_create();
+			break;
+		case BENCHSUITE_SYNC_SEMAPHORE:
+			sync->handle = semaphore_create(0);
+			break;
+		case BENCHSUITE_SYNC_SWITCH:
+			sync->ping = semaphore_create(0);
+			sync->pong = semaphore_create(0);
+			if (sync->ping == INVALID_HANDLE_VALUE || sync->pong == INVALID_HANDLE_VALUE)
+				break;
+
+			/* The partner runs on the same CPU as the benchmark so each round trip is two context switches */
+			sync->handle = thread_create_ex(benchsuite_partner_execute, BENCHSUITE_THREAD_STACK_SIZE, thread_get_priority(thread_get_current()),
+				(config->cpu == CPU_ID_ALL) ? thread_get_affinity(thread_get_current()) : (1 << config->cpu),
+				(config->cpu == CPU_ID_ALL) ? cpu_get_current() : config->cpu, BENCHSUITE_THREAD_NAME, sync);
+			break;
+	}
+
+	if (sync->handle == INVALID_HANDLE_VALUE)
+	{
+		if (sync->pong != INVALID_HANDLE_VALUE)
+			semaphore_destroy(sync->pong);
+		if (sync->ping != INVALID_HANDLE_VALUE)
+			semaphore_destroy(sync->ping);
+
+		free(sync);
+
+		return ERROR_OPERATION_FAILED;
+	}
+
+	*data = sync;
+
+	return ERROR_SUCCESS;
+}
+
+static void STDCALL benchsuite_sync_teardown(void *data)
+{
+	BENCHSUITE_SYNC *sync = (BENCHSUITE_SYNC *)data;
+
+	switch (sync->primitive)
+	{
+		case BENCHSUITE_SYNC_SPIN:
+			spin_destroy(sync->handle);
+			break;
+		case BENCHSUITE_SYNC_MUTEX:
+			mutex_destroy(sync->handle);
+			break;
+		case BENCHSUITE_SYNC_CRITICAL_SECTION:
+			critical_section_destroy(sync->handle);
+			break;
+		case BENCHSUITE_SYNC_SEMAPHORE:
+			semaphore_destroy(sync->handle);
+			break;
+		case BENCHSUITE_SYNC_SWITCH:
+			sync->stopping = TRUE;
+			semaphore_signal(sync->ping);
+			semaphore_wait(sync->pong);
+
+			semaphore_destroy(sync->pong);
+			semaphore_destroy(sync->ping);
+			break;
+	}
+
+	free(sync);
+}
+
+static uint32_t STDCALL benchsuite_spin_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_SYNC *sync = (BENCHSUITE_SYNC *)data;
+
+	while (iterations--)
+	{
+		spin_lock(sync->handle);
+		spin_unlock(sync->handle);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_mutex_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_SYNC *sync = (BENCHSUITE_SYNC *)data;
+
+	while (iterations--)
+	{
+		mutex_lock(sync->handle);
+		mutex_unlock(sync->handle);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_critical_section_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_SYNC *sync = (BENCHSUITE_SYNC *)data;
+
+	while (iterations--)
+	{
+		critical_section_lock(sync->handle);
+		critical_section_unlock(sync->handle);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_semaphore_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_SYNC *sync = (BENCHSUITE_SYNC *)data;
+
+	while (iterations--)
+	{
+		semaphore_signal(sync->handle);
+		semaphore_wait(sync->handle);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_switch_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_SYNC *sync = (BENCHSUITE_SYNC *)data;
+
+	while (iterations--)
+	{
+		semaphore_signal(sync->ping);
+		semaphore_wait(sync->pong);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_yield_run(void *data, uint32_t iterations)
+{
+	while (iterations--)
+		thread_yield();
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Heap Benchmarks */
+static uint32_t STDCALL benchsuite_malloc_run(void *data, uint32_t iterations)
+{
+	size_t size = (size_t)(uintptr_t)data;
+	void *block;
+
+	while (iterations--)
+	{
+		block = malloc(size);
+		if (!block)
+			return ERROR_NOT_ENOUGH_MEMORY;
+
+		/* Touch the block so the allocation cannot be optimised away */
+		*(volatile uint8_t *)block = 0;
+
+		free(block);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_malloc_setup(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, void **data)
+{
+	*data = benchmark->parameter;
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_malloc_mixed_run(void *data, uint32_t iterations)
+{
+	static const uint16_t sizes[8] = {16, 48, 128, 24, 512, 64, 2048, 256};
+	void *blocks[BENCHSUITE_HEAP_BLOCKS];
+	uint32_t index;
+
+	while (iterations--)
+	{
+		for (index = 0; index < BENCHSUITE_HEAP_BLOCKS; index++)
+		{
+			blocks[index] = malloc(sizes[index & 7]);
+			if (!blocks[index])
+			{
+				while (index--)
+					free(blocks[index]);
+
+				return ERROR_NOT_ENOUGH_MEMORY;
+			}
+		}
+
+		/* Free the odd blocks then the even ones to leave holes between allocations */
+		for (index = 1; index < BENCHSUITE_HEAP_BLOCKS; index += 2)
+			free(blocks[index]);
+		for (index = 0; index < BENCHSUITE_HEAP_BLOCKS; index += 2)
+			free(blocks[index]);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Console Benchmarks */
+static uint32_t STDCALL benchsuite_console_setup(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, void **data)
+{
+	CONSOLE_DEVICE *console;
+	WINDOW_HANDLE window;
+
+	console = console_device_get_default();
+	if (!console)
+		return ERROR_NOT_SUPPORTED;
+
+	window = console_window_create(console, CONSOLE_POSITION_BOTTOMRIGHT, FALSE);
+	if (window == INVALID_HANDLE_VALUE)
+		return ERROR_NOT_SUPPORTED;
+
+	*data = (void *)window;
+
+	return ERROR_SUCCESS;
+}
+
+static void STDCALL benchsuite_console_teardown(void *data)
+{
+	console_window_destroy((WINDOW_HANDLE)data);
+}
+
+static uint32_t STDCALL benchsuite_console_write_run(void *data, uint32_t iterations)
+{
+	while (iterations--)
+		console_window_write_ln((WINDOW_HANDLE)data, "The quick brown fox jumps over the lazy dog 0123456789");
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_console_clear_run(void *data, uint32_t iterations)
+{
+	while (iterations--)
+		console_window_clear((WINDOW_HANDLE)data);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Framebuffer Benchmarks */
+typedef struct _BENCHSUITE_FRAMEBUFFER BENCHSUITE_FRAMEBUFFER;
+struct _BENCHSUITE_FRAMEBUFFER
+{
+	FRAMEBUFFER_DEVICE *framebuffer;
+	uint32_t x; // Position of the rectangle (Bottom right corner of the screen)
+	uint32_t y;
+	void *buffer; // Pixels for put_rect
+};
+
+static uint32_t STDCALL benchsuite_framebuffer_setup(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, void **data)
+{
+	BENCHSUITE_FRAMEBUFFER *context;
+	FRAMEBUFFER_PROPERTIES properties;
+	FRAMEBUFFER_DEVICE *framebuffer;
+	uint32_t size;
+
+	framebuffer = framebuffer_device_get_default();
+	if (!framebuffer)
+		return ERROR_NOT_SUPPORTED;
+
+	if (framebuffer_device_get_properties(framebuffer, &properties) != ERROR_SUCCESS)
+		return ERROR_NOT_SUPPORTED;
+
+	/* The copy benchmark needs room for two rectangles side by side */
+	if (properties.physicalwidth < BENCHSUITE_RECT_SIZE * 2 || properties.physicalheight < BENCHSUITE_RECT_SIZE)
+		return ERROR_NOT_SUPPORTED;
+
+	size = BENCHSUITE_RECT_SIZE * BENCHSUITE_RECT_SIZE * ((properties.depth + 7) / 8);
+
+	context = calloc(1, sizeof(BENCHSUITE_FRAMEBUFFER) + size);
+	if (!context)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	context->framebuffer = framebuffer;
+	context->x = properties.physicalwidth - (BENCHSUITE_RECT_SIZE * 2);
+	context->y = properties.physicalheight - BENCHSUITE_RECT_SIZE;
+	context->buffer = context + 1;
+	memset(context->buffer, 0x5A, size);
+
+	*data = context;
+
+	return ERROR_SUCCESS;
+}
+
+static void STDCALL benchsuite_framebuffer_teardown(void *data)
+{
+	free(data);
+}
+
+static uint32_t STDCALL benchsuite_fill_rect_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_FRAMEBUFFER *context = (BENCHSUITE_FRAMEBUFFER *)data;
+	uint32_t status;
+
+	while (iterations--)
+	{
+		status = framebuffer_device_fill_rect(context->framebuffer, context->x, context->y, BENCHSUITE_RECT_SIZE, BENCHSUITE_RECT_SIZE, (iterations & 1) ? COLOR_WHITE : COLOR_BLACK, FRAMEBUFFER_TRANSFER_NONE);
+		if (status != ERROR_SUCCESS)
+			return status;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_put_rect_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_FRAMEBUFFER *context = (BENCHSUITE_FRAMEBUFFER *)data;
+	uint32_t status;
+
+	while (iterations--)
+	{
+		status = framebuffer_device_put_rect(context->framebuffer, context->x, context->y, context->buffer, BENCHSUITE_RECT_SIZE, BENCHSUITE_RECT_SIZE, 0, FRAMEBUFFER_TRANSFER_NONE);
+		if (status != ERROR_SUCCESS)
+			return status;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_copy_rect_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_FRAMEBUFFER *context = (BENCHSUITE_FRAMEBUFFER *)data;
+	uint32_t status;
+
+	while (iterations--)
+	{
+		status = framebuffer_device_copy_rect(context->framebuffer, context->x, context->y, context->x + BENCHSUITE_RECT_SIZE, context->y, BENCHSUITE_RECT_SIZE, BENCHSUITE_RECT_SIZE, FRAMEBUFFER_TRANSFER_NONE);
+		if (status != ERROR_SUCCESS)
+			return status;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Filesystem Benchmarks */
+typedef struct _BENCHSUITE_FILE BENCHSUITE_FILE;
+struct _BENCHSUITE_FILE
+{
+	int handle; // File descriptor (Or -1 for the create benchmark)
+	uint32_t position; // Current position in the file
+	char filename[MAX_PATH];
+	uint8_t buffer[BENCHSUITE_FILE_BLOCK];
+};
+
+static uint32_t STDCALL benchsuite_file_setup(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, void **data)
+{
+	BENCHSUITE_FILE *context;
+	const char *path;
+	uint32_t size;
+	BOOL prefill;
+
+	context = calloc(1, sizeof(BENCHSUITE_FILE));
+	if (!context)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	path = config->path ? config->path : BENCHMARK_DEFAULT_PATH;
+	size = strlen(path);
+	snprintf(context->filename, sizeof(context->filename), "%s%s%s", path, (size > 0 && path[size - 1] != '\\' && path[size - 1] != '/') ? "\\" : "", BENCHSUITE_FILE_NAME);
+
+	memset(context->buffer, 0xA5, sizeof(context->buffer));
+
+	/* The parameter is 1 to write, 2 to read a file filled in advance or NULL to create and delete */
+	context->handle = -1;
+	if (benchmark->parameter)
+	{
+		context->handle = open(context->filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (context->handle < 0)
+		{
+			free(context);
+			return ERROR_NOT_SUPPORTED;
+		}
+
+		prefill = (benchmark->parameter == (void *)2);
+		for (size = 0; prefill && size < BENCHSUITE_FILE_SIZE; size += BENCHSUITE_FILE_BLOCK)
+		{
+			if (write(context->handle, context->buffer, BENCHSUITE_FILE_BLOCK) != BENCHSUITE_FILE_BLOCK)
+			{
+				close(context->handle);
+				unlink(context->filename);
+				free(context);
+				return ERROR_NOT_SUPPORTED;
+			}
+		}
+
+		lseek(context->handle, 0, SEEK_SET);
+	}
+
+	*data = context;
+
+	return ERROR_SUCCESS;
+}
+
+static void STDCALL benchsuite_file_teardown(void *data)
+{
+	BENCHSUITE_FILE *context = (BENCHSUITE_FILE *)data;
+
+	if (context->handle >= 0)
+	{
+		close(context->handle);
+		unlink(context->filename);
+	}
+
+	free(context);
+}
+
+/* Wrap to the start once the file reaches its maximum size */
+static void benchsuite_file_advance(BENCHSUITE_FILE *context)
+{
+	context->position += BENCHSUITE_FILE_BLOCK;
+	if (context->position >= BENCHSUITE_FILE_SIZE)
+	{
+		lseek(context->handle, 0, SEEK_SET);
+		context->position = 0;
+	}
+}
+
+static uint32_t STDCALL benchsuite_file_write_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_FILE *context = (BENCHSUITE_FILE *)data;
+
+	while (iterations--)
+	{
+		if (write(context->handle, context->buffer, BENCHSUITE_FILE_BLOCK) != BENCHSUITE_FILE_BLOCK)
+			return ERROR_WRITE_FAULT;
+
+		benchsuite_file_advance(context);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_file_read_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_FILE *context = (BENCHSUITE_FILE *)data;
+
+	while (iterations--)
+	{
+		if (read(context->handle, context->buffer, BENCHSUITE_FILE_BLOCK) != BENCHSUITE_FILE_BLOCK)
+			return ERROR_READ_FAULT;
+
+		benchsuite_file_advance(context);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_file_create_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_FILE *context = (BENCHSUITE_FILE *)data;
+	int handle;
+
+	while (iterations--)
+	{
+		handle = open(context->filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (handle < 0)
+			return ERROR_OPEN_FAILED;
+
+		close(handle);
+
+		if (unlink(context->filename) != 0)
+			return ERROR_WRITE_FAULT;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Sockets Benchmarks */
+typedef struct _BENCHSUITE_SOCKETS BENCHSUITE_SOCKETS;
+struct _BENCHSUITE_SOCKETS
+{
+	int sender; // Socket used to send
+	int receiver; // Socket used to receive
+	int listener; // Listening socket (TCP only)
+	struct sockaddr_in address; // Address of the receiver
+	uint8_t buffer[BENCHSUITE_TCP_SIZE];
+};
+
+static void STDCALL benchsuite_sockets_teardown(void *data)
+{
+	BENCHSUITE_SOCKETS *context = (BENCHSUITE_SOCKETS *)data;
+
+	if (context->sender >= 0)
+		close(context->sender);
+	if (context->receiver >= 0)
+		close(context->receiver);
+	if (context->listener >= 0)
+		close(context->listener);
+
+	free(context);
+}
+
+static uint32_t STDCALL benchsuite_sockets_setup(const BENCHMARK *benchmark, const BENCHMARK_CONFIG *config, void **data)
+{
+	BENCHSUITE_SOCKETS *context;
+	socklen_t length;
+	BOOL tcp;
+
+	context = calloc(1, sizeof(BENCHSUITE_SOCKETS));
+	if (!context)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	context->sender = -1;
+	context->receiver = -1;
+	context->listener = -1;
+
+	/* Bind to an ephemeral port on the loopback address and read back the port */
+	context->address.sin_family = AF_INET;
+	context->address.sin_port = 0;
+	context->address.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+	tcp = (benchmark->parameter != NULL);
+	if (tcp)
+	{
+		context->listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (context->listener < 0)
+			goto failed;
+
+		length = sizeof(context->address);
+		if (bind(context->listener, (struct sockaddr *)&context->address, sizeof(context->address)) != 0
+			|| getsockname(context->listener, (struct sockaddr *)&context->address, &length) != 0
+			|| listen(context->listener, 1) != 0)
+			goto failed;
+
+		context->sender = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (context->sender < 0)
+			goto failed;
+
+		if (connect(context->sender, (struct sockaddr *)&context->address, sizeof(context->address)) != 0)
+			goto failed;
+
+		context->receiver = accept(context->listener, NULL, NULL);
+		if (context->receiver < 0)
+			goto failed;
+	}
+	else
+	{
+		context->receiver = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (context->receiver < 0)
+			goto failed;
+
+		length = sizeof(context->address);
+		if (bind(context->receiver, (struct sockaddr *)&context->address, sizeof(context->address)) != 0
+			|| getsockname(context->receiver, (struct sockaddr *)&context->address, &length) != 0)
+			goto failed;
+
+		context->sender = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (context->sender < 0)
+			goto failed;
+	}
+
+	*data = context;
+
+	return ERROR_SUCCESS;
+
+failed:
+	benchsuite_sockets_teardown(context);
+
+	return ERROR_NOT_SUPPORTED;
+}
+
+static uint32_t STDCALL benchsuite_udp_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_SOCKETS *context = (BENCHSUITE_SOCKETS *)data;
+
+	while (iterations--)
+	{
+		if (sendto(context->sender, context->buffer, BENCHSUITE_UDP_SIZE, 0, (struct sockaddr *)&context->address, sizeof(context->address)) != BENCHSUITE_UDP_SIZE)
+			return ERROR_WRITE_FAULT;
+
+		if (recv(context->receiver, context->buffer, BENCHSUITE_UDP_SIZE, 0) != BENCHSUITE_UDP_SIZE)
+			return ERROR_READ_FAULT;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL benchsuite_tcp_run(void *data, uint32_t iterations)
+{
+	BENCHSUITE_SOCKETS *context = (BENCHSUITE_SOCKETS *)data;
+	uint32_t received;
+	int count;
+
+	while (iterations--)
+	{
+		if (send(context->sender, context->buffer, BENCHSUITE_TCP_SIZE, 0) != BENCHSUITE_TCP_SIZE)
+			return ERROR_WRITE_FAULT;
+
+		/* A stream may deliver the data in more than one piece */
+		for (received = 0; received < BENCHSUITE_TCP_SIZE; received += count)
+		{
+			count = recv(context->receiver, context->buffer + received, BENCHSUITE_TCP_SIZE - received, 0);
+			if (count <= 0)
+				return ERROR_READ_FAULT;
+		}
+	}
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Standard Suite */
+static const BENCHMARK benchsuite[] =
+{
+	{"spin_lock_unlock", BENCHMARK_GROUP_THREADS, 0, benchsuite_sync_setup, benchsuite_spin_run, benchsuite_sync_teardown, (void *)BENCHSUITE_SYNC_SPIN},
+	{"mutex_lock_unlock", BENCHMARK_GROUP_THREADS, 0, benchsuite_sync_setup, benchsuite_mutex_run, benchsuite_sync_teardown, (void *)BENCHSUITE_SYNC_MUTEX},
+	{"critical_section_lock_unlock", BENCHMARK_GROUP_THREADS, 0, benchsuite_sync_setup, benchsuite_critical_section_run, benchsuite_sync_teardown, (void *)BENCHSUITE_SYNC_CRITICAL_SECTION},
+	{"semaphore_signal_wait", BENCHMARK_GROUP_THREADS, 0, benchsuite_sync_setup, benchsuite_semaphore_run, benchsuite_sync_teardown, (void *)BENCHSUITE_SYNC_SEMAPHORE},
+	{"thread_yield", BENCHMARK_GROUP_THREADS, 0, NULL, benchsuite_yield_run, NULL, NULL},
+	{"context_switch_round_trip", BENCHMARK_GROUP_THREADS, 0, benchsuite_sync_setup, benchsuite_switch_run, benchsuite_sync_teardown, (void *)BENCHSUITE_SYNC_SWITCH},
+	{"malloc_free_64", BENCHMARK_GROUP_HEAP, 0, benchsuite_malloc_setup, benchsuite_malloc_run, NULL, (void *)64},
+	{"malloc_free_4k", BENCHMARK_GROUP_HEAP, 0, benchsuite_malloc_setup, benchsuite_malloc_run, NULL, (void *)SIZE_4K},
+	{"malloc_free_mixed_64_blocks", BENCHMARK_GROUP_HEAP, 0, NULL, benchsuite_malloc_mixed_run, NULL, NULL},
+	{"console_window_write_ln", BENCHMARK_GROUP_CONSOLE, 0, benchsuite_console_setup, benchsuite_console_write_run, benchsuite_console_teardown, NULL},
+	{"console_window_clear", BENCHMARK_GROUP_CONSOLE, 0, benchsuite_console_setup, benchsuite_console_clear_run, benchsuite_console_teardown, NULL},
+	{"framebuffer_fill_rect_64x64", BENCHMARK_GROUP_FRAMEBUFFER, 0, benchsuite_framebuffer_setup, benchsuite_fill_rect_run, benchsuite_framebuffer_teardown, NULL},
+	{"framebuffer_put_rect_64x64", BENCHMARK_GROUP_FRAMEBUFFER, 0, benchsuite_framebuffer_setup, benchsuite_put_rect_run, benchsuite_framebuffer_teardown, NULL},
+	{"framebuffer_copy_rect_64x64", BENCHMARK_GROUP_FRAMEBUFFER, 0, benchsuite_framebuffer_setup, benchsuite_copy_rect_run, benchsuite_framebuffer_teardown, NULL},
+	{"file_write_4k", BENCHMARK_GROUP_FILESYSTEM, 0, benchsuite_file_setup, benchsuite_file_write_run, benchsuite_file_teardown, (void *)1},
+	{"file_read_4k", BENCHMARK_GROUP_FILESYSTEM, 0, benchsuite_file_setup, benchsuite_file_read_run, benchsuite_file_teardown, (void *)2},
+	{"file_create_delete", BENCHMARK_GROUP_FILESYSTEM, 0, benchsuite_file_setup, benchsuite_file_create_run, benchsuite_file_teardown, NULL},
+	{"udp_loopback_64", BENCHMARK_GROUP_SOCKETS, 0, benchsuite_sockets_setup, benchsuite_udp_run, benchsuite_sockets_teardown, NULL},
+	{"tcp_loopback_1k", BENCHMARK_GROUP_SOCKETS, 0, benchsuite_sockets_setup, benchsuite_tcp_run, benchsuite_sockets_teardown, (void *)1},
+};
+
+#define BENCHSUITE_COUNT	(sizeof(benchsuite) / sizeof(BENCHMARK))
+
+/* ============================================================================== */
+/* Benchmark Suite Functions */
+uint32_t STDCALL benchmark_suite_get_count(uint32_t groups)
+{
+	uint32_t count;
+	uint32_t index;
+
+	count = 0;
+	for (index = 0; index < BENCHSUITE_COUNT; index++)
+	{
+		if (benchsuite[index].group & groups)
+			count++;
+	}
+
+	return count;
+}
+
+uint32_t STDCALL benchmark_suite_run(uint32_t groups, const BENCHMARK_CONFIG *config, BENCHMARK_RESULT *results, uint32_t len, uint32_t *count)
+{
+	uint32_t index;
+	uint32_t total;
+
+	if (!results || !count)
+		return ERROR_INVALID_PARAMETER;
+
+	/* Count returns the number of results required when the buffer is too small */
+	*count = benchmark_suite_get_count(groups);
+	if (*count > len)
+		return ERROR_INSUFFICIENT_BUFFER;
+
+	total = 0;
+	for (index = 0; index < BENCHSUITE_COUNT; index++)
+	{
+		if (!(benchsuite[index].group & groups))
+			continue;
+
+		benchmark_run(&benchsuite[index], config, &results[total]);
+		total++;
+	}
+
+	return ERROR_SUCCESS;
+}
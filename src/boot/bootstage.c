@@ -0,0 +1,678 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/filesystem.h"
+#include "ultibo/network.h"
+#include "ultibo/bootstage.h"
+
+/* Implementation of boot stages and the boot timeline for Ultibo API
+ *
+ * The core subsystems start asynchronously and only offer flags such as
+ * file_sys_start_completed, so each application ended up polling for the
+ * pieces it needed. A boot stage wraps one piece of startup work behind a
+ * completion, the stage runs on its own thread once every stage it depends
+ * on is ready and completes the completion for all waiters when it finishes.
+ * Independent stages therefore start in parallel, by default on the
+ * secondary CPUs so the main application thread keeps CPU 0 to itself.
+ *
+ * The core stages for the file system, drive C:\ and the network are created
+ * when the module starts but are only run when something needs them, all of
+ * the polling of core flags happens in those stage threads. Waiting for or
+ * starting any stage also starts the stages it depends on.
+ *
+ * Every start, ready, failure and wait is stamped with clock_get_count and
+ * clock_microseconds in a fixed size timeline which is filled without locks
+ * so it can be read back or logged at any point during startup.
+ */
+
+/* Boot stage module states */
+#define BOOT_STAGE_MODULE_STOPPED	0
+#define BOOT_STAGE_MODULE_STARTING	1
+#define BOOT_STAGE_MODULE_STARTED	2
+
+/* Status of a stage which did not start because a required dependency failed */
+#define BOOT_STAGE_DEPENDENCY_FAILED	ERROR_NOT_READY
+
+/* Boot Stage */
+struct _BOOT_STAGE
+{
+	uint32_t signature; // Signature for entry validation
+	char name[BOOT_STAGE_NAME_LENGTH]; // Name of the stage
+	boot_stage_start_proc start; // Start function of the stage
+	void *data; // Passed to the start function
+	uint32_t cpu; // CPU requested for the stage thread (CPU_ID_ALL to choose one)
+	uint32_t flags; // Boot stage flags (eg BOOT_STAGE_FLAG_OPTIONAL)
+	volatile uint32_t state; // Boot stage state (eg BOOT_STAGE_STATE_READY)
+	volatile uint32_t status; // Result of the start function (Or BOOT_STAGE_DEPENDENCY_FAILED)
+	COMPLETION_HANDLE ready; // Completed for all waiters when the stage is ready or has failed
+	THREAD_HANDLE thread; // Stage thread (INVALID_HANDLE_VALUE until started)
+	uint32_t dependencycount;
+	BOOT_STAGE *dependencies[BOOT_STAGE_MAX_DEPENDENCIES];
+	BOOT_STAGE *next; // Next stage in the list
+};
+
+/* Boot Stage Module */
+typedef struct _BOOT_STAGE_MODULE BOOT_STAGE_MODULE;
+struct _BOOT_STAGE_MODULE
+{
+	volatile uint32_t started; // Module state (eg BOOT_STAGE_MODULE_STARTED)
+	MUTEX_HANDLE lock; // Protects the stage list, dependencies and stage starts
+	BOOT_STAGE *first; // List of all stages in creation order
+	BOOT_STAGE *last;
+	uint32_t nextcpu; // Next secondary CPU for stages with CPU_ID_ALL
+	volatile uint32_t timelinecount; // Entries recorded in the timeline (May exceed BOOT_TIMELINE_MAX_ENTRIES)
+	BOOT_TIMELINE_ENTRY timeline[BOOT_TIMELINE_MAX_ENTRIES];
+};
+
+static BOOT_STAGE_MODULE bootstage;
+
+static BOOT_STAGE *boot_stage_create_locked(const char *name, boot_stage_start_proc start, void *data, uint32_t cpu, uint32_t flags);
+
+/* ============================================================================== */
+/* Internal functions */
+static void boot_timeline_record(const char *name, uint32_t event, uint32_t status)
+{
+	BOOT_TIMELINE_ENTRY *entry;
+	uint32_t index;
+
+	index = __sync_fetch_and_add(&bootstage.timelinecount, 1);
+	if (index >= BOOT_TIMELINE_MAX_ENTRIES)
+		return;
+
+	entry = &bootstage.timeline[index];
+	strncpy(entry->name, name, BOOT_STAGE_NAME_LENGTH - 1);
+	entry->name[BOOT_STAGE_NAME_LENGTH - 1] = '\0';
+	entry->status = status;
+	entry->cpu = cpu_get_current();
+	entry->count = clock_get_count();
+	entry->time = clock_microseconds();
+
+	/* The event is written last, readers treat BOOT_EVENT_NONE as not yet recorded */
+	__sync_synchronize();
+	entry->event = event;
+}
+
+/* Wait for a core subsystem by polling its flag on the stage thread */
+static uint32_t boot_stage_poll(BOOL STDCALL (*completed)(void))
+{
+	int64_t start = clock_milliseconds();
+
+	while (!completed())
+	{
+		if (clock_milliseconds() - start >= BOOT_STAGE_CORE_TIMEOUT)
+			return ERROR_WAIT_TIMEOUT;
+
+		thread_sleep(BOOT_STAGE_POLL_INTERVAL);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+static BOOL STDCALL boot_stage_drive_c_exists(void)
+{
+	return DirectoryExists("C:\\");
+}
+
+static uint32_t STDCALL boot_stage_filesystem_start(BOOT_STAGE *stage, void *data)
+{
+	return boot_stage_poll(file_sys_start_completed);
+}
+
+static uint32_t STDCALL boot_stage_drive_c_start(BOOT_STAGE *stage, void *data)
+{
+	return boot_stage_poll(boot_stage_drive_c_exists);
+}
+
+static uint32_t STDCALL boot_stage_network_start(BOOT_STAGE *stage, void *data)
+{
+	return boot_stage_poll(network_start_completed);
+}
+
+static void boot_stage_module_start(void)
+{
+	BOOT_STAGE *filesystem;
+	BOOT_STAGE *drive;
+
+	if (bootstage.started == BOOT_STAGE_MODULE_STARTED)
+		return;
+
+	if (!__sync_bool_compare_and_swap(&bootstage.started, BOOT_STAGE_MODULE_STOPPED, BOOT_STAGE_MODULE_STARTING))
+	{
+		while (bootstage.started != BOOT_STAGE_MODULE_STARTED)
+			thread_yield();
+		return;
+	}
+
+	bootstage.lock = mutex_create();
+	bootstage.nextcpu = 0;
+
+	boot_timeline_record("boot", BOOT_EVENT_INIT, ERROR_SUCCESS);
+
+	/* Core stages are created here but only run when needed */
+	filesystem = boot_stage_create_locked(BOOT_STAGE_FILESYSTEM, boot_stage_filesystem_start, NULL, CPU_ID_ALL, BOOT_STAGE_FLAG_NONE);
+	drive = boot_stage_create_locked(BOOT_STAGE_DRIVE_C, boot_stage_drive_c_start, NULL, CPU_ID_ALL, BOOT_STAGE_FLAG_NONE);
+	if (filesystem && drive)
+		drive->dependencies[drive->dependencycount++] = filesystem;
+	boot_stage_create_locked(BOOT_STAGE_NETWORK, boot_stage_network_start, NULL, CPU_ID_ALL, BOOT_STAGE_FLAG_NONE);
+
+	__sync_synchronize();
+	bootstage.started = BOOT_STAGE_MODULE_STARTED;
+}
+
+static BOOT_STAGE *boot_stage_check(BOOT_STAGE *stage)
+{
+	if (!stage || stage->signature != BOOT_STAGE_SIGNATURE)
+		return NULL;
+
+	return stage;
+}
+
+/* Caller must hold the module lock */
+static BOOT_STAGE *boot_stage_find_locked(const char *name)
+{
+	BOOT_STAGE *stage;
+
+	for (stage = bootstage.first; stage; stage = stage->next)
+	{
+		if (strcmp(stage->name, name) == 0)
+			return stage;
+	}
+
+	return NULL;
+}
+
+/* Caller must hold the module lock (Or be starting the module) */
+static BOOT_STAGE *boot_stage_create_locked(const char *name, boot_stage_start_proc start, void *data, uint32_t cpu, uint32_t flags)
+{
+	BOOT_STAGE *stage;
+
+	if (boot_stage_find_locked(name))
+		return NULL;
+
+	stage = calloc(1, sizeof(BOOT_STAGE));
+	if (!stage)
+		return NULL;
+
+	stage->ready = completion_create(COMPLETION_FLAG_NONE);
+	if (stage->ready == INVALID_HANDLE_VALUE)
+	{
+		free(stage);
+		return NULL;
+	}
+
+	strncpy(stage->name, name, BOOT_STAGE_NAME_LENGTH - 1);
+	stage->start = start;
+	stage->data = data;
+	stage->cpu = cpu;
+	stage->flags = flags;
+	stage->state = BOOT_STAGE_STATE_NONE;
+	stage->status = ERROR_SUCCESS;
+	stage->thread = INVALID_HANDLE_VALUE;
+	stage->signature = BOOT_STAGE_SIGNATURE;
+
+	if (bootstage.last)
+		bootstage.last->next = stage;
+	else
+		bootstage.first = stage;
+	bootstage.last = stage;
+
+	return stage;
+}
+
+/* Check if target can be reached from stage by following dependencies, caller must hold the module lock */
+static BOOL boot_stage_reaches(BOOT_STAGE *stage, BOOT_STAGE *target)
+{
+	uint32_t count;
+
+	if (stage == target)
+		return TRUE;
+
+	for (count = 0; count < stage->dependencycount; count++)
+	{
+		if (boot_stage_reaches(stage->dependencies[count], target))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static ssize_t STDCALL boot_stage_execute(void *parameter)
+{
+	BOOT_STAGE *stage = (BOOT_STAGE *)parameter;
+	BOOT_STAGE *dependency;
+	uint32_t status;
+	uint32_t count;
+
+	/* Dependencies were started first so every completion will be completed */
+	status = ERROR_SUCCESS;
+	for (count = 0; count < stage->dependencycount; count++)
+	{
+		dependency = stage->dependencies[count];
+		completion_wait(dependency->ready, INFINITE);
+
+		if (dependency->state != BOOT_STAGE_STATE_READY && (dependency->flags & BOOT_STAGE_FLAG_OPTIONAL) == 0)
+			status = BOOT_STAGE_DEPENDENCY_FAILED;
+	}
+
+	if (status == ERROR_SUCCESS)
+	{
+		stage->state = BOOT_STAGE_STATE_RUNNING;
+		boot_timeline_record(stage->name, BOOT_EVENT_START, ERROR_SUCCESS);
+
+		status = stage->start(stage, stage->data);
+	}
+
+	stage->status = status;
+	stage->state = (status == ERROR_SUCCESS) ? BOOT_STAGE_STATE_READY : BOOT_STAGE_STATE_FAILED;
+	boot_timeline_record(stage->name, (status == ERROR_SUCCESS) ? BOOT_EVENT_READY : BOOT_EVENT_FAILED, status);
+
+	/* State and status must be visible before any waiter is released */
+	__sync_synchronize();
+	completion_complete_all(stage->ready);
+
+	return 0;
+}
+
+/* Start a stage and any of its dependencies not yet started, caller must hold the module lock */
+static uint32_t boot_stage_start_locked(BOOT_STAGE *stage)
+{
+	uint32_t cpucount;
+	uint32_t count;
+	uint32_t cpu;
+
+	if (stage->state != BOOT_STAGE_STATE_NONE)
+		return ERROR_SUCCESS;
+
+	for (count = 0; count < stage->dependencycount; count++)
+	{
+		if (boot_stage_start_locked(stage->dependencies[count]) != ERROR_SUCCESS)
+			return ERROR_OPERATION_FAILED;
+	}
+
+	/* Spread stages over the secondary CPUs, a single CPU board uses CPU 0 */
+	cpu = stage->cpu;
+	if (cpu == CPU_ID_ALL)
+	{
+		cpucount = cpu_get_count();
+		cpu = CPU_ID_0;
+		if (cpucount > 1)
+			cpu = CPU_ID_1 + (bootstage.nextcpu++ % (cpucount - 1));
+	}
+
+	stage->state = BOOT_STAGE_STATE_WAITING;
+	stage->thread = thread_create_ex(boot_stage_execute, BOOT_STAGE_THREAD_STACK_SIZE, BOOT_STAGE_THREAD_PRIORITY, 1 << cpu, cpu, BOOT_STAGE_THREAD_NAME, stage);
+	if (stage->thread == INVALID_HANDLE_VALUE)
+	{
+		stage->state = BOOT_STAGE_STATE_NONE;
+		return ERROR_OPERATION_FAILED;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Boot Stage Functions */
+BOOT_STAGE * STDCALL boot_stage_create(const char *name, boot_stage_start_proc start, void *data, uint32_t cpu, uint32_t flags)
+{
+	BOOT_STAGE *stage;
+
+	if (!name || name[0] == '\0' || strlen(name) >= BOOT_STAGE_NAME_LENGTH || !start)
+		return NULL;
+
+	if (cpu != CPU_ID_ALL && cpu >= cpu_get_count())
+		return NULL;
+
+	boot_stage_module_start();
+
+	if (mutex_lock(bootstage.lock) != ERROR_SUCCESS)
+		return NULL;
+
+	stage = boot_stage_create_locked(name, start, data, cpu, flags);
+
+	mutex_unlock(bootstage.lock);
+
+	return stage;
+}
+
+uint32_t STDCALL boot_stage_depends(BOOT_STAGE *stage, BOOT_STAGE *dependency)
+{
+	uint32_t status;
+	uint32_t count;
+
+	if (!boot_stage_check(stage) || !boot_stage_check(dependency))
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(bootstage.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	status = ERROR_SUCCESS;
+	for (count = 0; count < stage->dependencycount; count++)
+	{
+		if (stage->dependencies[count] == dependency)
+			goto done;
+	}
+
+	/* A stage cannot gain dependencies once its thread is waiting on them */
+	if (stage->state != BOOT_STAGE_STATE_NONE)
+		status = ERROR_IN_USE;
+	else if (stage->dependencycount >= BOOT_STAGE_MAX_DEPENDENCIES)
+		status = ERROR_INSUFFICIENT_BUFFER;
+	else if (boot_stage_reaches(dependency, stage))
+		status = ERROR_INVALID_PARAMETER;
+	else
+		stage->dependencies[stage->dependencycount++] = dependency;
+
+done:
+	mutex_unlock(bootstage.lock);
+
+	return status;
+}
+
+uint32_t STDCALL boot_stage_start(BOOT_STAGE *stage)
+{
+	uint32_t status;
+
+	if (!boot_stage_check(stage))
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(bootstage.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	status = boot_stage_start_locked(stage);
+
+	mutex_unlock(bootstage.lock);
+
+	return status;
+}
+
+uint32_t STDCALL boot_stage_start_all(void)
+{
+	BOOT_STAGE *stage;
+	uint32_t status;
+
+	boot_stage_module_start();
+
+	if (mutex_lock(bootstage.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	status = ERROR_SUCCESS;
+	for (stage = bootstage.first; stage && status == ERROR_SUCCESS; stage = stage->next)
+		status = boot_stage_start_locked(stage);
+
+	mutex_unlock(bootstage.lock);
+
+	return status;
+}
+
+BOOT_STAGE * STDCALL boot_stage_find(const char *name)
+{
+	BOOT_STAGE *stage;
+
+	if (!name)
+		return NULL;
+
+	boot_stage_module_start();
+
+	if (mutex_lock(bootstage.lock) != ERROR_SUCCESS)
+		return NULL;
+
+	stage = boot_stage_find_locked(name);
+
+	mutex_unlock(bootstage.lock);
+
+	return stage;
+}
+
+uint32_t STDCALL boot_stage_wait(BOOT_STAGE *stage, uint32_t timeout)
+{
+	uint32_t status;
+
+	if (!boot_stage_check(stage))
+		return ERROR_INVALID_PARAMETER;
+
+	/* Nothing is recorded once the stage has finished */
+	if (stage->state != BOOT_STAGE_STATE_READY && stage->state != BOOT_STAGE_STATE_FAILED)
+	{
+		if (stage->state == BOOT_STAGE_STATE_NONE)
+		{
+			status = boot_stage_start(stage);
+			if (status != ERROR_SUCCESS)
+				return status;
+		}
+
+		boot_timeline_record(stage->name, BOOT_EVENT_WAIT, ERROR_SUCCESS);
+
+		status = completion_wait(stage->ready, timeout);
+		if (status != ERROR_SUCCESS)
+			return status;
+	}
+
+	if (stage->state == BOOT_STAGE_STATE_READY)
+		return ERROR_SUCCESS;
+
+	return stage->status;
+}
+
+uint32_t STDCALL boot_stage_wait_name(const char *name, uint32_t timeout)
+{
+	BOOT_STAGE *stage;
+
+	stage = boot_stage_find(name);
+	if (!stage)
+		return ERROR_NOT_FOUND;
+
+	return boot_stage_wait(stage, timeout);
+}
+
+uint32_t STDCALL boot_stage_get_state(BOOT_STAGE *stage)
+{
+	if (!boot_stage_check(stage))
+		return BOOT_STAGE_STATE_NONE;
+
+	return stage->state;
+}
+
+uint32_t STDCALL boot_stage_get_status(BOOT_STAGE *stage)
+{
+	if (!boot_stage_check(stage))
+		return ERROR_INVALID_PARAMETER;
+
+	return stage->status;
+}
+
+uint32_t STDCALL boot_stage_get_name(BOOT_STAGE *stage, char *name, uint32_t len)
+{
+	if (!boot_stage_check(stage) || !name || len == 0)
+		return 0;
+
+	strncpy(name, stage->name, len - 1);
+	name[len - 1] = '\0';
+
+	return strlen(name);
+}
+
+/* ============================================================================== */
+/* Boot Timeline Functions */
+uint32_t STDCALL boot_timeline_mark(const char *name)
+{
+	if (!name)
+		return ERROR_INVALID_PARAMETER;
+
+	boot_stage_module_start();
+
+	boot_timeline_record(name, BOOT_EVENT_MARK, ERROR_SUCCESS);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL boot_timeline_get(BOOT_TIMELINE_ENTRY *entries, uint32_t len, uint32_t *count)
+{
+	uint32_t recorded;
+	uint32_t index;
+
+	if (!entries && len > 0)
+		return ERROR_INVALID_PARAMETER;
+
+	boot_stage_module_start();
+
+	recorded = bootstage.timelinecount;
+	for (index = 0; index < recorded && index < len && index < BOOT_TIMELINE_MAX_ENTRIES; index++)
+		entries[index] = bootstage.timeline[index];
+
+	if (count)
+		*count = recorded;
+
+	return ERROR_SUCCESS;
+}
+
+static void STDCALL boot_timeline_logging_output(const char *text, void *data)
+{
+	logging_output(text);
+}
+
+uint32_t STDCALL boot_timeline_log(boot_timeline_output_cb output, void *data)
+{
+	const BOOT_TIMELINE_ENTRY *entry;
+	char event[32];
+	char text[128];
+	uint32_t recorded;
+	uint32_t index;
+	int64_t previous;
+
+	if (!output)
+		output = boot_timeline_logging_output;
+
+	boot_stage_module_start();
+
+	recorded = bootstage.timelinecount;
+	if (recorded > BOOT_TIMELINE_MAX_ENTRIES)
+		recorded = BOOT_TIMELINE_MAX_ENTRIES;
+
+	output("Boot timeline (Microseconds since clock start, time since previous entry)", data);
+
+	previous = bootstage.timeline[0].time;
+	for (index = 0; index < recorded; index++)
+	{
+		entry = &bootstage.timeline[index];
+		if (entry->event == BOOT_EVENT_NONE)
+			continue;
+
+		boot_event_to_string(entry->event, event, sizeof(event));
+		if (entry->event == BOOT_EVENT_FAILED)
+			snprintf(text, sizeof(text), "%10lld +%8lld CPU%u %-17s %s (Status %u)", (long long)entry->time, (long long)(entry->time - previous), (unsigned int)entry->cpu, event, entry->name, (unsigned int)entry->status);
+		else
+			snprintf(text, sizeof(text), "%10lld +%8lld CPU%u %-17s %s", (long long)entry->time, (long long)(entry->time - previous), (unsigned int)entry->cpu, event, entry->name);
+		output(text, data);
+
+		previous = entry->time;
+	}
+
+	if (bootstage.timelinecount > BOOT_TIMELINE_MAX_ENTRIES)
+	{
+		snprintf(text, sizeof(text), "%u entries not recorded", (unsigned int)(bootstage.timelinecount - BOOT_TIMELINE_MAX_ENTRIES));
+		output(text, data);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Boot Stage Helper Functions */
+/* Return the name of a boot stage state */
+uint32_t STDCALL boot_stage_state_to_string(uint32_t state, char *string, uint32_t len)
+{
+	const char *name;
+
+	switch (state)
+	{
+		case BOOT_STAGE_STATE_WAITING:
+			name = "BOOT_STAGE_STATE_WAITING";
+			break;
+		case BOOT_STAGE_STATE_RUNNING:
+			name = "BOOT_STAGE_STATE_RUNNING";
+			break;
+		case BOOT_STAGE_STATE_READY:
+			name = "BOOT_STAGE_STATE_READY";
+			break;
+		case BOOT_STAGE_STATE_FAILED:
+			name = "BOOT_STAGE_STATE_FAILED";
+			break;
+		default:
+			name = "BOOT_STAGE_STATE_NONE";
+	}
+
+	if (string != NULL && len > 0)
+	{
+		strncpy(string, name, len - 1);
+		string[len - 1] = '\0';
+	}
+
+	return strlen(name);
+}
+
+/* Return the name of a boot timeline event */
+uint32_t STDCALL boot_event_to_string(uint32_t event, char *string, uint32_t len)
+{
+	const char *name;
+
+	switch (event)
+	{
+		case BOOT_EVENT_INIT:
+			name = "BOOT_EVENT_INIT";
+			break;
+		case BOOT_EVENT_START:
+			name = "BOOT_EVENT_START";
+			break;
+		case BOOT_EVENT_READY:
+			name = "BOOT_EVENT_READY";
+			break;
+		case BOOT_EVENT_FAILED:
+			name = "BOOT_EVENT_FAILED";
+			break;
+		case BOOT_EVENT_WAIT:
+			name = "BOOT_EVENT_WAIT";
+			break;
+		case BOOT_EVENT_MARK:
+			name = "BOOT_EVENT_MARK";
+			break;
+		default:
+			name = "BOOT_EVENT_NONE";
+	}
+
+	if (string != NULL && len > 0)
+	{
+		strncpy(string, name, len - 1);
+		string[len - 1] = '\0';
+	}
+
+	return strlen(name);
+}
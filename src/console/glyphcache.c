@@ -0,0 +1,881 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/glyphcache.h"
+
+/* Implementation of the glyph cache and accelerated console text for Ultibo API
+ *
+ * The standard console text functions rasterize each character from the font
+ * bitmap one pixel at a time. A glyph cache holds each character already expanded
+ * to framebuffer pixels for a given font, foreground and background color so a
+ * run of text is built by copying whole glyph rows into a line buffer which is
+ * then written to the framebuffer with a single framebuffer_device_put_rect.
+ *
+ * Glyphs are expanded on first use and each cache keeps a fixed number of
+ * (Font, Forecolor, Backcolor) entries, the least recently used entry is
+ * discarded when a new combination is needed.
+ *
+ * Attaching a cache to a console device replaces the draw text, draw char and
+ * scroll methods of the device, scrolling moves the framebuffer memory directly
+ * instead of copying through the framebuffer device unless the framebuffer has a
+ * device specific copy rect method, in which case framebuffer_device_copy_rect is
+ * used (eg after framebuffer_device_dma_attach, see ultibo/framebufferdma.h). As
+ * with the standard method the vacated area is left for the caller to clear.
+ */
+
+/* Maximum number of console devices with an attached Glyph cache */
+#define GLYPH_CONSOLE_MAX	8
+
+/* Glyph Entry */
+typedef struct _GLYPH_ENTRY GLYPH_ENTRY;
+struct _GLYPH_ENTRY
+{
+	FONT_HANDLE font; // The font for this entry (NULL if the entry is free)
+	void *chardata; // Character data of the font when the entry was created (Detects a reused handle)
+	uint32_t forecolor; // Foreground color (COLOR_FORMAT_DEFAULT)
+	uint32_t backcolor; // Background color (COLOR_FORMAT_DEFAULT)
+	uint32_t charwidth; // Font character width in pixels
+	uint32_t charheight; // Font character height in pixels
+	uint32_t charcount; // Number of glyphs in the font
+	uint32_t rowbytes; // Bytes per expanded glyph row
+	uint32_t glyphbytes; // Bytes per expanded glyph
+	uint32_t lastused; // Cache clock value when this entry was last used
+	uint8_t fore[4]; // Foreground color in the cache format
+	uint8_t back[4]; // Background color in the cache format
+	uint8_t *expanded; // One byte per glyph, non zero if the glyph has been expanded
+	uint8_t *pixels; // Expanded glyphs (charcount * glyphbytes)
+};
+
+/* Glyph Cache */
+struct _GLYPH_CACHE
+{
+	uint32_t format; // Color format of expanded glyphs (eg COLOR_FORMAT_ARGB32)
+	uint32_t bytes; // Bytes per pixel of the color format
+	BOOL reverse; // Swap red and blue when converting colors (eg CONSOLE_FLAG_COLOR_REVERSE)
+	MUTEX_HANDLE lock; // Cache lock
+	uint32_t clock; // Incremented on each lookup for least recently used replacement
+	uint32_t maxentries; // Number of entries
+	GLYPH_ENTRY *entries;
+	GLYPH_CACHE_STATISTICS statistics;
+};
+
+/* Glyph Console */
+typedef struct _GLYPH_CONSOLE GLYPH_CONSOLE;
+struct _GLYPH_CONSOLE
+{
+	CONSOLE_DEVICE *console; // The console device (NULL if the slot is free)
+	FRAMEBUFFER_DEVICE *framebuffer; // The framebuffer device the console draws on
+	uint32_t flags; // Glyph cache flags (eg GLYPH_CACHE_FLAG_TEXT)
+	GLYPH_CACHE *cache; // The Glyph cache for this console
+	uint8_t *linebuffer; // Line buffer for rendering text
+	uint32_t linesize; // Size of the line buffer (Bytes)
+	// Original Console Methods
+	console_device_draw_char_proc drawchar;
+	console_device_draw_text_proc drawtext;
+	console_device_scroll_proc scroll;
+};
+
+static GLYPH_CONSOLE glyph_consoles[GLYPH_CONSOLE_MAX];
+static MUTEX_HANDLE glyph_consoles_lock = INVALID_HANDLE_VALUE;
+
+/* ============================================================================== */
+/* Glyph Cache Internal Functions */
+static BOOL glyph_font_supported(FONT_ENTRY *font)
+{
+	if (!font || font->signature != FONT_SIGNATURE)
+		return FALSE;
+
+	if (font->fontmode != FONT_MODE_PIXEL || !font->chardata)
+		return FALSE;
+
+	if (font->charwidth < 1 || font->charwidth > FONT_MAX_WIDTH || font->charheight < 1 || font->charheight > FONT_MAX_HEIGHT)
+		return FALSE;
+
+	return TRUE;
+}
+
+static uint32_t glyph_font_row(FONT_ENTRY *font, uint32_t index, uint32_t row)
+{
+	uint32_t offset = (index * font->charheight) + row;
+	uint32_t value;
+
+	/* Characters are stored in 8, 16 or 32 bit rows according to the width */
+	if (font->charwidth <= 8)
+		return ((uint8_t *)font->chardata)[offset];
+
+	if (font->charwidth <= 16)
+	{
+		value = ((uint16_t *)font->chardata)[offset];
+		if (font->fontflags & FONT_FLAG_BIGENDIAN)
+			value = __builtin_bswap16(value);
+
+		return value;
+	}
+
+	value = ((uint32_t *)font->chardata)[offset];
+	if (font->fontflags & FONT_FLAG_BIGENDIAN)
+		value = __builtin_bswap32(value);
+
+	return value;
+}
+
+static void glyph_entry_free(GLYPH_CACHE *cache, GLYPH_ENTRY *entry)
+{
+	if (!entry->font)
+		return;
+
+	cache->statistics.entrycount--;
+	cache->statistics.memoryused -= entry->charcount * (entry->glyphbytes + 1);
+
+	free(entry->pixels);
+	free(entry->expanded);
+
+	memset(entry, 0, sizeof(GLYPH_ENTRY));
+}
+
+static GLYPH_ENTRY *glyph_entry_find(GLYPH_CACHE *cache, FONT_ENTRY *font, uint32_t forecolor, uint32_t backcolor)
+{
+	GLYPH_ENTRY *entry;
+	GLYPH_ENTRY *oldest;
+	uint32_t index;
+
+	cache->clock++;
+
+	/* Check for an existing entry */
+	oldest = &cache->entries[0];
+	for (index = 0; index < cache->maxentries; index++)
+	{
+		entry = &cache->entries[index];
+		if (entry->font == (FONT_HANDLE)font && entry->forecolor == forecolor && entry->backcolor == backcolor)
+		{
+			/* Discard the entry if the handle now refers to a different font */
+			if (entry->chardata != font->chardata || entry->charwidth != font->charwidth || entry->charheight != font->charheight || entry->charcount != font->charcount)
+			{
+				glyph_entry_free(cache, entry);
+				oldest = entry;
+				break;
+			}
+
+			entry->lastused = cache->clock;
+			cache->statistics.hitcount++;
+
+			return entry;
+		}
+
+		/* Track the free or least recently used entry */
+		if (oldest->font && (!entry->font || entry->lastused < oldest->lastused))
+			oldest = entry;
+	}
+
+	/* Replace the free or least recently used entry */
+	entry = oldest;
+	if (entry->font)
+	{
+		glyph_entry_free(cache, entry);
+		cache->statistics.evictcount++;
+	}
+
+	entry->rowbytes = font->charwidth * cache->bytes;
+	entry->glyphbytes = entry->rowbytes * font->charheight;
+	entry->expanded = calloc(font->charcount, 1);
+	entry->pixels = malloc(font->charcount * entry->glyphbytes);
+	if (!entry->expanded || !entry->pixels)
+	{
+		free(entry->expanded);
+		free(entry->pixels);
+		memset(entry, 0, sizeof(GLYPH_ENTRY));
+
+		return NULL;
+	}
+
+	entry->font = (FONT_HANDLE)font;
+	entry->chardata = font->chardata;
+	entry->forecolor = forecolor;
+	entry->backcolor = backcolor;
+	entry->charwidth = font->charwidth;
+	entry->charheight = font->charheight;
+	entry->charcount = font->charcount;
+	entry->lastused = cache->clock;
+	glyph_color_to_format(forecolor, cache->format, entry->fore, cache->reverse);
+	glyph_color_to_format(backcolor, cache->format, entry->back, cache->reverse);
+
+	cache->statistics.entrycount++;
+	cache->statistics.memoryused += entry->charcount * (entry->glyphbytes + 1);
+	cache->statistics.misscount++;
+
+	return entry;
+}
+
+static void glyph_entry_expand(GLYPH_CACHE *cache, GLYPH_ENTRY *entry, uint32_t index)
+{
+	FONT_ENTRY *font = (FONT_ENTRY *)entry->font;
+	uint8_t *dest;
+	uint32_t value;
+	uint32_t row;
+	uint32_t col;
+
+	dest = entry->pixels + (index * entry->glyphbytes);
+	for (row = 0; row < entry->charheight; row++)
+	{
+		/* The leftmost pixel is the highest bit of the character width */
+		value = glyph_font_row(font, index, row);
+		for (col = 0; col < entry->charwidth; col++)
+		{
+			memcpy(dest, (value & (1 << (entry->charwidth - 1 - col))) ? entry->fore : entry->back, cache->bytes);
+			dest += cache->bytes;
+		}
+	}
+
+	entry->expanded[index] = 1;
+	cache->statistics.expandcount++;
+}
+
+static GLYPH_CONSOLE *glyph_console_find(CONSOLE_DEVICE *console)
+{
+	uint32_t index;
+
+	for (index = 0; index < GLYPH_CONSOLE_MAX; index++)
+	{
+		if (glyph_consoles[index].console == console)
+			return &glyph_consoles[index];
+	}
+
+	return NULL;
+}
+
+static BOOL glyph_console_direct(GLYPH_CONSOLE *entry)
+{
+	/* Direct access needs a linear unrotated framebuffer that does not require mark or commit */
+	if (entry->framebuffer->address == 0 || entry->framebuffer->rotation != FRAMEBUFFER_ROTATION_0)
+		return FALSE;
+
+	if (entry->framebuffer->device.deviceflags & (FRAMEBUFFER_FLAG_MARK | FRAMEBUFFER_FLAG_COMMIT))
+		return FALSE;
+
+	return TRUE;
+}
+
+static uint32_t STDCALL glyph_console_draw_text(CONSOLE_DEVICE *console, FONT_HANDLE handle, const char *text, uint32_t x, uint32_t y, uint32_t forecolor, uint32_t backcolor, uint32_t len)
+{
+	GLYPH_CONSOLE *entry;
+	FONT_ENTRY *font = (FONT_ENTRY *)handle;
+	uint32_t status;
+	uint32_t count;
+	uint32_t rows;
+	uint32_t size;
+
+	entry = glyph_console_find(console);
+	if (!entry)
+		return ERROR_NOT_FOUND;
+
+	/* Use the original method for fonts that cannot be cached */
+	if (!glyph_font_supported(font) || console->format != entry->cache->format)
+		return entry->drawtext(console, handle, text, x, y, forecolor, backcolor, len);
+
+	if (!text)
+		return ERROR_INVALID_PARAMETER;
+	if (x >= console->width || y >= console->height)
+		return ERROR_INVALID_PARAMETER;
+	if (len == 0)
+		return ERROR_SUCCESS;
+
+	/* Clip to the console */
+	count = (console->width - x) / font->charwidth;
+	if (count > len)
+		count = len;
+	if (count == 0)
+		return ERROR_SUCCESS;
+
+	rows = font->charheight;
+	if (rows > console->height - y)
+		rows = console->height - y;
+
+	if (mutex_lock(console->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	/* Grow the line buffer if needed */
+	size = count * font->charwidth * font->charheight * entry->cache->bytes;
+	if (size > entry->linesize)
+	{
+		free(entry->linebuffer);
+
+		entry->linesize = console->width * font->charheight * entry->cache->bytes;
+		entry->linebuffer = malloc(entry->linesize);
+		if (!entry->linebuffer)
+		{
+			entry->linesize = 0;
+
+			mutex_unlock(console->lock);
+			return ERROR_NOT_ENOUGH_MEMORY;
+		}
+	}
+
+	/* Render the whole run and write it with a single blit */
+	status = glyph_cache_render_text(entry->cache, handle, text, count, forecolor, backcolor, entry->linebuffer, count * font->charwidth * entry->cache->bytes);
+	if (status == ERROR_SUCCESS)
+		status = framebuffer_device_put_rect(entry->framebuffer, x, y, entry->linebuffer, count * font->charwidth, rows, 0, FRAMEBUFFER_TRANSFER_NONE);
+
+	console->drawcount++;
+
+	mutex_unlock(console->lock);
+
+	return status;
+}
+
+static uint32_t STDCALL glyph_console_draw_char(CONSOLE_DEVICE *console, FONT_HANDLE handle, char ch, uint32_t x, uint32_t y, uint32_t forecolor, uint32_t backcolor)
+{
+	GLYPH_CONSOLE *entry;
+
+	entry = glyph_console_find(console);
+	if (!entry)
+		return ERROR_NOT_FOUND;
+
+	if (!glyph_font_supported((FONT_ENTRY *)handle) || console->format != entry->cache->format)
+		return entry->drawchar(console, handle, ch, x, y, forecolor, backcolor);
+
+	return glyph_console_draw_text(console, handle, &ch, x, y, forecolor, backcolor, 1);
+}
+
+static uint32_t STDCALL glyph_console_scroll(CONSOLE_DEVICE *console, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2, uint32_t count, uint32_t direction)
+{
+	GLYPH_CONSOLE *entry;
+	FRAMEBUFFER_DEVICE *framebuffer;
+	uint8_t *address;
+	uint32_t pitch;
+	uint32_t bytes;
+	uint32_t width;
+	uint32_t height;
+	uint32_t row;
+	uint32_t status;
+
+	entry = glyph_console_find(console);
+	if (!entry)
+		return ERROR_NOT_FOUND;
+
+	if (!glyph_console_direct(entry))
+		return entry->scroll(console, x1, y1, x2, y2, count, direction);
+
+	if (x1 > x2 || y1 > y2 || x2 >= console->width || y2 >= console->height)
+		return ERROR_INVALID_PARAMETER;
+	if (count == 0)
+		return ERROR_INVALID_PARAMETER;
+
+	framebuffer = entry->framebuffer;
+	bytes = entry->cache->bytes;
+	pitch = framebuffer->pitch;
+	width = x2 - x1 + 1;
+	height = y2 - y1 + 1;
+
+	if (mutex_lock(console->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	/* Use the framebuffer copy rect if the device provides its own (usually accelerated) method */
+	if (framebuffer->devicecopyrect)
+	{
+		status = ERROR_SUCCESS;
+		switch (direction)
+		{
+			case CONSOLE_DIRECTION_UP:
+				if (count < height)
+					status = framebuffer_device_copy_rect(framebuffer, x1, y1 + count, x1, y1, width, height - count, FRAMEBUFFER_TRANSFER_NONE);
+				break;
+			case CONSOLE_DIRECTION_DOWN:
+				if (count < height)
+					status = framebuffer_device_copy_rect(framebuffer, x1, y1, x1, y1 + count, width, height - count, FRAMEBUFFER_TRANSFER_NONE);
+				break;
+			case CONSOLE_DIRECTION_LEFT:
+				if (count < width)
+					status = framebuffer_device_copy_rect(framebuffer, x1 + count, y1, x1, y1, width - count, height, FRAMEBUFFER_TRANSFER_NONE);
+				break;
+			case CONSOLE_DIRECTION_RIGHT:
+				if (count < width)
+					status = framebuffer_device_copy_rect(framebuffer, x1, y1, x1 + count, y1, width - count, height, FRAMEBUFFER_TRANSFER_NONE);
+				break;
+		}
+
+		if (status == ERROR_SUCCESS)
+		{
+			entry->cache->statistics.scrollcount++;
+			console->scrollcount++;
+		}
+
+		mutex_unlock(console->lock);
+		return status;
+	}
+
+	if (mutex_lock(framebuffer->lock) != ERROR_SUCCESS)
+	{
+		mutex_unlock(console->lock);
+		return ERROR_CAN_NOT_COMPLETE;
+	}
+
+	address = (uint8_t *)framebuffer->address + (y1 * pitch) + (x1 * bytes);
+
+	/* Move each row in an order that never overwrites rows still to be moved */
+	switch (direction)
+	{
+		case CONSOLE_DIRECTION_UP:
+			for (row = 0; count < height && row < height - count; row++)
+				memmove(address + (row * pitch), address + ((row + count) * pitch), width * bytes);
+			break;
+		case CONSOLE_DIRECTION_DOWN:
+			for (row = height; count < height && row > count; row--)
+				memmove(address + ((row - 1) * pitch), address + ((row - 1 - count) * pitch), width * bytes);
+			break;
+		case CONSOLE_DIRECTION_LEFT:
+			for (row = 0; count < width && row < height; row++)
+				memmove(address + (row * pitch), address + (row * pitch) + (count * bytes), (width - count) * bytes);
+			break;
+		case CONSOLE_DIRECTION_RIGHT:
+			for (row = 0; count < width && row < height; row++)
+				memmove(address + (row * pitch) + (count * bytes), address + (row * pitch), (width - count) * bytes);
+			break;
+	}
+
+	/* Write back the moved rows if the framebuffer is cached */
+	if (framebuffer->device.deviceflags & FRAMEBUFFER_FLAG_CACHED)
+		clean_data_cache_range((size_t)address, height * pitch);
+
+	entry->cache->statistics.scrollcount++;
+	console->scrollcount++;
+
+	mutex_unlock(framebuffer->lock);
+	mutex_unlock(console->lock);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Glyph Cache Functions */
+GLYPH_CACHE * STDCALL glyph_cache_create(uint32_t format, uint32_t maxentries)
+{
+	GLYPH_CACHE *cache;
+
+	if (glyph_color_format_bytes(format) == 0)
+		return NULL;
+
+	if (maxentries == 0)
+		maxentries = GLYPH_CACHE_DEFAULT_ENTRIES;
+	if (maxentries > GLYPH_CACHE_MAX_ENTRIES)
+		maxentries = GLYPH_CACHE_MAX_ENTRIES;
+
+	cache = calloc(1, sizeof(GLYPH_CACHE));
+	if (!cache)
+		return NULL;
+
+	cache->format = format;
+	cache->bytes = glyph_color_format_bytes(format);
+	cache->maxentries = maxentries;
+	cache->entries = calloc(maxentries, sizeof(GLYPH_ENTRY));
+	cache->lock = mutex_create();
+	if (!cache->entries || cache->lock == INVALID_HANDLE_VALUE)
+	{
+		if (cache->lock != INVALID_HANDLE_VALUE)
+			mutex_destroy(cache->lock);
+
+		free(cache->entries);
+		free(cache);
+
+		return NULL;
+	}
+
+	return cache;
+}
+
+uint32_t STDCALL glyph_cache_destroy(GLYPH_CACHE *cache)
+{
+	if (!cache)
+		return ERROR_INVALID_PARAMETER;
+
+	glyph_cache_flush(cache);
+
+	mutex_destroy(cache->lock);
+	free(cache->entries);
+	free(cache);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL glyph_cache_flush(GLYPH_CACHE *cache)
+{
+	uint32_t index;
+
+	if (!cache)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	for (index = 0; index < cache->maxentries; index++)
+	{
+		glyph_entry_free(cache, &cache->entries[index]);
+	}
+
+	mutex_unlock(cache->lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL glyph_cache_render_text(GLYPH_CACHE *cache, FONT_HANDLE font, const char *text, uint32_t len, uint32_t forecolor, uint32_t backcolor, void *buffer, uint32_t pitch)
+{
+	GLYPH_ENTRY *entry;
+	uint8_t *dest;
+	uint32_t index;
+	uint32_t row;
+	uint32_t glyph;
+
+	if (!cache || !text || !buffer)
+		return ERROR_INVALID_PARAMETER;
+
+	if (!glyph_font_supported((FONT_ENTRY *)font))
+		return ERROR_NOT_SUPPORTED;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	entry = glyph_entry_find(cache, (FONT_ENTRY *)font, forecolor, backcolor);
+	if (!entry)
+	{
+		mutex_unlock(cache->lock);
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
+
+	if (pitch < len * entry->rowbytes)
+	{
+		mutex_unlock(cache->lock);
+		return ERROR_INSUFFICIENT_BUFFER;
+	}
+
+	/* Expand any glyphs not yet in the cache */
+	for (index = 0; index < len; index++)
+	{
+		glyph = (uint8_t)text[index];
+		if (glyph >= entry->charcount)
+			glyph = 0;
+
+		if (!entry->expanded[glyph])
+			glyph_entry_expand(cache, entry, glyph);
+	}
+
+	/* Copy one row of each glyph at a time so each output row is written sequentially */
+	for (row = 0; row < entry->charheight; row++)
+	{
+		dest = (uint8_t *)buffer + (row * pitch);
+		for (index = 0; index < len; index++)
+		{
+			glyph = (uint8_t)text[index];
+			if (glyph >= entry->charcount)
+				glyph = 0;
+
+			memcpy(dest, entry->pixels + (glyph * entry->glyphbytes) + (row * entry->rowbytes), entry->rowbytes);
+			dest += entry->rowbytes;
+		}
+	}
+
+	cache->statistics.textcount++;
+	cache->statistics.charcount += len;
+
+	mutex_unlock(cache->lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL glyph_cache_get_statistics(GLYPH_CACHE *cache, GLYPH_CACHE_STATISTICS *statistics)
+{
+	if (!cache || !statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(cache->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	memcpy(statistics, &cache->statistics, sizeof(GLYPH_CACHE_STATISTICS));
+
+	mutex_unlock(cache->lock);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Console Glyph Cache Functions */
+uint32_t STDCALL console_device_glyph_cache_attach(CONSOLE_DEVICE *console, FRAMEBUFFER_DEVICE *framebuffer, uint32_t flags)
+{
+	GLYPH_CONSOLE *entry;
+	MUTEX_HANDLE lock;
+
+	if (!console || console->device.signature != DEVICE_SIGNATURE)
+		return ERROR_INVALID_PARAMETER;
+
+	if (console->consolemode != CONSOLE_MODE_PIXEL)
+		return ERROR_NOT_SUPPORTED;
+
+	/* The default console draws on the default framebuffer */
+	if (!framebuffer)
+		framebuffer = framebuffer_device_get_default();
+	if (!framebuffer || framebuffer->device.signature != DEVICE_SIGNATURE)
+		return ERROR_INVALID_PARAMETER;
+
+	if (framebuffer->physicalwidth < console->width || framebuffer->physicalheight < console->height || framebuffer->format != console->format)
+		return ERROR_INVALID_PARAMETER;
+
+	if (glyph_color_format_bytes(console->format) == 0)
+		return ERROR_NOT_SUPPORTED;
+
+	/* Create the global lock on first use */
+	if (glyph_consoles_lock == INVALID_HANDLE_VALUE)
+	{
+		lock = mutex_create();
+		if (lock == INVALID_HANDLE_VALUE)
+			return ERROR_OPERATION_FAILED;
+
+		if (!__sync_bool_compare_and_swap(&glyph_consoles_lock, INVALID_HANDLE_VALUE, lock))
+			mutex_destroy(lock);
+	}
+
+	if (mutex_lock(glyph_consoles_lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	if (glyph_console_find(console))
+	{
+		mutex_unlock(glyph_consoles_lock);
+		return ERROR_ALREADY_EXISTS;
+	}
+
+	entry = glyph_console_find(NULL);
+	if (!entry)
+	{
+		mutex_unlock(glyph_consoles_lock);
+		return ERROR_NO_MORE_ITEMS;
+	}
+
+	entry->cache = glyph_cache_create(console->format, GLYPH_CACHE_DEFAULT_ENTRIES);
+	if (!entry->cache)
+	{
+		mutex_unlock(glyph_consoles_lock);
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
+	entry->cache->reverse = (console->device.deviceflags & CONSOLE_FLAG_COLOR_REVERSE) != 0;
+
+	entry->framebuffer = framebuffer;
+	entry->flags = flags;
+	entry->drawchar = console->devicedrawchar;
+	entry->drawtext = console->devicedrawtext;
+	entry->scroll = console->devicescroll;
+
+	/* Make the entry visible before replacing the console methods */
+	__sync_synchronize();
+	entry->console = console;
+
+	if (mutex_lock(console->lock) == ERROR_SUCCESS)
+	{
+		if (flags & GLYPH_CACHE_FLAG_TEXT)
+		{
+			console->devicedrawchar = glyph_console_draw_char;
+			console->devicedrawtext = glyph_console_draw_text;
+		}
+		if (flags & GLYPH_CACHE_FLAG_SCROLL)
+			console->devicescroll = glyph_console_scroll;
+
+		mutex_unlock(console->lock);
+	}
+
+	mutex_unlock(glyph_consoles_lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL console_device_glyph_cache_detach(CONSOLE_DEVICE *console)
+{
+	GLYPH_CONSOLE *entry;
+
+	if (!console || glyph_consoles_lock == INVALID_HANDLE_VALUE)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(glyph_consoles_lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	entry = glyph_console_find(console);
+	if (!entry)
+	{
+		mutex_unlock(glyph_consoles_lock);
+		return ERROR_NOT_FOUND;
+	}
+
+	/* Restore the original methods, holding the console lock waits for any draw in progress */
+	if (mutex_lock(console->lock) != ERROR_SUCCESS)
+	{
+		mutex_unlock(glyph_consoles_lock);
+		return ERROR_CAN_NOT_COMPLETE;
+	}
+
+	console->devicedrawchar = entry->drawchar;
+	console->devicedrawtext = entry->drawtext;
+	console->devicescroll = entry->scroll;
+
+	mutex_unlock(console->lock);
+
+	glyph_cache_destroy(entry->cache);
+	free(entry->linebuffer);
+
+	memset(entry, 0, sizeof(GLYPH_CONSOLE));
+
+	mutex_unlock(glyph_consoles_lock);
+
+	return ERROR_SUCCESS;
+}
+
+GLYPH_CACHE * STDCALL console_device_glyph_cache_get(CONSOLE_DEVICE *console)
+{
+	GLYPH_CONSOLE *entry;
+
+	if (!console)
+		return NULL;
+
+	entry = glyph_console_find(console);
+	if (!entry)
+		return NULL;
+
+	return entry->cache;
+}
+
+/* ============================================================================== */
+/* Glyph Cache Helper Functions */
+uint32_t STDCALL glyph_color_format_bytes(uint32_t format)
+{
+	switch (format)
+	{
+		case COLOR_FORMAT_ARGB32:
+		case COLOR_FORMAT_ABGR32:
+		case COLOR_FORMAT_RGBA32:
+		case COLOR_FORMAT_BGRA32:
+		case COLOR_FORMAT_URGB32:
+		case COLOR_FORMAT_UBGR32:
+		case COLOR_FORMAT_RGBU32:
+		case COLOR_FORMAT_BGRU32:
+			return 4;
+		case COLOR_FORMAT_RGB24:
+		case COLOR_FORMAT_BGR24:
+			return 3;
+		case COLOR_FORMAT_RGB16:
+		case COLOR_FORMAT_BGR16:
+		case COLOR_FORMAT_RGB15:
+		case COLOR_FORMAT_BGR15:
+			return 2;
+		case COLOR_FORMAT_RGB8:
+		case COLOR_FORMAT_BGR8:
+		case COLOR_FORMAT_GRAY8:
+			return 1;
+	}
+
+	return 0;
+}
+
+uint32_t STDCALL glyph_color_to_format(uint32_t color, uint32_t format, void *dest, BOOL reverse)
+{
+	uint8_t *output = (uint8_t *)dest;
+	uint32_t alpha;
+	uint32_t red;
+	uint32_t green;
+	uint32_t blue;
+	uint32_t value;
+
+	if (!dest)
+		return ERROR_INVALID_PARAMETER;
+
+	/* Color is in COLOR_FORMAT_DEFAULT (ARGB32) */
+	alpha = (color >> 24) & 0xFF;
+	red = (color >> 16) & 0xFF;
+	green = (color >> 8) & 0xFF;
+	blue = color & 0xFF;
+
+	if (reverse)
+	{
+		value = red;
+		red = blue;
+		blue = value;
+	}
+
+	switch (format)
+	{
+		case COLOR_FORMAT_ARGB32:
+		case COLOR_FORMAT_URGB32:
+			value = (alpha << 24) | (red << 16) | (green << 8) | blue;
+			break;
+		case COLOR_FORMAT_ABGR32:
+		case COLOR_FORMAT_UBGR32:
+			value = (alpha << 24) | (blue << 16) | (green << 8) | red;
+			break;
+		case COLOR_FORMAT_RGBA32:
+		case COLOR_FORMAT_RGBU32:
+			value = (red << 24) | (green << 16) | (blue << 8) | alpha;
+			break;
+		case COLOR_FORMAT_BGRA32:
+		case COLOR_FORMAT_BGRU32:
+			value = (blue << 24) | (green << 16) | (red << 8) | alpha;
+			break;
+		case COLOR_FORMAT_RGB24:
+			value = (red << 16) | (green << 8) | blue;
+			break;
+		case COLOR_FORMAT_BGR24:
+			value = (blue << 16) | (green << 8) | red;
+			break;
+		case COLOR_FORMAT_RGB16:
+			value = ((red >> 3) << 11) | ((green >> 2) << 5) | (blue >> 3);
+			break;
+		case COLOR_FORMAT_BGR16:
+			value = ((blue >> 3) << 11) | ((green >> 2) << 5) | (red >> 3);
+			break;
+		case COLOR_FORMAT_RGB15:
+			value = ((red >> 3) << 10) | ((green >> 3) << 5) | (blue >> 3);
+			break;
+		case COLOR_FORMAT_BGR15:
+			value = ((blue >> 3) << 10) | ((green >> 3) << 5) | (red >> 3);
+			break;
+		case COLOR_FORMAT_RGB8:
+			value = ((red >> 5) << 5) | ((green >> 5) << 2) | (blue >> 6);
+			break;
+		case COLOR_FORMAT_BGR8:
+			value = ((blue >> 6) << 6) | ((green >> 5) << 3) | (red >> 5);
+			break;
+		case COLOR_FORMAT_GRAY8:
+			value = ((red * 77) + (green * 150) + (blue * 29)) >> 8;
+			break;
+		default:
+			return ERROR_NOT_SUPPORTED;
+	}
+
+	/* Store in little endian order */
+	output[0] = value & 0xFF;
+	output[1] = (value >> 8) & 0xFF;
+	output[2] = (value >> 16) & 0xFF;
+	output[3] = (value >> 24) & 0xFF;
+
+	return ERROR_SUCCESS;
+}
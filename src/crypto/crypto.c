@@ -0,0 +1,1634 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/crypto.h"
+
+/* Implementation of hashes, HMAC and CRC for the Ultibo API
+ *
+ * Every algorithm has a portable C implementation, the compression functions of
+ * SHA1 and SHA256 and the CRC32 and CRC32C loops also have versions using the
+ * ARMv8 instructions which are selected at runtime when the CPU reports them:
+ *
+ *  AArch64 - ID_AA64ISAR0_EL1 is read to find the SHA1, SHA256 and CRC32
+ *            instructions (As well as AES and PMULL used by cryptocipher.c)
+ *
+ *  AArch32 - ID_ISAR5 is read on ARMv7 builds to find the CRC32 instructions
+ *            of an ARMv8 CPU running in 32bit mode, they are emitted as raw
+ *            opcodes since the compiler is targeting ARMv7
+ *
+ * The Cortex-A53 and Cortex-A72 used by the Raspberry Pi 3 and 4 implement
+ * CRC32 but not the optional Cryptographic Extension, on those boards only the
+ * CRC functions are accelerated.
+ *
+ * crypto_set_features can mask any of the detected instructions so the C path
+ * can be tested and benchmarked on the same board.
+ *
+ * The C CRC uses slicing by 8 tables which are generated on first use along
+ * with the feature detection.
+ */
+
+/* ============================================================================== */
+/* Crypto specific constants */
+#define CRYPTO_STATE_STOPPED	0
+#define CRYPTO_STATE_STARTING	1
+#define CRYPTO_STATE_STARTED	2
+
+#define CRC32_POLYNOMIAL	0xEDB88320 // Reversed IEEE 802.3 polynomial
+#define CRC32C_POLYNOMIAL	0x82F63B78 // Reversed Castagnoli polynomial
+
+#define HMAC_MAX_CHUNK_SIZE	SHA512_CHUNK_SIZE
+
+#if defined(__aarch64__)
+#define CRYPTO_ARM64
+#elif defined(__arm__) && defined(__ARM_ARCH) && (__ARM_ARCH >= 7) && !defined(__thumb__)
+#define CRYPTO_ARM32
+#endif
+
+/* ============================================================================== */
+/* Crypto specific types */
+typedef struct _CRYPTO_STATE CRYPTO_STATE;
+struct _CRYPTO_STATE
+{
+	volatile uint32_t started; // Startup state (eg CRYPTO_STATE_STARTED)
+	uint32_t available; // Features detected on this CPU
+	volatile uint32_t features; // Features currently in use
+	uint32_t crc32[8][256]; // CRC32 slicing tables
+	uint32_t crc32c[8][256]; // CRC32C slicing tables
+};
+
+/* Hash algorithm state */
+typedef union _CRYPTO_HASH_STATE CRYPTO_HASH_STATE;
+union _CRYPTO_HASH_STATE
+{
+	MD5_CONTEXT md5;
+	SHA1_CONTEXT sha1;
+	SHA256_CONTEXT sha256;
+	SHA512_CONTEXT sha512;
+	uint32_t crc;
+};
+
+/* HMAC state */
+typedef struct _CRYPTO_HMAC CRYPTO_HMAC;
+struct _CRYPTO_HMAC
+{
+	uint32_t algorithm; // The underlying hash (eg CRYPTO_HASH_ALG_SHA256)
+	CRYPTO_HASH_STATE inner; // Inner hash with the key xor ipad already added
+	CRYPTO_HASH_STATE outer; // Outer hash with the key xor opad already added
+};
+
+struct _HASH_CONTEXT
+{
+	uint32_t signature; // Signature for entry validation
+	uint32_t algorithm; // Hash algorithm (eg CRYPTO_HASH_ALG_HMAC_SHA1)
+	uint32_t digestsize; // Size of the digest (Bytes)
+	CRYPTO_HMAC initial; // State after the key was added (Used by hash_reset)
+	CRYPTO_HMAC current; // Current state
+};
+
+static CRYPTO_STATE crypto = {CRYPTO_STATE_STOPPED};
+
+/* MD5 per round constants and shifts */
+static const uint32_t md5_k[64] = {
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+
+static const uint8_t md5_r[64] = {
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21};
+
+/* SHA256 round constants */
+static const uint32_t sha256_k[64] __attribute__((aligned(16))) = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+/* SHA512 round constants */
+static const uint64_t sha512_k[80] = {
+	0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+	0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+	0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+	0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+	0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+	0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+	0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+	0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+	0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+	0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+	0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+	0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+	0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+	0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+	0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+	0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+	0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+	0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+	0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+	0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL};
+
+/* ============================================================================== */
+/* Crypto Internal Functions */
+static inline uint32_t crypto_rol32(uint32_t value, uint32_t count)
+{
+	return (value << count) | (value >> (32 - count));
+}
+
+static inline uint32_t crypto_ror32(uint32_t value, uint32_t count)
+{
+	return (value >> count) | (value << (32 - count));
+}
+
+static inline uint64_t crypto_ror64(uint64_t value, uint32_t count)
+{
+	return (value >> count) | (value << (64 - count));
+}
+
+static inline uint32_t crypto_load32_le(const uint8_t *data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static inline uint32_t crypto_load32_be(const uint8_t *data)
+{
+	return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+static inline uint64_t crypto_load64_be(const uint8_t *data)
+{
+	return ((uint64_t)crypto_load32_be(data) << 32) | crypto_load32_be(data + 4);
+}
+
+static inline void crypto_store32_le(uint8_t *data, uint32_t value)
+{
+	data[0] = value;
+	data[1] = value >> 8;
+	data[2] = value >> 16;
+	data[3] = value >> 24;
+}
+
+static inline void crypto_store32_be(uint8_t *data, uint32_t value)
+{
+	data[0] = value >> 24;
+	data[1] = value >> 16;
+	data[2] = value >> 8;
+	data[3] = value;
+}
+
+static inline void crypto_store64_be(uint8_t *data, uint64_t value)
+{
+	crypto_store32_be(data, value >> 32);
+	crypto_store32_be(data + 4, value);
+}
+
+/* Return the ARMv8 instructions reported by the CPU ID registers */
+static uint32_t crypto_detect_features(void)
+{
+	uint32_t features = CRYPTO_FEATURE_NONE;
+
+#if defined(CRYPTO_ARM64)
+	uint64_t isar0;
+
+	__asm__ __volatile__("mrs %0, id_aa64isar0_el1" : "=r" (isar0));
+
+	/* AES field is 1 for AES or 2 for AES and PMULL */
+	if (((isar0 >> 4) & 0xF) >= 1)
+		features |= CRYPTO_FEATURE_AES;
+	if (((isar0 >> 4) & 0xF) >= 2)
+		features |= CRYPTO_FEATURE_PMULL;
+	if (((isar0 >> 8) & 0xF) >= 1)
+		features |= CRYPTO_FEATURE_SHA1;
+	if (((isar0 >> 12) & 0xF) >= 1)
+		features |= CRYPTO_FEATURE_SHA256;
+	if (((isar0 >> 16) & 0xF) >= 1)
+		features |= CRYPTO_FEATURE_CRC32;
+#elif defined(CRYPTO_ARM32)
+	uint32_t isar5;
+
+	/* ID_ISAR5 reads as zero on ARMv7 CPUs */
+	__asm__ __volatile__("mrc p15, 0, %0, c0, c2, 5" : "=r" (isar5));
+
+	if (((isar5 >> 16) & 0xF) >= 1)
+		features |= CRYPTO_FEATURE_CRC32;
+#endif
+
+	return features;
+}
+
+static void crypto_crc_tables(uint32_t table[8][256], uint32_t polynomial)
+{
+	uint32_t index;
+	uint32_t count;
+	uint32_t value;
+
+	for (index = 0; index < 256; index++)
+	{
+		value = index;
+		for (count = 0; count < 8; count++)
+			value = (value & 1) ? (value >> 1) ^ polynomial : value >> 1;
+
+		table[0][index] = value;
+	}
+
+	for (index = 0; index < 256; index++)
+	{
+		value = table[0][index];
+		for (count = 1; count < 8; count++)
+		{
+			value = (value >> 8) ^ table[0][value & 0xFF];
+			table[count][index] = value;
+		}
+	}
+}
+
+static void crypto_start(void)
+{
+	if (crypto.started == CRYPTO_STATE_STARTED)
+		return;
+
+	if (!__sync_bool_compare_and_swap(&crypto.started, CRYPTO_STATE_STOPPED, CRYPTO_STATE_STARTING))
+	{
+		while (crypto.started != CRYPTO_STATE_STARTED)
+			thread_yield();
+		return;
+	}
+
+	crypto.available = crypto_detect_features();
+	crypto.features = crypto.available;
+
+	crypto_crc_tables(crypto.crc32, CRC32_POLYNOMIAL);
+	crypto_crc_tables(crypto.crc32c, CRC32C_POLYNOMIAL);
+
+	__sync_synchronize();
+	crypto.started = CRYPTO_STATE_STARTED;
+}
+
+static inline uint32_t crypto_features(void)
+{
+	crypto_start();
+
+	return crypto.features;
+}
+
+static uint32_t crypto_digest_to_string(const uint8_t *digest, uint32_t size, char *string, uint32_t len)
+{
+	static const char hex[] = "0123456789abcdef";
+	uint32_t count;
+
+	if (!digest || !string || len == 0)
+		return 0;
+
+	for (count = 0; count < size && (count * 2) + 2 < len; count++)
+	{
+		string[count * 2] = hex[digest[count] >> 4];
+		string[(count * 2) + 1] = hex[digest[count] & 0xF];
+	}
+	string[count * 2] = '\0';
+
+	return count * 2;
+}
+
+/* ============================================================================== */
+/* CRC Internal Functions */
+static uint32_t crc_update_c(uint32_t table[8][256], uint32_t crc, const uint8_t *data, size_t size)
+{
+	uint32_t one;
+	uint32_t two;
+
+	while (size >= 8)
+	{
+		one = crypto_load32_le(data) ^ crc;
+		two = crypto_load32_le(data + 4);
+		crc = table[7][one & 0xFF] ^ table[6][(one >> 8) & 0xFF] ^ table[5][(one >> 16) & 0xFF] ^ table[4][one >> 24] ^
+			table[3][two & 0xFF] ^ table[2][(two >> 8) & 0xFF] ^ table[1][(two >> 16) & 0xFF] ^ table[0][two >> 24];
+		data += 8;
+		size -= 8;
+	}
+
+	while (size > 0)
+	{
+		crc = (crc >> 8) ^ table[0][(crc ^ *data++) & 0xFF];
+		size--;
+	}
+
+	return crc;
+}
+
+#if defined(CRYPTO_ARM64)
+static uint32_t crc32_update_arm(uint32_t crc, const uint8_t *data, size_t size)
+{
+	uint64_t value;
+
+	while (size >= 8)
+	{
+		memcpy(&value, data, 8);
+		__asm__(".arch_extension crc\n" "crc32x %w0, %w0, %x1" : "+r" (crc) : "r" (value));
+		data += 8;
+		size -= 8;
+	}
+
+	while (size > 0)
+	{
+		__asm__(".arch_extension crc\n" "crc32b %w0, %w0, %w1" : "+r" (crc) : "r" ((uint32_t)*data++));
+		size--;
+	}
+
+	return crc;
+}
+
+static uint32_t crc32c_update_arm(uint32_t crc, const uint8_t *data, size_t size)
+{
+	uint64_t value;
+
+	while (size >= 8)
+	{
+		memcpy(&value, data, 8);
+		__asm__(".arch_extension crc\n" "crc32cx %w0, %w0, %x1" : "+r" (crc) : "r" (value));
+		data += 8;
+		size -= 8;
+	}
+
+	while (size > 0)
+	{
+		__asm__(".arch_extension crc\n" "crc32cb %w0, %w0, %w1" : "+r" (crc) : "r" ((uint32_t)*data++));
+		size--;
+	}
+
+	return crc;
+}
+#elif defined(CRYPTO_ARM32)
+/* CRC32W, CRC32B, CRC32CW and CRC32CB of r0 and r1 into r0 (ARM encoding) */
+#define CRC32_ARM_OPCODE_W	".inst 0xe1400041"
+#define CRC32_ARM_OPCODE_B	".inst 0xe1000041"
+#define CRC32C_ARM_OPCODE_W	".inst 0xe1400241"
+#define CRC32C_ARM_OPCODE_B	".inst 0xe1000241"
+
+static uint32_t crc_update_arm(uint32_t crc, const uint8_t *data, size_t size, BOOL castagnoli)
+{
+	register uint32_t r0 __asm__("r0") = crc;
+	register uint32_t r1 __asm__("r1");
+	uint32_t value;
+
+	while (size >= 4)
+	{
+		memcpy(&value, data, 4);
+		r1 = value;
+		if (castagnoli)
+			__asm__(CRC32C_ARM_OPCODE_W : "+r" (r0) : "r" (r1));
+		else
+			__asm__(CRC32_ARM_OPCODE_W : "+r" (r0) : "r" (r1));
+		data += 4;
+		size -= 4;
+	}
+
+	while (size > 0)
+	{
+		r1 = *data++;
+		if (castagnoli)
+			__asm__(CRC32C_ARM_OPCODE_B : "+r" (r0) : "r" (r1));
+		else
+			__asm__(CRC32_ARM_OPCODE_B : "+r" (r0) : "r" (r1));
+		size--;
+	}
+
+	return r0;
+}
+
+static uint32_t crc32_update_arm(uint32_t crc, const uint8_t *data, size_t size)
+{
+	return crc_update_arm(crc, data, size, FALSE);
+}
+
+static uint32_t crc32c_update_arm(uint32_t crc, const uint8_t *data, size_t size)
+{
+	return crc_update_arm(crc, data, size, TRUE);
+}
+#endif
+
+/* ============================================================================== */
+/* Hash Internal Functions */
+static void md5_transform(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+	uint32_t w[16];
+	uint32_t a, b, c, d;
+	uint32_t f, g, t;
+	uint32_t i;
+
+	while (blocks-- > 0)
+	{
+		for (i = 0; i < 16; i++)
+			w[i] = crypto_load32_le(data + (i * 4));
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+
+		for (i = 0; i < 64; i++)
+		{
+			if (i < 16)
+			{
+				f = d ^ (b & (c ^ d));
+				g = i;
+			}
+			else if (i < 32)
+			{
+				f = c ^ (d & (b ^ c));
+				g = (5 * i + 1) & 15;
+			}
+			else if (i < 48)
+			{
+				f = b ^ c ^ d;
+				g = (3 * i + 5) & 15;
+			}
+			else
+			{
+				f = c ^ (b | ~d);
+				g = (7 * i) & 15;
+			}
+
+			t = d;
+			d = c;
+			c = b;
+			b = b + crypto_rol32(a + f + md5_k[i] + w[g], md5_r[i]);
+			a = t;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+
+		data += MD5_CHUNK_SIZE;
+	}
+}
+
+static void sha1_transform_c(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+	uint32_t w[16];
+	uint32_t a, b, c, d, e;
+	uint32_t f, k, t;
+	uint32_t i;
+
+	while (blocks-- > 0)
+	{
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+
+		for (i = 0; i < 80; i++)
+		{
+			/* Message schedule kept as a 16 word circular buffer */
+			if (i < 16)
+				w[i] = crypto_load32_be(data + (i * 4));
+			else
+				w[i & 15] = crypto_rol32(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15], 1);
+
+			if (i < 20)
+			{
+				f = d ^ (b & (c ^ d));
+				k = 0x5A827999;
+			}
+			else if (i < 40)
+			{
+				f = b ^ c ^ d;
+				k = 0x6ED9EBA1;
+			}
+			else if (i < 60)
+			{
+				f = (b & c) | (d & (b | c));
+				k = 0x8F1BBCDC;
+			}
+			else
+			{
+				f = b ^ c ^ d;
+				k = 0xCA62C1D6;
+			}
+
+			t = crypto_rol32(a, 5) + f + e + k + w[i & 15];
+			e = d;
+			d = c;
+			c = crypto_rol32(b, 30);
+			b = a;
+			a = t;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+
+		data += SHA1_CHUNK_SIZE;
+	}
+}
+
+static void sha256_transform_c(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+	uint32_t w[64];
+	uint32_t a, b, c, d, e, f, g, h;
+	uint32_t s0, s1, t1, t2;
+	uint32_t i;
+
+	while (blocks-- > 0)
+	{
+		for (i = 0; i < 16; i++)
+			w[i] = crypto_load32_be(data + (i * 4));
+
+		for (i = 16; i < 64; i++)
+		{
+			s0 = crypto_ror32(w[i - 15], 7) ^ crypto_ror32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+			s1 = crypto_ror32(w[i - 2], 17) ^ crypto_ror32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		for (i = 0; i < 64; i++)
+		{
+			t1 = h + (crypto_ror32(e, 6) ^ crypto_ror32(e, 11) ^ crypto_ror32(e, 25)) + (g ^ (e & (f ^ g))) + sha256_k[i] + w[i];
+			t2 = (crypto_ror32(a, 2) ^ crypto_ror32(a, 13) ^ crypto_ror32(a, 22)) + ((a & b) | (c & (a | b)));
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+
+		data += SHA256_CHUNK_SIZE;
+	}
+}
+
+static void sha512_transform(uint64_t *state, const uint8_t *data, size_t blocks)
+{
+	uint64_t w[80];
+	uint64_t a, b, c, d, e, f, g, h;
+	uint64_t s0, s1, t1, t2;
+	uint32_t i;
+
+	while (blocks-- > 0)
+	{
+		for (i = 0; i < 16; i++)
+			w[i] = crypto_load64_be(data + (i * 8));
+
+		for (i = 16; i < 80; i++)
+		{
+			s0 = crypto_ror64(w[i - 15], 1) ^ crypto_ror64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+			s1 = crypto_ror64(w[i - 2], 19) ^ crypto_ror64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		for (i = 0; i < 80; i++)
+		{
+			t1 = h + (crypto_ror64(e, 14) ^ crypto_ror64(e, 18) ^ crypto_ror64(e, 41)) + (g ^ (e & (f ^ g))) + sha512_k[i] + w[i];
+			t2 = (crypto_ror64(a, 28) ^ crypto_ror64(a, 34) ^ crypto_ror64(a, 39)) + ((a & b) | (c & (a | b)));
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+
+		data += SHA512_CHUNK_SIZE;
+	}
+}
+
+#if defined(CRYPTO_ARM64)
+/* Four rounds of SHA1 with the schedule word w and constant k, v6 receives the e value for the next four rounds */
+#define SHA1_ARM_ROUNDS(op, w, k) \
+	"add v5.4s, " w ".4s, " k ".4s\n" \
+	"sha1h s6, s0\n" \
+	op " q0, s1, v5.4s\n" \
+	"mov v1.16b, v6.16b\n"
+
+/* Calculate the next four schedule words into w0 */
+#define SHA1_ARM_SCHEDULE(w0, w1, w2, w3) \
+	"sha1su0 " w0 ".4s, " w1 ".4s, " w2 ".4s\n" \
+	"sha1su1 " w0 ".4s, " w3 ".4s\n"
+
+static void sha1_transform_arm(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+	__asm__ __volatile__(
+		".arch_extension crypto\n"
+		"dup v20.4s, %w[k0]\n"
+		"dup v21.4s, %w[k1]\n"
+		"dup v22.4s, %w[k2]\n"
+		"dup v23.4s, %w[k3]\n"
+		"ld1 {v0.4s}, [%[state]]\n"
+		"ldr s1, [%[state], #16]\n"
+		"1:\n"
+		"ld1 {v16.16b-v19.16b}, [%[data]], #64\n"
+		"rev32 v16.16b, v16.16b\n"
+		"rev32 v17.16b, v17.16b\n"
+		"rev32 v18.16b, v18.16b\n"
+		"rev32 v19.16b, v19.16b\n"
+		"mov v2.16b, v0.16b\n"
+		"mov v3.16b, v1.16b\n"
+		/* Rounds 0 to 19 */
+		SHA1_ARM_ROUNDS("sha1c", "v16", "v20") SHA1_ARM_SCHEDULE("v16", "v17", "v18", "v19")
+		SHA1_ARM_ROUNDS("sha1c", "v17", "v20") SHA1_ARM_SCHEDULE("v17", "v18", "v19", "v16")
+		SHA1_ARM_ROUNDS("sha1c", "v18", "v20") SHA1_ARM_SCHEDULE("v18", "v19", "v16", "v17")
+		SHA1_ARM_ROUNDS("sha1c", "v19", "v20") SHA1_ARM_SCHEDULE("v19", "v16", "v17", "v18")
+		SHA1_ARM_ROUNDS("sha1c", "v16", "v20") SHA1_ARM_SCHEDULE("v16", "v17", "v18", "v19")
+		/* Rounds 20 to 39 */
+		SHA1_ARM_ROUNDS("sha1p", "v17", "v21") SHA1_ARM_SCHEDULE("v17", "v18", "v19", "v16")
+		SHA1_ARM_ROUNDS("sha1p", "v18", "v21") SHA1_ARM_SCHEDULE("v18", "v19", "v16", "v17")
+		SHA1_ARM_ROUNDS("sha1p", "v19", "v21") SHA1_ARM_SCHEDULE("v19", "v16", "v17", "v18")
+		SHA1_ARM_ROUNDS("sha1p", "v16", "v21") SHA1_ARM_SCHEDULE("v16", "v17", "v18", "v19")
+		SHA1_ARM_ROUNDS("sha1p", "v17", "v21") SHA1_ARM_SCHEDULE("v17", "v18", "v19", "v16")
+		/* Rounds 40 to 59 */
+		SHA1_ARM_ROUNDS("sha1m", "v18", "v22") SHA1_ARM_SCHEDULE("v18", "v19", "v16", "v17")
+		SHA1_ARM_ROUNDS("sha1m", "v19", "v22") SHA1_ARM_SCHEDULE("v19", "v16", "v17", "v18")
+		SHA1_ARM_ROUNDS("sha1m", "v16", "v22") SHA1_ARM_SCHEDULE("v16", "v17", "v18", "v19")
+		SHA1_ARM_ROUNDS("sha1m", "v17", "v22") SHA1_ARM_SCHEDULE("v17", "v18", "v19", "v16")
+		SHA1_ARM_ROUNDS("sha1m", "v18", "v22") SHA1_ARM_SCHEDULE("v18", "v19", "v16", "v17")
+		/* Rounds 60 to 79 */
+		SHA1_ARM_ROUNDS("sha1p", "v19", "v23") SHA1_ARM_SCHEDULE("v19", "v16", "v17", "v18")
+		SHA1_ARM_ROUNDS("sha1p", "v16", "v23")
+		SHA1_ARM_ROUNDS("sha1p", "v17", "v23")
+		SHA1_ARM_ROUNDS("sha1p", "v18", "v23")
+		SHA1_ARM_ROUNDS("sha1p", "v19", "v23")
+		"add v0.4s, v0.4s, v2.4s\n"
+		"add v1.4s, v1.4s, v3.4s\n"
+		"subs %[blocks], %[blocks], #1\n"
+		"b.ne 1b\n"
+		"st1 {v0.4s}, [%[state]]\n"
+		"str s1, [%[state], #16]\n"
+		: [data] "+r" (data), [blocks] "+r" (blocks)
+		: [state] "r" (state), [k0] "r" (0x5A827999), [k1] "r" (0x6ED9EBA1), [k2] "r" (0x8F1BBCDC), [k3] "r" (0xCA62C1D6)
+		: "cc", "memory", "v0", "v1", "v2", "v3", "v5", "v6", "v16", "v17", "v18", "v19", "v20", "v21", "v22", "v23");
+}
+
+/* Four rounds of SHA256 with the schedule word w and the next four constants */
+#define SHA256_ARM_ROUNDS(w) \
+	"ld1 {v4.4s}, [x9], #16\n" \
+	"add v5.4s, " w ".4s, v4.4s\n" \
+	"mov v6.16b, v0.16b\n" \
+	"sha256h q0, q1, v5.4s\n" \
+	"sha256h2 q1, q6, v5.4s\n"
+
+/* Calculate the next four schedule words into w0 */
+#define SHA256_ARM_SCHEDULE(w0, w1, w2, w3) \
+	"sha256su0 " w0 ".4s, " w1 ".4s\n" \
+	"sha256su1 " w0 ".4s, " w2 ".4s, " w3 ".4s\n"
+
+static void sha256_transform_arm(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+	__asm__ __volatile__(
+		".arch_extension crypto\n"
+		"ld1 {v0.4s, v1.4s}, [%[state]]\n"
+		"1:\n"
+		"ld1 {v16.16b-v19.16b}, [%[data]], #64\n"
+		"rev32 v16.16b, v16.16b\n"
+		"rev32 v17.16b, v17.16b\n"
+		"rev32 v18.16b, v18.16b\n"
+		"rev32 v19.16b, v19.16b\n"
+		"mov v2.16b, v0.16b\n"
+		"mov v3.16b, v1.16b\n"
+		"mov x9, %[k]\n"
+		SHA256_ARM_ROUNDS("v16") SHA256_ARM_SCHEDULE("v16", "v17", "v18", "v19")
+		SHA256_ARM_ROUNDS("v17") SHA256_ARM_SCHEDULE("v17", "v18", "v19", "v16")
+		SHA256_ARM_ROUNDS("v18") SHA256_ARM_SCHEDULE("v18", "v19", "v16", "v17")
+		SHA256_ARM_ROUNDS("v19") SHA256_ARM_SCHEDULE("v19", "v16", "v17", "v18")
+		SHA256_ARM_ROUNDS("v16") SHA256_ARM_SCHEDULE("v16", "v17", "v18", "v19")
+		SHA256_ARM_ROUNDS("v17") SHA256_ARM_SCHEDULE("v17", "v18", "v19", "v16")
+		SHA256_ARM_ROUNDS("v18") SHA256_ARM_SCHEDULE("v18", "v19", "v16", "v17")
+		SHA256_ARM_ROUNDS("v19") SHA256_ARM_SCHEDULE("v19", "v16", "v17", "v18")
+		SHA256_ARM_ROUNDS("v16") SHA256_ARM_SCHEDULE("v16", "v17", "v18", "v19")
+		SHA256_ARM_ROUNDS("v17") SHA256_ARM_SCHEDULE("v17", "v18", "v19", "v16")
+		SHA256_ARM_ROUNDS("v18") SHA256_ARM_SCHEDULE("v18", "v19", "v16", "v17")
+		SHA256_ARM_ROUNDS("v19") SHA256_ARM_SCHEDULE("v19", "v16", "v17", "v18")
+		SHA256_ARM_ROUNDS("v16")
+		SHA256_ARM_ROUNDS("v17")
+		SHA256_ARM_ROUNDS("v18")
+		SHA256_ARM_ROUNDS("v19")
+		"add v0.4s, v0.4s, v2.4s\n"
+		"add v1.4s, v1.4s, v3.4s\n"
+		"subs %[blocks], %[blocks], #1\n"
+		"b.ne 1b\n"
+		"st1 {v0.4s, v1.4s}, [%[state]]\n"
+		: [data] "+r" (data), [blocks] "+r" (blocks)
+		: [state] "r" (state), [k] "r" (sha256_k)
+		: "cc", "memory", "x9", "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v16", "v17", "v18", "v19");
+}
+#endif
+
+static void sha1_transform(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+#if defined(CRYPTO_ARM64)
+	if (crypto_features() & CRYPTO_FEATURE_SHA1)
+	{
+		sha1_transform_arm(state, data, blocks);
+		return;
+	}
+#endif
+
+	sha1_transform_c(state, data, blocks);
+}
+
+static void sha256_transform(uint32_t *state, const uint8_t *data, size_t blocks)
+{
+#if defined(CRYPTO_ARM64)
+	if (crypto_features() & CRYPTO_FEATURE_SHA256)
+	{
+		sha256_transform_arm(state, data, blocks);
+		return;
+	}
+#endif
+
+	sha256_transform_c(state, data, blocks);
+}
+
+/* Add data to a hash with 64 byte chunks, whole chunks are passed directly from the data */
+static void hash_update_chunks(uint32_t *state, uint64_t *count, uint8_t *buffer, uint32_t chunksize, const uint8_t *data, size_t size, void (*transform)(uint32_t *state, const uint8_t *data, size_t blocks))
+{
+	uint32_t used = *count & (chunksize - 1);
+	uint32_t fill;
+	size_t blocks;
+
+	*count += size;
+
+	if (used > 0)
+	{
+		fill = chunksize - used;
+		if (size < fill)
+		{
+			memcpy(buffer + used, data, size);
+			return;
+		}
+
+		memcpy(buffer + used, data, fill);
+		transform(state, buffer, 1);
+		data += fill;
+		size -= fill;
+	}
+
+	blocks = size / chunksize;
+	if (blocks > 0)
+	{
+		transform(state, data, blocks);
+		data += blocks * chunksize;
+		size -= blocks * chunksize;
+	}
+
+	if (size > 0)
+		memcpy(buffer, data, size);
+}
+
+/* Append the padding and bit length to a hash with 64 byte chunks */
+static void hash_final_chunks(uint32_t *state, uint64_t count, uint8_t *buffer, BOOL bigendian, void (*transform)(uint32_t *state, const uint8_t *data, size_t blocks))
+{
+	uint32_t used = count & 63;
+	uint64_t bits = count * 8;
+
+	buffer[used++] = 0x80;
+	if (used > 56)
+	{
+		memset(buffer + used, 0, 64 - used);
+		transform(state, buffer, 1);
+		used = 0;
+	}
+	memset(buffer + used, 0, 56 - used);
+
+	if (bigendian)
+	{
+		crypto_store64_be(buffer + 56, bits);
+	}
+	else
+	{
+		crypto_store32_le(buffer + 56, bits);
+		crypto_store32_le(buffer + 60, bits >> 32);
+	}
+
+	transform(state, buffer, 1);
+}
+
+/* Initialize, update and finish any of the underlying hashes by algorithm */
+static void hash_state_init(uint32_t algorithm, CRYPTO_HASH_STATE *state)
+{
+	switch (algorithm)
+	{
+		case CRYPTO_HASH_ALG_MD5:
+			md5_init(&state->md5);
+			break;
+		case CRYPTO_HASH_ALG_SHA1:
+			sha1_init(&state->sha1);
+			break;
+		case CRYPTO_HASH_ALG_SHA256:
+			sha256_init(&state->sha256);
+			break;
+		case CRYPTO_HASH_ALG_SHA384:
+			sha384_init(&state->sha512);
+			break;
+		case CRYPTO_HASH_ALG_SHA512:
+			sha512_init(&state->sha512);
+			break;
+		case CRYPTO_HASH_ALG_CRC32:
+		case CRYPTO_HASH_ALG_CRC32C:
+			state->crc = 0;
+			break;
+	}
+}
+
+static void hash_state_update(uint32_t algorithm, CRYPTO_HASH_STATE *state, const void *data, size_t size)
+{
+	switch (algorithm)
+	{
+		case CRYPTO_HASH_ALG_MD5:
+			md5_update(&state->md5, data, size);
+			break;
+		case CRYPTO_HASH_ALG_SHA1:
+			sha1_update(&state->sha1, data, size);
+			break;
+		case CRYPTO_HASH_ALG_SHA256:
+			sha256_update(&state->sha256, data, size);
+			break;
+		case CRYPTO_HASH_ALG_SHA384:
+			sha384_update(&state->sha512, data, size);
+			break;
+		case CRYPTO_HASH_ALG_SHA512:
+			sha512_update(&state->sha512, data, size);
+			break;
+		case CRYPTO_HASH_ALG_CRC32:
+			state->crc = crc32_update(state->crc, data, size);
+			break;
+		case CRYPTO_HASH_ALG_CRC32C:
+			state->crc = crc32c_update(state->crc, data, size);
+			break;
+	}
+}
+
+static void hash_state_final(uint32_t algorithm, CRYPTO_HASH_STATE *state, uint8_t *digest)
+{
+	switch (algorithm)
+	{
+		case CRYPTO_HASH_ALG_MD5:
+			md5_final(&state->md5, digest);
+			break;
+		case CRYPTO_HASH_ALG_SHA1:
+			sha1_final(&state->sha1, digest);
+			break;
+		case CRYPTO_HASH_ALG_SHA256:
+			sha256_final(&state->sha256, digest);
+			break;
+		case CRYPTO_HASH_ALG_SHA384:
+			sha384_final(&state->sha512, digest);
+			break;
+		case CRYPTO_HASH_ALG_SHA512:
+			sha512_final(&state->sha512, digest);
+			break;
+		case CRYPTO_HASH_ALG_CRC32:
+		case CRYPTO_HASH_ALG_CRC32C:
+			crypto_store32_be(digest, state->crc);
+			break;
+	}
+}
+
+/* Return the underlying hash of an HMAC algorithm (or the algorithm itself) */
+static uint32_t hash_get_base(uint32_t algorithm)
+{
+	switch (algorithm)
+	{
+		case CRYPTO_HASH_ALG_HMAC_MD5:
+			return CRYPTO_HASH_ALG_MD5;
+		case CRYPTO_HASH_ALG_HMAC_SHA1:
+			return CRYPTO_HASH_ALG_SHA1;
+		case CRYPTO_HASH_ALG_HMAC_SHA256:
+			return CRYPTO_HASH_ALG_SHA256;
+		case CRYPTO_HASH_ALG_HMAC_SHA384:
+			return CRYPTO_HASH_ALG_SHA384;
+		case CRYPTO_HASH_ALG_HMAC_SHA512:
+			return CRYPTO_HASH_ALG_SHA512;
+	}
+
+	return algorithm;
+}
+
+static uint32_t hash_get_chunk_size(uint32_t algorithm)
+{
+	return (algorithm == CRYPTO_HASH_ALG_SHA384 || algorithm == CRYPTO_HASH_ALG_SHA512) ? SHA512_CHUNK_SIZE : SHA256_CHUNK_SIZE;
+}
+
+/* Prepare the inner and outer hashes of an HMAC, keys longer than the chunk size are hashed first */
+static void hmac_init(CRYPTO_HMAC *hmac, uint32_t algorithm, const uint8_t *key, uint32_t keysize)
+{
+	uint8_t pad[HMAC_MAX_CHUNK_SIZE];
+	uint32_t chunksize = hash_get_chunk_size(algorithm);
+	uint32_t count;
+
+	hmac->algorithm = algorithm;
+
+	memset(pad, 0, sizeof(pad));
+	if (keysize > chunksize)
+	{
+		hash_state_init(algorithm, &hmac->inner);
+		hash_state_update(algorithm, &hmac->inner, key, keysize);
+		hash_state_final(algorithm, &hmac->inner, pad);
+	}
+	else if (keysize > 0)
+	{
+		memcpy(pad, key, keysize);
+	}
+
+	for (count = 0; count < chunksize; count++)
+		pad[count] ^= 0x36;
+	hash_state_init(algorithm, &hmac->inner);
+	hash_state_update(algorithm, &hmac->inner, pad, chunksize);
+
+	for (count = 0; count < chunksize; count++)
+		pad[count] ^= 0x36 ^ 0x5C;
+	hash_state_init(algorithm, &hmac->outer);
+	hash_state_update(algorithm, &hmac->outer, pad, chunksize);
+
+	memset(pad, 0, sizeof(pad));
+}
+
+static void hmac_final(CRYPTO_HMAC *hmac, uint8_t *digest)
+{
+	uint8_t inner[CRYPTO_HASH_MAX_DIGEST_SIZE];
+
+	hash_state_final(hmac->algorithm, &hmac->inner, inner);
+	hash_state_update(hmac->algorithm, &hmac->outer, inner, hash_get_digest_size(hmac->algorithm));
+	hash_state_final(hmac->algorithm, &hmac->outer, digest);
+}
+
+/* Hash a chain of data blocks with a plain hash or an HMAC */
+static BOOL hash_digest_blocks(uint32_t algorithm, const void *key, uint32_t keysize, CRYPTO_BLOCK *data, uint8_t *digest)
+{
+	CRYPTO_HMAC hmac;
+	uint32_t base = hash_get_base(algorithm);
+
+	if (!data || !digest)
+		return FALSE;
+
+	if (base != algorithm)
+		hmac_init(&hmac, base, key, keysize);
+	else
+		hash_state_init(base, &hmac.inner);
+
+	while (data)
+	{
+		if (data->data && data->size > 0)
+			hash_state_update(base, &hmac.inner, data->data, data->size);
+
+		data = data->next;
+	}
+
+	if (base != algorithm)
+	{
+		hmac.algorithm = base;
+		hmac_final(&hmac, digest);
+	}
+	else
+	{
+		hash_state_final(base, &hmac.inner, digest);
+	}
+
+	return TRUE;
+}
+
+static BOOL hash_digest_string(uint32_t algorithm, const char *key, const char *value, uint8_t *digest)
+{
+	CRYPTO_BLOCK block;
+
+	if (!value)
+		return FALSE;
+
+	block.data = (void *)value;
+	block.size = strlen(value);
+	block.next = NULL;
+
+	return hash_digest_blocks(algorithm, key, key ? strlen(key) : 0, &block, digest);
+}
+
+static BOOL hash_check(HASH_CONTEXT *context)
+{
+	return (context && context->signature == CRYPTO_HASH_SIGNATURE);
+}
+
+/* ============================================================================== */
+/* Crypto Functions */
+uint32_t STDCALL crypto_get_features(void)
+{
+	return crypto_features();
+}
+
+uint32_t STDCALL crypto_set_features(uint32_t features)
+{
+	crypto_start();
+
+	crypto.features = features & crypto.available;
+
+	return crypto.features;
+}
+
+uint32_t STDCALL crypto_get_available(void)
+{
+	crypto_start();
+
+	return crypto.available;
+}
+
+/* ============================================================================== */
+/* MD5 Functions */
+void STDCALL md5_init(MD5_CONTEXT *context)
+{
+	context->state[0] = 0x67452301;
+	context->state[1] = 0xEFCDAB89;
+	context->state[2] = 0x98BADCFE;
+	context->state[3] = 0x10325476;
+	context->count = 0;
+}
+
+void STDCALL md5_update(MD5_CONTEXT *context, const void *data, size_t size)
+{
+	hash_update_chunks(context->state, &context->count, context->buffer, MD5_CHUNK_SIZE, data, size, md5_transform);
+}
+
+void STDCALL md5_final(MD5_CONTEXT *context, MD5_DIGEST digest)
+{
+	uint32_t count;
+
+	hash_final_chunks(context->state, context->count, context->buffer, FALSE, md5_transform);
+
+	for (count = 0; count < 4; count++)
+		crypto_store32_le(digest + (count * 4), context->state[count]);
+}
+
+BOOL STDCALL md5_digest_data(CRYPTO_BLOCK *data, MD5_DIGEST digest)
+{
+	return hash_digest_blocks(CRYPTO_HASH_ALG_MD5, NULL, 0, data, digest);
+}
+
+BOOL STDCALL md5_digest_string(const char *value, MD5_DIGEST digest)
+{
+	return hash_digest_string(CRYPTO_HASH_ALG_MD5, NULL, value, digest);
+}
+
+uint32_t STDCALL md5_digest_to_string(const MD5_DIGEST digest, char *string, uint32_t len)
+{
+	return crypto_digest_to_string(digest, MD5_DIGEST_SIZE, string, len);
+}
+
+BOOL STDCALL hmac_md5_digest_data(const void *key, uint32_t keysize, CRYPTO_BLOCK *data, MD5_DIGEST digest)
+{
+	return hash_digest_blocks(CRYPTO_HASH_ALG_HMAC_MD5, key, keysize, data, digest);
+}
+
+BOOL STDCALL hmac_md5_digest_string(const char *key, const char *value, MD5_DIGEST digest)
+{
+	return hash_digest_string(CRYPTO_HASH_ALG_HMAC_MD5, key, value, digest);
+}
+
+/* ============================================================================== */
+/* SHA1 Functions */
+void STDCALL sha1_init(SHA1_CONTEXT *context)
+{
+	context->state[0] = 0x67452301;
+	context->state[1] = 0xEFCDAB89;
+	context->state[2] = 0x98BADCFE;
+	context->state[3] = 0x10325476;
+	context->state[4] = 0xC3D2E1F0;
+	context->count = 0;
+}
+
+void STDCALL sha1_update(SHA1_CONTEXT *context, const void *data, size_t size)
+{
+	hash_update_chunks(context->state, &context->count, context->buffer, SHA1_CHUNK_SIZE, data, size, sha1_transform);
+}
+
+void STDCALL sha1_final(SHA1_CONTEXT *context, SHA1_DIGEST digest)
+{
+	uint32_t count;
+
+	hash_final_chunks(context->state, context->count, context->buffer, TRUE, sha1_transform);
+
+	for (count = 0; count < 5; count++)
+		crypto_store32_be(digest + (count * 4), context->state[count]);
+}
+
+BOOL STDCALL sha1_digest_data(CRYPTO_BLOCK *data, SHA1_DIGEST digest)
+{
+	return hash_digest_blocks(CRYPTO_HASH_ALG_SHA1, NULL, 0, data, digest);
+}
+
+BOOL STDCALL sha1_digest_string(const char *value, SHA1_DIGEST digest)
+{
+	return hash_digest_string(CRYPTO_HASH_ALG_SHA1, NULL, value, digest);
+}
+
+uint32_t STDCALL sha1_digest_to_string(const SHA1_DIGEST digest, char *string, uint32_t len)
+{
+	return crypto_digest_to_string(digest, SHA1_DIGEST_SIZE, string, len);
+}
+
+BOOL STDCALL hmac_sha1_digest_data(const void *key, uint32_t keysize, CRYPTO_BLOCK *data, SHA1_DIGEST digest)
+{
+	return hash_digest_blocks(CRYPTO_HASH_ALG_HMAC_SHA1, key, keysize, data, digest);
+}
+
+BOOL STDCALL hmac_sha1_digest_string(const char *key, const char *value, SHA1_DIGEST digest)
+{
+	return hash_digest_string(CRYPTO_HASH_ALG_HMAC_SHA1, key, value, digest);
+}
+
+/* ============================================================================== */
+/* SHA256 Functions */
+void STDCALL sha256_init(SHA256_CONTEXT *context)
+{
+	context->state[0] = 0x6A09E667;
+	context->state[1] = 0xBB67AE85;
+	context->state[2] = 0x3C6EF372;
+	context->state[3] = 0xA54FF53A;
+	context->state[4] = 0x510E527F;
+	context->state[5] = 0x9B05688C;
+	context->state[6] = 0x1F83D9AB;
+	context->state[7] = 0x5BE0CD19;
+	context->count = 0;
+}
+
+void STDCALL sha256_update(SHA256_CONTEXT *context, const void *data, size_t size)
+{
+	hash_update_chunks(context->state, &context->count, context->buffer, SHA256_CHUNK_SIZE, data, size, sha256_transform);
+}
+
+void STDCALL sha256_final(SHA256_CONTEXT *context, SHA256_DIGEST digest)
+{
+	uint32_t count;
+
+	hash_final_chunks(context->state, context->count, context->buffer, TRUE, sha256_transform);
+
+	for (count = 0; count < 8; count++)
+		crypto_store32_be(digest + (count * 4), context->state[count]);
+}
+
+BOOL STDCALL sha256_digest_data(CRYPTO_BLOCK *data, SHA256_DIGEST digest)
+{
+	return hash_digest_blocks(CRYPTO_HASH_ALG_SHA256, NULL, 0, data, digest);
+}
+
+BOOL STDCALL sha256_digest_string(const char *value, SHA256_DIGEST digest)
+{
+	return hash_digest_string(CRYPTO_HASH_ALG_SHA256, NULL, value, digest);
+}
+
+uint32_t STDCALL sha256_digest_to_string(const SHA256_DIGEST digest, char *string, uint32_t len)
+{
+	return crypto_digest_to_string(digest, SHA256_DIGEST_SIZE, string, len);
+}
+
+BOOL STDCALL hmac_sha256_digest_data(const void *key, uint32_t keysize, CRYPTO_BLOCK *data, SHA256_DIGEST digest)
+{
+	return hash_digest_blocks(CRYPTO_HASH_ALG_HMAC_SHA256, key, keysize, data, digest);
+}
+
+BOOL STDCALL hmac_sha256_digest_string(const char *key, const char *value, SHA256_DIGEST digest)
+{
+	return hash_digest_string(CRYPTO_HASH_ALG_HMAC_SHA256, key, value, digest);
+}
+
+/* ============================================================================== */
+/* SHA384 Functions */
+void STDCALL sha384_init(SHA384_CONTEXT *context)
+{
+	context->state[0] = 0xCBBB9D5DC1059ED8ULL;
+	context->state[1] = 0x629A292A367CD507ULL;
+	context->state[2] = 0x9159015A3070DD17ULL;
+	context->state[3] = 0x152FECD8F70E5939ULL;
+	context->state[4] = 0x67332667FFC00B31ULL;
+	context->state[5] = 0x8EB44A8768581511ULL;
+	context->state[6] = 0xDB0C2E0D64F98FA7ULL;
+	context->state[7] = 0x47B5481DBEFA4FA4ULL;
+	context->count = 0;
+}
+
+void STDCALL sha384_update(SHA384_CONTEXT *context, const void *data, size_t size)
+{
+	sha512_update(context, data, size);
+}
+
+void STDCALL sha384_final(SHA384_CONTEXT *context, SHA384_DIGEST digest)
+{
+	SHA512_DIGEST full;
+
+	sha512_final(context, full);
+	memcpy(digest, full, SHA384_DIGEST_SIZE);
+}
+
+BOOL STDCALL sha384_digest_data(CRYPTO_BLOCK *data, SHA384_DIGEST digest)
+{
+	return hash_digest_blocks(CRYPTO_HASH_ALG_SHA384, NULL, 0, data, digest);
+}
+
+BOOL STDCALL sha384_digest_string(const char *value, SHA384_DIGEST digest)
+{
+	return hash_digest_string(CRYPTO_HASH_ALG_SHA384, NULL, value, digest);
+}
+
+uint32_t STDCALL sha384_digest_to_string(const SHA384_DIGEST digest, char *string, uint32_t len)
+{
+	return crypto_digest_to_string(digest, SHA384_DIGEST_SIZE, string, len);
+}
+
+/* ============================================================================== */
+/* SHA512 Functions */
+void STDCALL sha512_init(SHA512_CONTEXT *context)
+{
+	context->state[0] = 0x6A09E667F3BCC908ULL;
+	context->state[1] = 0xBB67AE8584CAA73BULL;
+	context->state[2] = 0x3C6EF372FE94F82BULL;
+	context->state[3] = 0xA54FF53A5F1D36F1ULL;
+	context->state[4] = 0x510E527FADE682D1ULL;
+	context->state[5] = 0x9B05688C2B3E6C1FULL;
+	context->state[6] = 0x1F83D9ABFB41BD6BULL;
+	context->state[7] = 0x5BE0CD19137E2179ULL;
+	context->count = 0;
+}
+
+void STDCALL sha512_update(SHA512_CONTEXT *context, const void *data, size_t size)
+{
+	const uint8_t *bytes = data;
+	uint32_t used = context->count & (SHA512_CHUNK_SIZE - 1);
+	uint32_t fill;
+	size_t blocks;
+
+	context->count += size;
+
+	if (used > 0)
+	{
+		fill = SHA512_CHUNK_SIZE - used;
+		if (size < fill)
+		{
+			memcpy(context->buffer + used, bytes, size);
+			return;
+		}
+
+		memcpy(context->buffer + used, bytes, fill);
+		sha512_transform(context->state, context->buffer, 1);
+		bytes += fill;
+		size -= fill;
+	}
+
+	blocks = size / SHA512_CHUNK_SIZE;
+	if (blocks > 0)
+	{
+		sha512_transform(context->state, bytes, blocks);
+		bytes += blocks * SHA512_CHUNK_SIZE;
+		size -= blocks * SHA512_CHUNK_SIZE;
+	}
+
+	if (size > 0)
+		memcpy(context->buffer, bytes, size);
+}
+
+void STDCALL sha512_final(SHA512_CONTEXT *context, SHA512_DIGEST digest)
+{
+	uint32_t used = context->count & (SHA512_CHUNK_SIZE - 1);
+	uint32_t count;
+
+	context->buffer[used++] = 0x80;
+	if (used > 112)
+	{
+		memset(context->buffer + used, 0, SHA512_CHUNK_SIZE - used);
+		sha512_transform(context->state, context->buffer, 1);
+		used = 0;
+	}
+	memset(context->buffer + used, 0, 112 - used);
+
+	/* 128 bit length, the upper 64 bits are the top bits of the byte count */
+	crypto_store64_be(context->buffer + 112, context->count >> 61);
+	crypto_store64_be(context->buffer + 120, context->count << 3);
+	sha512_transform(context->state, context->buffer, 1);
+
+	for (count = 0; count < 8; count++)
+		crypto_store64_be(digest + (count * 8), context->state[count]);
+}
+
+BOOL STDCALL sha512_digest_data(CRYPTO_BLOCK *data, SHA512_DIGEST digest)
+{
+	return hash_digest_blocks(CRYPTO_HASH_ALG_SHA512, NULL, 0, data, digest);
+}
+
+BOOL STDCALL sha512_digest_string(const char *value, SHA512_DIGEST digest)
+{
+	return hash_digest_string(CRYPTO_HASH_ALG_SHA512, NULL, value, digest);
+}
+
+uint32_t STDCALL sha512_digest_to_string(const SHA512_DIGEST digest, char *string, uint32_t len)
+{
+	return crypto_digest_to_string(digest, SHA512_DIGEST_SIZE, string, len);
+}
+
+/* ============================================================================== */
+/* CRC Functions */
+uint32_t STDCALL crc32_update(uint32_t crc, const void *data, size_t size)
+{
+	if (!data)
+		return crc;
+
+#if defined(CRYPTO_ARM64) || defined(CRYPTO_ARM32)
+	if (crypto_features() & CRYPTO_FEATURE_CRC32)
+		return ~crc32_update_arm(~crc, data, size);
+#else
+	crypto_start();
+#endif
+
+	return ~crc_update_c(crypto.crc32, ~crc, data, size);
+}
+
+uint32_t STDCALL crc32c_update(uint32_t crc, const void *data, size_t size)
+{
+	if (!data)
+		return crc;
+
+#if defined(CRYPTO_ARM64) || defined(CRYPTO_ARM32)
+	if (crypto_features() & CRYPTO_FEATURE_CRC32)
+		return ~crc32c_update_arm(~crc, data, size);
+#else
+	crypto_start();
+#endif
+
+	return ~crc_update_c(crypto.crc32c, ~crc, data, size);
+}
+
+/* ============================================================================== */
+/* Hash Functions */
+HASH_CONTEXT * STDCALL hash_create(uint32_t algorithm, const void *key, uint32_t keysize)
+{
+	HASH_CONTEXT *context;
+	uint32_t base;
+
+	if (hash_get_digest_size(algorithm) == 0)
+		return NULL;
+
+	if (!key && keysize > 0)
+		return NULL;
+
+	context = calloc(1, sizeof(HASH_CONTEXT));
+	if (!context)
+		return NULL;
+
+	context->signature = CRYPTO_HASH_SIGNATURE;
+	context->algorithm = algorithm;
+	context->digestsize = hash_get_digest_size(algorithm);
+
+	base = hash_get_base(algorithm);
+	if (base != algorithm)
+	{
+		hmac_init(&context->initial, base, key, keysize);
+	}
+	else
+	{
+		context->initial.algorithm = base;
+		hash_state_init(base, &context->initial.inner);
+	}
+
+	context->current = context->initial;
+
+	return context;
+}
+
+BOOL STDCALL hash_destroy(HASH_CONTEXT *context)
+{
+	if (!hash_check(context))
+		return FALSE;
+
+	/* Clear the keyed state before freeing */
+	memset(context, 0, sizeof(HASH_CONTEXT));
+	free(context);
+
+	return TRUE;
+}
+
+BOOL STDCALL hash_reset(HASH_CONTEXT *context)
+{
+	if (!hash_check(context))
+		return FALSE;
+
+	context->current = context->initial;
+
+	return TRUE;
+}
+
+BOOL STDCALL hash_update(HASH_CONTEXT *context, const void *data, size_t size)
+{
+	if (!hash_check(context))
+		return FALSE;
+
+	if (!data && size > 0)
+		return FALSE;
+
+	if (size > 0)
+		hash_state_update(context->current.algorithm, &context->current.inner, data, size);
+
+	return TRUE;
+}
+
+BOOL STDCALL hash_finish(HASH_CONTEXT *context, void *digest, uint32_t size)
+{
+	if (!hash_check(context))
+		return FALSE;
+
+	if (!digest || size < context->digestsize)
+		return FALSE;
+
+	if (hash_get_base(context->algorithm) != context->algorithm)
+		hmac_final(&context->current, digest);
+	else
+		hash_state_final(context->current.algorithm, &context->current.inner, digest);
+
+	/* Ready for another message with the same key */
+	context->current = context->initial;
+
+	return TRUE;
+}
+
+uint32_t STDCALL hash_get_digest_size(uint32_t algorithm)
+{
+	switch (hash_get_base(algorithm))
+	{
+		case CRYPTO_HASH_ALG_MD5:
+			return MD5_DIGEST_SIZE;
+		case CRYPTO_HASH_ALG_SHA1:
+			return SHA1_DIGEST_SIZE;
+		case CRYPTO_HASH_ALG_SHA256:
+			return SHA256_DIGEST_SIZE;
+		case CRYPTO_HASH_ALG_SHA384:
+			return SHA384_DIGEST_SIZE;
+		case CRYPTO_HASH_ALG_SHA512:
+			return SHA512_DIGEST_SIZE;
+		case CRYPTO_HASH_ALG_CRC32:
+		case CRYPTO_HASH_ALG_CRC32C:
+			return 4;
+	}
+
+	return 0;
+}
+
+/* ============================================================================== */
+/* Crypto Helper Functions */
+uint32_t STDCALL crypto_features_to_string(uint32_t features, char *string, uint32_t len)
+{
+	static const char *names[] = {"AES", "PMULL", "SHA1", "SHA256", "CRC32"};
+	uint32_t count;
+
+	if (!string || len == 0)
+		return 0;
+
+	string[0] = '\0';
+
+	if (features == CRYPTO_FEATURE_NONE)
+	{
+		strncpy(string, "None", len - 1);
+		string[len - 1] = '\0';
+		return strlen(string);
+	}
+
+	for (count = 0; count < sizeof(names) / sizeof(names[0]); count++)
+	{
+		if ((features & (1 << count)) == 0)
+			continue;
+
+		if (string[0] != '\0')
+			strncat(string, " ", len - strlen(string) - 1);
+		strncat(string, names[count], len - strlen(string) - 1);
+	}
+
+	return strlen(string);
+}
+
+uint32_t STDCALL crypto_hash_alg_to_string(uint32_t algorithm, char *string, uint32_t len)
+{
+	const char *value;
+
+	if (!string || len == 0)
+		return 0;
+
+	switch (algorithm)
+	{
+		case CRYPTO_HASH_ALG_MD5:
+			value = "MD5";
+			break;
+		case CRYPTO_HASH_ALG_SHA1:
+			value = "SHA1";
+			break;
+		case CRYPTO_HASH_ALG_SHA256:
+			value = "SHA256";
+			break;
+		case CRYPTO_HASH_ALG_SHA384:
+			value = "SHA384";
+			break;
+		case CRYPTO_HASH_ALG_SHA512:
+			value = "SHA512";
+			break;
+		case CRYPTO_HASH_ALG_HMAC_MD5:
+			value = "HMAC-MD5";
+			break;
+		case CRYPTO_HASH_ALG_HMAC_SHA1:
+			value = "HMAC-SHA1";
+			break;
+		case CRYPTO_HASH_ALG_HMAC_SHA256:
+			value = "HMAC-SHA256";
+			break;
+		case CRYPTO_HASH_ALG_HMAC_SHA384:
+			value = "HMAC-SHA384";
+			break;
+		case CRYPTO_HASH_ALG_HMAC_SHA512:
+			value = "HMAC-SHA512";
+			break;
+		case CRYPTO_HASH_ALG_CRC32:
+			value = "CRC32";
+			break;
+		case CRYPTO_HASH_ALG_CRC32C:
+			value = "CRC32C";
+			break;
+		default:
+			value = "Unknown";
+			break;
+	}
+
+	strncpy(string, value, len - 1);
+	string[len - 1] = '\0';
+
+	return strlen(string);
+}
@@ -0,0 +1,1843 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/crypto.h"
+
+/* Implementation of AES, DES, 3DES and RC4 for the Ultibo API
+ *
+ * The C path of AES uses four 1KB tables for each direction with the state held
+ * as little endian column words, so the round keys are stored in byte order and
+ * are shared with the AArch64 path which uses the AESE/AESD instructions. The
+ * tables are generated on first use rather than compiled in.
+ *
+ * On AArch64 with the AES instructions all round keys are kept in v16 to v30
+ * for the length of a call, the last rounds always use the same registers so
+ * the 128, 192 and 256 bit key sizes share one loop. GCM uses PMULL for GHASH
+ * when available, otherwise a 4 bit table per key (Shoup's method).
+ *
+ * There is no NEON path for 32bit builds, the Cortex-A7/A53/A72 have no AES
+ * instructions and a bit sliced implementation only pays off when 8 blocks
+ * can be processed in parallel which excludes CBC encryption, those builds use
+ * the table driven C code.
+ *
+ * GCM increments only the low 32 bits of the counter as the specification
+ * requires, bulk counter mode calls are split where those bits wrap.
+ *
+ * DES uses combined S-box and P permutation tables with the initial and final
+ * permutations done by bit swapping.
+ */
+
+/* ============================================================================== */
+/* Cipher specific constants */
+#define CIPHER_STATE_STOPPED	0
+#define CIPHER_STATE_STARTING	1
+#define CIPHER_STATE_STARTED	2
+
+#define AES_GCM_STATE_AAD	0 // Accepting additional data
+#define AES_GCM_STATE_DATA	1 // Accepting data to encrypt or decrypt
+#define AES_GCM_STATE_DONE	2 // Tag calculated
+
+#if defined(__aarch64__)
+#define CIPHER_ARM64
+#endif
+
+/* ============================================================================== */
+/* Cipher specific types */
+typedef struct _CIPHER_STATE CIPHER_STATE;
+struct _CIPHER_STATE
+{
+	volatile uint32_t started; // Startup state (eg CIPHER_STATE_STARTED)
+	uint8_t sbox[256]; // AES S-box
+	uint8_t isbox[256]; // AES inverse S-box
+	uint32_t te[4][256]; // AES encryption tables (SubBytes and MixColumns for each row)
+	uint32_t td[4][256]; // AES decryption tables (InvSubBytes and InvMixColumns for each row)
+	uint32_t sp[8][64]; // DES combined S-box and P permutation
+};
+
+struct _CIPHER_CONTEXT
+{
+	uint32_t signature; // Signature for entry validation
+	uint32_t algorithm; // Cipher algorithm (eg CRYPTO_CIPHER_ALG_AES)
+	uint32_t mode; // Cipher mode (eg CRYPTO_CIPHER_MODE_CBC)
+	uint32_t blocksize; // Block size of the algorithm (0 for stream ciphers)
+	uint8_t vector[AES_BLOCK_SIZE]; // CBC chaining value or CTR counter
+	uint8_t stream[AES_BLOCK_SIZE]; // CTR key stream of the current block
+	uint32_t used; // Bytes of the CTR key stream already used
+	union
+	{
+		AES_KEY aes;
+		struct
+		{
+			DES_KEY encrypt;
+			DES_KEY decrypt;
+		} des;
+		DES3_KEY des3;
+		RC4_STATE rc4;
+	} key;
+};
+
+static CIPHER_STATE cipher = {CIPHER_STATE_STOPPED};
+
+/* DES tables (Bits numbered from 1 as the most significant) */
+static const uint8_t des_pc1[56] = {
+	57, 49, 41, 33, 25, 17, 9, 1, 58, 50, 42, 34, 26, 18,
+	10, 2, 59, 51, 43, 35, 27, 19, 11, 3, 60, 52, 44, 36,
+	63, 55, 47, 39, 31, 23, 15, 7, 62, 54, 46, 38, 30, 22,
+	14, 6, 61, 53, 45, 37, 29, 21, 13, 5, 28, 20, 12, 4};
+
+static const uint8_t des_pc2[48] = {
+	14, 17, 11, 24, 1, 5, 3, 28, 15, 6, 21, 10,
+	23, 19, 12, 4, 26, 8, 16, 7, 27, 20, 13, 2,
+	41, 52, 31, 37, 47, 55, 30, 40, 51, 45, 33, 48,
+	44, 49, 39, 56, 34, 53, 46, 42, 50, 36, 29, 32};
+
+static const uint8_t des_shifts[16] = {1, 1, 2, 2, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 2, 1};
+
+static const uint8_t des_p[32] = {
+	16, 7, 20, 21, 29, 12, 28, 17, 1, 15, 23, 26, 5, 18, 31, 10,
+	2, 8, 24, 14, 32, 27, 3, 9, 19, 13, 30, 6, 22, 11, 4, 25};
+
+static const uint8_t des_sbox[8][64] = {
+	{14, 4, 13, 1, 2, 15, 11, 8, 3, 10, 6, 12, 5, 9, 0, 7,
+	 0, 15, 7, 4, 14, 2, 13, 1, 10, 6, 12, 11, 9, 5, 3, 8,
+	 4, 1, 14, 8, 13, 6, 2, 11, 15, 12, 9, 7, 3, 10, 5, 0,
+	 15, 12, 8, 2, 4, 9, 1, 7, 5, 11, 3, 14, 10, 0, 6, 13},
+	{15, 1, 8, 14, 6, 11, 3, 4, 9, 7, 2, 13, 12, 0, 5, 10,
+	 3, 13, 4, 7, 15, 2, 8, 14, 12, 0, 1, 10, 6, 9, 11, 5,
+	 0, 14, 7, 11, 10, 4, 13, 1, 5, 8, 12, 6, 9, 3, 2, 15,
+	 13, 8, 10, 1, 3, 15, 4, 2, 11, 6, 7, 12, 0, 5, 14, 9},
+	{10, 0, 9, 14, 6, 3, 15, 5, 1, 13, 12, 7, 11, 4, 2, 8,
+	 13, 7, 0, 9, 3, 4, 6, 10, 2, 8, 5, 14, 12, 11, 15, 1,
+	 13, 6, 4, 9, 8, 15, 3, 0, 11, 1, 2, 12, 5, 10, 14, 7,
+	 1, 10, 13, 0, 6, 9, 8, 7, 4, 15, 14, 3, 11, 5, 2, 12},
+	{7, 13, 14, 3, 0, 6, 9, 10, 1, 2, 8, 5, 11, 12, 4, 15,
+	 13, 8, 11, 5, 6, 15, 0, 3, 4, 7, 2, 12, 1, 10, 14, 9,
+	 10, 6, 9, 0, 12, 11, 7, 13, 15, 1, 3, 14, 5, 2, 8, 4,
+	 3, 15, 0, 6, 10, 1, 13, 8, 9, 4, 5, 11, 12, 7, 2, 14},
+	{2, 12, 4, 1, 7, 10, 11, 6, 8, 5, 3, 15, 13, 0, 14, 9,
+	 14, 11, 2, 12, 4, 7, 13, 1, 5, 0, 15, 10, 3, 9, 8, 6,
+	 4, 2, 1, 11, 10, 13, 7, 8, 15, 9, 12, 5, 6, 3, 0, 14,
+	 11, 8, 12, 7, 1, 14, 2, 13, 6, 15, 0, 9, 10, 4, 5, 3},
+	{12, 1, 10, 15, 9, 2, 6, 8, 0, 13, 3, 4, 14, 7, 5, 11,
+	 10, 15, 4, 2, 7, 12, 9, 5, 6, 1, 13, 14, 0, 11, 3, 8,
+	 9, 14, 15, 5, 2, 8, 12, 3, 7, 0, 4, 10, 1, 13, 11, 6,
+	 4, 3, 2, 12, 9, 5, 15, 10, 11, 14, 1, 7, 6, 0, 8, 13},
+	{4, 11, 2, 14, 15, 0, 8, 13, 3, 12, 9, 7, 5, 10, 6, 1,
+	 13, 0, 11, 7, 4, 9, 1, 10, 14, 3, 5, 12, 2, 15, 8, 6,
+	 1, 4, 11, 13, 12, 3, 7, 14, 10, 15, 6, 8, 0, 5, 9, 2,
+	 6, 11, 13, 8, 1, 4, 10, 7, 9, 5, 0, 15, 14, 2, 3, 12},
+	{13, 2, 8, 4, 6, 15, 11, 1, 10, 9, 3, 14, 5, 0, 12, 7,
+	 1, 15, 13, 8, 10, 3, 7, 4, 12, 5, 6, 11, 0, 14, 9, 2,
+	 7, 11, 4, 1, 9, 12, 14, 2, 0, 6, 10, 13, 15, 3, 5, 8,
+	 2, 1, 14, 7, 4, 10, 8, 13, 15, 12, 9, 0, 3, 5, 6, 11}};
+
+/* GHASH reduction of the 4 bits shifted out of the table multiply */
+static const uint64_t ghash_last4[16] = {
+	0x0000, 0x1C20, 0x3840, 0x2460, 0x7080, 0x6CA0, 0x48C0, 0x54E0,
+	0xE100, 0xFD20, 0xD940, 0xC560, 0x9180, 0x8DA0, 0xA9C0, 0xB5E0};
+
+/* ============================================================================== */
+/* Cipher Internal Functions */
+static inline uint32_t cipher_rol32(uint32_t value, uint32_t count)
+{
+	return (value << count) | (value >> ((32 - count) & 31));
+}
+
+static inline uint32_t cipher_load32_le(const uint8_t *data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static inline uint32_t cipher_load32_be(const uint8_t *data)
+{
+	return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+static inline uint64_t cipher_load64_be(const uint8_t *data)
+{
+	return ((uint64_t)cipher_load32_be(data) << 32) | cipher_load32_be(data + 4);
+}
+
+static inline void cipher_store32_le(uint8_t *data, uint32_t value)
+{
+	data[0] = value;
+	data[1] = value >> 8;
+	data[2] = value >> 16;
+	data[3] = value >> 24;
+}
+
+static inline void cipher_store32_be(uint8_t *data, uint32_t value)
+{
+	data[0] = value >> 24;
+	data[1] = value >> 16;
+	data[2] = value >> 8;
+	data[3] = value;
+}
+
+static inline void cipher_store64_be(uint8_t *data, uint64_t value)
+{
+	cipher_store32_be(data, value >> 32);
+	cipher_store32_be(data + 4, value);
+}
+
+static inline void cipher_xor_block(uint8_t *dest, const uint8_t *source1, const uint8_t *source2, uint32_t size)
+{
+	uint32_t count;
+
+	for (count = 0; count < size; count++)
+		dest[count] = source1[count] ^ source2[count];
+}
+
+/* Multiply in GF(2^8) with the AES polynomial */
+static uint8_t aes_multiply(uint8_t a, uint8_t b)
+{
+	uint8_t result = 0;
+
+	while (b)
+	{
+		if (b & 1)
+			result ^= a;
+		a = (a << 1) ^ ((a & 0x80) ? 0x1B : 0);
+		b >>= 1;
+	}
+
+	return result;
+}
+
+static void cipher_aes_tables(void)
+{
+	uint8_t p = 1;
+	uint8_t q = 1;
+	uint8_t x;
+	uint8_t s;
+	uint32_t index;
+	uint32_t row;
+
+	/* S-box from the multiplicative inverse (q = 1 / p) and the affine transform */
+	do
+	{
+		p = p ^ (p << 1) ^ ((p & 0x80) ? 0x1B : 0);
+		q ^= q << 1;
+		q ^= q << 2;
+		q ^= q << 4;
+		if (q & 0x80)
+			q ^= 0x09;
+
+		x = q ^ ((q << 1) | (q >> 7)) ^ ((q << 2) | (q >> 6)) ^ ((q << 3) | (q >> 5)) ^ ((q << 4) | (q >> 4));
+		cipher.sbox[p] = x ^ 0x63;
+	} while (p != 1);
+	cipher.sbox[0] = 0x63;
+
+	for (index = 0; index < 256; index++)
+		cipher.isbox[cipher.sbox[index]] = index;
+
+	/* Column words are little endian, row 0 in the low byte */
+	for (index = 0; index < 256; index++)
+	{
+		s = cipher.sbox[index];
+		cipher.te[0][index] = aes_multiply(s, 2) | (s << 8) | (s << 16) | ((uint32_t)aes_multiply(s, 3) << 24);
+
+		s = cipher.isbox[index];
+		cipher.td[0][index] = aes_multiply(s, 14) | (aes_multiply(s, 9) << 8) | (aes_multiply(s, 13) << 16) | ((uint32_t)aes_multiply(s, 11) << 24);
+
+		for (row = 1; row < 4; row++)
+		{
+			cipher.te[row][index] = cipher_rol32(cipher.te[0][index], row * 8);
+			cipher.td[row][index] = cipher_rol32(cipher.td[0][index], row * 8);
+		}
+	}
+}
+
+static void cipher_des_tables(void)
+{
+	uint32_t box;
+	uint32_t index;
+	uint32_t value;
+	uint32_t bit;
+	uint32_t result;
+
+	for (box = 0; box < 8; box++)
+	{
+		for (index = 0; index < 64; index++)
+		{
+			/* Row from the outer bits, column from the inner 4 bits */
+			value = des_sbox[box][(((index >> 4) & 2) | (index & 1)) * 16 + ((index >> 1) & 0xF)];
+			value <<= 28 - (box * 4);
+
+			result = 0;
+			for (bit = 0; bit < 32; bit++)
+			{
+				if (value & (1U << (32 - des_p[bit])))
+					result |= 1U << (31 - bit);
+			}
+
+			cipher.sp[box][index] = result;
+		}
+	}
+}
+
+static void cipher_start(void)
+{
+	if (cipher.started == CIPHER_STATE_STARTED)
+		return;
+
+	if (!__sync_bool_compare_and_swap(&cipher.started, CIPHER_STATE_STOPPED, CIPHER_STATE_STARTING))
+	{
+		while (cipher.started != CIPHER_STATE_STARTED)
+			thread_yield();
+		return;
+	}
+
+	cipher_aes_tables();
+	cipher_des_tables();
+
+	__sync_synchronize();
+	cipher.started = CIPHER_STATE_STARTED;
+}
+
+/* Increment a 16 byte big endian counter */
+static inline void cipher_increment(uint8_t *counter)
+{
+	int32_t index;
+
+	for (index = AES_BLOCK_SIZE - 1; index >= 0; index--)
+	{
+		if (++counter[index] != 0)
+			break;
+	}
+}
+
+/* ============================================================================== */
+/* AES Internal Functions */
+static uint32_t aes_sub_word(uint32_t value)
+{
+	return cipher.sbox[value & 0xFF] | (cipher.sbox[(value >> 8) & 0xFF] << 8) | (cipher.sbox[(value >> 16) & 0xFF] << 16) | ((uint32_t)cipher.sbox[value >> 24] << 24);
+}
+
+static uint32_t aes_inv_mix_word(uint32_t value)
+{
+	return cipher.td[0][cipher.sbox[value & 0xFF]] ^ cipher.td[1][cipher.sbox[(value >> 8) & 0xFF]] ^
+		cipher.td[2][cipher.sbox[(value >> 16) & 0xFF]] ^ cipher.td[3][cipher.sbox[value >> 24]];
+}
+
+static void aes_encrypt_c(const uint32_t *keys, uint32_t rounds, const uint8_t *input, uint8_t *output)
+{
+	uint32_t s0, s1, s2, s3;
+	uint32_t t0, t1, t2, t3;
+	uint32_t round;
+
+	s0 = cipher_load32_le(input) ^ keys[0];
+	s1 = cipher_load32_le(input + 4) ^ keys[1];
+	s2 = cipher_load32_le(input + 8) ^ keys[2];
+	s3 = cipher_load32_le(input + 12) ^ keys[3];
+
+	for (round = 1; round < rounds; round++)
+	{
+		keys += 4;
+		t0 = cipher.te[0][s0 & 0xFF] ^ cipher.te[1][(s1 >> 8) & 0xFF] ^ cipher.te[2][(s2 >> 16) & 0xFF] ^ cipher.te[3][s3 >> 24] ^ keys[0];
+		t1 = cipher.te[0][s1 & 0xFF] ^ cipher.te[1][(s2 >> 8) & 0xFF] ^ cipher.te[2][(s3 >> 16) & 0xFF] ^ cipher.te[3][s0 >> 24] ^ keys[1];
+		t2 = cipher.te[0][s2 & 0xFF] ^ cipher.te[1][(s3 >> 8) & 0xFF] ^ cipher.te[2][(s0 >> 16) & 0xFF] ^ cipher.te[3][s1 >> 24] ^ keys[2];
+		t3 = cipher.te[0][s3 & 0xFF] ^ cipher.te[1][(s0 >> 8) & 0xFF] ^ cipher.te[2][(s1 >> 16) & 0xFF] ^ cipher.te[3][s2 >> 24] ^ keys[3];
+		s0 = t0;
+		s1 = t1;
+		s2 = t2;
+		s3 = t3;
+	}
+
+	/* Last round has no MixColumns */
+	keys += 4;
+	t0 = cipher.sbox[s0 & 0xFF] | (cipher.sbox[(s1 >> 8) & 0xFF] << 8) | (cipher.sbox[(s2 >> 16) & 0xFF] << 16) | ((uint32_t)cipher.sbox[s3 >> 24] << 24);
+	t1 = cipher.sbox[s1 & 0xFF] | (cipher.sbox[(s2 >> 8) & 0xFF] << 8) | (cipher.sbox[(s3 >> 16) & 0xFF] << 16) | ((uint32_t)cipher.sbox[s0 >> 24] << 24);
+	t2 = cipher.sbox[s2 & 0xFF] | (cipher.sbox[(s3 >> 8) & 0xFF] << 8) | (cipher.sbox[(s0 >> 16) & 0xFF] << 16) | ((uint32_t)cipher.sbox[s1 >> 24] << 24);
+	t3 = cipher.sbox[s3 & 0xFF] | (cipher.sbox[(s0 >> 8) & 0xFF] << 8) | (cipher.sbox[(s1 >> 16) & 0xFF] << 16) | ((uint32_t)cipher.sbox[s2 >> 24] << 24);
+
+	cipher_store32_le(output, t0 ^ keys[0]);
+	cipher_store32_le(output + 4, t1 ^ keys[1]);
+	cipher_store32_le(output + 8, t2 ^ keys[2]);
+	cipher_store32_le(output + 12, t3 ^ keys[3]);
+}
+
+static void aes_decrypt_c(const uint32_t *keys, uint32_t rounds, const uint8_t *input, uint8_t *output)
+{
+	uint32_t s0, s1, s2, s3;
+	uint32_t t0, t1, t2, t3;
+	uint32_t round;
+
+	s0 = cipher_load32_le(input) ^ keys[0];
+	s1 = cipher_load32_le(input + 4) ^ keys[1];
+	s2 = cipher_load32_le(input + 8) ^ keys[2];
+	s3 = cipher_load32_le(input + 12) ^ keys[3];
+
+	for (round = 1; round < rounds; round++)
+	{
+		keys += 4;
+		t0 = cipher.td[0][s0 & 0xFF] ^ cipher.td[1][(s3 >> 8) & 0xFF] ^ cipher.td[2][(s2 >> 16) & 0xFF] ^ cipher.td[3][s1 >> 24] ^ keys[0];
+		t1 = cipher.td[0][s1 & 0xFF] ^ cipher.td[1][(s0 >> 8) & 0xFF] ^ cipher.td[2][(s3 >> 16) & 0xFF] ^ cipher.td[3][s2 >> 24] ^ keys[1];
+		t2 = cipher.td[0][s2 & 0xFF] ^ cipher.td[1][(s1 >> 8) & 0xFF] ^ cipher.td[2][(s0 >> 16) & 0xFF] ^ cipher.td[3][s3 >> 24] ^ keys[2];
+		t3 = cipher.td[0][s3 & 0xFF] ^ cipher.td[1][(s2 >> 8) & 0xFF] ^ cipher.td[2][(s1 >> 16) & 0xFF] ^ cipher.td[3][s0 >> 24] ^ keys[3];
+		s0 = t0;
+		s1 = t1;
+		s2 = t2;
+		s3 = t3;
+	}
+
+	keys += 4;
+	t0 = cipher.isbox[s0 & 0xFF] | (cipher.isbox[(s3 >> 8) & 0xFF] << 8) | (cipher.isbox[(s2 >> 16) & 0xFF] << 16) | ((uint32_t)cipher.isbox[s1 >> 24] << 24);
+	t1 = cipher.isbox[s1 & 0xFF] | (cipher.isbox[(s0 >> 8) & 0xFF] << 8) | (cipher.isbox[(s3 >> 16) & 0xFF] << 16) | ((uint32_t)cipher.isbox[s2 >> 24] << 24);
+	t2 = cipher.isbox[s2 & 0xFF] | (cipher.isbox[(s1 >> 8) & 0xFF] << 8) | (cipher.isbox[(s0 >> 16) & 0xFF] << 16) | ((uint32_t)cipher.isbox[s3 >> 24] << 24);
+	t3 = cipher.isbox[s3 & 0xFF] | (cipher.isbox[(s2 >> 8) & 0xFF] << 8) | (cipher.isbox[(s1 >> 16) & 0xFF] << 16) | ((uint32_t)cipher.isbox[s0 >> 24] << 24);
+
+	cipher_store32_le(output, t0 ^ keys[0]);
+	cipher_store32_le(output + 4, t1 ^ keys[1]);
+	cipher_store32_le(output + 8, t2 ^ keys[2]);
+	cipher_store32_le(output + 12, t3 ^ keys[3]);
+}
+
+#if defined(CIPHER_ARM64)
+/* Load the round keys so the last 11 are always in v20 to v30 */
+#define AES_ARM_LOAD_KEYS \
+	".arch_extension crypto\n" \
+	"cmp %w[rounds], #12\n" \
+	"b.eq 5f\n" \
+	"b.hi 6f\n" \
+	"ld1 {v20.16b-v23.16b}, [%[keys]], #64\n" \
+	"ld1 {v24.16b-v27.16b}, [%[keys]], #64\n" \
+	"ld1 {v28.16b-v30.16b}, [%[keys]]\n" \
+	"b 7f\n" \
+	"5:\n" \
+	"ld1 {v18.16b-v21.16b}, [%[keys]], #64\n" \
+	"ld1 {v22.16b-v25.16b}, [%[keys]], #64\n" \
+	"ld1 {v26.16b-v29.16b}, [%[keys]], #64\n" \
+	"ld1 {v30.16b}, [%[keys]]\n" \
+	"b 7f\n" \
+	"6:\n" \
+	"ld1 {v16.16b-v19.16b}, [%[keys]], #64\n" \
+	"ld1 {v20.16b-v23.16b}, [%[keys]], #64\n" \
+	"ld1 {v24.16b-v27.16b}, [%[keys]], #64\n" \
+	"ld1 {v28.16b-v30.16b}, [%[keys]]\n" \
+	"7:\n"
+
+/* Encrypt or decrypt one block in register v (op is e or d, mix is mc or imc) */
+#define AES_ARM_ROUND(op, mix, v, k) \
+	"aes" op " " v ".16b, " k ".16b\n" \
+	"aes" mix " " v ".16b, " v ".16b\n"
+
+#define AES_ARM_BLOCK(op, mix, v) \
+	"cmp %w[rounds], #12\n" \
+	"b.lo 9f\n" \
+	"b.eq 8f\n" \
+	AES_ARM_ROUND(op, mix, v, "v16") \
+	AES_ARM_ROUND(op, mix, v, "v17") \
+	"8:\n" \
+	AES_ARM_ROUND(op, mix, v, "v18") \
+	AES_ARM_ROUND(op, mix, v, "v19") \
+	"9:\n" \
+	AES_ARM_ROUND(op, mix, v, "v20") \
+	AES_ARM_ROUND(op, mix, v, "v21") \
+	AES_ARM_ROUND(op, mix, v, "v22") \
+	AES_ARM_ROUND(op, mix, v, "v23") \
+	AES_ARM_ROUND(op, mix, v, "v24") \
+	AES_ARM_ROUND(op, mix, v, "v25") \
+	AES_ARM_ROUND(op, mix, v, "v26") \
+	AES_ARM_ROUND(op, mix, v, "v27") \
+	AES_ARM_ROUND(op, mix, v, "v28") \
+	"aes" op " " v ".16b, v29.16b\n" \
+	"eor " v ".16b, " v ".16b, v30.16b\n"
+
+#define AES_ARM_CLOBBERS \
+	"cc", "memory", "v0", "v1", "v2", "v16", "v17", "v18", "v19", "v20", "v21", "v22", "v23", "v24", "v25", "v26", "v27", "v28", "v29", "v30"
+
+static void aes_encrypt_arm(const uint32_t *keys, uint32_t rounds, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+	__asm__ __volatile__(
+		AES_ARM_LOAD_KEYS
+		"1:\n"
+		"ld1 {v0.16b}, [%[input]], #16\n"
+		AES_ARM_BLOCK("e", "mc", "v0")
+		"st1 {v0.16b}, [%[output]], #16\n"
+		"subs %[blocks], %[blocks], #1\n"
+		"b.ne 1b\n"
+		: [keys] "+r" (keys), [input] "+r" (input), [output] "+r" (output), [blocks] "+r" (blocks)
+		: [rounds] "r" (rounds)
+		: AES_ARM_CLOBBERS);
+}
+
+static void aes_decrypt_arm(const uint32_t *keys, uint32_t rounds, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+	__asm__ __volatile__(
+		AES_ARM_LOAD_KEYS
+		"1:\n"
+		"ld1 {v0.16b}, [%[input]], #16\n"
+		AES_ARM_BLOCK("d", "imc", "v0")
+		"st1 {v0.16b}, [%[output]], #16\n"
+		"subs %[blocks], %[blocks], #1\n"
+		"b.ne 1b\n"
+		: [keys] "+r" (keys), [input] "+r" (input), [output] "+r" (output), [blocks] "+r" (blocks)
+		: [rounds] "r" (rounds)
+		: AES_ARM_CLOBBERS);
+}
+
+static void aes_cbc_encrypt_arm(const uint32_t *keys, uint32_t rounds, uint8_t *vector, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+	__asm__ __volatile__(
+		AES_ARM_LOAD_KEYS
+		"ld1 {v1.16b}, [%[vector]]\n"
+		"1:\n"
+		"ld1 {v0.16b}, [%[input]], #16\n"
+		"eor v1.16b, v1.16b, v0.16b\n"
+		AES_ARM_BLOCK("e", "mc", "v1")
+		"st1 {v1.16b}, [%[output]], #16\n"
+		"subs %[blocks], %[blocks], #1\n"
+		"b.ne 1b\n"
+		"st1 {v1.16b}, [%[vector]]\n"
+		: [keys] "+r" (keys), [input] "+r" (input), [output] "+r" (output), [blocks] "+r" (blocks)
+		: [rounds] "r" (rounds), [vector] "r" (vector)
+		: AES_ARM_CLOBBERS);
+}
+
+static void aes_cbc_decrypt_arm(const uint32_t *keys, uint32_t rounds, uint8_t *vector, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+	__asm__ __volatile__(
+		AES_ARM_LOAD_KEYS
+		"ld1 {v1.16b}, [%[vector]]\n"
+		"1:\n"
+		"ld1 {v0.16b}, [%[input]], #16\n"
+		"mov v2.16b, v0.16b\n"
+		AES_ARM_BLOCK("d", "imc", "v0")
+		"eor v0.16b, v0.16b, v1.16b\n"
+		"mov v1.16b, v2.16b\n"
+		"st1 {v0.16b}, [%[output]], #16\n"
+		"subs %[blocks], %[blocks], #1\n"
+		"b.ne 1b\n"
+		"st1 {v1.16b}, [%[vector]]\n"
+		: [keys] "+r" (keys), [input] "+r" (input), [output] "+r" (output), [blocks] "+r" (blocks)
+		: [rounds] "r" (rounds), [vector] "r" (vector)
+		: AES_ARM_CLOBBERS);
+}
+
+/* Counter mode with a 128 bit big endian counter held in x10 (High) and x11 (Low) */
+static void aes_ctr_arm(const uint32_t *keys, uint32_t rounds, uint8_t *counter, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+	__asm__ __volatile__(
+		AES_ARM_LOAD_KEYS
+		"ldp x10, x11, [%[counter]]\n"
+		"rev x10, x10\n"
+		"rev x11, x11\n"
+		"1:\n"
+		"rev x12, x10\n"
+		"rev x13, x11\n"
+		"fmov d0, x12\n"
+		"mov v0.d[1], x13\n"
+		"adds x11, x11, #1\n"
+		"adc x10, x10, xzr\n"
+		AES_ARM_BLOCK("e", "mc", "v0")
+		"ld1 {v1.16b}, [%[input]], #16\n"
+		"eor v0.16b, v0.16b, v1.16b\n"
+		"st1 {v0.16b}, [%[output]], #16\n"
+		"subs %[blocks], %[blocks], #1\n"
+		"b.ne 1b\n"
+		"rev x10, x10\n"
+		"rev x11, x11\n"
+		"stp x10, x11, [%[counter]]\n"
+		: [keys] "+r" (keys), [input] "+r" (input), [output] "+r" (output), [blocks] "+r" (blocks)
+		: [rounds] "r" (rounds), [counter] "r" (counter)
+		: AES_ARM_CLOBBERS, "x10", "x11", "x12", "x13");
+}
+
+/* GHASH with PMULL, both values are bit reversed within each byte so that
+   bit n of the 128 bit little endian register is the coefficient of x^n and
+   the product is reduced by x^128 = x^7 + x^2 + x + 1 (0x87) in two folds */
+static void ghash_arm(uint8_t *ghash, const uint8_t *hash, const uint8_t *data, size_t blocks)
+{
+	__asm__ __volatile__(
+		".arch_extension crypto\n"
+		"ld1 {v0.16b}, [%[ghash]]\n"
+		"rbit v0.16b, v0.16b\n"
+		"ld1 {v1.16b}, [%[hash]]\n"
+		"rbit v1.16b, v1.16b\n"
+		"ext v2.16b, v1.16b, v1.16b, #8\n"
+		"mov x9, #0x87\n"
+		"dup v7.2d, x9\n"
+		"movi v6.16b, #0\n"
+		"1:\n"
+		"ld1 {v3.16b}, [%[data]], #16\n"
+		"rbit v3.16b, v3.16b\n"
+		"eor v0.16b, v0.16b, v3.16b\n"
+		/* 256 bit product in v5:v4 */
+		"pmull v4.1q, v0.1d, v1.1d\n"
+		"pmull2 v5.1q, v0.2d, v1.2d\n"
+		"pmull v16.1q, v0.1d, v2.1d\n"
+		"pmull2 v17.1q, v0.2d, v2.2d\n"
+		"eor v16.16b, v16.16b, v17.16b\n"
+		"ext v17.16b, v6.16b, v16.16b, #8\n"
+		"eor v4.16b, v4.16b, v17.16b\n"
+		"ext v17.16b, v16.16b, v6.16b, #8\n"
+		"eor v5.16b, v5.16b, v17.16b\n"
+		/* Fold the top 64 bits, then the remaining 64 plus the overflow */
+		"pmull2 v16.1q, v5.2d, v7.2d\n"
+		"ext v17.16b, v6.16b, v16.16b, #8\n"
+		"eor v4.16b, v4.16b, v17.16b\n"
+		"ext v17.16b, v16.16b, v6.16b, #8\n"
+		"eor v5.16b, v5.16b, v17.16b\n"
+		"pmull v16.1q, v5.1d, v7.1d\n"
+		"eor v0.16b, v4.16b, v16.16b\n"
+		"subs %[blocks], %[blocks], #1\n"
+		"b.ne 1b\n"
+		"rbit v0.16b, v0.16b\n"
+		"st1 {v0.16b}, [%[ghash]]\n"
+		: [data] "+r" (data), [blocks] "+r" (blocks)
+		: [ghash] "r" (ghash), [hash] "r" (hash)
+		: "cc", "memory", "x9", "v0", "v1", "v2", "v3", "v4", "v5", "v6", "v7", "v16", "v17");
+}
+#endif
+
+/* Encrypt or decrypt whole blocks with the best available path */
+static void aes_encrypt_blocks(AES_KEY *aeskey, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+#if defined(CIPHER_ARM64)
+	if (crypto_get_features() & CRYPTO_FEATURE_AES)
+	{
+		aes_encrypt_arm(aeskey->encrypt, aeskey->rounds, input, output, blocks);
+		return;
+	}
+#endif
+
+	while (blocks-- > 0)
+	{
+		aes_encrypt_c(aeskey->encrypt, aeskey->rounds, input, output);
+		input += AES_BLOCK_SIZE;
+		output += AES_BLOCK_SIZE;
+	}
+}
+
+static void aes_decrypt_blocks(AES_KEY *aeskey, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+#if defined(CIPHER_ARM64)
+	if (crypto_get_features() & CRYPTO_FEATURE_AES)
+	{
+		aes_decrypt_arm(aeskey->decrypt, aeskey->rounds, input, output, blocks);
+		return;
+	}
+#endif
+
+	while (blocks-- > 0)
+	{
+		aes_decrypt_c(aeskey->decrypt, aeskey->rounds, input, output);
+		input += AES_BLOCK_SIZE;
+		output += AES_BLOCK_SIZE;
+	}
+}
+
+/* XOR whole blocks with the encrypted counter, incrementing all 128 bits */
+static void aes_ctr_blocks(AES_KEY *aeskey, uint8_t *counter, const uint8_t *input, uint8_t *output, size_t blocks)
+{
+	uint8_t stream[AES_BLOCK_SIZE];
+
+#if defined(CIPHER_ARM64)
+	if (crypto_get_features() & CRYPTO_FEATURE_AES)
+	{
+		aes_ctr_arm(aeskey->encrypt, aeskey->rounds, counter, input, output, blocks);
+		return;
+	}
+#endif
+
+	while (blocks-- > 0)
+	{
+		aes_encrypt_c(aeskey->encrypt, aeskey->rounds, counter, stream);
+		cipher_increment(counter);
+		cipher_xor_block(output, input, stream, AES_BLOCK_SIZE);
+		input += AES_BLOCK_SIZE;
+		output += AES_BLOCK_SIZE;
+	}
+}
+
+/* Counter mode with a partially used key stream block carried between calls */
+static void aes_ctr_stream(AES_KEY *aeskey, uint8_t *counter, uint8_t *stream, uint32_t *used, const uint8_t *input, uint8_t *output, size_t size)
+{
+	size_t blocks;
+
+	while (size > 0 && *used < AES_BLOCK_SIZE)
+	{
+		*output++ = *input++ ^ stream[(*used)++];
+		size--;
+	}
+
+	blocks = size / AES_BLOCK_SIZE;
+	if (blocks > 0)
+	{
+		aes_ctr_blocks(aeskey, counter, input, output, blocks);
+		input += blocks * AES_BLOCK_SIZE;
+		output += blocks * AES_BLOCK_SIZE;
+		size -= blocks * AES_BLOCK_SIZE;
+	}
+
+	if (size > 0)
+	{
+		aes_encrypt_blocks(aeskey, counter, stream, 1);
+		cipher_increment(counter);
+		*used = 0;
+
+		while (size > 0)
+		{
+			*output++ = *input++ ^ stream[(*used)++];
+			size--;
+		}
+	}
+}
+
+/* ============================================================================== */
+/* GCM Internal Functions */
+/* Build the 4 bit multiplication table for the hash key */
+static void aes_gcm_table(AES_GCM_CONTEXT *context)
+{
+	uint64_t high = cipher_load64_be(context->hash);
+	uint64_t low = cipher_load64_be(context->hash + 8);
+	uint64_t carry;
+	uint32_t index;
+	uint32_t count;
+
+	context->table[0][0] = 0;
+	context->table[0][1] = 0;
+	context->table[8][0] = high;
+	context->table[8][1] = low;
+
+	/* Entries 4, 2 and 1 are H times x, x^2 and x^3 */
+	for (index = 4; index > 0; index >>= 1)
+	{
+		carry = (low & 1) ? 0xE100000000000000ULL : 0;
+		low = (high << 63) | (low >> 1);
+		high = (high >> 1) ^ carry;
+		context->table[index][0] = high;
+		context->table[index][1] = low;
+	}
+
+	for (index = 2; index <= 8; index *= 2)
+	{
+		for (count = 1; count < index; count++)
+		{
+			context->table[index + count][0] = context->table[index][0] ^ context->table[count][0];
+			context->table[index + count][1] = context->table[index][1] ^ context->table[count][1];
+		}
+	}
+}
+
+/* Multiply the GHASH value by H using the table */
+static void aes_gcm_multiply(AES_GCM_CONTEXT *context, uint8_t *value)
+{
+	uint64_t high;
+	uint64_t low;
+	uint32_t nibble;
+	uint32_t rem;
+	int32_t index;
+
+	nibble = value[15] & 0xF;
+	high = context->table[nibble][0];
+	low = context->table[nibble][1];
+
+	for (index = 15; index >= 0; index--)
+	{
+		if (index != 15)
+		{
+			nibble = value[index] & 0xF;
+			rem = low & 0xF;
+			low = (high << 60) | (low >> 4);
+			high = (high >> 4) ^ (ghash_last4[rem] << 48) ^ context->table[nibble][0];
+			low ^= context->table[nibble][1];
+		}
+
+		nibble = value[index] >> 4;
+		rem = low & 0xF;
+		low = (high << 60) | (low >> 4);
+		high = (high >> 4) ^ (ghash_last4[rem] << 48) ^ context->table[nibble][0];
+		low ^= context->table[nibble][1];
+	}
+
+	cipher_store64_be(value, high);
+	cipher_store64_be(value + 8, low);
+}
+
+static void aes_gcm_hash_blocks(AES_GCM_CONTEXT *context, const uint8_t *data, size_t blocks)
+{
+#if defined(CIPHER_ARM64)
+	if (crypto_get_features() & CRYPTO_FEATURE_PMULL)
+	{
+		ghash_arm(context->ghash, context->hash, data, blocks);
+		return;
+	}
+#endif
+
+	while (blocks-- > 0)
+	{
+		cipher_xor_block(context->ghash, context->ghash, data, AES_BLOCK_SIZE);
+		aes_gcm_multiply(context, context->ghash);
+		data += AES_BLOCK_SIZE;
+	}
+}
+
+/* Add data to GHASH, holding any partial block until more data or a flush */
+static void aes_gcm_hash(AES_GCM_CONTEXT *context, const uint8_t *data, size_t size)
+{
+	uint32_t fill;
+	size_t blocks;
+
+	if (context->partialsize > 0)
+	{
+		fill = AES_BLOCK_SIZE - context->partialsize;
+		if (size < fill)
+		{
+			memcpy(context->partial + context->partialsize, data, size);
+			context->partialsize += size;
+			return;
+		}
+
+		memcpy(context->partial + context->partialsize, data, fill);
+		aes_gcm_hash_blocks(context, context->partial, 1);
+		context->partialsize = 0;
+		data += fill;
+		size -= fill;
+	}
+
+	blocks = size / AES_BLOCK_SIZE;
+	if (blocks > 0)
+	{
+		aes_gcm_hash_blocks(context, data, blocks);
+		data += blocks * AES_BLOCK_SIZE;
+		size -= blocks * AES_BLOCK_SIZE;
+	}
+
+	if (size > 0)
+	{
+		memcpy(context->partial, data, size);
+		context->partialsize = size;
+	}
+}
+
+/* Pad any partial block with zeros and hash it */
+static void aes_gcm_hash_flush(AES_GCM_CONTEXT *context)
+{
+	if (context->partialsize == 0)
+		return;
+
+	memset(context->partial + context->partialsize, 0, AES_BLOCK_SIZE - context->partialsize);
+	aes_gcm_hash_blocks(context, context->partial, 1);
+	context->partialsize = 0;
+}
+
+/* Increment only the low 32 bits of the counter */
+static inline void aes_gcm_increment(uint8_t *counter)
+{
+	cipher_store32_be(counter + 12, cipher_load32_be(counter + 12) + 1);
+}
+
+/* Counter mode for GCM, bulk calls are split where the low 32 bits wrap and the upper 96 bits restored */
+static void aes_gcm_ctr(AES_GCM_CONTEXT *context, const uint8_t *input, uint8_t *output, size_t size)
+{
+	uint8_t upper[AES_BLOCK_SIZE - 4];
+	uint64_t remain;
+	size_t blocks;
+	size_t count;
+
+	while (size > 0 && context->used < AES_BLOCK_SIZE)
+	{
+		*output++ = *input++ ^ context->stream[context->used++];
+		size--;
+	}
+
+	blocks = size / AES_BLOCK_SIZE;
+	while (blocks > 0)
+	{
+		remain = 0x100000000ULL - cipher_load32_be(context->counter + 12);
+		count = (blocks < remain) ? blocks : (size_t)remain;
+
+		memcpy(upper, context->counter, sizeof(upper));
+		aes_ctr_blocks(&context->key, context->counter, input, output, count);
+		memcpy(context->counter, upper, sizeof(upper));
+
+		input += count * AES_BLOCK_SIZE;
+		output += count * AES_BLOCK_SIZE;
+		size -= count * AES_BLOCK_SIZE;
+		blocks -= count;
+	}
+
+	if (size > 0)
+	{
+		aes_encrypt_blocks(&context->key, context->counter, context->stream, 1);
+		aes_gcm_increment(context->counter);
+		context->used = 0;
+
+		while (size > 0)
+		{
+			*output++ = *input++ ^ context->stream[context->used++];
+			size--;
+		}
+	}
+}
+
+static BOOL aes_gcm_begin_data(AES_GCM_CONTEXT *context)
+{
+	if (context->state == AES_GCM_STATE_AAD)
+	{
+		aes_gcm_hash_flush(context);
+		context->state = AES_GCM_STATE_DATA;
+	}
+
+	return (context->state == AES_GCM_STATE_DATA);
+}
+
+/* ============================================================================== */
+/* DES Internal Functions */
+/* Swap the bits of b selected by mask with the bits of a shifted by n */
+#define DES_PERM_OP(a, b, n, m) \
+	{ \
+		uint32_t t = (((a) >> (n)) ^ (b)) & (m); \
+		(b) ^= t; \
+		(a) ^= t << (n); \
+	}
+
+static void des_crypt(const uint32_t *keys, const uint8_t *input, uint8_t *output)
+{
+	uint32_t left = cipher_load32_be(input);
+	uint32_t right = cipher_load32_be(input + 4);
+	uint32_t value;
+	uint32_t round;
+
+	/* Initial permutation */
+	DES_PERM_OP(left, right, 4, 0x0F0F0F0F);
+	DES_PERM_OP(left, right, 16, 0x0000FFFF);
+	DES_PERM_OP(right, left, 2, 0x33333333);
+	DES_PERM_OP(right, left, 8, 0x00FF00FF);
+	DES_PERM_OP(left, right, 1, 0x55555555);
+
+	for (round = 0; round < 16; round++)
+	{
+		/* Each S-box takes 6 bits of the expansion of right, which are 6 consecutive bits with wrap around */
+		value = cipher.sp[0][(cipher_rol32(right, 5) ^ (keys[0] >> 24)) & 0x3F] ^
+			cipher.sp[1][(cipher_rol32(right, 9) ^ (keys[0] >> 16)) & 0x3F] ^
+			cipher.sp[2][(cipher_rol32(right, 13) ^ (keys[0] >> 8)) & 0x3F] ^
+			cipher.sp[3][(cipher_rol32(right, 17) ^ keys[0]) & 0x3F] ^
+			cipher.sp[4][(cipher_rol32(right, 21) ^ (keys[1] >> 24)) & 0x3F] ^
+			cipher.sp[5][(cipher_rol32(right, 25) ^ (keys[1] >> 16)) & 0x3F] ^
+			cipher.sp[6][(cipher_rol32(right, 29) ^ (keys[1] >> 8)) & 0x3F] ^
+			cipher.sp[7][(cipher_rol32(right, 1) ^ keys[1]) & 0x3F];
+
+		value ^= left;
+		left = right;
+		right = value;
+		keys += 2;
+	}
+
+	/* Final permutation of right and left (The halves are swapped after the last round) */
+	DES_PERM_OP(right, left, 1, 0x55555555);
+	DES_PERM_OP(left, right, 8, 0x00FF00FF);
+	DES_PERM_OP(left, right, 2, 0x33333333);
+	DES_PERM_OP(right, left, 16, 0x0000FFFF);
+	DES_PERM_OP(right, left, 4, 0x0F0F0F0F);
+
+	cipher_store32_be(output, right);
+	cipher_store32_be(output + 4, left);
+}
+
+/* Expand an 8 byte key into 16 round keys, each stored as eight 6 bit groups in two words */
+static void des_key_schedule(const uint8_t *key, DES_KEY *encryptkey, DES_KEY *decryptkey)
+{
+	uint64_t value = cipher_load64_be(key);
+	uint32_t c = 0;
+	uint32_t d = 0;
+	uint64_t cd;
+	uint32_t bit;
+	uint32_t round;
+	uint32_t group;
+	uint32_t words[2];
+
+	/* Permuted choice 1 into two 28 bit halves */
+	for (bit = 0; bit < 56; bit++)
+	{
+		if ((value >> (64 - des_pc1[bit])) & 1)
+		{
+			if (bit < 28)
+				c |= 1U << (27 - bit);
+			else
+				d |= 1U << (55 - bit);
+		}
+	}
+
+	for (round = 0; round < 16; round++)
+	{
+		c = ((c << des_shifts[round]) | (c >> (28 - des_shifts[round]))) & 0x0FFFFFFF;
+		d = ((d << des_shifts[round]) | (d >> (28 - des_shifts[round]))) & 0x0FFFFFFF;
+		cd = ((uint64_t)c << 28) | d;
+
+		/* Permuted choice 2, bit n of the 48 bit key goes to group n / 6 */
+		words[0] = 0;
+		words[1] = 0;
+		for (bit = 0; bit < 48; bit++)
+		{
+			if ((cd >> (56 - des_pc2[bit])) & 1)
+			{
+				group = bit / 6;
+				words[group / 4] |= 1U << ((3 - (group & 3)) * 8 + (5 - (bit % 6)));
+			}
+		}
+
+		if (encryptkey)
+		{
+			encryptkey->keys[round * 2] = words[0];
+			encryptkey->keys[(round * 2) + 1] = words[1];
+		}
+
+		if (decryptkey)
+		{
+			decryptkey->keys[(15 - round) * 2] = words[0];
+			decryptkey->keys[((15 - round) * 2) + 1] = words[1];
+		}
+	}
+}
+
+/* ============================================================================== */
+/* Cipher Context Internal Functions */
+static BOOL cipher_check(CIPHER_CONTEXT *context)
+{
+	return (context && context->signature == CRYPTO_CIPHER_SIGNATURE);
+}
+
+static void cipher_encrypt_block(CIPHER_CONTEXT *context, const uint8_t *input, uint8_t *output)
+{
+	switch (context->algorithm)
+	{
+		case CRYPTO_CIPHER_ALG_AES:
+			aes_encrypt_block(input, output, &context->key.aes);
+			break;
+		case CRYPTO_CIPHER_ALG_DES:
+			des_encrypt_block(input, output, &context->key.des.encrypt);
+			break;
+		case CRYPTO_CIPHER_ALG_3DES:
+			des3_encrypt_block(input, output, &context->key.des3);
+			break;
+	}
+}
+
+static void cipher_decrypt_block(CIPHER_CONTEXT *context, const uint8_t *input, uint8_t *output)
+{
+	switch (context->algorithm)
+	{
+		case CRYPTO_CIPHER_ALG_AES:
+			aes_decrypt_block(input, output, &context->key.aes);
+			break;
+		case CRYPTO_CIPHER_ALG_DES:
+			des_decrypt_block(input, output, &context->key.des.decrypt);
+			break;
+		case CRYPTO_CIPHER_ALG_3DES:
+			des3_decrypt_block(input, output, &context->key.des3);
+			break;
+	}
+}
+
+/* Counter mode for the 8 byte block ciphers (AES uses aes_ctr_stream) */
+static void cipher_ctr_stream(CIPHER_CONTEXT *context, const uint8_t *input, uint8_t *output, size_t size)
+{
+	int32_t index;
+
+	while (size > 0)
+	{
+		if (context->used >= context->blocksize)
+		{
+			cipher_encrypt_block(context, context->vector, context->stream);
+			for (index = context->blocksize - 1; index >= 0; index--)
+			{
+				if (++context->vector[index] != 0)
+					break;
+			}
+			context->used = 0;
+		}
+
+		*output++ = *input++ ^ context->stream[context->used++];
+		size--;
+	}
+}
+
+/* ECB and CBC for any block cipher */
+static BOOL cipher_crypt_blocks(CIPHER_CONTEXT *context, const uint8_t *input, uint8_t *output, size_t size, BOOL encrypt)
+{
+	uint8_t block[AES_BLOCK_SIZE];
+	uint32_t blocksize = context->blocksize;
+
+	if ((size % blocksize) != 0)
+		return FALSE;
+
+	if (context->algorithm == CRYPTO_CIPHER_ALG_AES)
+	{
+		if (context->mode == CRYPTO_CIPHER_MODE_ECB)
+			return encrypt ? aes_ecb_encrypt(&context->key.aes, input, output, size) : aes_ecb_decrypt(&context->key.aes, input, output, size);
+
+		return encrypt ? aes_cbc_encrypt(&context->key.aes, context->vector, input, output, size) : aes_cbc_decrypt(&context->key.aes, context->vector, input, output, size);
+	}
+
+	while (size > 0)
+	{
+		if (context->mode == CRYPTO_CIPHER_MODE_ECB)
+		{
+			if (encrypt)
+				cipher_encrypt_block(context, input, output);
+			else
+				cipher_decrypt_block(context, input, output);
+		}
+		else if (encrypt)
+		{
+			cipher_xor_block(block, input, context->vector, blocksize);
+			cipher_encrypt_block(context, block, output);
+			memcpy(context->vector, output, blocksize);
+		}
+		else
+		{
+			/* Keep the cipher text in case input and output are the same */
+			memcpy(block, input, blocksize);
+			cipher_decrypt_block(context, input, output);
+			cipher_xor_block(output, output, context->vector, blocksize);
+			memcpy(context->vector, block, blocksize);
+		}
+
+		input += blocksize;
+		output += blocksize;
+		size -= blocksize;
+	}
+
+	return TRUE;
+}
+
+static BOOL cipher_crypt(CIPHER_CONTEXT *context, const void *input, void *output, size_t size, BOOL encrypt)
+{
+	if (!cipher_check(context))
+		return FALSE;
+
+	if ((!input || !output) && size > 0)
+		return FALSE;
+
+	if (size == 0)
+		return TRUE;
+
+	if (context->algorithm == CRYPTO_CIPHER_ALG_RC4)
+	{
+		rc4_update(&context->key.rc4, input, output, size);
+		return TRUE;
+	}
+
+	if (context->mode == CRYPTO_CIPHER_MODE_CTR)
+	{
+		if (context->algorithm == CRYPTO_CIPHER_ALG_AES)
+			aes_ctr_stream(&context->key.aes, context->vector, context->stream, &context->used, input, output, size);
+		else
+			cipher_ctr_stream(context, input, output, size);
+
+		return TRUE;
+	}
+
+	return cipher_crypt_blocks(context, input, output, size, encrypt);
+}
+
+/* ============================================================================== */
+/* AES Functions */
+BOOL STDCALL aes_key_setup(const void *key, uint32_t keysize, AES_KEY *aeskey)
+{
+	const uint8_t *bytes = key;
+	uint32_t *w;
+	uint32_t words;
+	uint32_t total;
+	uint32_t index;
+	uint32_t rcon;
+	uint32_t value;
+	uint32_t round;
+
+	if (!key || !aeskey)
+		return FALSE;
+
+	if (keysize != AES_KEY_SIZE128 && keysize != AES_KEY_SIZE192 && keysize != AES_KEY_SIZE256)
+		return FALSE;
+
+	cipher_start();
+
+	words = keysize / 4;
+	aeskey->rounds = words + 6;
+	total = 4 * (aeskey->rounds + 1);
+	w = aeskey->encrypt;
+
+	for (index = 0; index < words; index++)
+		w[index] = cipher_load32_le(bytes + (index * 4));
+
+	rcon = 1;
+	for (index = words; index < total; index++)
+	{
+		value = w[index - 1];
+		if ((index % words) == 0)
+		{
+			/* RotWord moves byte 1 to byte 0 which is a right rotate of the little endian word */
+			value = aes_sub_word((value >> 8) | (value << 24)) ^ rcon;
+			rcon = aes_multiply(rcon, 2);
+		}
+		else if (words > 6 && (index % words) == 4)
+		{
+			value = aes_sub_word(value);
+		}
+
+		w[index] = w[index - words] ^ value;
+	}
+
+	/* Decryption keys in reverse order with InvMixColumns applied to the inner rounds */
+	for (round = 0; round <= aeskey->rounds; round++)
+	{
+		for (index = 0; index < 4; index++)
+		{
+			value = w[((aeskey->rounds - round) * 4) + index];
+			if (round > 0 && round < aeskey->rounds)
+				value = aes_inv_mix_word(value);
+
+			aeskey->decrypt[(round * 4) + index] = value;
+		}
+	}
+
+	return TRUE;
+}
+
+void STDCALL aes_encrypt_block(const void *plain, void *crypt, AES_KEY *aeskey)
+{
+	cipher_start();
+
+	aes_encrypt_blocks(aeskey, plain, crypt, 1);
+}
+
+void STDCALL aes_decrypt_block(const void *crypt, void *plain, AES_KEY *aeskey)
+{
+	cipher_start();
+
+	aes_decrypt_blocks(aeskey, crypt, plain, 1);
+}
+
+BOOL STDCALL aes_ecb_encrypt(AES_KEY *aeskey, const void *plain, void *crypt, size_t size)
+{
+	if (!aeskey || !plain || !crypt || (size % AES_BLOCK_SIZE) != 0)
+		return FALSE;
+
+	cipher_start();
+
+	if (size > 0)
+		aes_encrypt_blocks(aeskey, plain, crypt, size / AES_BLOCK_SIZE);
+
+	return TRUE;
+}
+
+BOOL STDCALL aes_ecb_decrypt(AES_KEY *aeskey, const void *crypt, void *plain, size_t size)
+{
+	if (!aeskey || !crypt || !plain || (size % AES_BLOCK_SIZE) != 0)
+		return FALSE;
+
+	cipher_start();
+
+	if (size > 0)
+		aes_decrypt_blocks(aeskey, crypt, plain, size / AES_BLOCK_SIZE);
+
+	return TRUE;
+}
+
+BOOL STDCALL aes_cbc_encrypt(AES_KEY *aeskey, uint8_t *vector, const void *plain, void *crypt, size_t size)
+{
+	const uint8_t *input = plain;
+	uint8_t *output = crypt;
+
+	if (!aeskey || !vector || !plain || !crypt || (size % AES_BLOCK_SIZE) != 0)
+		return FALSE;
+
+	if (size == 0)
+		return TRUE;
+
+	cipher_start();
+
+#if defined(CIPHER_ARM64)
+	if (crypto_get_features() & CRYPTO_FEATURE_AES)
+	{
+		aes_cbc_encrypt_arm(aeskey->encrypt, aeskey->rounds, vector, input, output, size / AES_BLOCK_SIZE);
+		return TRUE;
+	}
+#endif
+
+	while (size > 0)
+	{
+		cipher_xor_block(vector, vector, input, AES_BLOCK_SIZE);
+		aes_encrypt_c(aeskey->encrypt, aeskey->rounds, vector, vector);
+		memcpy(output, vector, AES_BLOCK_SIZE);
+		input += AES_BLOCK_SIZE;
+		output += AES_BLOCK_SIZE;
+		size -= AES_BLOCK_SIZE;
+	}
+
+	return TRUE;
+}
+
+BOOL STDCALL aes_cbc_decrypt(AES_KEY *aeskey, uint8_t *vector, const void *crypt, void *plain, size_t size)
+{
+	const uint8_t *input = crypt;
+	uint8_t *output = plain;
+	uint8_t block[AES_BLOCK_SIZE];
+
+	if (!aeskey || !vector || !crypt || !plain || (size % AES_BLOCK_SIZE) != 0)
+		return FALSE;
+
+	if (size == 0)
+		return TRUE;
+
+	cipher_start();
+
+#if defined(CIPHER_ARM64)
+	if (crypto_get_features() & CRYPTO_FEATURE_AES)
+	{
+		aes_cbc_decrypt_arm(aeskey->decrypt, aeskey->rounds, vector, input, output, size / AES_BLOCK_SIZE);
+		return TRUE;
+	}
+#endif
+
+	while (size > 0)
+	{
+		memcpy(block, input, AES_BLOCK_SIZE);
+		aes_decrypt_c(aeskey->decrypt, aeskey->rounds, input, output);
+		cipher_xor_block(output, output, vector, AES_BLOCK_SIZE);
+		memcpy(vector, block, AES_BLOCK_SIZE);
+		input += AES_BLOCK_SIZE;
+		output += AES_BLOCK_SIZE;
+		size -= AES_BLOCK_SIZE;
+	}
+
+	return TRUE;
+}
+
+BOOL STDCALL aes_ctr_init(AES_CTR_CONTEXT *context, const void *key, uint32_t keysize, const void *nonce)
+{
+	if (!context || !nonce)
+		return FALSE;
+
+	if (!aes_key_setup(key, keysize, &context->key))
+		return FALSE;
+
+	memcpy(context->counter, nonce, AES_BLOCK_SIZE);
+	context->used = AES_BLOCK_SIZE;
+
+	return TRUE;
+}
+
+void STDCALL aes_ctr_update(AES_CTR_CONTEXT *context, const void *input, void *output, size_t size)
+{
+	if (!context || !input || !output || size == 0)
+		return;
+
+	aes_ctr_stream(&context->key, context->counter, context->stream, &context->used, input, output, size);
+}
+
+BOOL STDCALL aes_ctr_encrypt_data(const void *key, uint32_t keysize, const void *nonce, const void *plain, void *crypt, size_t size)
+{
+	AES_CTR_CONTEXT context;
+
+	if (!plain || !crypt)
+		return FALSE;
+
+	if (!aes_ctr_init(&context, key, keysize, nonce))
+		return FALSE;
+
+	aes_ctr_update(&context, plain, crypt, size);
+
+	memset(&context, 0, sizeof(AES_CTR_CONTEXT));
+
+	return TRUE;
+}
+
+BOOL STDCALL aes_ctr_decrypt_data(const void *key, uint32_t keysize, const void *nonce, const void *crypt, void *plain, size_t size)
+{
+	return aes_ctr_encrypt_data(key, keysize, nonce, crypt, plain, size);
+}
+
+BOOL STDCALL aes_gcm_init(AES_GCM_CONTEXT *context, const void *key, uint32_t keysize, const void *iv, uint32_t ivsize)
+{
+	uint8_t block[AES_BLOCK_SIZE];
+
+	if (!context || !iv || ivsize == 0)
+		return FALSE;
+
+	memset(context, 0, sizeof(AES_GCM_CONTEXT));
+
+	if (!aes_key_setup(key, keysize, &context->key))
+		return FALSE;
+
+	/* Hash key is the encrypted zero block */
+	aes_encrypt_blocks(&context->key, context->hash, context->hash, 1);
+	aes_gcm_table(context);
+
+	if (ivsize == AES_GCM_IV_SIZE)
+	{
+		memcpy(context->initial, iv, AES_GCM_IV_SIZE);
+		context->initial[15] = 1;
+	}
+	else
+	{
+		/* Other sizes are hashed along with their length in bits */
+		aes_gcm_hash(context, iv, ivsize);
+		aes_gcm_hash_flush(context);
+
+		memset(block, 0, AES_BLOCK_SIZE);
+		cipher_store64_be(block + 8, (uint64_t)ivsize * 8);
+		aes_gcm_hash_blocks(context, block, 1);
+
+		memcpy(context->initial, context->ghash, AES_BLOCK_SIZE);
+		memset(context->ghash, 0, AES_BLOCK_SIZE);
+	}
+
+	memcpy(context->counter, context->initial, AES_BLOCK_SIZE);
+	aes_gcm_increment(context->counter);
+
+	context->used = AES_BLOCK_SIZE;
+	context->state = AES_GCM_STATE_AAD;
+
+	return TRUE;
+}
+
+BOOL STDCALL aes_gcm_aad(AES_GCM_CONTEXT *context, const void *aad, size_t size)
+{
+	if (!context || context->state != AES_GCM_STATE_AAD)
+		return FALSE;
+
+	if (!aad && size > 0)
+		return FALSE;
+
+	aes_gcm_hash(context, aad, size);
+	context->aadsize += size;
+
+	return TRUE;
+}
+
+BOOL STDCALL aes_gcm_encrypt(AES_GCM_CONTEXT *context, const void *plain, void *crypt, size_t size)
+{
+	if (!context || !aes_gcm_begin_data(context))
+		return FALSE;
+
+	if (size == 0)
+		return TRUE;
+
+	if (!plain || !crypt)
+		return FALSE;
+
+	aes_gcm_ctr(context, plain, crypt, size);
+	aes_gcm_hash(context, crypt, size);
+	context->datasize += size;
+
+	return TRUE;
+}
+
+BOOL STDCALL aes_gcm_decrypt(AES_GCM_CONTEXT *context, const void *crypt, void *plain, size_t size)
+{
+	if (!context || !aes_gcm_begin_data(context))
+		return FALSE;
+
+	if (size == 0)
+		return TRUE;
+
+	if (!crypt || !plain)
+		return FALSE;
+
+	/* Hash first in case crypt and plain are the same buffer */
+	aes_gcm_hash(context, crypt, size);
+	aes_gcm_ctr(context, crypt, plain, size);
+	context->datasize += size;
+
+	return TRUE;
+}
+
+BOOL STDCALL aes_gcm_final(AES_GCM_CONTEXT *context, void *tag)
+{
+	uint8_t block[AES_BLOCK_SIZE];
+
+	if (!context || !tag || !aes_gcm_begin_data(context))
+		return FALSE;
+
+	aes_gcm_hash_flush(context);
+
+	cipher_store64_be(block, context->aadsize * 8);
+	cipher_store64_be(block + 8, context->datasize * 8);
+	aes_gcm_hash_blocks(context, block, 1);
+
+	aes_encrypt_blocks(&context->key, context->initial, block, 1);
+	cipher_xor_block(tag, block, context->ghash, AES_GCM_TAG_SIZE);
+
+	context->state = AES_GCM_STATE_DONE;
+
+	return TRUE;
+}
+
+BOOL STDCALL aes_gcm_verify(AES_GCM_CONTEXT *context, const void *tag, uint32_t tagsize)
+{
+	uint8_t expected[AES_GCM_TAG_SIZE];
+	const uint8_t *bytes = tag;
+	uint8_t difference = 0;
+	uint32_t count;
+
+	if (!tag || tagsize == 0 || tagsize > AES_GCM_TAG_SIZE)
+		return FALSE;
+
+	if (!aes_gcm_final(context, expected))
+		return FALSE;
+
+	for (count = 0; count < tagsize; count++)
+		difference |= expected[count] ^ bytes[count];
+
+	return (difference == 0);
+}
+
+BOOL STDCALL aes_gcm_encrypt_data(const void *key, uint32_t keysize, const void *iv, const void *aad, const void *plain, void *crypt, uint32_t ivsize, uint32_t aadsize, size_t size, void *tag)
+{
+	AES_GCM_CONTEXT context;
+	BOOL result;
+
+	if (!aes_gcm_init(&context, key, keysize, iv, ivsize))
+		return FALSE;
+
+	result = aes_gcm_aad(&context, aad, aadsize) && aes_gcm_encrypt(&context, plain, crypt, size) && aes_gcm_final(&context, tag);
+
+	memset(&context, 0, sizeof(AES_GCM_CONTEXT));
+
+	return result;
+}
+
+BOOL STDCALL aes_gcm_decrypt_data(const void *key, uint32_t keysize, const void *iv, const void *aad, const void *crypt, void *plain, uint32_t ivsize, uint32_t aadsize, size_t size, const void *tag)
+{
+	AES_GCM_CONTEXT context;
+	BOOL result;
+
+	if (!aes_gcm_init(&context, key, keysize, iv, ivsize))
+		return FALSE;
+
+	result = aes_gcm_aad(&context, aad, aadsize) && aes_gcm_decrypt(&context, crypt, plain, size) && aes_gcm_verify(&context, tag, AES_GCM_TAG_SIZE);
+
+	/* Do not release unauthenticated plain text */
+	if (!result && plain && size > 0)
+		memset(plain, 0, size);
+
+	memset(&context, 0, sizeof(AES_GCM_CONTEXT));
+
+	return result;
+}
+
+BOOL STDCALL aes_gcm_gmac_data(const void *key, uint32_t keysize, const void *iv, const void *aad, uint32_t ivsize, uint32_t aadsize, void *tag)
+{
+	return aes_gcm_encrypt_data(key, keysize, iv, aad, NULL, NULL, ivsize, aadsize, 0, tag);
+}
+
+/* ============================================================================== */
+/* DES Functions */
+BOOL STDCALL des_key_setup(const void *key, uint32_t keysize, DES_KEY *encryptkey, DES_KEY *decryptkey)
+{
+	if (!key || keysize != DES_KEY_SIZE)
+		return FALSE;
+
+	if (!encryptkey && !decryptkey)
+		return FALSE;
+
+	cipher_start();
+
+	des_key_schedule(key, encryptkey, decryptkey);
+
+	return TRUE;
+}
+
+void STDCALL des_encrypt_block(const void *plain, void *crypt, DES_KEY *key)
+{
+	cipher_start();
+
+	des_crypt(key->keys, plain, crypt);
+}
+
+void STDCALL des_decrypt_block(const void *crypt, void *plain, DES_KEY *key)
+{
+	cipher_start();
+
+	des_crypt(key->keys, crypt, plain);
+}
+
+BOOL STDCALL des3_key_setup(const void *key, uint32_t keysize, DES3_KEY *des3key)
+{
+	const uint8_t *bytes = key;
+
+	if (!key || !des3key)
+		return FALSE;
+
+	if (keysize != DES3_KEY_SIZE && keysize != DES_KEY_SIZE * 2)
+		return FALSE;
+
+	cipher_start();
+
+	/* Encrypt with K1, decrypt with K2, encrypt with K3 (K3 is K1 for a 16 byte key), each array holds the schedules in the order applied */
+	des_key_schedule(bytes, &des3key->encrypt[0], &des3key->decrypt[2]);
+	des_key_schedule(bytes + DES_KEY_SIZE, &des3key->decrypt[1], &des3key->encrypt[1]);
+	des_key_schedule((keysize == DES3_KEY_SIZE) ? bytes + (DES_KEY_SIZE * 2) : bytes, &des3key->encrypt[2], &des3key->decrypt[0]);
+
+	return TRUE;
+}
+
+void STDCALL des3_encrypt_block(const void *plain, void *crypt, DES3_KEY *des3key)
+{
+	cipher_start();
+
+	des_crypt(des3key->encrypt[0].keys, plain, crypt);
+	des_crypt(des3key->encrypt[1].keys, crypt, crypt);
+	des_crypt(des3key->encrypt[2].keys, crypt, crypt);
+}
+
+void STDCALL des3_decrypt_block(const void *crypt, void *plain, DES3_KEY *des3key)
+{
+	cipher_start();
+
+	des_crypt(des3key->decrypt[0].keys, crypt, plain);
+	des_crypt(des3key->decrypt[1].keys, plain, plain);
+	des_crypt(des3key->decrypt[2].keys, plain, plain);
+}
+
+/* ============================================================================== */
+/* RC4 Functions */
+BOOL STDCALL rc4_init(RC4_STATE *state, const void *key, uint32_t keysize)
+{
+	const uint8_t *bytes = key;
+	uint32_t index;
+	uint8_t j;
+	uint8_t t;
+
+	if (!state || !key || keysize == 0 || keysize > RC4_MAX_KEY_SIZE)
+		return FALSE;
+
+	for (index = 0; index < 256; index++)
+		state->s[index] = index;
+
+	j = 0;
+	for (index = 0; index < 256; index++)
+	{
+		j += state->s[index] + bytes[index % keysize];
+		t = state->s[index];
+		state->s[index] = state->s[j];
+		state->s[j] = t;
+	}
+
+	state->i = 0;
+	state->j = 0;
+
+	return TRUE;
+}
+
+void STDCALL rc4_update(RC4_STATE *state, const void *input, void *output, size_t size)
+{
+	const uint8_t *source = input;
+	uint8_t *dest = output;
+	uint8_t *s;
+	uint8_t i;
+	uint8_t j;
+	uint8_t t;
+
+	if (!state)
+		return;
+
+	s = state->s;
+	i = state->i;
+	j = state->j;
+
+	while (size-- > 0)
+	{
+		i++;
+		j += s[i];
+		t = s[i];
+		s[i] = s[j];
+		s[j] = t;
+
+		/* A NULL input just advances the key stream */
+		if (source)
+			*dest++ = *source++ ^ s[(uint8_t)(s[i] + s[j])];
+	}
+
+	state->i = i;
+	state->j = j;
+}
+
+BOOL STDCALL rc4_encrypt_data(const void *key, uint32_t keysize, const void *plain, void *crypt, size_t size, uint32_t start)
+{
+	RC4_STATE state;
+
+	if (!plain || !crypt)
+		return FALSE;
+
+	if (!rc4_init(&state, key, keysize))
+		return FALSE;
+
+	rc4_update(&state, NULL, NULL, start);
+	rc4_update(&state, plain, crypt, size);
+
+	memset(&state, 0, sizeof(RC4_STATE));
+
+	return TRUE;
+}
+
+BOOL STDCALL rc4_decrypt_data(const void *key, uint32_t keysize, const void *crypt, void *plain, size_t size, uint32_t start)
+{
+	return rc4_encrypt_data(key, keysize, crypt, plain, size, start);
+}
+
+/* ============================================================================== */
+/* Cipher Functions */
+CIPHER_CONTEXT * STDCALL cipher_create(uint32_t algorithm, const void *vector, const void *key, uint32_t keysize)
+{
+	return cipher_create_ex(algorithm, (algorithm == CRYPTO_CIPHER_ALG_RC4) ? CRYPTO_CIPHER_MODE_NONE : CRYPTO_CIPHER_MODE_CBC, vector, key, keysize);
+}
+
+CIPHER_CONTEXT * STDCALL cipher_create_ex(uint32_t algorithm, uint32_t mode, const void *vector, const void *key, uint32_t keysize)
+{
+	CIPHER_CONTEXT *context;
+	BOOL result;
+
+	if (!key)
+		return NULL;
+
+	/* Stream ciphers have no mode, block ciphers must have one */
+	if ((algorithm == CRYPTO_CIPHER_ALG_RC4) != (mode == CRYPTO_CIPHER_MODE_NONE))
+		return NULL;
+
+	if (mode > CRYPTO_CIPHER_MODE_CTR)
+		return NULL;
+
+	context = calloc(1, sizeof(CIPHER_CONTEXT));
+	if (!context)
+		return NULL;
+
+	context->algorithm = algorithm;
+	context->mode = mode;
+	context->blocksize = cipher_get_block_size(algorithm);
+	context->used = context->blocksize;
+
+	switch (algorithm)
+	{
+		case CRYPTO_CIPHER_ALG_AES:
+			result = aes_key_setup(key, keysize, &context->key.aes);
+			break;
+		case CRYPTO_CIPHER_ALG_DES:
+			result = des_key_setup(key, keysize, &context->key.des.encrypt, &context->key.des.decrypt);
+			break;
+		case CRYPTO_CIPHER_ALG_3DES:
+			result = des3_key_setup(key, keysize, &context->key.des3);
+			break;
+		case CRYPTO_CIPHER_ALG_RC4:
+			result = rc4_init(&context->key.rc4, key, keysize);
+			break;
+		default:
+			result = FALSE;
+			break;
+	}
+
+	if (!result)
+	{
+		free(context);
+		return NULL;
+	}
+
+	/* A missing vector is treated as all zeros */
+	if (vector && context->blocksize > 0)
+		memcpy(context->vector, vector, context->blocksize);
+
+	context->signature = CRYPTO_CIPHER_SIGNATURE;
+
+	return context;
+}
+
+BOOL STDCALL cipher_destroy(CIPHER_CONTEXT *context)
+{
+	if (!cipher_check(context))
+		return FALSE;
+
+	/* Clear the key schedule before freeing */
+	memset(context, 0, sizeof(CIPHER_CONTEXT));
+	free(context);
+
+	return TRUE;
+}
+
+BOOL STDCALL cipher_encrypt(CIPHER_CONTEXT *context, const void *plain, void *crypt, size_t size)
+{
+	return cipher_crypt(context, plain, crypt, size, TRUE);
+}
+
+BOOL STDCALL cipher_decrypt(CIPHER_CONTEXT *context, const void *crypt, void *plain, size_t size)
+{
+	return cipher_crypt(context, crypt, plain, size, FALSE);
+}
+
+uint32_t STDCALL cipher_get_block_size(uint32_t algorithm)
+{
+	switch (algorithm)
+	{
+		case CRYPTO_CIPHER_ALG_AES:
+			return AES_BLOCK_SIZE;
+		case CRYPTO_CIPHER_ALG_DES:
+		case CRYPTO_CIPHER_ALG_3DES:
+			return DES_BLOCK_SIZE;
+	}
+
+	return 0;
+}
+
+/* ============================================================================== */
+/* Cipher Helper Functions */
+uint32_t STDCALL crypto_cipher_alg_to_string(uint32_t algorithm, char *string, uint32_t len)
+{
+	const char *value;
+
+	if (!string || len == 0)
+		return 0;
+
+	switch (algorithm)
+	{
+		case CRYPTO_CIPHER_ALG_AES:
+			value = "AES";
+			break;
+		case CRYPTO_CIPHER_ALG_DES:
+			value = "DES";
+			break;
+		case CRYPTO_CIPHER_ALG_3DES:
+			value = "3DES";
+			break;
+		case CRYPTO_CIPHER_ALG_RC4:
+			value = "RC4";
+			break;
+		default:
+			value = "Unknown";
+			break;
+	}
+
+	strncpy(string, value, len - 1);
+	string[len - 1] = '\0';
+
+	return strlen(string);
+}
@@ -0,0 +1,1105 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/threads.h"
+#include "ultibo/platform.h"
+#include "ultibo/devicetree.h"
+
+/* Implementation of the device tree index for Ultibo API
+ *
+ * The device tree functions work directly on the flattened blob, so every
+ * lookup by path walks the structure block from the start and every property
+ * lookup walks the node. An index is built with two passes over the blob, the
+ * first validates it and counts the nodes, properties, phandles and compatible
+ * strings and the second fills arrays and hash tables sized from those counts
+ * in a single allocation. The blob itself is never copied.
+ *
+ * Node paths are hashed with FNV-1a, which can be continued from the hash of
+ * the parent so no path strings are stored. A hit is confirmed by comparing
+ * the path with the node names from the leaf back up to the root. Property
+ * names are interned once so a property is found by hashing the node and the
+ * name number, and each compatible string owns a list of its nodes in tree
+ * order which is filled with a counting sort at the end of the second pass.
+ *
+ * Handles are the offset of the node or property token from the start of the
+ * structure block, the same values used by the device tree functions, so the
+ * results can be passed straight to device_tree_get_property_value and the
+ * others when indexing the boot device tree.
+ */
+
+/* Empty hash table slot or missing array index */
+#define DT_INDEX_NONE	0xFFFFFFFF
+
+/* FNV-1a parameters */
+#define DT_INDEX_FNV_BASIS	0x811C9DC5
+#define DT_INDEX_FNV_PRIME	0x01000193
+
+/* Smallest hash table size (Slots) */
+#define DT_INDEX_MIN_TABLE	8
+
+/* Default index states */
+#define DT_INDEX_STATE_STOPPED	0
+#define DT_INDEX_STATE_STARTING	1
+#define DT_INDEX_STATE_STARTED	2
+
+/* Convert a structure block offset to a handle */
+#define DT_INDEX_HANDLE(offset)	((HANDLE)(offset))
+
+/* Index Node */
+typedef struct _DT_INDEX_NODE DT_INDEX_NODE;
+struct _DT_INDEX_NODE
+{
+	uint32_t offset; // Offset of the begin node token in the structure block
+	uint32_t parent; // Index of the parent node (DT_INDEX_NONE for the root)
+	uint32_t hash; // Hash of the full path
+};
+
+/* Index Property */
+typedef struct _DT_INDEX_PROPERTY DT_INDEX_PROPERTY;
+struct _DT_INDEX_PROPERTY
+{
+	uint32_t offset; // Offset of the property token in the structure block
+	uint32_t node; // Index of the node containing the property
+	uint32_t name; // Index of the interned property name
+};
+
+/* Index Name */
+typedef struct _DT_INDEX_NAME DT_INDEX_NAME;
+struct _DT_INDEX_NAME
+{
+	uint32_t offset; // Offset of the name in the strings block
+	uint32_t hash; // Hash of the name
+};
+
+/* Index Compatible */
+typedef struct _DT_INDEX_COMPATIBLE DT_INDEX_COMPATIBLE;
+struct _DT_INDEX_COMPATIBLE
+{
+	uint32_t offset; // Offset of the first occurrence of the string in the structure block
+	uint32_t hash; // Hash of the string
+	uint32_t first; // First entry in the compatible node list
+	uint32_t count; // Number of entries in the compatible node list
+};
+
+/* Index Phandle */
+typedef struct _DT_INDEX_PHANDLE DT_INDEX_PHANDLE;
+struct _DT_INDEX_PHANDLE
+{
+	uint32_t phandle; // Phandle value
+	uint32_t node; // Index of the node
+};
+
+/* Device Tree Index */
+struct _DEVICE_TREE_INDEX
+{
+	uint32_t signature; // Signature for entry validation
+	uint32_t size; // Size of the allocation (Bytes)
+	const uint8_t *structure; // Structure block of the blob
+	uint32_t structuresize;
+	const char *strings; // Strings block of the blob
+	uint32_t stringssize;
+	uint32_t aliases; // Index of the /aliases node (DT_INDEX_NONE if not present)
+	/* Counts */
+	uint32_t nodecount;
+	uint32_t propertycount;
+	uint32_t namecount;
+	uint32_t compatiblecount;
+	uint32_t occurrencecount; // Total compatible strings in all nodes
+	uint32_t phandlecount;
+	/* Arrays */
+	DT_INDEX_NODE *nodes;
+	DT_INDEX_PROPERTY *properties;
+	DT_INDEX_NAME *names;
+	DT_INDEX_COMPATIBLE *compatibles;
+	DT_INDEX_PHANDLE *phandles;
+	uint32_t *compatiblenodes; // Node indexes for each compatible string in tree order
+	/* Hash tables (Open addressing with linear probing, sizes are a power of 2) */
+	uint32_t *pathtable; // Nodes by path hash
+	uint32_t pathmask;
+	uint32_t *offsettable; // Nodes by offset
+	uint32_t offsetmask;
+	uint32_t *propertytable; // Properties by node and name
+	uint32_t propertymask;
+	uint32_t *nametable; // Names by hash
+	uint32_t namemask;
+	uint32_t *compatibletable; // Compatible strings by hash
+	uint32_t compatiblemask;
+	uint32_t *phandletable; // Phandles by value
+	uint32_t phandlemask;
+};
+
+/* Build state passed between the two passes */
+typedef struct _DT_INDEX_BUILD DT_INDEX_BUILD;
+struct _DT_INDEX_BUILD
+{
+	BOOL fill; // FALSE to count only, TRUE to fill the arrays and tables
+	uint32_t *occurrenceids; // Compatible index of each occurrence (Fill pass only)
+	uint32_t *occurrencenodes; // Node index of each occurrence (Fill pass only)
+};
+
+/* Default index of the boot device tree */
+static DEVICE_TREE_INDEX *dt_index_default;
+static volatile uint32_t dt_index_state = DT_INDEX_STATE_STOPPED;
+
+/* ============================================================================== */
+/* Internal functions */
+static inline uint32_t dt_index_load32(const void *address)
+{
+	const uint8_t *bytes = address;
+
+	return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+static inline uint32_t dt_index_align(uint32_t offset)
+{
+	return (offset + (DTB_STRUCTURE_ALIGNMENT - 1)) & ~(DTB_STRUCTURE_ALIGNMENT - 1);
+}
+
+static inline uint32_t dt_index_hash(uint32_t hash, const char *data, uint32_t len)
+{
+	while (len-- > 0)
+	{
+		hash ^= (uint8_t)*data++;
+		hash *= DT_INDEX_FNV_PRIME;
+	}
+
+	return hash;
+}
+
+static inline uint32_t dt_index_mix(uint32_t value)
+{
+	value ^= value >> 16;
+	value *= 0x7FEB352D;
+	value ^= value >> 15;
+	value *= 0x846CA68B;
+	value ^= value >> 16;
+
+	return value;
+}
+
+static inline uint32_t dt_index_property_key(uint32_t node, uint32_t name)
+{
+	return dt_index_mix((node * 0x9E3779B1) ^ name);
+}
+
+/* Return the mask of a table with at least twice count slots */
+static uint32_t dt_index_table_mask(uint32_t count)
+{
+	uint32_t slots = DT_INDEX_MIN_TABLE;
+
+	while (slots < count * 2)
+		slots <<= 1;
+
+	return slots - 1;
+}
+
+static DEVICE_TREE_INDEX *dt_index_check(DEVICE_TREE_INDEX *index)
+{
+	if (!index)
+		return device_tree_index_get_default();
+
+	if (index->signature != DEVICE_TREE_INDEX_SIGNATURE)
+		return NULL;
+
+	return index;
+}
+
+static inline const char *dt_index_node_name(const DEVICE_TREE_INDEX *index, uint32_t node)
+{
+	return (const char *)index->structure + index->nodes[node].offset + DTB_NODE_OFFSET;
+}
+
+/* Find the node at an offset in the structure block */
+static uint32_t dt_index_node_from_handle(const DEVICE_TREE_INDEX *index, HANDLE handle)
+{
+	uint32_t offset;
+	uint32_t slot;
+	uint32_t node;
+
+	if (handle == INVALID_HANDLE_VALUE || handle >= index->structuresize)
+		return DT_INDEX_NONE;
+
+	offset = (uint32_t)handle;
+
+	slot = dt_index_mix(offset) & index->offsetmask;
+	while ((node = index->offsettable[slot]) != DT_INDEX_NONE)
+	{
+		if (index->nodes[node].offset == offset)
+			return node;
+
+		slot = (slot + 1) & index->offsetmask;
+	}
+
+	return DT_INDEX_NONE;
+}
+
+/* Find the property at an offset in the structure block, properties are in tree order so a binary search is used */
+static uint32_t dt_index_property_from_handle(const DEVICE_TREE_INDEX *index, HANDLE handle)
+{
+	uint32_t offset;
+	uint32_t low;
+	uint32_t high;
+	uint32_t middle;
+
+	if (handle == INVALID_HANDLE_VALUE || handle >= index->structuresize)
+		return DT_INDEX_NONE;
+
+	offset = (uint32_t)handle;
+
+	low = 0;
+	high = index->propertycount;
+	while (low < high)
+	{
+		middle = low + ((high - low) / 2);
+		if (index->properties[middle].offset < offset)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	if (low < index->propertycount && index->properties[low].offset == offset)
+		return low;
+
+	return DT_INDEX_NONE;
+}
+
+/* Find a property name, or add it if insert is TRUE */
+static uint32_t dt_index_name_lookup(DEVICE_TREE_INDEX *index, const char *name, uint32_t nameoffset, BOOL insert)
+{
+	uint32_t hash;
+	uint32_t slot;
+	uint32_t entry;
+
+	hash = dt_index_hash(DT_INDEX_FNV_BASIS, name, strlen(name));
+
+	slot = hash & index->namemask;
+	while ((entry = index->nametable[slot]) != DT_INDEX_NONE)
+	{
+		if (index->names[entry].hash == hash && strcmp(index->strings + index->names[entry].offset, name) == 0)
+			return entry;
+
+		slot = (slot + 1) & index->namemask;
+	}
+
+	if (!insert)
+		return DT_INDEX_NONE;
+
+	entry = index->namecount++;
+	index->names[entry].offset = nameoffset;
+	index->names[entry].hash = hash;
+	index->nametable[slot] = entry;
+
+	return entry;
+}
+
+/* Find a compatible string, or add it if insert is TRUE (Offset is the position of the string in the structure block) */
+static uint32_t dt_index_compatible_lookup(DEVICE_TREE_INDEX *index, const char *compatible, uint32_t len, uint32_t offset, BOOL insert)
+{
+	uint32_t hash;
+	uint32_t slot;
+	uint32_t entry;
+	const char *string;
+
+	hash = dt_index_hash(DT_INDEX_FNV_BASIS, compatible, len);
+
+	slot = hash & index->compatiblemask;
+	while ((entry = index->compatibletable[slot]) != DT_INDEX_NONE)
+	{
+		string = (const char *)index->structure + index->compatibles[entry].offset;
+		if (index->compatibles[entry].hash == hash && strncmp(string, compatible, len) == 0 && string[len] == '\0')
+			return entry;
+
+		slot = (slot + 1) & index->compatiblemask;
+	}
+
+	if (!insert)
+		return DT_INDEX_NONE;
+
+	entry = index->compatiblecount++;
+	index->compatibles[entry].offset = offset;
+	index->compatibles[entry].hash = hash;
+	index->compatibles[entry].first = 0;
+	index->compatibles[entry].count = 0;
+	index->compatibletable[slot] = entry;
+
+	return entry;
+}
+
+static uint32_t dt_index_property_lookup(const DEVICE_TREE_INDEX *index, uint32_t node, uint32_t name)
+{
+	uint32_t slot;
+	uint32_t entry;
+
+	slot = dt_index_property_key(node, name) & index->propertymask;
+	while ((entry = index->propertytable[slot]) != DT_INDEX_NONE)
+	{
+		if (index->properties[entry].node == node && index->properties[entry].name == name)
+			return entry;
+
+		slot = (slot + 1) & index->propertymask;
+	}
+
+	return DT_INDEX_NONE;
+}
+
+/* Check that path (Without a trailing separator) is the full path of node */
+static BOOL dt_index_match_path(const DEVICE_TREE_INDEX *index, uint32_t node, const char *path, uint32_t len)
+{
+	const char *name;
+	uint32_t namelen;
+
+	while (index->nodes[node].parent != DT_INDEX_NONE)
+	{
+		name = dt_index_node_name(index, node);
+		namelen = strlen(name);
+
+		if (len < namelen + 1 || path[len - namelen - 1] != '/' || memcmp(path + len - namelen, name, namelen) != 0)
+			return FALSE;
+
+		len -= namelen + 1;
+		node = index->nodes[node].parent;
+	}
+
+	return (len == 0);
+}
+
+static void dt_index_add_node(DEVICE_TREE_INDEX *index, uint32_t offset, uint32_t parent, const char *name, uint32_t namelen)
+{
+	uint32_t node = index->nodecount;
+	uint32_t hash;
+	uint32_t slot;
+
+	/* The root is the empty path, each child continues the hash of its parent */
+	hash = DT_INDEX_FNV_BASIS;
+	if (parent != DT_INDEX_NONE)
+		hash = dt_index_hash(dt_index_hash(index->nodes[parent].hash, "/", 1), name, namelen);
+
+	index->nodes[node].offset = offset;
+	index->nodes[node].parent = parent;
+	index->nodes[node].hash = hash;
+
+	slot = hash & index->pathmask;
+	while (index->pathtable[slot] != DT_INDEX_NONE)
+		slot = (slot + 1) & index->pathmask;
+	index->pathtable[slot] = node;
+
+	slot = dt_index_mix(offset) & index->offsetmask;
+	while (index->offsettable[slot] != DT_INDEX_NONE)
+		slot = (slot + 1) & index->offsetmask;
+	index->offsettable[slot] = node;
+
+	if (parent == 0 && namelen == strlen(DTB_NODE_ALIASES) && memcmp(name, DTB_NODE_ALIASES, namelen) == 0)
+		index->aliases = node;
+}
+
+static void dt_index_add_property(DEVICE_TREE_INDEX *index, DT_INDEX_BUILD *build, uint32_t offset, uint32_t node, uint32_t nameoffset, const uint8_t *value, uint32_t length)
+{
+	const char *name = index->strings + nameoffset;
+	uint32_t property = index->propertycount;
+	uint32_t phandle;
+	uint32_t entry;
+	uint32_t slot;
+	uint32_t start;
+	uint32_t end;
+
+	index->properties[property].offset = offset;
+	index->properties[property].node = node;
+	index->properties[property].name = dt_index_name_lookup(index, name, nameoffset, TRUE);
+
+	slot = dt_index_property_key(node, index->properties[property].name) & index->propertymask;
+	while (index->propertytable[slot] != DT_INDEX_NONE)
+		slot = (slot + 1) & index->propertymask;
+	index->propertytable[slot] = property;
+
+	if (length == 4 && (strcmp(name, DTB_PROPERTY_PHANDLE) == 0 || strcmp(name, "linux,phandle") == 0))
+	{
+		/* A node with both phandle and linux,phandle is only added once */
+		phandle = dt_index_load32(value);
+
+		slot = dt_index_mix(phandle) & index->phandlemask;
+		while ((entry = index->phandletable[slot]) != DT_INDEX_NONE)
+		{
+			if (index->phandles[entry].phandle == phandle)
+				return;
+
+			slot = (slot + 1) & index->phandlemask;
+		}
+
+		entry = index->phandlecount++;
+		index->phandles[entry].phandle = phandle;
+		index->phandles[entry].node = node;
+		index->phandletable[slot] = entry;
+	}
+	else if (strcmp(name, DTB_PROPERTY_COMPATIBLE) == 0)
+	{
+		/* Only strings terminated within the value are counted */
+		start = 0;
+		for (end = 0; end < length; end++)
+		{
+			if (value[end] != '\0')
+				continue;
+
+			if (end > start)
+			{
+				entry = dt_index_compatible_lookup(index, (const char *)value + start, end - start, offset + DTB_PROPERTY_OFFSET + start, TRUE);
+				index->compatibles[entry].count++;
+
+				build->occurrenceids[index->occurrencecount] = entry;
+				build->occurrencenodes[index->occurrencecount] = node;
+				index->occurrencecount++;
+			}
+			start = end + 1;
+		}
+	}
+}
+
+/* Walk the structure block, counting only or filling the index depending on build */
+static BOOL dt_index_walk(DEVICE_TREE_INDEX *index, DT_INDEX_BUILD *build)
+{
+	const uint8_t *structure = index->structure;
+	uint32_t size = index->structuresize;
+	uint32_t stack[DEVICE_TREE_INDEX_MAX_DEPTH];
+	uint32_t depth = 0;
+	uint32_t offset = 0;
+	uint32_t token;
+	uint32_t namelen;
+	uint32_t length;
+	uint32_t nameoffset;
+	uint32_t start;
+	uint32_t end;
+	const char *name;
+	const uint8_t *value;
+
+	index->nodecount = 0;
+	index->propertycount = 0;
+	index->namecount = 0;
+	index->compatiblecount = 0;
+	index->occurrencecount = 0;
+	index->phandlecount = 0;
+
+	while (offset <= size - 4)
+	{
+		token = dt_index_load32(structure + offset);
+		switch (token)
+		{
+			case DTB_BEGIN_NODE:
+				/* Only one root, the name must be terminated within the block */
+				if (depth >= DEVICE_TREE_INDEX_MAX_DEPTH || (depth == 0 && index->nodecount > 0))
+					return FALSE;
+
+				name = (const char *)structure + offset + DTB_NODE_OFFSET;
+				if (offset + DTB_NODE_OFFSET >= size)
+					return FALSE;
+				namelen = strnlen(name, size - offset - DTB_NODE_OFFSET);
+				if (namelen == size - offset - DTB_NODE_OFFSET)
+					return FALSE;
+
+				if (build->fill)
+					dt_index_add_node(index, offset, (depth > 0) ? stack[depth - 1] : DT_INDEX_NONE, name, namelen);
+
+				stack[depth++] = index->nodecount++;
+				offset = dt_index_align(offset + DTB_NODE_OFFSET + namelen + 1);
+				break;
+			case DTB_END_NODE:
+				if (depth == 0)
+					return FALSE;
+
+				depth--;
+				offset += 4;
+				break;
+			case DTB_PROP:
+				if (depth == 0 || size - offset < DTB_PROPERTY_OFFSET)
+					return FALSE;
+
+				length = dt_index_load32(structure + offset + 4);
+				nameoffset = dt_index_load32(structure + offset + 8);
+				if (length > size - offset - DTB_PROPERTY_OFFSET || nameoffset >= index->stringssize)
+					return FALSE;
+				if (!memchr(index->strings + nameoffset, '\0', index->stringssize - nameoffset))
+					return FALSE;
+
+				value = structure + offset + DTB_PROPERTY_OFFSET;
+				if (build->fill)
+				{
+					dt_index_add_property(index, build, offset, stack[depth - 1], nameoffset, value, length);
+				}
+				else
+				{
+					name = index->strings + nameoffset;
+					if (length == 4 && (strcmp(name, DTB_PROPERTY_PHANDLE) == 0 || strcmp(name, "linux,phandle") == 0))
+					{
+						index->phandlecount++;
+					}
+					else if (strcmp(name, DTB_PROPERTY_COMPATIBLE) == 0)
+					{
+						start = 0;
+						for (end = 0; end < length; end++)
+						{
+							if (value[end] != '\0')
+								continue;
+
+							if (end > start)
+								index->occurrencecount++;
+							start = end + 1;
+						}
+					}
+				}
+
+				index->propertycount++;
+				offset = dt_index_align(offset + DTB_PROPERTY_OFFSET + length);
+				break;
+			case DTB_NOP:
+				offset += 4;
+				break;
+			case DTB_END:
+				return (depth == 0 && index->nodecount > 0);
+			default:
+				return FALSE;
+		}
+
+		/* Offsets near the 4GB limit cannot occur in a valid blob */
+		if (offset > size)
+			return FALSE;
+	}
+
+	return FALSE;
+}
+
+/* ============================================================================== */
+/* Device Tree Index Functions */
+DEVICE_TREE_INDEX * STDCALL device_tree_index_create(const void *blob, uint32_t size)
+{
+	const uint8_t *bytes = blob;
+	DEVICE_TREE_INDEX counts;
+	DEVICE_TREE_INDEX *index;
+	DT_INDEX_BUILD build;
+	uint32_t totalsize;
+	uint32_t version;
+	uint32_t structureoffset;
+	uint32_t structuresize;
+	uint32_t stringsoffset;
+	uint32_t stringssize;
+	uint32_t namebound;
+	uint32_t allocsize;
+	uint32_t offset;
+	uint32_t count;
+	uint32_t entry;
+	uint32_t *slots;
+
+	if (!blob || size < sizeof(DTB_HEADER))
+		return NULL;
+
+	/* Check the header */
+	if (dt_index_load32(bytes) != DTB_MAGIC)
+		return NULL;
+
+	totalsize = dt_index_load32(bytes + 4);
+	structureoffset = dt_index_load32(bytes + 8);
+	stringsoffset = dt_index_load32(bytes + 12);
+	version = dt_index_load32(bytes + 20);
+	stringssize = dt_index_load32(bytes + 32);
+
+	if (totalsize > size || totalsize < sizeof(DTB_HEADER) || version < DTB_VERSION_COMPATIBLE)
+		return NULL;
+	if (structureoffset >= totalsize || stringsoffset > totalsize || stringssize > totalsize - stringsoffset)
+		return NULL;
+
+	/* Version 16 has no structure size */
+	structuresize = totalsize - structureoffset;
+	if (version >= DTB_VERSION_CURRENT)
+	{
+		structuresize = dt_index_load32(bytes + 36);
+		if (structuresize > totalsize - structureoffset)
+			return NULL;
+	}
+	if (structuresize < 4)
+		return NULL;
+
+	/* Count everything */
+	memset(&counts, 0, sizeof(DEVICE_TREE_INDEX));
+	counts.structure = bytes + structureoffset;
+	counts.structuresize = structuresize;
+	counts.strings = (const char *)bytes + stringsoffset;
+	counts.stringssize = stringssize;
+
+	build.fill = FALSE;
+	build.occurrenceids = NULL;
+	build.occurrencenodes = NULL;
+
+	if (!dt_index_walk(&counts, &build))
+		return NULL;
+
+	/* Every distinct name starts at a distinct offset in the strings block (Names may share a tail) */
+	namebound = stringssize;
+	if (namebound > counts.propertycount)
+		namebound = counts.propertycount;
+
+	counts.pathmask = dt_index_table_mask(counts.nodecount);
+	counts.offsetmask = counts.pathmask;
+	counts.propertymask = dt_index_table_mask(counts.propertycount);
+	counts.namemask = dt_index_table_mask(namebound);
+	counts.compatiblemask = dt_index_table_mask(counts.occurrencecount);
+	counts.phandlemask = dt_index_table_mask(counts.phandlecount);
+
+	/* Allocate the index, arrays and tables together (Every member is 32 bit so no padding is needed) */
+	allocsize = sizeof(DEVICE_TREE_INDEX);
+	allocsize += counts.nodecount * sizeof(DT_INDEX_NODE);
+	allocsize += counts.propertycount * sizeof(DT_INDEX_PROPERTY);
+	allocsize += namebound * sizeof(DT_INDEX_NAME);
+	allocsize += counts.occurrencecount * (sizeof(DT_INDEX_COMPATIBLE) + sizeof(uint32_t));
+	allocsize += counts.phandlecount * sizeof(DT_INDEX_PHANDLE);
+	allocsize += (counts.pathmask + 1 + counts.offsetmask + 1 + counts.propertymask + 1 + counts.namemask + 1 + counts.compatiblemask + 1 + counts.phandlemask + 1) * sizeof(uint32_t);
+
+	index = malloc(allocsize);
+	if (!index)
+		return NULL;
+
+	*index = counts;
+	index->size = allocsize;
+	index->aliases = DT_INDEX_NONE;
+
+	index->nodes = (DT_INDEX_NODE *)(index + 1);
+	index->properties = (DT_INDEX_PROPERTY *)(index->nodes + counts.nodecount);
+	index->names = (DT_INDEX_NAME *)(index->properties + counts.propertycount);
+	index->compatibles = (DT_INDEX_COMPATIBLE *)(index->names + namebound);
+	index->phandles = (DT_INDEX_PHANDLE *)(index->compatibles + counts.occurrencecount);
+	index->compatiblenodes = (uint32_t *)(index->phandles + counts.phandlecount);
+
+	slots = index->compatiblenodes + counts.occurrencecount;
+	index->pathtable = slots;
+	slots += index->pathmask + 1;
+	index->offsettable = slots;
+	slots += index->offsetmask + 1;
+	index->propertytable = slots;
+	slots += index->propertymask + 1;
+	index->nametable = slots;
+	slots += index->namemask + 1;
+	index->compatibletable = slots;
+	slots += index->compatiblemask + 1;
+	index->phandletable = slots;
+	slots += index->phandlemask + 1;
+
+	memset(index->pathtable, 0xFF, (uint8_t *)slots - (uint8_t *)index->pathtable);
+
+	/* Compatible occurrences are collected during the walk and sorted by string afterwards */
+	build.fill = TRUE;
+	if (counts.occurrencecount > 0)
+	{
+		build.occurrenceids = malloc(counts.occurrencecount * sizeof(uint32_t) * 2);
+		if (!build.occurrenceids)
+		{
+			free(index);
+			return NULL;
+		}
+		build.occurrencenodes = build.occurrenceids + counts.occurrencecount;
+	}
+
+	if (!dt_index_walk(index, &build))
+	{
+		free(build.occurrenceids);
+		free(index);
+		return NULL;
+	}
+
+	count = 0;
+	for (entry = 0; entry < index->compatiblecount; entry++)
+	{
+		index->compatibles[entry].first = count;
+		count += index->compatibles[entry].count;
+		index->compatibles[entry].count = 0;
+	}
+
+	for (offset = 0; offset < index->occurrencecount; offset++)
+	{
+		entry = build.occurrenceids[offset];
+		index->compatiblenodes[index->compatibles[entry].first + index->compatibles[entry].count++] = build.occurrencenodes[offset];
+	}
+
+	free(build.occurrenceids);
+
+	index->signature = DEVICE_TREE_INDEX_SIGNATURE;
+
+	return index;
+}
+
+uint32_t STDCALL device_tree_index_destroy(DEVICE_TREE_INDEX *index)
+{
+	if (!index || index->signature != DEVICE_TREE_INDEX_SIGNATURE)
+		return ERROR_INVALID_PARAMETER;
+
+	/* The default index is shared by every caller */
+	if (index == dt_index_default)
+		return ERROR_ACCESS_DENIED;
+
+	index->signature = 0;
+	free(index);
+
+	return ERROR_SUCCESS;
+}
+
+DEVICE_TREE_INDEX * STDCALL device_tree_index_get_default(void)
+{
+	if (dt_index_state == DT_INDEX_STATE_STARTED)
+		return dt_index_default;
+
+	if (!__sync_bool_compare_and_swap(&dt_index_state, DT_INDEX_STATE_STOPPED, DT_INDEX_STATE_STARTING))
+	{
+		while (dt_index_state != DT_INDEX_STATE_STARTED)
+			thread_yield();
+		return dt_index_default;
+	}
+
+	/* A failed build is not retried, the boot device tree cannot change */
+	if (device_tree_valid())
+		dt_index_default = device_tree_index_create((const void *)device_tree_get_base(), device_tree_get_size());
+
+	__sync_synchronize();
+	dt_index_state = DT_INDEX_STATE_STARTED;
+
+	return dt_index_default;
+}
+
+uint32_t STDCALL device_tree_index_get_info(DEVICE_TREE_INDEX *index, DEVICE_TREE_INDEX_INFO *info)
+{
+	if (!info)
+		return ERROR_INVALID_PARAMETER;
+
+	index = dt_index_check(index);
+	if (!index)
+		return ERROR_NOT_FOUND;
+
+	info->nodecount = index->nodecount;
+	info->propertycount = index->propertycount;
+	info->namecount = index->namecount;
+	info->compatiblecount = index->compatiblecount;
+	info->phandlecount = index->phandlecount;
+	info->size = index->size;
+
+	return ERROR_SUCCESS;
+}
+
+HANDLE STDCALL device_tree_index_find_node(DEVICE_TREE_INDEX *index, const char *path)
+{
+	char buffer[DEVICE_TREE_INDEX_MAX_PATH];
+	const char *separator;
+	const char *value;
+	uint32_t aliaslen;
+	uint32_t valuelen;
+	uint32_t property;
+	uint32_t name;
+	uint32_t length;
+	uint32_t len;
+	uint32_t hash;
+	uint32_t slot;
+	uint32_t node;
+
+	if (!path)
+		return INVALID_HANDLE_VALUE;
+
+	index = dt_index_check(index);
+	if (!index)
+		return INVALID_HANDLE_VALUE;
+
+	/* Expand an alias to the path it refers to */
+	if (path[0] != '/')
+	{
+		if (index->aliases == DT_INDEX_NONE)
+			return INVALID_HANDLE_VALUE;
+
+		separator = strchr(path, '/');
+		aliaslen = separator ? (uint32_t)(separator - path) : strlen(path);
+		if (aliaslen == 0 || aliaslen >= DEVICE_TREE_INDEX_MAX_PATH)
+			return INVALID_HANDLE_VALUE;
+
+		memcpy(buffer, path, aliaslen);
+		buffer[aliaslen] = '\0';
+
+		name = dt_index_name_lookup(index, buffer, 0, FALSE);
+		if (name == DT_INDEX_NONE)
+			return INVALID_HANDLE_VALUE;
+
+		property = dt_index_property_lookup(index, index->aliases, name);
+		if (property == DT_INDEX_NONE)
+			return INVALID_HANDLE_VALUE;
+
+		value = (const char *)index->structure + index->properties[property].offset + DTB_PROPERTY_OFFSET;
+		length = dt_index_load32(index->structure + index->properties[property].offset + 4);
+		valuelen = strnlen(value, length);
+		if (valuelen == length || value[0] != '/')
+			return INVALID_HANDLE_VALUE;
+
+		len = separator ? strlen(separator) : 0;
+		if (valuelen + len >= DEVICE_TREE_INDEX_MAX_PATH)
+			return INVALID_HANDLE_VALUE;
+
+		memcpy(buffer, value, valuelen);
+		if (separator)
+			memcpy(buffer + valuelen, separator, len);
+		buffer[valuelen + len] = '\0';
+
+		path = buffer;
+	}
+
+	/* The root is the empty path */
+	len = strlen(path);
+	while (len > 0 && path[len - 1] == '/')
+		len--;
+
+	hash = dt_index_hash(DT_INDEX_FNV_BASIS, path, len);
+
+	slot = hash & index->pathmask;
+	while ((node = index->pathtable[slot]) != DT_INDEX_NONE)
+	{
+		if (index->nodes[node].hash == hash && dt_index_match_path(index, node, path, len))
+			return DT_INDEX_HANDLE(index->nodes[node].offset);
+
+		slot = (slot + 1) & index->pathmask;
+	}
+
+	return INVALID_HANDLE_VALUE;
+}
+
+HANDLE STDCALL device_tree_index_find_phandle(DEVICE_TREE_INDEX *index, uint32_t phandle)
+{
+	uint32_t slot;
+	uint32_t entry;
+
+	index = dt_index_check(index);
+	if (!index)
+		return INVALID_HANDLE_VALUE;
+
+	slot = dt_index_mix(phandle) & index->phandlemask;
+	while ((entry = index->phandletable[slot]) != DT_INDEX_NONE)
+	{
+		if (index->phandles[entry].phandle == phandle)
+			return DT_INDEX_HANDLE(index->nodes[index->phandles[entry].node].offset);
+
+		slot = (slot + 1) & index->phandlemask;
+	}
+
+	return INVALID_HANDLE_VALUE;
+}
+
+HANDLE STDCALL device_tree_index_find_compatible(DEVICE_TREE_INDEX *index, const char *compatible, uint32_t instance)
+{
+	uint32_t entry;
+
+	if (!compatible)
+		return INVALID_HANDLE_VALUE;
+
+	index = dt_index_check(index);
+	if (!index)
+		return INVALID_HANDLE_VALUE;
+
+	entry = dt_index_compatible_lookup(index, compatible, strlen(compatible), 0, FALSE);
+	if (entry == DT_INDEX_NONE || instance >= index->compatibles[entry].count)
+		return INVALID_HANDLE_VALUE;
+
+	return DT_INDEX_HANDLE(index->nodes[index->compatiblenodes[index->compatibles[entry].first + instance]].offset);
+}
+
+uint32_t STDCALL device_tree_index_count_compatible(DEVICE_TREE_INDEX *index, const char *compatible)
+{
+	uint32_t entry;
+
+	if (!compatible)
+		return 0;
+
+	index = dt_index_check(index);
+	if (!index)
+		return 0;
+
+	entry = dt_index_compatible_lookup(index, compatible, strlen(compatible), 0, FALSE);
+	if (entry == DT_INDEX_NONE)
+		return 0;
+
+	return index->compatibles[entry].count;
+}
+
+HANDLE STDCALL device_tree_index_find_property(DEVICE_TREE_INDEX *index, HANDLE node, const char *name)
+{
+	uint32_t entry;
+	uint32_t nameid;
+	uint32_t property;
+
+	if (!name)
+		return INVALID_HANDLE_VALUE;
+
+	index = dt_index_check(index);
+	if (!index)
+		return INVALID_HANDLE_VALUE;
+
+	entry = dt_index_node_from_handle(index, node);
+	if (entry == DT_INDEX_NONE)
+		return INVALID_HANDLE_VALUE;
+
+	nameid = dt_index_name_lookup(index, name, 0, FALSE);
+	if (nameid == DT_INDEX_NONE)
+		return INVALID_HANDLE_VALUE;
+
+	property = dt_index_property_lookup(index, entry, nameid);
+	if (property == DT_INDEX_NONE)
+		return INVALID_HANDLE_VALUE;
+
+	return DT_INDEX_HANDLE(index->properties[property].offset);
+}
+
+HANDLE STDCALL device_tree_index_next_node(DEVICE_TREE_INDEX *index, HANDLE previous)
+{
+	uint32_t node;
+
+	index = dt_index_check(index);
+	if (!index)
+		return INVALID_HANDLE_VALUE;
+
+	if (previous == INVALID_HANDLE_VALUE)
+		return DT_INDEX_HANDLE(index->nodes[0].offset);
+
+	node = dt_index_node_from_handle(index, previous);
+	if (node == DT_INDEX_NONE || node + 1 >= index->nodecount)
+		return INVALID_HANDLE_VALUE;
+
+	return DT_INDEX_HANDLE(index->nodes[node + 1].offset);
+}
+
+HANDLE STDCALL device_tree_index_get_parent(DEVICE_TREE_INDEX *index, HANDLE node)
+{
+	uint32_t entry;
+
+	index = dt_index_check(index);
+	if (!index)
+		return INVALID_HANDLE_VALUE;
+
+	entry = dt_index_node_from_handle(index, node);
+	if (entry == DT_INDEX_NONE || index->nodes[entry].parent == DT_INDEX_NONE)
+		return INVALID_HANDLE_VALUE;
+
+	return DT_INDEX_HANDLE(index->nodes[index->nodes[entry].parent].offset);
+}
+
+const char * STDCALL device_tree_index_get_node_name(DEVICE_TREE_INDEX *index, HANDLE node)
+{
+	uint32_t entry;
+
+	index = dt_index_check(index);
+	if (!index)
+		return NULL;
+
+	entry = dt_index_node_from_handle(index, node);
+	if (entry == DT_INDEX_NONE)
+		return NULL;
+
+	return dt_index_node_name(index, entry);
+}
+
+uint32_t STDCALL device_tree_index_get_node_path(DEVICE_TREE_INDEX *index, HANDLE node, char *path, uint32_t len)
+{
+	uint32_t stack[DEVICE_TREE_INDEX_MAX_DEPTH];
+	uint32_t depth;
+	uint32_t entry;
+	uint32_t size;
+	uint32_t namelen;
+	const char *name;
+
+	if (!path || len < 2)
+		return 0;
+
+	index = dt_index_check(index);
+	if (!index)
+		return 0;
+
+	entry = dt_index_node_from_handle(index, node);
+	if (entry == DT_INDEX_NONE)
+		return 0;
+
+	/* Collect the nodes from the leaf up, the root is not included */
+	depth = 0;
+	while (index->nodes[entry].parent != DT_INDEX_NONE)
+	{
+		stack[depth++] = entry;
+		entry = index->nodes[entry].parent;
+	}
+
+	if (depth == 0)
+	{
+		strcpy(path, DTB_NODE_ROOT);
+		return 1;
+	}
+
+	size = 0;
+	while (depth > 0)
+	{
+		name = dt_index_node_name(index, stack[--depth]);
+		namelen = strlen(name);
+		if (size + namelen + 1 >= len)
+			return 0;
+
+		path[size++] = '/';
+		memcpy(path + size, name, namelen);
+		size += namelen;
+	}
+	path[size] = '\0';
+
+	return size;
+}
+
+const char * STDCALL device_tree_index_get_property_name(DEVICE_TREE_INDEX *index, HANDLE property)
+{
+	uint32_t entry;
+
+	index = dt_index_check(index);
+	if (!index)
+		return NULL;
+
+	entry = dt_index_property_from_handle(index, property);
+	if (entry == DT_INDEX_NONE)
+		return NULL;
+
+	return index->strings + index->names[index->properties[entry].name].offset;
+}
+
+void * STDCALL device_tree_index_get_property_value(DEVICE_TREE_INDEX *index, HANDLE property, uint32_t *length)
+{
+	uint32_t entry;
+	uint32_t offset;
+
+	index = dt_index_check(index);
+	if (!index)
+		return NULL;
+
+	entry = dt_index_property_from_handle(index, property);
+	if (entry == DT_INDEX_NONE)
+		return NULL;
+
+	offset = index->properties[entry].offset;
+	if (length)
+		*length = dt_index_load32(index->structure + offset + 4);
+
+	return (void *)(index->structure + offset + DTB_PROPERTY_OFFSET);
+}
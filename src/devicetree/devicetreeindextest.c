@@ -0,0 +1,967 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Host test, benchmark and fuzz harness for the device tree index (devicetree/devicetreeindex.c)
+ *
+ * This file is not part of the Ultibo run time, it includes devicetreeindex.c with stub
+ * versions of the few Ultibo functions it needs and runs on the development host.
+ *
+ * Each blob is checked against a reference parse of the structure block: every node
+ * by path, alias and tree order, every parent, every property by name, every phandle
+ * and every compatible list. Path, phandle and property lookups and the index build
+ * are then timed against linear walks of the blob like those made by the device tree
+ * functions. Finally the blob is corrupted at random many times and each result is
+ * either rejected by device_tree_index_create or indexed and queried, built with
+ * AddressSanitizer any read outside the blob or the index is reported.
+ *
+ * Device tree files are passed on the command line, with no files a Pi sized blob
+ * (About 700 nodes with aliases, phandles and compatible lists) is generated. The
+ * Raspberry Pi device tree files are in the boot folder of the firmware repository:
+ *
+ *  https://github.com/raspberrypi/firmware/tree/master/boot
+ *
+ *  eg curl -LO https://raw.githubusercontent.com/raspberrypi/firmware/master/boot/bcm2711-rpi-4-b.dtb
+ *
+ * or from the boot partition of any Raspberry Pi OS image. Build and run from the root
+ * of the repository with:
+ *
+ *  gcc -std=gnu11 -g -O2 -fsanitize=address,undefined -iquote include -o devicetreeindextest src/devicetree/devicetreeindextest.c
+ *  ./devicetreeindextest [-f iterations] [bcm2711-rpi-4-b.dtb ...]
+ *
+ * Build without -fsanitize for representative benchmark times.
+ */
+
+/* The Ultibo timer_create conflicts with the POSIX declaration in the host headers */
+#define timer_create host_timer_create
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#undef timer_create
+
+/* Newlib definitions used by the Ultibo headers */
+#define _ATTRIBUTE(x) __attribute__(x)
+#define __VALIST __gnuc_va_list
+
+#include "devicetreeindex.c"
+
+/* ============================================================================== */
+/* Host stubs */
+uint32_t STDCALL thread_yield(void)
+{
+	return ERROR_SUCCESS;
+}
+
+/* There is no boot device tree on the host, device_tree_index_get_default returns NULL */
+BOOL STDCALL device_tree_valid(void)
+{
+	return FALSE;
+}
+
+size_t STDCALL device_tree_get_base(void)
+{
+	return 0;
+}
+
+uint32_t STDCALL device_tree_get_size(void)
+{
+	return 0;
+}
+
+/* ============================================================================== */
+/* Host test */
+#define HOST_MAX_NODES	8192
+#define HOST_MAX_PROPERTIES	64 // Per node
+#define HOST_MAX_DEPTH	32
+#define HOST_DEFAULT_FUZZ	3000
+
+#define HOST_TOKEN_BEGIN_NODE	1
+#define HOST_TOKEN_END_NODE	2
+#define HOST_TOKEN_PROP	3
+#define HOST_TOKEN_NOP	4
+#define HOST_TOKEN_END	9
+
+/* Reference node from a direct parse of the structure block */
+typedef struct _HOST_NODE HOST_NODE;
+struct _HOST_NODE
+{
+	char path[DEVICE_TREE_INDEX_MAX_PATH];
+	uint32_t offset;
+	int32_t parent;
+	BOOL hasphandle;
+	uint32_t phandle;
+	const char *compatible;
+	uint32_t compatiblelen;
+	uint32_t propertycount;
+	uint32_t properties[HOST_MAX_PROPERTIES];
+};
+
+static HOST_NODE *hostnodes;
+static uint32_t hostnodecount;
+static const uint8_t *hoststructure;
+static const char *hoststrings;
+
+static uint32_t failures;
+static uint32_t checks;
+
+#define HOST_CHECK(condition, ...) do { checks++; if (!(condition)) { if (failures++ < 20) { printf("FAIL: "); printf(__VA_ARGS__); printf("\n"); } } } while (0)
+
+static uint32_t host_random(void)
+{
+	static uint64_t state = 88172645463325252ULL;
+
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+
+	return (uint32_t)state;
+}
+
+static double host_seconds(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec + (now.tv_nsec * 1e-9);
+}
+
+static uint32_t host_load32(const uint8_t *value)
+{
+	return ((uint32_t)value[0] << 24) | ((uint32_t)value[1] << 16) | ((uint32_t)value[2] << 8) | value[3];
+}
+
+static void host_store32(uint8_t *value, uint32_t data)
+{
+	value[0] = data >> 24;
+	value[1] = data >> 16;
+	value[2] = data >> 8;
+	value[3] = data;
+}
+
+/* Offset of the token after the one at offset */
+static uint32_t host_skip(uint32_t offset)
+{
+	switch (host_load32(hoststructure + offset))
+	{
+		case HOST_TOKEN_BEGIN_NODE:
+			return (offset + 4 + strlen((const char *)hoststructure + offset + 4) + 1 + 3) & ~3;
+		case HOST_TOKEN_PROP:
+			return (offset + 12 + host_load32(hoststructure + offset + 4) + 3) & ~3;
+	}
+
+	return offset + 4;
+}
+
+static const char *host_property_name(uint32_t offset)
+{
+	return hoststrings + host_load32(hoststructure + offset + 8);
+}
+
+/* Join a node name to the path of its parent, returns FALSE if too long */
+static BOOL host_join(char *path, const char *parent, const char *name)
+{
+	uint32_t parentlen = (strcmp(parent, "/") == 0) ? 0 : strlen(parent);
+	uint32_t namelen = strlen(name);
+
+	if (parentlen + 1 + namelen >= DEVICE_TREE_INDEX_MAX_PATH)
+		return FALSE;
+
+	memcpy(path, parent, parentlen);
+	path[parentlen] = '/';
+	memcpy(path + parentlen + 1, name, namelen + 1);
+
+	return TRUE;
+}
+
+/* Parse a blob that device_tree_index_create accepted into the reference node list */
+static BOOL host_parse(const uint8_t *blob)
+{
+	int32_t stack[HOST_MAX_DEPTH];
+	uint32_t depth = 0;
+	uint32_t offset = 0;
+	uint32_t length;
+	const char *name;
+	HOST_NODE *node;
+
+	hoststructure = blob + host_load32(blob + 8);
+	hoststrings = (const char *)blob + host_load32(blob + 12);
+	hostnodecount = 0;
+
+	while (TRUE)
+	{
+		switch (host_load32(hoststructure + offset))
+		{
+			case HOST_TOKEN_BEGIN_NODE:
+				if (hostnodecount == HOST_MAX_NODES || depth == HOST_MAX_DEPTH)
+					return FALSE;
+
+				name = (const char *)hoststructure + offset + 4;
+				node = &hostnodes[hostnodecount];
+				memset(node, 0, sizeof(HOST_NODE));
+				node->offset = offset;
+				node->parent = depth ? stack[depth - 1] : -1;
+				if (depth == 0)
+					strcpy(node->path, "/");
+				else if (!host_join(node->path, hostnodes[stack[depth - 1]].path, name))
+					return FALSE;
+
+				stack[depth++] = hostnodecount++;
+				break;
+			case HOST_TOKEN_END_NODE:
+				if (depth == 0)
+					return FALSE;
+				depth--;
+				break;
+			case HOST_TOKEN_PROP:
+				if (depth == 0)
+					return FALSE;
+
+				node = &hostnodes[stack[depth - 1]];
+				if (node->propertycount == HOST_MAX_PROPERTIES)
+					return FALSE;
+				node->properties[node->propertycount++] = offset;
+
+				length = host_load32(hoststructure + offset + 4);
+				name = host_property_name(offset);
+				if (length == 4 && !node->hasphandle && (strcmp(name, "phandle") == 0 || strcmp(name, "linux,phandle") == 0))
+				{
+					node->hasphandle = TRUE;
+					node->phandle = host_load32(hoststructure + offset + 12);
+				}
+				if (strcmp(name, "compatible") == 0)
+				{
+					node->compatible = (const char *)hoststructure + offset + 12;
+					node->compatiblelen = length;
+				}
+				break;
+			case HOST_TOKEN_NOP:
+				break;
+			default:
+				return (depth == 0);
+		}
+
+		offset = host_skip(offset);
+	}
+}
+
+/* Linear path lookup, each component is searched for among the children of the last match */
+static uint32_t host_linear_find_node(const char *path)
+{
+	const char *component;
+	const char *name;
+	uint32_t componentlen;
+	uint32_t offset = 0;
+	uint32_t depth = 0;
+	uint32_t target = 0;
+	uint32_t token;
+
+	component = path;
+	while (*component == '/')
+		component++;
+	if (*component == '\0')
+		return 0;
+
+	componentlen = strcspn(component, "/");
+
+	while (TRUE)
+	{
+		token = host_load32(hoststructure + offset);
+		if (token == HOST_TOKEN_BEGIN_NODE)
+		{
+			if (depth == target + 1)
+			{
+				name = (const char *)hoststructure + offset + 4;
+				if (strncmp(name, component, componentlen) == 0 && name[componentlen] == '\0')
+				{
+					component += componentlen;
+					while (*component == '/')
+						component++;
+					if (*component == '\0')
+						return offset;
+
+					componentlen = strcspn(component, "/");
+					target++;
+				}
+			}
+			depth++;
+		}
+		else if (token == HOST_TOKEN_END_NODE)
+		{
+			/* Left the subtree of the last match without finding the next component */
+			if (depth-- == target + 1 && depth == target)
+				return DT_INDEX_NONE;
+		}
+		else if (token != HOST_TOKEN_PROP && token != HOST_TOKEN_NOP)
+		{
+			return DT_INDEX_NONE;
+		}
+
+		offset = host_skip(offset);
+	}
+}
+
+/* Linear phandle lookup over every property of the tree */
+static uint32_t host_linear_find_phandle(uint32_t phandle)
+{
+	uint32_t offset = 0;
+	uint32_t node = 0;
+	uint32_t token;
+	const char *name;
+
+	while ((token = host_load32(hoststructure + offset)) != HOST_TOKEN_END)
+	{
+		if (token == HOST_TOKEN_BEGIN_NODE)
+		{
+			node = offset;
+		}
+		else if (token == HOST_TOKEN_PROP && host_load32(hoststructure + offset + 4) == 4)
+		{
+			name = host_property_name(offset);
+			if ((strcmp(name, "phandle") == 0 || strcmp(name, "linux,phandle") == 0) && host_load32(hoststructure + offset + 12) == phandle)
+				return node;
+		}
+
+		offset = host_skip(offset);
+	}
+
+	return DT_INDEX_NONE;
+}
+
+/* Linear property lookup within a node */
+static uint32_t host_linear_find_property(uint32_t node, const char *name)
+{
+	uint32_t offset = host_skip(node);
+	uint32_t token;
+
+	while ((token = host_load32(hoststructure + offset)) == HOST_TOKEN_PROP || token == HOST_TOKEN_NOP)
+	{
+		if (token == HOST_TOKEN_PROP && strcmp(host_property_name(offset), name) == 0)
+			return offset;
+
+		offset = host_skip(offset);
+	}
+
+	return DT_INDEX_NONE;
+}
+
+static void host_check_nodes(DEVICE_TREE_INDEX *index)
+{
+	char buffer[DEVICE_TREE_INDEX_MAX_PATH + 2];
+	const char *name;
+	HOST_NODE *node;
+	HANDLE handle;
+	uint32_t length;
+	uint32_t first;
+	uint32_t count;
+	uint32_t other;
+	uint32_t property;
+
+	handle = INVALID_HANDLE_VALUE;
+	for (count = 0; count < hostnodecount; count++)
+	{
+		node = &hostnodes[count];
+
+		HOST_CHECK(device_tree_index_find_node(index, node->path) == node->offset, "find node %s", node->path);
+		HOST_CHECK(host_linear_find_node(node->path) == node->offset, "linear find node %s", node->path);
+
+		handle = device_tree_index_next_node(index, handle);
+		HOST_CHECK(handle == node->offset, "next node %u", (unsigned int)count);
+
+		HOST_CHECK(device_tree_index_get_node_path(index, node->offset, buffer, sizeof(buffer)) == strlen(node->path) && strcmp(buffer, node->path) == 0, "node path %s (%s)", node->path, buffer);
+		HOST_CHECK(device_tree_index_get_parent(index, node->offset) == ((node->parent < 0) ? INVALID_HANDLE_VALUE : hostnodes[node->parent].offset), "parent of %s", node->path);
+
+		if (count > 0)
+		{
+			snprintf(buffer, sizeof(buffer), "%s/", node->path);
+			HOST_CHECK(device_tree_index_find_node(index, buffer) == node->offset, "trailing separator %s", buffer);
+
+			snprintf(buffer, sizeof(buffer), "%sx", node->path);
+			HOST_CHECK(device_tree_index_find_node(index, buffer) == INVALID_HANDLE_VALUE, "missing node %s", buffer);
+		}
+
+		/* The first property with a name is found when a node has duplicates */
+		for (property = 0; property < node->propertycount; property++)
+		{
+			name = host_property_name(node->properties[property]);
+			first = property;
+			for (other = 0; other < property; other++)
+			{
+				if (strcmp(host_property_name(node->properties[other]), name) == 0)
+				{
+					first = other;
+					break;
+				}
+			}
+
+			HOST_CHECK(device_tree_index_find_property(index, node->offset, name) == node->properties[first], "property %s of %s", name, node->path);
+			HOST_CHECK(strcmp(device_tree_index_get_property_name(index, node->properties[property]), name) == 0, "property name %s", name);
+			HOST_CHECK(device_tree_index_get_property_value(index, node->properties[property], &length) == hoststructure + node->properties[property] + 12 && length == host_load32(hoststructure + node->properties[property] + 4), "property value %s", name);
+		}
+		HOST_CHECK(device_tree_index_find_property(index, node->offset, "no-such-property") == INVALID_HANDLE_VALUE, "missing property of %s", node->path);
+
+		/* The first node with a phandle is found when phandles are duplicated */
+		if (node->hasphandle)
+		{
+			first = count;
+			for (other = 0; other < count; other++)
+			{
+				if (hostnodes[other].hasphandle && hostnodes[other].phandle == node->phandle)
+				{
+					first = other;
+					break;
+				}
+			}
+
+			HOST_CHECK(device_tree_index_find_phandle(index, node->phandle) == hostnodes[first].offset, "phandle %u", (unsigned int)node->phandle);
+		}
+	}
+
+	HOST_CHECK(device_tree_index_next_node(index, handle) == INVALID_HANDLE_VALUE, "next node after the last");
+	HOST_CHECK(device_tree_index_find_phandle(index, 0xDEADBEEF) == INVALID_HANDLE_VALUE, "missing phandle");
+	if (hostnodecount > 1)
+		HOST_CHECK(device_tree_index_find_property(index, hostnodes[1].offset + 4, "reg") == INVALID_HANDLE_VALUE, "property of an invalid node handle");
+}
+
+static void host_check_compatible(DEVICE_TREE_INDEX *index)
+{
+	static HANDLE expected[HOST_MAX_NODES];
+	const char *compatible;
+	const char *other;
+	uint32_t position;
+	uint32_t count;
+	uint32_t node;
+	uint32_t match;
+	uint32_t index2;
+
+	for (node = 0; node < hostnodecount; node++)
+	{
+		for (position = 0; position < hostnodes[node].compatiblelen; position += strlen(compatible) + 1)
+		{
+			compatible = hostnodes[node].compatible + position;
+			if (*compatible == '\0')
+				continue;
+
+			/* Every node listing the string in tree order */
+			count = 0;
+			for (match = 0; match < hostnodecount; match++)
+			{
+				for (index2 = 0; index2 < hostnodes[match].compatiblelen; index2 += strlen(other) + 1)
+				{
+					other = hostnodes[match].compatible + index2;
+					if (*other && strcmp(compatible, other) == 0)
+						expected[count++] = hostnodes[match].offset;
+				}
+			}
+
+			HOST_CHECK(device_tree_index_count_compatible(index, compatible) == count, "count compatible %s", compatible);
+			for (match = 0; match < count; match++)
+				HOST_CHECK(device_tree_index_find_compatible(index, compatible, match) == expected[match], "compatible %s instance %u", compatible, (unsigned int)match);
+			HOST_CHECK(device_tree_index_find_compatible(index, compatible, count) == INVALID_HANDLE_VALUE, "compatible %s past the end", compatible);
+		}
+	}
+
+	HOST_CHECK(device_tree_index_count_compatible(index, "vendor,no-such-device") == 0, "missing compatible");
+}
+
+static void host_check_aliases(DEVICE_TREE_INDEX *index)
+{
+	char buffer[DEVICE_TREE_INDEX_MAX_PATH * 2];
+	const char *target;
+	const char *alias;
+	HOST_NODE *aliases = NULL;
+	uint32_t property;
+	uint32_t length;
+	uint32_t targetlen;
+	uint32_t node;
+
+	for (node = 0; node < hostnodecount; node++)
+	{
+		if (hostnodes[node].parent == 0 && strcmp(hostnodes[node].path, "/aliases") == 0)
+		{
+			aliases = &hostnodes[node];
+			break;
+		}
+	}
+
+	HOST_CHECK(device_tree_index_find_node(index, "no-such-alias") == INVALID_HANDLE_VALUE, "missing alias");
+	if (!aliases)
+		return;
+
+	for (property = 0; property < aliases->propertycount; property++)
+	{
+		alias = host_property_name(aliases->properties[property]);
+		target = (const char *)hoststructure + aliases->properties[property] + 12;
+		length = host_load32(hoststructure + aliases->properties[property] + 4);
+		if (length == 0 || target[0] != '/' || strnlen(target, length) == length || device_tree_index_find_property(index, aliases->offset, alias) != aliases->properties[property])
+			continue;
+
+		HOST_CHECK(device_tree_index_find_node(index, alias) == host_linear_find_node(target), "alias %s", alias);
+
+		/* A path below the alias target */
+		targetlen = strlen(target);
+		for (node = 0; node < hostnodecount; node++)
+		{
+			if (strncmp(hostnodes[node].path, target, targetlen) == 0 && hostnodes[node].path[targetlen] == '/')
+			{
+				snprintf(buffer, sizeof(buffer), "%s%s", alias, hostnodes[node].path + targetlen);
+				if (strlen(buffer) < DEVICE_TREE_INDEX_MAX_PATH)
+					HOST_CHECK(device_tree_index_find_node(index, buffer) == hostnodes[node].offset, "alias path %s", buffer);
+				break;
+			}
+		}
+	}
+}
+
+static void host_benchmark(const uint8_t *blob, uint32_t size, DEVICE_TREE_INDEX *index)
+{
+	DEVICE_TREE_INDEX *build;
+	volatile uint32_t sink = 0;
+	uint32_t repeat;
+	uint32_t node;
+	uint32_t phandles = 0;
+	double start;
+	double linear;
+	double indexed;
+
+	start = host_seconds();
+	for (repeat = 0; repeat < 50; repeat++)
+	{
+		build = device_tree_index_create(blob, size);
+		device_tree_index_destroy(build);
+	}
+	printf("  build %.1f us\n", ((host_seconds() - start) / 50) * 1e6);
+
+	start = host_seconds();
+	for (repeat = 0; repeat < 5; repeat++)
+		for (node = 0; node < hostnodecount; node++)
+			sink += host_linear_find_node(hostnodes[node].path);
+	linear = (host_seconds() - start) / (5 * hostnodecount);
+
+	start = host_seconds();
+	for (repeat = 0; repeat < 200; repeat++)
+		for (node = 0; node < hostnodecount; node++)
+			sink += (uint32_t)device_tree_index_find_node(index, hostnodes[node].path);
+	indexed = (host_seconds() - start) / (200 * hostnodecount);
+	printf("  path lookup     linear %8.1f ns  index %6.1f ns\n", linear * 1e9, indexed * 1e9);
+
+	for (node = 0; node < hostnodecount; node++)
+		if (hostnodes[node].hasphandle)
+			phandles++;
+	if (phandles)
+	{
+		start = host_seconds();
+		for (repeat = 0; repeat < 5; repeat++)
+			for (node = 0; node < hostnodecount; node++)
+				if (hostnodes[node].hasphandle)
+					sink += host_linear_find_phandle(hostnodes[node].phandle);
+		linear = (host_seconds() - start) / (5 * phandles);
+
+		start = host_seconds();
+		for (repeat = 0; repeat < 200; repeat++)
+			for (node = 0; node < hostnodecount; node++)
+				if (hostnodes[node].hasphandle)
+					sink += (uint32_t)device_tree_index_find_phandle(index, hostnodes[node].phandle);
+		indexed = (host_seconds() - start) / (200 * phandles);
+		printf("  phandle lookup  linear %8.1f ns  index %6.1f ns\n", linear * 1e9, indexed * 1e9);
+	}
+
+	start = host_seconds();
+	for (repeat = 0; repeat < 200; repeat++)
+		for (node = 0; node < hostnodecount; node++)
+			sink += host_linear_find_property(hostnodes[node].offset, "status");
+	linear = (host_seconds() - start) / (200 * hostnodecount);
+
+	start = host_seconds();
+	for (repeat = 0; repeat < 200; repeat++)
+		for (node = 0; node < hostnodecount; node++)
+			sink += (uint32_t)device_tree_index_find_property(index, hostnodes[node].offset, "status");
+	indexed = (host_seconds() - start) / (200 * hostnodecount);
+	printf("  property lookup linear %8.1f ns  index %6.1f ns\n", linear * 1e9, indexed * 1e9);
+}
+
+/* Corrupt copies of the blob and query whatever is indexed (Memory errors are reported by AddressSanitizer) */
+static void host_fuzz(const uint8_t *blob, uint32_t size, uint32_t iterations)
+{
+	DEVICE_TREE_INDEX *index;
+	char buffer[DEVICE_TREE_INDEX_MAX_PATH];
+	uint8_t *copy;
+	uint32_t structoffset;
+	uint32_t structsize;
+	uint32_t iteration;
+	uint32_t offset;
+	uint32_t count;
+	uint32_t created = 0;
+	HANDLE node;
+	HANDLE property;
+
+	copy = malloc(size);
+	if (!copy)
+		return;
+
+	structoffset = host_load32(blob + 8);
+	structsize = host_load32(blob + 36);
+
+	for (iteration = 0; iteration < iterations; iteration++)
+	{
+		memcpy(copy, blob, size);
+
+		/* Random bytes anywhere, or a random token or length in the structure block */
+		for (count = 1 + host_random() % 8; count > 0; count--)
+			copy[host_random() % size] = host_random();
+		if (structsize >= 4 && (host_random() % 4) == 0)
+		{
+			offset = structoffset + ((host_random() % structsize) & ~3);
+			if (offset + 4 <= size)
+				host_store32(copy + offset, (host_random() % 2) ? host_random() % 10 : host_random());
+		}
+
+		index = device_tree_index_create(copy, size);
+		if (!index)
+			continue;
+		created++;
+
+		node = INVALID_HANDLE_VALUE;
+		while ((node = device_tree_index_next_node(index, node)) != INVALID_HANDLE_VALUE)
+		{
+			if (device_tree_index_get_node_path(index, node, buffer, sizeof(buffer)))
+				device_tree_index_find_node(index, buffer);
+			device_tree_index_get_node_name(index, node);
+			device_tree_index_get_parent(index, node);
+
+			property = device_tree_index_find_property(index, node, "compatible");
+			if (property != INVALID_HANDLE_VALUE)
+			{
+				device_tree_index_get_property_value(index, property, &count);
+				device_tree_index_get_property_name(index, property);
+			}
+			device_tree_index_find_property(index, node, "reg");
+		}
+
+		for (count = 0; count < 32; count++)
+		{
+			snprintf(buffer, sizeof(buffer), "serial%u/x", (unsigned int)count);
+			device_tree_index_find_node(index, buffer);
+			snprintf(buffer, sizeof(buffer), "alias%u", (unsigned int)count);
+			device_tree_index_find_node(index, buffer);
+			device_tree_index_find_phandle(index, count);
+			device_tree_index_find_compatible(index, "brcm,bcm2835-gpio", count);
+		}
+
+		device_tree_index_destroy(index);
+	}
+
+	printf("  fuzz %u corrupted blobs, %u indexed and queried\n", (unsigned int)iterations, (unsigned int)created);
+
+	free(copy);
+}
+
+/* ============================================================================== */
+/* Generated blob */
+typedef struct _HOST_BLOB HOST_BLOB;
+struct _HOST_BLOB
+{
+	uint8_t *structure;
+	uint32_t structsize;
+	char *strings;
+	uint32_t stringsize;
+	uint32_t phandle;
+	uint32_t nodecount;
+	char paths[64][DEVICE_TREE_INDEX_MAX_PATH]; // Alias targets
+	uint32_t pathcount;
+};
+
+static void host_blob_token(HOST_BLOB *blob, uint32_t token)
+{
+	host_store32(blob->structure + blob->structsize, token);
+	blob->structsize += 4;
+}
+
+static void host_blob_bytes(HOST_BLOB *blob, const void *data, uint32_t len)
+{
+	memcpy(blob->structure + blob->structsize, data, len);
+	blob->structsize += len;
+	while (blob->structsize & 3)
+		blob->structure[blob->structsize++] = 0;
+}
+
+static uint32_t host_blob_string(HOST_BLOB *blob, const char *name)
+{
+	uint32_t offset = 0;
+
+	while (offset < blob->stringsize)
+	{
+		if (strcmp(blob->strings + offset, name) == 0)
+			return offset;
+		offset += strlen(blob->strings + offset) + 1;
+	}
+
+	strcpy(blob->strings + blob->stringsize, name);
+	blob->stringsize += strlen(name) + 1;
+
+	return offset;
+}
+
+static void host_blob_property(HOST_BLOB *blob, const char *name, const void *value, uint32_t len)
+{
+	host_blob_token(blob, HOST_TOKEN_PROP);
+	host_blob_token(blob, len);
+	host_blob_token(blob, host_blob_string(blob, name));
+	host_blob_bytes(blob, value, len);
+}
+
+static void host_blob_node(HOST_BLOB *blob, const char *name, const char *path, uint32_t depth)
+{
+	static const char *compatibles[] = {"brcm,bcm2835-gpio", "brcm,bcm2711-gpio", "arm,pl011", "arm,primecell", "brcm,bcm2835-i2c", "brcm,bcm2835-spi",
+		"brcm,bcm2835-sdhci", "simple-bus", "brcm,bcm2835-dma", "fixed-clock", "brcm,bcm2711-pcie", "snps,dwc2", "brcm,bcm2835-pwm"};
+	static const char *properties[] = {"reg", "status", "interrupts", "clocks", "#address-cells", "#size-cells", "pinctrl-0", "dma-names", "clock-frequency"};
+	static const char *names[] = {"serial", "i2c", "spi", "gpio", "mmc", "dma", "clk", "pwm", "fan", "led"};
+	static const uint32_t children[] = {48, 8, 4, 2};
+	char child[DEVICE_TREE_INDEX_MAX_PATH];
+	char childpath[DEVICE_TREE_INDEX_MAX_PATH];
+	uint8_t value[64];
+	uint32_t count;
+	uint32_t len;
+	uint32_t item;
+
+	host_blob_token(blob, HOST_TOKEN_BEGIN_NODE);
+	host_blob_bytes(blob, name, strlen(name) + 1);
+	blob->nodecount++;
+
+	if (depth >= 2 && blob->pathcount < 64 && (host_random() % 8) == 0)
+		snprintf(blob->paths[blob->pathcount++], DEVICE_TREE_INDEX_MAX_PATH, "%s", path);
+
+	if ((host_random() % 20) == 0)
+		host_blob_token(blob, HOST_TOKEN_NOP);
+
+	if ((host_random() % 10) < 7)
+	{
+		len = 0;
+		for (count = 1 + host_random() % 3; count > 0; count--)
+		{
+			item = host_random() % (sizeof(compatibles) / sizeof(compatibles[0]));
+			strcpy((char *)value + len, compatibles[item]);
+			len += strlen(compatibles[item]) + 1;
+		}
+		host_blob_property(blob, "compatible", value, len);
+	}
+
+	for (count = host_random() % 7; count > 0; count--)
+	{
+		len = (host_random() % 5) * 4;
+		for (item = 0; item < len; item++)
+			value[item] = host_random();
+		host_blob_property(blob, properties[host_random() % (sizeof(properties) / sizeof(properties[0]))], value, len);
+	}
+
+	if ((host_random() % 2) == 0)
+	{
+		host_store32(value, blob->phandle);
+		host_blob_property(blob, "phandle", value, 4);
+		if ((host_random() % 10) < 3)
+			host_blob_property(blob, "linux,phandle", value, 4);
+		blob->phandle += ((host_random() % 4) == 0) ? 1000 : 1;
+	}
+
+	if (depth < 4)
+	{
+		for (count = host_random() % (children[depth] + 1); count > 0; count--)
+		{
+			/* The node count keeps the names of siblings unique */
+			snprintf(child, sizeof(child), "%s@%x", names[host_random() % (sizeof(names) / sizeof(names[0]))], (unsigned int)blob->nodecount);
+			if (!host_join(childpath, path, child))
+				continue;
+			host_blob_node(blob, child, childpath, depth + 1);
+		}
+	}
+
+	if (depth == 0)
+	{
+		host_blob_token(blob, HOST_TOKEN_BEGIN_NODE);
+		host_blob_bytes(blob, "aliases", 8);
+		for (count = 0; count < blob->pathcount; count++)
+		{
+			snprintf(child, sizeof(child), "alias%u", (unsigned int)count);
+			host_blob_property(blob, child, blob->paths[count], strlen(blob->paths[count]) + 1);
+		}
+		host_blob_token(blob, HOST_TOKEN_END_NODE);
+	}
+
+	host_blob_token(blob, HOST_TOKEN_END_NODE);
+}
+
+static uint8_t *host_generate(uint32_t *size)
+{
+	HOST_BLOB blob;
+	uint8_t *result;
+	uint32_t offset;
+
+	memset(&blob, 0, sizeof(blob));
+	blob.structure = malloc(SIZE_1M);
+	blob.strings = malloc(SIZE_64K);
+	if (!blob.structure || !blob.strings)
+		return NULL;
+
+	blob.phandle = 1;
+	host_blob_node(&blob, "", "/", 0);
+	host_blob_token(&blob, HOST_TOKEN_END);
+
+	/* Header, empty reservation map, structure block then strings block */
+	offset = 40 + 16 + blob.structsize;
+	*size = offset + blob.stringsize;
+	result = calloc(1, *size);
+	if (result)
+	{
+		host_store32(result + 0, DTB_MAGIC);
+		host_store32(result + 4, *size);
+		host_store32(result + 8, 56);
+		host_store32(result + 12, offset);
+		host_store32(result + 16, 40);
+		host_store32(result + 20, 17);
+		host_store32(result + 24, 16);
+		host_store32(result + 32, blob.stringsize);
+		host_store32(result + 36, blob.structsize);
+		memcpy(result + 56, blob.structure, blob.structsize);
+		memcpy(result + offset, blob.strings, blob.stringsize);
+	}
+
+	free(blob.structure);
+	free(blob.strings);
+
+	return result;
+}
+
+static uint8_t *host_load(const char *filename, uint32_t *size)
+{
+	uint8_t *result;
+	FILE *file;
+	long len;
+
+	file = fopen(filename, "rb");
+	if (!file)
+		return NULL;
+
+	fseek(file, 0, SEEK_END);
+	len = ftell(file);
+	rewind(file);
+
+	result = (len > 0) ? malloc(len) : NULL;
+	if (result && fread(result, 1, len, file) != (size_t)len)
+	{
+		free(result);
+		result = NULL;
+	}
+	fclose(file);
+
+	*size = (uint32_t)len;
+
+	return result;
+}
+
+static void host_run(const char *name, const uint8_t *blob, uint32_t size, uint32_t iterations)
+{
+	DEVICE_TREE_INDEX_INFO info;
+	DEVICE_TREE_INDEX *index;
+
+	printf("%s (%u bytes)\n", name, (unsigned int)size);
+
+	index = device_tree_index_create(blob, size);
+	HOST_CHECK(index != NULL, "%s: not indexed", name);
+	if (!index)
+		return;
+
+	HOST_CHECK(host_parse(blob), "%s: reference parse failed", name);
+
+	memset(&info, 0, sizeof(info));
+	HOST_CHECK(device_tree_index_get_info(index, &info) == ERROR_SUCCESS, "%s: get info", name);
+	printf("  %u nodes, %u properties, %u names, %u compatible, %u phandles, index %u bytes\n", (unsigned int)info.nodecount, (unsigned int)info.propertycount,
+		(unsigned int)info.namecount, (unsigned int)info.compatiblecount, (unsigned int)info.phandlecount, (unsigned int)info.size);
+	HOST_CHECK(info.nodecount == hostnodecount, "%s: node count %u expected %u", name, (unsigned int)info.nodecount, (unsigned int)hostnodecount);
+
+	host_check_nodes(index);
+	host_check_compatible(index);
+	host_check_aliases(index);
+	host_benchmark(blob, size, index);
+
+	device_tree_index_destroy(index);
+
+	host_fuzz(blob, size, iterations);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t iterations = HOST_DEFAULT_FUZZ;
+	uint32_t size;
+	uint8_t *blob;
+	int files = 0;
+	int arg;
+
+	setvbuf(stdout, NULL, _IONBF, 0);
+
+	hostnodes = calloc(HOST_MAX_NODES, sizeof(HOST_NODE));
+	if (!hostnodes)
+		return 1;
+
+	HOST_CHECK(device_tree_index_get_default() == NULL, "default index without a boot device tree");
+	HOST_CHECK(device_tree_index_create(NULL, 0) == NULL, "create from NULL");
+
+	for (arg = 1; arg < argc; arg++)
+	{
+		if (strcmp(argv[arg], "-f") == 0 && arg + 1 < argc)
+		{
+			iterations = strtoul(argv[++arg], NULL, 0);
+			continue;
+		}
+
+		files++;
+		blob = host_load(argv[arg], &size);
+		HOST_CHECK(blob != NULL, "%s: could not be read", argv[arg]);
+		if (!blob)
+			continue;
+
+		host_run(argv[arg], blob, size, iterations);
+		free(blob);
+	}
+
+	if (files == 0)
+	{
+		blob = host_generate(&size);
+		if (blob)
+		{
+			host_run("generated", blob, size, iterations);
+			free(blob);
+		}
+	}
+
+	printf("checks %u failures %u\n", (unsigned int)checks, (unsigned int)failures);
+
+	free(hostnodes);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,429 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/framebuffer.h"
+#include "ultibo/dma.h"
+#include "ultibo/framebufferdma.h"
+
+/* Implementation of DMA accelerated framebuffer copy for Ultibo API
+ *
+ * Attaching to a framebuffer device installs a device copy rect method so that
+ * framebuffer_device_copy_rect, and the console scroll and graphics window copy
+ * and move image functions that use it, move large regions with a single DMA
+ * request using 2D stride instead of a CPU copy through the framebuffer copy
+ * buffer. A console with a glyph cache attached (See ultibo/glyphcache.h) also
+ * scrolls through framebuffer_device_copy_rect once DMA is attached.
+ *
+ * When the destination is below the source the rows are transferred from the
+ * bottom up using a negative stride so overlapping regions are copied correctly,
+ * a copy that overlaps within the same rows is always done by the CPU.
+ *
+ * Regions smaller than the threshold are copied by the CPU since the setup cost
+ * of a DMA request is greater than the copy itself.
+ */
+
+/* Framebuffer DMA */
+typedef struct _FRAMEBUFFER_DMA FRAMEBUFFER_DMA;
+struct _FRAMEBUFFER_DMA
+{
+	FRAMEBUFFER_DEVICE *framebuffer; // The framebuffer device (NULL if the slot is free)
+	DMA_HOST *dma; // The DMA host for transfers
+	DMA_PROPERTIES properties; // DMA host properties
+	DMA_DATA *data; // DMA data blocks for the current copy
+	uint32_t datacount; // Number of DMA data blocks allocated
+	framebuffer_device_copy_rect_proc copyrect; // Original copy rect method (May be NULL)
+	FRAMEBUFFER_DMA_STATISTICS statistics;
+};
+
+static FRAMEBUFFER_DMA framebuffer_dmas[FRAMEBUFFER_DMA_MAX_DEVICES];
+static MUTEX_HANDLE framebuffer_dmas_lock = INVALID_HANDLE_VALUE;
+
+/* ============================================================================== */
+/* Framebuffer DMA Internal Functions */
+static FRAMEBUFFER_DMA *framebuffer_dma_find(FRAMEBUFFER_DEVICE *framebuffer)
+{
+	uint32_t index;
+
+	for (index = 0; index < FRAMEBUFFER_DMA_MAX_DEVICES; index++)
+	{
+		if (framebuffer_dmas[index].framebuffer == framebuffer)
+			return &framebuffer_dmas[index];
+	}
+
+	return NULL;
+}
+
+static void framebuffer_dma_copy_cpu(FRAMEBUFFER_DEVICE *framebuffer, uint8_t *source, uint8_t *dest, uint32_t rowbytes, uint32_t height, BOOL descending)
+{
+	uint32_t row;
+
+	/* Copy rows in the order that never overwrites a row not yet copied */
+	if (descending)
+	{
+		for (row = height; row > 0; row--)
+			memmove(dest + ((row - 1) * framebuffer->pitch), source + ((row - 1) * framebuffer->pitch), rowbytes);
+	}
+	else
+	{
+		for (row = 0; row < height; row++)
+			memmove(dest + (row * framebuffer->pitch), source + (row * framebuffer->pitch), rowbytes);
+	}
+
+	if (framebuffer->device.deviceflags & FRAMEBUFFER_FLAG_CACHED)
+		clean_data_cache_range((size_t)dest, height * framebuffer->pitch);
+}
+
+static uint32_t framebuffer_dma_copy_dma(FRAMEBUFFER_DMA *entry, uint8_t *source, uint8_t *dest, uint32_t rowbytes, uint32_t height, BOOL descending)
+{
+	FRAMEBUFFER_DEVICE *framebuffer = entry->framebuffer;
+	DMA_DATA *data;
+	uint32_t rowsperblock;
+	uint32_t blockcount;
+	uint32_t block;
+	uint32_t first;
+	uint32_t rows;
+	uint32_t status;
+	int32_t stride;
+	size_t start;
+	size_t end;
+
+	/* Use 2D stride if the host supports the row length and stride, otherwise one block per row */
+	stride = descending ? -(int32_t)(framebuffer->pitch + rowbytes) : (int32_t)(framebuffer->pitch - rowbytes);
+	rowsperblock = 1;
+	if (entry->statistics.stridesupport && rowbytes <= entry->properties.maxlength && entry->properties.maxcount > 0)
+	{
+		if ((descending && stride >= entry->properties.minstride) || (!descending && (uint32_t)stride <= entry->properties.maxstride))
+			rowsperblock = (height < entry->properties.maxcount) ? height : entry->properties.maxcount;
+	}
+
+	blockcount = (height + rowsperblock - 1) / rowsperblock;
+	if (blockcount > entry->datacount)
+	{
+		free(entry->data);
+
+		entry->data = malloc(blockcount * sizeof(DMA_DATA));
+		if (!entry->data)
+		{
+			entry->datacount = 0;
+			return ERROR_NOT_ENOUGH_MEMORY;
+		}
+		entry->datacount = blockcount;
+	}
+
+	/* Build the blocks in transfer order */
+	for (block = 0; block < blockcount; block++)
+	{
+		data = &entry->data[block];
+		memset(data, 0, sizeof(DMA_DATA));
+
+		rows = height - (block * rowsperblock);
+		if (rows > rowsperblock)
+			rows = rowsperblock;
+
+		/* For descending blocks the first row transferred is the lowest row of the block */
+		first = descending ? height - 1 - (block * rowsperblock) : block * rowsperblock;
+
+		data->source = source + (first * framebuffer->pitch);
+		data->dest = dest + (first * framebuffer->pitch);
+		data->size = rowbytes * rows;
+		data->flags = DMA_DATA_FLAG_NOCLEAN | DMA_DATA_FLAG_NOINVALIDATE;
+		if (rows > 1)
+		{
+			data->flags |= DMA_DATA_FLAG_STRIDE;
+			data->stridelength = rowbytes;
+			data->sourcestride = stride;
+			data->deststride = stride;
+		}
+		data->next = (block + 1 < blockcount) ? &entry->data[block + 1] : NULL;
+	}
+
+	/* Write back and discard the cached rows covering both regions before the transfer */
+	if (framebuffer->device.deviceflags & FRAMEBUFFER_FLAG_CACHED)
+	{
+		start = (source < dest) ? (size_t)source : (size_t)dest;
+		end = ((source > dest) ? (size_t)source : (size_t)dest) + (height * framebuffer->pitch);
+		clean_and_invalidate_data_cache_range(start, end - start);
+	}
+
+	status = dma_transfer_request(entry->dma, entry->data, DMA_DIR_MEM_TO_MEM, DMA_DREQ_ID_NONE, DMA_REQUEST_FLAG_COMPATIBLE, FRAMEBUFFER_DMA_TIMEOUT);
+
+	/* Discard any lines fetched into the cache during the transfer */
+	if (framebuffer->device.deviceflags & FRAMEBUFFER_FLAG_CACHED)
+		invalidate_data_cache_range((size_t)dest, height * framebuffer->pitch);
+
+	return status;
+}
+
+static uint32_t STDCALL framebuffer_dma_copy_rect(FRAMEBUFFER_DEVICE *framebuffer, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2, uint32_t width, uint32_t height, uint32_t flags)
+{
+	FRAMEBUFFER_DMA *entry;
+	uint8_t *source;
+	uint8_t *dest;
+	uint32_t bytes;
+	uint32_t rowbytes;
+	uint32_t total;
+	int64_t start;
+	BOOL descending;
+
+	entry = framebuffer_dma_find(framebuffer);
+	if (!entry)
+		return ERROR_NOT_FOUND;
+
+	if (width == 0 || height == 0)
+		return ERROR_INVALID_PARAMETER;
+	if (x1 + width > framebuffer->virtualwidth || x2 + width > framebuffer->virtualwidth)
+		return ERROR_INVALID_PARAMETER;
+	if (y1 + height > framebuffer->virtualheight || y2 + height > framebuffer->virtualheight)
+		return ERROR_INVALID_PARAMETER;
+
+	bytes = framebuffer->depth >> 3;
+	rowbytes = width * bytes;
+	total = rowbytes * height;
+
+	if (mutex_lock(framebuffer->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	source = (uint8_t *)framebuffer->address + (y1 * framebuffer->pitch) + (x1 * bytes);
+	dest = (uint8_t *)framebuffer->address + (y2 * framebuffer->pitch) + (x2 * bytes);
+	descending = (y2 > y1);
+
+	entry->statistics.copycount++;
+
+	/* Overlap within the same rows cannot be done by a forward DMA transfer */
+	if (total >= entry->statistics.threshold && y1 != y2)
+	{
+		start = clock_microseconds();
+		if (framebuffer_dma_copy_dma(entry, source, dest, rowbytes, height, descending) == ERROR_SUCCESS)
+		{
+			entry->statistics.dmatime += clock_microseconds() - start;
+			entry->statistics.dmacount++;
+			entry->statistics.dmabytes += total;
+
+			framebuffer->copycount++;
+
+			mutex_unlock(framebuffer->lock);
+			return ERROR_SUCCESS;
+		}
+
+		entry->statistics.dmaerrors++;
+	}
+
+	start = clock_microseconds();
+	framebuffer_dma_copy_cpu(framebuffer, source, dest, rowbytes, height, descending);
+	entry->statistics.cputime += clock_microseconds() - start;
+	entry->statistics.cpucount++;
+	entry->statistics.cpubytes += total;
+
+	framebuffer->copycount++;
+
+	mutex_unlock(framebuffer->lock);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Framebuffer DMA Functions */
+uint32_t STDCALL framebuffer_device_dma_attach(FRAMEBUFFER_DEVICE *framebuffer, uint32_t threshold)
+{
+	FRAMEBUFFER_DMA *entry;
+	MUTEX_HANDLE lock;
+	DMA_HOST *dma;
+
+	if (!framebuffer || framebuffer->device.signature != DEVICE_SIGNATURE)
+		return ERROR_INVALID_PARAMETER;
+
+	/* Direct copy needs a linear unrotated framebuffer that does not require mark or commit */
+	if (framebuffer->address == 0 || framebuffer->rotation != FRAMEBUFFER_ROTATION_0 || framebuffer->depth < 8)
+		return ERROR_NOT_SUPPORTED;
+	if (framebuffer->device.deviceflags & (FRAMEBUFFER_FLAG_MARK | FRAMEBUFFER_FLAG_COMMIT))
+		return ERROR_NOT_SUPPORTED;
+
+	dma = dma_host_get_default();
+	if (!dma)
+		return ERROR_NOT_SUPPORTED;
+
+	/* Create the global lock on first use */
+	if (framebuffer_dmas_lock == INVALID_HANDLE_VALUE)
+	{
+		lock = mutex_create();
+		if (lock == INVALID_HANDLE_VALUE)
+			return ERROR_OPERATION_FAILED;
+
+		if (!__sync_bool_compare_and_swap(&framebuffer_dmas_lock, INVALID_HANDLE_VALUE, lock))
+			mutex_destroy(lock);
+	}
+
+	if (mutex_lock(framebuffer_dmas_lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	if (framebuffer_dma_find(framebuffer))
+	{
+		mutex_unlock(framebuffer_dmas_lock);
+		return ERROR_ALREADY_EXISTS;
+	}
+
+	entry = framebuffer_dma_find(NULL);
+	if (!entry)
+	{
+		mutex_unlock(framebuffer_dmas_lock);
+		return ERROR_NO_MORE_ITEMS;
+	}
+
+	memset(entry, 0, sizeof(FRAMEBUFFER_DMA));
+	if (dma_host_properties(dma, &entry->properties) != ERROR_SUCCESS)
+	{
+		mutex_unlock(framebuffer_dmas_lock);
+		return ERROR_OPERATION_FAILED;
+	}
+
+	entry->dma = dma;
+	entry->statistics.threshold = threshold ? threshold : FRAMEBUFFER_DMA_DEFAULT_THRESHOLD;
+	entry->statistics.stridesupport = (entry->properties.flags & DMA_FLAG_STRIDE) != 0;
+	entry->copyrect = framebuffer->devicecopyrect;
+
+	/* Make the entry visible before installing the copy rect method */
+	__sync_synchronize();
+	entry->framebuffer = framebuffer;
+
+	if (mutex_lock(framebuffer->lock) == ERROR_SUCCESS)
+	{
+		framebuffer->devicecopyrect = framebuffer_dma_copy_rect;
+
+		mutex_unlock(framebuffer->lock);
+	}
+
+	mutex_unlock(framebuffer_dmas_lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL framebuffer_device_dma_detach(FRAMEBUFFER_DEVICE *framebuffer)
+{
+	FRAMEBUFFER_DMA *entry;
+
+	if (!framebuffer || framebuffer_dmas_lock == INVALID_HANDLE_VALUE)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(framebuffer_dmas_lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	entry = framebuffer_dma_find(framebuffer);
+	if (!entry)
+	{
+		mutex_unlock(framebuffer_dmas_lock);
+		return ERROR_NOT_FOUND;
+	}
+
+	/* Restore the original method, holding the framebuffer lock waits for any copy in progress */
+	if (mutex_lock(framebuffer->lock) != ERROR_SUCCESS)
+	{
+		mutex_unlock(framebuffer_dmas_lock);
+		return ERROR_CAN_NOT_COMPLETE;
+	}
+
+	framebuffer->devicecopyrect = entry->copyrect;
+
+	mutex_unlock(framebuffer->lock);
+
+	free(entry->data);
+
+	memset(entry, 0, sizeof(FRAMEBUFFER_DMA));
+
+	mutex_unlock(framebuffer_dmas_lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL framebuffer_device_dma_set_threshold(FRAMEBUFFER_DEVICE *framebuffer, uint32_t threshold)
+{
+	FRAMEBUFFER_DMA *entry;
+
+	if (!framebuffer)
+		return ERROR_INVALID_PARAMETER;
+
+	entry = framebuffer_dma_find(framebuffer);
+	if (!entry)
+		return ERROR_NOT_FOUND;
+
+	entry->statistics.threshold = threshold;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL framebuffer_device_dma_get_statistics(FRAMEBUFFER_DEVICE *framebuffer, FRAMEBUFFER_DMA_STATISTICS *statistics)
+{
+	FRAMEBUFFER_DMA *entry;
+
+	if (!framebuffer || !statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	entry = framebuffer_dma_find(framebuffer);
+	if (!entry)
+		return ERROR_NOT_FOUND;
+
+	if (mutex_lock(framebuffer->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	memcpy(statistics, &entry->statistics, sizeof(FRAMEBUFFER_DMA_STATISTICS));
+
+	mutex_unlock(framebuffer->lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL framebuffer_device_dma_reset_statistics(FRAMEBUFFER_DEVICE *framebuffer)
+{
+	FRAMEBUFFER_DMA *entry;
+
+	if (!framebuffer)
+		return ERROR_INVALID_PARAMETER;
+
+	entry = framebuffer_dma_find(framebuffer);
+	if (!entry)
+		return ERROR_NOT_FOUND;
+
+	if (mutex_lock(framebuffer->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	/* Reset the counters only, the threshold and stride support are kept */
+	entry->statistics.copycount = 0;
+	entry->statistics.dmacount = 0;
+	entry->statistics.cpucount = 0;
+	entry->statistics.dmaerrors = 0;
+	entry->statistics.dmabytes = 0;
+	entry->statistics.cpubytes = 0;
+	entry->statistics.dmatime = 0;
+	entry->statistics.cputime = 0;
+
+	mutex_unlock(framebuffer->lock);
+
+	return ERROR_SUCCESS;
+}
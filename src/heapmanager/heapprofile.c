@@ -0,0 +1,1162 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Call the original heap functions from this module */
+#define HEAP_PROFILE_INTERNAL
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/heapmanager.h"
+#include "ultibo/heapprofile.h"
+
+/* Implementation of the heap profiler for Ultibo API
+ *
+ * In a heap profiling build (make HEAP_PROFILE=1) calls to the heap functions are
+ * redirected to the instrumented versions in this module which record the address,
+ * size, flags, calling thread and caller address of each allocation while tracking
+ * is started. Without HEAP_PROFILE nothing is redirected and there is no overhead.
+ *
+ * Live blocks are kept in a hash table by address, each block is also counted in a
+ * site (caller address and flags) and a type (lowest HEAP_FLAG_* bit). Snapshots copy
+ * the site table so that two snapshots can be compared to find sites whose live bytes
+ * keep growing, the blocks allocated since a snapshot can then be listed to find
+ * the individual allocations that were not freed.
+ *
+ * The tables are allocated when tracking starts and are updated with interrupts
+ * disabled under a small atomic flag so allocations from IRQ and FIQ handlers
+ * (eg get_irq_mem) are also tracked.
+ */
+
+/* Heap Profile State */
+typedef struct _HEAP_PROFILE_STATE HEAP_PROFILE_STATE;
+struct _HEAP_PROFILE_STATE
+{
+	volatile BOOL running;
+	uint32_t flag; // Atomic flag protecting the tables
+	uint32_t maxblocks; // Size of the block table (Power of 2)
+	uint32_t blockcount;
+	uint32_t sitecount;
+	size_t livebytes;
+	uint32_t sequence;
+	uint32_t overflowcount;
+	uint32_t unknowncount;
+	uint32_t typecount[HEAP_PROFILE_TYPE_COUNT];
+	size_t typebytes[HEAP_PROFILE_TYPE_COUNT];
+	HEAP_PROFILE_BLOCK *blocks;
+	HEAP_PROFILE_SITE sites[HEAP_PROFILE_MAX_SITES];
+};
+
+static HEAP_PROFILE_STATE heapprofile;
+
+static const char *heap_profile_type_names[HEAP_PROFILE_TYPE_COUNT] = {
+	"Normal",
+	"Shared",
+	"Local",
+	"Code",
+	"Device",
+	"NoCache",
+	"NonShared",
+	"Locked",
+	"IRQ",
+	"FIQ",
+	"Reclaim",
+	"Other"};
+
+/* ============================================================================== */
+/* Heap Profile Internal Functions */
+static inline IRQ_FIQ_MASK heap_profile_lock(void)
+{
+	IRQ_FIQ_MASK mask = save_irq_fiq();
+
+	while (__sync_lock_test_and_set(&heapprofile.flag, 1))
+	{
+		while (heapprofile.flag)
+			;
+	}
+
+	return mask;
+}
+
+static inline void heap_profile_unlock(IRQ_FIQ_MASK mask)
+{
+	__sync_lock_release(&heapprofile.flag);
+
+	restore_irq_fiq(mask);
+}
+
+static inline uint32_t heap_profile_type(uint32_t flags)
+{
+	if (flags == HEAP_FLAG_NORMAL)
+		return HEAP_PROFILE_TYPE_NORMAL;
+
+	if (flags & ~(HEAP_FLAG_RECLAIM | (HEAP_FLAG_RECLAIM - 1)))
+		return HEAP_PROFILE_TYPE_OTHER;
+
+	return __builtin_ctz(flags) + 1;
+}
+
+static inline uint32_t heap_profile_block_slot(void *address)
+{
+	return (((uint32_t)(size_t)address >> 3) * 2654435761U) & (heapprofile.maxblocks - 1);
+}
+
+/* Find or add a site, caller must hold the lock */
+static HEAP_PROFILE_SITE *heap_profile_site(size_t caller, uint32_t flags)
+{
+	HEAP_PROFILE_SITE *site;
+	uint32_t slot;
+	uint32_t probe;
+
+	slot = (((uint32_t)caller ^ flags) * 2654435761U) >> 16;
+	for (probe = 0; probe < HEAP_PROFILE_MAX_SITES; probe++)
+	{
+		site = &heapprofile.sites[(slot + probe) & (HEAP_PROFILE_MAX_SITES - 1)];
+
+		if (site->caller == caller && site->flags == flags)
+			return site;
+
+		if (site->caller == 0)
+		{
+			site->caller = caller;
+			site->flags = flags;
+			heapprofile.sitecount++;
+			return site;
+		}
+	}
+
+	return NULL;
+}
+
+/* Record a new block, returns Address unchanged */
+static void *heap_profile_allocated(void *address, size_t size, uint32_t flags, size_t caller)
+{
+	HEAP_PROFILE_BLOCK *block;
+	HEAP_PROFILE_SITE *site;
+	IRQ_FIQ_MASK mask;
+	THREAD_HANDLE thread;
+	uint32_t type;
+	uint32_t slot;
+
+	if (!heapprofile.running || !address)
+		return address;
+
+	thread = thread_get_current();
+	type = heap_profile_type(flags);
+
+	mask = heap_profile_lock();
+
+	/* Keep the table at most 3/4 full so probes stay short */
+	site = heap_profile_site(caller, flags);
+	if (!site || heapprofile.blockcount >= heapprofile.maxblocks - (heapprofile.maxblocks / 4))
+	{
+		heapprofile.overflowcount++;
+
+		heap_profile_unlock(mask);
+		return address;
+	}
+
+	slot = heap_profile_block_slot(address);
+	while (heapprofile.blocks[slot].address)
+		slot = (slot + 1) & (heapprofile.maxblocks - 1);
+
+	block = &heapprofile.blocks[slot];
+	block->address = address;
+	block->size = size;
+	block->caller = caller;
+	block->flags = flags;
+	block->sequence = ++heapprofile.sequence;
+	block->thread = thread;
+
+	heapprofile.blockcount++;
+	heapprofile.livebytes += size;
+	heapprofile.typecount[type]++;
+	heapprofile.typebytes[type] += size;
+
+	site->livecount++;
+	site->livebytes += size;
+	site->alloccount++;
+	if (site->livebytes > site->peakbytes)
+		site->peakbytes = site->livebytes;
+
+	heap_profile_unlock(mask);
+
+	return address;
+}
+
+/* Remove a block, returns TRUE and a copy of the block (if requested) if it was tracked */
+static BOOL heap_profile_freed(void *address, HEAP_PROFILE_BLOCK *copy)
+{
+	HEAP_PROFILE_BLOCK *block;
+	HEAP_PROFILE_SITE *site;
+	IRQ_FIQ_MASK mask;
+	uint32_t type;
+	uint32_t slot;
+	uint32_t next;
+	uint32_t home;
+
+	if (!heapprofile.running || !address)
+		return FALSE;
+
+	mask = heap_profile_lock();
+
+	slot = heap_profile_block_slot(address);
+	while (heapprofile.blocks[slot].address && heapprofile.blocks[slot].address != address)
+		slot = (slot + 1) & (heapprofile.maxblocks - 1);
+
+	block = &heapprofile.blocks[slot];
+	if (!block->address)
+	{
+		heapprofile.unknowncount++;
+
+		heap_profile_unlock(mask);
+		return FALSE;
+	}
+
+	if (copy)
+		memcpy(copy, block, sizeof(HEAP_PROFILE_BLOCK));
+
+	type = heap_profile_type(block->flags);
+	heapprofile.blockcount--;
+	heapprofile.livebytes -= block->size;
+	heapprofile.typecount[type]--;
+	heapprofile.typebytes[type] -= block->size;
+
+	site = heap_profile_site(block->caller, block->flags);
+	if (site)
+	{
+		site->livecount--;
+		site->livebytes -= block->size;
+		site->freecount++;
+	}
+
+	/* Remove by shifting back any following entries that probed past this slot */
+	next = slot;
+	for (;;)
+	{
+		next = (next + 1) & (heapprofile.maxblocks - 1);
+		if (!heapprofile.blocks[next].address)
+			break;
+
+		home = heap_profile_block_slot(heapprofile.blocks[next].address);
+		if (((next - home) & (heapprofile.maxblocks - 1)) >= ((next - slot) & (heapprofile.maxblocks - 1)))
+		{
+			heapprofile.blocks[slot] = heapprofile.blocks[next];
+			slot = next;
+		}
+	}
+	heapprofile.blocks[slot].address = NULL;
+
+	heap_profile_unlock(mask);
+
+	return TRUE;
+}
+
+/* Record the result of a reallocation, the previous block was removed before reallocating
+   in case its address was reused by another thread before this call returns */
+static void *heap_profile_reallocated(void *address, size_t size, uint32_t flags, size_t caller, HEAP_PROFILE_BLOCK *previous)
+{
+	if (!heapprofile.running)
+		return address;
+
+	/* On failure the previous block is unchanged */
+	if (!address && size != 0)
+	{
+		if (previous)
+			heap_profile_allocated(previous->address, previous->size, previous->flags, previous->caller);
+
+		return NULL;
+	}
+
+	return heap_profile_allocated(address, size, flags, caller);
+}
+
+/* Sort helpers (Largest first) */
+static int heap_profile_compare_sites(const void *a, const void *b)
+{
+	const HEAP_PROFILE_SITE *site1 = (const HEAP_PROFILE_SITE *)a;
+	const HEAP_PROFILE_SITE *site2 = (const HEAP_PROFILE_SITE *)b;
+
+	if (site1->livebytes == site2->livebytes)
+		return 0;
+
+	return (site1->livebytes < site2->livebytes) ? 1 : -1;
+}
+
+static int heap_profile_compare_diffs(const void *a, const void *b)
+{
+	const HEAP_PROFILE_DIFF *diff1 = (const HEAP_PROFILE_DIFF *)a;
+	const HEAP_PROFILE_DIFF *diff2 = (const HEAP_PROFILE_DIFF *)b;
+
+	if (diff1->bytesdelta == diff2->bytesdelta)
+		return 0;
+
+	return (diff1->bytesdelta < diff2->bytesdelta) ? 1 : -1;
+}
+
+/* Copy the used sites into a new array sorted by live bytes */
+static HEAP_PROFILE_SITE *heap_profile_copy_sites(uint32_t *count)
+{
+	HEAP_PROFILE_SITE *sites;
+	IRQ_FIQ_MASK mask;
+	uint32_t index;
+	uint32_t total;
+
+	sites = malloc(HEAP_PROFILE_MAX_SITES * sizeof(HEAP_PROFILE_SITE));
+	if (!sites)
+		return NULL;
+
+	total = 0;
+
+	mask = heap_profile_lock();
+	for (index = 0; index < HEAP_PROFILE_MAX_SITES; index++)
+	{
+		if (heapprofile.sites[index].caller != 0)
+			sites[total++] = heapprofile.sites[index];
+	}
+	heap_profile_unlock(mask);
+
+	qsort(sites, total, sizeof(HEAP_PROFILE_SITE), heap_profile_compare_sites);
+
+	*count = total;
+
+	return sites;
+}
+
+/* ============================================================================== */
+/* Heap Profile Functions */
+uint32_t STDCALL heap_profile_start(uint32_t maxblocks)
+{
+	HEAP_PROFILE_BLOCK *blocks;
+	uint32_t size;
+
+	if (heapprofile.running)
+		return ERROR_ALREADY_EXISTS;
+
+	if (maxblocks == 0)
+		maxblocks = HEAP_PROFILE_DEFAULT_BLOCKS;
+
+	/* Round up to a power of 2 */
+	size = 16;
+	while (size < maxblocks)
+		size <<= 1;
+
+	/* Allocated from the heap directly so the table is not tracked */
+	blocks = get_mem(size * sizeof(HEAP_PROFILE_BLOCK));
+	if (!blocks)
+		return ERROR_NOT_ENOUGH_MEMORY;
+	memset(blocks, 0, size * sizeof(HEAP_PROFILE_BLOCK));
+
+	if (heapprofile.blocks)
+		free_mem(heapprofile.blocks);
+
+	memset(&heapprofile, 0, sizeof(HEAP_PROFILE_STATE));
+	heapprofile.maxblocks = size;
+	heapprofile.blocks = blocks;
+
+	__sync_synchronize();
+	heapprofile.running = TRUE;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL heap_profile_stop(void)
+{
+	IRQ_FIQ_MASK mask;
+
+	if (!heapprofile.running)
+		return ERROR_NOT_READY;
+
+	/* Tables are kept for reporting until the next start */
+	mask = heap_profile_lock();
+	heapprofile.running = FALSE;
+	heap_profile_unlock(mask);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL heap_profile_get_statistics(HEAP_PROFILE_STATISTICS *statistics)
+{
+	IRQ_FIQ_MASK mask;
+
+	if (!statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	if (!heapprofile.blocks)
+		return ERROR_NOT_READY;
+
+	mask = heap_profile_lock();
+
+	statistics->running = heapprofile.running;
+	statistics->maxblocks = heapprofile.maxblocks;
+	statistics->blockcount = heapprofile.blockcount;
+	statistics->sitecount = heapprofile.sitecount;
+	statistics->livebytes = heapprofile.livebytes;
+	statistics->sequence = heapprofile.sequence;
+	statistics->overflowcount = heapprofile.overflowcount;
+	statistics->unknowncount = heapprofile.unknowncount;
+	memcpy(statistics->typecount, heapprofile.typecount, sizeof(statistics->typecount));
+	memcpy(statistics->typebytes, heapprofile.typebytes, sizeof(statistics->typebytes));
+
+	heap_profile_unlock(mask);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL heap_profile_get_sites(HEAP_PROFILE_SITE *buffer, uint32_t len, uint32_t *count)
+{
+	HEAP_PROFILE_SITE *sites;
+	uint32_t total;
+
+	if (!count || (!buffer && len > 0))
+		return ERROR_INVALID_PARAMETER;
+
+	if (!heapprofile.blocks)
+		return ERROR_NOT_READY;
+
+	sites = heap_profile_copy_sites(&total);
+	if (!sites)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	memcpy(buffer, sites, ((total < len) ? total : len) * sizeof(HEAP_PROFILE_SITE));
+	free(sites);
+
+	*count = total;
+	if (total > len)
+		return ERROR_INSUFFICIENT_BUFFER;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL heap_profile_get_blocks(uint32_t sequence, HEAP_PROFILE_BLOCK *buffer, uint32_t len, uint32_t *count)
+{
+	HEAP_PROFILE_BLOCK *block;
+	IRQ_FIQ_MASK mask;
+	uint32_t total;
+	uint32_t slot;
+
+	if (!count || (!buffer && len > 0))
+		return ERROR_INVALID_PARAMETER;
+
+	if (!heapprofile.blocks)
+		return ERROR_NOT_READY;
+
+	total = 0;
+
+	mask = heap_profile_lock();
+	for (slot = 0; slot < heapprofile.maxblocks; slot++)
+	{
+		block = &heapprofile.blocks[slot];
+		if (!block->address || block->sequence <= sequence)
+			continue;
+
+		if (total < len)
+			buffer[total] = *block;
+		total++;
+	}
+	heap_profile_unlock(mask);
+
+	*count = total;
+	if (total > len)
+		return ERROR_INSUFFICIENT_BUFFER;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL heap_profile_get_fragmentation(HEAP_PROFILE_FRAGMENTATION *fragmentation)
+{
+	HEAP_STATUS status;
+
+	if (!fragmentation)
+		return ERROR_INVALID_PARAMETER;
+
+	status = get_heap_status();
+
+	fragmentation->totalfree = status.totalfree;
+	fragmentation->freecount = get_heap_block_count(HEAP_STATE_FREE);
+	fragmentation->largestfree = get_heap_block_max(HEAP_STATE_FREE);
+	fragmentation->smallestfree = get_heap_block_min(HEAP_STATE_FREE);
+	fragmentation->fragmentation = 0;
+	if (fragmentation->totalfree > fragmentation->largestfree)
+		fragmentation->fragmentation = (uint32_t)(((uint64_t)(fragmentation->totalfree - fragmentation->largestfree) * 100) / fragmentation->totalfree);
+
+	return ERROR_SUCCESS;
+}
+
+HEAP_PROFILE_SNAPSHOT * STDCALL heap_profile_snapshot_create(void)
+{
+	HEAP_PROFILE_SNAPSHOT *snapshot;
+	IRQ_FIQ_MASK mask;
+
+	if (!heapprofile.blocks)
+		return NULL;
+
+	snapshot = malloc(sizeof(HEAP_PROFILE_SNAPSHOT));
+	if (!snapshot)
+		return NULL;
+
+	snapshot->sites = heap_profile_copy_sites(&snapshot->sitecount);
+	if (!snapshot->sites)
+	{
+		free(snapshot);
+		return NULL;
+	}
+
+	mask = heap_profile_lock();
+	snapshot->sequence = heapprofile.sequence;
+	memcpy(snapshot->typecount, heapprofile.typecount, sizeof(snapshot->typecount));
+	memcpy(snapshot->typebytes, heapprofile.typebytes, sizeof(snapshot->typebytes));
+	heap_profile_unlock(mask);
+
+	snapshot->time = clock_microseconds();
+
+	return snapshot;
+}
+
+uint32_t STDCALL heap_profile_snapshot_destroy(HEAP_PROFILE_SNAPSHOT *snapshot)
+{
+	if (!snapshot)
+		return ERROR_INVALID_PARAMETER;
+
+	free(snapshot->sites);
+	free(snapshot);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL heap_profile_snapshot_diff(HEAP_PROFILE_SNAPSHOT *before, HEAP_PROFILE_SNAPSHOT *after, HEAP_PROFILE_DIFF *buffer, uint32_t len, uint32_t *count)
+{
+	HEAP_PROFILE_DIFF *diffs;
+	HEAP_PROFILE_SITE *site;
+	uint32_t total;
+	uint32_t index;
+	uint32_t match;
+	int64_t bytes;
+	int32_t blocks;
+
+	if (!before || !after || !count || (!buffer && len > 0))
+		return ERROR_INVALID_PARAMETER;
+
+	diffs = malloc((after->sitecount + 1) * sizeof(HEAP_PROFILE_DIFF));
+	if (!diffs)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	/* Sites are never removed so every site in the earlier snapshot is also in the later one */
+	total = 0;
+	for (index = 0; index < after->sitecount; index++)
+	{
+		site = &after->sites[index];
+
+		bytes = site->livebytes;
+		blocks = site->livecount;
+		for (match = 0; match < before->sitecount; match++)
+		{
+			if (before->sites[match].caller == site->caller && before->sites[match].flags == site->flags)
+			{
+				bytes -= before->sites[match].livebytes;
+				blocks -= before->sites[match].livecount;
+				break;
+			}
+		}
+
+		if (bytes <= 0)
+			continue;
+
+		diffs[total].caller = site->caller;
+		diffs[total].flags = site->flags;
+		diffs[total].countdelta = blocks;
+		diffs[total].bytesdelta = bytes;
+		diffs[total].livebytes = site->livebytes;
+		total++;
+	}
+
+	qsort(diffs, total, sizeof(HEAP_PROFILE_DIFF), heap_profile_compare_diffs);
+
+	memcpy(buffer, diffs, ((total < len) ? total : len) * sizeof(HEAP_PROFILE_DIFF));
+	free(diffs);
+
+	*count = total;
+	if (total > len)
+		return ERROR_INSUFFICIENT_BUFFER;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL heap_profile_report(uint32_t limit)
+{
+	HEAP_PROFILE_STATISTICS statistics;
+	HEAP_PROFILE_FRAGMENTATION fragmentation;
+	HEAP_PROFILE_SITE *sites;
+	char line[256];
+	uint32_t count;
+	uint32_t index;
+
+	if (heap_profile_get_statistics(&statistics) != ERROR_SUCCESS)
+		return ERROR_NOT_READY;
+
+	snprintf(line, sizeof(line), "Heap Profile: %u live blocks, %lu live bytes, %u sites, %u overflows, %u unknown frees", (unsigned int)statistics.blockcount, (unsigned long)statistics.livebytes, (unsigned int)statistics.sitecount, (unsigned int)statistics.overflowcount, (unsigned int)statistics.unknowncount);
+	logging_output(line);
+
+	for (index = 0; index < HEAP_PROFILE_TYPE_COUNT; index++)
+	{
+		if (statistics.typecount[index] == 0)
+			continue;
+
+		snprintf(line, sizeof(line), " %s: %u blocks, %lu bytes", heap_profile_type_names[index], (unsigned int)statistics.typecount[index], (unsigned long)statistics.typebytes[index]);
+		logging_output(line);
+	}
+
+	sites = heap_profile_copy_sites(&count);
+	if (!sites)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	if (limit == 0 || limit > count)
+		limit = count;
+
+	for (index = 0; index < limit; index++)
+	{
+		snprintf(line, sizeof(line), " Site 0x%08lx flags 0x%08x: %u blocks, %lu bytes (peak %lu), %u allocs, %u frees", (unsigned long)sites[index].caller, (unsigned int)sites[index].flags, (unsigned int)sites[index].livecount, (unsigned long)sites[index].livebytes, (unsigned long)sites[index].peakbytes, (unsigned int)sites[index].alloccount, (unsigned int)sites[index].freecount);
+		logging_output(line);
+	}
+
+	free(sites);
+
+	heap_profile_get_fragmentation(&fragmentation);
+
+	snprintf(line, sizeof(line), "Heap Fragmentation: %u free bytes in %u blocks, largest %u, smallest %u, fragmentation %u%%", (unsigned int)fragmentation.totalfree, (unsigned int)fragmentation.freecount, (unsigned int)fragmentation.largestfree, (unsigned int)fragmentation.smallestfree, (unsigned int)fragmentation.fragmentation);
+	logging_output(line);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL heap_profile_report_diff(HEAP_PROFILE_SNAPSHOT *before, HEAP_PROFILE_SNAPSHOT *after, uint32_t limit)
+{
+	HEAP_PROFILE_DIFF *diffs;
+	char line[256];
+	uint32_t count;
+	uint32_t index;
+	uint32_t status;
+
+	if (!before || !after)
+		return ERROR_INVALID_PARAMETER;
+
+	status = heap_profile_snapshot_diff(before, after, NULL, 0, &count);
+	if (status != ERROR_SUCCESS && status != ERROR_INSUFFICIENT_BUFFER)
+		return status;
+
+	snprintf(line, sizeof(line), "Heap Profile Diff: %u sites grew over %lld ms (Sequence %u to %u)", (unsigned int)count, (long long)((after->time - before->time) / 1000), (unsigned int)before->sequence, (unsigned int)after->sequence);
+	logging_output(line);
+
+	if (limit == 0 || limit > count)
+		limit = count;
+	if (limit == 0)
+		return ERROR_SUCCESS;
+
+	diffs = malloc(limit * sizeof(HEAP_PROFILE_DIFF));
+	if (!diffs)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	heap_profile_snapshot_diff(before, after, diffs, limit, &count);
+
+	for (index = 0; index < limit; index++)
+	{
+		snprintf(line, sizeof(line), " Site 0x%08lx flags 0x%08x: %+lld bytes, %+d blocks, %lu live bytes", (unsigned long)diffs[index].caller, (unsigned int)diffs[index].flags, (long long)diffs[index].bytesdelta, (int)diffs[index].countdelta, (unsigned long)diffs[index].livebytes);
+		logging_output(line);
+	}
+
+	free(diffs);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL heap_profile_report_blocks(uint32_t sequence, uint32_t limit)
+{
+	HEAP_PROFILE_BLOCK *blocks;
+	char name[THREAD_NAME_LENGTH];
+	char line[256];
+	uint32_t count;
+	uint32_t index;
+	uint32_t status;
+
+	status = heap_profile_get_blocks(sequence, NULL, 0, &count);
+	if (status != ERROR_SUCCESS && status != ERROR_INSUFFICIENT_BUFFER)
+		return status;
+
+	snprintf(line, sizeof(line), "Heap Profile: %u live blocks allocated after sequence %u", (unsigned int)count, (unsigned int)sequence);
+	logging_output(line);
+
+	if (limit == 0 || limit > count)
+		limit = count;
+	if (limit == 0)
+		return ERROR_SUCCESS;
+
+	blocks = malloc(limit * sizeof(HEAP_PROFILE_BLOCK));
+	if (!blocks)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	heap_profile_get_blocks(sequence, blocks, limit, &count);
+	if (count < limit)
+		limit = count;
+
+	for (index = 0; index < limit; index++)
+	{
+		if (thread_get_name(blocks[index].thread, name, sizeof(name)) != ERROR_SUCCESS || name[0] == '\0')
+			snprintf(name, sizeof(name), "Thread 0x%08lx", (unsigned long)blocks[index].thread);
+
+		snprintf(line, sizeof(line), " Block 0x%08lx size %lu flags 0x%08x sequence %u caller 0x%08lx thread %s", (unsigned long)blocks[index].address, (unsigned long)blocks[index].size, (unsigned int)blocks[index].flags, (unsigned int)blocks[index].sequence, (unsigned long)blocks[index].caller, name);
+		logging_output(line);
+	}
+
+	free(blocks);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Heap Profile Instrumented Functions */
+void * STDCALL heap_profile_get_mem(size_t size)
+{
+	return heap_profile_allocated(get_mem(size), size, HEAP_FLAG_NORMAL, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_mem_ex(size_t size, uint32_t flags, uint32_t affinity)
+{
+	return heap_profile_allocated(get_mem_ex(size, flags, affinity), size, flags, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_aligned_mem(size_t size, size_t alignment)
+{
+	return heap_profile_allocated(get_aligned_mem(size, alignment), size, HEAP_FLAG_NORMAL, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_aligned_mem_ex(size_t size, size_t alignment, uint32_t flags, uint32_t affinity)
+{
+	return heap_profile_allocated(get_aligned_mem_ex(size, alignment, flags, affinity), size, flags, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_shared_mem(size_t size)
+{
+	return heap_profile_allocated(get_shared_mem(size), size, HEAP_FLAG_SHARED, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_shared_aligned_mem(size_t size, size_t alignment)
+{
+	return heap_profile_allocated(get_shared_aligned_mem(size, alignment), size, HEAP_FLAG_SHARED, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_local_mem(size_t size, uint32_t affinity)
+{
+	return heap_profile_allocated(get_local_mem(size, affinity), size, HEAP_FLAG_LOCAL, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_local_aligned_mem(size_t size, size_t alignment, uint32_t affinity)
+{
+	return heap_profile_allocated(get_local_aligned_mem(size, alignment, affinity), size, HEAP_FLAG_LOCAL, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_code_mem(size_t size, uint32_t affinity)
+{
+	return heap_profile_allocated(get_code_mem(size, affinity), size, HEAP_FLAG_CODE, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_code_aligned_mem(size_t size, size_t alignment, uint32_t affinity)
+{
+	return heap_profile_allocated(get_code_aligned_mem(size, alignment, affinity), size, HEAP_FLAG_CODE, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_device_mem(size_t size)
+{
+	return heap_profile_allocated(get_device_mem(size), size, HEAP_FLAG_DEVICE, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_device_aligned_mem(size_t size, size_t alignment)
+{
+	return heap_profile_allocated(get_device_aligned_mem(size, alignment), size, HEAP_FLAG_DEVICE, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_nocache_mem(size_t size)
+{
+	return heap_profile_allocated(get_nocache_mem(size), size, HEAP_FLAG_NOCACHE, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_nocache_aligned_mem(size_t size, size_t alignment)
+{
+	return heap_profile_allocated(get_nocache_aligned_mem(size, alignment), size, HEAP_FLAG_NOCACHE, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_nonshared_mem(size_t size)
+{
+	return heap_profile_allocated(get_nonshared_mem(size), size, HEAP_FLAG_NONSHARED, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_nonshared_aligned_mem(size_t size, size_t alignment)
+{
+	return heap_profile_allocated(get_nonshared_aligned_mem(size, alignment), size, HEAP_FLAG_NONSHARED, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_irq_mem(size_t size, uint32_t affinity)
+{
+	return heap_profile_allocated(get_irq_mem(size, affinity), size, HEAP_FLAG_IRQ, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_irq_aligned_mem(size_t size, size_t alignment, uint32_t affinity)
+{
+	return heap_profile_allocated(get_irq_aligned_mem(size, alignment, affinity), size, HEAP_FLAG_IRQ, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_fiq_mem(size_t size, uint32_t affinity)
+{
+	return heap_profile_allocated(get_fiq_mem(size, affinity), size, HEAP_FLAG_FIQ, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_get_fiq_aligned_mem(size_t size, size_t alignment, uint32_t affinity)
+{
+	return heap_profile_allocated(get_fiq_aligned_mem(size, alignment, affinity), size, HEAP_FLAG_FIQ, (size_t)__builtin_return_address(0));
+}
+
+size_t STDCALL heap_profile_free_mem(void *addr)
+{
+	heap_profile_freed(addr, NULL);
+
+	return free_mem(addr);
+}
+
+size_t STDCALL heap_profile_free_irq_mem(void *addr)
+{
+	heap_profile_freed(addr, NULL);
+
+	return free_irq_mem(addr);
+}
+
+size_t STDCALL heap_profile_free_fiq_mem(void *addr)
+{
+	heap_profile_freed(addr, NULL);
+
+	return free_fiq_mem(addr);
+}
+
+void * STDCALL heap_profile_alloc_mem(size_t size)
+{
+	return heap_profile_allocated(alloc_mem(size), size, HEAP_FLAG_NORMAL, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_alloc_mem_ex(size_t size, uint32_t flags, uint32_t affinity)
+{
+	return heap_profile_allocated(alloc_mem_ex(size, flags, affinity), size, flags, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_realloc_mem(void *addr, size_t size)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_mem(addr, size), size, HEAP_FLAG_NORMAL, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_realloc_mem_ex(void *addr, size_t size, uint32_t flags, uint32_t affinity)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_mem_ex(addr, size, flags, affinity), size, flags, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_alloc_aligned_mem(size_t size, size_t alignment)
+{
+	return heap_profile_allocated(alloc_aligned_mem(size, alignment), size, HEAP_FLAG_NORMAL, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_alloc_aligned_mem_ex(size_t size, size_t alignment, uint32_t flags, uint32_t affinity)
+{
+	return heap_profile_allocated(alloc_aligned_mem_ex(size, alignment, flags, affinity), size, flags, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_realloc_aligned_mem(void *addr, size_t size, size_t alignment)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_aligned_mem(addr, size, alignment), size, HEAP_FLAG_NORMAL, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_realloc_aligned_mem_ex(void *addr, size_t size, size_t alignment, uint32_t flags, uint32_t affinity)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_aligned_mem_ex(addr, size, alignment, flags, affinity), size, flags, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_alloc_shared_mem(size_t size)
+{
+	return heap_profile_allocated(alloc_shared_mem(size), size, HEAP_FLAG_SHARED, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_alloc_shared_aligned_mem(size_t size, size_t alignment)
+{
+	return heap_profile_allocated(alloc_shared_aligned_mem(size, alignment), size, HEAP_FLAG_SHARED, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_realloc_shared_mem(void *addr, size_t size)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_shared_mem(addr, size), size, HEAP_FLAG_SHARED, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_realloc_shared_aligned_mem(void *addr, size_t size, size_t alignment)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_shared_aligned_mem(addr, size, alignment), size, HEAP_FLAG_SHARED, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_alloc_local_mem(size_t size, uint32_t affinity)
+{
+	return heap_profile_allocated(alloc_local_mem(size, affinity), size, HEAP_FLAG_LOCAL, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_alloc_local_aligned_mem(size_t size, size_t alignment, uint32_t affinity)
+{
+	return heap_profile_allocated(alloc_local_aligned_mem(size, alignment, affinity), size, HEAP_FLAG_LOCAL, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_realloc_local_mem(void *addr, size_t size, uint32_t affinity)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_local_mem(addr, size, affinity), size, HEAP_FLAG_LOCAL, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_realloc_local_aligned_mem(void *addr, size_t size, size_t alignment, uint32_t affinity)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_local_aligned_mem(addr, size, alignment, affinity), size, HEAP_FLAG_LOCAL, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_alloc_code_mem(size_t size, uint32_t affinity)
+{
+	return heap_profile_allocated(alloc_code_mem(size, affinity), size, HEAP_FLAG_CODE, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_alloc_code_aligned_mem(size_t size, size_t alignment, uint32_t affinity)
+{
+	return heap_profile_allocated(alloc_code_aligned_mem(size, alignment, affinity), size, HEAP_FLAG_CODE, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_realloc_code_mem(void *addr, size_t size, uint32_t affinity)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_code_mem(addr, size, affinity), size, HEAP_FLAG_CODE, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_realloc_code_aligned_mem(void *addr, size_t size, size_t alignment, uint32_t affinity)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_code_aligned_mem(addr, size, alignment, affinity), size, HEAP_FLAG_CODE, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_alloc_device_mem(size_t size)
+{
+	return heap_profile_allocated(alloc_device_mem(size), size, HEAP_FLAG_DEVICE, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_alloc_device_aligned_mem(size_t size, size_t alignment)
+{
+	return heap_profile_allocated(alloc_device_aligned_mem(size, alignment), size, HEAP_FLAG_DEVICE, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_realloc_device_mem(void *addr, size_t size)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_device_mem(addr, size), size, HEAP_FLAG_DEVICE, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_realloc_device_aligned_mem(void *addr, size_t size, size_t alignment)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_device_aligned_mem(addr, size, alignment), size, HEAP_FLAG_DEVICE, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_alloc_nocache_mem(size_t size)
+{
+	return heap_profile_allocated(alloc_nocache_mem(size), size, HEAP_FLAG_NOCACHE, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_alloc_nocache_aligned_mem(size_t size, size_t alignment)
+{
+	return heap_profile_allocated(alloc_nocache_aligned_mem(size, alignment), size, HEAP_FLAG_NOCACHE, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_realloc_nocache_mem(void *addr, size_t size)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_nocache_mem(addr, size), size, HEAP_FLAG_NOCACHE, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_realloc_nocache_aligned_mem(void *addr, size_t size, size_t alignment)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_nocache_aligned_mem(addr, size, alignment), size, HEAP_FLAG_NOCACHE, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_alloc_nonshared_mem(size_t size)
+{
+	return heap_profile_allocated(alloc_nonshared_mem(size), size, HEAP_FLAG_NONSHARED, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_alloc_nonshared_aligned_mem(size_t size, size_t alignment)
+{
+	return heap_profile_allocated(alloc_nonshared_aligned_mem(size, alignment), size, HEAP_FLAG_NONSHARED, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_realloc_nonshared_mem(void *addr, size_t size)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_nonshared_mem(addr, size), size, HEAP_FLAG_NONSHARED, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_realloc_nonshared_aligned_mem(void *addr, size_t size, size_t alignment)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_nonshared_aligned_mem(addr, size, alignment), size, HEAP_FLAG_NONSHARED, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_alloc_irq_mem(size_t size, uint32_t affinity)
+{
+	return heap_profile_allocated(alloc_irq_mem(size, affinity), size, HEAP_FLAG_IRQ, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_alloc_irq_aligned_mem(size_t size, size_t alignment, uint32_t affinity)
+{
+	return heap_profile_allocated(alloc_irq_aligned_mem(size, alignment, affinity), size, HEAP_FLAG_IRQ, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_realloc_irq_mem(void *addr, size_t size, uint32_t affinity)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_irq_mem(addr, size, affinity), size, HEAP_FLAG_IRQ, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_realloc_irq_aligned_mem(void *addr, size_t size, size_t alignment, uint32_t affinity)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_irq_aligned_mem(addr, size, alignment, affinity), size, HEAP_FLAG_IRQ, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_alloc_fiq_mem(size_t size, uint32_t affinity)
+{
+	return heap_profile_allocated(alloc_fiq_mem(size, affinity), size, HEAP_FLAG_FIQ, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_alloc_fiq_aligned_mem(size_t size, size_t alignment, uint32_t affinity)
+{
+	return heap_profile_allocated(alloc_fiq_aligned_mem(size, alignment, affinity), size, HEAP_FLAG_FIQ, (size_t)__builtin_return_address(0));
+}
+
+void * STDCALL heap_profile_realloc_fiq_mem(void *addr, size_t size, uint32_t affinity)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_fiq_mem(addr, size, affinity), size, HEAP_FLAG_FIQ, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
+
+void * STDCALL heap_profile_realloc_fiq_aligned_mem(void *addr, size_t size, size_t alignment, uint32_t affinity)
+{
+	HEAP_PROFILE_BLOCK block;
+	BOOL found;
+
+	found = heap_profile_freed(addr, &block);
+
+	return heap_profile_reallocated(realloc_fiq_aligned_mem(addr, size, alignment, affinity), size, HEAP_FLAG_FIQ, (size_t)__builtin_return_address(0), found ? &block : NULL);
+}
@@ -0,0 +1,971 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/threads.h"
+#include "ultibo/input.h"
+
+/* Implementation of bulk input reads and input sets for Ultibo API
+ *
+ * The standard device read functions remove one record at a time from the
+ * device buffer, acquiring the device lock for each record. The functions
+ * here claim every available record from the buffer semaphore first and then
+ * copy them all out of the ring while holding the device lock only once.
+ *
+ * Input sets allow a single thread to wait on several input devices at once,
+ * each device in a set has a small wait thread which blocks on the buffer
+ * semaphore and signals the set when data arrives. The semaphore count is
+ * handed straight back so every record is still accounted for by the reader.
+ * Removing a device signals the semaphore once more to wake the wait thread
+ * and takes that count back after the thread has exited, so the wait threads
+ * never need to poll.
+ *
+ * Devices with a device specific read method do not use the device buffer so
+ * they cannot be added to an input set, the read all functions pass their read
+ * to the device instead (Keyboard and mouse read methods have no flags so the
+ * NON_BLOCK device flag is set for the duration of a non blocking read).
+ */
+
+/* Input Set Entry */
+typedef struct _INPUT_SET_ENTRY INPUT_SET_ENTRY;
+struct _INPUT_SET_ENTRY
+{
+	INPUT_SET *set; // The Input set this entry belongs to
+	uint32_t inputtype; // The type of the device (eg INPUT_TYPE_MOUSE)
+	void *device; // The device for this entry (eg MOUSE_DEVICE)
+	SEMAPHORE_HANDLE wait; // The buffer semaphore of the device
+	EVENT_HANDLE rearm; // Signaled by the reader when the device has been drained
+	COMPLETION_HANDLE done; // Completed by the wait thread when it exits
+	THREAD_ID thread; // The wait thread for this entry
+	volatile BOOL pending; // Set by the wait thread when data is available
+	volatile BOOL terminate; // Set when the entry is being removed
+	BOOL directread; // TRUE if this entry set the direct read flag on the device (Cleared again on removal)
+};
+
+/* Input Set */
+struct _INPUT_SET
+{
+	MUTEX_HANDLE lock; // Input set lock
+	EVENT_HANDLE ready; // Signaled when any device in the set has data available
+	uint32_t count; // Number of devices in the set
+	uint32_t next; // Index of the first device to read on the next call (Round robin)
+	INPUT_SET_ENTRY *entries[INPUT_SET_MAX_DEVICES];
+};
+
+/* Remove up to len records from a device ring buffer while holding the device lock only once */
+static uint32_t input_buffer_drain(MUTEX_HANDLE lock, SEMAPHORE_HANDLE wait, volatile uint32_t *start, volatile uint32_t *available, void *ring, uint32_t ringsize, uint32_t recordsize, void *buffer, size_t stride, uint32_t len, uint32_t timeout, uint32_t *count)
+{
+	uint32_t taken;
+	uint32_t first;
+	uint32_t index;
+	uint8_t *dest;
+
+	*count = 0;
+
+	if (len == 0)
+		return ERROR_INSUFFICIENT_BUFFER;
+
+	/* Claim the first record, waiting if requested */
+	if (semaphore_wait_ex(wait, timeout) != ERROR_SUCCESS)
+		return (timeout == 0) ? ERROR_NO_MORE_ITEMS : ERROR_WAIT_TIMEOUT;
+	taken = 1;
+
+	/* Claim any further records that are already available without waiting */
+	while (taken < len && semaphore_wait_ex(wait, 0) == ERROR_SUCCESS)
+		taken++;
+
+	if (mutex_lock(lock) != ERROR_SUCCESS)
+	{
+		semaphore_signal_ex(wait, taken, NULL);
+		return ERROR_CAN_NOT_COMPLETE;
+	}
+
+	/* The semaphore never runs ahead of the buffer count but be defensive */
+	if (taken > *available)
+	{
+		semaphore_signal_ex(wait, taken - *available, NULL);
+		taken = *available;
+	}
+
+	first = *start;
+	dest = (uint8_t *)buffer;
+
+	if (stride == recordsize)
+	{
+		/* Contiguous destination, copy in at most two blocks */
+		index = ringsize - first;
+		if (index > taken)
+			index = taken;
+
+		memcpy(dest, (uint8_t *)ring + (first * recordsize), index * recordsize);
+		if (taken > index)
+			memcpy(dest + (index * recordsize), ring, (taken - index) * recordsize);
+	}
+	else
+	{
+		/* Strided destination (eg INPUT_EVENT), copy each record */
+		for (index = 0; index < taken; index++)
+		{
+			memcpy(dest, (uint8_t *)ring + (((first + index) % ringsize) * recordsize), recordsize);
+			dest += stride;
+		}
+	}
+
+	*start = (first + taken) % ringsize;
+	*available -= taken;
+
+	mutex_unlock(lock);
+
+	*count = taken;
+
+	return ERROR_SUCCESS;
+}
+
+/* Call the device specific read method of a keyboard, setting the NON_BLOCK device flag if requested */
+static uint32_t input_keyboard_device_read(KEYBOARD_DEVICE *keyboard, void *buffer, uint32_t size, uint32_t flags, uint32_t *count)
+{
+	size_t argument2;
+	uint32_t status;
+	BOOL restore;
+
+	restore = FALSE;
+	if (flags & INPUT_FLAG_NON_BLOCK)
+	{
+		argument2 = 0;
+		keyboard_device_control(keyboard, KEYBOARD_CONTROL_GET_FLAG, KEYBOARD_FLAG_NON_BLOCK, &argument2);
+		if (!argument2)
+		{
+			/* Never fall back to a read that could block */
+			if (keyboard_device_control(keyboard, KEYBOARD_CONTROL_SET_FLAG, KEYBOARD_FLAG_NON_BLOCK, &argument2) != ERROR_SUCCESS)
+				return ERROR_NOT_SUPPORTED;
+			restore = TRUE;
+		}
+	}
+
+	status = keyboard->deviceread(keyboard, buffer, size, count);
+
+	if (restore)
+		keyboard_device_control(keyboard, KEYBOARD_CONTROL_CLEAR_FLAG, KEYBOARD_FLAG_NON_BLOCK, &argument2);
+
+	return status;
+}
+
+/* Call the device specific read method of a mouse, setting the NON_BLOCK device flag if requested */
+static uint32_t input_mouse_device_read(MOUSE_DEVICE *mouse, void *buffer, uint32_t size, uint32_t flags, uint32_t *count)
+{
+	size_t argument2;
+	uint32_t status;
+	BOOL restore;
+
+	restore = FALSE;
+	if (flags & INPUT_FLAG_NON_BLOCK)
+	{
+		argument2 = 0;
+		mouse_device_control(mouse, MOUSE_CONTROL_GET_FLAG, MOUSE_FLAG_NON_BLOCK, &argument2);
+		if (!argument2)
+		{
+			if (mouse_device_control(mouse, MOUSE_CONTROL_SET_FLAG, MOUSE_FLAG_NON_BLOCK, &argument2) != ERROR_SUCCESS)
+				return ERROR_NOT_SUPPORTED;
+			restore = TRUE;
+		}
+	}
+
+	status = mouse->deviceread(mouse, buffer, size, count);
+
+	if (restore)
+		mouse_device_control(mouse, MOUSE_CONTROL_CLEAR_FLAG, MOUSE_FLAG_NON_BLOCK, &argument2);
+
+	return status;
+}
+
+/* Merge consecutive mouse records with the same button state */
+static uint32_t input_mouse_coalesce(uint8_t *base, size_t stride, uint32_t count)
+{
+	uint32_t index;
+	uint32_t output;
+	int32_t value;
+	MOUSE_DATA *last;
+	MOUSE_DATA *current;
+
+	if (count < 2)
+		return count;
+
+	output = 1;
+	last = (MOUSE_DATA *)base;
+	for (index = 1; index < count; index++)
+	{
+		current = (MOUSE_DATA *)(base + (index * stride));
+
+		if (current->buttons == last->buttons)
+		{
+			/* Absolute values take the latest position, relative values are summed */
+			if (current->buttons & MOUSE_ABSOLUTE_X)
+				last->offsetx = current->offsetx;
+			else
+			{
+				value = last->offsetx + current->offsetx;
+				last->offsetx = (value > INT16_MAX) ? INT16_MAX : (value < INT16_MIN) ? INT16_MIN : value;
+			}
+
+			if (current->buttons & MOUSE_ABSOLUTE_Y)
+				last->offsety = current->offsety;
+			else
+			{
+				value = last->offsety + current->offsety;
+				last->offsety = (value > INT16_MAX) ? INT16_MAX : (value < INT16_MIN) ? INT16_MIN : value;
+			}
+
+			if (current->buttons & MOUSE_ABSOLUTE_WHEEL)
+				last->offsetwheel = current->offsetwheel;
+			else
+			{
+				value = last->offsetwheel + current->offsetwheel;
+				last->offsetwheel = (value > INT16_MAX) ? INT16_MAX : (value < INT16_MIN) ? INT16_MIN : value;
+			}
+
+			last->maximumx = current->maximumx;
+			last->maximumy = current->maximumy;
+			last->maximumwheel = current->maximumwheel;
+		}
+		else
+		{
+			/* Button change, start a new record */
+			last = (MOUSE_DATA *)(base + (output * stride));
+			if (last != current)
+				memcpy(last, current, sizeof(MOUSE_DATA));
+			output++;
+		}
+	}
+
+	return output;
+}
+
+/* Drop touch records that are superseded by the next record for the same point with the same state */
+static uint32_t input_touch_coalesce(uint8_t *base, size_t stride, uint32_t count)
+{
+	uint32_t index;
+	uint32_t output;
+	uint32_t slot;
+	uint32_t used;
+	TOUCH_DATA *current;
+	struct
+	{
+		uint16_t pointid;
+		uint32_t info;
+	} seen[16];
+
+	if (count < 2)
+		return count;
+
+	/* Walk backwards keeping the newest record of each run, packing kept records at the end */
+	used = 0;
+	output = count;
+	index = count;
+	while (index > 0)
+	{
+		index--;
+		current = (TOUCH_DATA *)(base + (index * stride));
+
+		for (slot = 0; slot < used; slot++)
+		{
+			if (seen[slot].pointid == current->pointid)
+				break;
+		}
+
+		if (slot < used && seen[slot].info == current->info)
+			continue;
+
+		if (slot == used && used < 16)
+		{
+			seen[slot].pointid = current->pointid;
+			used++;
+		}
+		if (slot < used)
+			seen[slot].info = current->info;
+
+		output--;
+		if (output != index)
+			memcpy(base + (output * stride), current, sizeof(TOUCH_DATA));
+	}
+
+	/* Move the kept records to the front */
+	if (output > 0)
+	{
+		for (index = 0; index < count - output; index++)
+			memcpy(base + (index * stride), base + ((output + index) * stride), sizeof(TOUCH_DATA));
+	}
+
+	return count - output;
+}
+
+/* Merge consecutive joystick records with the same button and hat state, keeping the latest axes */
+static uint32_t input_joystick_coalesce(uint8_t *base, size_t stride, uint32_t count)
+{
+	uint32_t index;
+	uint32_t output;
+	JOYSTICK_DATA *last;
+	JOYSTICK_DATA *current;
+
+	if (count < 2)
+		return count;
+
+	output = 1;
+	last = (JOYSTICK_DATA *)base;
+	for (index = 1; index < count; index++)
+	{
+		current = (JOYSTICK_DATA *)(base + (index * stride));
+
+		if (current->buttons != last->buttons || current->hatcount != last->hatcount || memcmp(current->hats, last->hats, sizeof(current->hats)) != 0)
+		{
+			last = (JOYSTICK_DATA *)(base + (output * stride));
+			output++;
+		}
+
+		if (last != current)
+			memcpy(last, current, sizeof(JOYSTICK_DATA));
+	}
+
+	return output;
+}
+
+/* Read all available keyboard records from a device in one locked copy
+ *
+ * The device must be in direct read mode (KEYBOARD_FLAG_DIRECT_READ), pass
+ * NULL to read from the global keyboard buffer instead.
+ */
+uint32_t STDCALL keyboard_device_read_all(KEYBOARD_DEVICE *keyboard, KEYBOARD_DATA *buffer, uint32_t len, uint32_t flags, uint32_t *count)
+{
+	uint32_t size;
+
+	if (buffer == NULL || count == NULL)
+		return ERROR_INVALID_PARAMETER;
+
+	*count = 0;
+	size = len * sizeof(KEYBOARD_DATA);
+
+	if (keyboard == NULL)
+		return keyboard_read_ex(buffer, size, (flags & INPUT_FLAG_NON_BLOCK) ? KEYBOARD_FLAG_NON_BLOCK : KEYBOARD_FLAG_NONE, count);
+
+	if (keyboard->device.signature != DEVICE_SIGNATURE)
+		return ERROR_INVALID_PARAMETER;
+
+	if (keyboard->deviceread != NULL)
+		return input_keyboard_device_read(keyboard, buffer, size, flags, count);
+
+	return input_buffer_drain(keyboard->lock, keyboard->buffer.wait, &keyboard->buffer.start, &keyboard->buffer.count,
+		keyboard->buffer.buffer, KEYBOARD_BUFFER_SIZE, sizeof(KEYBOARD_DATA), buffer, sizeof(KEYBOARD_DATA), len,
+		(flags & INPUT_FLAG_NON_BLOCK) ? 0 : INFINITE, count);
+}
+
+/* Read all available mouse records from a device in one locked copy
+ *
+ * The device must be in direct read mode (MOUSE_FLAG_DIRECT_READ), pass NULL
+ * to read from the global mouse buffer instead. If INPUT_FLAG_COALESCE is set
+ * consecutive records with the same buttons are merged before returning.
+ */
+uint32_t STDCALL mouse_device_read_all(MOUSE_DEVICE *mouse, MOUSE_DATA *buffer, uint32_t len, uint32_t flags, uint32_t *count)
+{
+	uint32_t size;
+	uint32_t status;
+
+	if (buffer == NULL || count == NULL)
+		return ERROR_INVALID_PARAMETER;
+
+	*count = 0;
+	size = len * sizeof(MOUSE_DATA);
+
+	if (mouse == NULL)
+		status = mouse_read_ex(buffer, size, (flags & INPUT_FLAG_NON_BLOCK) ? MOUSE_FLAG_NON_BLOCK : MOUSE_FLAG_NONE, count);
+	else if (mouse->device.signature != DEVICE_SIGNATURE)
+		return ERROR_INVALID_PARAMETER;
+	else if (mouse->deviceread != NULL)
+		status = input_mouse_device_read(mouse, buffer, size, flags, count);
+	else
+		status = input_buffer_drain(mouse->lock, mouse->buffer.wait, &mouse->buffer.start, &mouse->buffer.count,
+			mouse->buffer.buffer, MOUSE_BUFFER_SIZE, sizeof(MOUSE_DATA), buffer, sizeof(MOUSE_DATA), len,
+			(flags & INPUT_FLAG_NON_BLOCK) ? 0 : INFINITE, count);
+
+	if (status == ERROR_SUCCESS && (flags & INPUT_FLAG_COALESCE))
+		*count = input_mouse_coalesce((uint8_t *)buffer, sizeof(MOUSE_DATA), *count);
+
+	return status;
+}
+
+/* Read all available touch records from a device in one locked copy
+ *
+ * If INPUT_FLAG_COALESCE is set only the newest record of each run of records
+ * with the same point and touch state is returned.
+ */
+uint32_t STDCALL touch_device_read_all(TOUCH_DEVICE *touch, TOUCH_DATA *buffer, uint32_t len, uint32_t flags, uint32_t *count)
+{
+	uint32_t status;
+
+	if (touch == NULL || buffer == NULL || count == NULL)
+		return ERROR_INVALID_PARAMETER;
+
+	*count = 0;
+
+	if (touch->device.signature != DEVICE_SIGNATURE)
+		return ERROR_INVALID_PARAMETER;
+
+	if (touch->deviceread != NULL)
+		status = touch->deviceread(touch, buffer, len * sizeof(TOUCH_DATA), (flags & INPUT_FLAG_NON_BLOCK) ? TOUCH_FLAG_NON_BLOCK : TOUCH_FLAG_NONE, count);
+	else
+		status = input_buffer_drain(touch->lock, touch->buffer.wait, &touch->buffer.start, &touch->buffer.count,
+			touch->buffer.buffer, TOUCH_BUFFER_SIZE, sizeof(TOUCH_DATA), buffer, sizeof(TOUCH_DATA), len,
+			(flags & INPUT_FLAG_NON_BLOCK) ? 0 : INFINITE, count);
+
+	if (status == ERROR_SUCCESS && (flags & INPUT_FLAG_COALESCE))
+		*count = input_touch_coalesce((uint8_t *)buffer, sizeof(TOUCH_DATA), *count);
+
+	return status;
+}
+
+/* Read all available joystick records from a device in one locked copy
+ *
+ * If INPUT_FLAG_COALESCE is set consecutive records with the same button and
+ * hat state are merged, keeping the latest axis values.
+ */
+uint32_t STDCALL joystick_device_read_all(JOYSTICK_DEVICE *joystick, JOYSTICK_DATA *buffer, uint32_t len, uint32_t flags, uint32_t *count)
+{
+	uint32_t status;
+
+	if (joystick == NULL || buffer == NULL || count == NULL)
+		return ERROR_INVALID_PARAMETER;
+
+	*count = 0;
+
+	if (joystick->device.signature != DEVICE_SIGNATURE)
+		return ERROR_INVALID_PARAMETER;
+
+	if (joystick->deviceread != NULL)
+		status = joystick->deviceread(joystick, buffer, len * sizeof(JOYSTICK_DATA), (flags & INPUT_FLAG_NON_BLOCK) ? JOYSTICK_FLAG_NON_BLOCK : JOYSTICK_FLAG_NONE, count);
+	else
+		status = input_buffer_drain(joystick->lock, joystick->buffer.wait, &joystick->buffer.start, &joystick->buffer.count,
+			joystick->buffer.buffer, JOYSTICK_BUFFER_SIZE, sizeof(JOYSTICK_DATA), buffer, sizeof(JOYSTICK_DATA), len,
+			(flags & INPUT_FLAG_NON_BLOCK) ? 0 : INFINITE, count);
+
+	if (status == ERROR_SUCCESS && (flags & INPUT_FLAG_COALESCE))
+		*count = input_joystick_coalesce((uint8_t *)buffer, sizeof(JOYSTICK_DATA), *count);
+
+	return status;
+}
+
+/* Drain one input set entry into a strided INPUT_EVENT array */
+static uint32_t input_set_entry_drain(INPUT_SET_ENTRY *entry, INPUT_EVENT *events, uint32_t len, uint32_t flags, uint32_t *count)
+{
+	uint32_t index;
+	uint32_t status;
+
+	switch (entry->inputtype)
+	{
+		case INPUT_TYPE_KEYBOARD:
+		{
+			KEYBOARD_DEVICE *keyboard = (KEYBOARD_DEVICE *)entry->device;
+			status = input_buffer_drain(keyboard->lock, keyboard->buffer.wait, &keyboard->buffer.start, &keyboard->buffer.count,
+				keyboard->buffer.buffer, KEYBOARD_BUFFER_SIZE, sizeof(KEYBOARD_DATA), &events->data.keyboard, sizeof(INPUT_EVENT), len, 0, count);
+			break;
+		}
+		case INPUT_TYPE_MOUSE:
+		{
+			MOUSE_DEVICE *mouse = (MOUSE_DEVICE *)entry->device;
+			status = input_buffer_drain(mouse->lock, mouse->buffer.wait, &mouse->buffer.start, &mouse->buffer.count,
+				mouse->buffer.buffer, MOUSE_BUFFER_SIZE, sizeof(MOUSE_DATA), &events->data.mouse, sizeof(INPUT_EVENT), len, 0, count);
+			if (status == ERROR_SUCCESS && (flags & INPUT_FLAG_COALESCE))
+				*count = input_mouse_coalesce((uint8_t *)&events->data.mouse, sizeof(INPUT_EVENT), *count);
+			break;
+		}
+		case INPUT_TYPE_TOUCH:
+		{
+			TOUCH_DEVICE *touch = (TOUCH_DEVICE *)entry->device;
+			status = input_buffer_drain(touch->lock, touch->buffer.wait, &touch->buffer.start, &touch->buffer.count,
+				touch->buffer.buffer, TOUCH_BUFFER_SIZE, sizeof(TOUCH_DATA), &events->data.touch, sizeof(INPUT_EVENT), len, 0, count);
+			if (status == ERROR_SUCCESS && (flags & INPUT_FLAG_COALESCE))
+				*count = input_touch_coalesce((uint8_t *)&events->data.touch, sizeof(INPUT_EVENT), *count);
+			break;
+		}
+		case INPUT_TYPE_JOYSTICK:
+		{
+			JOYSTICK_DEVICE *joystick = (JOYSTICK_DEVICE *)entry->device;
+			status = input_buffer_drain(joystick->lock, joystick->buffer.wait, &joystick->buffer.start, &joystick->buffer.count,
+				joystick->buffer.buffer, JOYSTICK_BUFFER_SIZE, sizeof(JOYSTICK_DATA), &events->data.joystick, sizeof(INPUT_EVENT), len, 0, count);
+			if (status == ERROR_SUCCESS && (flags & INPUT_FLAG_COALESCE))
+				*count = input_joystick_coalesce((uint8_t *)&events->data.joystick, sizeof(INPUT_EVENT), *count);
+			break;
+		}
+		default:
+			return ERROR_INVALID_PARAMETER;
+	}
+
+	for (index = 0; index < *count; index++)
+	{
+		events[index].inputtype = entry->inputtype;
+		events[index].device = entry->device;
+	}
+
+	return status;
+}
+
+/* Switch a keyboard or mouse to direct read mode, or restore the mode it had before it was added */
+static void input_set_entry_direct_read(INPUT_SET_ENTRY *entry, BOOL enable)
+{
+	size_t argument2;
+
+	switch (entry->inputtype)
+	{
+		case INPUT_TYPE_KEYBOARD:
+			if (enable)
+			{
+				/* Leave the flag alone if someone else already set it */
+				argument2 = 0;
+				keyboard_device_control((KEYBOARD_DEVICE *)entry->device, KEYBOARD_CONTROL_GET_FLAG, KEYBOARD_FLAG_DIRECT_READ, &argument2);
+				if (argument2)
+					return;
+
+				if (keyboard_device_control((KEYBOARD_DEVICE *)entry->device, KEYBOARD_CONTROL_SET_FLAG, KEYBOARD_FLAG_DIRECT_READ, &argument2) == ERROR_SUCCESS)
+					entry->directread = TRUE;
+			}
+			else if (entry->directread)
+			{
+				keyboard_device_control((KEYBOARD_DEVICE *)entry->device, KEYBOARD_CONTROL_CLEAR_FLAG, KEYBOARD_FLAG_DIRECT_READ, &argument2);
+				entry->directread = FALSE;
+			}
+			break;
+		case INPUT_TYPE_MOUSE:
+			if (enable)
+			{
+				argument2 = 0;
+				mouse_device_control((MOUSE_DEVICE *)entry->device, MOUSE_CONTROL_GET_FLAG, MOUSE_FLAG_DIRECT_READ, &argument2);
+				if (argument2)
+					return;
+
+				if (mouse_device_control((MOUSE_DEVICE *)entry->device, MOUSE_CONTROL_SET_FLAG, MOUSE_FLAG_DIRECT_READ, &argument2) == ERROR_SUCCESS)
+					entry->directread = TRUE;
+			}
+			else if (entry->directread)
+			{
+				mouse_device_control((MOUSE_DEVICE *)entry->device, MOUSE_CONTROL_CLEAR_FLAG, MOUSE_FLAG_DIRECT_READ, &argument2);
+				entry->directread = FALSE;
+			}
+			break;
+	}
+}
+
+/* Wait thread for one device in an input set */
+static ssize_t STDCALL input_set_entry_execute(void *parameter)
+{
+	INPUT_SET_ENTRY *entry = (INPUT_SET_ENTRY *)parameter;
+
+	while (!entry->terminate)
+	{
+		/* Wait for data on the device (Or the extra count signaled by input_set_remove) */
+		if (semaphore_wait(entry->wait) != ERROR_SUCCESS)
+			break;
+
+		/* Return the count so the reader sees every record */
+		semaphore_signal(entry->wait);
+
+		if (entry->terminate)
+			break;
+
+		/* Notify the set and wait until the reader has drained this device (Or the entry is removed) */
+		entry->pending = TRUE;
+		event_set(entry->set->ready);
+
+		while (entry->pending && !entry->terminate)
+			event_wait(entry->rearm);
+	}
+
+	completion_complete(entry->done);
+
+	return 0;
+}
+
+/* Create a new empty input set */
+INPUT_SET * STDCALL input_set_create(void)
+{
+	INPUT_SET *set;
+
+	set = calloc(1, sizeof(INPUT_SET));
+	if (set == NULL)
+		return NULL;
+
+	set->lock = mutex_create();
+	set->ready = event_create(FALSE, FALSE);
+	if (set->lock == INVALID_HANDLE_VALUE || set->ready == INVALID_HANDLE_VALUE)
+	{
+		if (set->lock != INVALID_HANDLE_VALUE)
+			mutex_destroy(set->lock);
+		if (set->ready != INVALID_HANDLE_VALUE)
+			event_destroy(set->ready);
+		free(set);
+
+		return NULL;
+	}
+
+	return set;
+}
+
+/* Remove all devices from an input set and destroy it */
+uint32_t STDCALL input_set_destroy(INPUT_SET *set)
+{
+	if (set == NULL)
+		return ERROR_INVALID_PARAMETER;
+
+	while (set->count > 0)
+		input_set_remove(set, set->entries[set->count - 1]->device);
+
+	event_destroy(set->ready);
+	mutex_destroy(set->lock);
+	free(set);
+
+	return ERROR_SUCCESS;
+}
+
+/* Add a keyboard, mouse, touch or joystick device to an input set
+ *
+ * Keyboard and mouse devices are switched to direct read mode so their data
+ * is delivered to the device buffer instead of the global buffer, the mode is
+ * restored when the device is removed unless it was already set when added.
+ *
+ * Devices with a device specific read method return ERROR_NOT_SUPPORTED, while
+ * a device is in a set it must only be read through the set.
+ */
+uint32_t STDCALL input_set_add(INPUT_SET *set, uint32_t inputtype, void *device)
+{
+	uint32_t index;
+	BOOL custom;
+	INPUT_SET_ENTRY *entry;
+
+	if (set == NULL || device == NULL)
+		return ERROR_INVALID_PARAMETER;
+
+	if (((DEVICE *)device)->signature != DEVICE_SIGNATURE)
+		return ERROR_INVALID_PARAMETER;
+
+	entry = calloc(1, sizeof(INPUT_SET_ENTRY));
+	if (entry == NULL)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	entry->set = set;
+	entry->inputtype = inputtype;
+	entry->device = device;
+
+	switch (inputtype)
+	{
+		case INPUT_TYPE_KEYBOARD:
+			entry->wait = ((KEYBOARD_DEVICE *)device)->buffer.wait;
+			custom = (((KEYBOARD_DEVICE *)device)->deviceread != NULL);
+			break;
+		case INPUT_TYPE_MOUSE:
+			entry->wait = ((MOUSE_DEVICE *)device)->buffer.wait;
+			custom = (((MOUSE_DEVICE *)device)->deviceread != NULL);
+			break;
+		case INPUT_TYPE_TOUCH:
+			entry->wait = ((TOUCH_DEVICE *)device)->buffer.wait;
+			custom = (((TOUCH_DEVICE *)device)->deviceread != NULL);
+			break;
+		case INPUT_TYPE_JOYSTICK:
+			entry->wait = ((JOYSTICK_DEVICE *)device)->buffer.wait;
+			custom = (((JOYSTICK_DEVICE *)device)->deviceread != NULL);
+			break;
+		default:
+			free(entry);
+			return ERROR_INVALID_PARAMETER;
+	}
+
+	/* The set waits on and drains the device buffer, which a device specific read method does not use */
+	if (custom)
+	{
+		free(entry);
+		return ERROR_NOT_SUPPORTED;
+	}
+
+	if (mutex_lock(set->lock) != ERROR_SUCCESS)
+	{
+		free(entry);
+		return ERROR_CAN_NOT_COMPLETE;
+	}
+
+	for (index = 0; index < set->count; index++)
+	{
+		if (set->entries[index]->device == device)
+		{
+			mutex_unlock(set->lock);
+			free(entry);
+			return ERROR_ALREADY_EXISTS;
+		}
+	}
+
+	if (set->count >= INPUT_SET_MAX_DEVICES)
+	{
+		mutex_unlock(set->lock);
+		free(entry);
+		return ERROR_INSUFFICIENT_BUFFER;
+	}
+
+	entry->rearm = event_create(FALSE, FALSE);
+	entry->done = completion_create(COMPLETION_FLAG_NONE);
+	entry->thread = begin_thread(NULL, INPUT_THREAD_STACK_SIZE, input_set_entry_execute, entry, THREAD_CREATE_NONE, &entry->thread);
+	if (entry->thread == INVALID_HANDLE_VALUE)
+	{
+		mutex_unlock(set->lock);
+		event_destroy(entry->rearm);
+		completion_destroy(entry->done);
+		free(entry);
+		return ERROR_OPERATION_FAILED;
+	}
+
+	thread_set_name(entry->thread, INPUT_THREAD_NAME);
+	thread_set_priority(entry->thread, INPUT_THREAD_PRIORITY);
+
+	input_set_entry_direct_read(entry, TRUE);
+
+	set->entries[set->count] = entry;
+	set->count++;
+
+	mutex_unlock(set->lock);
+
+	return ERROR_SUCCESS;
+}
+
+/* Remove a device from an input set, waiting for its wait thread to exit */
+uint32_t STDCALL input_set_remove(INPUT_SET *set, void *device)
+{
+	uint32_t index;
+	INPUT_SET_ENTRY *entry;
+
+	if (set == NULL || device == NULL)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(set->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	entry = NULL;
+	for (index = 0; index < set->count; index++)
+	{
+		if (set->entries[index]->device == device)
+		{
+			entry = set->entries[index];
+
+			set->count--;
+			memmove(&set->entries[index], &set->entries[index + 1], (set->count - index) * sizeof(INPUT_SET_ENTRY *));
+			set->entries[set->count] = NULL;
+			break;
+		}
+	}
+
+	if (set->next >= set->count)
+		set->next = 0;
+
+	mutex_unlock(set->lock);
+
+	if (entry == NULL)
+		return ERROR_NOT_FOUND;
+
+	/* Wake the wait thread wherever it is blocked, the extra count is taken back once it has exited */
+	entry->terminate = TRUE;
+	event_set(entry->rearm);
+	semaphore_signal(entry->wait);
+	completion_wait(entry->done, INFINITE);
+	semaphore_wait(entry->wait);
+
+	input_set_entry_direct_read(entry, FALSE);
+
+	event_destroy(entry->rearm);
+	completion_destroy(entry->done);
+	free(entry);
+
+	return ERROR_SUCCESS;
+}
+
+/* Wait until any device in an input set has data available */
+uint32_t STDCALL input_set_wait(INPUT_SET *set, uint32_t timeout)
+{
+	uint32_t index;
+	uint32_t status;
+	uint32_t remaining;
+	uint64_t elapsed;
+	uint64_t start;
+	BOOL pending;
+
+	if (set == NULL)
+		return ERROR_INVALID_PARAMETER;
+
+	start = get_tick_count64();
+	remaining = timeout;
+
+	while (1)
+	{
+		/* Entries are freed by input_set_remove, only look at them under the lock */
+		if (mutex_lock(set->lock) != ERROR_SUCCESS)
+			return ERROR_CAN_NOT_COMPLETE;
+
+		pending = FALSE;
+		for (index = 0; index < set->count; index++)
+		{
+			if (set->entries[index]->pending)
+			{
+				pending = TRUE;
+				break;
+			}
+		}
+
+		mutex_unlock(set->lock);
+
+		if (pending)
+			return ERROR_SUCCESS;
+
+		if (remaining == 0)
+			return ERROR_WAIT_TIMEOUT;
+
+		status = event_wait_ex(set->ready, remaining);
+		if (status != ERROR_SUCCESS)
+			return status;
+
+		/* Recheck after wakeup, another reader may have taken the data so only wait for what is left of the timeout */
+		if (timeout != INFINITE)
+		{
+			elapsed = get_tick_count64() - start;
+			remaining = (elapsed >= timeout) ? 0 : (uint32_t)(timeout - elapsed);
+		}
+	}
+}
+
+/* Read events from all devices in an input set
+ *
+ * Each device that has data is drained in a single locked copy, devices are
+ * visited in round robin order so one busy device cannot starve the others.
+ * If INPUT_FLAG_NON_BLOCK is set the timeout is ignored and the call returns
+ * ERROR_NO_MORE_ITEMS immediately when no device has data.
+ */
+uint32_t STDCALL input_set_read(INPUT_SET *set, INPUT_EVENT *events, uint32_t len, uint32_t flags, uint32_t timeout, uint32_t *count)
+{
+	uint32_t index;
+	uint32_t visited;
+	uint32_t status;
+	uint32_t drained;
+	INPUT_SET_ENTRY *entry;
+
+	if (set == NULL || events == NULL || count == NULL || len == 0)
+		return ERROR_INVALID_PARAMETER;
+
+	*count = 0;
+
+	if (!(flags & INPUT_FLAG_NON_BLOCK))
+	{
+		status = input_set_wait(set, timeout);
+		if (status != ERROR_SUCCESS)
+			return status;
+	}
+
+	if (mutex_lock(set->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	index = set->next;
+	for (visited = 0; visited < set->count && *count < len; visited++)
+	{
+		entry = set->entries[index];
+
+		if (input_set_entry_drain(entry, &events[*count], len - *count, flags, &drained) == ERROR_SUCCESS)
+			*count += drained;
+
+		/* Release the wait thread if it is parked on this device */
+		if (entry->pending)
+		{
+			entry->pending = FALSE;
+			event_set(entry->rearm);
+		}
+
+		index = (index + 1) % set->count;
+	}
+	set->next = index;
+
+	mutex_unlock(set->lock);
+
+	return (*count > 0) ? ERROR_SUCCESS : ERROR_NO_MORE_ITEMS;
+}
+
+/* Merge consecutive mouse records with the same buttons, returns the new count */
+uint32_t STDCALL mouse_data_coalesce(MOUSE_DATA *buffer, uint32_t count)
+{
+	if (buffer == NULL)
+		return 0;
+
+	return input_mouse_coalesce((uint8_t *)buffer, sizeof(MOUSE_DATA), count);
+}
+
+/* Remove superseded touch records, returns the new count */
+uint32_t STDCALL touch_data_coalesce(TOUCH_DATA *buffer, uint32_t count)
+{
+	if (buffer == NULL)
+		return 0;
+
+	return input_touch_coalesce((uint8_t *)buffer, sizeof(TOUCH_DATA), count);
+}
+
+/* Merge consecutive joystick records with the same buttons and hats, returns the new count */
+uint32_t STDCALL joystick_data_coalesce(JOYSTICK_DATA *buffer, uint32_t count)
+{
+	if (buffer == NULL)
+		return 0;
+
+	return input_joystick_coalesce((uint8_t *)buffer, sizeof(JOYSTICK_DATA), count);
+}
+
+/* Return the name of an input type */
+uint32_t STDCALL input_type_to_string(uint32_t inputtype, char *string, uint32_t len)
+{
+	const char *name;
+
+	switch (inputtype)
+	{
+		case INPUT_TYPE_KEYBOARD:
+			name = "INPUT_TYPE_KEYBOARD";
+			break;
+		case INPUT_TYPE_MOUSE:
+			name = "INPUT_TYPE_MOUSE";
+			break;
+		case INPUT_TYPE_TOUCH:
+			name = "INPUT_TYPE_TOUCH";
+			break;
+		case INPUT_TYPE_JOYSTICK:
+			name = "INPUT_TYPE_JOYSTICK";
+			break;
+		default:
+			name = "INPUT_TYPE_NONE";
+	}
+
+	if (string != NULL && len > 0)
+	{
+		strncpy(string, name, len - 1);
+		string[len - 1] = '\0';
+	}
+
+	return strlen(name);
+}
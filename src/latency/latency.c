@@ -0,0 +1,1420 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/devices.h"
+#include "ultibo/gpio.h"
+#include "ultibo/latency.h"
+
+/* Implementation of the interrupt latency and jitter measurement suite for Ultibo API
+ *
+ * Each test raises an event at a known time and records how long it takes for the
+ * event to be observed in a histogram, all times are taken from clock_get_total
+ * whose rate is measured against clock_microseconds when a run starts.
+ *
+ *  Timer       Repeating timer device event with TIMER_EVENT_FLAG_INTERRUPT, the
+ *              deviation of each event from the programmed interval is recorded.
+ *  Timer Wake  The same timer event signals a semaphore, the time until a critical
+ *              priority thread waiting on the semaphore runs is recorded.
+ *  IPI         A thread signals a semaphore waited on by a thread on another CPU,
+ *              the time until that thread runs is recorded. There is no interface
+ *              for sending an inter processor interrupt directly so this measures
+ *              the cross CPU wakeup path that the scheduler uses it for.
+ *  GPIO        An output pin is set high, the time until the input event callback
+ *              for the connected pin is called is recorded. Without a GPIO device
+ *              a virtual loopback device is registered with pins connected in pairs,
+ *              events are dispatched from the worker pool (or directly with
+ *              LATENCY_FLAG_GPIO_INTERRUPT) in the same way as the hardware drivers.
+ *  Worker      The timer event calls worker_schedule_irq, the time until the task
+ *              starts on a worker thread is recorded.
+ *
+ * Histograms have 8 linear buckets for each power of 2 nanoseconds so percentiles
+ * are accurate to within 12.5 percent while covering up to 4 seconds. The clock
+ * counter rate limits the resolution, on some boards it is only 1MHz.
+ *
+ * While each test runs a load thread is started on every CPU except the measuring
+ * CPU, if there is only one CPU the loads run on that CPU at a lower priority than
+ * the measuring threads.
+ */
+
+/* Latency Load (One per load thread) */
+typedef struct _LATENCY_LOAD LATENCY_LOAD;
+struct _LATENCY_LOAD
+{
+	uint32_t load; // The load generated by this thread (eg LATENCY_LOAD_CPU)
+	uint32_t cpu; // The CPU this thread is bound to
+	uint32_t count; // Number of iterations completed
+};
+
+/* Latency Context (One per test pass) */
+typedef struct _LATENCY_CONTEXT LATENCY_CONTEXT;
+struct _LATENCY_CONTEXT
+{
+	uint32_t test; // The test being run (eg LATENCY_TEST_TIMER)
+	volatile BOOL stopping;
+	volatile uint32_t pending; // Non zero while an event is outstanding
+	int64_t endtime; // Time when the test ends (Microseconds)
+	int64_t period; // Expected interval between timer events (Clock counts)
+	int64_t last; // Time of the previous timer event (Clock counts)
+	volatile int64_t stamp; // Time the current event was raised (Clock counts)
+	uint32_t interval; // Interval between events (Microseconds)
+	uint32_t cpu; // CPU for the measuring threads
+	uint32_t status; // Result of the pass when run by a thread
+	SEMAPHORE_HANDLE signal; // Signalled when an event is raised
+	SEMAPHORE_HANDLE ack; // Signalled when an event has been observed
+	SEMAPHORE_HANDLE done; // Signalled by each thread of the pass when it exits
+	LATENCY_HISTOGRAM *primary; // Histogram for the test
+	LATENCY_HISTOGRAM *secondary; // Histogram for the timer wake test (Timer pass only)
+	GPIO_DEVICE *gpio;
+	uint32_t outputpin;
+	uint32_t inputpin;
+	uint32_t gpioflags;
+};
+
+/* Latency Loopback Pin */
+typedef struct _LATENCY_LOOPBACK_PIN LATENCY_LOOPBACK_PIN;
+struct _LATENCY_LOOPBACK_PIN
+{
+	uint32_t pin;
+	uint32_t level; // Current level of the pin (eg GPIO_LEVEL_HIGH)
+	uint32_t trigger; // Trigger of the registered event (or GPIO_TRIGGER_NONE)
+	uint32_t flags; // Flags of the registered event (eg GPIO_EVENT_FLAG_REPEAT)
+	gpio_event_cb callback; // Callback of the registered event (or NULL if none)
+	void *data;
+};
+
+/* Latency Loopback Event (A triggered event waiting to be dispatched) */
+typedef struct _LATENCY_LOOPBACK_EVENT LATENCY_LOOPBACK_EVENT;
+struct _LATENCY_LOOPBACK_EVENT
+{
+	gpio_event_cb callback;
+	void *data;
+	uint32_t pin;
+	uint32_t trigger;
+	uint32_t flags;
+};
+
+/* Latency Loopback (Virtual GPIO device) */
+typedef struct _LATENCY_LOOPBACK LATENCY_LOOPBACK;
+struct _LATENCY_LOOPBACK
+{
+	GPIO_DEVICE gpio; // GPIO device (Must be first)
+	LATENCY_LOOPBACK_PIN pins[LATENCY_LOOPBACK_PIN_COUNT];
+};
+
+/* Latency State */
+typedef struct _LATENCY_STATE LATENCY_STATE;
+struct _LATENCY_STATE
+{
+	MUTEX_HANDLE lock; // Lock for runs and load start/stop
+	uint64_t clockrate; // Measured rate of clock_get_total (Counts per second)
+	uint64_t nanoscale; // Nanoseconds per clock count (16.16 fixed point)
+	volatile BOOL loading; // Load threads run while set
+	uint32_t loadmask; // Loads currently running
+	uint32_t loadcount; // Number of load threads
+	LATENCY_LOAD *loads; // One per load thread
+	SEMAPHORE_HANDLE loaddone; // Signalled by each load thread when it exits
+	LATENCY_CONTEXT context; // Context of the current test pass (Not on the stack so a late worker task or callback is harmless)
+};
+
+static LATENCY_STATE latency = {INVALID_HANDLE_VALUE};
+
+/* ============================================================================== */
+/* Latency Internal Functions */
+static uint32_t latency_create_lock(void)
+{
+	MUTEX_HANDLE lock;
+
+	if (latency.lock != INVALID_HANDLE_VALUE)
+		return ERROR_SUCCESS;
+
+	lock = mutex_create();
+	if (lock == INVALID_HANDLE_VALUE)
+		return ERROR_OPERATION_FAILED;
+
+	if (!__sync_bool_compare_and_swap(&latency.lock, INVALID_HANDLE_VALUE, lock))
+		mutex_destroy(lock);
+
+	return ERROR_SUCCESS;
+}
+
+/* Measure the rate of the clock counter */
+static void latency_calibrate(void)
+{
+	int64_t starttotal;
+	int64_t endtotal;
+	int64_t starttime;
+	int64_t endtime;
+
+	starttotal = clock_get_total();
+	starttime = clock_microseconds();
+
+	thread_sleep(LATENCY_CALIBRATE_TIME);
+
+	endtotal = clock_get_total();
+	endtime = clock_microseconds();
+
+	if (endtime <= starttime || endtotal <= starttotal)
+		latency.clockrate = 1000000;
+	else
+		latency.clockrate = ((uint64_t)(endtotal - starttotal) * 1000000) / (uint64_t)(endtime - starttime);
+
+	latency.nanoscale = (1000000000ULL << 16) / latency.clockrate;
+}
+
+static uint32_t latency_counts_to_ns(int64_t counts)
+{
+	uint64_t value;
+
+	if (counts <= 0)
+		return 0;
+
+	value = ((uint64_t)counts * latency.nanoscale) >> 16;
+	if (value > 0xFFFFFFFF)
+		return 0xFFFFFFFF;
+
+	return (uint32_t)value;
+}
+
+static uint32_t latency_bucket_index(uint32_t value)
+{
+	uint32_t exponent;
+
+	if (value < LATENCY_SUB_BUCKETS)
+		return value;
+
+	exponent = 31 - __builtin_clz(value);
+
+	return ((exponent - LATENCY_SUB_BUCKET_BITS + 1) << LATENCY_SUB_BUCKET_BITS) + ((value >> (exponent - LATENCY_SUB_BUCKET_BITS)) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+/* Return the largest value that falls in a bucket */
+static uint32_t latency_bucket_limit(uint32_t index)
+{
+	uint32_t shift;
+
+	if (index < LATENCY_SUB_BUCKETS)
+		return index;
+
+	shift = (index >> LATENCY_SUB_BUCKET_BITS) - 1;
+
+	return ((LATENCY_SUB_BUCKETS + (index & (LATENCY_SUB_BUCKETS - 1))) << shift) + ((1U << shift) - 1);
+}
+
+static void latency_delay(uint32_t interval)
+{
+	if (interval >= 1000)
+		thread_sleep(interval / 1000);
+	else
+		thread_yield();
+}
+
+static THREAD_HANDLE latency_thread_start(thread_start_proc proc, uint32_t priority, uint32_t cpu, void *parameter)
+{
+	return thread_create_ex(proc, LATENCY_THREAD_STACK_SIZE, priority, 1 << cpu, cpu, LATENCY_THREAD_NAME, parameter);
+}
+
+/* ============================================================================== */
+/* Latency Load Functions */
+static void latency_load_cpu(LATENCY_LOAD *load)
+{
+	volatile double value = 1.0;
+	volatile uint32_t state = 2463534242U;
+	uint32_t index;
+
+	while (latency.loading)
+	{
+		for (index = 0; index < 10000; index++)
+		{
+			value = value * 1.0000001 + 0.5;
+			if (value > 1000000.0)
+				value = 1.0;
+
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+		}
+
+		load->count++;
+	}
+}
+
+static void latency_load_memory(LATENCY_LOAD *load)
+{
+	uint8_t *source;
+	uint8_t *dest;
+
+	source = malloc(LATENCY_MEMORY_LOAD_SIZE);
+	dest = malloc(LATENCY_MEMORY_LOAD_SIZE);
+	if (source && dest)
+	{
+		memset(source, 0x55, LATENCY_MEMORY_LOAD_SIZE);
+
+		while (latency.loading)
+		{
+			memcpy(dest, source, LATENCY_MEMORY_LOAD_SIZE);
+			memset(source, (uint8_t)load->count, LATENCY_MEMORY_LOAD_SIZE);
+
+			load->count++;
+		}
+	}
+
+	free(source);
+	free(dest);
+}
+
+static void latency_load_network(LATENCY_LOAD *load)
+{
+	struct sockaddr_in address;
+	char buffer[LATENCY_NETWORK_LOAD_SIZE];
+	int handle;
+
+	handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (handle < 0)
+		return;
+
+	memset(buffer, 0xAA, sizeof(buffer));
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(LATENCY_NETWORK_LOAD_PORT);
+	address.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+	while (latency.loading)
+	{
+		/* Back off if the network stack is out of buffers */
+		if (sendto(handle, buffer, sizeof(buffer), 0, (struct sockaddr *)&address, sizeof(address)) < 0)
+			thread_sleep(1);
+
+		load->count++;
+	}
+
+	close(handle);
+}
+
+static ssize_t STDCALL latency_load_execute(void *parameter)
+{
+	LATENCY_LOAD *load = (LATENCY_LOAD *)parameter;
+
+	switch (load->load)
+	{
+		case LATENCY_LOAD_CPU:
+			latency_load_cpu(load);
+			break;
+		case LATENCY_LOAD_MEMORY:
+			latency_load_memory(load);
+			break;
+		case LATENCY_LOAD_NETWORK:
+			latency_load_network(load);
+			break;
+	}
+
+	semaphore_signal(latency.loaddone);
+
+	return 0;
+}
+
+/* Start load threads, caller must hold the latency lock */
+static uint32_t latency_load_begin(uint32_t loads, uint32_t affinity)
+{
+	uint32_t cpus[32];
+	uint32_t types[3];
+	uint32_t cpucount;
+	uint32_t typecount;
+	uint32_t count;
+	uint32_t index;
+	uint32_t cpu;
+
+	if (latency.loading)
+		return ERROR_ALREADY_EXISTS;
+
+	loads &= LATENCY_LOAD_ALL;
+	if (loads == LATENCY_LOAD_NONE)
+		return ERROR_SUCCESS;
+
+	cpucount = 0;
+	for (cpu = 0; cpu < cpu_get_count() && cpu < 32; cpu++)
+	{
+		if (affinity & (1U << cpu))
+			cpus[cpucount++] = cpu;
+	}
+	if (cpucount == 0)
+		return ERROR_INVALID_PARAMETER;
+
+	typecount = 0;
+	if (loads & LATENCY_LOAD_CPU)
+		types[typecount++] = LATENCY_LOAD_CPU;
+	if (loads & LATENCY_LOAD_MEMORY)
+		types[typecount++] = LATENCY_LOAD_MEMORY;
+	if (loads & LATENCY_LOAD_NETWORK)
+		types[typecount++] = LATENCY_LOAD_NETWORK;
+
+	/* One thread on each CPU, with extra threads if there are more load types than CPUs */
+	count = (cpucount > typecount) ? cpucount : typecount;
+
+	latency.loads = calloc(count, sizeof(LATENCY_LOAD));
+	if (!latency.loads)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	latency.loaddone = semaphore_create(0);
+	if (latency.loaddone == INVALID_HANDLE_VALUE)
+	{
+		free(latency.loads);
+		latency.loads = NULL;
+		return ERROR_OPERATION_FAILED;
+	}
+
+	latency.loading = TRUE;
+	latency.loadcount = 0;
+	for (index = 0; index < count; index++)
+	{
+		LATENCY_LOAD *load = &latency.loads[index];
+
+		load->load = types[index % typecount];
+		load->cpu = cpus[index % cpucount];
+
+		if (thread_create_ex(latency_load_execute, LATENCY_THREAD_STACK_SIZE, LATENCY_LOAD_THREAD_PRIORITY, 1 << load->cpu, load->cpu, LATENCY_LOAD_THREAD_NAME, load) == INVALID_HANDLE_VALUE)
+			break;
+
+		latency.loadcount++;
+	}
+
+	latency.loadmask = loads;
+
+	return ERROR_SUCCESS;
+}
+
+/* Stop load threads, caller must hold the latency lock */
+static uint32_t latency_load_end(void)
+{
+	uint32_t index;
+
+	if (!latency.loading)
+		return ERROR_SUCCESS;
+
+	latency.loading = FALSE;
+
+	for (index = 0; index < latency.loadcount; index++)
+		semaphore_wait(latency.loaddone);
+
+	semaphore_destroy(latency.loaddone);
+	latency.loaddone = INVALID_HANDLE_VALUE;
+
+	free(latency.loads);
+	latency.loads = NULL;
+	latency.loadcount = 0;
+	latency.loadmask = LATENCY_LOAD_NONE;
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Latency Test Functions */
+static void STDCALL latency_worker_task(void *data)
+{
+	LATENCY_CONTEXT *context = (LATENCY_CONTEXT *)data;
+
+	/* A task that starts after the pass has ended is not recorded */
+	if (!context->stopping)
+		latency_histogram_add(context->primary, latency_counts_to_ns(clock_get_total() - context->stamp));
+
+	__sync_lock_release(&context->pending);
+}
+
+/* Timer device event callback, called by the interrupt handler */
+static void STDCALL latency_timer_event(void *data)
+{
+	LATENCY_CONTEXT *context = (LATENCY_CONTEXT *)data;
+	int64_t now = clock_get_total();
+	int64_t deviation;
+
+	if (context->stopping)
+		return;
+
+	if (context->test == LATENCY_TEST_WORKER)
+	{
+		/* Only one task outstanding, otherwise a backlog in the worker pool inflates every sample after it */
+		if (!__sync_bool_compare_and_swap(&context->pending, 0, 1))
+			return;
+
+		context->stamp = now;
+		if (worker_schedule_irq(CPU_AFFINITY_NONE, latency_worker_task, context, NULL) != ERROR_SUCCESS)
+		{
+			context->primary->missed++;
+			__sync_lock_release(&context->pending);
+		}
+		return;
+	}
+
+	if (context->primary && context->last != 0)
+	{
+		deviation = now - context->last - context->period;
+		if (deviation < 0)
+			deviation = -deviation;
+
+		latency_histogram_add(context->primary, latency_counts_to_ns(deviation));
+	}
+	context->last = now;
+
+	if (context->secondary && __sync_bool_compare_and_swap(&context->pending, 0, 1))
+	{
+		context->stamp = now;
+		semaphore_signal(context->signal);
+	}
+}
+
+/* Wait for the timer event and record the time until this thread runs */
+static ssize_t STDCALL latency_wake_execute(void *parameter)
+{
+	LATENCY_CONTEXT *context = (LATENCY_CONTEXT *)parameter;
+
+	while (!context->stopping)
+	{
+		if (semaphore_wait_ex(context->signal, LATENCY_EVENT_TIMEOUT) != ERROR_SUCCESS)
+			continue;
+
+		if (context->stopping)
+			break;
+
+		latency_histogram_add(context->secondary, latency_counts_to_ns(clock_get_total() - context->stamp));
+
+		__sync_lock_release(&context->pending);
+	}
+
+	semaphore_signal(context->done);
+
+	return 0;
+}
+
+static uint32_t latency_timer_pass(LATENCY_CONTEXT *context, TIMER_DEVICE *timer)
+{
+	THREAD_HANDLE thread = INVALID_HANDLE_VALUE;
+	uint32_t oldinterval;
+	uint32_t interval;
+	uint32_t started;
+	uint32_t status;
+	uint32_t rate;
+
+	if (!timer)
+		return ERROR_NOT_FOUND;
+
+	rate = timer_device_get_rate(timer);
+	if (rate == 0)
+		return ERROR_NOT_SUPPORTED;
+
+	interval = (uint32_t)(((uint64_t)rate * context->interval) / 1000000);
+	if (interval == 0)
+		interval = 1;
+
+	/* Leave the timer in the state it was found */
+	started = FALSE;
+	if (timer->timerstate != TIMER_STATE_ENABLED)
+	{
+		status = timer_device_start(timer);
+		if (status != ERROR_SUCCESS)
+			return status;
+
+		started = TRUE;
+	}
+
+	oldinterval = timer_device_get_interval(timer);
+
+	status = timer_device_set_interval(timer, interval);
+	if (status == ERROR_SUCCESS)
+	{
+		context->period = (int64_t)(((uint64_t)interval * latency.clockrate) / rate);
+
+		if (context->secondary)
+		{
+			thread = latency_thread_start(latency_wake_execute, THREAD_PRIORITY_CRITICAL, context->cpu, context);
+			if (thread == INVALID_HANDLE_VALUE)
+				status = ERROR_OPERATION_FAILED;
+		}
+
+		if (status == ERROR_SUCCESS)
+			status = timer_device_event(timer, TIMER_EVENT_FLAG_REPEAT | TIMER_EVENT_FLAG_INTERRUPT, latency_timer_event, context);
+
+		if (status == ERROR_SUCCESS)
+		{
+			while (clock_microseconds() < context->endtime)
+				thread_sleep(LATENCY_EVENT_TIMEOUT);
+
+			timer_device_cancel(timer);
+		}
+
+		context->stopping = TRUE;
+
+		if (thread != INVALID_HANDLE_VALUE)
+		{
+			semaphore_signal(context->signal);
+			semaphore_wait(context->done);
+		}
+
+		/* Allow an outstanding worker task to finish before the context goes away */
+		while (context->pending && clock_microseconds() < context->endtime + (LATENCY_EVENT_TIMEOUT * 1000))
+			thread_sleep(1);
+
+		if (oldinterval != 0)
+			timer_device_set_interval(timer, oldinterval);
+	}
+
+	if (started)
+		timer_device_stop(timer);
+
+	return status;
+}
+
+/* Wait for the signal from the other CPU and record the time until this thread runs */
+static ssize_t STDCALL latency_ipi_receive(void *parameter)
+{
+	LATENCY_CONTEXT *context = (LATENCY_CONTEXT *)parameter;
+
+	while (!context->stopping)
+	{
+		if (semaphore_wait_ex(context->signal, LATENCY_EVENT_TIMEOUT) != ERROR_SUCCESS)
+			continue;
+
+		if (context->stopping)
+			break;
+
+		latency_histogram_add(context->primary, latency_counts_to_ns(clock_get_total() - context->stamp));
+
+		semaphore_signal(context->ack);
+	}
+
+	semaphore_signal(context->done);
+
+	return 0;
+}
+
+static ssize_t STDCALL latency_ipi_send(void *parameter)
+{
+	LATENCY_CONTEXT *context = (LATENCY_CONTEXT *)parameter;
+
+	while (clock_microseconds() < context->endtime)
+	{
+		context->stamp = clock_get_total();
+		semaphore_signal(context->signal);
+
+		if (semaphore_wait_ex(context->ack, LATENCY_EVENT_TIMEOUT) != ERROR_SUCCESS)
+			context->primary->missed++;
+
+		latency_delay(context->interval);
+	}
+
+	context->stopping = TRUE;
+
+	semaphore_signal(context->done);
+
+	return 0;
+}
+
+static uint32_t latency_ipi_pass(LATENCY_CONTEXT *context)
+{
+	uint32_t status;
+	uint32_t count;
+	uint32_t cpu;
+
+	/* The sender runs on the next CPU, with one CPU this measures a local wakeup */
+	cpu = (context->cpu + 1) % cpu_get_count();
+
+	if (latency_thread_start(latency_ipi_receive, THREAD_PRIORITY_CRITICAL, context->cpu, context) == INVALID_HANDLE_VALUE)
+		return ERROR_OPERATION_FAILED;
+
+	count = 1;
+	status = ERROR_SUCCESS;
+	if (latency_thread_start(latency_ipi_send, THREAD_PRIORITY_CRITICAL, cpu, context) != INVALID_HANDLE_VALUE)
+	{
+		count++;
+	}
+	else
+	{
+		context->stopping = TRUE;
+		status = ERROR_OPERATION_FAILED;
+	}
+
+	while (count > 0)
+	{
+		semaphore_wait(context->done);
+		count--;
+	}
+
+	return status;
+}
+
+/* GPIO input event callback, called by a worker thread or the interrupt handler */
+static void STDCALL latency_gpio_event(void *data, uint32_t pin, uint32_t trigger)
+{
+	LATENCY_CONTEXT *context = (LATENCY_CONTEXT *)data;
+	int64_t now = clock_get_total();
+
+	/* Ignore an event that arrives after the output pass has given up waiting for it */
+	if (!__sync_bool_compare_and_swap(&context->pending, 1, 0))
+		return;
+
+	latency_histogram_add(context->primary, latency_counts_to_ns(now - context->stamp));
+
+	semaphore_signal(context->signal);
+}
+
+/* Set the output pin and wait for the input event on the connected pin */
+static ssize_t STDCALL latency_gpio_execute(void *parameter)
+{
+	LATENCY_CONTEXT *context = (LATENCY_CONTEXT *)parameter;
+	GPIO_DEVICE *gpio = context->gpio;
+	uint32_t status = ERROR_SUCCESS;
+
+	gpio_device_output_set(gpio, context->outputpin, GPIO_LEVEL_LOW);
+
+	while (clock_microseconds() < context->endtime)
+	{
+		status = gpio_device_input_event(gpio, context->inputpin, GPIO_TRIGGER_RISING, context->gpioflags, INFINITE, latency_gpio_event, context);
+		if (status != ERROR_SUCCESS)
+			break;
+
+		context->pending = 1;
+		context->stamp = clock_get_total();
+
+		gpio_device_output_set(gpio, context->outputpin, GPIO_LEVEL_HIGH);
+
+		if (semaphore_wait_ex(context->signal, LATENCY_EVENT_TIMEOUT) != ERROR_SUCCESS)
+		{
+			gpio_device_input_cancel(gpio, context->inputpin);
+
+			/* The callback may have run between the timeout and the cancel */
+			if (__sync_bool_compare_and_swap(&context->pending, 1, 0))
+				context->primary->missed++;
+			else
+				semaphore_wait(context->signal);
+		}
+
+		gpio_device_output_set(gpio, context->outputpin, GPIO_LEVEL_LOW);
+
+		latency_delay(context->interval);
+	}
+
+	context->status = status;
+	context->stopping = TRUE;
+
+	semaphore_signal(context->done);
+
+	return 0;
+}
+
+static uint32_t latency_gpio_pass(LATENCY_CONTEXT *context)
+{
+	/* Not all devices support function and pull selection (eg the loopback device) */
+	gpio_device_function_select(context->gpio, context->outputpin, GPIO_FUNCTION_OUT);
+	gpio_device_function_select(context->gpio, context->inputpin, GPIO_FUNCTION_IN);
+	gpio_device_pull_select(context->gpio, context->inputpin, GPIO_PULL_NONE);
+
+	if (latency_thread_start(latency_gpio_execute, THREAD_PRIORITY_CRITICAL, context->cpu, context) == INVALID_HANDLE_VALUE)
+		return ERROR_OPERATION_FAILED;
+
+	semaphore_wait(context->done);
+
+	return context->status;
+}
+
+static uint32_t latency_context_init(LATENCY_CONTEXT *context, uint32_t test, LATENCY_CONFIG *config, uint32_t duration, uint32_t interval)
+{
+	memset(context, 0, sizeof(LATENCY_CONTEXT));
+
+	context->test = test;
+	context->interval = interval;
+	context->cpu = config->cpu;
+	/* Signalled from the timer and GPIO interrupt handlers */
+	context->signal = semaphore_create_ex(0, LATENCY_SIGNAL_MAXIMUM, SEMAPHORE_FLAG_IRQ);
+	context->ack = semaphore_create(0);
+	context->done = semaphore_create(0);
+	if (context->signal == INVALID_HANDLE_VALUE || context->ack == INVALID_HANDLE_VALUE || context->done == INVALID_HANDLE_VALUE)
+		return ERROR_OPERATION_FAILED;
+
+	context->endtime = clock_microseconds() + ((int64_t)duration * 1000);
+
+	return ERROR_SUCCESS;
+}
+
+static void latency_context_free(LATENCY_CONTEXT *context)
+{
+	if (context->signal != INVALID_HANDLE_VALUE)
+		semaphore_destroy(context->signal);
+	if (context->ack != INVALID_HANDLE_VALUE)
+		semaphore_destroy(context->ack);
+	if (context->done != INVALID_HANDLE_VALUE)
+		semaphore_destroy(context->done);
+
+	context->signal = INVALID_HANDLE_VALUE;
+	context->ack = INVALID_HANDLE_VALUE;
+	context->done = INVALID_HANDLE_VALUE;
+}
+
+/* ============================================================================== */
+/* Latency Loopback Functions */
+static BOOL latency_loopback_triggered(uint32_t trigger, uint32_t previous, uint32_t level)
+{
+	switch (trigger)
+	{
+		case GPIO_TRIGGER_LOW:
+			return (level == GPIO_LEVEL_LOW);
+		case GPIO_TRIGGER_HIGH:
+			return (level == GPIO_LEVEL_HIGH);
+		case GPIO_TRIGGER_RISING:
+		case GPIO_TRIGGER_ASYNC_RISING:
+			return (previous == GPIO_LEVEL_LOW && level == GPIO_LEVEL_HIGH);
+		case GPIO_TRIGGER_FALLING:
+		case GPIO_TRIGGER_ASYNC_FALLING:
+			return (previous == GPIO_LEVEL_HIGH && level == GPIO_LEVEL_LOW);
+		case GPIO_TRIGGER_EDGE:
+			return (previous != level);
+	}
+
+	return FALSE;
+}
+
+/* Take the registered event from a pin, caller must hold the device lock */
+static void latency_loopback_take(LATENCY_LOOPBACK_PIN *input, LATENCY_LOOPBACK_EVENT *event)
+{
+	event->callback = input->callback;
+	event->data = input->data;
+	event->pin = input->pin;
+	event->trigger = input->trigger;
+	event->flags = input->flags;
+
+	if ((input->flags & GPIO_EVENT_FLAG_REPEAT) == 0)
+	{
+		input->callback = NULL;
+		input->data = NULL;
+		input->trigger = GPIO_TRIGGER_NONE;
+	}
+}
+
+static void STDCALL latency_loopback_execute(void *data)
+{
+	LATENCY_LOOPBACK_EVENT *event = (LATENCY_LOOPBACK_EVENT *)data;
+
+	event->callback(event->data, event->pin, event->trigger);
+
+	free(event);
+}
+
+/* Call the event callback from the worker pool, or directly if GPIO_EVENT_FLAG_INTERRUPT was requested */
+static void latency_loopback_dispatch(GPIO_DEVICE *gpio, LATENCY_LOOPBACK_EVENT *event)
+{
+	LATENCY_LOOPBACK_EVENT *copy;
+
+	gpio->eventcount++;
+
+	if ((event->flags & GPIO_EVENT_FLAG_INTERRUPT) == 0)
+	{
+		copy = malloc(sizeof(LATENCY_LOOPBACK_EVENT));
+		if (copy)
+		{
+			memcpy(copy, event, sizeof(LATENCY_LOOPBACK_EVENT));
+
+			if (worker_schedule(0, latency_loopback_execute, copy, NULL) == ERROR_SUCCESS)
+				return;
+
+			free(copy);
+		}
+	}
+
+	event->callback(event->data, event->pin, event->trigger);
+}
+
+static uint32_t STDCALL latency_loopback_start(GPIO_DEVICE *gpio)
+{
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL latency_loopback_stop(GPIO_DEVICE *gpio)
+{
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL latency_loopback_input_get(GPIO_DEVICE *gpio, uint32_t pin)
+{
+	LATENCY_LOOPBACK *loopback = (LATENCY_LOOPBACK *)gpio;
+
+	if (pin >= LATENCY_LOOPBACK_PIN_COUNT)
+		return GPIO_LEVEL_UNKNOWN;
+
+	gpio->getcount++;
+
+	return loopback->pins[pin].level;
+}
+
+static uint32_t STDCALL latency_loopback_input_event(GPIO_DEVICE *gpio, uint32_t pin, uint32_t trigger, uint32_t flags, uint32_t timeout, gpio_event_cb callback, void *data)
+{
+	LATENCY_LOOPBACK *loopback = (LATENCY_LOOPBACK *)gpio;
+	LATENCY_LOOPBACK_PIN *input;
+	LATENCY_LOOPBACK_EVENT event;
+	BOOL triggered;
+
+	if (pin >= LATENCY_LOOPBACK_PIN_COUNT)
+		return ERROR_INVALID_PARAMETER;
+	if (trigger < GPIO_TRIGGER_LOW || trigger > GPIO_TRIGGER_EDGE)
+		return ERROR_INVALID_PARAMETER;
+	if (!callback)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(gpio->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	input = &loopback->pins[pin];
+	if (input->callback)
+	{
+		mutex_unlock(gpio->lock);
+		return ERROR_IN_USE;
+	}
+
+	/* Timeouts are not supported, the event remains until triggered or cancelled */
+	input->trigger = trigger;
+	input->flags = flags;
+	input->callback = callback;
+	input->data = data;
+
+	/* A level trigger that already matches fires immediately */
+	triggered = (trigger == GPIO_TRIGGER_LOW || trigger == GPIO_TRIGGER_HIGH) && latency_loopback_triggered(trigger, input->level, input->level);
+	if (triggered)
+		latency_loopback_take(input, &event);
+
+	mutex_unlock(gpio->lock);
+
+	if (triggered)
+		latency_loopback_dispatch(gpio, &event);
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t STDCALL latency_loopback_input_cancel(GPIO_DEVICE *gpio, uint32_t pin)
+{
+	LATENCY_LOOPBACK *loopback = (LATENCY_LOOPBACK *)gpio;
+	LATENCY_LOOPBACK_PIN *input;
+	uint32_t status = ERROR_SUCCESS;
+
+	if (pin >= LATENCY_LOOPBACK_PIN_COUNT)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(gpio->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	input = &loopback->pins[pin];
+	if (input->callback)
+	{
+		input->callback = NULL;
+		input->data = NULL;
+		input->trigger = GPIO_TRIGGER_NONE;
+	}
+	else
+	{
+		status = ERROR_NOT_FOUND;
+	}
+
+	mutex_unlock(gpio->lock);
+
+	return status;
+}
+
+static uint32_t STDCALL latency_loopback_output_set(GPIO_DEVICE *gpio, uint32_t pin, uint32_t level)
+{
+	LATENCY_LOOPBACK *loopback = (LATENCY_LOOPBACK *)gpio;
+	LATENCY_LOOPBACK_PIN *input;
+	LATENCY_LOOPBACK_EVENT event;
+	uint32_t previous;
+	BOOL triggered;
+
+	if (pin >= LATENCY_LOOPBACK_PIN_COUNT)
+		return ERROR_INVALID_PARAMETER;
+	if (level > GPIO_LEVEL_HIGH)
+		return ERROR_INVALID_PARAMETER;
+
+	if (mutex_lock(gpio->lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	gpio->setcount++;
+
+	/* Pins are connected in pairs (0 and 1, 2 and 3 etc), setting either drives both */
+	loopback->pins[pin].level = level;
+
+	input = &loopback->pins[pin ^ 1];
+	previous = input->level;
+	input->level = level;
+
+	triggered = input->callback && latency_loopback_triggered(input->trigger, previous, level);
+	if (triggered)
+		latency_loopback_take(input, &event);
+
+	mutex_unlock(gpio->lock);
+
+	if (triggered)
+		latency_loopback_dispatch(gpio, &event);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Latency Functions */
+static BOOL latency_requested(LATENCY_CONFIG *config, uint32_t count, uint32_t test)
+{
+	return (test < count) && (config->tests & (1 << test));
+}
+
+/* Run the requested tests and return one result for each test indexed by test number (eg results[LATENCY_TEST_GPIO]),
+ * tests that were not requested or do not fit in count have the status ERROR_NOT_ASSIGNED */
+uint32_t STDCALL latency_run(LATENCY_CONFIG *config, LATENCY_RESULT *results, uint32_t count)
+{
+	LATENCY_CONTEXT *context = &latency.context;
+	TIMER_DEVICE *timer;
+	GPIO_DEVICE *loopback = NULL;
+	uint32_t affinity;
+	uint32_t duration;
+	uint32_t interval;
+	uint32_t cpucount;
+	uint32_t status;
+	uint32_t index;
+
+	if (!config || !results || count == 0)
+		return ERROR_INVALID_PARAMETER;
+
+	cpucount = cpu_get_count();
+	if (config->cpu >= cpucount)
+		return ERROR_INVALID_PARAMETER;
+
+	if (latency_create_lock() != ERROR_SUCCESS)
+		return ERROR_OPERATION_FAILED;
+
+	if (mutex_lock(latency.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	duration = config->duration ? config->duration : LATENCY_DEFAULT_DURATION;
+	interval = config->interval ? config->interval : LATENCY_DEFAULT_INTERVAL;
+
+	for (index = 0; index < count; index++)
+	{
+		memset(&results[index], 0, sizeof(LATENCY_RESULT));
+		results[index].test = index;
+		results[index].status = ERROR_NOT_ASSIGNED;
+		latency_histogram_clear(&results[index].histogram);
+	}
+
+	latency_calibrate();
+
+	/* Load every CPU except the measuring CPU, or the measuring CPU if it is the only one */
+	affinity = ((cpucount >= 32) ? 0xFFFFFFFF : ((1U << cpucount) - 1)) & ~(1U << config->cpu);
+	if (affinity == 0)
+		affinity = 1U << config->cpu;
+
+	status = latency_load_begin(config->loads, affinity);
+	if (status != ERROR_SUCCESS)
+	{
+		mutex_unlock(latency.lock);
+		return status;
+	}
+
+	timer = config->timer ? config->timer : timer_device_get_default();
+
+	/* Timer and timer wake are measured from the same events */
+	if (latency_requested(config, count, LATENCY_TEST_TIMER) || latency_requested(config, count, LATENCY_TEST_TIMER_WAKE))
+	{
+		status = latency_context_init(context, LATENCY_TEST_TIMER, config, duration, interval);
+		if (status == ERROR_SUCCESS)
+		{
+			if (latency_requested(config, count, LATENCY_TEST_TIMER))
+				context->primary = &results[LATENCY_TEST_TIMER].histogram;
+			if (latency_requested(config, count, LATENCY_TEST_TIMER_WAKE))
+				context->secondary = &results[LATENCY_TEST_TIMER_WAKE].histogram;
+
+			status = latency_timer_pass(context, timer);
+		}
+		latency_context_free(context);
+
+		if (latency_requested(config, count, LATENCY_TEST_TIMER))
+			results[LATENCY_TEST_TIMER].status = status;
+		if (latency_requested(config, count, LATENCY_TEST_TIMER_WAKE))
+			results[LATENCY_TEST_TIMER_WAKE].status = status;
+	}
+
+	if (latency_requested(config, count, LATENCY_TEST_IPI))
+	{
+		status = latency_context_init(context, LATENCY_TEST_IPI, config, duration, interval);
+		if (status == ERROR_SUCCESS)
+		{
+			context->primary = &results[LATENCY_TEST_IPI].histogram;
+
+			status = latency_ipi_pass(context);
+		}
+		latency_context_free(context);
+
+		results[LATENCY_TEST_IPI].status = status;
+	}
+
+	if (latency_requested(config, count, LATENCY_TEST_GPIO))
+	{
+		status = latency_context_init(context, LATENCY_TEST_GPIO, config, duration, interval);
+		if (status == ERROR_SUCCESS)
+		{
+			context->primary = &results[LATENCY_TEST_GPIO].histogram;
+			context->gpioflags = (config->flags & LATENCY_FLAG_GPIO_INTERRUPT) ? GPIO_EVENT_FLAG_INTERRUPT : GPIO_EVENT_FLAG_NONE;
+			context->gpio = config->gpio;
+			context->outputpin = config->outputpin;
+			context->inputpin = config->inputpin;
+			if (!context->gpio)
+			{
+				loopback = latency_loopback_create();
+
+				context->gpio = loopback;
+				context->outputpin = GPIO_PIN_0;
+				context->inputpin = GPIO_PIN_1;
+			}
+
+			status = context->gpio ? latency_gpio_pass(context) : ERROR_NOT_FOUND;
+		}
+		latency_context_free(context);
+
+		results[LATENCY_TEST_GPIO].status = status;
+	}
+
+	if (latency_requested(config, count, LATENCY_TEST_WORKER))
+	{
+		status = latency_context_init(context, LATENCY_TEST_WORKER, config, duration, interval);
+		if (status == ERROR_SUCCESS)
+		{
+			context->primary = &results[LATENCY_TEST_WORKER].histogram;
+
+			status = latency_timer_pass(context, timer);
+		}
+		latency_context_free(context);
+
+		results[LATENCY_TEST_WORKER].status = status;
+	}
+
+	for (index = 0; index < count; index++)
+	{
+		if (results[index].status != ERROR_SUCCESS)
+			continue;
+
+		results[index].loads = latency.loadmask;
+		results[index].p50 = latency_histogram_percentile(&results[index].histogram, 5000);
+		results[index].p90 = latency_histogram_percentile(&results[index].histogram, 9000);
+		results[index].p99 = latency_histogram_percentile(&results[index].histogram, 9900);
+		results[index].p999 = latency_histogram_percentile(&results[index].histogram, 9990);
+	}
+
+	latency_load_end();
+
+	if (loopback)
+		latency_loopback_destroy(loopback);
+
+	mutex_unlock(latency.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL latency_load_start(uint32_t loads, uint32_t affinity)
+{
+	uint32_t status;
+
+	if (latency_create_lock() != ERROR_SUCCESS)
+		return ERROR_OPERATION_FAILED;
+
+	if (mutex_lock(latency.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	status = latency_load_begin(loads, affinity);
+
+	mutex_unlock(latency.lock);
+
+	return status;
+}
+
+uint32_t STDCALL latency_load_stop(void)
+{
+	uint32_t status;
+
+	if (latency.lock == INVALID_HANDLE_VALUE)
+		return ERROR_SUCCESS;
+
+	if (mutex_lock(latency.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	status = latency_load_end();
+
+	mutex_unlock(latency.lock);
+
+	return status;
+}
+
+/* Create and register a virtual GPIO device where pins are connected in pairs (0 and 1, 2 and 3 etc) */
+GPIO_DEVICE * STDCALL latency_loopback_create(void)
+{
+	LATENCY_LOOPBACK *loopback;
+	GPIO_DEVICE *gpio;
+	uint32_t index;
+
+	gpio = gpio_device_create_ex(sizeof(LATENCY_LOOPBACK));
+	if (!gpio)
+		return NULL;
+
+	loopback = (LATENCY_LOOPBACK *)gpio;
+
+	/* Device */
+	gpio->device.devicebus = DEVICE_BUS_NONE;
+	gpio->device.devicetype = GPIO_TYPE_NONE;
+	gpio->device.deviceflags = GPIO_FLAG_TRIGGER_LOW | GPIO_FLAG_TRIGGER_HIGH | GPIO_FLAG_TRIGGER_RISING | GPIO_FLAG_TRIGGER_FALLING | GPIO_FLAG_TRIGGER_EDGE;
+	gpio->device.devicedata = NULL;
+	strncpy(gpio->device.devicedescription, LATENCY_LOOPBACK_DESCRIPTION, DEVICE_DESC_LENGTH - 1);
+
+	/* GPIO */
+	gpio->gpiostate = GPIO_STATE_DISABLED;
+	gpio->devicestart = latency_loopback_start;
+	gpio->devicestop = latency_loopback_stop;
+	gpio->deviceinputget = latency_loopback_input_get;
+	gpio->deviceinputevent = latency_loopback_input_event;
+	gpio->deviceinputcancel = latency_loopback_input_cancel;
+	gpio->deviceoutputset = latency_loopback_output_set;
+
+	/* Driver */
+	gpio->properties.flags = gpio->device.deviceflags;
+	gpio->properties.pinmin = GPIO_PIN_0;
+	gpio->properties.pinmax = LATENCY_LOOPBACK_PIN_COUNT - 1;
+	gpio->properties.pincount = LATENCY_LOOPBACK_PIN_COUNT;
+	gpio->properties.functionmin = GPIO_FUNCTION_IN;
+	gpio->properties.functionmax = GPIO_FUNCTION_OUT;
+	gpio->properties.functioncount = 2;
+
+	for (index = 0; index < LATENCY_LOOPBACK_PIN_COUNT; index++)
+	{
+		loopback->pins[index].pin = index;
+		loopback->pins[index].level = GPIO_LEVEL_LOW;
+		loopback->pins[index].trigger = GPIO_TRIGGER_NONE;
+	}
+
+	if (gpio_device_register(gpio) != ERROR_SUCCESS)
+	{
+		gpio_device_destroy(gpio);
+		return NULL;
+	}
+
+	if (gpio_device_start(gpio) != ERROR_SUCCESS)
+	{
+		gpio_device_deregister(gpio);
+		gpio_device_destroy(gpio);
+		return NULL;
+	}
+
+	return gpio;
+}
+
+uint32_t STDCALL latency_loopback_destroy(GPIO_DEVICE *gpio)
+{
+	uint32_t status;
+
+	if (!gpio || gpio->deviceoutputset != latency_loopback_output_set)
+		return ERROR_INVALID_PARAMETER;
+
+	gpio_device_stop(gpio);
+
+	status = gpio_device_deregister(gpio);
+	if (status != ERROR_SUCCESS)
+		return status;
+
+	return gpio_device_destroy(gpio);
+}
+
+/* ============================================================================== */
+/* Latency Helper Functions */
+void STDCALL latency_histogram_clear(LATENCY_HISTOGRAM *histogram)
+{
+	if (!histogram)
+		return;
+
+	memset(histogram, 0, sizeof(LATENCY_HISTOGRAM));
+
+	histogram->minimum = 0xFFFFFFFF;
+}
+
+/* Record a value (Nanoseconds), safe to call from an interrupt handler but not from two CPUs at once */
+void STDCALL latency_histogram_add(LATENCY_HISTOGRAM *histogram, uint32_t value)
+{
+	if (!histogram)
+		return;
+
+	histogram->count++;
+	histogram->total += value;
+
+	if (value < histogram->minimum)
+		histogram->minimum = value;
+	if (value > histogram->maximum)
+		histogram->maximum = value;
+
+	histogram->buckets[latency_bucket_index(value)]++;
+}
+
+/* Return the value (Nanoseconds) below which the given fraction of values fall, rounded up to the limit of the bucket */
+uint32_t STDCALL latency_histogram_percentile(LATENCY_HISTOGRAM *histogram, uint32_t percentile)
+{
+	uint64_t target;
+	uint32_t cumulative;
+	uint32_t value;
+	uint32_t index;
+
+	if (!histogram || histogram->count == 0)
+		return 0;
+
+	if (percentile >= 10000)
+		return histogram->maximum;
+
+	target = (((uint64_t)histogram->count * percentile) + 9999) / 10000;
+	if (target == 0)
+		target = 1;
+
+	cumulative = 0;
+	for (index = 0; index < LATENCY_BUCKET_COUNT; index++)
+	{
+		cumulative += histogram->buckets[index];
+		if (cumulative >= target)
+		{
+			value = latency_bucket_limit(index);
+			if (value > histogram->maximum)
+				value = histogram->maximum;
+			if (value < histogram->minimum)
+				value = histogram->minimum;
+
+			return value;
+		}
+	}
+
+	return histogram->maximum;
+}
+
+/* Return the name of a latency test */
+uint32_t STDCALL latency_test_to_string(uint32_t test, char *string, uint32_t len)
+{
+	const char *name;
+
+	switch (test)
+	{
+		case LATENCY_TEST_TIMER:
+			name = "Timer";
+			break;
+		case LATENCY_TEST_TIMER_WAKE:
+			name = "Timer Wake";
+			break;
+		case LATENCY_TEST_IPI:
+			name = "IPI";
+			break;
+		case LATENCY_TEST_GPIO:
+			name = "GPIO";
+			break;
+		case LATENCY_TEST_WORKER:
+			name = "Worker";
+			break;
+		default:
+			name = "Unknown";
+	}
+
+	if (string != NULL && len > 0)
+	{
+		strncpy(string, name, len - 1);
+		string[len - 1] = '\0';
+	}
+
+	return strlen(name);
+}
+
+/* Format a result as a single line of text with times in microseconds */
+uint32_t STDCALL latency_result_to_string(LATENCY_RESULT *result, char *string, uint32_t len)
+{
+	LATENCY_HISTOGRAM *histogram;
+	char name[32];
+	int size;
+
+	if (!result || !string || len == 0)
+		return 0;
+
+	latency_test_to_string(result->test, name, sizeof(name));
+
+	histogram = &result->histogram;
+	if (result->status != ERROR_SUCCESS)
+		size = snprintf(string, len, "%-10s not run (Error %u)", name, (unsigned int)result->status);
+	else if (histogram->count == 0)
+		size = snprintf(string, len, "%-10s no samples (%u missed)", name, (unsigned int)histogram->missed);
+	else
+		size = snprintf(string, len, "%-10s n=%u missed=%u min=%u.%02u p50=%u.%02u p90=%u.%02u p99=%u.%02u p99.9=%u.%02u max=%u.%02u us",
+			name, (unsigned int)histogram->count, (unsigned int)histogram->missed,
+			(unsigned int)(histogram->minimum / 1000), (unsigned int)((histogram->minimum % 1000) / 10),
+			(unsigned int)(result->p50 / 1000), (unsigned int)((result->p50 % 1000) / 10),
+			(unsigned int)(result->p90 / 1000), (unsigned int)((result->p90 % 1000) / 10),
+			(unsigned int)(result->p99 / 1000), (unsigned int)((result->p99 % 1000) / 10),
+			(unsigned int)(result->p999 / 1000), (unsigned int)((result->p999 % 1000) / 10),
+			(unsigned int)(histogram->maximum / 1000), (unsigned int)((histogram->maximum % 1000) / 10));
+
+	if (size < 0)
+		return 0;
+
+	return ((uint32_t)size < len) ? (uint32_t)size : len - 1;
+}
+
+/* Write each result to the log followed by the non empty histogram buckets */
+uint32_t STDCALL latency_report_log(LATENCY_RESULT *results, uint32_t count)
+{
+	LATENCY_HISTOGRAM *histogram;
+	char line[256];
+	uint32_t index;
+	uint32_t bucket;
+
+	if (!results)
+		return ERROR_INVALID_PARAMETER;
+
+	for (index = 0; index < count; index++)
+	{
+		if (results[index].status == ERROR_NOT_ASSIGNED)
+			continue;
+
+		latency_result_to_string(&results[index], line, sizeof(line));
+		logging_output(line);
+
+		histogram = &results[index].histogram;
+		for (bucket = 0; bucket < LATENCY_BUCKET_COUNT; bucket++)
+		{
+			if (histogram->buckets[bucket] == 0)
+				continue;
+
+			snprintf(line, sizeof(line), "  <= %u ns: %u", (unsigned int)latency_bucket_limit(bucket), (unsigned int)histogram->buckets[bucket]);
+			logging_output(line);
+		}
+	}
+
+	return ERROR_SUCCESS;
+}
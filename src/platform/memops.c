@@ -0,0 +1,666 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/memops.h"
+
+/* Implementation of tuned memory copy, move and fill for Ultibo API
+ *
+ * Copies and fills are split into an unaligned head and tail, which are passed
+ * to the C library, and a body of 64 byte blocks aligned to the destination that
+ * is moved by a loop selected at compile time for the architecture:
+ *
+ *  ARMv6 - Word loads and stores with prefetch, used only when the source and
+ *          destination share the same word alignment (Otherwise the C library)
+ *
+ *  ARMv7 - NEON loads and stores of 64 bytes per pass with prefetch, only d0 to
+ *          d7 are used so the code is safe with the VFPv3-D16 context saved by
+ *          the scheduler even though the compiler is not targeting NEON
+ *
+ *  ARMv8 - SIMD register pair loads and stores with prefetch, copies and fills
+ *          at or above the non temporal threshold (By default the L2 cache size)
+ *          use non temporal stores so they do not evict the working set
+ *
+ * None of these may be called from an interrupt handler since they use the
+ * floating point registers of the interrupted thread.
+ *
+ * mem_ops_copy_auto passes copies at or above the DMA threshold to the DMA
+ * controller with dma_copy_memory (Which performs any cache maintenance needed)
+ * and falls back to the CPU if the transfer fails. The threshold is disabled by
+ * default since the crossover depends on the board, mem_ops_tune measures it
+ * along with the prefetch distance and applies the results.
+ */
+
+/* ============================================================================== */
+/* Memory Operations specific constants */
+#define MEM_OPS_STATE_STOPPED	0
+#define MEM_OPS_STATE_STARTING	1
+#define MEM_OPS_STATE_STARTED	2
+
+#define MEM_OPS_BLOCK_MASK	(MEM_OPS_BLOCK_SIZE - 1)
+
+#if defined(__aarch64__)
+#define MEM_OPS_IMPL_CURRENT	MEM_OPS_IMPL_ARM64
+#elif defined(__arm__) && defined(__ARM_ARCH) && (__ARM_ARCH >= 7)
+#define MEM_OPS_IMPL_CURRENT	MEM_OPS_IMPL_NEON
+#else
+#define MEM_OPS_IMPL_CURRENT	MEM_OPS_IMPL_GENERIC
+#endif
+
+/* ============================================================================== */
+/* Memory Operations specific types */
+typedef struct _MEM_OPS_STATE MEM_OPS_STATE;
+struct _MEM_OPS_STATE
+{
+	volatile uint32_t started; // Startup state (eg MEM_OPS_STATE_STARTED)
+	SPIN_HANDLE lock; // Lock protecting the statistics
+	MEM_OPS_CONFIG config;
+	MEM_OPS_STATISTICS statistics;
+};
+
+static MEM_OPS_STATE memops = {MEM_OPS_STATE_STOPPED};
+
+/* Prefetch distances tried by mem_ops_tune (Bytes) */
+static const uint32_t memops_prefetch_distances[] = {0, 64, 128, 192, 256, 384, 512, 768, 1024};
+
+/* ============================================================================== */
+/* Memory Operations Internal Functions */
+static void mem_ops_start(void)
+{
+	if (memops.started == MEM_OPS_STATE_STARTED)
+		return;
+
+	if (!__sync_bool_compare_and_swap(&memops.started, MEM_OPS_STATE_STOPPED, MEM_OPS_STATE_STARTING))
+	{
+		while (memops.started != MEM_OPS_STATE_STARTED)
+			thread_yield();
+		return;
+	}
+
+	memops.lock = spin_create();
+
+	memops.config.implementation = MEM_OPS_IMPL_CURRENT;
+	memops.config.flags = MEM_OPS_FLAG_NONE;
+	memops.config.prefetch = MEM_OPS_DEFAULT_PREFETCH;
+	memops.config.dmathreshold = MEM_OPS_THRESHOLD_NEVER;
+	memops.config.linesize = l1_data_cache_get_line_size();
+	memops.config.l1size = l1_data_cache_get_size();
+	memops.config.l2size = l2_cache_get_size();
+	memops.config.pagesize = memory_get_page_size();
+
+	/* Only the ARMv8 loops have non temporal stores */
+	memops.config.nonthreshold = MEM_OPS_THRESHOLD_NEVER;
+	if (MEM_OPS_IMPL_CURRENT == MEM_OPS_IMPL_ARM64 && memops.config.l2size > 0)
+		memops.config.nonthreshold = memops.config.l2size;
+
+	__sync_synchronize();
+	memops.started = MEM_OPS_STATE_STARTED;
+}
+
+/* Copy size bytes (A non zero multiple of MEM_OPS_BLOCK_SIZE) from source to dest in a forward direction */
+static void mem_ops_copy_blocks(uint8_t *dest, const uint8_t *source, size_t size, size_t prefetch, BOOL nontemporal)
+{
+#if MEM_OPS_IMPL_CURRENT == MEM_OPS_IMPL_ARM64
+	if (nontemporal)
+	{
+		__asm__ __volatile__(
+			"1:\n"
+			"prfm pldl1strm, [%[source], %[prefetch]]\n"
+			"ldnp q0, q1, [%[source]]\n"
+			"ldnp q2, q3, [%[source], #32]\n"
+			"add %[source], %[source], #64\n"
+			"subs %[size], %[size], #64\n"
+			"stnp q0, q1, [%[dest]]\n"
+			"stnp q2, q3, [%[dest], #32]\n"
+			"add %[dest], %[dest], #64\n"
+			"b.ne 1b\n"
+			: [dest] "+r" (dest), [source] "+r" (source), [size] "+r" (size)
+			: [prefetch] "r" (prefetch)
+			: "v0", "v1", "v2", "v3", "cc", "memory");
+	}
+	else
+	{
+		__asm__ __volatile__(
+			"1:\n"
+			"prfm pldl1keep, [%[source], %[prefetch]]\n"
+			"ldp q0, q1, [%[source]]\n"
+			"ldp q2, q3, [%[source], #32]\n"
+			"add %[source], %[source], #64\n"
+			"subs %[size], %[size], #64\n"
+			"stp q0, q1, [%[dest]]\n"
+			"stp q2, q3, [%[dest], #32]\n"
+			"add %[dest], %[dest], #64\n"
+			"b.ne 1b\n"
+			: [dest] "+r" (dest), [source] "+r" (source), [size] "+r" (size)
+			: [prefetch] "r" (prefetch)
+			: "v0", "v1", "v2", "v3", "cc", "memory");
+	}
+#elif MEM_OPS_IMPL_CURRENT == MEM_OPS_IMPL_NEON
+	(void)nontemporal;
+
+	__asm__ __volatile__(
+		".fpu neon\n"
+		"1:\n"
+		"pld [%[source], %[prefetch]]\n"
+		"vld1.8 {d0-d3}, [%[source]]!\n"
+		"vld1.8 {d4-d7}, [%[source]]!\n"
+		"subs %[size], %[size], #64\n"
+		"vst1.8 {d0-d3}, [%[dest]]!\n"
+		"vst1.8 {d4-d7}, [%[dest]]!\n"
+		"bne 1b\n"
+		: [dest] "+r" (dest), [source] "+r" (source), [size] "+r" (size)
+		: [prefetch] "r" (prefetch)
+		: "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "cc", "memory");
+#else
+	uint32_t *target = (uint32_t *)dest;
+	const uint32_t *next = (const uint32_t *)source;
+	uint32_t value0, value1, value2, value3, value4, value5, value6, value7;
+
+	(void)nontemporal;
+
+	/* Each half block is loaded before it is stored so a forward move is safe */
+	while (size > 0)
+	{
+		__builtin_prefetch((const uint8_t *)next + prefetch);
+
+		value0 = next[0]; value1 = next[1]; value2 = next[2]; value3 = next[3];
+		value4 = next[4]; value5 = next[5]; value6 = next[6]; value7 = next[7];
+		target[0] = value0; target[1] = value1; target[2] = value2; target[3] = value3;
+		target[4] = value4; target[5] = value5; target[6] = value6; target[7] = value7;
+
+		value0 = next[8]; value1 = next[9]; value2 = next[10]; value3 = next[11];
+		value4 = next[12]; value5 = next[13]; value6 = next[14]; value7 = next[15];
+		target[8] = value0; target[9] = value1; target[10] = value2; target[11] = value3;
+		target[12] = value4; target[13] = value5; target[14] = value6; target[15] = value7;
+
+		next += 16;
+		target += 16;
+		size -= MEM_OPS_BLOCK_SIZE;
+	}
+#endif
+}
+
+/* Fill size bytes (A non zero multiple of MEM_OPS_BLOCK_SIZE) at dest with value */
+static void mem_ops_set_blocks(uint8_t *dest, uint8_t value, size_t size, BOOL nontemporal)
+{
+#if MEM_OPS_IMPL_CURRENT == MEM_OPS_IMPL_ARM64
+	uint32_t pattern = value;
+
+	if (nontemporal)
+	{
+		__asm__ __volatile__(
+			"dup v0.16b, %w[pattern]\n"
+			"mov v1.16b, v0.16b\n"
+			"1:\n"
+			"subs %[size], %[size], #64\n"
+			"stnp q0, q1, [%[dest]]\n"
+			"stnp q0, q1, [%[dest], #32]\n"
+			"add %[dest], %[dest], #64\n"
+			"b.ne 1b\n"
+			: [dest] "+r" (dest), [size] "+r" (size)
+			: [pattern] "r" (pattern)
+			: "v0", "v1", "cc", "memory");
+	}
+	else
+	{
+		__asm__ __volatile__(
+			"dup v0.16b, %w[pattern]\n"
+			"mov v1.16b, v0.16b\n"
+			"1:\n"
+			"subs %[size], %[size], #64\n"
+			"stp q0, q1, [%[dest]]\n"
+			"stp q0, q1, [%[dest], #32]\n"
+			"add %[dest], %[dest], #64\n"
+			"b.ne 1b\n"
+			: [dest] "+r" (dest), [size] "+r" (size)
+			: [pattern] "r" (pattern)
+			: "v0", "v1", "cc", "memory");
+	}
+#elif MEM_OPS_IMPL_CURRENT == MEM_OPS_IMPL_NEON
+	uint32_t pattern = value;
+
+	(void)nontemporal;
+
+	__asm__ __volatile__(
+		".fpu neon\n"
+		"vdup.8 q0, %[pattern]\n"
+		"vmov q1, q0\n"
+		"1:\n"
+		"subs %[size], %[size], #64\n"
+		"vst1.8 {d0-d3}, [%[dest]]!\n"
+		"vst1.8 {d0-d3}, [%[dest]]!\n"
+		"bne 1b\n"
+		: [dest] "+r" (dest), [size] "+r" (size)
+		: [pattern] "r" (pattern)
+		: "d0", "d1", "d2", "d3", "cc", "memory");
+#else
+	uint32_t *target = (uint32_t *)dest;
+	uint32_t pattern = value * 0x01010101U;
+
+	(void)nontemporal;
+
+	while (size > 0)
+	{
+		target[0] = pattern; target[1] = pattern; target[2] = pattern; target[3] = pattern;
+		target[4] = pattern; target[5] = pattern; target[6] = pattern; target[7] = pattern;
+		target[8] = pattern; target[9] = pattern; target[10] = pattern; target[11] = pattern;
+		target[12] = pattern; target[13] = pattern; target[14] = pattern; target[15] = pattern;
+
+		target += 16;
+		size -= MEM_OPS_BLOCK_SIZE;
+	}
+#endif
+}
+
+/* Copy forward with the head and tail passed to the C library, overlap is only allowed when dest is below source */
+static void mem_ops_copy_forward(uint8_t *dest, const uint8_t *source, size_t size, size_t prefetch, BOOL nontemporal, BOOL overlap)
+{
+	size_t head;
+	size_t body;
+
+	/* The word loop needs the source and dest to share the same word alignment */
+	if (MEM_OPS_IMPL_CURRENT == MEM_OPS_IMPL_GENERIC && (((size_t)dest ^ (size_t)source) & 3) != 0)
+	{
+		if (overlap)
+			memmove(dest, source, size);
+		else
+			memcpy(dest, source, size);
+		return;
+	}
+
+	/* Align the destination to a block so no store splits a cache line */
+	head = (MEM_OPS_BLOCK_SIZE - ((size_t)dest & MEM_OPS_BLOCK_MASK)) & MEM_OPS_BLOCK_MASK;
+	if (head > 0)
+	{
+		if (overlap)
+			memmove(dest, source, head);
+		else
+			memcpy(dest, source, head);
+
+		dest += head;
+		source += head;
+		size -= head;
+	}
+
+	body = size & ~(size_t)MEM_OPS_BLOCK_MASK;
+	if (body > 0)
+	{
+		mem_ops_copy_blocks(dest, source, body, prefetch, nontemporal);
+
+		dest += body;
+		source += body;
+		size -= body;
+	}
+
+	if (size > 0)
+	{
+		if (overlap)
+			memmove(dest, source, size);
+		else
+			memcpy(dest, source, size);
+	}
+}
+
+/* Return the fastest of MEM_OPS_TUNE_REPEATS CPU copies (Clock ticks) */
+static int64_t mem_ops_time_cpu(uint8_t *dest, const uint8_t *source, size_t size, size_t prefetch, BOOL nontemporal)
+{
+	int64_t best = -1;
+	int64_t start;
+	int64_t elapsed;
+	uint32_t count;
+
+	for (count = 0; count < MEM_OPS_TUNE_REPEATS; count++)
+	{
+		start = clock_get_total();
+		mem_ops_copy_forward(dest, source, size, prefetch, nontemporal, FALSE);
+		elapsed = clock_get_total() - start;
+
+		if (best < 0 || elapsed < best)
+			best = elapsed;
+	}
+
+	return best;
+}
+
+/* Return the fastest of MEM_OPS_TUNE_REPEATS DMA copies (Clock ticks) or -1 if DMA failed */
+static int64_t mem_ops_time_dma(uint8_t *dest, uint8_t *source, size_t size)
+{
+	int64_t best = -1;
+	int64_t start;
+	int64_t elapsed;
+	uint32_t count;
+
+	for (count = 0; count < MEM_OPS_TUNE_REPEATS; count++)
+	{
+		start = clock_get_total();
+		if (dma_copy_memory(source, dest, size) != ERROR_SUCCESS)
+			return -1;
+		elapsed = clock_get_total() - start;
+
+		if (best < 0 || elapsed < best)
+			best = elapsed;
+	}
+
+	return best;
+}
+
+/* ============================================================================== */
+/* Memory Operations Functions */
+void * STDCALL mem_ops_copy(void *dest, const void *source, size_t size)
+{
+	mem_ops_start();
+
+	if (size < MEM_OPS_SMALL_SIZE)
+		return memcpy(dest, source, size);
+
+	mem_ops_copy_forward((uint8_t *)dest, (const uint8_t *)source, size, memops.config.prefetch, size >= memops.config.nonthreshold && !(memops.config.flags & MEM_OPS_FLAG_NO_NON_TEMPORAL), FALSE);
+
+	return dest;
+}
+
+void * STDCALL mem_ops_move(void *dest, const void *source, size_t size)
+{
+	mem_ops_start();
+
+	/* A destination inside the source must be copied backwards */
+	if (size < MEM_OPS_SMALL_SIZE || ((uint8_t *)dest > (const uint8_t *)source && (uint8_t *)dest < (const uint8_t *)source + size))
+		return memmove(dest, source, size);
+
+	mem_ops_copy_forward((uint8_t *)dest, (const uint8_t *)source, size, memops.config.prefetch, FALSE, TRUE);
+
+	return dest;
+}
+
+void * STDCALL mem_ops_set(void *dest, int value, size_t size)
+{
+	uint8_t *target = (uint8_t *)dest;
+	size_t head;
+	size_t body;
+
+	mem_ops_start();
+
+	if (size < MEM_OPS_SMALL_SIZE)
+		return memset(dest, value, size);
+
+	head = (MEM_OPS_BLOCK_SIZE - ((size_t)target & MEM_OPS_BLOCK_MASK)) & MEM_OPS_BLOCK_MASK;
+	if (head > 0)
+	{
+		memset(target, value, head);
+		target += head;
+		size -= head;
+	}
+
+	body = size & ~(size_t)MEM_OPS_BLOCK_MASK;
+	if (body > 0)
+	{
+		mem_ops_set_blocks(target, (uint8_t)value, body, body >= memops.config.nonthreshold && !(memops.config.flags & MEM_OPS_FLAG_NO_NON_TEMPORAL));
+		target += body;
+		size -= body;
+	}
+
+	if (size > 0)
+		memset(target, value, size);
+
+	return dest;
+}
+
+uint32_t STDCALL mem_ops_copy_auto(void *dest, const void *source, size_t size)
+{
+	BOOL overlap;
+	BOOL dma;
+
+	if (!dest || !source)
+		return ERROR_INVALID_PARAMETER;
+
+	mem_ops_start();
+
+	if (size == 0)
+		return ERROR_SUCCESS;
+
+	overlap = ((uint8_t *)dest < (const uint8_t *)source + size) && ((const uint8_t *)source < (uint8_t *)dest + size);
+	dma = !overlap && size >= memops.config.dmathreshold && size <= 0xFFFFFFFF && !(memops.config.flags & MEM_OPS_FLAG_NO_DMA) && dma_available();
+
+	if (dma)
+	{
+		if (dma_copy_memory((void *)source, dest, (uint32_t)size) == ERROR_SUCCESS)
+		{
+			spin_lock(memops.lock);
+			memops.statistics.dmacount++;
+			memops.statistics.dmabytes += size;
+			spin_unlock(memops.lock);
+
+			return ERROR_SUCCESS;
+		}
+
+		spin_lock(memops.lock);
+		memops.statistics.dmaerrors++;
+		spin_unlock(memops.lock);
+	}
+
+	if (overlap)
+		mem_ops_move(dest, source, size);
+	else
+		mem_ops_copy(dest, source, size);
+
+	spin_lock(memops.lock);
+	memops.statistics.cpucount++;
+	memops.statistics.cpubytes += size;
+	spin_unlock(memops.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL mem_ops_get_config(MEM_OPS_CONFIG *config)
+{
+	if (!config)
+		return ERROR_INVALID_PARAMETER;
+
+	mem_ops_start();
+
+	*config = memops.config;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL mem_ops_set_config(const MEM_OPS_CONFIG *config)
+{
+	if (!config)
+		return ERROR_INVALID_PARAMETER;
+
+	if (config->prefetch > MEM_OPS_MAX_PREFETCH)
+		return ERROR_INVALID_PARAMETER;
+
+	mem_ops_start();
+
+	/* The implementation and cache properties are read only */
+	memops.config.flags = config->flags;
+	memops.config.prefetch = config->prefetch;
+	memops.config.dmathreshold = config->dmathreshold;
+	memops.config.nonthreshold = (MEM_OPS_IMPL_CURRENT == MEM_OPS_IMPL_ARM64) ? config->nonthreshold : MEM_OPS_THRESHOLD_NEVER;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL mem_ops_tune(MEM_OPS_CONFIG *config)
+{
+	uint8_t *source;
+	uint8_t *dest;
+	size_t size;
+	size_t tunesize;
+	uint32_t index;
+	uint32_t prefetch;
+	uint32_t dmathreshold;
+	uint32_t nonthreshold;
+	int64_t best;
+	int64_t cputime;
+	int64_t othertime;
+
+	mem_ops_start();
+
+	source = malloc(MEM_OPS_TUNE_MAX_SIZE);
+	dest = malloc(MEM_OPS_TUNE_MAX_SIZE);
+	if (!source || !dest)
+	{
+		free(source);
+		free(dest);
+		return ERROR_NOT_ENOUGH_MEMORY;
+	}
+
+	memset(source, 0x5A, MEM_OPS_TUNE_MAX_SIZE);
+	memset(dest, 0, MEM_OPS_TUNE_MAX_SIZE);
+
+	/* Find the prefetch distance with a copy large enough to come from memory rather than cache */
+	tunesize = MEM_OPS_TUNE_MAX_SIZE;
+	if (memops.config.l2size > 0 && memops.config.l2size * 4 < tunesize)
+		tunesize = memops.config.l2size * 4;
+
+	prefetch = memops.config.prefetch;
+	best = -1;
+	for (index = 0; index < sizeof(memops_prefetch_distances) / sizeof(memops_prefetch_distances[0]); index++)
+	{
+		cputime = mem_ops_time_cpu(dest, source, tunesize, memops_prefetch_distances[index], FALSE);
+		if (best < 0 || cputime < best)
+		{
+			best = cputime;
+			prefetch = memops_prefetch_distances[index];
+		}
+	}
+
+	/* The thresholds are the smallest size from which the alternative stays faster at every larger size */
+	nonthreshold = MEM_OPS_THRESHOLD_NEVER;
+	if (MEM_OPS_IMPL_CURRENT == MEM_OPS_IMPL_ARM64 && !(memops.config.flags & MEM_OPS_FLAG_NO_NON_TEMPORAL))
+	{
+		for (size = MEM_OPS_TUNE_MIN_SIZE; size <= MEM_OPS_TUNE_MAX_SIZE; size *= 2)
+		{
+			cputime = mem_ops_time_cpu(dest, source, size, prefetch, FALSE);
+			othertime = mem_ops_time_cpu(dest, source, size, prefetch, TRUE);
+
+			if (othertime < cputime)
+			{
+				if (nonthreshold == MEM_OPS_THRESHOLD_NEVER)
+					nonthreshold = size;
+			}
+			else
+			{
+				nonthreshold = MEM_OPS_THRESHOLD_NEVER;
+			}
+		}
+	}
+
+	dmathreshold = MEM_OPS_THRESHOLD_NEVER;
+	if (dma_available() && !(memops.config.flags & MEM_OPS_FLAG_NO_DMA))
+	{
+		for (size = MEM_OPS_TUNE_MIN_SIZE; size <= MEM_OPS_TUNE_MAX_SIZE; size *= 2)
+		{
+			cputime = mem_ops_time_cpu(dest, source, size, prefetch, size >= nonthreshold);
+			othertime = mem_ops_time_dma(dest, source, size);
+			if (othertime < 0)
+			{
+				dmathreshold = MEM_OPS_THRESHOLD_NEVER;
+				break;
+			}
+
+			if (othertime < cputime)
+			{
+				if (dmathreshold == MEM_OPS_THRESHOLD_NEVER)
+					dmathreshold = size;
+			}
+			else
+			{
+				dmathreshold = MEM_OPS_THRESHOLD_NEVER;
+			}
+		}
+	}
+
+	free(source);
+	free(dest);
+
+	memops.config.prefetch = prefetch;
+	memops.config.nonthreshold = nonthreshold;
+	memops.config.dmathreshold = dmathreshold;
+
+	if (config)
+		*config = memops.config;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL mem_ops_get_statistics(MEM_OPS_STATISTICS *statistics)
+{
+	if (!statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	mem_ops_start();
+
+	spin_lock(memops.lock);
+	*statistics = memops.statistics;
+	spin_unlock(memops.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL mem_ops_reset_statistics(void)
+{
+	mem_ops_start();
+
+	spin_lock(memops.lock);
+	memset(&memops.statistics, 0, sizeof(MEM_OPS_STATISTICS));
+	spin_unlock(memops.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL mem_ops_implementation_to_string(uint32_t implementation, char *string, uint32_t len)
+{
+	const char *value;
+
+	if (!string || len == 0)
+		return 0;
+
+	switch (implementation)
+	{
+		case MEM_OPS_IMPL_GENERIC:
+			value = "generic";
+			break;
+		case MEM_OPS_IMPL_NEON:
+			value = "neon";
+			break;
+		case MEM_OPS_IMPL_ARM64:
+			value = "arm64";
+			break;
+		default:
+			value = "unknown";
+			break;
+	}
+
+	strncpy(string, value, len - 1);
+	string[len - 1] = '\0';
+
+	return strlen(string);
+}
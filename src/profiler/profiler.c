@@ -0,0 +1,919 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/profiler.h"
+
+/* Implementation of the statistical sampling profiler for Ultibo API
+ *
+ * The profiler hooks the local scheduler interrupt on each CPU, the interrupt
+ * handler is given the handle of the thread that was interrupted. At the requested
+ * rate the handler locates the exception return state (PC and CPSR) saved on the
+ * interrupted stack, records the PC and follows the frame pointer chain to build
+ * a call stack. The original scheduler handler is then called as normal.
+ *
+ * Samples are written to a buffer for each CPU which only that CPU writes and only
+ * the aggregation thread reads so no locks are needed at interrupt time, the
+ * aggregation thread merges them into a histogram of (Thread, Call stack) counts.
+ *
+ * The histogram is exported as collapsed stack text (one line per unique stack,
+ * frames separated by semicolons followed by the count) for use with flame graph
+ * tools. Addresses are written in hex and can be converted to function names on
+ * the host with tools/profiler_symbolize.py which runs addr2line against the kernel
+ * ELF file.
+ *
+ * Call stacks beyond the interrupted PC require code compiled with frame pointers
+ * (eg CFLAGS += -fno-omit-frame-pointer), only the 32-bit ARM exception frame
+ * layout is currently supported and profiler_start returns ERROR_NOT_SUPPORTED
+ * on other architectures.
+ *
+ * The scheduler interrupt is swapped while running on the CPU it belongs to with
+ * IRQ and FIQ masked, being a local interrupt it cannot occur on that CPU between
+ * the release of one handler and the request of the other. Only entries with the
+ * priority and flags that request_ex_irq or request_ex_fiq would give them are
+ * hooked, so the original is restored exactly when profiling stops.
+ */
+
+/* Text section bounds from the linker script (If available) */
+extern char _text_start[] __attribute__((weak));
+extern char _etext[] __attribute__((weak));
+
+/* ARM CPSR bits */
+#define PROFILER_CPSR_MODE_MASK	0x1F
+#define PROFILER_CPSR_MODE_USR	0x10
+#define PROFILER_CPSR_MODE_SYS	0x1F
+#define PROFILER_CPSR_IRQ_MASK	0x80
+#define PROFILER_CPSR_THUMB	0x20
+
+/* Profiler Sample */
+typedef struct _PROFILER_SAMPLE PROFILER_SAMPLE;
+struct _PROFILER_SAMPLE
+{
+	THREAD_HANDLE thread; // The interrupted thread
+	uint32_t depth; // Number of addresses in frames
+	size_t frames[PROFILER_MAX_DEPTH]; // Interrupted PC followed by the return addresses of each caller
+};
+
+/* Profiler Buffer (One per CPU, written only by the interrupt handler on that CPU) */
+typedef struct _PROFILER_BUFFER PROFILER_BUFFER;
+struct _PROFILER_BUFFER
+{
+	uint32_t head; // Next sample to write (Interrupt handler)
+	uint32_t tail; // Next sample to read (Aggregation thread)
+	uint32_t dropcount; // Samples discarded because the buffer was full
+	uint32_t missedcount; // Samples where the interrupted PC could not be located
+	int64_t last; // Time of the last sample (Microseconds)
+	PROFILER_SAMPLE samples[PROFILER_BUFFER_SAMPLES];
+};
+
+/* Profiler Hook (The original scheduler interrupt of a CPU) */
+typedef struct _PROFILER_HOOK PROFILER_HOOK;
+struct _PROFILER_HOOK
+{
+	uint32_t cpuid;
+	BOOL hooked;
+	INTERRUPT_ENTRY entry; // Original interrupt entry
+};
+
+/* Profiler Stack (An entry in the histogram) */
+typedef struct _PROFILER_STACK PROFILER_STACK;
+struct _PROFILER_STACK
+{
+	uint32_t count; // Number of samples with this thread and call stack (0 if the entry is free)
+	uint32_t hash;
+	PROFILER_SAMPLE sample;
+};
+
+/* Profiler State */
+typedef struct _PROFILER_STATE PROFILER_STATE;
+struct _PROFILER_STATE
+{
+	MUTEX_HANDLE lock; // Lock for the histogram and start/stop
+	volatile BOOL running;
+	BOOL stopping; // Set while waiting for the aggregation thread to exit
+	uint32_t flags;
+	uint32_t interval; // Interval between samples on each CPU (Microseconds)
+	uint32_t cpucount;
+	THREAD_HANDLE thread; // Aggregation thread
+	COMPLETION_HANDLE done; // Completed by the aggregation thread when it exits
+	PROFILER_BUFFER *buffers; // One per CPU
+	PROFILER_HOOK *hooks; // One per CPU
+	PROFILER_STACK *stacks; // Histogram (PROFILER_MAX_STACKS entries)
+	PROFILER_STATISTICS statistics;
+};
+
+static PROFILER_STATE profiler = {INVALID_HANDLE_VALUE};
+
+/* Export line callback */
+typedef uint32_t (*profiler_line_cb)(const char *line, void *data);
+
+/* ============================================================================== */
+/* Profiler Internal Functions */
+static BOOL profiler_valid_pc(size_t pc)
+{
+	if (pc == 0)
+		return FALSE;
+
+	if (_text_start && _etext)
+		return (pc >= (size_t)_text_start && pc < (size_t)_etext);
+
+	return TRUE;
+}
+
+/* Get the stack pointer of the interrupted (SYS mode) context */
+static size_t profiler_get_thread_sp(void)
+{
+	size_t value = 0;
+
+#if defined(__arm__)
+	uint32_t cpsr;
+
+	/* Switch to SYS mode to read the banked stack pointer, then restore the mode and interrupt state */
+	__asm__ volatile ("mrs %0, cpsr" : "=r" (cpsr));
+	__asm__ volatile ("cpsid if, #0x1F\n\tmov %0, sp\n\tmsr cpsr_c, %1" : "=&r" (value) : "r" (cpsr) : "memory");
+#endif
+
+	return value;
+}
+
+/* Capture the interrupted PC and call stack, returns the number of frames or 0 if not found */
+static uint32_t profiler_capture(THREAD_HANDLE thread, PROFILER_SAMPLE *sample)
+{
+	THREAD_ENTRY *entry = (THREAD_ENTRY *)thread;
+	size_t *stack;
+	size_t *frame;
+	size_t stacktop;
+	size_t stackbottom;
+	size_t fp;
+	size_t next;
+	uint32_t index;
+
+	sample->depth = 0;
+
+	stack = (size_t *)profiler_get_thread_sp();
+	if (!stack)
+		return 0;
+
+	/* Find the saved return state (PC, CPSR) pushed on exception entry */
+	frame = NULL;
+	for (index = 0; index < PROFILER_SCAN_WORDS; index++)
+	{
+		size_t pc = stack[index];
+		size_t cpsr = stack[index + 1];
+		uint32_t mode = cpsr & PROFILER_CPSR_MODE_MASK;
+
+		if ((mode == PROFILER_CPSR_MODE_SYS || mode == PROFILER_CPSR_MODE_USR) && (cpsr & PROFILER_CPSR_IRQ_MASK) == 0 && profiler_valid_pc(pc))
+		{
+			/* ARM code is word aligned */
+			if ((cpsr & PROFILER_CPSR_THUMB) == 0 && (pc & 3) != 0)
+				continue;
+
+			frame = &stack[index];
+			break;
+		}
+	}
+	if (!frame)
+		return 0;
+
+	sample->frames[sample->depth++] = frame[0];
+
+	if (profiler.flags & PROFILER_FLAG_PC_ONLY)
+		return sample->depth;
+
+	if (!entry || entry->signature != THREAD_SIGNATURE)
+		return sample->depth;
+
+	/* R0 to R12 and LR are saved below the return state, follow the frame pointer (R11) chain */
+	stacktop = (size_t)entry->stackbase;
+	stackbottom = stacktop - entry->stacksize;
+	fp = frame[-3];
+	while (sample->depth < PROFILER_MAX_DEPTH)
+	{
+		/* The frame pointer points to the saved LR with the previous frame pointer below it */
+		if (fp < stackbottom + sizeof(size_t) || fp >= stacktop || (fp & (sizeof(size_t) - 1)) != 0)
+			break;
+
+		if (!profiler_valid_pc(((size_t *)fp)[0]))
+			break;
+
+		sample->frames[sample->depth++] = ((size_t *)fp)[0];
+
+		next = ((size_t *)fp)[-1];
+		if (next <= fp)
+			break;
+
+		fp = next;
+	}
+
+	return sample->depth;
+}
+
+static THREAD_HANDLE STDCALL profiler_interrupt(uint32_t cpuid, THREAD_HANDLE thread, void *parameter)
+{
+	PROFILER_HOOK *hook = (PROFILER_HOOK *)parameter;
+
+	if (profiler.running)
+		profiler_sample(cpuid, thread);
+
+	/* Call the original scheduler handler */
+	return hook->entry.handlerex(cpuid, thread, hook->entry.parameter);
+}
+
+/* Check that re-requesting an interrupt entry gives back the same priority and flags */
+static BOOL profiler_entry_default(INTERRUPT_ENTRY *entry)
+{
+	if (entry->flags & INTERRUPT_FLAG_FIQ)
+		return (entry->priority == INTERRUPT_PRIORITY_FIQ && (entry->flags & ~(INTERRUPT_FLAG_FIQ | INTERRUPT_FLAG_LOCAL)) == 0);
+
+	return (entry->priority == INTERRUPT_PRIORITY_DEFAULT && (entry->flags & ~INTERRUPT_FLAG_LOCAL) == 0);
+}
+
+/* Replace one extended handler of a local interrupt with another, called on the CPU that owns the interrupt */
+static uint32_t profiler_swap_handler(PROFILER_HOOK *hook, interrupt_handler oldhandler, interrupt_ex_handler oldhandlerex, void *oldparameter, interrupt_handler newhandler, interrupt_ex_handler newhandlerex, void *newparameter)
+{
+	INTERRUPT_ENTRY *entry = &hook->entry;
+	IRQ_FIQ_MASK mask;
+	uint32_t status;
+
+	mask = save_irq_fiq();
+
+	if (entry->flags & INTERRUPT_FLAG_FIQ)
+	{
+		status = release_ex_fiq(hook->cpuid, entry->number, oldhandler, oldhandlerex, oldparameter);
+		if (status == ERROR_SUCCESS)
+		{
+			status = request_ex_fiq(hook->cpuid, entry->number, newhandler, newhandlerex, newparameter);
+			if (status != ERROR_SUCCESS)
+				request_ex_fiq(hook->cpuid, entry->number, oldhandler, oldhandlerex, oldparameter);
+		}
+	}
+	else
+	{
+		status = release_ex_irq(hook->cpuid, entry->number, oldhandler, oldhandlerex, oldparameter);
+		if (status == ERROR_SUCCESS)
+		{
+			status = request_ex_irq(hook->cpuid, entry->number, newhandler, newhandlerex, newparameter);
+			if (status != ERROR_SUCCESS)
+				request_ex_irq(hook->cpuid, entry->number, oldhandler, oldhandlerex, oldparameter);
+		}
+	}
+
+	restore_irq_fiq(mask);
+
+	return status;
+}
+
+/* Move the calling thread to a CPU, returns the previous affinity or 0 if the thread could not be moved */
+static uint32_t profiler_pin(uint32_t cpuid)
+{
+	THREAD_HANDLE thread = thread_get_current();
+	uint32_t affinity;
+	uint32_t retries;
+
+	affinity = thread_get_affinity(thread);
+	if (thread_set_affinity(thread, 1 << cpuid) != ERROR_SUCCESS)
+		return 0;
+
+	for (retries = 0; retries < PROFILER_PIN_RETRIES && cpu_get_current() != cpuid; retries++)
+		thread_yield();
+
+	if (cpu_get_current() != cpuid)
+	{
+		thread_set_affinity(thread, affinity);
+		return 0;
+	}
+
+	return affinity;
+}
+
+static uint32_t profiler_hook_cpu(PROFILER_HOOK *hook)
+{
+	INTERRUPT_ENTRY entry;
+	uint32_t affinity;
+	uint32_t number;
+	uint32_t start;
+	uint32_t count;
+	uint32_t status;
+
+	/* Find the local interrupt with an extended handler (The scheduler interrupt) */
+	start = get_local_interrupt_start();
+	count = get_local_interrupt_count();
+	for (number = start; number < start + count; number++)
+	{
+		if (get_local_interrupt_entry(hook->cpuid, number, 0, &entry) != ERROR_SUCCESS)
+			continue;
+		if (!entry.handlerex)
+			continue;
+
+		/* The profiler handler would be requested with a different priority or flags */
+		if (!profiler_entry_default(&entry))
+			return ERROR_NOT_SUPPORTED;
+
+		memcpy(&hook->entry, &entry, sizeof(INTERRUPT_ENTRY));
+
+		affinity = profiler_pin(hook->cpuid);
+		if (affinity == 0)
+			return ERROR_CAN_NOT_COMPLETE;
+
+		/* Replace the scheduler handler with the profiler handler */
+		status = profiler_swap_handler(hook, entry.handler, entry.handlerex, entry.parameter, NULL, profiler_interrupt, hook);
+		if (status == ERROR_SUCCESS)
+		{
+			/* Confirm the new entry matches the original before relying on being able to restore it */
+			if (get_local_interrupt_entry(hook->cpuid, number, 0, &entry) != ERROR_SUCCESS || entry.priority != hook->entry.priority || entry.flags != hook->entry.flags)
+			{
+				profiler_swap_handler(hook, NULL, profiler_interrupt, hook, hook->entry.handler, hook->entry.handlerex, hook->entry.parameter);
+				status = ERROR_NOT_SUPPORTED;
+			}
+		}
+
+		thread_set_affinity(thread_get_current(), affinity);
+
+		if (status != ERROR_SUCCESS)
+			return status;
+
+		hook->hooked = TRUE;
+
+		return ERROR_SUCCESS;
+	}
+
+	return ERROR_NOT_FOUND;
+}
+
+static void profiler_unhook_cpu(PROFILER_HOOK *hook)
+{
+	INTERRUPT_ENTRY *entry = &hook->entry;
+	uint32_t affinity;
+
+	if (!hook->hooked)
+		return;
+
+	/* If the thread cannot be moved leave the profiler handler in place, it passes every interrupt on once running is clear */
+	affinity = profiler_pin(hook->cpuid);
+	if (affinity == 0)
+		return;
+
+	if (profiler_swap_handler(hook, NULL, profiler_interrupt, hook, entry->handler, entry->handlerex, entry->parameter) == ERROR_SUCCESS)
+		hook->hooked = FALSE;
+
+	thread_set_affinity(thread_get_current(), affinity);
+}
+
+static uint32_t profiler_hash(PROFILER_SAMPLE *sample)
+{
+	uint32_t hash = (uint32_t)(size_t)sample->thread * 2654435761U;
+	uint32_t index;
+
+	for (index = 0; index < sample->depth; index++)
+		hash = (hash ^ (uint32_t)sample->frames[index]) * 16777619U;
+
+	return hash;
+}
+
+/* Add a sample to the histogram, caller must hold the profiler lock */
+static void profiler_aggregate(PROFILER_SAMPLE *sample)
+{
+	PROFILER_STACK *stack;
+	uint32_t hash;
+	uint32_t probe;
+	uint32_t slot;
+
+	hash = profiler_hash(sample);
+	for (probe = 0; probe < PROFILER_MAX_STACKS; probe++)
+	{
+		slot = (hash + probe) & (PROFILER_MAX_STACKS - 1);
+		stack = &profiler.stacks[slot];
+
+		if (stack->count == 0)
+		{
+			stack->hash = hash;
+			memcpy(&stack->sample, sample, sizeof(PROFILER_SAMPLE));
+			stack->count = 1;
+
+			profiler.statistics.stackcount++;
+			profiler.statistics.samplecount++;
+			return;
+		}
+
+		if (stack->hash == hash && stack->sample.thread == sample->thread && stack->sample.depth == sample->depth && memcmp(stack->sample.frames, sample->frames, sample->depth * sizeof(size_t)) == 0)
+		{
+			stack->count++;
+
+			profiler.statistics.samplecount++;
+			return;
+		}
+	}
+
+	profiler.statistics.overflowcount++;
+}
+
+/* Move samples from the CPU buffers to the histogram */
+static void profiler_drain(void)
+{
+	PROFILER_BUFFER *buffer;
+	uint32_t head;
+	uint32_t cpuid;
+
+	if (mutex_lock(profiler.lock) != ERROR_SUCCESS)
+		return;
+
+	for (cpuid = 0; cpuid < profiler.cpucount; cpuid++)
+	{
+		buffer = &profiler.buffers[cpuid];
+
+		head = __atomic_load_n(&buffer->head, __ATOMIC_ACQUIRE);
+		while (buffer->tail != head)
+		{
+			profiler_aggregate(&buffer->samples[buffer->tail & (PROFILER_BUFFER_SAMPLES - 1)]);
+
+			__atomic_store_n(&buffer->tail, buffer->tail + 1, __ATOMIC_RELEASE);
+		}
+	}
+
+	mutex_unlock(profiler.lock);
+}
+
+static ssize_t STDCALL profiler_execute(void *parameter)
+{
+	while (profiler.running)
+	{
+		thread_sleep(PROFILER_DRAIN_INTERVAL);
+
+		profiler_drain();
+	}
+
+	completion_complete(profiler.done);
+
+	return 0;
+}
+
+/* Wait for the aggregation thread to exit after clearing running, caller must not hold the profiler lock */
+static void profiler_join(void)
+{
+	completion_wait(profiler.done, INFINITE);
+
+	if (mutex_lock(profiler.lock) == ERROR_SUCCESS)
+	{
+		profiler.stopping = FALSE;
+
+		mutex_unlock(profiler.lock);
+	}
+}
+
+/* Format each histogram entry as a collapsed stack line, caller must hold the profiler lock */
+static uint32_t profiler_format(profiler_line_cb callback, void *data)
+{
+	PROFILER_STACK *stack;
+	char line[THREAD_NAME_LENGTH + (PROFILER_MAX_DEPTH * 20) + 32];
+	char name[THREAD_NAME_LENGTH];
+	uint32_t offset;
+	uint32_t status;
+	uint32_t slot;
+	int32_t index;
+
+	for (slot = 0; slot < PROFILER_MAX_STACKS; slot++)
+	{
+		stack = &profiler.stacks[slot];
+		if (stack->count == 0)
+			continue;
+
+		/* Thread name first then the frames from the outermost caller to the interrupted PC */
+		if (thread_get_name(stack->sample.thread, name, sizeof(name)) != ERROR_SUCCESS || name[0] == '\0')
+			snprintf(name, sizeof(name), "Thread 0x%08lx", (unsigned long)stack->sample.thread);
+
+		/* Semicolons separate frames in the collapsed format */
+		for (offset = 0; name[offset]; offset++)
+		{
+			if (name[offset] == ';')
+				name[offset] = '_';
+		}
+
+		offset = snprintf(line, sizeof(line), "%s", name);
+		if (stack->sample.depth == 0)
+			offset += snprintf(line + offset, sizeof(line) - offset, ";[unknown]");
+
+		for (index = stack->sample.depth - 1; index >= 0; index--)
+			offset += snprintf(line + offset, sizeof(line) - offset, ";0x%08lx", (unsigned long)stack->sample.frames[index]);
+
+		snprintf(line + offset, sizeof(line) - offset, " %u\n", (unsigned int)stack->count);
+
+		status = callback(line, data);
+		if (status != ERROR_SUCCESS)
+			return status;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+/* Export Buffer */
+typedef struct _PROFILER_EXPORT PROFILER_EXPORT;
+struct _PROFILER_EXPORT
+{
+	char *buffer;
+	uint32_t len;
+	uint32_t count;
+};
+
+static uint32_t profiler_line_buffer(const char *line, void *data)
+{
+	PROFILER_EXPORT *export = (PROFILER_EXPORT *)data;
+	uint32_t size = strlen(line);
+
+	/* Count the full size even when the buffer is too small */
+	if (export->buffer && export->count + size < export->len)
+		memcpy(export->buffer + export->count, line, size);
+
+	export->count += size;
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t profiler_line_file(const char *line, void *data)
+{
+	if (fputs(line, (FILE *)data) < 0)
+		return ERROR_WRITE_FAULT;
+
+	return ERROR_SUCCESS;
+}
+
+static uint32_t profiler_line_log(const char *line, void *data)
+{
+	char text[THREAD_NAME_LENGTH + (PROFILER_MAX_DEPTH * 20) + 32];
+	uint32_t size;
+
+	/* Logging adds its own line ending */
+	size = strlen(line);
+	if (size >= sizeof(text))
+		size = sizeof(text) - 1;
+
+	memcpy(text, line, size);
+	if (size > 0 && text[size - 1] == '\n')
+		size--;
+	text[size] = '\0';
+
+	logging_output(text);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Profiler Functions */
+uint32_t STDCALL profiler_start(uint32_t rate, uint32_t flags)
+{
+	MUTEX_HANDLE lock;
+	uint32_t cpuid;
+	uint32_t status;
+
+#if !defined(__arm__)
+	/* Only the 32-bit ARM exception frame can be located (See profiler_get_thread_sp) */
+	return ERROR_NOT_SUPPORTED;
+#endif
+
+	/* Create the lock on first use */
+	if (profiler.lock == INVALID_HANDLE_VALUE)
+	{
+		lock = mutex_create();
+		if (lock == INVALID_HANDLE_VALUE)
+			return ERROR_OPERATION_FAILED;
+
+		if (!__sync_bool_compare_and_swap(&profiler.lock, INVALID_HANDLE_VALUE, lock))
+			mutex_destroy(lock);
+	}
+
+	if (mutex_lock(profiler.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	if (profiler.running)
+	{
+		mutex_unlock(profiler.lock);
+		return ERROR_ALREADY_EXISTS;
+	}
+
+	/* A stop is still waiting for the previous aggregation thread */
+	if (profiler.stopping)
+	{
+		mutex_unlock(profiler.lock);
+		return ERROR_IN_USE;
+	}
+
+	if (rate == 0)
+		rate = PROFILER_DEFAULT_RATE;
+
+	/* Allocate the buffers and histogram on first start, the histogram is kept until cleared */
+	if (!profiler.stacks)
+	{
+		profiler.cpucount = cpu_get_count();
+		profiler.buffers = calloc(profiler.cpucount, sizeof(PROFILER_BUFFER));
+		profiler.hooks = calloc(profiler.cpucount, sizeof(PROFILER_HOOK));
+		profiler.stacks = calloc(PROFILER_MAX_STACKS, sizeof(PROFILER_STACK));
+		if (!profiler.done)
+			profiler.done = completion_create(COMPLETION_FLAG_NONE);
+		if (!profiler.buffers || !profiler.hooks || !profiler.stacks || profiler.done == INVALID_HANDLE_VALUE)
+		{
+			if (profiler.done != INVALID_HANDLE_VALUE)
+				completion_destroy(profiler.done);
+			profiler.done = 0;
+			free(profiler.buffers);
+			free(profiler.hooks);
+			free(profiler.stacks);
+			profiler.buffers = NULL;
+			profiler.hooks = NULL;
+			profiler.stacks = NULL;
+
+			mutex_unlock(profiler.lock);
+			return ERROR_NOT_ENOUGH_MEMORY;
+		}
+	}
+
+	profiler.flags = flags;
+	profiler.interval = 1000000 / rate;
+	profiler.statistics.rate = rate;
+	profiler.statistics.flags = flags;
+	profiler.statistics.cpucount = profiler.cpucount;
+	profiler.statistics.starttime = clock_microseconds();
+
+	profiler.running = TRUE;
+
+	/* Start the aggregation thread */
+	completion_reset(profiler.done);
+	profiler.thread = thread_create(profiler_execute, PROFILER_THREAD_STACK_SIZE, PROFILER_THREAD_PRIORITY, PROFILER_THREAD_NAME, NULL);
+	if (profiler.thread == INVALID_HANDLE_VALUE)
+	{
+		profiler.running = FALSE;
+
+		mutex_unlock(profiler.lock);
+		return ERROR_OPERATION_FAILED;
+	}
+
+	/* Hook the scheduler interrupt on each CPU */
+	if ((flags & PROFILER_FLAG_NO_HOOK) == 0)
+	{
+		for (cpuid = 0; cpuid < profiler.cpucount; cpuid++)
+		{
+			profiler.hooks[cpuid].cpuid = cpuid;
+
+			status = profiler_hook_cpu(&profiler.hooks[cpuid]);
+			if (status != ERROR_SUCCESS)
+			{
+				while (cpuid > 0)
+					profiler_unhook_cpu(&profiler.hooks[--cpuid]);
+
+				profiler.running = FALSE;
+				profiler.stopping = TRUE;
+
+				mutex_unlock(profiler.lock);
+
+				profiler_join();
+				return status;
+			}
+		}
+	}
+
+	mutex_unlock(profiler.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL profiler_stop(void)
+{
+	uint32_t cpuid;
+
+	if (profiler.lock == INVALID_HANDLE_VALUE)
+		return ERROR_NOT_READY;
+
+	if (mutex_lock(profiler.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	if (!profiler.running)
+	{
+		mutex_unlock(profiler.lock);
+		return ERROR_NOT_READY;
+	}
+
+	for (cpuid = 0; cpuid < profiler.cpucount; cpuid++)
+		profiler_unhook_cpu(&profiler.hooks[cpuid]);
+
+	/* The aggregation thread exits on the next interval */
+	profiler.running = FALSE;
+	profiler.stopping = TRUE;
+	profiler.statistics.duration += clock_microseconds() - profiler.statistics.starttime;
+
+	mutex_unlock(profiler.lock);
+
+	/* Collect any remaining samples once the aggregation thread has gone */
+	profiler_join();
+	profiler_drain();
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL profiler_clear(void)
+{
+	uint32_t cpuid;
+
+	if (profiler.lock == INVALID_HANDLE_VALUE || !profiler.stacks)
+		return ERROR_NOT_READY;
+
+	if (mutex_lock(profiler.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	memset(profiler.stacks, 0, PROFILER_MAX_STACKS * sizeof(PROFILER_STACK));
+
+	for (cpuid = 0; cpuid < profiler.cpucount; cpuid++)
+	{
+		profiler.buffers[cpuid].dropcount = 0;
+		profiler.buffers[cpuid].missedcount = 0;
+	}
+
+	profiler.statistics.samplecount = 0;
+	profiler.statistics.overflowcount = 0;
+	profiler.statistics.stackcount = 0;
+	profiler.statistics.duration = 0;
+	profiler.statistics.starttime = clock_microseconds();
+
+	mutex_unlock(profiler.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL profiler_sample(uint32_t cpuid, THREAD_HANDLE thread)
+{
+	PROFILER_BUFFER *buffer;
+	PROFILER_SAMPLE *sample;
+	int64_t now;
+
+	/* Called at interrupt time on the CPU being sampled */
+	if (!profiler.running || cpuid >= profiler.cpucount)
+		return ERROR_NOT_READY;
+
+	buffer = &profiler.buffers[cpuid];
+
+	now = clock_microseconds();
+	if (now - buffer->last < profiler.interval)
+		return ERROR_SUCCESS;
+	buffer->last = now;
+
+	if (buffer->head - __atomic_load_n(&buffer->tail, __ATOMIC_ACQUIRE) >= PROFILER_BUFFER_SAMPLES)
+	{
+		buffer->dropcount++;
+		return ERROR_INSUFFICIENT_BUFFER;
+	}
+
+	sample = &buffer->samples[buffer->head & (PROFILER_BUFFER_SAMPLES - 1)];
+	sample->thread = thread;
+	if (profiler_capture(thread, sample) == 0)
+		buffer->missedcount++;
+
+	__atomic_store_n(&buffer->head, buffer->head + 1, __ATOMIC_RELEASE);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL profiler_get_statistics(PROFILER_STATISTICS *statistics)
+{
+	uint32_t cpuid;
+
+	if (!statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	if (profiler.lock == INVALID_HANDLE_VALUE || !profiler.stacks)
+		return ERROR_NOT_READY;
+
+	if (mutex_lock(profiler.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	memcpy(statistics, &profiler.statistics, sizeof(PROFILER_STATISTICS));
+
+	/* Add the counts kept by each CPU */
+	statistics->dropcount = 0;
+	statistics->missedcount = 0;
+	for (cpuid = 0; cpuid < profiler.cpucount; cpuid++)
+	{
+		statistics->dropcount += profiler.buffers[cpuid].dropcount;
+		statistics->missedcount += profiler.buffers[cpuid].missedcount;
+	}
+
+	if (profiler.running)
+		statistics->duration += clock_microseconds() - profiler.statistics.starttime;
+
+	mutex_unlock(profiler.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL profiler_export(char *buffer, uint32_t len, uint32_t *count)
+{
+	PROFILER_EXPORT export;
+	uint32_t status;
+
+	if (!count)
+		return ERROR_INVALID_PARAMETER;
+
+	if (profiler.lock == INVALID_HANDLE_VALUE || !profiler.stacks)
+		return ERROR_NOT_READY;
+
+	profiler_drain();
+
+	if (mutex_lock(profiler.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	export.buffer = buffer;
+	export.len = len;
+	export.count = 0;
+
+	status = profiler_format(profiler_line_buffer, &export);
+
+	mutex_unlock(profiler.lock);
+
+	/* Count is the size required (Excluding the null terminator) */
+	*count = export.count;
+	if (status != ERROR_SUCCESS)
+		return status;
+
+	if (!buffer || export.count >= len)
+		return ERROR_INSUFFICIENT_BUFFER;
+
+	buffer[export.count] = '\0';
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL profiler_export_file(const char *filename)
+{
+	uint32_t status;
+	FILE *file;
+
+	if (!filename)
+		return ERROR_INVALID_PARAMETER;
+
+	if (profiler.lock == INVALID_HANDLE_VALUE || !profiler.stacks)
+		return ERROR_NOT_READY;
+
+	file = fopen(filename, "w");
+	if (!file)
+		return ERROR_OPEN_FAILED;
+
+	profiler_drain();
+
+	if (mutex_lock(profiler.lock) != ERROR_SUCCESS)
+	{
+		fclose(file);
+		return ERROR_CAN_NOT_COMPLETE;
+	}
+
+	status = profiler_format(profiler_line_file, file);
+
+	mutex_unlock(profiler.lock);
+
+	if (fclose(file) != 0 && status == ERROR_SUCCESS)
+		status = ERROR_WRITE_FAULT;
+
+	return status;
+}
+
+uint32_t STDCALL profiler_export_log(void)
+{
+	uint32_t status;
+
+	if (profiler.lock == INVALID_HANDLE_VALUE || !profiler.stacks)
+		return ERROR_NOT_READY;
+
+	profiler_drain();
+
+	if (mutex_lock(profiler.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	status = profiler_format(profiler_line_log, NULL);
+
+	mutex_unlock(profiler.lock);
+
+	return status;
+}
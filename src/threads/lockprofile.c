@@ -0,0 +1,978 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Call the original lock functions from this module */
+#define LOCK_PROFILE_INTERNAL
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/lockprofile.h"
+
+/* Implementation of the lock contention profiler for Ultibo API
+ *
+ * In a lock profiling build (make LOCK_PROFILE=1) calls to the spin lock, mutex,
+ * critical section and synchronizer lock functions are redirected to the instrumented
+ * versions in this module which record the acquisition and call the original.
+ *
+ * Contention is detected by checking the lock owner (or by a failed try lock for
+ * mutexes and critical sections which are then retried up to LOCK_PROFILE_SPIN_LIMIT
+ * times before blocking). Wait and hold times are measured with clock_get_count and
+ * accumulated for each lock handle and for each thread using the lock.
+ *
+ * Records are kept in a fixed table so that no memory is allocated while a lock is
+ * being acquired, each record is updated with interrupts disabled under a small
+ * atomic flag so the instrumented functions can be used from any context.
+ *
+ * The destroy functions are redirected as well so the record of a lock is freed
+ * with it, a lock created later with the same handle starts with a new record.
+ * Freed records are marked rather than emptied so lookups can still probe past
+ * them, adding and freeing records is serialized by a flag for the whole table
+ * while lookups of existing records do not take it.
+ */
+
+/* Handle value of a record that has been freed (Never a valid lock handle) */
+#define LOCK_PROFILE_HANDLE_FREED	INVALID_HANDLE_VALUE
+
+/* Lock Profile Thread (Wait and hold totals for one thread on a lock) */
+typedef struct _LOCK_PROFILE_THREAD LOCK_PROFILE_THREAD;
+struct _LOCK_PROFILE_THREAD
+{
+	THREAD_HANDLE thread;
+	uint64_t waittime;
+	uint64_t holdtime;
+};
+
+/* Lock Profile Record */
+typedef struct _LOCK_PROFILE_RECORD LOCK_PROFILE_RECORD;
+struct _LOCK_PROFILE_RECORD
+{
+	HANDLE handle; // Handle of the lock (0 if the record is free)
+	uint32_t locktype;
+	uint32_t flag; // Atomic flag protecting the statistics below
+	// Statistics
+	uint32_t acquirecount;
+	uint32_t contendedcount;
+	uint32_t failedcount;
+	uint64_t spincount;
+	uint64_t waittime;
+	uint32_t maxwaittime;
+	uint64_t holdtime;
+	uint32_t maxholdtime;
+	THREAD_HANDLE maxholder;
+	LOCK_PROFILE_THREAD threads[LOCK_PROFILE_MAX_THREADS];
+	// Owner (Protected by the lock being profiled)
+	THREAD_HANDLE owner;
+	uint32_t depth;
+	uint32_t acquiretime;
+};
+
+/* Lock Profile State */
+typedef struct _LOCK_PROFILE_STATE LOCK_PROFILE_STATE;
+struct _LOCK_PROFILE_STATE
+{
+	uint32_t flag; // Atomic flag serializing adding and freeing of records
+	uint32_t lockcount;
+	uint32_t overflowcount;
+	int64_t starttime; // Microseconds
+	int64_t starttotal; // Clock count (64-bit) at start time
+	LOCK_PROFILE_RECORD records[LOCK_PROFILE_MAX_LOCKS];
+};
+
+static LOCK_PROFILE_STATE lockprofile;
+
+/* ============================================================================== */
+/* Lock Profile Internal Functions */
+static inline IRQ_FIQ_MASK lock_profile_flag_lock(volatile uint32_t *flag)
+{
+	IRQ_FIQ_MASK mask = save_irq_fiq();
+
+	while (__sync_lock_test_and_set(flag, 1))
+	{
+		while (*flag)
+			;
+	}
+
+	return mask;
+}
+
+static inline void lock_profile_flag_unlock(volatile uint32_t *flag, IRQ_FIQ_MASK mask)
+{
+	__sync_lock_release(flag);
+
+	restore_irq_fiq(mask);
+}
+
+static inline IRQ_FIQ_MASK lock_profile_record_lock(LOCK_PROFILE_RECORD *record)
+{
+	return lock_profile_flag_lock(&record->flag);
+}
+
+static inline void lock_profile_record_unlock(LOCK_PROFILE_RECORD *record, IRQ_FIQ_MASK mask)
+{
+	lock_profile_flag_unlock(&record->flag, mask);
+}
+
+static inline BOOL lock_profile_record_used(LOCK_PROFILE_RECORD *record)
+{
+	return (record->handle != 0 && record->handle != LOCK_PROFILE_HANDLE_FREED);
+}
+
+/* Clear the statistics of a record, caller must hold the record flag or own an unpublished record */
+static void lock_profile_record_clear(LOCK_PROFILE_RECORD *record)
+{
+	record->acquirecount = 0;
+	record->contendedcount = 0;
+	record->failedcount = 0;
+	record->spincount = 0;
+	record->waittime = 0;
+	record->maxwaittime = 0;
+	record->holdtime = 0;
+	record->maxholdtime = 0;
+	record->maxholder = INVALID_HANDLE_VALUE;
+	memset(record->threads, 0, sizeof(record->threads));
+}
+
+static void lock_profile_start(void)
+{
+	lockprofile.starttime = clock_microseconds();
+	lockprofile.starttotal = clock_get_total();
+}
+
+static inline uint32_t lock_profile_slot(HANDLE handle)
+{
+	return ((uint32_t)(size_t)handle * 2654435761U) >> 16;
+}
+
+/* Find the record for a lock handle without adding it, returns NULL if not recorded */
+static LOCK_PROFILE_RECORD *lock_profile_lookup(HANDLE handle)
+{
+	LOCK_PROFILE_RECORD *record;
+	uint32_t probe;
+	uint32_t slot;
+
+	slot = lock_profile_slot(handle);
+	for (probe = 0; probe < LOCK_PROFILE_MAX_LOCKS; probe++)
+	{
+		record = &lockprofile.records[(slot + probe) & (LOCK_PROFILE_MAX_LOCKS - 1)];
+
+		if (record->handle == handle)
+			return record;
+
+		/* Freed records are passed over, an empty one ends the probe */
+		if (record->handle == 0)
+			break;
+	}
+
+	return NULL;
+}
+
+/* Find or add the record for a lock handle, returns NULL if the table is full */
+static LOCK_PROFILE_RECORD *lock_profile_find(HANDLE handle, uint32_t locktype)
+{
+	LOCK_PROFILE_RECORD *record;
+	LOCK_PROFILE_RECORD *free;
+	IRQ_FIQ_MASK mask;
+	uint32_t probe;
+	uint32_t slot;
+
+	if (handle == 0 || handle == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	if (lockprofile.starttime == 0)
+		lock_profile_start();
+
+	record = lock_profile_lookup(handle);
+	if (record)
+		return record;
+
+	mask = lock_profile_flag_lock(&lockprofile.flag);
+
+	/* Search again now that no other CPU can add the same handle, remembering the first free record */
+	free = NULL;
+	slot = lock_profile_slot(handle);
+	for (probe = 0; probe < LOCK_PROFILE_MAX_LOCKS; probe++)
+	{
+		record = &lockprofile.records[(slot + probe) & (LOCK_PROFILE_MAX_LOCKS - 1)];
+
+		if (record->handle == handle)
+		{
+			lock_profile_flag_unlock(&lockprofile.flag, mask);
+			return record;
+		}
+
+		if (record->handle == LOCK_PROFILE_HANDLE_FREED)
+		{
+			if (!free)
+				free = record;
+			continue;
+		}
+
+		if (record->handle == 0)
+		{
+			if (!free)
+				free = record;
+			break;
+		}
+	}
+
+	if (!free)
+	{
+		lock_profile_flag_unlock(&lockprofile.flag, mask);
+
+		__sync_fetch_and_add(&lockprofile.overflowcount, 1);
+		return NULL;
+	}
+
+	/* Fill in the record before the handle makes it visible to other CPUs */
+	lock_profile_record_clear(free);
+	free->locktype = locktype;
+	free->owner = INVALID_HANDLE_VALUE;
+	free->depth = 0;
+	free->acquiretime = 0;
+	__sync_synchronize();
+	free->handle = handle;
+
+	lockprofile.lockcount++;
+
+	lock_profile_flag_unlock(&lockprofile.flag, mask);
+
+	return free;
+}
+
+/* Free the record for a lock handle, called before the lock is destroyed */
+static void lock_profile_free(HANDLE handle)
+{
+	LOCK_PROFILE_RECORD *record;
+	IRQ_FIQ_MASK recordmask;
+	IRQ_FIQ_MASK mask;
+
+	if (handle == 0 || handle == INVALID_HANDLE_VALUE)
+		return;
+
+	mask = lock_profile_flag_lock(&lockprofile.flag);
+
+	record = lock_profile_lookup(handle);
+	if (record)
+	{
+		/* Wait for any snapshot of the record to finish */
+		recordmask = lock_profile_record_lock(record);
+		record->handle = LOCK_PROFILE_HANDLE_FREED;
+		lock_profile_record_unlock(record, recordmask);
+
+		lockprofile.lockcount--;
+	}
+
+	lock_profile_flag_unlock(&lockprofile.flag, mask);
+}
+
+/* Find or add the thread entry for a record, caller must hold the record flag */
+static LOCK_PROFILE_THREAD *lock_profile_find_thread(LOCK_PROFILE_RECORD *record, THREAD_HANDLE thread)
+{
+	uint32_t index;
+
+	for (index = 0; index < LOCK_PROFILE_MAX_THREADS; index++)
+	{
+		if (record->threads[index].thread == thread)
+			return &record->threads[index];
+
+		if (record->threads[index].thread == 0)
+		{
+			record->threads[index].thread = thread;
+			return &record->threads[index];
+		}
+	}
+
+	return NULL;
+}
+
+/* Account for an acquisition (Successful or not), Start is the clock count before waiting */
+static void lock_profile_acquired(LOCK_PROFILE_RECORD *record, uint32_t start, BOOL contended, uint32_t spins, uint32_t status, BOOL exclusive)
+{
+	LOCK_PROFILE_THREAD *entry;
+	THREAD_HANDLE thread;
+	IRQ_FIQ_MASK mask;
+	uint32_t now;
+	uint32_t wait;
+
+	if (!record)
+		return;
+
+	now = clock_get_count();
+	wait = now - start;
+	thread = thread_get_current();
+
+	mask = lock_profile_record_lock(record);
+
+	if (status == ERROR_SUCCESS)
+		record->acquirecount++;
+	else
+		record->failedcount++;
+	if (contended)
+		record->contendedcount++;
+	record->spincount += spins;
+	record->waittime += wait;
+	if (wait > record->maxwaittime)
+		record->maxwaittime = wait;
+
+	entry = lock_profile_find_thread(record, thread);
+	if (entry)
+		entry->waittime += wait;
+
+	lock_profile_record_unlock(record, mask);
+
+	/* Only the owner updates the owner fields */
+	if (status == ERROR_SUCCESS && exclusive)
+	{
+		if (record->owner == thread)
+		{
+			record->depth++;
+		}
+		else
+		{
+			record->owner = thread;
+			record->depth = 1;
+			record->acquiretime = now;
+		}
+	}
+}
+
+/* Account for a release, called by the owner before the lock is released */
+static void lock_profile_released(LOCK_PROFILE_RECORD *record)
+{
+	LOCK_PROFILE_THREAD *entry;
+	THREAD_HANDLE thread;
+	IRQ_FIQ_MASK mask;
+	uint32_t hold;
+
+	if (!record)
+		return;
+
+	thread = thread_get_current();
+	if (record->owner != thread)
+		return;
+
+	if (record->depth > 1)
+	{
+		record->depth--;
+		return;
+	}
+
+	hold = clock_get_count() - record->acquiretime;
+	record->owner = INVALID_HANDLE_VALUE;
+	record->depth = 0;
+
+	mask = lock_profile_record_lock(record);
+
+	record->holdtime += hold;
+	if (hold > record->maxholdtime)
+	{
+		record->maxholdtime = hold;
+		record->maxholder = thread;
+	}
+
+	entry = lock_profile_find_thread(record, thread);
+	if (entry)
+		entry->holdtime += hold;
+
+	lock_profile_record_unlock(record, mask);
+}
+
+static BOOL lock_profile_contended(THREAD_HANDLE owner)
+{
+	return (owner != INVALID_HANDLE_VALUE && owner != thread_get_current());
+}
+
+/* Copy a record to a snapshot entry, returns FALSE if the record was freed */
+static BOOL lock_profile_copy(LOCK_PROFILE_RECORD *record, LOCK_PROFILE_ENTRY *entry)
+{
+	IRQ_FIQ_MASK mask;
+	uint32_t index;
+
+	mask = lock_profile_record_lock(record);
+
+	if (!lock_profile_record_used(record))
+	{
+		lock_profile_record_unlock(record, mask);
+		return FALSE;
+	}
+
+	entry->handle = record->handle;
+	entry->locktype = record->locktype;
+	entry->acquirecount = record->acquirecount;
+	entry->contendedcount = record->contendedcount;
+	entry->failedcount = record->failedcount;
+	entry->spincount = record->spincount;
+	entry->waittime = record->waittime;
+	entry->maxwaittime = record->maxwaittime;
+	entry->holdtime = record->holdtime;
+	entry->maxholdtime = record->maxholdtime;
+	entry->maxholder = record->maxholder;
+	entry->topwaiter = INVALID_HANDLE_VALUE;
+	entry->topwaitertime = 0;
+	entry->topholder = INVALID_HANDLE_VALUE;
+	entry->topholdertime = 0;
+
+	for (index = 0; index < LOCK_PROFILE_MAX_THREADS; index++)
+	{
+		if (record->threads[index].thread == 0)
+			break;
+
+		if (record->threads[index].waittime > entry->topwaitertime)
+		{
+			entry->topwaiter = record->threads[index].thread;
+			entry->topwaitertime = record->threads[index].waittime;
+		}
+		if (record->threads[index].holdtime > entry->topholdertime)
+		{
+			entry->topholder = record->threads[index].thread;
+			entry->topholdertime = record->threads[index].holdtime;
+		}
+	}
+
+	lock_profile_record_unlock(record, mask);
+
+	return TRUE;
+}
+
+static uint32_t lock_profile_clock_rate(void)
+{
+	int64_t duration;
+
+	if (lockprofile.starttime == 0)
+		return 0;
+
+	/* Require at least 100ms for a usable estimate */
+	duration = clock_microseconds() - lockprofile.starttime;
+	if (duration < 100000)
+		return 0;
+
+	return (uint32_t)(((clock_get_total() - lockprofile.starttotal) * 1000000) / duration);
+}
+
+static const char *lock_profile_type_name(uint32_t locktype)
+{
+	switch (locktype)
+	{
+		case LOCK_PROFILE_TYPE_SPIN:
+			return "Spin";
+		case LOCK_PROFILE_TYPE_MUTEX:
+			return "Mutex";
+		case LOCK_PROFILE_TYPE_CRITICAL_SECTION:
+			return "CriticalSection";
+		case LOCK_PROFILE_TYPE_SYNCHRONIZER:
+			return "Synchronizer";
+	}
+
+	return "Unknown";
+}
+
+static void lock_profile_thread_name(THREAD_HANDLE thread, char *name, uint32_t len)
+{
+	if (thread == INVALID_HANDLE_VALUE)
+	{
+		snprintf(name, len, "None");
+		return;
+	}
+
+	if (thread_get_name(thread, name, len) != ERROR_SUCCESS || name[0] == '\0')
+		snprintf(name, len, "Thread 0x%08lx", (unsigned long)thread);
+}
+
+/* Convert clock counts to microseconds (Or leave as counts if the rate is not known) */
+static uint64_t lock_profile_to_us(uint64_t value, uint32_t clockrate)
+{
+	if (clockrate == 0)
+		return value;
+
+	return (value * 1000000) / clockrate;
+}
+
+/* ============================================================================== */
+/* Lock Profile Functions */
+uint32_t STDCALL lock_profile_snapshot(LOCK_PROFILE_ENTRY *buffer, uint32_t len, uint32_t *count)
+{
+	LOCK_PROFILE_ENTRY entry;
+	LOCK_PROFILE_RECORD *record;
+	uint32_t total;
+	uint32_t used;
+	uint32_t slot;
+	uint32_t index;
+
+	if (!count)
+		return ERROR_INVALID_PARAMETER;
+
+	if (!buffer && len > 0)
+		return ERROR_INVALID_PARAMETER;
+
+	total = 0;
+	used = 0;
+	for (slot = 0; slot < LOCK_PROFILE_MAX_LOCKS; slot++)
+	{
+		record = &lockprofile.records[slot];
+		if (!lock_profile_record_used(record))
+			continue;
+
+		if (!lock_profile_copy(record, &entry))
+			continue;
+
+		total++;
+
+		/* Keep the buffer sorted by total wait time (Largest first) */
+		index = used;
+		while (index > 0 && buffer[index - 1].waittime < entry.waittime)
+		{
+			if (index < len)
+				buffer[index] = buffer[index - 1];
+			index--;
+		}
+		if (index < len)
+		{
+			buffer[index] = entry;
+			if (used < len)
+				used++;
+		}
+	}
+
+	*count = total;
+	if (total > len)
+		return ERROR_INSUFFICIENT_BUFFER;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL lock_profile_get_statistics(LOCK_PROFILE_STATISTICS *statistics)
+{
+	if (!statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	statistics->lockcount = lockprofile.lockcount;
+	statistics->overflowcount = lockprofile.overflowcount;
+	statistics->clockrate = lock_profile_clock_rate();
+	statistics->starttime = lockprofile.starttime;
+	statistics->duration = 0;
+	if (lockprofile.starttime != 0)
+		statistics->duration = clock_microseconds() - lockprofile.starttime;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL lock_profile_reset(void)
+{
+	LOCK_PROFILE_RECORD *record;
+	IRQ_FIQ_MASK mask;
+	uint32_t slot;
+
+	/* Records are kept (Handles and owners remain valid), only the statistics are cleared */
+	for (slot = 0; slot < LOCK_PROFILE_MAX_LOCKS; slot++)
+	{
+		record = &lockprofile.records[slot];
+		if (!lock_profile_record_used(record))
+			continue;
+
+		mask = lock_profile_record_lock(record);
+
+		lock_profile_record_clear(record);
+
+		lock_profile_record_unlock(record, mask);
+	}
+
+	lockprofile.overflowcount = 0;
+	lock_profile_start();
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL lock_profile_dump(uint32_t limit)
+{
+	LOCK_PROFILE_STATISTICS statistics;
+	LOCK_PROFILE_ENTRY *entries;
+	LOCK_PROFILE_ENTRY *entry;
+	char waiter[THREAD_NAME_LENGTH];
+	char holder[THREAD_NAME_LENGTH];
+	char line[512];
+	const char *units;
+	uint32_t count;
+	uint32_t index;
+
+	lock_profile_get_statistics(&statistics);
+
+	if (limit == 0 || limit > statistics.lockcount)
+		limit = statistics.lockcount;
+
+	units = (statistics.clockrate != 0) ? "us" : "counts";
+
+	snprintf(line, sizeof(line), "Lock Profile: %u locks, %u overflows, clock rate %u, duration %lld ms", (unsigned int)statistics.lockcount, (unsigned int)statistics.overflowcount, (unsigned int)statistics.clockrate, (long long)(statistics.duration / 1000));
+	logging_output(line);
+
+	if (limit == 0)
+		return ERROR_SUCCESS;
+
+	entries = malloc(limit * sizeof(LOCK_PROFILE_ENTRY));
+	if (!entries)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	lock_profile_snapshot(entries, limit, &count);
+	if (count < limit)
+		limit = count;
+
+	for (index = 0; index < limit; index++)
+	{
+		entry = &entries[index];
+
+		lock_profile_thread_name(entry->topwaiter, waiter, sizeof(waiter));
+		lock_profile_thread_name(entry->topholder, holder, sizeof(holder));
+
+		snprintf(line, sizeof(line), "%s 0x%08lx: acquired %u contended %u (%u%%) failed %u spins %llu wait %llu max %llu hold %llu max %llu %s, top waiter %s (%llu) top holder %s (%llu)",
+			lock_profile_type_name(entry->locktype),
+			(unsigned long)entry->handle,
+			(unsigned int)entry->acquirecount,
+			(unsigned int)entry->contendedcount,
+			(unsigned int)(entry->acquirecount ? ((uint64_t)entry->contendedcount * 100) / entry->acquirecount : 0),
+			(unsigned int)entry->failedcount,
+			(unsigned long long)entry->spincount,
+			(unsigned long long)lock_profile_to_us(entry->waittime, statistics.clockrate),
+			(unsigned long long)lock_profile_to_us(entry->maxwaittime, statistics.clockrate),
+			(unsigned long long)lock_profile_to_us(entry->holdtime, statistics.clockrate),
+			(unsigned long long)lock_profile_to_us(entry->maxholdtime, statistics.clockrate),
+			units,
+			waiter,
+			(unsigned long long)lock_profile_to_us(entry->topwaitertime, statistics.clockrate),
+			holder,
+			(unsigned long long)lock_profile_to_us(entry->topholdertime, statistics.clockrate));
+		logging_output(line);
+	}
+
+	free(entries);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Lock Profile Instrumented Functions */
+/* Spin */
+static uint32_t lock_profile_spin_acquire(SPIN_HANDLE spin, uint32_t STDCALL (*lock)(SPIN_HANDLE))
+{
+	LOCK_PROFILE_RECORD *record;
+	uint32_t start;
+	uint32_t status;
+	BOOL contended;
+
+	record = lock_profile_find(spin, LOCK_PROFILE_TYPE_SPIN);
+	contended = lock_profile_contended(spin_owner(spin));
+	start = clock_get_count();
+
+	status = lock(spin);
+
+	lock_profile_acquired(record, start, contended, 0, status, TRUE);
+
+	return status;
+}
+
+static uint32_t lock_profile_spin_release(SPIN_HANDLE spin, uint32_t STDCALL (*unlock)(SPIN_HANDLE))
+{
+	lock_profile_released(lock_profile_find(spin, LOCK_PROFILE_TYPE_SPIN));
+
+	return unlock(spin);
+}
+
+uint32_t STDCALL lock_profile_spin_destroy(SPIN_HANDLE spin)
+{
+	lock_profile_free(spin);
+
+	return spin_destroy(spin);
+}
+
+uint32_t STDCALL lock_profile_spin_lock(SPIN_HANDLE spin)
+{
+	return lock_profile_spin_acquire(spin, spin_lock);
+}
+
+uint32_t STDCALL lock_profile_spin_unlock(SPIN_HANDLE spin)
+{
+	return lock_profile_spin_release(spin, spin_unlock);
+}
+
+uint32_t STDCALL lock_profile_spin_lock_irq(SPIN_HANDLE spin)
+{
+	return lock_profile_spin_acquire(spin, spin_lock_irq);
+}
+
+uint32_t STDCALL lock_profile_spin_unlock_irq(SPIN_HANDLE spin)
+{
+	return lock_profile_spin_release(spin, spin_unlock_irq);
+}
+
+uint32_t STDCALL lock_profile_spin_lock_fiq(SPIN_HANDLE spin)
+{
+	return lock_profile_spin_acquire(spin, spin_lock_fiq);
+}
+
+uint32_t STDCALL lock_profile_spin_unlock_fiq(SPIN_HANDLE spin)
+{
+	return lock_profile_spin_release(spin, spin_unlock_fiq);
+}
+
+uint32_t STDCALL lock_profile_spin_lock_irq_fiq(SPIN_HANDLE spin)
+{
+	return lock_profile_spin_acquire(spin, spin_lock_irq_fiq);
+}
+
+uint32_t STDCALL lock_profile_spin_unlock_irq_fiq(SPIN_HANDLE spin)
+{
+	return lock_profile_spin_release(spin, spin_unlock_irq_fiq);
+}
+
+uint32_t STDCALL lock_profile_spin_lock_preempt(SPIN_HANDLE spin)
+{
+	return lock_profile_spin_acquire(spin, spin_lock_preempt);
+}
+
+uint32_t STDCALL lock_profile_spin_unlock_preempt(SPIN_HANDLE spin)
+{
+	return lock_profile_spin_release(spin, spin_unlock_preempt);
+}
+
+/* Mutex */
+uint32_t STDCALL lock_profile_mutex_destroy(MUTEX_HANDLE mutex)
+{
+	lock_profile_free(mutex);
+
+	return mutex_destroy(mutex);
+}
+
+uint32_t STDCALL lock_profile_mutex_lock(MUTEX_HANDLE mutex)
+{
+	LOCK_PROFILE_RECORD *record;
+	uint32_t start;
+	uint32_t spins;
+	uint32_t status;
+
+	record = lock_profile_find(mutex, LOCK_PROFILE_TYPE_MUTEX);
+	start = clock_get_count();
+
+	status = mutex_try_lock(mutex);
+	if (status == ERROR_SUCCESS)
+	{
+		lock_profile_acquired(record, start, FALSE, 0, status, TRUE);
+		return status;
+	}
+
+	/* Contended, retry before blocking */
+	for (spins = 1; spins <= LOCK_PROFILE_SPIN_LIMIT; spins++)
+	{
+		status = mutex_try_lock(mutex);
+		if (status == ERROR_SUCCESS)
+		{
+			lock_profile_acquired(record, start, TRUE, spins, status, TRUE);
+			return status;
+		}
+	}
+
+	status = mutex_lock(mutex);
+
+	lock_profile_acquired(record, start, TRUE, LOCK_PROFILE_SPIN_LIMIT, status, TRUE);
+
+	return status;
+}
+
+uint32_t STDCALL lock_profile_mutex_unlock(MUTEX_HANDLE mutex)
+{
+	lock_profile_released(lock_profile_find(mutex, LOCK_PROFILE_TYPE_MUTEX));
+
+	return mutex_unlock(mutex);
+}
+
+uint32_t STDCALL lock_profile_mutex_try_lock(MUTEX_HANDLE mutex)
+{
+	LOCK_PROFILE_RECORD *record;
+	uint32_t start;
+	uint32_t status;
+
+	record = lock_profile_find(mutex, LOCK_PROFILE_TYPE_MUTEX);
+	start = clock_get_count();
+
+	status = mutex_try_lock(mutex);
+
+	lock_profile_acquired(record, start, status != ERROR_SUCCESS, 0, status, TRUE);
+
+	return status;
+}
+
+/* Critical Section */
+uint32_t STDCALL lock_profile_critical_section_destroy(CRITICAL_SECTION_HANDLE criticalsection)
+{
+	lock_profile_free(criticalsection);
+
+	return critical_section_destroy(criticalsection);
+}
+
+uint32_t STDCALL lock_profile_critical_section_lock(CRITICAL_SECTION_HANDLE criticalsection)
+{
+	return lock_profile_critical_section_lock_ex(criticalsection, INFINITE);
+}
+
+uint32_t STDCALL lock_profile_critical_section_lock_ex(CRITICAL_SECTION_HANDLE criticalsection, uint32_t timeout)
+{
+	LOCK_PROFILE_RECORD *record;
+	uint32_t start;
+	uint32_t spins;
+	uint32_t status;
+
+	record = lock_profile_find(criticalsection, LOCK_PROFILE_TYPE_CRITICAL_SECTION);
+	start = clock_get_count();
+
+	status = critical_section_try_lock(criticalsection);
+	if (status == ERROR_SUCCESS)
+	{
+		lock_profile_acquired(record, start, FALSE, 0, status, TRUE);
+		return status;
+	}
+
+	/* Contended, retry before blocking (Unless no wait was requested) */
+	spins = 0;
+	if (timeout != 0)
+	{
+		for (spins = 1; spins <= LOCK_PROFILE_SPIN_LIMIT; spins++)
+		{
+			status = critical_section_try_lock(criticalsection);
+			if (status == ERROR_SUCCESS)
+			{
+				lock_profile_acquired(record, start, TRUE, spins, status, TRUE);
+				return status;
+			}
+		}
+		spins = LOCK_PROFILE_SPIN_LIMIT;
+	}
+
+	if (timeout == INFINITE)
+		status = critical_section_lock(criticalsection);
+	else
+		status = critical_section_lock_ex(criticalsection, timeout);
+
+	lock_profile_acquired(record, start, TRUE, spins, status, TRUE);
+
+	return status;
+}
+
+uint32_t STDCALL lock_profile_critical_section_unlock(CRITICAL_SECTION_HANDLE criticalsection)
+{
+	lock_profile_released(lock_profile_find(criticalsection, LOCK_PROFILE_TYPE_CRITICAL_SECTION));
+
+	return critical_section_unlock(criticalsection);
+}
+
+uint32_t STDCALL lock_profile_critical_section_try_lock(CRITICAL_SECTION_HANDLE criticalsection)
+{
+	LOCK_PROFILE_RECORD *record;
+	uint32_t start;
+	uint32_t status;
+
+	record = lock_profile_find(criticalsection, LOCK_PROFILE_TYPE_CRITICAL_SECTION);
+	start = clock_get_count();
+
+	status = critical_section_try_lock(criticalsection);
+
+	lock_profile_acquired(record, start, status != ERROR_SUCCESS, 0, status, TRUE);
+
+	return status;
+}
+
+/* Synchronizer */
+uint32_t STDCALL lock_profile_synchronizer_destroy(SYNCHRONIZER_HANDLE synchronizer)
+{
+	lock_profile_free(synchronizer);
+
+	return synchronizer_destroy(synchronizer);
+}
+
+uint32_t STDCALL lock_profile_synchronizer_reader_lock(SYNCHRONIZER_HANDLE synchronizer)
+{
+	return lock_profile_synchronizer_reader_lock_ex(synchronizer, INFINITE);
+}
+
+uint32_t STDCALL lock_profile_synchronizer_reader_lock_ex(SYNCHRONIZER_HANDLE synchronizer, uint32_t timeout)
+{
+	LOCK_PROFILE_RECORD *record;
+	uint32_t start;
+	uint32_t status;
+	BOOL contended;
+
+	record = lock_profile_find(synchronizer, LOCK_PROFILE_TYPE_SYNCHRONIZER);
+	contended = lock_profile_contended(synchronizer_writer_owner(synchronizer));
+	start = clock_get_count();
+
+	if (timeout == INFINITE)
+		status = synchronizer_reader_lock(synchronizer);
+	else
+		status = synchronizer_reader_lock_ex(synchronizer, timeout);
+
+	/* Readers share the lock so hold time is not recorded */
+	lock_profile_acquired(record, start, contended, 0, status, FALSE);
+
+	return status;
+}
+
+uint32_t STDCALL lock_profile_synchronizer_reader_unlock(SYNCHRONIZER_HANDLE synchronizer)
+{
+	return synchronizer_reader_unlock(synchronizer);
+}
+
+uint32_t STDCALL lock_profile_synchronizer_writer_lock(SYNCHRONIZER_HANDLE synchronizer)
+{
+	return lock_profile_synchronizer_writer_lock_ex(synchronizer, INFINITE);
+}
+
+uint32_t STDCALL lock_profile_synchronizer_writer_lock_ex(SYNCHRONIZER_HANDLE synchronizer, uint32_t timeout)
+{
+	LOCK_PROFILE_RECORD *record;
+	uint32_t start;
+	uint32_t status;
+	BOOL contended;
+
+	record = lock_profile_find(synchronizer, LOCK_PROFILE_TYPE_SYNCHRONIZER);
+	contended = lock_profile_contended(synchronizer_writer_owner(synchronizer)) || synchronizer_reader_count(synchronizer) > 0;
+	start = clock_get_count();
+
+	if (timeout == INFINITE)
+		status = synchronizer_writer_lock(synchronizer);
+	else
+		status = synchronizer_writer_lock_ex(synchronizer, timeout);
+
+	lock_profile_acquired(record, start, contended, 0, status, TRUE);
+
+	return status;
+}
+
+uint32_t STDCALL lock_profile_synchronizer_writer_unlock(SYNCHRONIZER_HANDLE synchronizer)
+{
+	lock_profile_released(lock_profile_find(synchronizer, LOCK_PROFILE_TYPE_SYNCHRONIZER));
+
+	return synchronizer_writer_unlock(synchronizer);
+}
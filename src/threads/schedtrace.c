@@ -0,0 +1,1039 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Call the original thread functions from this module */
+#define SCHED_TRACE_INTERNAL
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/schedtrace.h"
+
+/* Implementation of the scheduler trace recorder for Ultibo API
+ *
+ * Events are written with a timestamp from clock_get_total into a buffer for each
+ * CPU, only the CPU that owns a buffer writes to it (with IRQ and FIQ masked) so
+ * recording needs no locks and costs a few dozen instructions per event.
+ *
+ * The scheduler does not provide trace hooks so the recorder replaces the local
+ * scheduler interrupt handler on each CPU with a wrapper which records the entry and
+ * exit. The extended handler returns the thread to resume which gives each preemptive
+ * context switch exactly. Device interrupt handlers are not wrapped.
+ *
+ * The scheduler interrupt is swapped while running on the CPU it belongs to with
+ * IRQ and FIQ masked, being a local interrupt it cannot occur on that CPU between
+ * the release of one handler and the request of the other. Only entries with the
+ * priority and flags that request_ex_irq or request_ex_fiq would give them are
+ * hooked, so the original is restored exactly when tracing stops.
+ *
+ * Switches made by a thread yielding, sleeping or waiting (or on return from a device
+ * interrupt) do not pass through the scheduler interrupt, these are recorded (as
+ * SCHED_TRACE_REASON_INFERRED) at the next scheduler interrupt on the same CPU where
+ * a different thread is found to have been interrupted.
+ *
+ * In a scheduler trace build (make SCHED_TRACE=1) calls to thread_ready, thread_wake
+ * and thread_migrate are also recorded, the time from a wake or ready to the thread
+ * being switched in is reported as the wakeup latency in the JSON export.
+ *
+ * The binary capture (sched_trace_export or sched_trace_export_file) is much faster
+ * to write than the JSON export, it can be converted to the same JSON on the host
+ * with tools/schedtrace_json.py.
+ */
+
+/* Scheduler Trace Buffer (One per CPU, written only by that CPU) */
+typedef struct _SCHED_TRACE_BUFFER SCHED_TRACE_BUFFER;
+struct _SCHED_TRACE_BUFFER
+{
+	uint32_t head; // Total number of events written
+	uint32_t dropcount; // Events dropped or overwritten
+	uint32_t switchcount; // Context switches recorded
+	THREAD_HANDLE current; // Thread last known to be running (or INVALID_HANDLE_VALUE)
+	SCHED_TRACE_EVENT *events;
+};
+
+/* Scheduler Trace Hook (The scheduler interrupt of one CPU) */
+typedef struct _SCHED_TRACE_HOOK SCHED_TRACE_HOOK;
+struct _SCHED_TRACE_HOOK
+{
+	uint32_t cpuid; // CPU that owns the scheduler interrupt
+	BOOL hooked; // TRUE while the trace handler is in place
+	INTERRUPT_ENTRY entry; // Original interrupt entry
+};
+
+/* Scheduler Trace State */
+typedef struct _SCHED_TRACE_STATE SCHED_TRACE_STATE;
+struct _SCHED_TRACE_STATE
+{
+	MUTEX_HANDLE lock; // Lock for start, stop and export
+	volatile BOOL running;
+	uint32_t flags;
+	uint32_t cpucount;
+	uint32_t size; // Events in each buffer (Power of 2)
+	uint64_t starttotal; // Clock count at start
+	int64_t starttime; // Microseconds at start
+	uint32_t clockrate; // Calculated at stop (Counts per second)
+	SCHED_TRACE_BUFFER *buffers;
+	uint32_t hookcount; // CPUs with the trace handler in place
+	SCHED_TRACE_HOOK hooks[CPU_ID_31 + 1];
+};
+
+static SCHED_TRACE_STATE schedtrace = {INVALID_HANDLE_VALUE};
+
+/* ============================================================================== */
+/* Scheduler Trace Internal Functions */
+static inline BOOL sched_trace_valid_thread(THREAD_HANDLE thread)
+{
+	if (thread == 0 || thread == INVALID_HANDLE_VALUE)
+		return FALSE;
+
+	return (((THREAD_ENTRY *)thread)->signature == THREAD_SIGNATURE);
+}
+
+/* Write an event to the buffer of the current CPU, caller must have IRQ and FIQ masked */
+static inline void sched_trace_write(uint32_t cpuid, uint32_t eventtype, THREAD_HANDLE thread, THREAD_HANDLE other, uint32_t data)
+{
+	SCHED_TRACE_BUFFER *buffer = &schedtrace.buffers[cpuid];
+	SCHED_TRACE_EVENT *event;
+
+	if (buffer->head >= schedtrace.size)
+	{
+		buffer->dropcount++;
+
+		if ((schedtrace.flags & SCHED_TRACE_FLAG_WRAP) == 0)
+			return;
+	}
+
+	event = &buffer->events[buffer->head & (schedtrace.size - 1)];
+	event->timestamp = clock_get_total();
+	event->eventtype = eventtype;
+	event->cpuid = cpuid;
+	event->data = data;
+	event->thread = thread;
+	event->other = other;
+
+	buffer->head++;
+}
+
+/* Record a context switch from Thread to Next on this CPU */
+static void sched_trace_switch(uint32_t cpuid, THREAD_HANDLE thread, THREAD_HANDLE next, uint32_t reason)
+{
+	THREAD_ENTRY *prev = (THREAD_ENTRY *)thread;
+	THREAD_ENTRY *entry = (THREAD_ENTRY *)next;
+	uint32_t state = 0;
+	uint32_t priority = 0;
+
+	if (sched_trace_valid_thread(thread))
+	{
+		state = prev->state;
+		priority = prev->priority;
+	}
+
+	sched_trace_write(cpuid, SCHED_TRACE_EVENT_SWITCH, thread, next, SCHED_TRACE_SWITCH_DATA(state, priority, entry->priority, reason));
+	schedtrace.buffers[cpuid].switchcount++;
+	schedtrace.buffers[cpuid].current = next;
+
+	/* The saved CPU is still the CPU of the last run until the switch completes */
+	if (entry->currentcpu != cpuid)
+		sched_trace_write(cpuid, SCHED_TRACE_EVENT_MIGRATE, next, INVALID_HANDLE_VALUE, entry->currentcpu);
+}
+
+/* Check the running thread against the last known, records an inferred switch if different */
+static inline void sched_trace_observe(uint32_t cpuid, THREAD_HANDLE thread)
+{
+	THREAD_HANDLE current = schedtrace.buffers[cpuid].current;
+
+	if (thread == current || !sched_trace_valid_thread(thread))
+		return;
+
+	sched_trace_switch(cpuid, current, thread, SCHED_TRACE_REASON_INFERRED);
+}
+
+static THREAD_HANDLE STDCALL sched_trace_interrupt(uint32_t cpuid, THREAD_HANDLE thread, void *parameter)
+{
+	SCHED_TRACE_HOOK *hook = (SCHED_TRACE_HOOK *)parameter;
+	IRQ_FIQ_MASK mask;
+	THREAD_HANDLE next;
+
+	if (!schedtrace.running)
+		return hook->entry.handlerex(cpuid, thread, hook->entry.parameter);
+
+	/* FIQ is still enabled if the scheduler interrupt is an IRQ, mask both so each write completes */
+	mask = save_irq_fiq();
+
+	sched_trace_observe(cpuid, thread);
+	sched_trace_write(cpuid, SCHED_TRACE_EVENT_IRQ_ENTER, thread, INVALID_HANDLE_VALUE, hook->entry.number);
+
+	restore_irq_fiq(mask);
+
+	next = hook->entry.handlerex(cpuid, thread, hook->entry.parameter);
+
+	mask = save_irq_fiq();
+
+	sched_trace_write(cpuid, SCHED_TRACE_EVENT_IRQ_EXIT, thread, INVALID_HANDLE_VALUE, hook->entry.number);
+
+	if (next != thread && sched_trace_valid_thread(next))
+		sched_trace_switch(cpuid, thread, next, SCHED_TRACE_REASON_PREEMPT);
+
+	restore_irq_fiq(mask);
+
+	return next;
+}
+
+/* Check an interrupt entry has the priority and flags that request_ex_irq or request_ex_fiq would give it */
+static BOOL sched_trace_entry_default(INTERRUPT_ENTRY *entry)
+{
+	if (entry->flags & INTERRUPT_FLAG_FIQ)
+		return (entry->priority == INTERRUPT_PRIORITY_FIQ && (entry->flags & ~(INTERRUPT_FLAG_FIQ | INTERRUPT_FLAG_LOCAL)) == 0);
+
+	return (entry->priority == INTERRUPT_PRIORITY_DEFAULT && (entry->flags & ~INTERRUPT_FLAG_LOCAL) == 0);
+}
+
+/* Replace one extended handler of a local interrupt with another, called on the CPU that owns the interrupt */
+static uint32_t sched_trace_replace(SCHED_TRACE_HOOK *hook, interrupt_ex_handler oldhandlerex, void *oldparameter, interrupt_ex_handler newhandlerex, void *newparameter)
+{
+	INTERRUPT_ENTRY *entry = &hook->entry;
+	IRQ_FIQ_MASK mask;
+	uint32_t status;
+
+	mask = save_irq_fiq();
+
+	if (entry->flags & INTERRUPT_FLAG_FIQ)
+	{
+		status = release_ex_fiq(hook->cpuid, entry->number, NULL, oldhandlerex, oldparameter);
+		if (status == ERROR_SUCCESS)
+		{
+			status = request_ex_fiq(hook->cpuid, entry->number, NULL, newhandlerex, newparameter);
+			if (status != ERROR_SUCCESS)
+				request_ex_fiq(hook->cpuid, entry->number, NULL, oldhandlerex, oldparameter);
+		}
+	}
+	else
+	{
+		status = release_ex_irq(hook->cpuid, entry->number, NULL, oldhandlerex, oldparameter);
+		if (status == ERROR_SUCCESS)
+		{
+			status = request_ex_irq(hook->cpuid, entry->number, NULL, newhandlerex, newparameter);
+			if (status != ERROR_SUCCESS)
+				request_ex_irq(hook->cpuid, entry->number, NULL, oldhandlerex, oldparameter);
+		}
+	}
+
+	restore_irq_fiq(mask);
+
+	return status;
+}
+
+/* Move the calling thread to a CPU, returns the previous affinity or 0 if the thread could not be moved */
+static uint32_t sched_trace_pin(uint32_t cpuid)
+{
+	THREAD_HANDLE thread = thread_get_current();
+	uint32_t affinity;
+	uint32_t retries;
+
+	affinity = thread_get_affinity(thread);
+	if (thread_set_affinity(thread, 1 << cpuid) != ERROR_SUCCESS)
+		return 0;
+
+	for (retries = 0; retries < SCHED_TRACE_PIN_RETRIES && cpu_get_current() != cpuid; retries++)
+		thread_yield();
+
+	if (cpu_get_current() != cpuid)
+	{
+		thread_set_affinity(thread, affinity);
+		return 0;
+	}
+
+	return affinity;
+}
+
+/* Replace the scheduler interrupt handler of a CPU with the trace handler */
+static uint32_t sched_trace_hook(SCHED_TRACE_HOOK *hook)
+{
+	INTERRUPT_ENTRY entry;
+	uint32_t affinity;
+	uint32_t number;
+	uint32_t start;
+	uint32_t count;
+	uint32_t status;
+
+	/* Still in place from a stop that could not restore it */
+	if (hook->hooked)
+		return ERROR_SUCCESS;
+
+	/* Find the local interrupt with an extended handler (The scheduler interrupt) */
+	start = get_local_interrupt_start();
+	count = get_local_interrupt_count();
+	for (number = start; number < start + count; number++)
+	{
+		if (get_local_interrupt_entry(hook->cpuid, number, 0, &entry) != ERROR_SUCCESS)
+			continue;
+		if (!entry.handlerex || entry.handler || entry.sharedhandler)
+			continue;
+
+		/* The trace handler would be requested with a different priority or flags */
+		if (!sched_trace_entry_default(&entry))
+			return ERROR_NOT_SUPPORTED;
+
+		memcpy(&hook->entry, &entry, sizeof(INTERRUPT_ENTRY));
+
+		/* Being a local interrupt it cannot occur on its own CPU between the release and request */
+		affinity = sched_trace_pin(hook->cpuid);
+		if (affinity == 0)
+			return ERROR_CAN_NOT_COMPLETE;
+
+		status = sched_trace_replace(hook, entry.handlerex, entry.parameter, sched_trace_interrupt, hook);
+		if (status == ERROR_SUCCESS)
+		{
+			/* Confirm the new entry matches the original before relying on being able to restore it */
+			if (get_local_interrupt_entry(hook->cpuid, number, 0, &entry) != ERROR_SUCCESS || entry.priority != hook->entry.priority || entry.flags != hook->entry.flags)
+			{
+				sched_trace_replace(hook, sched_trace_interrupt, hook, hook->entry.handlerex, hook->entry.parameter);
+				status = ERROR_NOT_SUPPORTED;
+			}
+		}
+
+		thread_set_affinity(thread_get_current(), affinity);
+
+		if (status != ERROR_SUCCESS)
+			return status;
+
+		hook->hooked = TRUE;
+		schedtrace.hookcount++;
+
+		return ERROR_SUCCESS;
+	}
+
+	return ERROR_NOT_FOUND;
+}
+
+static void sched_trace_unhook(SCHED_TRACE_HOOK *hook)
+{
+	uint32_t affinity;
+
+	if (!hook->hooked)
+		return;
+
+	/* If the thread cannot be moved leave the trace handler in place, it passes every interrupt on once running is clear */
+	affinity = sched_trace_pin(hook->cpuid);
+	if (affinity == 0)
+		return;
+
+	if (sched_trace_replace(hook, sched_trace_interrupt, hook, hook->entry.handlerex, hook->entry.parameter) == ERROR_SUCCESS)
+	{
+		hook->hooked = FALSE;
+		schedtrace.hookcount--;
+	}
+
+	thread_set_affinity(thread_get_current(), affinity);
+}
+
+static void sched_trace_unhook_all(void)
+{
+	uint32_t cpuid;
+
+	/* Restore in reverse order */
+	for (cpuid = schedtrace.cpucount; cpuid > 0; cpuid--)
+		sched_trace_unhook(&schedtrace.hooks[cpuid - 1]);
+}
+
+static uint32_t sched_trace_clock_rate(void)
+{
+	int64_t duration;
+
+	if (schedtrace.clockrate != 0)
+		return schedtrace.clockrate;
+
+	if (schedtrace.starttime == 0)
+		return 0;
+
+	/* Require at least 100ms for a usable estimate */
+	duration = clock_microseconds() - schedtrace.starttime;
+	if (duration < 100000)
+		return 0;
+
+	return (uint32_t)(((clock_get_total() - schedtrace.starttotal) * 1000000) / duration);
+}
+
+/* Merge iterator over the buffers of all CPUs in timestamp order */
+typedef struct _SCHED_TRACE_CURSOR SCHED_TRACE_CURSOR;
+struct _SCHED_TRACE_CURSOR
+{
+	uint32_t next[CPU_ID_31 + 1];
+	uint32_t end[CPU_ID_31 + 1];
+};
+
+static uint32_t sched_trace_first(SCHED_TRACE_CURSOR *cursor)
+{
+	SCHED_TRACE_BUFFER *buffer;
+	uint32_t cpuid;
+	uint32_t total = 0;
+
+	for (cpuid = 0; cpuid < schedtrace.cpucount; cpuid++)
+	{
+		buffer = &schedtrace.buffers[cpuid];
+
+		cursor->end[cpuid] = buffer->head;
+		cursor->next[cpuid] = (buffer->head > schedtrace.size) ? buffer->head - schedtrace.size : 0;
+
+		total += cursor->end[cpuid] - cursor->next[cpuid];
+	}
+
+	return total;
+}
+
+static SCHED_TRACE_EVENT *sched_trace_next(SCHED_TRACE_CURSOR *cursor)
+{
+	SCHED_TRACE_EVENT *result = NULL;
+	SCHED_TRACE_EVENT *event;
+	uint32_t selected = 0;
+	uint32_t cpuid;
+
+	for (cpuid = 0; cpuid < schedtrace.cpucount; cpuid++)
+	{
+		if (cursor->next[cpuid] == cursor->end[cpuid])
+			continue;
+
+		event = &schedtrace.buffers[cpuid].events[cursor->next[cpuid] & (schedtrace.size - 1)];
+		if (!result || event->timestamp < result->timestamp)
+		{
+			result = event;
+			selected = cpuid;
+		}
+	}
+
+	if (result)
+		cursor->next[selected]++;
+
+	return result;
+}
+
+/* Check the trace can be exported, caller must hold the lock */
+static uint32_t sched_trace_check_export(void)
+{
+	if (!schedtrace.buffers)
+		return ERROR_NOT_READY;
+
+	/* Buffers are read without interrupts disabled so tracing must be stopped */
+	if (schedtrace.running)
+		return ERROR_IN_USE;
+
+	return ERROR_SUCCESS;
+}
+
+static void sched_trace_fill_header(SCHED_TRACE_HEADER *header, uint32_t eventcount)
+{
+	header->signature = SCHED_TRACE_SIGNATURE;
+	header->version = SCHED_TRACE_VERSION;
+	header->eventsize = sizeof(SCHED_TRACE_EVENT);
+	header->cpucount = schedtrace.cpucount;
+	header->clockrate = sched_trace_clock_rate();
+	header->eventcount = eventcount;
+	header->starttime = schedtrace.starttotal;
+}
+
+/* Write a thread name as a JSON string value */
+static void sched_trace_json_name(FILE *file, THREAD_HANDLE thread)
+{
+	char name[THREAD_NAME_LENGTH];
+	char *c;
+
+	if (!sched_trace_valid_thread(thread) || thread_get_name(thread, name, sizeof(name)) != ERROR_SUCCESS || name[0] == '\0')
+		snprintf(name, sizeof(name), "Thread 0x%08lx", (unsigned long)thread);
+
+	for (c = name; *c; c++)
+	{
+		if (*c == '"' || *c == '\\' || (unsigned char)*c < 0x20)
+			*c = '_';
+	}
+
+	fputs(name, file);
+}
+
+static const char *sched_trace_state_name(uint32_t state)
+{
+	switch (state)
+	{
+		case THREAD_STATE_RUNNING:
+			return "running";
+		case THREAD_STATE_READY:
+			return "ready";
+		case THREAD_STATE_SLEEP:
+			return "sleep";
+		case THREAD_STATE_SUSPENDED:
+			return "suspended";
+		case THREAD_STATE_WAIT:
+		case THREAD_STATE_WAIT_TIMEOUT:
+			return "wait";
+		case THREAD_STATE_RECEIVE:
+		case THREAD_STATE_RECEIVE_TIMEOUT:
+			return "receive";
+		case THREAD_STATE_HALTED:
+			return "halted";
+		case THREAD_STATE_TERMINATED:
+			return "terminated";
+	}
+
+	return "unknown";
+}
+
+static const char *sched_trace_reason_name(uint32_t reason)
+{
+	switch (reason)
+	{
+		case SCHED_TRACE_REASON_PREEMPT:
+			return "preempt";
+		case SCHED_TRACE_REASON_INFERRED:
+			return "inferred";
+	}
+
+	return "unknown";
+}
+
+/* ============================================================================== */
+/* Scheduler Trace Functions */
+uint32_t STDCALL sched_trace_start(uint32_t events, uint32_t flags)
+{
+	MUTEX_HANDLE lock;
+	uint32_t cpuid;
+	uint32_t status;
+
+	/* Create the lock on first use */
+	if (schedtrace.lock == INVALID_HANDLE_VALUE)
+	{
+		lock = mutex_create();
+		if (lock == INVALID_HANDLE_VALUE)
+			return ERROR_OPERATION_FAILED;
+
+		if (!__sync_bool_compare_and_swap(&schedtrace.lock, INVALID_HANDLE_VALUE, lock))
+			mutex_destroy(lock);
+	}
+
+	if (mutex_lock(schedtrace.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	if (schedtrace.running)
+	{
+		mutex_unlock(schedtrace.lock);
+		return ERROR_ALREADY_EXISTS;
+	}
+
+	if (events == 0)
+		events = SCHED_TRACE_DEFAULT_EVENTS;
+
+	/* Round down to a power of 2 */
+	while (events & (events - 1))
+		events &= events - 1;
+
+	/* Allocate the buffers (Reallocated if the size changes) */
+	if (schedtrace.buffers && schedtrace.size != events)
+	{
+		for (cpuid = 0; cpuid < schedtrace.cpucount; cpuid++)
+			free(schedtrace.buffers[cpuid].events);
+		free(schedtrace.buffers);
+		schedtrace.buffers = NULL;
+	}
+	if (!schedtrace.buffers)
+	{
+		schedtrace.cpucount = cpu_get_count();
+		schedtrace.size = events;
+		schedtrace.buffers = calloc(schedtrace.cpucount, sizeof(SCHED_TRACE_BUFFER));
+		if (!schedtrace.buffers)
+		{
+			mutex_unlock(schedtrace.lock);
+			return ERROR_NOT_ENOUGH_MEMORY;
+		}
+
+		for (cpuid = 0; cpuid < schedtrace.cpucount; cpuid++)
+		{
+			schedtrace.buffers[cpuid].events = malloc(events * sizeof(SCHED_TRACE_EVENT));
+			if (!schedtrace.buffers[cpuid].events)
+			{
+				while (cpuid > 0)
+					free(schedtrace.buffers[--cpuid].events);
+				free(schedtrace.buffers);
+				schedtrace.buffers = NULL;
+
+				mutex_unlock(schedtrace.lock);
+				return ERROR_NOT_ENOUGH_MEMORY;
+			}
+		}
+	}
+
+	/* Each start begins a new capture */
+	for (cpuid = 0; cpuid < schedtrace.cpucount; cpuid++)
+	{
+		schedtrace.buffers[cpuid].head = 0;
+		schedtrace.buffers[cpuid].dropcount = 0;
+		schedtrace.buffers[cpuid].switchcount = 0;
+		schedtrace.buffers[cpuid].current = INVALID_HANDLE_VALUE;
+	}
+
+	schedtrace.flags = flags;
+	schedtrace.clockrate = 0;
+	schedtrace.starttime = clock_microseconds();
+	schedtrace.starttotal = clock_get_total();
+
+	schedtrace.running = TRUE;
+
+	/* Hook the scheduler interrupt on each CPU */
+	if ((flags & SCHED_TRACE_FLAG_NO_HOOK) == 0)
+	{
+		for (cpuid = 0; cpuid < schedtrace.cpucount; cpuid++)
+		{
+			schedtrace.hooks[cpuid].cpuid = cpuid;
+
+			status = sched_trace_hook(&schedtrace.hooks[cpuid]);
+			if (status != ERROR_SUCCESS)
+			{
+				schedtrace.running = FALSE;
+
+				sched_trace_unhook_all();
+
+				mutex_unlock(schedtrace.lock);
+				return status;
+			}
+		}
+	}
+
+	mutex_unlock(schedtrace.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL sched_trace_stop(void)
+{
+	if (schedtrace.lock == INVALID_HANDLE_VALUE)
+		return ERROR_NOT_READY;
+
+	if (mutex_lock(schedtrace.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	if (!schedtrace.running)
+	{
+		mutex_unlock(schedtrace.lock);
+		return ERROR_NOT_READY;
+	}
+
+	schedtrace.running = FALSE;
+
+	sched_trace_unhook_all();
+
+	schedtrace.clockrate = sched_trace_clock_rate();
+
+	mutex_unlock(schedtrace.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL sched_trace_clear(void)
+{
+	IRQ_FIQ_MASK mask;
+	uint32_t cpuid;
+
+	if (schedtrace.lock == INVALID_HANDLE_VALUE || !schedtrace.buffers)
+		return ERROR_NOT_READY;
+
+	if (mutex_lock(schedtrace.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	for (cpuid = 0; cpuid < schedtrace.cpucount; cpuid++)
+	{
+		mask = save_irq_fiq();
+
+		schedtrace.buffers[cpuid].head = 0;
+		schedtrace.buffers[cpuid].dropcount = 0;
+		schedtrace.buffers[cpuid].switchcount = 0;
+
+		restore_irq_fiq(mask);
+	}
+
+	mutex_unlock(schedtrace.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL sched_trace_get_statistics(SCHED_TRACE_STATISTICS *statistics)
+{
+	SCHED_TRACE_BUFFER *buffer;
+	uint32_t cpuid;
+
+	if (!statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	memset(statistics, 0, sizeof(SCHED_TRACE_STATISTICS));
+
+	if (!schedtrace.buffers)
+		return ERROR_NOT_READY;
+
+	statistics->flags = schedtrace.flags;
+	statistics->cpucount = schedtrace.cpucount;
+	statistics->eventsize = schedtrace.size;
+	statistics->hookcount = schedtrace.hookcount;
+	statistics->clockrate = sched_trace_clock_rate();
+	statistics->running = schedtrace.running;
+
+	for (cpuid = 0; cpuid < schedtrace.cpucount; cpuid++)
+	{
+		buffer = &schedtrace.buffers[cpuid];
+
+		statistics->eventcount += (buffer->head > schedtrace.size) ? schedtrace.size : buffer->head;
+		statistics->dropcount += buffer->dropcount;
+		statistics->switchcount += buffer->switchcount;
+	}
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL sched_trace_mark(uint32_t value)
+{
+	return sched_trace_record(SCHED_TRACE_EVENT_MARK, thread_get_current(), INVALID_HANDLE_VALUE, value);
+}
+
+uint32_t STDCALL sched_trace_record(uint32_t eventtype, THREAD_HANDLE thread, THREAD_HANDLE other, uint32_t data)
+{
+	IRQ_FIQ_MASK mask;
+	uint32_t cpuid;
+
+	if (!schedtrace.running)
+		return ERROR_NOT_READY;
+
+	/* Interrupts disabled so the CPU cannot change and no interrupt can write to the same buffer */
+	mask = save_irq_fiq();
+
+	cpuid = cpu_get_current();
+	if (cpuid < schedtrace.cpucount)
+		sched_trace_write(cpuid, eventtype, thread, other, data);
+
+	restore_irq_fiq(mask);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL sched_trace_export(void *buffer, uint32_t len, uint32_t *count)
+{
+	SCHED_TRACE_CURSOR cursor;
+	SCHED_TRACE_HEADER *header;
+	SCHED_TRACE_EVENT *event;
+	SCHED_TRACE_EVENT *output;
+	uint32_t eventcount;
+	uint32_t status;
+
+	if (!count)
+		return ERROR_INVALID_PARAMETER;
+
+	if (schedtrace.lock == INVALID_HANDLE_VALUE)
+		return ERROR_NOT_READY;
+
+	if (mutex_lock(schedtrace.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	status = sched_trace_check_export();
+	if (status != ERROR_SUCCESS)
+	{
+		mutex_unlock(schedtrace.lock);
+		return status;
+	}
+
+	eventcount = sched_trace_first(&cursor);
+
+	*count = sizeof(SCHED_TRACE_HEADER) + (eventcount * sizeof(SCHED_TRACE_EVENT));
+	if (!buffer || len < *count)
+	{
+		mutex_unlock(schedtrace.lock);
+		return ERROR_INSUFFICIENT_BUFFER;
+	}
+
+	header = (SCHED_TRACE_HEADER *)buffer;
+	sched_trace_fill_header(header, eventcount);
+
+	output = (SCHED_TRACE_EVENT *)(header + 1);
+	while ((event = sched_trace_next(&cursor)) != NULL)
+		memcpy(output++, event, sizeof(SCHED_TRACE_EVENT));
+
+	mutex_unlock(schedtrace.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL sched_trace_export_file(const char *filename)
+{
+	SCHED_TRACE_CURSOR cursor;
+	SCHED_TRACE_HEADER header;
+	SCHED_TRACE_EVENT *event;
+	uint32_t status;
+	FILE *file;
+
+	if (!filename)
+		return ERROR_INVALID_PARAMETER;
+
+	if (schedtrace.lock == INVALID_HANDLE_VALUE)
+		return ERROR_NOT_READY;
+
+	if (mutex_lock(schedtrace.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	status = sched_trace_check_export();
+	if (status != ERROR_SUCCESS)
+	{
+		mutex_unlock(schedtrace.lock);
+		return status;
+	}
+
+	file = fopen(filename, "wb");
+	if (!file)
+	{
+		mutex_unlock(schedtrace.lock);
+		return ERROR_OPEN_FAILED;
+	}
+
+	sched_trace_fill_header(&header, sched_trace_first(&cursor));
+	if (fwrite(&header, sizeof(SCHED_TRACE_HEADER), 1, file) != 1)
+		status = ERROR_WRITE_FAULT;
+
+	while (status == ERROR_SUCCESS && (event = sched_trace_next(&cursor)) != NULL)
+	{
+		if (fwrite(event, sizeof(SCHED_TRACE_EVENT), 1, file) != 1)
+			status = ERROR_WRITE_FAULT;
+	}
+
+	if (fclose(file) != 0 && status == ERROR_SUCCESS)
+		status = ERROR_WRITE_FAULT;
+
+	mutex_unlock(schedtrace.lock);
+
+	return status;
+}
+
+uint32_t STDCALL sched_trace_export_json(const char *filename)
+{
+	SCHED_TRACE_CURSOR cursor;
+	SCHED_TRACE_EVENT *event;
+	THREAD_HANDLE wakethread[SCHED_TRACE_MAX_WAKES];
+	uint64_t waketime[SCHED_TRACE_MAX_WAKES];
+	uint64_t maxlatency[CPU_ID_31 + 1];
+	uint32_t irqdepth[CPU_ID_31 + 1];
+	BOOL threadopen[CPU_ID_31 + 1];
+	uint64_t lasttime = 0;
+	uint64_t latency;
+	uint32_t clockrate;
+	uint32_t status;
+	uint32_t cpuid;
+	uint32_t index;
+	uint32_t data;
+	double ts;
+	FILE *file;
+
+	if (!filename)
+		return ERROR_INVALID_PARAMETER;
+
+	if (schedtrace.lock == INVALID_HANDLE_VALUE)
+		return ERROR_NOT_READY;
+
+	if (mutex_lock(schedtrace.lock) != ERROR_SUCCESS)
+		return ERROR_CAN_NOT_COMPLETE;
+
+	status = sched_trace_check_export();
+	if (status != ERROR_SUCCESS)
+	{
+		mutex_unlock(schedtrace.lock);
+		return status;
+	}
+
+	clockrate = sched_trace_clock_rate();
+	if (clockrate == 0)
+	{
+		mutex_unlock(schedtrace.lock);
+		return ERROR_NOT_READY;
+	}
+
+	file = fopen(filename, "w");
+	if (!file)
+	{
+		mutex_unlock(schedtrace.lock);
+		return ERROR_OPEN_FAILED;
+	}
+
+	memset(wakethread, 0, sizeof(wakethread));
+	memset(maxlatency, 0, sizeof(maxlatency));
+	memset(irqdepth, 0, sizeof(irqdepth));
+	memset(threadopen, 0, sizeof(threadopen));
+
+	/* One track for each CPU, thread runs and interrupts are nested slices on the track */
+	fprintf(file, "{\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Ultibo\"}}");
+	for (cpuid = 0; cpuid < schedtrace.cpucount; cpuid++)
+		fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"CPU %u\"}}", (unsigned int)cpuid, (unsigned int)cpuid);
+
+	sched_trace_first(&cursor);
+	while ((event = sched_trace_next(&cursor)) != NULL)
+	{
+		cpuid = event->cpuid;
+		data = event->data;
+		lasttime = event->timestamp;
+		ts = ((double)(event->timestamp - schedtrace.starttotal) * 1000000.0) / clockrate;
+
+		switch (event->eventtype)
+		{
+			case SCHED_TRACE_EVENT_SWITCH:
+				/* Close any interrupt slices left open by a lost exit, then the previous thread */
+				while (irqdepth[cpuid] > 0)
+				{
+					fprintf(file, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}", ts, (unsigned int)cpuid);
+					irqdepth[cpuid]--;
+				}
+				if (threadopen[cpuid])
+					fprintf(file, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"state\":\"%s\"}}", ts, (unsigned int)cpuid, sched_trace_state_name(SCHED_TRACE_SWITCH_STATE(data)));
+
+				/* Wakeup latency if the next thread has a pending wake */
+				latency = 0;
+				for (index = 0; index < SCHED_TRACE_MAX_WAKES; index++)
+				{
+					if (wakethread[index] == event->other)
+					{
+						latency = ((event->timestamp - waketime[index]) * 1000000) / clockrate;
+						if (latency > maxlatency[cpuid])
+							maxlatency[cpuid] = latency;
+
+						wakethread[index] = 0;
+						break;
+					}
+				}
+
+				fprintf(file, ",\n{\"name\":\"");
+				sched_trace_json_name(file, event->other);
+				fprintf(file, "\",\"cat\":\"thread\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"handle\":\"0x%08lx\",\"priority\":%u,\"reason\":\"%s\",\"wake_latency_us\":%llu}}",
+					ts, (unsigned int)cpuid, (unsigned long)event->other, (unsigned int)SCHED_TRACE_SWITCH_NEXT_PRIORITY(data), sched_trace_reason_name(SCHED_TRACE_SWITCH_REASON(data)), (unsigned long long)latency);
+				threadopen[cpuid] = TRUE;
+				break;
+			case SCHED_TRACE_EVENT_IRQ_ENTER:
+				/* Start the interrupted thread slice if the capture began during it */
+				if (!threadopen[cpuid] && sched_trace_valid_thread(event->thread))
+				{
+					fprintf(file, ",\n{\"name\":\"");
+					sched_trace_json_name(file, event->thread);
+					fprintf(file, "\",\"cat\":\"thread\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"handle\":\"0x%08lx\"}}", ts, (unsigned int)cpuid, (unsigned long)event->thread);
+					threadopen[cpuid] = TRUE;
+				}
+
+				fprintf(file, ",\n{\"name\":\"IRQ %u\",\"cat\":\"irq\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}", (unsigned int)data, ts, (unsigned int)cpuid);
+				irqdepth[cpuid]++;
+				break;
+			case SCHED_TRACE_EVENT_IRQ_EXIT:
+				if (irqdepth[cpuid] > 0)
+				{
+					fprintf(file, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}", ts, (unsigned int)cpuid);
+					irqdepth[cpuid]--;
+				}
+				break;
+			case SCHED_TRACE_EVENT_WAKE:
+			case SCHED_TRACE_EVENT_READY:
+				/* Remember the time for the wakeup latency (Oldest pending entry is replaced if full) */
+				for (index = 0; index < SCHED_TRACE_MAX_WAKES; index++)
+				{
+					if (wakethread[index] == event->thread || wakethread[index] == 0)
+						break;
+				}
+				if (index == SCHED_TRACE_MAX_WAKES)
+				{
+					index = 0;
+					for (data = 1; data < SCHED_TRACE_MAX_WAKES; data++)
+					{
+						if (waketime[data] < waketime[index])
+							index = data;
+					}
+				}
+				if (wakethread[index] != event->thread)
+				{
+					wakethread[index] = event->thread;
+					waketime[index] = event->timestamp;
+				}
+
+				fprintf(file, ",\n{\"name\":\"%s ", (event->eventtype == SCHED_TRACE_EVENT_WAKE) ? "Wake" : "Ready");
+				sched_trace_json_name(file, event->thread);
+				fprintf(file, "\",\"cat\":\"wake\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"handle\":\"0x%08lx\"}}", ts, (unsigned int)cpuid, (unsigned long)event->thread);
+				break;
+			case SCHED_TRACE_EVENT_MIGRATE:
+			case SCHED_TRACE_EVENT_MIGRATE_REQUEST:
+				fprintf(file, ",\n{\"name\":\"%s ", (event->eventtype == SCHED_TRACE_EVENT_MIGRATE) ? "Migrate" : "Migrate Request");
+				sched_trace_json_name(file, event->thread);
+				fprintf(file, "\",\"cat\":\"migrate\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":0,\"tid\":%u,\"args\":{\"handle\":\"0x%08lx\",\"cpu\":%u}}", ts, (unsigned int)cpuid, (unsigned long)event->thread, (unsigned int)data);
+				break;
+			case SCHED_TRACE_EVENT_MARK:
+				fprintf(file, ",\n{\"name\":\"Mark %u\",\"cat\":\"mark\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}", (unsigned int)data, ts, (unsigned int)cpuid);
+				break;
+		}
+	}
+
+	/* Close any open slices at the time of the last event */
+	ts = ((double)(lasttime - schedtrace.starttotal) * 1000000.0) / clockrate;
+	for (cpuid = 0; cpuid < schedtrace.cpucount; cpuid++)
+	{
+		while (irqdepth[cpuid]-- > 0)
+			fprintf(file, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}", ts, (unsigned int)cpuid);
+		if (threadopen[cpuid])
+			fprintf(file, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}", ts, (unsigned int)cpuid);
+	}
+
+	fprintf(file, "\n],\n\"displayTimeUnit\":\"ns\",\n\"otherData\":{\"clockrate\":%u", (unsigned int)clockrate);
+	for (cpuid = 0; cpuid < schedtrace.cpucount; cpuid++)
+		fprintf(file, ",\"cpu%u_switches\":%u,\"cpu%u_dropped\":%u,\"cpu%u_max_wake_latency_us\":%llu", (unsigned int)cpuid, (unsigned int)schedtrace.buffers[cpuid].switchcount, (unsigned int)cpuid, (unsigned int)schedtrace.buffers[cpuid].dropcount, (unsigned int)cpuid, (unsigned long long)maxlatency[cpuid]);
+	fprintf(file, "}}\n");
+
+	if (ferror(file))
+		status = ERROR_WRITE_FAULT;
+	if (fclose(file) != 0 && status == ERROR_SUCCESS)
+		status = ERROR_WRITE_FAULT;
+
+	mutex_unlock(schedtrace.lock);
+
+	return status;
+}
+
+/* ============================================================================== */
+/* Scheduler Trace Instrumented Functions */
+uint32_t STDCALL sched_trace_thread_ready(THREAD_HANDLE thread, BOOL reschedule)
+{
+	sched_trace_record(SCHED_TRACE_EVENT_READY, thread, thread_get_current(), 0);
+
+	return thread_ready(thread, reschedule);
+}
+
+uint32_t STDCALL sched_trace_thread_wake(THREAD_HANDLE thread)
+{
+	sched_trace_record(SCHED_TRACE_EVENT_WAKE, thread, thread_get_current(), 0);
+
+	return thread_wake(thread);
+}
+
+uint32_t STDCALL sched_trace_thread_migrate(THREAD_HANDLE thread, uint32_t cpu)
+{
+	sched_trace_record(SCHED_TRACE_EVENT_MIGRATE_REQUEST, thread, thread_get_current(), cpu);
+
+	return thread_migrate(thread, cpu);
+}
@@ -0,0 +1,365 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/threadstats.h"
+
+/* Implementation of the per thread CPU accounting for Ultibo API
+ *
+ * thread_stats_get enumerates the threads from thread_snapshot_create, which copies
+ * the thread table while holding its lock, and copies only the accounting fields
+ * into an array supplied by the caller. The thread table lock is internal to the
+ * RTL and a thread destroyed while the table is walked may have its entry freed,
+ * so the table is never read directly even though the snapshot allocates an entry
+ * for every thread on each call.
+ *
+ * A history remembers the kernel time and switch count of each thread from the
+ * previous call so that deltas can be returned, in delta mode only threads that
+ * are new or have run since the previous call are returned. The history is an
+ * open addressed hash table keyed by handle, allocated once when it is created.
+ * A history must only be used by one caller at a time.
+ */
+
+/* Thread Statistics History Entry */
+typedef struct _THREAD_STATS_HISTORY_ENTRY THREAD_STATS_HISTORY_ENTRY;
+struct _THREAD_STATS_HISTORY_ENTRY
+{
+	THREAD_HANDLE handle; // Handle of the thread (0 if the entry is empty)
+	uint32_t generation; // Generation of the last call that saw the thread
+	int64_t kerneltime; // Kernel time from the last call that returned the thread
+	int64_t switchcount; // Switch count from the last call that returned the thread
+};
+
+/* Thread Statistics History */
+struct _THREAD_STATS_HISTORY
+{
+	uint32_t maxthreads; // Maximum number of threads tracked
+	uint32_t count; // Number of threads tracked
+	uint32_t mask; // Number of entries - 1 (Entries is a power of 2 at least twice maxthreads)
+	uint32_t generation; // Incremented by each call to thread_stats_get
+	THREAD_STATS_HISTORY_ENTRY *entries;
+};
+
+/* ============================================================================== */
+/* Thread Statistics Internal Functions */
+static uint32_t thread_stats_hash(THREAD_STATS_HISTORY *history, THREAD_HANDLE handle)
+{
+	/* Thread entries are heap blocks so the low bits carry little information */
+	return (uint32_t)(((uintptr_t)handle >> 4) * 2654435761U) & history->mask;
+}
+
+/* Find the entry for a thread, adding it if not found (Returns NULL if the history is full) */
+static THREAD_STATS_HISTORY_ENTRY *thread_stats_lookup(THREAD_STATS_HISTORY *history, THREAD_HANDLE handle, BOOL *found)
+{
+	THREAD_STATS_HISTORY_ENTRY *entry;
+	uint32_t index;
+
+	index = thread_stats_hash(history, handle);
+	while (TRUE)
+	{
+		entry = &history->entries[index];
+
+		if (entry->handle == handle)
+		{
+			*found = TRUE;
+			return entry;
+		}
+
+		if (entry->handle == 0)
+			break;
+
+		index = (index + 1) & history->mask;
+	}
+
+	*found = FALSE;
+
+	if (history->count >= history->maxthreads)
+		return NULL;
+
+	entry->handle = handle;
+	entry->kerneltime = 0;
+	entry->switchcount = 0;
+	history->count++;
+
+	return entry;
+}
+
+/* Remove the entry at index by moving later entries of the same probe sequence back */
+static void thread_stats_remove(THREAD_STATS_HISTORY *history, uint32_t index)
+{
+	uint32_t next;
+	uint32_t home;
+
+	next = index;
+	while (TRUE)
+	{
+		next = (next + 1) & history->mask;
+		if (history->entries[next].handle == 0)
+			break;
+
+		/* An entry can move back only if its home slot is not cyclically between index and next */
+		home = thread_stats_hash(history, history->entries[next].handle);
+		if (index <= next ? (index < home && home <= next) : (index < home || home <= next))
+			continue;
+
+		history->entries[index] = history->entries[next];
+		index = next;
+	}
+
+	memset(&history->entries[index], 0, sizeof(THREAD_STATS_HISTORY_ENTRY));
+	history->count--;
+}
+
+/* Remove threads that were not seen by the current call */
+static void thread_stats_sweep(THREAD_STATS_HISTORY *history)
+{
+	uint32_t index;
+
+	index = 0;
+	while (index <= history->mask)
+	{
+		/* The entry moved into a removed slot must be checked as well */
+		if (history->entries[index].handle != 0 && history->entries[index].generation != history->generation)
+			thread_stats_remove(history, index);
+		else
+			index++;
+	}
+}
+
+/* Stack free from the stack pointer saved at the last context switch, the stack base is the top and it grows down towards base - size */
+static uint32_t thread_stats_stack_free(void *stackbase, uint32_t stacksize, void *stackpointer)
+{
+	size_t stacktop = (size_t)stackbase;
+	size_t stackbottom = stacktop - stacksize;
+
+	if ((size_t)stackpointer > stackbottom && (size_t)stackpointer <= stacktop)
+		return (uint32_t)((size_t)stackpointer - stackbottom);
+
+	return 0;
+}
+
+/* Apply the history and delta filter to the statistics of one thread and copy them to the buffer if there is room */
+static void thread_stats_add(THREAD_STATS *buffer, uint32_t len, uint32_t flags, THREAD_STATS_HISTORY *history, uint32_t *matched, THREAD_STATS *sample)
+{
+	THREAD_STATS_HISTORY_ENTRY *previous;
+	BOOL found;
+
+	previous = NULL;
+	found = FALSE;
+	if (history)
+	{
+		previous = thread_stats_lookup(history, sample->handle, &found);
+		if (previous)
+			previous->generation = history->generation;
+	}
+
+	/* A thread without a history entry (new or history full) is always returned */
+	if ((flags & THREAD_STATS_FLAG_DELTA) && found && previous->kerneltime == sample->kerneltime && previous->switchcount == sample->switchcount)
+		return;
+
+	if (*matched < len)
+	{
+		sample->kerneldelta = found ? sample->kerneltime - previous->kerneltime : sample->kerneltime;
+		sample->switchdelta = found ? sample->switchcount - previous->switchcount : sample->switchcount;
+
+		memcpy(&buffer[*matched], sample, sizeof(THREAD_STATS));
+
+		/* Only threads that were returned are updated so no change is lost when the buffer is too small */
+		if (previous)
+		{
+			previous->kerneltime = sample->kerneltime;
+			previous->switchcount = sample->switchcount;
+		}
+	}
+
+	(*matched)++;
+}
+
+/* Enumerate from a thread snapshot, the RTL copies the thread table while holding its lock */
+static uint32_t thread_stats_get_snapshot(THREAD_STATS *buffer, uint32_t len, uint32_t flags, THREAD_STATS_HISTORY *history, uint32_t *matched)
+{
+	THREAD_SNAPSHOT *snapshot;
+	THREAD_SNAPSHOT *current;
+	THREAD_STATS sample;
+
+	snapshot = thread_snapshot_create();
+	if (!snapshot)
+		return ERROR_NOT_ENOUGH_MEMORY;
+
+	for (current = snapshot; current; current = current->next)
+	{
+		sample.handle = current->handle;
+		sample.cpu = current->cpu;
+		sample.state = current->state;
+		sample.priority = current->priority;
+		sample.stacksize = current->stacksize;
+		sample.kerneltime = current->kerneltime;
+		sample.switchcount = current->switchcount;
+
+		if (current->handle == thread_get_current())
+			sample.stackfree = thread_get_stack_free();
+		else
+			sample.stackfree = thread_stats_stack_free(current->stackbase, current->stacksize, current->stackpointer);
+
+		thread_stats_add(buffer, len, flags, history, matched, &sample);
+	}
+
+	thread_snapshot_destroy(snapshot);
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Thread Statistics Functions */
+THREAD_STATS_HISTORY * STDCALL thread_stats_history_create(uint32_t maxthreads)
+{
+	THREAD_STATS_HISTORY *history;
+	uint32_t size;
+
+	if (maxthreads == 0)
+		maxthreads = THREAD_STATS_DEFAULT_THREADS;
+
+	if (maxthreads > 0x10000000)
+		return NULL;
+
+	size = 1;
+	while (size < maxthreads * 2)
+		size <<= 1;
+
+	history = (THREAD_STATS_HISTORY *)calloc(1, sizeof(THREAD_STATS_HISTORY));
+	if (!history)
+		return NULL;
+
+	history->entries = (THREAD_STATS_HISTORY_ENTRY *)calloc(size, sizeof(THREAD_STATS_HISTORY_ENTRY));
+	if (!history->entries)
+	{
+		free(history);
+		return NULL;
+	}
+
+	history->maxthreads = maxthreads;
+	history->mask = size - 1;
+
+	return history;
+}
+
+uint32_t STDCALL thread_stats_history_destroy(THREAD_STATS_HISTORY *history)
+{
+	if (!history)
+		return ERROR_INVALID_PARAMETER;
+
+	free(history->entries);
+	free(history);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL thread_stats_history_reset(THREAD_STATS_HISTORY *history)
+{
+	if (!history)
+		return ERROR_INVALID_PARAMETER;
+
+	memset(history->entries, 0, (history->mask + 1) * sizeof(THREAD_STATS_HISTORY_ENTRY));
+	history->count = 0;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL thread_stats_get(THREAD_STATS *buffer, uint32_t len, uint32_t flags, THREAD_STATS_HISTORY *history, uint32_t *count)
+{
+	uint32_t matched;
+	uint32_t status;
+
+	if ((!buffer && len > 0) || !count)
+		return ERROR_INVALID_PARAMETER;
+
+	if ((flags & THREAD_STATS_FLAG_DELTA) && !history)
+		return ERROR_INVALID_PARAMETER;
+
+	if (history)
+		history->generation++;
+
+	matched = 0;
+	status = thread_stats_get_snapshot(buffer, len, flags, history, &matched);
+
+	/* Threads missed by a failed snapshot must not be dropped from the history */
+	if (status != ERROR_SUCCESS)
+		return status;
+
+	if (history)
+		thread_stats_sweep(history);
+
+	*count = matched;
+	if (matched > len)
+		return ERROR_INSUFFICIENT_BUFFER;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL thread_stats_get_cpu(uint32_t cpu, THREAD_STATS_CPU *statistics)
+{
+	static const uint32_t threadtypes[4] = {THREAD_TYPE_IDLE, THREAD_TYPE_IRQ, THREAD_TYPE_FIQ, THREAD_TYPE_SWI};
+	THREAD_HANDLE thread;
+	int64_t createtime;
+	int64_t exittime;
+	int64_t times[4];
+	uint32_t index;
+
+	if (!statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	if (cpu == CPU_ID_ALL)
+		cpu = cpu_get_current();
+	if (cpu >= cpu_get_count())
+		return ERROR_INVALID_PARAMETER;
+
+	/* Each CPU has its own Idle, IRQ, FIQ and SWI threads which are accounted like any other thread */
+	for (index = 0; index < 4; index++)
+	{
+		times[index] = 0;
+
+		thread = scheduler_get_thread_handle(cpu, threadtypes[index]);
+		if (thread == INVALID_HANDLE_VALUE)
+			continue;
+
+		if (thread_get_times(thread, &createtime, &exittime, &times[index]) != ERROR_SUCCESS)
+			times[index] = 0;
+	}
+
+	statistics->cpu = cpu;
+	statistics->threadcount = scheduler_get_thread_count(cpu);
+	statistics->utilization = cpu_get_utilization(cpu);
+	statistics->idletime = times[0];
+	statistics->irqtime = times[1];
+	statistics->fiqtime = times[2];
+	statistics->switime = times[3];
+
+	return ERROR_SUCCESS;
+}
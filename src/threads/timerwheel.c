@@ -0,0 +1,735 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/timerwheel.h"
+
+/* Implementation of the hierarchical timer wheel for Ultibo API
+ *
+ * The kernel timers (timer_create_ex etc) are kept in a single list sorted by
+ * delta key, so enabling a timer walks the list and costs O(n) with n timers
+ * active. The timer wheel keeps armed timers in 6 levels of 64 slots where each
+ * slot of level 0 is one millisecond and each slot of a higher level covers the
+ * whole of the level below, so arming and cancelling a timer are O(1).
+ *
+ * The wheel thread sleeps until the next timer is due, when it wakes it moves
+ * the slots of the higher levels down as the lower levels wrap and collects all
+ * timers expiring up to the current time into a batch. Events with the flag
+ * TIMER_FLAG_PRIORITY are executed directly by the wheel thread, TIMER_FLAG_WORKER
+ * events are passed to the worker pool and the rest are passed as one batch to
+ * the event thread, the same priorities as the kernel timer threads are used.
+ *
+ * A timer may be given slack, the expiry time is then rounded up within the
+ * slack to a boundary with as many low bits clear as possible so that timers
+ * armed close together expire in the same batch and need fewer cascades.
+ *
+ * TIMER_FLAG_RESCHEDULE timers are rearmed when the event completes, other timers
+ * become disabled when they expire unless the event enables them again. Enabling
+ * a timer that is already armed restarts its interval. Timer functions must not
+ * be called from interrupt handlers.
+ */
+
+#define TIMER_WHEEL_STATE_STOPPED	0
+#define TIMER_WHEEL_STATE_STARTING	1
+#define TIMER_WHEEL_STATE_STARTED	2
+
+#define TIMER_WHEEL_NEVER	0xFFFFFFFFFFFFFFFFULL
+
+/* Timer Wheel Timer */
+struct _TIMER_WHEEL_TIMER
+{
+	// Timer Properties
+	uint32_t signature; // Signature for entry validation
+	uint32_t interval; // Interval for timer (Milliseconds)
+	uint32_t state; // State of the timer (Enabled/Disabled)
+	uint32_t flags; // Timer Flags (eg TIMER_FLAG_RESCHEDULE)
+	uint32_t slack; // Maximum delay allowed for coalescing (Milliseconds)
+	timer_event_proc event; // Function to call when timer triggers
+	void *data; // Data to pass to function when timer triggers
+	// Internal Properties
+	uint64_t expires; // Wheel time when the timer expires (While armed)
+	uint32_t level; // Level of the slot holding the timer (While armed)
+	uint32_t slot; // Slot holding the timer (While armed)
+	BOOL armed; // The timer is in a slot
+	BOOL pending; // The timer has expired and the event has not completed
+	BOOL again; // The timer expired again before the event completed
+	BOOL destroyed; // The timer was destroyed while pending and is freed when the event completes
+	TIMER_WHEEL_TIMER *prev; // Previous timer in the slot
+	TIMER_WHEEL_TIMER *next; // Next timer in the slot
+	TIMER_WHEEL_TIMER *batchnext; // Next timer in the expired batch or event queue
+};
+
+/* Timer Wheel State */
+typedef struct _TIMER_WHEEL_STATE TIMER_WHEEL_STATE;
+struct _TIMER_WHEEL_STATE
+{
+	SPIN_HANDLE lock; // Lock for the wheel, timers and event queue
+	volatile uint32_t started; // Startup state (eg TIMER_WHEEL_STATE_STARTED)
+	int64_t base; // Value of clock_milliseconds at wheel time 0
+	uint64_t now; // Wheel time that has been processed
+	uint64_t wakeup; // Wheel time the wheel thread will next wake up
+	uint64_t occupied[TIMER_WHEEL_LEVELS]; // Bitmap of non empty slots for each level
+	TIMER_WHEEL_TIMER *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_LEVEL_SLOTS];
+	SEMAPHORE_HANDLE signal; // Signalled to wake the wheel thread
+	SEMAPHORE_HANDLE eventsignal; // Signalled when a batch is added to the event queue
+	TIMER_WHEEL_TIMER *eventfirst; // Event queue for the event thread
+	TIMER_WHEEL_TIMER *eventlast;
+	THREAD_HANDLE thread;
+	THREAD_HANDLE eventthread;
+	TIMER_WHEEL_STATISTICS statistics;
+};
+
+static TIMER_WHEEL_STATE timerwheel = {INVALID_HANDLE_VALUE};
+
+/* ============================================================================== */
+/* Timer Wheel Internal Functions */
+static uint64_t timer_wheel_current(void)
+{
+	return (uint64_t)(clock_milliseconds() - timerwheel.base);
+}
+
+static BOOL timer_wheel_check(TIMER_WHEEL_TIMER *timer)
+{
+	return (timer && timer->signature == TIMER_WHEEL_SIGNATURE);
+}
+
+/* Put a timer in the slot for its expiry time, caller must hold the wheel lock.
+ * An expiry time equal to now goes in the level 0 slot for now, which is only
+ * collected if the wheel is part way through advancing to now (See timer_wheel_cascade) */
+static void timer_wheel_insert(TIMER_WHEEL_TIMER *timer, uint64_t expires)
+{
+	TIMER_WHEEL_TIMER **head;
+	uint64_t delta;
+	uint32_t level;
+	uint32_t slot;
+
+	/* The lowest level where the expiry time is within one rotation */
+	delta = expires - timerwheel.now;
+	level = 0;
+	while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1ULL << (TIMER_WHEEL_LEVEL_BITS * (level + 1))))
+		level++;
+
+	slot = (expires >> (TIMER_WHEEL_LEVEL_BITS * level)) & TIMER_WHEEL_LEVEL_MASK;
+
+	timer->expires = expires;
+	timer->level = level;
+	timer->slot = slot;
+	timer->armed = TRUE;
+
+	head = &timerwheel.slots[level][slot];
+	timer->prev = NULL;
+	timer->next = *head;
+	if (*head)
+		(*head)->prev = timer;
+	*head = timer;
+
+	timerwheel.occupied[level] |= (1ULL << slot);
+	timerwheel.statistics.armedcount++;
+}
+
+/* Take a timer out of its slot, caller must hold the wheel lock */
+static void timer_wheel_remove(TIMER_WHEEL_TIMER *timer)
+{
+	TIMER_WHEEL_TIMER **head = &timerwheel.slots[timer->level][timer->slot];
+
+	if (timer->prev)
+		timer->prev->next = timer->next;
+	else
+		*head = timer->next;
+	if (timer->next)
+		timer->next->prev = timer->prev;
+
+	if (*head == NULL)
+		timerwheel.occupied[timer->level] &= ~(1ULL << timer->slot);
+
+	timer->prev = NULL;
+	timer->next = NULL;
+	timer->armed = FALSE;
+
+	timerwheel.statistics.armedcount--;
+}
+
+/* Arm a timer to expire after delay milliseconds, caller must hold the wheel lock.
+ * Returns TRUE if the wheel thread must be woken to see the new expiry time */
+static BOOL timer_wheel_arm(TIMER_WHEEL_TIMER *timer, uint32_t delay)
+{
+	uint64_t current;
+	uint64_t expires;
+	uint64_t limit;
+	uint32_t bit;
+
+	if (timer->armed)
+		timer_wheel_remove(timer);
+
+	/* An empty wheel can skip straight to the current time */
+	current = timer_wheel_current();
+	if (timerwheel.statistics.armedcount == 0 && current > timerwheel.now)
+		timerwheel.now = current;
+
+	expires = current + delay;
+
+	/* Round up within the slack to the boundary with the most low bits clear */
+	if (timer->slack)
+	{
+		limit = expires + timer->slack;
+		bit = 63 - __builtin_clzll(expires ^ limit);
+		expires = limit & ~((1ULL << bit) - 1);
+	}
+
+	/* The slot for now has already been collected */
+	if (expires <= timerwheel.now)
+		expires = timerwheel.now + 1;
+
+	timer_wheel_insert(timer, expires);
+
+	timerwheel.statistics.armcount++;
+
+	if (timer->expires < timerwheel.wakeup)
+	{
+		timerwheel.wakeup = timer->expires;
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Move the timers in a slot of a higher level to the levels below, caller must hold the wheel lock.
+ * Called with now set to the start of the slot and before the level 0 slot for now is collected,
+ * so timers expiring exactly on the boundary go to that slot and expire in the same tick */
+static void timer_wheel_cascade(uint32_t level, uint32_t slot)
+{
+	TIMER_WHEEL_TIMER *timer;
+	TIMER_WHEEL_TIMER *next;
+
+	timer = timerwheel.slots[level][slot];
+	timerwheel.slots[level][slot] = NULL;
+	timerwheel.occupied[level] &= ~(1ULL << slot);
+
+	while (timer)
+	{
+		next = timer->next;
+
+		timer->armed = FALSE;
+		timerwheel.statistics.armedcount--;
+
+		timer_wheel_insert(timer, timer->expires);
+		timerwheel.statistics.cascadecount++;
+
+		timer = next;
+	}
+}
+
+/* Advance the wheel to the target time and return the expired timers as a batch, caller must hold the wheel lock */
+static TIMER_WHEEL_TIMER *timer_wheel_advance(uint64_t target)
+{
+	TIMER_WHEEL_TIMER *batch = NULL;
+	TIMER_WHEEL_TIMER *timer;
+	TIMER_WHEEL_TIMER *next;
+	uint32_t count = 0;
+	uint32_t level;
+	uint32_t slot;
+
+	while (timerwheel.now < target)
+	{
+		if (timerwheel.statistics.armedcount == 0)
+		{
+			timerwheel.now = target;
+			break;
+		}
+
+		timerwheel.now++;
+
+		/* Each time a level wraps the next slot of the level above moves down */
+		level = 1;
+		while (level < TIMER_WHEEL_LEVELS && (timerwheel.now & ((1ULL << (TIMER_WHEEL_LEVEL_BITS * level)) - 1)) == 0)
+		{
+			timer_wheel_cascade(level, (timerwheel.now >> (TIMER_WHEEL_LEVEL_BITS * level)) & TIMER_WHEEL_LEVEL_MASK);
+			level++;
+		}
+
+		slot = timerwheel.now & TIMER_WHEEL_LEVEL_MASK;
+		timer = timerwheel.slots[0][slot];
+		if (!timer)
+			continue;
+
+		timerwheel.slots[0][slot] = NULL;
+		timerwheel.occupied[0] &= ~(1ULL << slot);
+
+		while (timer)
+		{
+			next = timer->next;
+
+			timer->prev = NULL;
+			timer->next = NULL;
+			timer->armed = FALSE;
+			timerwheel.statistics.armedcount--;
+			timerwheel.statistics.expirecount++;
+
+			/* A timer still running its last event is run again when that completes */
+			if (timer->pending)
+			{
+				timer->again = TRUE;
+				timerwheel.statistics.overruncount++;
+			}
+			else
+			{
+				timer->pending = TRUE;
+				timer->batchnext = batch;
+				batch = timer;
+				count++;
+			}
+
+			timer = next;
+		}
+	}
+
+	if (count)
+	{
+		timerwheel.statistics.batchcount++;
+		if (count > timerwheel.statistics.batchmax)
+			timerwheel.statistics.batchmax = count;
+	}
+
+	return batch;
+}
+
+/* Return the wheel time when the next timer expires or a level wraps, caller must hold the wheel lock */
+static uint64_t timer_wheel_next(void)
+{
+	uint64_t next = TIMER_WHEEL_NEVER;
+	uint64_t occupied;
+	uint32_t shift;
+	uint32_t level;
+
+	if (timerwheel.statistics.armedcount == 0)
+		return TIMER_WHEEL_NEVER;
+
+	/* Rotate the level 0 bitmap so the slot for the next millisecond is bit 0 */
+	occupied = timerwheel.occupied[0];
+	shift = (timerwheel.now + 1) & TIMER_WHEEL_LEVEL_MASK;
+	if (shift)
+		occupied = (occupied >> shift) | (occupied << (TIMER_WHEEL_LEVEL_SLOTS - shift));
+	if (occupied)
+		next = timerwheel.now + 1 + __builtin_ctzll(occupied);
+
+	/* Timers in higher levels can not expire before level 0 next wraps */
+	for (level = 1; level < TIMER_WHEEL_LEVELS; level++)
+	{
+		if (timerwheel.occupied[level])
+		{
+			uint64_t wrap = (timerwheel.now | TIMER_WHEEL_LEVEL_MASK) + 1;
+
+			if (wrap < next)
+				next = wrap;
+			break;
+		}
+	}
+
+	return next;
+}
+
+/* Call the event of an expired timer and rearm or release it */
+static void timer_wheel_trigger(TIMER_WHEEL_TIMER *timer)
+{
+	timer_event_proc event;
+	void *data;
+	BOOL destroyed;
+	BOOL again;
+	BOOL wake = FALSE;
+
+	do
+	{
+		spin_lock(timerwheel.lock);
+		event = timer->event;
+		data = timer->data;
+		destroyed = timer->destroyed;
+		spin_unlock(timerwheel.lock);
+
+		if (!destroyed && event)
+			event(data);
+
+		spin_lock(timerwheel.lock);
+		again = timer->again && !timer->destroyed;
+		timer->again = FALSE;
+		spin_unlock(timerwheel.lock);
+	} while (again);
+
+	spin_lock(timerwheel.lock);
+
+	timer->pending = FALSE;
+
+	destroyed = timer->destroyed;
+	if (!destroyed && timer->state == TIMER_STATE_ENABLED && !timer->armed)
+	{
+		/* The event did not enable the timer again */
+		if (timer->flags & TIMER_FLAG_RESCHEDULE)
+			wake = timer_wheel_arm(timer, timer->interval);
+		else
+			timer->state = TIMER_STATE_DISABLED;
+	}
+
+	spin_unlock(timerwheel.lock);
+
+	if (wake)
+		semaphore_signal(timerwheel.signal);
+
+	if (destroyed)
+		free(timer);
+}
+
+static void STDCALL timer_wheel_worker_task(void *data)
+{
+	timer_wheel_trigger((TIMER_WHEEL_TIMER *)data);
+}
+
+/* Pass each expired timer to the thread that executes its event */
+static void timer_wheel_dispatch(TIMER_WHEEL_TIMER *batch)
+{
+	TIMER_WHEEL_TIMER *timer;
+	BOOL queued = FALSE;
+
+	while (batch)
+	{
+		timer = batch;
+		batch = timer->batchnext;
+		timer->batchnext = NULL;
+
+		if (timer->flags & TIMER_FLAG_PRIORITY)
+		{
+			timer_wheel_trigger(timer);
+			continue;
+		}
+
+		if ((timer->flags & TIMER_FLAG_WORKER) && worker_schedule(0, timer_wheel_worker_task, timer, NULL) == ERROR_SUCCESS)
+			continue;
+
+		spin_lock(timerwheel.lock);
+		if (timerwheel.eventlast)
+			timerwheel.eventlast->batchnext = timer;
+		else
+			timerwheel.eventfirst = timer;
+		timerwheel.eventlast = timer;
+		spin_unlock(timerwheel.lock);
+
+		queued = TRUE;
+	}
+
+	if (queued)
+		semaphore_signal(timerwheel.eventsignal);
+}
+
+static ssize_t STDCALL timer_wheel_execute(void *parameter)
+{
+	TIMER_WHEEL_TIMER *batch;
+	uint64_t current;
+	uint64_t next;
+	uint32_t timeout;
+
+	while (TRUE)
+	{
+		spin_lock(timerwheel.lock);
+
+		timerwheel.statistics.wakeupcount++;
+
+		batch = timer_wheel_advance(timer_wheel_current());
+
+		next = timer_wheel_next();
+		timerwheel.wakeup = next;
+
+		spin_unlock(timerwheel.lock);
+
+		if (batch)
+			timer_wheel_dispatch(batch);
+
+		/* Sleep until the next expiry, arming an earlier timer signals the semaphore */
+		timeout = INFINITE;
+		if (next != TIMER_WHEEL_NEVER)
+		{
+			current = timer_wheel_current();
+			if (next <= current)
+				continue;
+
+			timeout = (next - current >= INFINITE) ? INFINITE - 1 : (uint32_t)(next - current);
+		}
+
+		semaphore_wait_ex(timerwheel.signal, timeout);
+	}
+
+	return 0;
+}
+
+static ssize_t STDCALL timer_wheel_event_execute(void *parameter)
+{
+	TIMER_WHEEL_TIMER *timer;
+	TIMER_WHEEL_TIMER *next;
+
+	while (TRUE)
+	{
+		if (semaphore_wait(timerwheel.eventsignal) != ERROR_SUCCESS)
+			continue;
+
+		spin_lock(timerwheel.lock);
+		timer = timerwheel.eventfirst;
+		timerwheel.eventfirst = NULL;
+		timerwheel.eventlast = NULL;
+		spin_unlock(timerwheel.lock);
+
+		while (timer)
+		{
+			next = timer->batchnext;
+			timer->batchnext = NULL;
+
+			timer_wheel_trigger(timer);
+
+			timer = next;
+		}
+	}
+
+	return 0;
+}
+
+/* Create the lock and threads on first use */
+static uint32_t timer_wheel_start(void)
+{
+	if (timerwheel.started == TIMER_WHEEL_STATE_STARTED)
+		return ERROR_SUCCESS;
+
+	if (!__sync_bool_compare_and_swap(&timerwheel.started, TIMER_WHEEL_STATE_STOPPED, TIMER_WHEEL_STATE_STARTING))
+	{
+		while (timerwheel.started == TIMER_WHEEL_STATE_STARTING)
+			thread_yield();
+
+		return (timerwheel.started == TIMER_WHEEL_STATE_STARTED) ? ERROR_SUCCESS : ERROR_OPERATION_FAILED;
+	}
+
+	timerwheel.base = clock_milliseconds();
+	timerwheel.now = 0;
+	timerwheel.wakeup = TIMER_WHEEL_NEVER;
+
+	timerwheel.lock = spin_create();
+	timerwheel.signal = semaphore_create(0);
+	timerwheel.eventsignal = semaphore_create(0);
+	if (timerwheel.lock == INVALID_HANDLE_VALUE || timerwheel.signal == INVALID_HANDLE_VALUE || timerwheel.eventsignal == INVALID_HANDLE_VALUE)
+		goto failed;
+
+	timerwheel.eventthread = thread_create(timer_wheel_event_execute, TIMER_WHEEL_THREAD_STACK_SIZE, TIMER_WHEEL_EVENT_THREAD_PRIORITY, TIMER_WHEEL_EVENT_THREAD_NAME, NULL);
+	if (timerwheel.eventthread == INVALID_HANDLE_VALUE)
+		goto failed;
+
+	timerwheel.thread = thread_create(timer_wheel_execute, TIMER_WHEEL_THREAD_STACK_SIZE, TIMER_WHEEL_THREAD_PRIORITY, TIMER_WHEEL_THREAD_NAME, NULL);
+	if (timerwheel.thread == INVALID_HANDLE_VALUE)
+	{
+		thread_terminate(timerwheel.eventthread, 0);
+		goto failed;
+	}
+
+	__sync_synchronize();
+	timerwheel.started = TIMER_WHEEL_STATE_STARTED;
+
+	return ERROR_SUCCESS;
+
+failed:
+	if (timerwheel.eventsignal != INVALID_HANDLE_VALUE)
+		semaphore_destroy(timerwheel.eventsignal);
+	if (timerwheel.signal != INVALID_HANDLE_VALUE)
+		semaphore_destroy(timerwheel.signal);
+	if (timerwheel.lock != INVALID_HANDLE_VALUE)
+		spin_destroy(timerwheel.lock);
+
+	timerwheel.eventsignal = INVALID_HANDLE_VALUE;
+	timerwheel.signal = INVALID_HANDLE_VALUE;
+	timerwheel.lock = INVALID_HANDLE_VALUE;
+
+	__sync_synchronize();
+	timerwheel.started = TIMER_WHEEL_STATE_STOPPED;
+
+	return ERROR_OPERATION_FAILED;
+}
+
+/* ============================================================================== */
+/* Timer Wheel Functions */
+TIMER_WHEEL_TIMER * STDCALL timer_wheel_create(uint32_t interval, BOOL enabled, BOOL reschedule, timer_event_proc event, void *data)
+{
+	return timer_wheel_create_ex(interval, enabled ? TIMER_STATE_ENABLED : TIMER_STATE_DISABLED, reschedule ? TIMER_FLAG_RESCHEDULE : TIMER_FLAG_NONE, event, data);
+}
+
+TIMER_WHEEL_TIMER * STDCALL timer_wheel_create_ex(uint32_t interval, uint32_t state, uint32_t flags, timer_event_proc event, void *data)
+{
+	TIMER_WHEEL_TIMER *timer;
+
+	if (timer_wheel_start() != ERROR_SUCCESS)
+		return NULL;
+
+	timer = calloc(1, sizeof(TIMER_WHEEL_TIMER));
+	if (!timer)
+		return NULL;
+
+	timer->signature = TIMER_WHEEL_SIGNATURE;
+	timer->interval = interval;
+	timer->state = TIMER_STATE_DISABLED;
+	timer->flags = flags;
+	timer->event = event;
+	timer->data = data;
+
+	spin_lock(timerwheel.lock);
+	timerwheel.statistics.timercount++;
+	spin_unlock(timerwheel.lock);
+
+	if (state == TIMER_STATE_ENABLED && timer_wheel_enable(timer) != ERROR_SUCCESS)
+	{
+		timer_wheel_destroy(timer);
+		return NULL;
+	}
+
+	return timer;
+}
+
+uint32_t STDCALL timer_wheel_destroy(TIMER_WHEEL_TIMER *timer)
+{
+	BOOL pending;
+
+	if (!timer_wheel_check(timer))
+		return ERROR_INVALID_PARAMETER;
+
+	spin_lock(timerwheel.lock);
+
+	if (timer->armed)
+		timer_wheel_remove(timer);
+
+	timer->signature = 0;
+	timer->state = TIMER_STATE_DISABLED;
+
+	/* An expired timer is freed when its event completes */
+	pending = timer->pending;
+	if (pending)
+		timer->destroyed = TRUE;
+
+	timerwheel.statistics.timercount--;
+
+	spin_unlock(timerwheel.lock);
+
+	if (!pending)
+		free(timer);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL timer_wheel_enable(TIMER_WHEEL_TIMER *timer)
+{
+	if (!timer_wheel_check(timer))
+		return ERROR_INVALID_PARAMETER;
+
+	return timer_wheel_enable_ex(timer, timer->interval, timer->event, timer->data);
+}
+
+uint32_t STDCALL timer_wheel_enable_ex(TIMER_WHEEL_TIMER *timer, uint32_t interval, timer_event_proc event, void *data)
+{
+	BOOL wake;
+
+	if (!timer_wheel_check(timer))
+		return ERROR_INVALID_PARAMETER;
+
+	if (!event)
+		return ERROR_INVALID_PARAMETER;
+
+	spin_lock(timerwheel.lock);
+
+	timer->interval = interval;
+	timer->event = event;
+	timer->data = data;
+	timer->state = TIMER_STATE_ENABLED;
+
+	wake = timer_wheel_arm(timer, (timer->flags & TIMER_FLAG_IMMEDIATE) ? 0 : interval);
+
+	spin_unlock(timerwheel.lock);
+
+	if (wake)
+		semaphore_signal(timerwheel.signal);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL timer_wheel_disable(TIMER_WHEEL_TIMER *timer)
+{
+	if (!timer_wheel_check(timer))
+		return ERROR_INVALID_PARAMETER;
+
+	spin_lock(timerwheel.lock);
+
+	timer->state = TIMER_STATE_DISABLED;
+
+	if (timer->armed)
+	{
+		timer_wheel_remove(timer);
+		timerwheel.statistics.cancelcount++;
+	}
+
+	spin_unlock(timerwheel.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL timer_wheel_get_slack(TIMER_WHEEL_TIMER *timer)
+{
+	if (!timer_wheel_check(timer))
+		return 0;
+
+	return timer->slack;
+}
+
+uint32_t STDCALL timer_wheel_set_slack(TIMER_WHEEL_TIMER *timer, uint32_t slack)
+{
+	if (!timer_wheel_check(timer))
+		return ERROR_INVALID_PARAMETER;
+
+	/* Applies the next time the timer is armed */
+	timer->slack = slack;
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL timer_wheel_get_statistics(TIMER_WHEEL_STATISTICS *statistics)
+{
+	if (!statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	if (timerwheel.started != TIMER_WHEEL_STATE_STARTED)
+	{
+		memset(statistics, 0, sizeof(TIMER_WHEEL_STATISTICS));
+		return ERROR_SUCCESS;
+	}
+
+	spin_lock(timerwheel.lock);
+	memcpy(statistics, &timerwheel.statistics, sizeof(TIMER_WHEEL_STATISTICS));
+	statistics->tick = timerwheel.now;
+	spin_unlock(timerwheel.lock);
+
+	return ERROR_SUCCESS;
+}
@@ -0,0 +1,397 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Host test for the hierarchical timer wheel (threads/timerwheel.c)
+ *
+ * This file is not part of the Ultibo run time, it includes timerwheel.c with stub
+ * versions of the clock, lock, semaphore and thread functions and runs the wheel
+ * against a simulated millisecond clock on the development host.
+ *
+ * Timers are checked to expire exactly when due, including expiry times that fall
+ * on the boundary of a higher level (64, 4096, 262144 ms) and expiry times rounded
+ * to a boundary by slack, then a large random set of timers is armed, rearmed and
+ * cancelled and each must expire once, never early and (without slack) never late.
+ *
+ * Build and run from the root of the repository with:
+ *
+ *  gcc -std=gnu11 -g -O1 -fsanitize=address,undefined -iquote include -o timerwheeltest src/threads/timerwheeltest.c && ./timerwheeltest
+ */
+
+/* The Ultibo timer_create conflicts with the POSIX declaration in the host headers */
+#define timer_create host_timer_create
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+#undef timer_create
+
+/* Newlib definitions used by the Ultibo headers */
+#define _ATTRIBUTE(x) __attribute__(x)
+#define __VALIST __gnuc_va_list
+
+#include "timerwheel.c"
+
+/* ============================================================================== */
+/* Host stubs */
+static int64_t host_clock;
+
+int64_t STDCALL clock_milliseconds(void)
+{
+	return host_clock;
+}
+
+SPIN_HANDLE STDCALL spin_create(void)
+{
+	return 1;
+}
+
+uint32_t STDCALL spin_destroy(SPIN_HANDLE spin)
+{
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL spin_lock(SPIN_HANDLE spin)
+{
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL spin_unlock(SPIN_HANDLE spin)
+{
+	return ERROR_SUCCESS;
+}
+
+SEMAPHORE_HANDLE STDCALL semaphore_create(uint32_t count)
+{
+	return 2;
+}
+
+uint32_t STDCALL semaphore_destroy(SEMAPHORE_HANDLE semaphore)
+{
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL semaphore_wait(SEMAPHORE_HANDLE semaphore)
+{
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL semaphore_wait_ex(SEMAPHORE_HANDLE semaphore, uint32_t timeout)
+{
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL semaphore_signal(SEMAPHORE_HANDLE semaphore)
+{
+	return ERROR_SUCCESS;
+}
+
+THREAD_HANDLE STDCALL thread_create(thread_start_proc startproc, uint32_t stacksize, uint32_t priority, const char *name, void *parameter)
+{
+	/* The test advances the wheel itself (See host_run) */
+	return 3;
+}
+
+uint32_t STDCALL thread_terminate(THREAD_HANDLE thread, uint32_t exitcode)
+{
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL thread_yield(void)
+{
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL worker_schedule(uint32_t interval, worker_task_proc task, void *data, worker_cb callback)
+{
+	return ERROR_NOT_SUPPORTED;
+}
+
+/* ============================================================================== */
+/* Host test */
+#define HOST_RANDOM_TIMERS	20000
+
+typedef struct _HOST_TIMER HOST_TIMER;
+struct _HOST_TIMER
+{
+	TIMER_WHEEL_TIMER *timer;
+	int64_t due; // Clock time the timer is due
+	uint32_t slack;
+	int32_t fired; // Number of times the event was called
+	int64_t firedat; // Clock time of the last event
+};
+
+static uint32_t failures;
+static uint32_t checks;
+
+#define HOST_CHECK(condition, ...) do { checks++; if (!(condition)) { if (failures++ < 20) { printf("FAIL: "); printf(__VA_ARGS__); printf("\n"); } } } while (0)
+
+static uint32_t host_random(void)
+{
+	static uint64_t state = 88172645463325252ULL;
+
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+
+	return (uint32_t)state;
+}
+
+static void STDCALL host_event(void *data)
+{
+	HOST_TIMER *host = (HOST_TIMER *)data;
+
+	host->fired++;
+	host->firedat = host_clock;
+}
+
+/* Advance the wheel to the clock and run the expired events as the wheel thread would */
+static uint64_t host_run(void)
+{
+	TIMER_WHEEL_TIMER *batch;
+	TIMER_WHEEL_TIMER *timer;
+	uint64_t next;
+
+	spin_lock(timerwheel.lock);
+	batch = timer_wheel_advance(timer_wheel_current());
+	next = timer_wheel_next();
+	timerwheel.wakeup = next;
+	spin_unlock(timerwheel.lock);
+
+	while (batch)
+	{
+		timer = batch;
+		batch = timer->batchnext;
+		timer->batchnext = NULL;
+
+		timer_wheel_trigger(timer);
+	}
+
+	return next;
+}
+
+/* Arm a timer at the current clock and step one millisecond at a time until it fires */
+static void host_boundary(const char *name, uint32_t interval, uint32_t slack, int64_t expected)
+{
+	HOST_TIMER host;
+	int64_t limit;
+
+	memset(&host, 0, sizeof(host));
+	host.timer = timer_wheel_create_ex(interval, TIMER_STATE_DISABLED, TIMER_FLAG_NONE, host_event, &host);
+	HOST_CHECK(host.timer != NULL, "%s: create failed", name);
+	if (!host.timer)
+		return;
+
+	if (slack)
+		timer_wheel_set_slack(host.timer, slack);
+
+	expected += host_clock;
+	timer_wheel_enable(host.timer);
+
+	limit = host_clock + interval + slack + 2;
+	while (host.fired == 0 && host_clock < limit)
+	{
+		host_clock++;
+		host_run();
+	}
+
+	HOST_CHECK(host.fired == 1, "%s: fired %d times", name, (int)host.fired);
+	HOST_CHECK(host.firedat == expected, "%s: expected at %lld fired at %lld", name, (long long)expected, (long long)host.firedat);
+
+	timer_wheel_destroy(host.timer);
+}
+
+/* Arm a timer and jump the clock straight to each wakeup time the wheel asks for */
+static void host_boundary_sleep(const char *name, uint32_t interval)
+{
+	HOST_TIMER host;
+	uint64_t next;
+	int64_t expected;
+
+	memset(&host, 0, sizeof(host));
+	host.timer = timer_wheel_create_ex(interval, TIMER_STATE_DISABLED, TIMER_FLAG_NONE, host_event, &host);
+	if (!host.timer)
+		return;
+
+	expected = host_clock + interval;
+	timer_wheel_enable(host.timer);
+
+	next = timerwheel.wakeup;
+	while (host.fired == 0 && next != TIMER_WHEEL_NEVER)
+	{
+		host_clock = timerwheel.base + (int64_t)next;
+		next = host_run();
+	}
+
+	HOST_CHECK(host.fired == 1 && host.firedat == expected, "%s: expected at %lld fired %d times at %lld", name, (long long)expected, (int)host.fired, (long long)host.firedat);
+
+	timer_wheel_destroy(host.timer);
+}
+
+static void host_boundaries(void)
+{
+	static const uint32_t intervals[] = {63, 64, 65, 127, 128, 4095, 4096, 4097, 8192, 262143, 262144, 262145, 16777216};
+	char name[64];
+	uint32_t index;
+	uint32_t start;
+
+	/* Wheel time 0 so each interval expires on (or next to) a level boundary */
+	for (index = 0; index < sizeof(intervals) / sizeof(intervals[0]); index++)
+	{
+		host_clock = timerwheel.base + (int64_t)timerwheel.now;
+		snprintf(name, sizeof(name), "boundary %u", (unsigned int)intervals[index]);
+		host_boundary(name, intervals[index], 0, intervals[index]);
+
+		snprintf(name, sizeof(name), "boundary sleep %u", (unsigned int)intervals[index]);
+		host_boundary_sleep(name, intervals[index]);
+	}
+
+	/* Arm part way through a rotation so the expiry lands on the next boundary */
+	for (start = 1; start < 64; start += 7)
+	{
+		host_clock = (timerwheel.base + (int64_t)timerwheel.now) | 0x3F;
+		host_clock -= start;
+		host_run();
+
+		snprintf(name, sizeof(name), "next boundary +%u", (unsigned int)(start + 1));
+		host_boundary(name, start + 1, 0, start + 1);
+
+		host_clock = ((timerwheel.base + (int64_t)timerwheel.now) | 0xFFF) - (start * 37);
+		host_run();
+
+		snprintf(name, sizeof(name), "next level 2 boundary +%u", (unsigned int)(start * 37 + 1));
+		host_boundary(name, start * 37 + 1, 0, start * 37 + 1);
+	}
+
+	/* Slack rounds 100 up to 128 (Within 100 to 130) */
+	host_clock = timerwheel.base + (((int64_t)timerwheel.now + 0x3FFF) & ~0x3FFFLL);
+	host_run();
+	host_boundary("slack 100+30", 100, 30, 128);
+
+	/* Slack rounds 5000 up to 8192 (Within 5000 to 9000) */
+	host_clock = timerwheel.base + (((int64_t)timerwheel.now + 0x3FFF) & ~0x3FFFLL);
+	host_run();
+	host_boundary("slack 5000+4000", 5000, 4000, 8192);
+}
+
+static void host_random_timers(void)
+{
+	HOST_TIMER *hosts;
+	HOST_TIMER *host;
+	uint64_t next;
+	uint32_t interval;
+	uint32_t index;
+	int64_t late;
+
+	hosts = calloc(HOST_RANDOM_TIMERS, sizeof(HOST_TIMER));
+	if (!hosts)
+		return;
+
+	for (index = 0; index < HOST_RANDOM_TIMERS; index++)
+	{
+		host = &hosts[index];
+		interval = (index % 3 == 0) ? host_random() % 300000 : host_random() % 5000;
+
+		host->timer = timer_wheel_create_ex(interval, TIMER_STATE_DISABLED, TIMER_FLAG_NONE, host_event, host);
+		if (index % 7 == 0)
+		{
+			host->slack = interval / 16;
+			timer_wheel_set_slack(host->timer, host->slack);
+		}
+		host->due = host_clock + (interval ? interval : 1); // Interval 0 expires on the next tick
+		timer_wheel_enable(host->timer);
+	}
+
+	/* Rearm half and cancel some */
+	for (index = 0; index < 3; index++)
+	{
+		host_clock++;
+		host_run();
+	}
+	for (index = 0; index < HOST_RANDOM_TIMERS; index += 2)
+	{
+		host = &hosts[index];
+		if (host->fired)
+			continue;
+
+		interval = host_random() % 70000;
+		host->due = host_clock + (interval ? interval : 1);
+		timer_wheel_enable_ex(host->timer, interval, host_event, host);
+	}
+	for (index = 1; index < HOST_RANDOM_TIMERS; index += 10)
+	{
+		host = &hosts[index];
+		if (host->fired)
+			continue;
+
+		timer_wheel_disable(host->timer);
+		host->fired = -1;
+	}
+
+	/* Step a millisecond at a time, the wheel must expire every timer on its due time */
+	next = host_run();
+	while (next != TIMER_WHEEL_NEVER)
+	{
+		host_clock++;
+		next = host_run();
+	}
+
+	for (index = 0; index < HOST_RANDOM_TIMERS; index++)
+	{
+		host = &hosts[index];
+		if (host->fired == -1)
+			continue;
+
+		late = host->firedat - host->due;
+
+		HOST_CHECK(host->fired == 1, "random %u: fired %d times", (unsigned int)index, (int)host->fired);
+		HOST_CHECK(late >= 0, "random %u: fired %lld ms early", (unsigned int)index, (long long)-late);
+		HOST_CHECK(late <= (int64_t)host->slack, "random %u: fired %lld ms late (Slack %u)", (unsigned int)index, (long long)late, (unsigned int)host->slack);
+
+		timer_wheel_destroy(host->timer);
+	}
+
+	free(hosts);
+}
+
+int main(void)
+{
+	TIMER_WHEEL_STATISTICS statistics;
+
+	setvbuf(stdout, NULL, _IONBF, 0);
+
+	host_clock = 1000;
+
+	host_boundaries();
+	host_random_timers();
+
+	timer_wheel_get_statistics(&statistics);
+	printf("checks %u failures %u (expired %llu cascaded %llu batches %llu)\n", (unsigned int)checks, (unsigned int)failures,
+		(unsigned long long)statistics.expirecount, (unsigned long long)statistics.cascadecount, (unsigned long long)statistics.batchcount);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,507 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/workerpool.h"
+
+/* Implementation of the per CPU worker pools for Ultibo API
+ *
+ * The kernel worker pool (worker_schedule etc) has one queue shared by all of the
+ * worker threads, every task passes through the same lock and may run on any CPU
+ * so the data it touches is often in the cache of another CPU. Here each CPU has
+ * its own queue and its own worker threads bound to that CPU, a task scheduled
+ * with worker_schedule_local runs on the CPU that scheduled it unless that CPU is
+ * busy for long enough that another CPU runs dry.
+ *
+ * A worker always takes tasks from its own queue first. Only when the queue is
+ * empty does it look at the queues of the other CPUs, starting with the next CPU
+ * so that thieves spread across the queues, and takes the oldest task if that task
+ * is not pinned. When a task is queued and none of the workers of the target CPU
+ * are idle an idle worker on another CPU is woken so it can steal the task.
+ *
+ * The queues are protected by IRQ spin locks and the idle workers wait on IRQ
+ * semaphores so tasks can be scheduled from interrupt handlers once the pool has
+ * been started, the first call must be made from a thread since it creates the
+ * worker threads.
+ */
+
+#define WORKER_POOL_STATE_STOPPED	0
+#define WORKER_POOL_STATE_STARTING	1
+#define WORKER_POOL_STATE_STARTED	2
+
+#define WORKER_POOL_QUEUE_MASK	(WORKER_POOL_QUEUE_SIZE - 1)
+
+/* Worker Pool Request */
+typedef struct _WORKER_POOL_REQUEST WORKER_POOL_REQUEST;
+struct _WORKER_POOL_REQUEST
+{
+	worker_task_proc task; // Task to call by worker
+	void *data; // Data to pass to task
+	worker_cb callback; // Callback when task is completed
+	uint32_t flags; // Request Flags (eg WORKER_POOL_FLAG_PINNED)
+	int64_t queued; // Value of clock_microseconds when the request was queued
+};
+
+/* Worker Pool Queue (One per CPU) */
+typedef struct _WORKER_POOL_QUEUE WORKER_POOL_QUEUE;
+struct _WORKER_POOL_QUEUE
+{
+	SPIN_HANDLE lock; // Queue Lock
+	SEMAPHORE_HANDLE signal; // Signalled once for each idle worker that is woken (Never more than the number of workers)
+	uint32_t cpu; // The CPU this queue belongs to
+	uint32_t start; // Index of the oldest request
+	uint32_t count; // Number of requests in the queue
+	uint32_t idle; // Number of workers waiting on the signal
+	THREAD_HANDLE threads[WORKER_POOL_MAX_THREADS];
+	WORKER_POOL_STATISTICS statistics;
+	WORKER_POOL_REQUEST requests[WORKER_POOL_QUEUE_SIZE];
+};
+
+/* Worker Pool State */
+typedef struct _WORKER_POOL_STATE WORKER_POOL_STATE;
+struct _WORKER_POOL_STATE
+{
+	volatile uint32_t started; // Startup state (eg WORKER_POOL_STATE_STARTED)
+	uint32_t cpucount; // Number of CPUs with a queue
+	uint32_t threadcount; // Number of worker threads for each CPU
+	WORKER_POOL_QUEUE *queues[CPU_ID_MAX + 1];
+};
+
+static WORKER_POOL_STATE workerpool = {WORKER_POOL_STATE_STOPPED};
+
+/* ============================================================================== */
+/* Worker Pool Internal Functions */
+/* Remove the oldest request from a queue, caller must hold the queue lock */
+static BOOL worker_pool_dequeue(WORKER_POOL_QUEUE *queue, WORKER_POOL_REQUEST *request, BOOL steal)
+{
+	WORKER_POOL_REQUEST *first;
+
+	if (queue->count == 0)
+		return FALSE;
+
+	first = &queue->requests[queue->start];
+	if (steal && (first->flags & WORKER_POOL_FLAG_PINNED))
+		return FALSE;
+
+	*request = *first;
+
+	queue->start = (queue->start + 1) & WORKER_POOL_QUEUE_MASK;
+	queue->count--;
+	queue->statistics.depth = queue->count;
+	if (steal)
+		queue->statistics.donatedcount++;
+
+	return TRUE;
+}
+
+/* Look for a task on the queues of the other CPUs */
+static BOOL worker_pool_steal(WORKER_POOL_QUEUE *queue, WORKER_POOL_REQUEST *request)
+{
+	WORKER_POOL_QUEUE *victim;
+	BOOL result;
+	uint32_t count;
+	uint32_t cpu;
+
+	cpu = queue->cpu;
+	for (count = 1; count < workerpool.cpucount; count++)
+	{
+		cpu = (cpu + 1) % workerpool.cpucount;
+		victim = workerpool.queues[cpu];
+
+		/* Check without the lock first to avoid touching busy queues needlessly */
+		if (victim->count == 0)
+			continue;
+
+		spin_lock_irq(victim->lock);
+		result = worker_pool_dequeue(victim, request, TRUE);
+		spin_unlock_irq(victim->lock);
+
+		if (result)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Wake one idle worker on any CPU other than the one specified */
+static void worker_pool_wake_other(uint32_t cpu)
+{
+	WORKER_POOL_QUEUE *queue;
+	BOOL woken;
+	uint32_t count;
+
+	for (count = 1; count < workerpool.cpucount; count++)
+	{
+		cpu = (cpu + 1) % workerpool.cpucount;
+		queue = workerpool.queues[cpu];
+
+		if (queue->idle == 0)
+			continue;
+
+		woken = FALSE;
+		spin_lock_irq(queue->lock);
+		if (queue->idle > 0)
+		{
+			queue->idle--;
+			woken = TRUE;
+		}
+		spin_unlock_irq(queue->lock);
+
+		if (woken)
+		{
+			semaphore_signal(queue->signal);
+			return;
+		}
+	}
+}
+
+static ssize_t STDCALL worker_pool_execute(void *parameter)
+{
+	WORKER_POOL_QUEUE *queue = (WORKER_POOL_QUEUE *)parameter;
+	WORKER_POOL_REQUEST request;
+	BOOL stolen;
+	BOOL found;
+	uint32_t latency;
+
+	while (TRUE)
+	{
+		spin_lock_irq(queue->lock);
+		found = worker_pool_dequeue(queue, &request, FALSE);
+		spin_unlock_irq(queue->lock);
+
+		stolen = FALSE;
+		if (!found)
+		{
+			found = worker_pool_steal(queue, &request);
+			stolen = found;
+		}
+
+		if (!found)
+		{
+			/* Recheck the own queue while registering as idle so a task queued after the check above is not missed */
+			spin_lock_irq(queue->lock);
+			found = worker_pool_dequeue(queue, &request, FALSE);
+			if (!found)
+				queue->idle++;
+			spin_unlock_irq(queue->lock);
+
+			if (!found)
+			{
+				semaphore_wait(queue->signal);
+				continue;
+			}
+		}
+
+		latency = (uint32_t)(clock_microseconds() - request.queued);
+
+		request.task(request.data);
+
+		if (request.callback)
+			request.callback(request.data);
+
+		/* Statistics are only updated by the workers of this CPU and the schedulers under the lock */
+		spin_lock_irq(queue->lock);
+		queue->statistics.executedcount++;
+		if (stolen)
+			queue->statistics.stolencount++;
+		queue->statistics.latencytotal += latency;
+		if (latency > queue->statistics.latencymax)
+			queue->statistics.latencymax = latency;
+		spin_unlock_irq(queue->lock);
+	}
+
+	return 0;
+}
+
+static void worker_pool_free(void)
+{
+	WORKER_POOL_QUEUE *queue;
+	uint32_t count;
+	uint32_t cpu;
+
+	for (cpu = 0; cpu <= CPU_ID_MAX; cpu++)
+	{
+		queue = workerpool.queues[cpu];
+		if (!queue)
+			continue;
+
+		for (count = 0; count < WORKER_POOL_MAX_THREADS; count++)
+		{
+			if (queue->threads[count] != INVALID_HANDLE_VALUE)
+				thread_terminate(queue->threads[count], 0);
+		}
+
+		if (queue->signal != INVALID_HANDLE_VALUE)
+			semaphore_destroy(queue->signal);
+		if (queue->lock != INVALID_HANDLE_VALUE)
+			spin_destroy(queue->lock);
+
+		free(queue);
+		workerpool.queues[cpu] = NULL;
+	}
+}
+
+/* ============================================================================== */
+/* Worker Pool Functions */
+uint32_t STDCALL worker_pool_start(uint32_t count)
+{
+	WORKER_POOL_QUEUE *queue;
+	uint32_t thread;
+	uint32_t cpu;
+
+	if (count > WORKER_POOL_MAX_THREADS)
+		return ERROR_INVALID_PARAMETER;
+
+	if (count == 0)
+		count = WORKER_POOL_DEFAULT_THREADS;
+
+	if (workerpool.started == WORKER_POOL_STATE_STARTED)
+		return ERROR_SUCCESS;
+
+	if (!__sync_bool_compare_and_swap(&workerpool.started, WORKER_POOL_STATE_STOPPED, WORKER_POOL_STATE_STARTING))
+	{
+		while (workerpool.started == WORKER_POOL_STATE_STARTING)
+			thread_yield();
+
+		return (workerpool.started == WORKER_POOL_STATE_STARTED) ? ERROR_SUCCESS : ERROR_OPERATION_FAILED;
+	}
+
+	workerpool.cpucount = cpu_get_count();
+	if (workerpool.cpucount > CPU_ID_MAX + 1)
+		workerpool.cpucount = CPU_ID_MAX + 1;
+	workerpool.threadcount = count;
+
+	/* Create all queues before any worker starts so that stealing sees every CPU */
+	for (cpu = 0; cpu < workerpool.cpucount; cpu++)
+	{
+		queue = (WORKER_POOL_QUEUE *)calloc(1, sizeof(WORKER_POOL_QUEUE));
+		if (!queue)
+			goto failed;
+
+		workerpool.queues[cpu] = queue;
+
+		for (thread = 0; thread < WORKER_POOL_MAX_THREADS; thread++)
+			queue->threads[thread] = INVALID_HANDLE_VALUE;
+
+		queue->cpu = cpu;
+		queue->statistics.cpu = cpu;
+		queue->statistics.threadcount = count;
+		queue->lock = spin_create();
+		queue->signal = semaphore_create_ex(0, WORKER_POOL_MAX_THREADS, SEMAPHORE_FLAG_IRQ);
+		if (queue->lock == INVALID_HANDLE_VALUE || queue->signal == INVALID_HANDLE_VALUE)
+			goto failed;
+	}
+
+	for (cpu = 0; cpu < workerpool.cpucount; cpu++)
+	{
+		queue = workerpool.queues[cpu];
+
+		for (thread = 0; thread < count; thread++)
+		{
+			queue->threads[thread] = thread_create_ex(worker_pool_execute, WORKER_POOL_THREAD_STACK_SIZE, WORKER_POOL_THREAD_PRIORITY, 1 << cpu, cpu, WORKER_POOL_THREAD_NAME, queue);
+			if (queue->threads[thread] == INVALID_HANDLE_VALUE)
+				goto failed;
+		}
+	}
+
+	__sync_synchronize();
+	workerpool.started = WORKER_POOL_STATE_STARTED;
+
+	return ERROR_SUCCESS;
+
+failed:
+	worker_pool_free();
+
+	__sync_synchronize();
+	workerpool.started = WORKER_POOL_STATE_STOPPED;
+
+	return ERROR_OPERATION_FAILED;
+}
+
+uint32_t STDCALL worker_schedule_on(uint32_t cpu, worker_task_proc task, void *data, worker_cb callback)
+{
+	return worker_schedule_on_ex(cpu, WORKER_POOL_FLAG_NONE, task, data, callback);
+}
+
+uint32_t STDCALL worker_schedule_on_ex(uint32_t cpu, uint32_t flags, worker_task_proc task, void *data, worker_cb callback)
+{
+	WORKER_POOL_QUEUE *queue;
+	WORKER_POOL_REQUEST *request;
+	BOOL wakeown;
+	uint32_t status;
+
+	if (!task)
+		return ERROR_INVALID_PARAMETER;
+
+	if (workerpool.started != WORKER_POOL_STATE_STARTED)
+	{
+		status = worker_pool_start(0);
+		if (status != ERROR_SUCCESS)
+			return status;
+	}
+
+	if (cpu == CPU_ID_ALL)
+		cpu = cpu_get_current();
+	if (cpu >= workerpool.cpucount)
+		return ERROR_INVALID_PARAMETER;
+
+	queue = workerpool.queues[cpu];
+
+	spin_lock_irq(queue->lock);
+
+	if (queue->count >= WORKER_POOL_QUEUE_SIZE)
+	{
+		queue->statistics.overflowcount++;
+		spin_unlock_irq(queue->lock);
+
+		return ERROR_INSUFFICIENT_BUFFER;
+	}
+
+	request = &queue->requests[(queue->start + queue->count) & WORKER_POOL_QUEUE_MASK];
+	request->task = task;
+	request->data = data;
+	request->callback = callback;
+	request->flags = flags;
+	request->queued = clock_microseconds();
+
+	queue->count++;
+	queue->statistics.depth = queue->count;
+	if (queue->count > queue->statistics.maxdepth)
+		queue->statistics.maxdepth = queue->count;
+	queue->statistics.queuedcount++;
+
+	wakeown = FALSE;
+	if (queue->idle > 0)
+	{
+		queue->idle--;
+		wakeown = TRUE;
+	}
+
+	spin_unlock_irq(queue->lock);
+
+	if (wakeown)
+		semaphore_signal(queue->signal);
+	else if (!(flags & WORKER_POOL_FLAG_PINNED))
+		worker_pool_wake_other(cpu);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL worker_schedule_local(worker_task_proc task, void *data, worker_cb callback)
+{
+	return worker_schedule_on_ex(CPU_ID_ALL, WORKER_POOL_FLAG_NONE, task, data, callback);
+}
+
+uint32_t STDCALL worker_pool_get_count(void)
+{
+	if (workerpool.started != WORKER_POOL_STATE_STARTED)
+		return 0;
+
+	return workerpool.cpucount * workerpool.threadcount;
+}
+
+uint32_t STDCALL worker_pool_get_statistics(uint32_t cpu, WORKER_POOL_STATISTICS *statistics)
+{
+	WORKER_POOL_QUEUE *queue;
+	uint32_t first;
+	uint32_t last;
+
+	if (!statistics)
+		return ERROR_INVALID_PARAMETER;
+
+	if (workerpool.started != WORKER_POOL_STATE_STARTED)
+		return ERROR_NOT_ASSIGNED;
+
+	/* CPU_ID_ALL returns the totals of all queues */
+	if (cpu == CPU_ID_ALL)
+	{
+		first = 0;
+		last = workerpool.cpucount - 1;
+	}
+	else
+	{
+		if (cpu >= workerpool.cpucount)
+			return ERROR_INVALID_PARAMETER;
+
+		first = cpu;
+		last = cpu;
+	}
+
+	memset(statistics, 0, sizeof(WORKER_POOL_STATISTICS));
+	statistics->cpu = cpu;
+
+	for (cpu = first; cpu <= last; cpu++)
+	{
+		queue = workerpool.queues[cpu];
+
+		spin_lock_irq(queue->lock);
+		statistics->threadcount += queue->statistics.threadcount;
+		statistics->depth += queue->statistics.depth;
+		statistics->maxdepth += queue->statistics.maxdepth;
+		statistics->queuedcount += queue->statistics.queuedcount;
+		statistics->executedcount += queue->statistics.executedcount;
+		statistics->stolencount += queue->statistics.stolencount;
+		statistics->donatedcount += queue->statistics.donatedcount;
+		statistics->overflowcount += queue->statistics.overflowcount;
+		statistics->latencytotal += queue->statistics.latencytotal;
+		if (queue->statistics.latencymax > statistics->latencymax)
+			statistics->latencymax = queue->statistics.latencymax;
+		spin_unlock_irq(queue->lock);
+	}
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL worker_pool_reset_statistics(void)
+{
+	WORKER_POOL_QUEUE *queue;
+	uint32_t cpu;
+
+	if (workerpool.started != WORKER_POOL_STATE_STARTED)
+		return ERROR_NOT_ASSIGNED;
+
+	for (cpu = 0; cpu < workerpool.cpucount; cpu++)
+	{
+		queue = workerpool.queues[cpu];
+
+		spin_lock_irq(queue->lock);
+		queue->statistics.maxdepth = queue->count;
+		queue->statistics.queuedcount = 0;
+		queue->statistics.executedcount = 0;
+		queue->statistics.stolencount = 0;
+		queue->statistics.donatedcount = 0;
+		queue->statistics.overflowcount = 0;
+		queue->statistics.latencytotal = 0;
+		queue->statistics.latencymax = 0;
+		spin_unlock_irq(queue->lock);
+	}
+
+	return ERROR_SUCCESS;
+}
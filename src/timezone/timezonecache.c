@@ -0,0 +1,730 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/timezone.h"
+#include "ultibo/ultibo.h"
+
+/* Implementation of the timezone transition cache for Ultibo API
+ *
+ * The RTL works out the state of a timezone from its rules on every call, which
+ * means finding the year of the date, converting both start rules to dates for
+ * that year and comparing. Logging a timestamp in local time does this for each
+ * record even though the answer only changes twice a year.
+ *
+ * Each timezone looked up here gets a table of the boundaries for the year of
+ * the lookup and the years either side. Boundaries are the start of each year
+ * plus the values returned by timezone_start_to_date_time for the daylight and
+ * standard rules. The state and bias between two boundaries are asked of the
+ * RTL (timezone_get_state_ex and timezone_get_active_bias_ex) at the start, the
+ * middle and the end of the interval, so the table only records what the RTL
+ * itself returns. Intervals with the same state and bias are then merged.
+ *
+ * The interval of the last lookup is kept as the current window, so until the
+ * date passes the next boundary a lookup is a comparison of the date with the
+ * two ends of the window. The window is read without locking using a sequence
+ * count, building the table and moving the window are serialized by a mutex.
+ *
+ * Local dates are compared with the exact values the RTL compares with. For a
+ * UTC time each boundary is moved by the bias in effect before it, so daylight
+ * time starts at the UTC instant the local standard time reaches the daylight
+ * rule and ends when the local daylight time reaches the standard rule (As for
+ * SystemTimeToTzSpecificLocalTime). Each UTC interval is also sampled with
+ * SystemTimeToTzSpecificLocalTime, which applies the rules of the UTC year and
+ * so differs for a rule within the bias of a year end, if any sample disagrees
+ * UTC lookups for that table are passed to the RTL.
+ *
+ * Tables are tagged with a generation count which timezone_cache_invalidate
+ * increments, timezone_cache_update_offset and timezone_cache_set_information
+ * do this after calling the RTL. Changing the default timezone needs nothing as
+ * each timezone has its own table, but an entry changed or deleted directly must
+ * be invalidated before it is used again.
+ *
+ * Dates outside the years TIMEZONE_CACHE_MIN_YEAR to TIMEZONE_CACHE_MAX_YEAR
+ * and rules the table cannot represent are passed to the RTL.
+ *
+ * The results are compared with a model of the RTL functions by the host test in
+ * timezone/timezonecachetest.c.
+ */
+
+/* ============================================================================== */
+/* Timezone Cache specific constants */
+#define TIMEZONE_CACHE_STATE_STOPPED	0
+#define TIMEZONE_CACHE_STATE_STARTING	1
+#define TIMEZONE_CACHE_STATE_STARTED	2
+
+#define TIMEZONE_CACHE_MIN_YEAR	1901 // Earliest year of a cached lookup (The table starts a year before)
+#define TIMEZONE_CACHE_MAX_YEAR	9997 // Latest year of a cached lookup (The table ends two years after)
+
+#define TIMEZONE_CACHE_MAX_BOUNDARIES	((TIMEZONE_CACHE_YEARS * 3) + 1) // Start of each year, two rules per year and the end of the last year
+
+#define TIMEZONE_CACHE_DAYS_TO_0001	693593 // Days from 1/1/0001 to 30/12/1899 (FreePascal) less one
+
+/* ============================================================================== */
+/* Timezone Cache specific types */
+/* Timezone Interval */
+typedef struct _TIMEZONE_INTERVAL TIMEZONE_INTERVAL;
+struct _TIMEZONE_INTERVAL
+{
+	double_t localstart; // Local date and time the interval starts (As compared by the RTL)
+	int64_t universalstart; // UTC time the interval starts (100 nanosecond ticks since 1/1/1601)
+	int32_t bias; // Active bias during the interval
+	uint32_t state; // Timezone state during the interval (eg TIME_ZONE_ID_DAYLIGHT)
+};
+
+/* Timezone Cache */
+typedef struct _TIMEZONE_CACHE TIMEZONE_CACHE;
+struct _TIMEZONE_CACHE
+{
+	TIMEZONE_ENTRY *timezone; // Timezone this cache belongs to
+	// Current window (Read without locking)
+	volatile uint32_t sequence; // Incremented before and after each change to the window (Odd while changing)
+	uint32_t generation; // Invalidation generation of the window
+	double_t localstart;
+	double_t localend;
+	int64_t universalstart;
+	int64_t universalend;
+	int32_t bias;
+	uint32_t state;
+	// Transition table (Protected by the lock)
+	uint32_t tablegeneration; // Invalidation generation the table was built in
+	int32_t tableyear; // Year the table was built for (The table is not built again for the same year and generation)
+	uint32_t count; // Number of intervals in the table (The entry after the last holds the end)
+	BOOL universal; // TRUE if the UTC starts of the intervals are in order
+	TIMEZONE_INTERVAL intervals[TIMEZONE_CACHE_MAX_BOUNDARIES];
+	// Internal Properties
+	TIMEZONE_CACHE *next; // Next entry in cache list
+};
+
+typedef struct _TIMEZONE_CACHE_STATE TIMEZONE_CACHE_STATE;
+struct _TIMEZONE_CACHE_STATE
+{
+	volatile uint32_t started; // Startup state (eg TIMEZONE_CACHE_STATE_STARTED)
+	MUTEX_HANDLE lock; // Serializes building of tables and moving of windows (Lookups do not lock)
+	volatile uint32_t generation; // Incremented by timezone_cache_invalidate(NULL)
+	TIMEZONE_CACHE * volatile caches;
+};
+
+static TIMEZONE_CACHE_STATE timezonecache = {TIMEZONE_CACHE_STATE_STOPPED};
+
+/* ============================================================================== */
+/* Timezone Cache Internal Functions */
+static void timezone_cache_start(void)
+{
+	if (timezonecache.started == TIMEZONE_CACHE_STATE_STARTED)
+		return;
+
+	if (!__sync_bool_compare_and_swap(&timezonecache.started, TIMEZONE_CACHE_STATE_STOPPED, TIMEZONE_CACHE_STATE_STARTING))
+	{
+		while (timezonecache.started != TIMEZONE_CACHE_STATE_STARTED)
+			thread_yield();
+		return;
+	}
+
+	timezonecache.lock = mutex_create();
+	timezonecache.generation = 1;
+
+	__sync_synchronize();
+	timezonecache.started = TIMEZONE_CACHE_STATE_STARTED;
+}
+
+/* Date value of 1 January of a year (Days since 30/12/1899) */
+static inline int32_t timezone_cache_year_start(int32_t year)
+{
+	int32_t previous = year - 1;
+
+	return (previous * 365) + (previous / 4) - (previous / 100) + (previous / 400) - TIMEZONE_CACHE_DAYS_TO_0001;
+}
+
+/* Year of a date value, or 0 if it is outside the years that can be cached */
+static int32_t timezone_cache_date_year(double_t datetime)
+{
+	int32_t days;
+	int32_t year;
+
+	/* Also rejects NaN */
+	if (!(datetime >= timezone_cache_year_start(TIMEZONE_CACHE_MIN_YEAR) && datetime < timezone_cache_year_start(TIMEZONE_CACHE_MAX_YEAR + 1)))
+		return 0;
+
+	days = (int32_t)datetime;
+
+	/* Estimate then correct */
+	year = (int32_t)((days + TIMEZONE_CACHE_DAYS_TO_0001) / 365.2425) + 1;
+	while (timezone_cache_year_start(year) > days)
+		year--;
+	while (timezone_cache_year_start(year + 1) <= days)
+		year++;
+
+	return year;
+}
+
+/* Year of a UTC time, or 0 if it is outside the years that can be cached */
+static int32_t timezone_cache_time_year(int64_t time)
+{
+	if (time < TIME_TICKS_TO_1899)
+		return 0;
+
+	return timezone_cache_date_year((double_t)((time - TIME_TICKS_TO_1899) / TIME_TICKS_PER_DAY));
+}
+
+/* Date value to 100 nanosecond ticks since 1/1/1601, rounded to the nearest millisecond as the rules are in milliseconds */
+static inline int64_t timezone_cache_date_to_ticks(double_t datetime)
+{
+	return ((int64_t)((datetime * PASCAL_TIME_MILLISECONDS_PER_DAY) + 0.5) * TIME_TICKS_PER_MILLISECOND) + TIME_TICKS_TO_1899;
+}
+
+static inline int64_t timezone_cache_file_time_to_ticks(const FILETIME *filetime)
+{
+	return (int64_t)(((uint64_t)filetime->dwHighDateTime << 32) | filetime->dwLowDateTime);
+}
+
+static inline void timezone_cache_ticks_to_file_time(int64_t time, FILETIME *filetime)
+{
+	filetime->dwLowDateTime = (uint32_t)time;
+	filetime->dwHighDateTime = (uint32_t)((uint64_t)time >> 32);
+}
+
+/* Get the bias at a UTC time from SystemTimeToTzSpecificLocalTime with the rules of the timezone */
+static int32_t timezone_cache_universal_bias(TIMEZONE_ENTRY *timezone, int64_t time)
+{
+	TIME_ZONE_INFORMATION information;
+	TIME_ZONE_INFORMATION *rules = NULL;
+	SYSTEMTIME universaltime;
+	SYSTEMTIME localtime;
+	FILETIME filetime;
+
+	if (timezone)
+	{
+		memset(&information, 0, sizeof(TIME_ZONE_INFORMATION));
+		information.bias = timezone->bias;
+		information.standarddate = timezone->standardstart;
+		information.standardbias = timezone->standardbias;
+		information.daylightdate = timezone->daylightstart;
+		information.daylightbias = timezone->daylightbias;
+		rules = &information;
+	}
+
+	/* System times hold whole milliseconds, drop the rest so the difference is whole minutes */
+	time -= time % TIME_TICKS_PER_MILLISECOND;
+
+	timezone_cache_ticks_to_file_time(time, &filetime);
+	if (!FileTimeToSystemTime(&filetime, &universaltime) || !SystemTimeToTzSpecificLocalTime(rules, &universaltime, &localtime) || !SystemTimeToFileTime(&localtime, &filetime))
+		return timezone ? timezone->bias : 0;
+
+	return (int32_t)((time - timezone_cache_file_time_to_ticks(&filetime)) / TIME_TICKS_PER_MINUTE);
+}
+
+/* Find or create the cache for a timezone */
+static TIMEZONE_CACHE *timezone_cache_get(TIMEZONE_ENTRY *timezone)
+{
+	TIMEZONE_CACHE *cache;
+
+	for (cache = timezonecache.caches; cache; cache = cache->next)
+	{
+		if (cache->timezone == timezone)
+			return cache;
+	}
+
+	if (mutex_lock(timezonecache.lock) != ERROR_SUCCESS)
+		return NULL;
+
+	for (cache = timezonecache.caches; cache; cache = cache->next)
+	{
+		if (cache->timezone == timezone)
+			break;
+	}
+
+	if (!cache)
+	{
+		/* An empty window and no table, the first lookup builds both */
+		cache = calloc(1, sizeof(TIMEZONE_CACHE));
+		if (cache)
+		{
+			cache->timezone = timezone;
+			cache->next = timezonecache.caches;
+
+			__sync_synchronize();
+			timezonecache.caches = cache;
+		}
+	}
+
+	mutex_unlock(timezonecache.lock);
+
+	return cache;
+}
+
+/* Read the current window, returns TRUE if the date (Or time if universal is TRUE) is inside it */
+static BOOL timezone_cache_read(TIMEZONE_CACHE *cache, BOOL universal, double_t datetime, int64_t time, int32_t *bias, uint32_t *state)
+{
+	uint32_t sequence;
+	BOOL found;
+
+	while (TRUE)
+	{
+		sequence = cache->sequence;
+		if (sequence & 1)
+		{
+			thread_yield();
+			continue;
+		}
+		__sync_synchronize();
+
+		if (universal)
+			found = (time >= cache->universalstart && time < cache->universalend);
+		else
+			found = (datetime >= cache->localstart && datetime < cache->localend);
+
+		found = found && (cache->generation == timezonecache.generation);
+		*bias = cache->bias;
+		*state = cache->state;
+
+		__sync_synchronize();
+		if (cache->sequence == sequence)
+			return found;
+	}
+}
+
+/* Make an interval of the table the current window, or empty the window if index is beyond the table (Caller must hold the lock) */
+static void timezone_cache_publish(TIMEZONE_CACHE *cache, uint32_t index)
+{
+	cache->sequence++;
+	__sync_synchronize();
+
+	if (index < cache->count)
+	{
+		cache->generation = cache->tablegeneration;
+		cache->localstart = cache->intervals[index].localstart;
+		cache->localend = cache->intervals[index + 1].localstart;
+		cache->universalstart = 0;
+		cache->universalend = 0;
+		if (cache->universal)
+		{
+			cache->universalstart = cache->intervals[index].universalstart;
+			cache->universalend = cache->intervals[index + 1].universalstart;
+		}
+		cache->bias = cache->intervals[index].bias;
+		cache->state = cache->intervals[index].state;
+	}
+	else
+	{
+		cache->localstart = 0;
+		cache->localend = 0;
+		cache->universalstart = 0;
+		cache->universalend = 0;
+	}
+
+	__sync_synchronize();
+	cache->sequence++;
+}
+
+/* Build the table for a year and the years either side (Caller must hold the lock) */
+static BOOL timezone_cache_build(TIMEZONE_CACHE *cache, int32_t year)
+{
+	TIMEZONE_ENTRY *timezone = cache->timezone;
+	TIMEZONE_INTERVAL *interval;
+	double_t boundaries[TIMEZONE_CACHE_MAX_BOUNDARIES];
+	double_t points[3];
+	int64_t times[3];
+	double_t value;
+	double_t first;
+	double_t last;
+	uint32_t generation;
+	uint32_t count;
+	uint32_t index;
+	uint32_t point;
+	uint32_t state;
+	int32_t current;
+	int32_t bias;
+
+	/* Read the generation first so an invalidation while building is not lost */
+	generation = timezonecache.generation;
+	__sync_synchronize();
+
+	cache->count = 0;
+	cache->tableyear = year;
+
+	count = 0;
+	for (current = year - (TIMEZONE_CACHE_YEARS / 2); current <= year + (TIMEZONE_CACHE_YEARS / 2); current++)
+	{
+		first = timezone_cache_year_start(current);
+		last = timezone_cache_year_start(current + 1);
+		boundaries[count++] = first;
+
+		/* A rule with no month (No daylight saving) or a date outside the year adds nothing */
+		value = timezone_start_to_date_time(&timezone->daylightstart, current);
+		if (value > first && value < last)
+			boundaries[count++] = value;
+
+		value = timezone_start_to_date_time(&timezone->standardstart, current);
+		if (value > first && value < last)
+			boundaries[count++] = value;
+	}
+	boundaries[count++] = timezone_cache_year_start(year + (TIMEZONE_CACHE_YEARS / 2) + 1);
+
+	/* Sort the boundaries, at most 2 per year are out of order */
+	for (index = 1; index < count; index++)
+	{
+		value = boundaries[index];
+		for (point = index; point > 0 && boundaries[point - 1] > value; point--)
+			boundaries[point] = boundaries[point - 1];
+		boundaries[point] = value;
+	}
+
+	for (index = 0; index + 1 < count; index++)
+	{
+		/* Rules that fall on the same moment leave an empty interval */
+		if (boundaries[index] == boundaries[index + 1])
+			continue;
+
+		/* The RTL must give the same answer at the start, middle and last millisecond of the interval */
+		points[0] = boundaries[index];
+		points[1] = (boundaries[index] + boundaries[index + 1]) / 2;
+		points[2] = boundaries[index + 1] - (1.0 / PASCAL_TIME_MILLISECONDS_PER_DAY);
+
+		bias = timezone_get_active_bias_ex(timezone, points[0]);
+		state = timezone_get_state_ex(timezone, points[0]);
+		for (point = 1; point < 3; point++)
+		{
+			if (points[point] <= points[0])
+				break;
+			if (timezone_get_active_bias_ex(timezone, points[point]) != bias || timezone_get_state_ex(timezone, points[point]) != state)
+				goto invalid;
+		}
+
+		/* Merge with the previous interval if nothing changes */
+		if (cache->count > 0 && cache->intervals[cache->count - 1].bias == bias && cache->intervals[cache->count - 1].state == state)
+			continue;
+
+		interval = &cache->intervals[cache->count++];
+		interval->localstart = boundaries[index];
+		interval->bias = bias;
+		interval->state = state;
+	}
+	if (cache->count == 0)
+		goto invalid;
+
+	/* The entry after the last interval holds the end */
+	interval = &cache->intervals[cache->count];
+	interval->localstart = boundaries[count - 1];
+	interval->bias = cache->intervals[cache->count - 1].bias;
+	interval->state = cache->intervals[cache->count - 1].state;
+
+	/* Each boundary happens when the local time under the bias before it reaches it (UTC = Local + Bias) */
+	cache->universal = TRUE;
+	for (index = 0; index <= cache->count; index++)
+	{
+		interval = &cache->intervals[index];
+		bias = (index > 0) ? cache->intervals[index - 1].bias : interval->bias;
+		interval->universalstart = timezone_cache_date_to_ticks(interval->localstart) + ((int64_t)bias * TIME_TICKS_PER_MINUTE);
+
+		/* Boundaries closer together than the change in bias cannot be ordered in UTC */
+		if (index > 0 && interval->universalstart <= cache->intervals[index - 1].universalstart)
+			cache->universal = FALSE;
+	}
+
+	/* The UTC intervals must also agree with SystemTimeToTzSpecificLocalTime at the start, middle and last millisecond */
+	for (index = 0; cache->universal && index < cache->count; index++)
+	{
+		interval = &cache->intervals[index];
+		times[0] = interval->universalstart;
+		times[1] = interval->universalstart + ((cache->intervals[index + 1].universalstart - interval->universalstart) / 2);
+		times[2] = cache->intervals[index + 1].universalstart - TIME_TICKS_PER_MILLISECOND;
+		for (point = 0; point < 3; point++)
+		{
+			if (timezone_cache_universal_bias(timezone, times[point]) != interval->bias)
+			{
+				cache->universal = FALSE;
+				break;
+			}
+		}
+	}
+
+	cache->tablegeneration = generation;
+
+	return TRUE;
+
+invalid:
+	/* Keep an empty table for this generation so the same table is not built again on every lookup */
+	cache->count = 0;
+	cache->tablegeneration = generation;
+
+	return FALSE;
+}
+
+/* Find the interval of the table holding a date (Or time if universal is TRUE) */
+static BOOL timezone_cache_find(TIMEZONE_CACHE *cache, BOOL universal, double_t datetime, int64_t time, uint32_t *index)
+{
+	uint32_t count;
+
+	if (cache->tablegeneration != timezonecache.generation)
+		return FALSE;
+	if (universal && !cache->universal)
+		return FALSE;
+
+	for (count = 0; count < cache->count; count++)
+	{
+		if (universal)
+		{
+			if (time >= cache->intervals[count].universalstart && time < cache->intervals[count + 1].universalstart)
+				break;
+		}
+		else
+		{
+			if (datetime >= cache->intervals[count].localstart && datetime < cache->intervals[count + 1].localstart)
+				break;
+		}
+	}
+	if (count >= cache->count)
+		return FALSE;
+
+	*index = count;
+
+	return TRUE;
+}
+
+/* Move the window to the interval holding a date (Or time if universal is TRUE), building the table if needed */
+static BOOL timezone_cache_select(TIMEZONE_CACHE *cache, BOOL universal, double_t datetime, int64_t time, int32_t *bias, uint32_t *state)
+{
+	uint32_t index;
+	int32_t year;
+	BOOL found;
+
+	year = universal ? timezone_cache_time_year(time) : timezone_cache_date_year(datetime);
+	if (year == 0)
+		return FALSE;
+
+	if (mutex_lock(timezonecache.lock) != ERROR_SUCCESS)
+		return FALSE;
+
+	/* Another lookup may already have moved the window or have built the table, a table for this year that
+	   cannot be built or cannot order the UTC boundaries would only be built the same way again */
+	found = timezone_cache_find(cache, universal, datetime, time, &index);
+	if (!found && (cache->tablegeneration != timezonecache.generation || cache->tableyear != year) && timezone_cache_build(cache, year))
+		found = timezone_cache_find(cache, universal, datetime, time, &index);
+
+	if (found)
+	{
+		timezone_cache_publish(cache, index);
+
+		*bias = cache->intervals[index].bias;
+		*state = cache->intervals[index].state;
+	}
+
+	mutex_unlock(timezonecache.lock);
+
+	return found;
+}
+
+/* Get the bias and state at a date (Or time if universal is TRUE), returns FALSE if the RTL must be asked instead */
+static BOOL timezone_cache_lookup(TIMEZONE_ENTRY *timezone, BOOL universal, double_t datetime, int64_t time, int32_t *bias, uint32_t *state)
+{
+	TIMEZONE_CACHE *cache;
+
+	if (!timezone)
+		return FALSE;
+
+	timezone_cache_start();
+
+	cache = timezone_cache_get(timezone);
+	if (!cache)
+		return FALSE;
+
+	if (timezone_cache_read(cache, universal, datetime, time, bias, state))
+		return TRUE;
+
+	return timezone_cache_select(cache, universal, datetime, time, bias, state);
+}
+
+/* ============================================================================== */
+/* Timezone Cache Functions */
+uint32_t STDCALL timezone_cache_get_state(TIMEZONE_ENTRY *timezone, double_t datetime)
+{
+	uint32_t state;
+	int32_t bias;
+
+	if (!timezone)
+		timezone = timezone_get_default();
+
+	if (timezone_cache_lookup(timezone, FALSE, datetime, 0, &bias, &state))
+		return state;
+
+	return timezone_get_state_ex(timezone, datetime);
+}
+
+int32_t STDCALL timezone_cache_get_active_bias(TIMEZONE_ENTRY *timezone, double_t datetime)
+{
+	uint32_t state;
+	int32_t bias;
+
+	if (!timezone)
+		timezone = timezone_get_default();
+
+	if (timezone_cache_lookup(timezone, FALSE, datetime, 0, &bias, &state))
+		return bias;
+
+	return timezone_get_active_bias_ex(timezone, datetime);
+}
+
+int32_t STDCALL timezone_cache_get_universal_bias(TIMEZONE_ENTRY *timezone, int64_t time)
+{
+	uint32_t state;
+	int32_t bias;
+
+	if (!timezone)
+		timezone = timezone_get_default();
+
+	if (timezone_cache_lookup(timezone, TRUE, 0, time, &bias, &state))
+		return bias;
+
+	return timezone_cache_universal_bias(timezone, time);
+}
+
+int64_t STDCALL timezone_cache_universal_to_local(TIMEZONE_ENTRY *timezone, int64_t time)
+{
+	/* Local = UTC - Bias */
+	return time - ((int64_t)timezone_cache_get_universal_bias(timezone, time) * TIME_TICKS_PER_MINUTE);
+}
+
+/* Note: The offset changes at the UTC instant of each boundary, the RTL finds the state from the local
+         time which it works out with the previous offset so during the repeated hour at the end of
+         daylight time it can return either value */
+int32_t STDCALL timezone_cache_get_active_offset(void)
+{
+	TIMEZONE_ENTRY *timezone;
+	FILETIME filetime;
+	uint32_t state;
+	int32_t bias;
+
+	timezone = timezone_get_default();
+
+	GetSystemTimeAsFileTime(&filetime);
+	if (timezone_cache_lookup(timezone, TRUE, 0, timezone_cache_file_time_to_ticks(&filetime), &bias, &state))
+		return bias;
+
+	return GetTimezoneActiveOffset();
+}
+
+BOOL STDCALL timezone_cache_file_time_to_local_file_time(const FILETIME *filetime, FILETIME *localfiletime)
+{
+	int64_t time;
+
+	if (!filetime || !localfiletime)
+		return FALSE;
+
+	time = timezone_cache_file_time_to_ticks(filetime) - ((int64_t)timezone_cache_get_active_offset() * TIME_TICKS_PER_MINUTE);
+	timezone_cache_ticks_to_file_time(time, localfiletime);
+
+	return TRUE;
+}
+
+BOOL STDCALL timezone_cache_local_file_time_to_file_time(const FILETIME *localfiletime, FILETIME *filetime)
+{
+	int64_t time;
+
+	if (!localfiletime || !filetime)
+		return FALSE;
+
+	time = timezone_cache_file_time_to_ticks(localfiletime) + ((int64_t)timezone_cache_get_active_offset() * TIME_TICKS_PER_MINUTE);
+	timezone_cache_ticks_to_file_time(time, filetime);
+
+	return TRUE;
+}
+
+BOOL STDCALL timezone_cache_system_time_to_local_time(TIME_ZONE_INFORMATION *timezoneinformation, const SYSTEMTIME *universaltime, SYSTEMTIME *localtime)
+{
+	FILETIME filetime;
+
+	/* Rules supplied by the caller are not cached */
+	if (timezoneinformation)
+		return SystemTimeToTzSpecificLocalTime(timezoneinformation, (SYSTEMTIME *)universaltime, localtime);
+
+	if (!universaltime || !localtime)
+		return FALSE;
+
+	if (!SystemTimeToFileTime((SYSTEMTIME *)universaltime, &filetime))
+		return FALSE;
+
+	timezone_cache_ticks_to_file_time(timezone_cache_universal_to_local(NULL, timezone_cache_file_time_to_ticks(&filetime)), &filetime);
+
+	return FileTimeToSystemTime(&filetime, localtime);
+}
+
+uint32_t STDCALL timezone_cache_invalidate(TIMEZONE_ENTRY *timezone)
+{
+	TIMEZONE_CACHE *cache;
+
+	timezone_cache_start();
+
+	if (!timezone)
+	{
+		__sync_add_and_fetch(&timezonecache.generation, 1);
+		return ERROR_SUCCESS;
+	}
+
+	for (cache = timezonecache.caches; cache; cache = cache->next)
+	{
+		if (cache->timezone == timezone)
+			break;
+	}
+	if (!cache)
+		return ERROR_SUCCESS;
+
+	if (mutex_lock(timezonecache.lock) != ERROR_SUCCESS)
+		return ERROR_OPERATION_FAILED;
+
+	/* Discard the table and empty the window */
+	cache->count = 0;
+	cache->tablegeneration = 0;
+	timezone_cache_publish(cache, 0);
+
+	mutex_unlock(timezonecache.lock);
+
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL timezone_cache_update_offset(void)
+{
+	uint32_t status;
+
+	status = timezone_update_offset();
+	timezone_cache_invalidate(NULL);
+
+	return status;
+}
+
+BOOL STDCALL timezone_cache_set_information(TIME_ZONE_INFORMATION *timezoneinformation)
+{
+	BOOL result;
+
+	result = SetTimeZoneInformation(timezoneinformation);
+	timezone_cache_invalidate(NULL);
+
+	return result;
+}
@@ -0,0 +1,731 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Host test for the timezone transition cache (timezone/timezonecache.c)
+ *
+ * This file is not part of the Ultibo run time, it includes timezonecache.c with
+ * stub versions of the thread and mutex functions and a model of the RTL timezone
+ * functions (timezone_start_to_date_time, timezone_get_state_ex and the Windows
+ * style SystemTimeToTzSpecificLocalTime which applies the rules of the UTC year).
+ *
+ * For a set of timezones with northern, southern, absolute, year end and odd bias
+ * rules the cached state, bias and UTC bias must equal the model:
+ *
+ *  Random    - Random dates and times from 1901 to 2200
+ *
+ *  Edges     - Every boundary from 1990 to 2060 (Both rules, the start and end of
+ *              each year) and from 1 millisecond to 1 day either side, in local
+ *              time and in UTC under each bias
+ *
+ *  Sequence  - Increasing UTC times 7 minutes apart over 8 years as a logger would
+ *              use them, the number of calls passed to the RTL is reported
+ *
+ * Then the default timezone functions, invalidation of one and all entries and
+ * lookups from several threads while the cache is invalidated are checked.
+ *
+ * Build and run from the root of the repository with:
+ *
+ *  gcc -std=gnu11 -g -O1 -pthread -fsanitize=address,undefined -iquote include -o timezonecachetest src/timezone/timezonecachetest.c -lm && ./timezonecachetest
+ *
+ * A count of random dates for each timezone can be given as the first parameter (Default 20000).
+ */
+
+/* The Ultibo timer_create conflicts with the POSIX declaration in the host headers */
+#define timer_create host_timer_create
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <unistd.h>
+#undef timer_create
+
+/* Newlib definitions used by the Ultibo headers */
+#define _ATTRIBUTE(x) __attribute__(x)
+#define __VALIST __gnuc_va_list
+
+#include "timezonecache.c"
+
+/* ============================================================================== */
+/* Host stubs */
+#define HOST_DAYS_TO_1970	25569 // Days from 30/12/1899 to 1/1/1970
+#define HOST_DAYS_TO_1601	134774 // Days from 1/1/1601 to 1/1/1970
+
+static TIMEZONE_ENTRY *host_default;
+static int64_t host_now; // UTC time returned by GetSystemTimeAsFileTime
+static volatile uint32_t host_rtl_calls; // Calls to the model from timezonecache.c (The test itself uses the uncounted versions)
+
+uint32_t STDCALL thread_yield(void)
+{
+	sched_yield();
+	return ERROR_SUCCESS;
+}
+
+MUTEX_HANDLE STDCALL mutex_create(void)
+{
+	pthread_mutex_t *mutex;
+
+	mutex = malloc(sizeof(pthread_mutex_t));
+	if (!mutex)
+		return INVALID_HANDLE_VALUE;
+
+	pthread_mutex_init(mutex, NULL);
+
+	return (MUTEX_HANDLE)mutex;
+}
+
+uint32_t STDCALL mutex_lock(MUTEX_HANDLE mutex)
+{
+	pthread_mutex_lock((pthread_mutex_t *)mutex);
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL mutex_unlock(MUTEX_HANDLE mutex)
+{
+	pthread_mutex_unlock((pthread_mutex_t *)mutex);
+	return ERROR_SUCCESS;
+}
+
+/* Days since 1/1/1970 of a date in the proleptic Gregorian calendar (Written independently of timezone_cache_year_start) */
+static int64_t host_days_from_civil(int64_t year, uint32_t month, uint32_t day)
+{
+	int64_t era;
+	uint32_t yearofera;
+	uint32_t dayofyear;
+	uint32_t dayofera;
+
+	year -= (month <= 2);
+	era = (year >= 0 ? year : year - 399) / 400;
+	yearofera = (uint32_t)(year - era * 400);
+	dayofyear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	dayofera = yearofera * 365 + yearofera / 4 - yearofera / 100 + dayofyear;
+
+	return era * 146097 + (int64_t)dayofera - 719468;
+}
+
+static void host_civil_from_days(int64_t days, int32_t *year, uint32_t *month, uint32_t *day)
+{
+	int64_t era;
+	uint32_t dayofera;
+	uint32_t yearofera;
+	uint32_t dayofyear;
+	uint32_t shifted;
+
+	days += 719468;
+	era = (days >= 0 ? days : days - 146096) / 146097;
+	dayofera = (uint32_t)(days - era * 146097);
+	yearofera = (dayofera - dayofera / 1460 + dayofera / 36524 - dayofera / 146096) / 365;
+	dayofyear = dayofera - (365 * yearofera + yearofera / 4 - yearofera / 100);
+	shifted = (5 * dayofyear + 2) / 153;
+
+	*day = dayofyear - (153 * shifted + 2) / 5 + 1;
+	*month = shifted + (shifted < 10 ? 3 : -9);
+	*year = (int32_t)(yearofera + era * 400 + (*month <= 2));
+}
+
+/* Date value (Days since 30/12/1899) of a date and time */
+static double_t host_encode_date(int32_t year, uint32_t month, uint32_t day, uint32_t hour, uint32_t minute, uint32_t second, uint32_t millisecond)
+{
+	return (double_t)(host_days_from_civil(year, month, day) + HOST_DAYS_TO_1970) + ((hour * 3600000.0) + (minute * 60000.0) + (second * 1000.0) + millisecond) / 86400000.0;
+}
+
+static int32_t host_date_year(double_t datetime)
+{
+	int32_t year;
+	uint32_t month;
+	uint32_t day;
+
+	host_civil_from_days((int64_t)floor(datetime) - HOST_DAYS_TO_1970, &year, &month, &day);
+
+	return year;
+}
+
+/* UTC time in 100 nanosecond ticks since 1/1/1601 of a date value, rounded to the millisecond */
+static int64_t host_date_to_ticks(double_t datetime)
+{
+	return ((int64_t)((datetime * 86400000.0) + 0.5) * TIME_TICKS_PER_MILLISECOND) + TIME_TICKS_TO_1899;
+}
+
+static void host_count_rtl(void)
+{
+	__sync_fetch_and_add(&host_rtl_calls, 1);
+}
+
+/* Date of a rule in a year, a day of the week rule with day 5 is the last in the month, 0 if there is no rule for the year */
+static double_t host_start_date(const SYSTEMTIME *start, int32_t year)
+{
+	int64_t first;
+	int32_t weekday;
+	int32_t days;
+	int32_t day;
+
+	if (start->wmonth == 0)
+		return 0;
+
+	/* Absolute rules apply only to their own year */
+	if (start->wyear != 0)
+	{
+		if (start->wyear != year)
+			return 0;
+
+		return host_encode_date(year, start->wmonth, start->wday, start->whour, start->wminute, start->wsecond, start->wmilliseconds);
+	}
+
+	/* 1/1/1970 was a Thursday */
+	first = host_days_from_civil(year, start->wmonth, 1);
+	weekday = (int32_t)(((first + 4) % 7 + 7) % 7);
+	days = (int32_t)(host_days_from_civil((start->wmonth == 12) ? year + 1 : year, (start->wmonth == 12) ? 1 : start->wmonth + 1, 1) - first);
+
+	day = 1 + (((int32_t)start->wdayofweek - weekday + 7) % 7) + (7 * ((int32_t)start->wday - 1));
+	while (day > days)
+		day -= 7;
+
+	return host_encode_date(year, start->wmonth, day, start->whour, start->wminute, start->wsecond, start->wmilliseconds);
+}
+
+static uint32_t host_state(TIMEZONE_ENTRY *timezone, double_t datetime)
+{
+	double_t standard;
+	double_t daylight;
+	int32_t year;
+
+	if (!timezone || timezone->standardstart.wmonth == 0 || timezone->daylightstart.wmonth == 0)
+		return TIME_ZONE_ID_UNKNOWN;
+
+	year = host_date_year(datetime);
+	standard = host_start_date(&timezone->standardstart, year);
+	daylight = host_start_date(&timezone->daylightstart, year);
+	if (standard == 0 || daylight == 0)
+		return TIME_ZONE_ID_STANDARD;
+
+	/* Southern hemisphere rules have daylight time over the end of the year */
+	if (daylight < standard)
+		return (datetime >= daylight && datetime < standard) ? TIME_ZONE_ID_DAYLIGHT : TIME_ZONE_ID_STANDARD;
+
+	return (datetime >= standard && datetime < daylight) ? TIME_ZONE_ID_STANDARD : TIME_ZONE_ID_DAYLIGHT;
+}
+
+static int32_t host_active_bias(TIMEZONE_ENTRY *timezone, double_t datetime)
+{
+	if (!timezone)
+		return 0;
+
+	switch (host_state(timezone, datetime))
+	{
+		case TIME_ZONE_ID_DAYLIGHT:
+			return timezone->bias + timezone->daylightbias;
+		case TIME_ZONE_ID_STANDARD:
+			return timezone->bias + timezone->standardbias;
+	}
+
+	return timezone->bias;
+}
+
+/* Bias at a UTC time as SystemTimeToTzSpecificLocalTime applies it, both rules are taken from the year of the UTC time and moved to UTC by the bias before them */
+static int32_t host_universal_bias_rules(const TIME_ZONE_INFORMATION *information, int64_t time)
+{
+	double_t daylightdate;
+	double_t standarddate;
+	int64_t daylight;
+	int64_t standard;
+	int32_t year;
+	uint32_t month;
+	uint32_t day;
+	BOOL daylighttime;
+
+	if (information->standarddate.wmonth == 0 || information->daylightdate.wmonth == 0)
+		return information->bias;
+
+	host_civil_from_days((time / TIME_TICKS_PER_DAY) - HOST_DAYS_TO_1601, &year, &month, &day);
+
+	daylightdate = host_start_date(&information->daylightdate, year);
+	standarddate = host_start_date(&information->standarddate, year);
+	if (daylightdate == 0 || standarddate == 0)
+		return information->bias + information->standardbias;
+
+	daylight = host_date_to_ticks(daylightdate) + ((int64_t)(information->bias + information->standardbias) * TIME_TICKS_PER_MINUTE);
+	standard = host_date_to_ticks(standarddate) + ((int64_t)(information->bias + information->daylightbias) * TIME_TICKS_PER_MINUTE);
+
+	if (daylight < standard)
+		daylighttime = (time >= daylight && time < standard);
+	else
+		daylighttime = !(time >= standard && time < daylight);
+
+	return information->bias + (daylighttime ? information->daylightbias : information->standardbias);
+}
+
+static void host_information(TIMEZONE_ENTRY *timezone, TIME_ZONE_INFORMATION *information)
+{
+	memset(information, 0, sizeof(TIME_ZONE_INFORMATION));
+	information->bias = timezone->bias;
+	information->standarddate = timezone->standardstart;
+	information->standardbias = timezone->standardbias;
+	information->daylightdate = timezone->daylightstart;
+	information->daylightbias = timezone->daylightbias;
+}
+
+static int32_t host_universal_bias(TIMEZONE_ENTRY *timezone, int64_t time)
+{
+	TIME_ZONE_INFORMATION information;
+
+	host_information(timezone, &information);
+
+	/* System times hold whole milliseconds */
+	return host_universal_bias_rules(&information, time - (time % TIME_TICKS_PER_MILLISECOND));
+}
+
+double_t STDCALL timezone_start_to_date_time(SYSTEMTIME *start, uint16_t year)
+{
+	host_count_rtl();
+
+	return host_start_date(start, year);
+}
+
+uint32_t STDCALL timezone_get_state_ex(TIMEZONE_ENTRY *timezone, double_t datetime)
+{
+	host_count_rtl();
+
+	return host_state(timezone, datetime);
+}
+
+int32_t STDCALL timezone_get_active_bias_ex(TIMEZONE_ENTRY *timezone, double_t datetime)
+{
+	host_count_rtl();
+
+	return host_active_bias(timezone, datetime);
+}
+
+TIMEZONE_ENTRY * STDCALL timezone_get_default(void)
+{
+	return host_default;
+}
+
+uint32_t STDCALL timezone_update_offset(void)
+{
+	return ERROR_SUCCESS;
+}
+
+BOOL STDCALL SystemTimeToFileTime(SYSTEMTIME *systemtime, FILETIME *filetime)
+{
+	int64_t time;
+
+	time = (host_days_from_civil(systemtime->wyear, systemtime->wmonth, systemtime->wday) + HOST_DAYS_TO_1601) * TIME_TICKS_PER_DAY;
+	time += (systemtime->whour * TIME_TICKS_PER_HOUR) + (systemtime->wminute * (int64_t)TIME_TICKS_PER_MINUTE);
+	time += (systemtime->wsecond * (int64_t)TIME_TICKS_PER_SECOND) + (systemtime->wmilliseconds * (int64_t)TIME_TICKS_PER_MILLISECOND);
+
+	filetime->dwLowDateTime = (uint32_t)time;
+	filetime->dwHighDateTime = (uint32_t)(time >> 32);
+
+	return TRUE;
+}
+
+BOOL STDCALL FileTimeToSystemTime(FILETIME *filetime, SYSTEMTIME *systemtime)
+{
+	int64_t time = ((int64_t)filetime->dwHighDateTime << 32) | filetime->dwLowDateTime;
+	int64_t days = time / TIME_TICKS_PER_DAY;
+	int64_t remain = time % TIME_TICKS_PER_DAY;
+	int32_t year;
+	uint32_t month;
+	uint32_t day;
+
+	host_civil_from_days(days - HOST_DAYS_TO_1601, &year, &month, &day);
+
+	systemtime->wyear = year;
+	systemtime->wmonth = month;
+	systemtime->wday = day;
+	systemtime->wdayofweek = (days + 1) % 7;
+	systemtime->whour = remain / TIME_TICKS_PER_HOUR;
+	systemtime->wminute = (remain % TIME_TICKS_PER_HOUR) / TIME_TICKS_PER_MINUTE;
+	systemtime->wsecond = (remain % TIME_TICKS_PER_MINUTE) / TIME_TICKS_PER_SECOND;
+	systemtime->wmilliseconds = (remain % TIME_TICKS_PER_SECOND) / TIME_TICKS_PER_MILLISECOND;
+
+	return TRUE;
+}
+
+BOOL STDCALL SystemTimeToTzSpecificLocalTime(TIME_ZONE_INFORMATION *timezoneinformation, SYSTEMTIME *universaltime, SYSTEMTIME *localtime)
+{
+	TIME_ZONE_INFORMATION information;
+	FILETIME filetime;
+	int64_t time;
+
+	host_count_rtl();
+
+	if (!timezoneinformation)
+	{
+		if (!host_default)
+			return FALSE;
+
+		host_information(host_default, &information);
+		timezoneinformation = &information;
+	}
+
+	SystemTimeToFileTime(universaltime, &filetime);
+	time = ((int64_t)filetime.dwHighDateTime << 32) | filetime.dwLowDateTime;
+	time -= (int64_t)host_universal_bias_rules(timezoneinformation, time) * TIME_TICKS_PER_MINUTE;
+
+	filetime.dwLowDateTime = (uint32_t)time;
+	filetime.dwHighDateTime = (uint32_t)(time >> 32);
+
+	return FileTimeToSystemTime(&filetime, localtime);
+}
+
+void STDCALL GetSystemTimeAsFileTime(FILETIME *filetime)
+{
+	filetime->dwLowDateTime = (uint32_t)host_now;
+	filetime->dwHighDateTime = (uint32_t)(host_now >> 32);
+}
+
+int32_t STDCALL GetTimezoneActiveOffset(void)
+{
+	host_count_rtl();
+
+	if (!host_default)
+		return 0;
+
+	return host_universal_bias(host_default, host_now);
+}
+
+BOOL STDCALL SetTimeZoneInformation(TIME_ZONE_INFORMATION *timezoneinformation)
+{
+	if (!host_default)
+		return FALSE;
+
+	host_default->bias = timezoneinformation->bias;
+	host_default->standardstart = timezoneinformation->standarddate;
+	host_default->standardbias = timezoneinformation->standardbias;
+	host_default->daylightstart = timezoneinformation->daylightdate;
+	host_default->daylightbias = timezoneinformation->daylightbias;
+
+	return TRUE;
+}
+
+/* ============================================================================== */
+/* Host test */
+#define HOST_ZONES	8
+#define HOST_THREADS	4
+#define HOST_THREAD_LOOKUPS	100000
+
+/* Counted atomically as the checks also run on several threads */
+#define HOST_CHECK(condition, ...) do { __sync_fetch_and_add(&checks, 1); if (!(condition)) { if (__sync_fetch_and_add(&failures, 1) < 20) { printf("FAIL: "); printf(__VA_ARGS__); printf("\n"); } } } while (0)
+
+static volatile uint32_t failures;
+static volatile uint32_t checks;
+
+static TIMEZONE_ENTRY host_zones[HOST_ZONES];
+
+static uint32_t host_random(void)
+{
+	static __thread uint64_t state = 88172645463325252ULL;
+
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+
+	return (uint32_t)state;
+}
+
+static double_t host_random_date(int32_t first, int32_t last)
+{
+	double_t start = host_encode_date(first, 1, 1, 0, 0, 0, 0);
+	double_t end = host_encode_date(last, 1, 1, 0, 0, 0, 0);
+
+	return start + (end - start) * (host_random() / 4294967296.0);
+}
+
+static SYSTEMTIME host_rule(uint16_t year, uint16_t month, uint16_t dayofweek, uint16_t day, uint16_t hour, uint16_t minute)
+{
+	SYSTEMTIME rule;
+
+	memset(&rule, 0, sizeof(SYSTEMTIME));
+	rule.wyear = year;
+	rule.wmonth = month;
+	rule.wdayofweek = dayofweek;
+	rule.wday = day;
+	rule.whour = hour;
+	rule.wminute = minute;
+
+	return rule;
+}
+
+static void host_zone(uint32_t index, const char *name, int32_t bias, int32_t standardbias, SYSTEMTIME standardstart, int32_t daylightbias, SYSTEMTIME daylightstart)
+{
+	TIMEZONE_ENTRY *timezone = &host_zones[index];
+
+	memset(timezone, 0, sizeof(TIMEZONE_ENTRY));
+	timezone->signature = TIMEZONE_SIGNATURE;
+	strncpy(timezone->name, name, TIMEZONE_NAME_LENGTH - 1);
+	timezone->bias = bias;
+	timezone->standardbias = standardbias;
+	timezone->standardstart = standardstart;
+	timezone->daylightbias = daylightbias;
+	timezone->daylightstart = daylightstart;
+}
+
+static void host_check_local(TIMEZONE_ENTRY *timezone, double_t datetime, const char *what)
+{
+	uint32_t state = timezone_cache_get_state(timezone, datetime);
+	int32_t bias = timezone_cache_get_active_bias(timezone, datetime);
+
+	HOST_CHECK(state == host_state(timezone, datetime) && bias == host_active_bias(timezone, datetime), "%s %s local %.9f: state %u bias %d expected state %u bias %d",
+		timezone->name, what, datetime, (unsigned int)state, (int)bias, (unsigned int)host_state(timezone, datetime), (int)host_active_bias(timezone, datetime));
+}
+
+static void host_check_universal(TIMEZONE_ENTRY *timezone, int64_t time, const char *what)
+{
+	int32_t expected = host_universal_bias(timezone, time);
+	int32_t bias = timezone_cache_get_universal_bias(timezone, time);
+
+	HOST_CHECK(bias == expected, "%s %s universal %lld ms: bias %d expected %d", timezone->name, what, (long long)(time / TIME_TICKS_PER_MILLISECOND), (int)bias, (int)expected);
+	HOST_CHECK(timezone_cache_universal_to_local(timezone, time) == time - ((int64_t)expected * TIME_TICKS_PER_MINUTE), "%s %s universal_to_local %lld ms", timezone->name, what, (long long)(time / TIME_TICKS_PER_MILLISECOND));
+}
+
+static void host_random_dates(TIMEZONE_ENTRY *timezone, uint32_t count)
+{
+	double_t datetime;
+	uint32_t index;
+
+	for (index = 0; index < count; index++)
+	{
+		datetime = host_random_date(1901, 2200);
+
+		host_check_local(timezone, datetime, "random");
+		host_check_universal(timezone, host_date_to_ticks(datetime), "random");
+	}
+}
+
+/* Each boundary and the times either side of it in local time, and in UTC under the standard, daylight and base bias */
+static void host_edges(TIMEZONE_ENTRY *timezone)
+{
+	static const double_t deltas[] = {0, 0.001, 1, 59, 60, 61, 3599, 3600, 3601, 86400}; // Seconds
+	double_t boundaries[4];
+	int32_t biases[3];
+	uint32_t boundary;
+	uint32_t delta;
+	uint32_t bias;
+	int32_t year;
+	int32_t sign;
+	int64_t time;
+
+	biases[0] = timezone->bias + timezone->standardbias;
+	biases[1] = timezone->bias;
+	biases[2] = timezone->bias + timezone->daylightbias;
+
+	for (year = 1990; year <= 2060; year++)
+	{
+		boundaries[0] = host_start_date(&timezone->daylightstart, year);
+		boundaries[1] = host_start_date(&timezone->standardstart, year);
+		boundaries[2] = host_encode_date(year, 1, 1, 0, 0, 0, 0);
+		boundaries[3] = host_encode_date(year, 12, 31, 23, 59, 59, 999);
+
+		for (boundary = 0; boundary < 4; boundary++)
+		{
+			if (boundaries[boundary] <= 0)
+				continue;
+
+			for (delta = 0; delta < sizeof(deltas) / sizeof(deltas[0]); delta++)
+			{
+				for (sign = -1; sign <= 1; sign += 2)
+				{
+					host_check_local(timezone, boundaries[boundary] + (sign * deltas[delta] / 86400.0), "edge");
+
+					for (bias = 0; bias < 3; bias++)
+					{
+						time = host_date_to_ticks(boundaries[boundary]) + ((int64_t)biases[bias] * TIME_TICKS_PER_MINUTE) + (sign * (int64_t)(deltas[delta] * TIME_TICKS_PER_SECOND));
+						host_check_universal(timezone, time, "edge");
+					}
+				}
+			}
+		}
+	}
+}
+
+/* Increasing UTC times as a logger would use them, returns the calls passed to the RTL */
+static uint32_t host_sequence(TIMEZONE_ENTRY *timezone, uint32_t *count)
+{
+	int64_t time = host_date_to_ticks(host_encode_date(2019, 1, 1, 0, 0, 0, 0));
+	int64_t end = host_date_to_ticks(host_encode_date(2027, 1, 1, 0, 0, 0, 0));
+	uint32_t calls = 0;
+	uint32_t start;
+	int32_t bias;
+
+	*count = 0;
+
+	for (; time < end; time += ((int64_t)7 * TIME_TICKS_PER_MINUTE) + 12345)
+	{
+		start = host_rtl_calls;
+		bias = timezone_cache_get_universal_bias(timezone, time);
+		calls += host_rtl_calls - start;
+
+		(*count)++;
+		if (*count % 97 == 0)
+			HOST_CHECK(bias == host_universal_bias(timezone, time), "%s sequence %lld ms: bias %d expected %d", timezone->name, (long long)(time / TIME_TICKS_PER_MILLISECOND), (int)bias, (int)host_universal_bias(timezone, time));
+	}
+
+	return calls;
+}
+
+/* The default timezone functions and invalidation of one entry and of all entries */
+static void host_default_timezone(void)
+{
+	TIME_ZONE_INFORMATION information;
+	SYSTEMTIME universaltime;
+	SYSTEMTIME localtimes[2];
+	FILETIME filetimes[3];
+	int32_t stale;
+	uint32_t index;
+
+	host_default = &host_zones[0];
+	host_now = host_date_to_ticks(host_encode_date(2025, 7, 1, 12, 0, 0, 0));
+
+	/* US rules, daylight time in July */
+	HOST_CHECK(timezone_cache_get_active_offset() == 240 && GetTimezoneActiveOffset() == 240, "active offset %d expected 240", (int)timezone_cache_get_active_offset());
+
+	GetSystemTimeAsFileTime(&filetimes[0]);
+	timezone_cache_file_time_to_local_file_time(&filetimes[0], &filetimes[1]);
+	timezone_cache_local_file_time_to_file_time(&filetimes[1], &filetimes[2]);
+	HOST_CHECK(memcmp(&filetimes[0], &filetimes[2], sizeof(FILETIME)) == 0 && timezone_cache_file_time_to_ticks(&filetimes[0]) - timezone_cache_file_time_to_ticks(&filetimes[1]) == 240LL * TIME_TICKS_PER_MINUTE, "file time to local file time");
+
+	FileTimeToSystemTime(&filetimes[0], &universaltime);
+	timezone_cache_system_time_to_local_time(NULL, &universaltime, &localtimes[0]);
+	SystemTimeToTzSpecificLocalTime(NULL, &universaltime, &localtimes[1]);
+	HOST_CHECK(memcmp(&localtimes[0], &localtimes[1], sizeof(SYSTEMTIME)) == 0, "system time to local time");
+
+	/* Set the default to European rules */
+	memset(&information, 0, sizeof(TIME_ZONE_INFORMATION));
+	information.bias = -60;
+	information.standarddate = host_zones[1].standardstart;
+	information.daylightdate = host_zones[1].daylightstart;
+	information.daylightbias = -60;
+
+	timezone_cache_set_information(&information);
+	HOST_CHECK(timezone_cache_get_active_offset() == -120, "active offset after set information %d expected -120", (int)timezone_cache_get_active_offset());
+
+	for (index = 0; index < 1000; index++)
+		host_check_local(&host_zones[0], host_random_date(2000, 2040), "after set information");
+
+	/* A change to an entry is not seen until it is invalidated */
+	timezone_cache_get_active_bias(&host_zones[2], host_encode_date(2025, 1, 1, 0, 0, 0, 0));
+	host_zones[2].daylightbias = -30;
+	stale = timezone_cache_get_active_bias(&host_zones[2], host_encode_date(2025, 1, 1, 0, 0, 0, 0));
+
+	timezone_cache_invalidate(&host_zones[2]);
+	HOST_CHECK(stale == -660 && timezone_cache_get_active_bias(&host_zones[2], host_encode_date(2025, 1, 1, 0, 0, 0, 0)) == -630, "invalidate entry: stale %d", (int)stale);
+}
+
+static void *host_thread_execute(void *parameter)
+{
+	TIMEZONE_ENTRY *timezone;
+	double_t datetime;
+	int64_t time;
+	int32_t bias;
+	uint32_t index;
+
+	for (index = 0; index < HOST_THREAD_LOOKUPS; index++)
+	{
+		timezone = &host_zones[host_random() % 4];
+		datetime = host_random_date(1950, 2100);
+
+		if (index & 1)
+		{
+			bias = timezone_cache_get_active_bias(timezone, datetime);
+			HOST_CHECK(bias == host_active_bias(timezone, datetime), "%s thread local %.9f: bias %d expected %d", timezone->name, datetime, (int)bias, (int)host_active_bias(timezone, datetime));
+		}
+		else
+		{
+			time = host_date_to_ticks(datetime);
+			bias = timezone_cache_get_universal_bias(timezone, time);
+			HOST_CHECK(bias == host_universal_bias(timezone, time), "%s thread universal %lld ms: bias %d expected %d", timezone->name, (long long)(time / TIME_TICKS_PER_MILLISECOND), (int)bias, (int)host_universal_bias(timezone, time));
+		}
+	}
+
+	return NULL;
+}
+
+/* Lookups on several threads while the cache is invalidated */
+static void host_threads(void)
+{
+	pthread_t threads[HOST_THREADS];
+	uint32_t index;
+
+	for (index = 0; index < HOST_THREADS; index++)
+		pthread_create(&threads[index], NULL, host_thread_execute, NULL);
+
+	for (index = 0; index < 200; index++)
+	{
+		timezone_cache_invalidate(NULL);
+		timezone_cache_invalidate(&host_zones[host_random() % 4]);
+		sched_yield();
+	}
+
+	for (index = 0; index < HOST_THREADS; index++)
+		pthread_join(threads[index], NULL);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t count = 20000;
+	uint32_t startfailures;
+	uint32_t startchecks;
+	uint32_t lookups;
+	uint32_t calls;
+	uint32_t index;
+
+	setvbuf(stdout, NULL, _IONBF, 0);
+
+	if (argc > 1)
+		count = strtoul(argv[1], NULL, 0);
+
+	host_zone(0, "us", 300, 0, host_rule(0, 11, 0, 1, 2, 0), -60, host_rule(0, 3, 0, 2, 2, 0));
+	host_zone(1, "eu", -60, 0, host_rule(0, 10, 0, 5, 3, 0), -60, host_rule(0, 3, 0, 5, 2, 0));
+	host_zone(2, "au", -600, 0, host_rule(0, 4, 0, 1, 3, 0), -60, host_rule(0, 10, 0, 1, 2, 0));
+	host_zone(3, "none", -330, 0, host_rule(0, 0, 0, 0, 0, 0), 0, host_rule(0, 0, 0, 0, 0, 0));
+	host_zone(4, "abs2030", 0, 0, host_rule(2030, 10, 0, 20, 2, 0), -60, host_rule(2030, 4, 0, 10, 1, 0)); // Absolute rules for one year
+	host_zone(5, "yearend", 120, 10, host_rule(0, 1, 0, 1, 0, 30), -30, host_rule(0, 12, 0, 31, 23, 30)); // Rules within the bias of the year end
+	host_zone(6, "close", 0, 0, host_rule(0, 3, 0, 2, 2, 30), -60, host_rule(0, 3, 0, 2, 2, 0)); // Rules 30 minutes apart
+	host_zone(7, "bias", 480, 60, host_rule(0, 11, 6, 5, 23, 59), -120, host_rule(0, 2, 1, 5, 0, 0)); // Standard bias and a 2 hour daylight bias
+
+	for (index = 0; index < HOST_ZONES; index++)
+	{
+		startfailures = failures;
+		startchecks = checks;
+
+		host_random_dates(&host_zones[index], count);
+		host_edges(&host_zones[index]);
+		calls = host_sequence(&host_zones[index], &lookups);
+
+		printf("%-8s checks %u failures %u (Sequence of %u lookups passed %u calls to the RTL)\n", host_zones[index].name, (unsigned int)(checks - startchecks), (unsigned int)(failures - startfailures), (unsigned int)lookups, (unsigned int)calls);
+	}
+
+	host_default_timezone();
+	host_threads();
+
+	printf("checks %u failures %u\n", (unsigned int)checks, (unsigned int)failures);
+
+	return failures ? 1 : 0;
+}
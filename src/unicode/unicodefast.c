@@ -0,0 +1,1681 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "ultibo/platform.h"
+#include "ultibo/threads.h"
+#include "ultibo/locale.h"
+#include "ultibo/unicode.h"
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/* Implementation of fast paths for the Unicode conversion functions for Ultibo API
+ *
+ * The conversion functions exported by the RTL work one character at a time which
+ * is slow for bulk text such as web pages. The functions here take the same
+ * parameters and return the same results, but only handle the cases where the
+ * answer is unambiguous and pass everything else to the RTL function unchanged:
+ *
+ *  UTF-8     - Valid input only. Any invalid or truncated sequence, an output
+ *              buffer that is too small or flags other than MB_ERR_INVALID_CHARS
+ *              are left to the RTL so replacement characters and last error
+ *              values are exactly what the RTL produces
+ *
+ *  SBCS      - Single byte code pages (CPINFO.maxcharsize = 1) use a table of all
+ *              256 byte values read back from MultiByteToWideChar. The reverse
+ *              table holds only the characters that round trip through
+ *              WideCharToMultiByte without the default character, so best fit
+ *              mappings and default characters are always decided by the RTL
+ *
+ *  Case      - CharUpperBuffA/CharLowerBuffA and the OEM/ANSI translations use
+ *              tables read back from the RTL for the current code pages, the
+ *              wide versions do the same for U+0000 to U+00FF and pass runs of
+ *              other characters to the RTL
+ *
+ * Tables are built on first use of each code page and are never freed, the
+ * code pages are resolved on every call so SetACP and SetOEMCP take effect.
+ *
+ * Within the fast paths runs of ASCII and case mapping are processed in blocks
+ * by one of the implementations below (See unicode_set_implementation):
+ *
+ *  Scalar    - One character at a time, kept as the reference for testing
+ *
+ *  Word      - Four bytes or two UTF-16 units per 32 bit word (ARMv6 and ARMv7
+ *              builds which use VFPv3-D16 and have no NEON)
+ *
+ *  NEON      - 16 bytes per pass (AArch64), this also validates UTF-8 in blocks
+ *              using the nibble lookup method of Keiser and Lemire and counts the
+ *              length of a conversion in blocks when only the size is requested
+ *
+ * The word and NEON UTF-16 paths need a 2 byte WCHAR, if the compiler uses a 4
+ * byte wchar_t those paths fall back to the scalar versions.
+ *
+ * Each implementation is compared with the scalar version and with a model of the
+ * RTL functions by the host test in unicode/unicodefasttest.c.
+ */
+
+/* ============================================================================== */
+/* Unicode specific constants */
+#define UNICODE_STATE_STOPPED	0
+#define UNICODE_STATE_STARTING	1
+#define UNICODE_STATE_STARTED	2
+
+#define UNICODE_FALLBACK	-1 // Returned by the conversions when the RTL must decide the result
+
+/* Unicode Table Flags */
+#define UNICODE_TABLE_FLAG_NONE	0x00000000
+#define UNICODE_TABLE_FLAG_VALID	0x00000001 // Tables were read back successfully from the RTL
+#define UNICODE_TABLE_FLAG_ASCII	0x00000002 // Bytes 0x00 to 0x7F map to the same values (Or ASCII case mapping only)
+
+#if defined(__SIZEOF_WCHAR_T__) && (__SIZEOF_WCHAR_T__ == 2)
+#define UNICODE_WCHAR_16
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define UNICODE_IMPL_DEFAULT	UNICODE_IMPL_NEON
+#else
+#define UNICODE_IMPL_DEFAULT	UNICODE_IMPL_WORD
+#endif
+
+#define UNICODE_WORD_HIGH_BITS	0x80808080U
+#define UNICODE_WORD_HIGH_BITS_W	0xFF80FF80U
+
+/* ============================================================================== */
+/* Unicode specific types */
+
+/* Block processing functions, each returns the number of leading elements processed */
+typedef struct _UNICODE_KERNELS UNICODE_KERNELS;
+struct _UNICODE_KERNELS
+{
+	size_t (*ascii_prefix)(const uint8_t *source, size_t count); // Length of the leading ASCII run
+	size_t (*ascii_widen)(const uint8_t *source, WCHAR *dest, size_t count); // Copy the leading ASCII run to UTF-16
+	size_t (*ascii_narrow)(const WCHAR *source, uint8_t *dest, size_t count); // Copy the leading ASCII run from UTF-16
+	size_t (*ascii_case)(uint8_t *buffer, size_t count, BOOL upper); // Map the case of the leading ASCII run
+	size_t (*ascii_case_w)(WCHAR *buffer, size_t count, BOOL upper); // Map the case of the leading ASCII run of UTF-16
+	size_t (*surrogate_scan)(const WCHAR *source, size_t count); // Offset of the first surrogate (Or unit above U+FFFF)
+	BOOL (*utf8_validate)(const uint8_t *source, size_t count);
+	size_t (*utf8_length_w)(const uint8_t *source, size_t count); // UTF-16 units needed for valid UTF-8
+	size_t (*utf16_length_8)(const WCHAR *source, size_t count); // UTF-8 bytes needed for valid UTF-16
+};
+
+/* Single byte code page tables */
+typedef struct _UNICODE_PAGE UNICODE_PAGE;
+struct _UNICODE_PAGE
+{
+	unsigned int codepage;
+	uint32_t flags; // Unicode table flags (eg UNICODE_TABLE_FLAG_ASCII)
+	WCHAR forward[256]; // Byte to UTF-16 values
+	uint16_t *reverse[256]; // UTF-16 to byte values indexed by the high byte then the low byte (0x100 or'ed with the byte, 0 if not present)
+	UNICODE_PAGE *next;
+};
+
+/* Case and OEM/ANSI tables for a pair of ANSI and OEM code pages */
+typedef struct _UNICODE_LOCALE UNICODE_LOCALE;
+struct _UNICODE_LOCALE
+{
+	unsigned int ansipage;
+	unsigned int oempage;
+	uint32_t caseflags; // Unicode table flags for upper and lower
+	uint32_t translateflags; // Unicode table flags for tooem and toansi
+	uint8_t upper[256];
+	uint8_t lower[256];
+	uint8_t tooem[256];
+	uint8_t toansi[256];
+	UNICODE_LOCALE *next;
+};
+
+typedef struct _UNICODE_STATE UNICODE_STATE;
+struct _UNICODE_STATE
+{
+	volatile uint32_t started; // Startup state (eg UNICODE_STATE_STARTED)
+	MUTEX_HANDLE lock; // Serializes building of tables (Lookups do not lock)
+	uint32_t implementation; // Current implementation (eg UNICODE_IMPL_NEON)
+	const UNICODE_KERNELS *kernels;
+	UNICODE_PAGE * volatile pages;
+	UNICODE_LOCALE * volatile locales;
+	uint32_t wideflags; // Unicode table flags for upperw and lowerw
+	WCHAR upperw[256]; // CharUpperBuffW values for U+0000 to U+00FF
+	WCHAR lowerw[256]; // CharLowerBuffW values for U+0000 to U+00FF
+};
+
+static UNICODE_STATE unicodefast = {UNICODE_STATE_STOPPED};
+
+/* ============================================================================== */
+/* Unicode Scalar Functions */
+/* Decode one UTF-8 sequence, returns the length or 0 if it is invalid or truncated */
+static inline size_t unicode_utf8_decode(const uint8_t *source, size_t count, uint32_t *value)
+{
+	uint32_t lead = source[0];
+
+	if (lead < 0x80)
+	{
+		*value = lead;
+		return 1;
+	}
+
+	if (lead < 0xC2)
+		return 0;
+
+	if (lead < 0xE0)
+	{
+		if (count < 2 || (source[1] & 0xC0) != 0x80)
+			return 0;
+
+		*value = ((lead & 0x1F) << 6) | (source[1] & 0x3F);
+		return 2;
+	}
+
+	if (lead < 0xF0)
+	{
+		if (count < 3 || (source[1] & 0xC0) != 0x80 || (source[2] & 0xC0) != 0x80)
+			return 0;
+
+		/* Overlong forms and surrogates */
+		if ((lead == 0xE0 && source[1] < 0xA0) || (lead == 0xED && source[1] > 0x9F))
+			return 0;
+
+		*value = ((lead & 0x0F) << 12) | ((source[1] & 0x3F) << 6) | (source[2] & 0x3F);
+		return 3;
+	}
+
+	if (lead < 0xF5)
+	{
+		if (count < 4 || (source[1] & 0xC0) != 0x80 || (source[2] & 0xC0) != 0x80 || (source[3] & 0xC0) != 0x80)
+			return 0;
+
+		/* Overlong forms and values above U+10FFFF */
+		if ((lead == 0xF0 && source[1] < 0x90) || (lead == 0xF4 && source[1] > 0x8F))
+			return 0;
+
+		*value = ((lead & 0x07) << 18) | ((source[1] & 0x3F) << 12) | ((source[2] & 0x3F) << 6) | (source[3] & 0x3F);
+		return 4;
+	}
+
+	return 0;
+}
+
+/* Surrogates and (With a 4 byte WCHAR) anything above U+FFFF need checking one at a time */
+static inline BOOL unicode_utf16_special(uint32_t value)
+{
+	return (value - 0xD800) < 0x800 || value > 0xFFFF;
+}
+
+static size_t unicode_scalar_ascii_prefix(const uint8_t *source, size_t count)
+{
+	size_t index;
+
+	for (index = 0; index < count && source[index] < 0x80; index++)
+		;
+
+	return index;
+}
+
+static size_t unicode_scalar_ascii_widen(const uint8_t *source, WCHAR *dest, size_t count)
+{
+	size_t index;
+
+	for (index = 0; index < count && source[index] < 0x80; index++)
+		dest[index] = source[index];
+
+	return index;
+}
+
+static size_t unicode_scalar_ascii_narrow(const WCHAR *source, uint8_t *dest, size_t count)
+{
+	size_t index;
+
+	for (index = 0; index < count && (uint32_t)source[index] < 0x80; index++)
+		dest[index] = (uint8_t)source[index];
+
+	return index;
+}
+
+static size_t unicode_scalar_ascii_case(uint8_t *buffer, size_t count, BOOL upper)
+{
+	uint8_t first = upper ? 'a' : 'A';
+	size_t index;
+
+	for (index = 0; index < count && buffer[index] < 0x80; index++)
+	{
+		if ((uint8_t)(buffer[index] - first) < 26)
+			buffer[index] ^= 0x20;
+	}
+
+	return index;
+}
+
+static size_t unicode_scalar_ascii_case_w(WCHAR *buffer, size_t count, BOOL upper)
+{
+	uint32_t first = upper ? 'a' : 'A';
+	size_t index;
+
+	for (index = 0; index < count && (uint32_t)buffer[index] < 0x80; index++)
+	{
+		if (((uint32_t)buffer[index] - first) < 26)
+			buffer[index] ^= 0x20;
+	}
+
+	return index;
+}
+
+static size_t unicode_scalar_surrogate_scan(const WCHAR *source, size_t count)
+{
+	size_t index;
+
+	for (index = 0; index < count && !unicode_utf16_special(source[index]); index++)
+		;
+
+	return index;
+}
+
+/* Validate one sequence at a time after skipping ASCII runs with the prefix function given */
+static BOOL unicode_utf8_validate_sequences(const uint8_t *source, size_t count, size_t (*prefix)(const uint8_t *source, size_t count))
+{
+	uint32_t value;
+	size_t index;
+	size_t size;
+
+	index = 0;
+	while (index < count)
+	{
+		index += prefix(source + index, count - index);
+
+		while (index < count && source[index] >= 0x80)
+		{
+			size = unicode_utf8_decode(source + index, count - index, &value);
+			if (size == 0)
+				return FALSE;
+
+			index += size;
+		}
+	}
+
+	return TRUE;
+}
+
+static BOOL unicode_scalar_utf8_validate(const uint8_t *source, size_t count)
+{
+	return unicode_utf8_validate_sequences(source, count, unicode_scalar_ascii_prefix);
+}
+
+static size_t unicode_scalar_utf8_length_w(const uint8_t *source, size_t count)
+{
+	size_t length = 0;
+	size_t index;
+
+	/* Every byte except continuations is one unit, four byte sequences need a surrogate pair */
+	for (index = 0; index < count; index++)
+		length += ((source[index] & 0xC0) != 0x80) + (source[index] >= 0xF0);
+
+	return length;
+}
+
+static size_t unicode_scalar_utf16_length_8(const WCHAR *source, size_t count)
+{
+	uint32_t value;
+	size_t length = 0;
+	size_t index;
+
+	/* Each half of a surrogate pair contributes 2 of the 4 bytes */
+	for (index = 0; index < count; index++)
+	{
+		value = source[index];
+		if (value < 0x80)
+			length += 1;
+		else if (value < 0x800 || (value - 0xD800) < 0x800)
+			length += 2;
+		else
+			length += 3;
+	}
+
+	return length;
+}
+
+static const UNICODE_KERNELS unicode_scalar_kernels =
+{
+	unicode_scalar_ascii_prefix,
+	unicode_scalar_ascii_widen,
+	unicode_scalar_ascii_narrow,
+	unicode_scalar_ascii_case,
+	unicode_scalar_ascii_case_w,
+	unicode_scalar_surrogate_scan,
+	unicode_scalar_utf8_validate,
+	unicode_scalar_utf8_length_w,
+	unicode_scalar_utf16_length_8
+};
+
+/* ============================================================================== */
+/* Unicode Word Functions */
+/* Words are loaded with memcpy so the source and dest need no particular alignment */
+static inline uint32_t unicode_word_load(const void *source)
+{
+	uint32_t value;
+
+	memcpy(&value, source, sizeof(value));
+	return value;
+}
+
+static inline void unicode_word_store(void *dest, uint32_t value)
+{
+	memcpy(dest, &value, sizeof(value));
+}
+
+/* Set 0x80 in each byte of an ASCII word where the byte is within first to last */
+static inline uint32_t unicode_word_range(uint32_t value, uint32_t first, uint32_t last)
+{
+	uint32_t above = value + ((0x80 - first) * 0x01010101U);
+	uint32_t beyond = value + ((0x7F - last) * 0x01010101U);
+
+	return above & ~beyond & UNICODE_WORD_HIGH_BITS;
+}
+
+static size_t unicode_word_ascii_prefix(const uint8_t *source, size_t count)
+{
+	size_t index = 0;
+
+	while (index + 8 <= count && ((unicode_word_load(source + index) | unicode_word_load(source + index + 4)) & UNICODE_WORD_HIGH_BITS) == 0)
+		index += 8;
+
+	return index + unicode_scalar_ascii_prefix(source + index, count - index);
+}
+
+static size_t unicode_word_ascii_case(uint8_t *buffer, size_t count, BOOL upper)
+{
+	uint32_t first = upper ? 'a' : 'A';
+	uint32_t value;
+	size_t index = 0;
+
+	while (index + 4 <= count)
+	{
+		value = unicode_word_load(buffer + index);
+		if (value & UNICODE_WORD_HIGH_BITS)
+			break;
+
+		/* Bytes are below 0x80 so the additions cannot carry into the next byte */
+		unicode_word_store(buffer + index, value ^ (unicode_word_range(value, first, first + 25) >> 2));
+		index += 4;
+	}
+
+	return index + unicode_scalar_ascii_case(buffer + index, count - index, upper);
+}
+
+#if defined(UNICODE_WCHAR_16)
+static size_t unicode_word_ascii_widen(const uint8_t *source, WCHAR *dest, size_t count)
+{
+	uint32_t value;
+	size_t index = 0;
+
+	while (index + 4 <= count)
+	{
+		value = unicode_word_load(source + index);
+		if (value & UNICODE_WORD_HIGH_BITS)
+			break;
+
+		unicode_word_store(dest + index, (value & 0xFF) | ((value & 0xFF00) << 8));
+		unicode_word_store(dest + index + 2, ((value >> 16) & 0xFF) | ((value >> 8) & 0xFF0000));
+		index += 4;
+	}
+
+	return index + unicode_scalar_ascii_widen(source + index, dest + index, count - index);
+}
+
+static size_t unicode_word_ascii_narrow(const WCHAR *source, uint8_t *dest, size_t count)
+{
+	uint32_t low;
+	uint32_t high;
+	size_t index = 0;
+
+	while (index + 4 <= count)
+	{
+		low = unicode_word_load(source + index);
+		high = unicode_word_load(source + index + 2);
+		if ((low | high) & UNICODE_WORD_HIGH_BITS_W)
+			break;
+
+		unicode_word_store(dest + index, (low & 0xFF) | ((low >> 8) & 0xFF00) | ((high & 0xFF) << 16) | ((high << 8) & 0xFF000000));
+		index += 4;
+	}
+
+	return index + unicode_scalar_ascii_narrow(source + index, dest + index, count - index);
+}
+
+static size_t unicode_word_ascii_case_w(WCHAR *buffer, size_t count, BOOL upper)
+{
+	uint32_t first = upper ? 'a' : 'A';
+	uint32_t value;
+	uint32_t above;
+	uint32_t beyond;
+	size_t index = 0;
+
+	while (index + 2 <= count)
+	{
+		value = unicode_word_load(buffer + index);
+		if (value & UNICODE_WORD_HIGH_BITS_W)
+			break;
+
+		/* Same as unicode_word_range with 16 bit lanes */
+		above = value + ((0x80 - first) * 0x00010001U);
+		beyond = value + ((0x7F - (first + 25)) * 0x00010001U);
+		unicode_word_store(buffer + index, value ^ ((above & ~beyond & 0x00800080U) >> 2));
+		index += 2;
+	}
+
+	return index + unicode_scalar_ascii_case_w(buffer + index, count - index, upper);
+}
+
+static size_t unicode_word_surrogate_scan(const WCHAR *source, size_t count)
+{
+	uint32_t value;
+	size_t index = 0;
+
+	/* Surrogate lanes become zero, any zero lane sets its top bit */
+	while (index + 2 <= count)
+	{
+		value = (unicode_word_load(source + index) & 0xF800F800U) ^ 0xD800D800U;
+		if ((value - 0x00010001U) & ~value & 0x80008000U)
+			break;
+
+		index += 2;
+	}
+
+	return index + unicode_scalar_surrogate_scan(source + index, count - index);
+}
+#else
+#define unicode_word_ascii_widen	unicode_scalar_ascii_widen
+#define unicode_word_ascii_narrow	unicode_scalar_ascii_narrow
+#define unicode_word_ascii_case_w	unicode_scalar_ascii_case_w
+#define unicode_word_surrogate_scan	unicode_scalar_surrogate_scan
+#endif
+
+static BOOL unicode_word_utf8_validate(const uint8_t *source, size_t count)
+{
+	return unicode_utf8_validate_sequences(source, count, unicode_word_ascii_prefix);
+}
+
+static size_t unicode_word_utf8_length_w(const uint8_t *source, size_t count)
+{
+	size_t index;
+
+	/* ASCII runs are one unit per byte */
+	index = unicode_word_ascii_prefix(source, count);
+
+	return index + unicode_scalar_utf8_length_w(source + index, count - index);
+}
+
+static const UNICODE_KERNELS unicode_word_kernels =
+{
+	unicode_word_ascii_prefix,
+	unicode_word_ascii_widen,
+	unicode_word_ascii_narrow,
+	unicode_word_ascii_case,
+	unicode_word_ascii_case_w,
+	unicode_word_surrogate_scan,
+	unicode_word_utf8_validate,
+	unicode_word_utf8_length_w,
+	unicode_scalar_utf16_length_8
+};
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+/* ============================================================================== */
+/* Unicode NEON Functions */
+static size_t unicode_neon_ascii_prefix(const uint8_t *source, size_t count)
+{
+	size_t index = 0;
+
+	while (index + 16 <= count && vmaxvq_u8(vld1q_u8(source + index)) < 0x80)
+		index += 16;
+
+	return index + unicode_scalar_ascii_prefix(source + index, count - index);
+}
+
+static size_t unicode_neon_ascii_case(uint8_t *buffer, size_t count, BOOL upper)
+{
+	uint8x16_t first = vdupq_n_u8(upper ? 'a' : 'A');
+	uint8x16_t letters = vdupq_n_u8(26);
+	uint8x16_t bit = vdupq_n_u8(0x20);
+	uint8x16_t value;
+	uint8x16_t mask;
+	size_t index = 0;
+
+	while (index + 16 <= count)
+	{
+		value = vld1q_u8(buffer + index);
+		if (vmaxvq_u8(value) >= 0x80)
+			break;
+
+		mask = vcltq_u8(vsubq_u8(value, first), letters);
+		vst1q_u8(buffer + index, veorq_u8(value, vandq_u8(mask, bit)));
+		index += 16;
+	}
+
+	return index + unicode_scalar_ascii_case(buffer + index, count - index, upper);
+}
+
+/* Nibble lookup UTF-8 validation (Keiser and Lemire, Validating UTF-8 In Less Than One Instruction Per Byte) */
+#define UNICODE_UTF8_TOO_SHORT	(1 << 0) // Lead byte or ASCII followed by a lead byte or ASCII where a continuation is needed
+#define UNICODE_UTF8_TOO_LONG	(1 << 1) // ASCII followed by a continuation
+#define UNICODE_UTF8_OVERLONG_3	(1 << 2) // 11100000 100_____
+#define UNICODE_UTF8_TOO_LARGE	(1 << 3) // 11110100 1001____ and above
+#define UNICODE_UTF8_SURROGATE	(1 << 4) // 11101101 101_____
+#define UNICODE_UTF8_OVERLONG_2	(1 << 5) // 1100000_ 10______
+#define UNICODE_UTF8_TOO_LARGE_1000	(1 << 6) // 11110101 1000____ and above
+#define UNICODE_UTF8_OVERLONG_4	(1 << 6) // 11110000 1000____
+#define UNICODE_UTF8_TWO_CONTS	(1 << 7) // Continuation followed by a continuation
+#define UNICODE_UTF8_CARRY	(UNICODE_UTF8_TOO_SHORT | UNICODE_UTF8_TOO_LONG | UNICODE_UTF8_TWO_CONTS)
+
+static const uint8_t unicode_utf8_byte_1_high[16] =
+{
+	/* 0_______ ASCII */
+	UNICODE_UTF8_TOO_LONG, UNICODE_UTF8_TOO_LONG, UNICODE_UTF8_TOO_LONG, UNICODE_UTF8_TOO_LONG,
+	UNICODE_UTF8_TOO_LONG, UNICODE_UTF8_TOO_LONG, UNICODE_UTF8_TOO_LONG, UNICODE_UTF8_TOO_LONG,
+	/* 10______ Continuation */
+	UNICODE_UTF8_TWO_CONTS, UNICODE_UTF8_TWO_CONTS, UNICODE_UTF8_TWO_CONTS, UNICODE_UTF8_TWO_CONTS,
+	/* 1100____ and 1101____ Two byte lead */
+	UNICODE_UTF8_TOO_SHORT | UNICODE_UTF8_OVERLONG_2,
+	UNICODE_UTF8_TOO_SHORT,
+	/* 1110____ Three byte lead */
+	UNICODE_UTF8_TOO_SHORT | UNICODE_UTF8_OVERLONG_3 | UNICODE_UTF8_SURROGATE,
+	/* 1111____ Four byte lead */
+	UNICODE_UTF8_TOO_SHORT | UNICODE_UTF8_TOO_LARGE | UNICODE_UTF8_TOO_LARGE_1000 | UNICODE_UTF8_OVERLONG_4
+};
+
+static const uint8_t unicode_utf8_byte_1_low[16] =
+{
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_OVERLONG_3 | UNICODE_UTF8_OVERLONG_2 | UNICODE_UTF8_OVERLONG_4,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_OVERLONG_2,
+	UNICODE_UTF8_CARRY,
+	UNICODE_UTF8_CARRY,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_TOO_LARGE,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_TOO_LARGE | UNICODE_UTF8_TOO_LARGE_1000,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_TOO_LARGE | UNICODE_UTF8_TOO_LARGE_1000,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_TOO_LARGE | UNICODE_UTF8_TOO_LARGE_1000,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_TOO_LARGE | UNICODE_UTF8_TOO_LARGE_1000,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_TOO_LARGE | UNICODE_UTF8_TOO_LARGE_1000,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_TOO_LARGE | UNICODE_UTF8_TOO_LARGE_1000,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_TOO_LARGE | UNICODE_UTF8_TOO_LARGE_1000,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_TOO_LARGE | UNICODE_UTF8_TOO_LARGE_1000,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_TOO_LARGE | UNICODE_UTF8_TOO_LARGE_1000 | UNICODE_UTF8_SURROGATE,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_TOO_LARGE | UNICODE_UTF8_TOO_LARGE_1000,
+	UNICODE_UTF8_CARRY | UNICODE_UTF8_TOO_LARGE | UNICODE_UTF8_TOO_LARGE_1000
+};
+
+static const uint8_t unicode_utf8_byte_2_high[16] =
+{
+	/* 0_______ ASCII */
+	UNICODE_UTF8_TOO_SHORT, UNICODE_UTF8_TOO_SHORT, UNICODE_UTF8_TOO_SHORT, UNICODE_UTF8_TOO_SHORT,
+	UNICODE_UTF8_TOO_SHORT, UNICODE_UTF8_TOO_SHORT, UNICODE_UTF8_TOO_SHORT, UNICODE_UTF8_TOO_SHORT,
+	/* 1000____ */
+	UNICODE_UTF8_TOO_LONG | UNICODE_UTF8_OVERLONG_2 | UNICODE_UTF8_TWO_CONTS | UNICODE_UTF8_OVERLONG_3 | UNICODE_UTF8_TOO_LARGE_1000 | UNICODE_UTF8_OVERLONG_4,
+	/* 1001____ */
+	UNICODE_UTF8_TOO_LONG | UNICODE_UTF8_OVERLONG_2 | UNICODE_UTF8_TWO_CONTS | UNICODE_UTF8_OVERLONG_3 | UNICODE_UTF8_TOO_LARGE,
+	/* 101_____ */
+	UNICODE_UTF8_TOO_LONG | UNICODE_UTF8_OVERLONG_2 | UNICODE_UTF8_TWO_CONTS | UNICODE_UTF8_SURROGATE | UNICODE_UTF8_TOO_LARGE,
+	UNICODE_UTF8_TOO_LONG | UNICODE_UTF8_OVERLONG_2 | UNICODE_UTF8_TWO_CONTS | UNICODE_UTF8_SURROGATE | UNICODE_UTF8_TOO_LARGE,
+	/* 11______ Lead byte */
+	UNICODE_UTF8_TOO_SHORT, UNICODE_UTF8_TOO_SHORT, UNICODE_UTF8_TOO_SHORT, UNICODE_UTF8_TOO_SHORT
+};
+
+static inline uint8x16_t unicode_neon_utf8_block(uint8x16_t input, uint8x16_t previous, uint8x16_t byte1high, uint8x16_t byte1low, uint8x16_t byte2high)
+{
+	uint8x16_t previous1 = vextq_u8(previous, input, 15);
+	uint8x16_t previous2 = vextq_u8(previous, input, 14);
+	uint8x16_t previous3 = vextq_u8(previous, input, 13);
+	uint8x16_t special;
+	uint8x16_t continuation;
+
+	special = vandq_u8(vandq_u8(vqtbl1q_u8(byte1high, vshrq_n_u8(previous1, 4)), vqtbl1q_u8(byte1low, vandq_u8(previous1, vdupq_n_u8(0x0F)))), vqtbl1q_u8(byte2high, vshrq_n_u8(input, 4)));
+
+	/* Only bytes two or three after a three or four byte lead must be continuations without a lead immediately before them */
+	continuation = vorrq_u8(vqsubq_u8(previous2, vdupq_n_u8(0xE0 - 0x80)), vqsubq_u8(previous3, vdupq_n_u8(0xF0 - 0x80)));
+
+	return veorq_u8(vandq_u8(continuation, vdupq_n_u8(0x80)), special);
+}
+
+static BOOL unicode_neon_utf8_validate(const uint8_t *source, size_t count)
+{
+	uint8x16_t byte1high = vld1q_u8(unicode_utf8_byte_1_high);
+	uint8x16_t byte1low = vld1q_u8(unicode_utf8_byte_1_low);
+	uint8x16_t byte2high = vld1q_u8(unicode_utf8_byte_2_high);
+	uint8x16_t previous = vdupq_n_u8(0);
+	uint8x16_t error = vdupq_n_u8(0);
+	uint8x16_t input;
+	uint8_t tail[16];
+	size_t index = 0;
+
+	while (index + 16 <= count)
+	{
+		input = vld1q_u8(source + index);
+		error = vorrq_u8(error, unicode_neon_utf8_block(input, previous, byte1high, byte1low, byte2high));
+		previous = input;
+		index += 16;
+	}
+
+	/* The tail is padded with zeros, an extra block of zeros catches a sequence truncated by the end */
+	memset(tail, 0, sizeof(tail));
+	memcpy(tail, source + index, count - index);
+	input = vld1q_u8(tail);
+	error = vorrq_u8(error, unicode_neon_utf8_block(input, previous, byte1high, byte1low, byte2high));
+	error = vorrq_u8(error, unicode_neon_utf8_block(vdupq_n_u8(0), input, byte1high, byte1low, byte2high));
+
+	return vmaxvq_u8(error) == 0;
+}
+
+static size_t unicode_neon_utf8_length_w(const uint8_t *source, size_t count)
+{
+	uint8x16_t continuation = vdupq_n_u8(0xC0);
+	uint8x16_t marker = vdupq_n_u8(0x80);
+	uint8x16_t four = vdupq_n_u8(0xF0);
+	uint8x16_t one = vdupq_n_u8(1);
+	uint8x16_t input;
+	uint8x16_t units;
+	size_t length = 0;
+	size_t index = 0;
+
+	while (index + 16 <= count)
+	{
+		input = vld1q_u8(source + index);
+
+		/* Each lane is 0, 1 or 2 so the sum of 16 lanes fits in a byte */
+		units = vandq_u8(vmvnq_u8(vceqq_u8(vandq_u8(input, continuation), marker)), one);
+		units = vaddq_u8(units, vandq_u8(vcgeq_u8(input, four), one));
+		length += vaddvq_u8(units);
+		index += 16;
+	}
+
+	return length + unicode_scalar_utf8_length_w(source + index, count - index);
+}
+
+#if defined(UNICODE_WCHAR_16)
+static size_t unicode_neon_ascii_widen(const uint8_t *source, WCHAR *dest, size_t count)
+{
+	uint8x16_t value;
+	size_t index = 0;
+
+	while (index + 16 <= count)
+	{
+		value = vld1q_u8(source + index);
+		if (vmaxvq_u8(value) >= 0x80)
+			break;
+
+		vst1q_u16((uint16_t *)(dest + index), vmovl_u8(vget_low_u8(value)));
+		vst1q_u16((uint16_t *)(dest + index + 8), vmovl_u8(vget_high_u8(value)));
+		index += 16;
+	}
+
+	return index + unicode_scalar_ascii_widen(source + index, dest + index, count - index);
+}
+
+static size_t unicode_neon_ascii_narrow(const WCHAR *source, uint8_t *dest, size_t count)
+{
+	uint16x8_t low;
+	uint16x8_t high;
+	size_t index = 0;
+
+	while (index + 16 <= count)
+	{
+		low = vld1q_u16((const uint16_t *)(source + index));
+		high = vld1q_u16((const uint16_t *)(source + index + 8));
+		if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80)
+			break;
+
+		vst1q_u8(dest + index, vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+		index += 16;
+	}
+
+	return index + unicode_scalar_ascii_narrow(source + index, dest + index, count - index);
+}
+
+static size_t unicode_neon_ascii_case_w(WCHAR *buffer, size_t count, BOOL upper)
+{
+	uint16x8_t first = vdupq_n_u16(upper ? 'a' : 'A');
+	uint16x8_t letters = vdupq_n_u16(26);
+	uint16x8_t bit = vdupq_n_u16(0x20);
+	uint16x8_t value;
+	uint16x8_t mask;
+	size_t index = 0;
+
+	while (index + 8 <= count)
+	{
+		value = vld1q_u16((const uint16_t *)(buffer + index));
+		if (vmaxvq_u16(value) >= 0x80)
+			break;
+
+		mask = vcltq_u16(vsubq_u16(value, first), letters);
+		vst1q_u16((uint16_t *)(buffer + index), veorq_u16(value, vandq_u16(mask, bit)));
+		index += 8;
+	}
+
+	return index + unicode_scalar_ascii_case_w(buffer + index, count - index, upper);
+}
+
+static size_t unicode_neon_surrogate_scan(const WCHAR *source, size_t count)
+{
+	uint16x8_t mask = vdupq_n_u16(0xF800);
+	uint16x8_t surrogate = vdupq_n_u16(0xD800);
+	size_t index = 0;
+
+	while (index + 8 <= count && vmaxvq_u16(vceqq_u16(vandq_u16(vld1q_u16((const uint16_t *)(source + index)), mask), surrogate)) == 0)
+		index += 8;
+
+	return index + unicode_scalar_surrogate_scan(source + index, count - index);
+}
+
+static size_t unicode_neon_utf16_length_8(const WCHAR *source, size_t count)
+{
+	uint16x8_t two = vdupq_n_u16(0x80);
+	uint16x8_t three = vdupq_n_u16(0x800);
+	uint16x8_t mask = vdupq_n_u16(0xF800);
+	uint16x8_t surrogate = vdupq_n_u16(0xD800);
+	uint16x8_t one = vdupq_n_u16(1);
+	uint16x8_t value;
+	uint16x8_t bytes;
+	size_t length = 0;
+	size_t index = 0;
+
+	/* 1 byte plus 1 from U+0080 plus 1 from U+0800, less 1 for each half of a surrogate pair */
+	while (index + 8 <= count)
+	{
+		value = vld1q_u16((const uint16_t *)(source + index));
+		bytes = vaddq_u16(one, vandq_u16(vcgeq_u16(value, two), one));
+		bytes = vaddq_u16(bytes, vandq_u16(vcgeq_u16(value, three), one));
+		bytes = vsubq_u16(bytes, vandq_u16(vceqq_u16(vandq_u16(value, mask), surrogate), one));
+		length += vaddvq_u16(bytes);
+		index += 8;
+	}
+
+	return length + unicode_scalar_utf16_length_8(source + index, count - index);
+}
+#else
+#define unicode_neon_ascii_widen	unicode_scalar_ascii_widen
+#define unicode_neon_ascii_narrow	unicode_scalar_ascii_narrow
+#define unicode_neon_ascii_case_w	unicode_scalar_ascii_case_w
+#define unicode_neon_surrogate_scan	unicode_scalar_surrogate_scan
+#define unicode_neon_utf16_length_8	unicode_scalar_utf16_length_8
+#endif
+
+static const UNICODE_KERNELS unicode_neon_kernels =
+{
+	unicode_neon_ascii_prefix,
+	unicode_neon_ascii_widen,
+	unicode_neon_ascii_narrow,
+	unicode_neon_ascii_case,
+	unicode_neon_ascii_case_w,
+	unicode_neon_surrogate_scan,
+	unicode_neon_utf8_validate,
+	unicode_neon_utf8_length_w,
+	unicode_neon_utf16_length_8
+};
+#endif
+
+/* ============================================================================== */
+/* Unicode Internal Functions */
+static void unicode_start(void)
+{
+	WCHAR buffer[255];
+	uint32_t value;
+
+	if (unicodefast.started == UNICODE_STATE_STARTED)
+		return;
+
+	if (!__sync_bool_compare_and_swap(&unicodefast.started, UNICODE_STATE_STOPPED, UNICODE_STATE_STARTING))
+	{
+		while (unicodefast.started != UNICODE_STATE_STARTED)
+			thread_yield();
+		return;
+	}
+
+	unicodefast.lock = mutex_create();
+	unicodefast.implementation = UNICODE_IMPL_DEFAULT;
+	unicodefast.kernels = &unicode_word_kernels;
+#if defined(__aarch64__) && defined(__ARM_NEON)
+	unicodefast.kernels = &unicode_neon_kernels;
+#endif
+
+	/* Read back the wide case mapping of U+0001 to U+00FF (NUL is left out in case the RTL stops at it) */
+	unicodefast.wideflags = UNICODE_TABLE_FLAG_VALID | UNICODE_TABLE_FLAG_ASCII;
+	unicodefast.upperw[0] = 0;
+	unicodefast.lowerw[0] = 0;
+
+	for (value = 1; value < 256; value++)
+		buffer[value - 1] = (WCHAR)value;
+	if (CharUpperBuffW(buffer, 255) != 255)
+		unicodefast.wideflags = UNICODE_TABLE_FLAG_NONE;
+	memcpy(unicodefast.upperw + 1, buffer, sizeof(buffer));
+
+	for (value = 1; value < 256; value++)
+		buffer[value - 1] = (WCHAR)value;
+	if (CharLowerBuffW(buffer, 255) != 255)
+		unicodefast.wideflags = UNICODE_TABLE_FLAG_NONE;
+	memcpy(unicodefast.lowerw + 1, buffer, sizeof(buffer));
+
+	/* The block functions only handle the ASCII letters */
+	for (value = 0; value < 0x80; value++)
+	{
+		if (unicodefast.upperw[value] != ((value >= 'a' && value <= 'z') ? value - 0x20 : value) || unicodefast.lowerw[value] != ((value >= 'A' && value <= 'Z') ? value + 0x20 : value))
+			unicodefast.wideflags &= ~UNICODE_TABLE_FLAG_ASCII;
+	}
+
+	__sync_synchronize();
+	unicodefast.started = UNICODE_STATE_STARTED;
+}
+
+/* Resolve the code page identifiers that depend on the current settings, CP_THREAD_ACP and CP_MACCP are left to the RTL */
+static unsigned int unicode_resolve_page(unsigned int codepage)
+{
+	switch (codepage)
+	{
+		case CP_ACP:
+			return GetACP();
+		case CP_OEMCP:
+			return GetOEMCP();
+	}
+
+	return codepage;
+}
+
+static BOOL unicode_page_add_reverse(UNICODE_PAGE *page, uint32_t value, uint8_t byte)
+{
+	uint16_t *table;
+
+	table = page->reverse[value >> 8];
+	if (!table)
+	{
+		table = calloc(256, sizeof(uint16_t));
+		if (!table)
+			return FALSE;
+
+		page->reverse[value >> 8] = table;
+	}
+
+	table[value & 0xFF] = 0x100 | byte;
+
+	return TRUE;
+}
+
+/* Build the tables for a single byte code page, caller must hold the lock */
+static UNICODE_PAGE *unicode_page_create(unsigned int codepage)
+{
+	UNICODE_PAGE *page;
+	CPINFO info;
+	char bytes[256];
+	char byte;
+	BOOL used;
+	WCHAR value;
+	uint32_t count;
+
+	page = calloc(1, sizeof(UNICODE_PAGE));
+	if (!page)
+		return NULL;
+
+	page->codepage = codepage;
+	page->flags = UNICODE_TABLE_FLAG_NONE;
+
+	if (codepage != CP_UTF8 && codepage != CP_UTF7 && GetCPInfo(codepage, &info) && info.maxcharsize == 1)
+	{
+		for (count = 0; count < 256; count++)
+			bytes[count] = (char)count;
+
+		if (MultiByteToWideChar(codepage, 0, bytes, 256, page->forward, 256) == 256)
+		{
+			page->flags = UNICODE_TABLE_FLAG_VALID | UNICODE_TABLE_FLAG_ASCII;
+
+			/* Only characters that come back as the same byte without the default character go in the reverse table */
+			for (count = 0; count < 256; count++)
+			{
+				value = page->forward[count];
+				used = FALSE;
+				if ((uint32_t)value <= 0xFFFF && WideCharToMultiByte(codepage, 0, &value, 1, &byte, 1, NULL, &used) == 1 && !used && (uint8_t)byte == count)
+				{
+					if (!unicode_page_add_reverse(page, value, count))
+						page->flags = UNICODE_TABLE_FLAG_NONE;
+				}
+				else if (count < 0x80)
+				{
+					page->flags &= ~UNICODE_TABLE_FLAG_ASCII;
+				}
+
+				if (count < 0x80 && (uint32_t)value != count)
+					page->flags &= ~UNICODE_TABLE_FLAG_ASCII;
+			}
+		}
+	}
+
+	/* Pages that are not single byte are kept with no flags so they are only checked once */
+	page->next = unicodefast.pages;
+	__sync_synchronize();
+	unicodefast.pages = page;
+
+	return page;
+}
+
+static UNICODE_PAGE *unicode_page_get(unsigned int codepage)
+{
+	UNICODE_PAGE *page;
+
+	for (page = unicodefast.pages; page; page = page->next)
+	{
+		if (page->codepage == codepage)
+			return page;
+	}
+
+	if (mutex_lock(unicodefast.lock) != ERROR_SUCCESS)
+		return NULL;
+
+	/* Check again in case another thread created it */
+	for (page = unicodefast.pages; page; page = page->next)
+	{
+		if (page->codepage == codepage)
+			break;
+	}
+
+	if (!page)
+		page = unicode_page_create(codepage);
+
+	mutex_unlock(unicodefast.lock);
+
+	return page;
+}
+
+/* Read back a byte mapping for bytes 1 to 255 from an RTL function which converts in place or to a buffer */
+static BOOL unicode_locale_read(uint8_t *table, uint32_t kind)
+{
+	char source[255];
+	char dest[255];
+	uint32_t count;
+	BOOL result;
+
+	for (count = 1; count < 256; count++)
+		source[count - 1] = dest[count - 1] = (char)count;
+
+	switch (kind)
+	{
+		case 0:
+			result = CharUpperBuffA(dest, 255) == 255;
+			break;
+		case 1:
+			result = CharLowerBuffA(dest, 255) == 255;
+			break;
+		case 2:
+			result = AnsiToOemBuff(source, dest, 255);
+			break;
+		default:
+			result = OemToAnsiBuff(source, dest, 255);
+	}
+
+	table[0] = 0;
+	memcpy(table + 1, dest, sizeof(dest));
+
+	return result;
+}
+
+/* Build the case and translation tables for a pair of code pages, caller must hold the lock */
+static UNICODE_LOCALE *unicode_locale_create(unsigned int ansipage, unsigned int oempage)
+{
+	UNICODE_LOCALE *locale;
+	uint32_t value;
+
+	locale = calloc(1, sizeof(UNICODE_LOCALE));
+	if (!locale)
+		return NULL;
+
+	locale->ansipage = ansipage;
+	locale->oempage = oempage;
+
+	locale->caseflags = UNICODE_TABLE_FLAG_NONE;
+	if (unicode_locale_read(locale->upper, 0) && unicode_locale_read(locale->lower, 1))
+	{
+		locale->caseflags = UNICODE_TABLE_FLAG_VALID | UNICODE_TABLE_FLAG_ASCII;
+		for (value = 0; value < 0x80; value++)
+		{
+			if (locale->upper[value] != ((value >= 'a' && value <= 'z') ? value - 0x20 : value) || locale->lower[value] != ((value >= 'A' && value <= 'Z') ? value + 0x20 : value))
+				locale->caseflags &= ~UNICODE_TABLE_FLAG_ASCII;
+		}
+	}
+
+	locale->translateflags = UNICODE_TABLE_FLAG_NONE;
+	if (unicode_locale_read(locale->tooem, 2) && unicode_locale_read(locale->toansi, 3))
+	{
+		locale->translateflags = UNICODE_TABLE_FLAG_VALID | UNICODE_TABLE_FLAG_ASCII;
+		for (value = 0; value < 0x80; value++)
+		{
+			if (locale->tooem[value] != value || locale->toansi[value] != value)
+				locale->translateflags &= ~UNICODE_TABLE_FLAG_ASCII;
+		}
+	}
+
+	locale->next = unicodefast.locales;
+	__sync_synchronize();
+	unicodefast.locales = locale;
+
+	return locale;
+}
+
+static UNICODE_LOCALE *unicode_locale_get(void)
+{
+	UNICODE_LOCALE *locale;
+	unsigned int ansipage = GetACP();
+	unsigned int oempage = GetOEMCP();
+
+	for (locale = unicodefast.locales; locale; locale = locale->next)
+	{
+		if (locale->ansipage == ansipage && locale->oempage == oempage)
+			return locale;
+	}
+
+	if (mutex_lock(unicodefast.lock) != ERROR_SUCCESS)
+		return NULL;
+
+	for (locale = unicodefast.locales; locale; locale = locale->next)
+	{
+		if (locale->ansipage == ansipage && locale->oempage == oempage)
+			break;
+	}
+
+	if (!locale)
+		locale = unicode_locale_create(ansipage, oempage);
+
+	mutex_unlock(unicodefast.lock);
+
+	return locale;
+}
+
+/* Check that every surrogate is part of a pair */
+static BOOL unicode_utf16_check(const UNICODE_KERNELS *kernels, const WCHAR *source, size_t count)
+{
+	size_t index = 0;
+
+	while (index < count)
+	{
+		index += kernels->surrogate_scan(source + index, count - index);
+		if (index >= count)
+			break;
+
+		if ((uint32_t)source[index] >= 0xDC00 || index + 1 >= count || ((uint32_t)source[index + 1] - 0xDC00) >= 0x400)
+			return FALSE;
+
+		index += 2;
+	}
+
+	return TRUE;
+}
+
+static size_t unicode_string_length_w(const WCHAR *source)
+{
+	size_t length = 0;
+
+	while (source[length])
+		length++;
+
+	return length;
+}
+
+/* Convert valid UTF-8, returns the units written (Or needed if dest is NULL) or UNICODE_FALLBACK */
+static int unicode_utf8_to_utf16(const UNICODE_KERNELS *kernels, const uint8_t *source, size_t count, WCHAR *dest, size_t len)
+{
+	uint32_t value;
+	size_t index;
+	size_t output;
+	size_t size;
+	size_t avail;
+
+	if (!dest)
+	{
+		if (!kernels->utf8_validate(source, count))
+			return UNICODE_FALLBACK;
+
+		size = kernels->utf8_length_w(source, count);
+		return (size > INT_MAX) ? UNICODE_FALLBACK : (int)size;
+	}
+
+	index = 0;
+	output = 0;
+	while (index < count)
+	{
+		avail = count - index;
+		if (avail > len - output)
+			avail = len - output;
+
+		size = kernels->ascii_widen(source + index, dest + output, avail);
+		index += size;
+		output += size;
+		if (index >= count)
+			break;
+
+		/* Stopped on ASCII means the output is full */
+		if (source[index] < 0x80)
+			return UNICODE_FALLBACK;
+
+		while (index < count && source[index] >= 0x80)
+		{
+			size = unicode_utf8_decode(source + index, count - index, &value);
+			if (size == 0)
+				return UNICODE_FALLBACK;
+
+			if (value >= 0x10000)
+			{
+				if (len - output < 2)
+					return UNICODE_FALLBACK;
+
+				value -= 0x10000;
+				dest[output++] = (WCHAR)(0xD800 + (value >> 10));
+				dest[output++] = (WCHAR)(0xDC00 + (value & 0x3FF));
+			}
+			else
+			{
+				if (output >= len)
+					return UNICODE_FALLBACK;
+
+				dest[output++] = (WCHAR)value;
+			}
+
+			index += size;
+		}
+	}
+
+	return (int)output;
+}
+
+/* Convert valid UTF-16, returns the bytes written (Or needed if dest is NULL) or UNICODE_FALLBACK */
+static int unicode_utf16_to_utf8(const UNICODE_KERNELS *kernels, const WCHAR *source, size_t count, uint8_t *dest, size_t len)
+{
+	uint32_t value;
+	size_t index;
+	size_t output;
+	size_t size;
+	size_t avail;
+
+	if (!dest)
+	{
+		if (!unicode_utf16_check(kernels, source, count))
+			return UNICODE_FALLBACK;
+
+		size = kernels->utf16_length_8(source, count);
+		return (size > INT_MAX) ? UNICODE_FALLBACK : (int)size;
+	}
+
+	index = 0;
+	output = 0;
+	while (index < count)
+	{
+		avail = count - index;
+		if (avail > len - output)
+			avail = len - output;
+
+		size = kernels->ascii_narrow(source + index, dest + output, avail);
+		index += size;
+		output += size;
+		if (index >= count)
+			break;
+
+		if ((uint32_t)source[index] < 0x80)
+			return UNICODE_FALLBACK;
+
+		while (index < count && (uint32_t)source[index] >= 0x80)
+		{
+			value = source[index];
+			if (value < 0x800)
+			{
+				if (len - output < 2)
+					return UNICODE_FALLBACK;
+
+				dest[output++] = 0xC0 | (value >> 6);
+				dest[output++] = 0x80 | (value & 0x3F);
+				index++;
+			}
+			else if ((value - 0xD800) < 0x800)
+			{
+				/* Only a high surrogate followed by a low surrogate */
+				if (value >= 0xDC00 || index + 1 >= count || ((uint32_t)source[index + 1] - 0xDC00) >= 0x400 || len - output < 4)
+					return UNICODE_FALLBACK;
+
+				value = 0x10000 + ((value - 0xD800) << 10) + ((uint32_t)source[index + 1] - 0xDC00);
+				dest[output++] = 0xF0 | (value >> 18);
+				dest[output++] = 0x80 | ((value >> 12) & 0x3F);
+				dest[output++] = 0x80 | ((value >> 6) & 0x3F);
+				dest[output++] = 0x80 | (value & 0x3F);
+				index += 2;
+			}
+			else
+			{
+				if (value > 0xFFFF || len - output < 3)
+					return UNICODE_FALLBACK;
+
+				dest[output++] = 0xE0 | (value >> 12);
+				dest[output++] = 0x80 | ((value >> 6) & 0x3F);
+				dest[output++] = 0x80 | (value & 0x3F);
+				index++;
+			}
+		}
+	}
+
+	return (int)output;
+}
+
+static int unicode_sbcs_to_utf16(const UNICODE_KERNELS *kernels, const UNICODE_PAGE *page, const uint8_t *source, size_t count, WCHAR *dest, size_t len)
+{
+	size_t index;
+
+	/* Every byte is one character */
+	if (!dest)
+		return (int)count;
+
+	if (len < count)
+		return UNICODE_FALLBACK;
+
+	index = 0;
+	while (index < count)
+	{
+		if (page->flags & UNICODE_TABLE_FLAG_ASCII)
+			index += kernels->ascii_widen(source + index, dest + index, count - index);
+
+		while (index < count && (source[index] >= 0x80 || !(page->flags & UNICODE_TABLE_FLAG_ASCII)))
+		{
+			dest[index] = page->forward[source[index]];
+			index++;
+		}
+	}
+
+	return (int)count;
+}
+
+static int unicode_utf16_to_sbcs(const UNICODE_KERNELS *kernels, const UNICODE_PAGE *page, const WCHAR *source, size_t count, uint8_t *dest, size_t len)
+{
+	const uint16_t *table;
+	uint32_t value;
+	uint16_t entry;
+	size_t index;
+
+	if (dest && len < count)
+		return UNICODE_FALLBACK;
+
+	index = 0;
+	while (index < count)
+	{
+		if (dest && (page->flags & UNICODE_TABLE_FLAG_ASCII))
+			index += kernels->ascii_narrow(source + index, dest + index, count - index);
+
+		while (index < count && ((uint32_t)source[index] >= 0x80 || !dest || !(page->flags & UNICODE_TABLE_FLAG_ASCII)))
+		{
+			/* Anything not in the reverse table may need the default character or a best fit mapping */
+			value = source[index];
+			table = (value <= 0xFFFF) ? page->reverse[value >> 8] : NULL;
+			entry = table ? table[value & 0xFF] : 0;
+			if (entry == 0)
+				return UNICODE_FALLBACK;
+
+			if (dest)
+				dest[index] = (uint8_t)entry;
+			index++;
+		}
+	}
+
+	return (int)count;
+}
+
+/* Map case with a byte table, taking ASCII runs in blocks where the table allows */
+static void unicode_case_buff(const UNICODE_KERNELS *kernels, uint8_t *buffer, size_t count, const uint8_t *table, BOOL ascii, BOOL upper)
+{
+	size_t index = 0;
+
+	while (index < count)
+	{
+		if (ascii)
+			index += kernels->ascii_case(buffer + index, count - index, upper);
+
+		while (index < count && (buffer[index] >= 0x80 || !ascii))
+		{
+			buffer[index] = table[buffer[index]];
+			index++;
+		}
+	}
+}
+
+static void unicode_case_buff_w(const UNICODE_KERNELS *kernels, WCHAR *buffer, size_t count, BOOL upper)
+{
+	const WCHAR *table = upper ? unicodefast.upperw : unicodefast.lowerw;
+	BOOL ascii = (unicodefast.wideflags & UNICODE_TABLE_FLAG_ASCII) != 0;
+	size_t index = 0;
+	size_t start;
+
+	while (index < count)
+	{
+		if (ascii)
+			index += kernels->ascii_case_w(buffer + index, count - index, upper);
+
+		while (index < count && ((uint32_t)buffer[index] >= 0x80 || !ascii))
+		{
+			if ((uint32_t)buffer[index] < 0x100)
+			{
+				buffer[index] = table[buffer[index]];
+				index++;
+				continue;
+			}
+
+			/* Runs beyond U+00FF go to the RTL */
+			start = index;
+			while (index < count && (uint32_t)buffer[index] >= 0x100)
+				index++;
+
+			if (upper)
+				CharUpperBuffW(buffer + start, index - start);
+			else
+				CharLowerBuffW(buffer + start, index - start);
+		}
+	}
+}
+
+static BOOL unicode_translate_buff(const UNICODE_KERNELS *kernels, const uint8_t *source, uint8_t *dest, size_t count, const uint8_t *table, BOOL ascii)
+{
+	size_t index = 0;
+	size_t size;
+
+	while (index < count)
+	{
+		if (ascii)
+		{
+			size = kernels->ascii_prefix(source + index, count - index);
+			if (source != dest)
+				memmove(dest + index, source + index, size);
+			index += size;
+		}
+
+		while (index < count && (source[index] >= 0x80 || !ascii))
+		{
+			dest[index] = table[source[index]];
+			index++;
+		}
+	}
+
+	return TRUE;
+}
+
+/* ============================================================================== */
+/* Unicode Fast Path Functions */
+int STDCALL unicode_multi_byte_to_wide_char(unsigned int codepage, uint32_t dwflags, const char *lpmultibytestr, int cbmultibyte, WCHAR *lpwidecharstr, int cchwidechar)
+{
+	const UNICODE_PAGE *page;
+	unsigned int resolved;
+	size_t count;
+	int result;
+
+	unicode_start();
+
+	/* Parameter errors are reported by the RTL */
+	if (!lpmultibytestr || cbmultibyte == 0 || cbmultibyte < -1 || cchwidechar < 0 || (cchwidechar > 0 && !lpwidecharstr))
+		goto fallback;
+
+	count = (cbmultibyte == -1) ? strlen(lpmultibytestr) + 1 : (size_t)cbmultibyte;
+	if (count > INT_MAX)
+		goto fallback;
+
+	resolved = unicode_resolve_page(codepage);
+	if (resolved == CP_UTF8)
+	{
+		if ((dwflags & ~MB_ERR_INVALID_CHARS) != 0)
+			goto fallback;
+
+		result = unicode_utf8_to_utf16(unicodefast.kernels, (const uint8_t *)lpmultibytestr, count, (cchwidechar == 0) ? NULL : lpwidecharstr, cchwidechar);
+	}
+	else
+	{
+		if ((dwflags & ~MB_PRECOMPOSED) != 0)
+			goto fallback;
+
+		page = unicode_page_get(resolved);
+		if (!page || !(page->flags & UNICODE_TABLE_FLAG_VALID))
+			goto fallback;
+
+		result = unicode_sbcs_to_utf16(unicodefast.kernels, page, (const uint8_t *)lpmultibytestr, count, (cchwidechar == 0) ? NULL : lpwidecharstr, cchwidechar);
+	}
+
+	if (result == UNICODE_FALLBACK)
+		goto fallback;
+
+	return result;
+
+fallback:
+	return MultiByteToWideChar(codepage, dwflags, (char *)lpmultibytestr, cbmultibyte, lpwidecharstr, cchwidechar);
+}
+
+int STDCALL unicode_wide_char_to_multi_byte(unsigned int codepage, uint32_t dwflags, const WCHAR *lpwidecharstr, int cchwidechar, char *lpmultibytestr, int cbmultibyte, char *lpdefaultchar, BOOL *lpuseddefaultchar)
+{
+	const UNICODE_PAGE *page;
+	unsigned int resolved;
+	size_t count;
+	int result;
+
+	unicode_start();
+
+	if (!lpwidecharstr || cchwidechar == 0 || cchwidechar < -1 || cbmultibyte < 0 || (cbmultibyte > 0 && !lpmultibytestr))
+		goto fallback;
+
+	count = (cchwidechar == -1) ? unicode_string_length_w(lpwidecharstr) + 1 : (size_t)cchwidechar;
+	if (count > INT_MAX)
+		goto fallback;
+
+	resolved = unicode_resolve_page(codepage);
+	if (resolved == CP_UTF8)
+	{
+		/* The default character parameters are not valid for UTF-8 */
+		if (dwflags != 0 || lpdefaultchar || lpuseddefaultchar)
+			goto fallback;
+
+		result = unicode_utf16_to_utf8(unicodefast.kernels, lpwidecharstr, count, (cbmultibyte == 0) ? NULL : (uint8_t *)lpmultibytestr, cbmultibyte);
+	}
+	else
+	{
+		if ((dwflags & ~WC_NO_BEST_FIT_CHARS) != 0)
+			goto fallback;
+
+		page = unicode_page_get(resolved);
+		if (!page || !(page->flags & UNICODE_TABLE_FLAG_VALID))
+			goto fallback;
+
+		result = unicode_utf16_to_sbcs(unicodefast.kernels, page, lpwidecharstr, count, (cbmultibyte == 0) ? NULL : (uint8_t *)lpmultibytestr, cbmultibyte);
+		if (result != UNICODE_FALLBACK && lpuseddefaultchar)
+			*lpuseddefaultchar = FALSE;
+	}
+
+	if (result == UNICODE_FALLBACK)
+		goto fallback;
+
+	return result;
+
+fallback:
+	return WideCharToMultiByte(codepage, dwflags, (WCHAR *)lpwidecharstr, cchwidechar, lpmultibytestr, cbmultibyte, lpdefaultchar, lpuseddefaultchar);
+}
+
+uint32_t STDCALL unicode_char_upper_buff(char *lpsz, uint32_t cchlength)
+{
+	const UNICODE_LOCALE *locale;
+
+	unicode_start();
+
+	locale = unicode_locale_get();
+	if (!lpsz || !locale || !(locale->caseflags & UNICODE_TABLE_FLAG_VALID))
+		return CharUpperBuffA(lpsz, cchlength);
+
+	unicode_case_buff(unicodefast.kernels, (uint8_t *)lpsz, cchlength, locale->upper, (locale->caseflags & UNICODE_TABLE_FLAG_ASCII) != 0, TRUE);
+
+	return cchlength;
+}
+
+uint32_t STDCALL unicode_char_upper_buff_w(WCHAR *lpsz, uint32_t cchlength)
+{
+	unicode_start();
+
+	if (!lpsz || !(unicodefast.wideflags & UNICODE_TABLE_FLAG_VALID))
+		return CharUpperBuffW(lpsz, cchlength);
+
+	unicode_case_buff_w(unicodefast.kernels, lpsz, cchlength, TRUE);
+
+	return cchlength;
+}
+
+uint32_t STDCALL unicode_char_lower_buff(char *lpsz, uint32_t cchlength)
+{
+	const UNICODE_LOCALE *locale;
+
+	unicode_start();
+
+	locale = unicode_locale_get();
+	if (!lpsz || !locale || !(locale->caseflags & UNICODE_TABLE_FLAG_VALID))
+		return CharLowerBuffA(lpsz, cchlength);
+
+	unicode_case_buff(unicodefast.kernels, (uint8_t *)lpsz, cchlength, locale->lower, (locale->caseflags & UNICODE_TABLE_FLAG_ASCII) != 0, FALSE);
+
+	return cchlength;
+}
+
+uint32_t STDCALL unicode_char_lower_buff_w(WCHAR *lpsz, uint32_t cchlength)
+{
+	unicode_start();
+
+	if (!lpsz || !(unicodefast.wideflags & UNICODE_TABLE_FLAG_VALID))
+		return CharLowerBuffW(lpsz, cchlength);
+
+	unicode_case_buff_w(unicodefast.kernels, lpsz, cchlength, FALSE);
+
+	return cchlength;
+}
+
+BOOL STDCALL unicode_ansi_to_oem_buff(const char *lpszsrc, char *lpszdst, uint32_t cchdstlength)
+{
+	const UNICODE_LOCALE *locale;
+
+	unicode_start();
+
+	locale = unicode_locale_get();
+	if (!lpszsrc || !lpszdst || !locale || !(locale->translateflags & UNICODE_TABLE_FLAG_VALID))
+		return AnsiToOemBuff((char *)lpszsrc, lpszdst, cchdstlength);
+
+	return unicode_translate_buff(unicodefast.kernels, (const uint8_t *)lpszsrc, (uint8_t *)lpszdst, cchdstlength, locale->tooem, (locale->translateflags & UNICODE_TABLE_FLAG_ASCII) != 0);
+}
+
+BOOL STDCALL unicode_oem_to_ansi_buff(const char *lpszsrc, char *lpszdst, uint32_t cchdstlength)
+{
+	const UNICODE_LOCALE *locale;
+
+	unicode_start();
+
+	locale = unicode_locale_get();
+	if (!lpszsrc || !lpszdst || !locale || !(locale->translateflags & UNICODE_TABLE_FLAG_VALID))
+		return OemToAnsiBuff((char *)lpszsrc, lpszdst, cchdstlength);
+
+	return unicode_translate_buff(unicodefast.kernels, (const uint8_t *)lpszsrc, (uint8_t *)lpszdst, cchdstlength, locale->toansi, (locale->translateflags & UNICODE_TABLE_FLAG_ASCII) != 0);
+}
+
+BOOL STDCALL unicode_utf8_validate(const char *str, uint32_t len)
+{
+	if (!str)
+		return FALSE;
+
+	unicode_start();
+
+	return unicodefast.kernels->utf8_validate((const uint8_t *)str, len);
+}
+
+BOOL STDCALL unicode_utf16_validate(const WCHAR *str, uint32_t len)
+{
+	if (!str)
+		return FALSE;
+
+	unicode_start();
+
+	return unicode_utf16_check(unicodefast.kernels, str, len);
+}
+
+uint32_t STDCALL unicode_get_implementation(void)
+{
+	unicode_start();
+
+	return unicodefast.implementation;
+}
+
+uint32_t STDCALL unicode_set_implementation(uint32_t implementation)
+{
+	const UNICODE_KERNELS *kernels;
+
+	unicode_start();
+
+	switch (implementation)
+	{
+		case UNICODE_IMPL_SCALAR:
+			kernels = &unicode_scalar_kernels;
+			break;
+		case UNICODE_IMPL_WORD:
+			kernels = &unicode_word_kernels;
+			break;
+#if defined(__aarch64__) && defined(__ARM_NEON)
+		case UNICODE_IMPL_NEON:
+			kernels = &unicode_neon_kernels;
+			break;
+#endif
+		default:
+			return ERROR_NOT_SUPPORTED;
+	}
+
+	unicodefast.kernels = kernels;
+	unicodefast.implementation = implementation;
+
+	return ERROR_SUCCESS;
+}
+
+/* ============================================================================== */
+/* Unicode Helper Functions */
+/* Return the name of a fast path implementation */
+uint32_t STDCALL unicode_implementation_to_string(uint32_t implementation, char *string, uint32_t len)
+{
+	const char *name;
+
+	switch (implementation)
+	{
+		case UNICODE_IMPL_SCALAR:
+			name = "UNICODE_IMPL_SCALAR";
+			break;
+		case UNICODE_IMPL_WORD:
+			name = "UNICODE_IMPL_WORD";
+			break;
+		case UNICODE_IMPL_NEON:
+			name = "UNICODE_IMPL_NEON";
+			break;
+		default:
+			name = "UNICODE_IMPL_UNKNOWN";
+	}
+
+	if (string != NULL && len > 0)
+	{
+		strncpy(string, name, len - 1);
+		string[len - 1] = '\0';
+	}
+
+	return strlen(name);
+}
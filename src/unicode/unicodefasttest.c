@@ -0,0 +1,1042 @@
+/*
+ * This file is part of the Ultibo project, https://ultibo.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* Host test for the Unicode fast paths (unicode/unicodefast.c)
+ *
+ * This file is not part of the Ultibo run time, it includes unicodefast.c with stub
+ * versions of the thread and mutex functions and a model of the RTL conversion,
+ * case mapping and OEM/ANSI functions for code pages 1252 (ANSI) and 437 (OEM).
+ *
+ * Each available implementation is checked in two ways:
+ *
+ *  Kernels   - Every block function is compared with the scalar version on random
+ *              buffers at every alignment, with the first non ASCII character (or
+ *              surrogate) at random positions within and after the blocks
+ *
+ *  Functions - Every unicode_* function is compared with the RTL model on random
+ *              valid and invalid text with output buffers of zero, exactly the size
+ *              needed, one less than needed and larger than needed
+ *
+ * The word and NEON UTF-16 paths need a 2 byte WCHAR so the test is built with
+ * -fshort-wchar, the NEON implementation is only checked when built on an AArch64
+ * host (eg 64-bit Raspberry Pi OS) and is reported as not available elsewhere.
+ *
+ * Build and run from the root of the repository with:
+ *
+ *  gcc -std=gnu11 -g -O1 -fshort-wchar -fsanitize=address,undefined -iquote include -o unicodefasttest src/unicode/unicodefasttest.c && ./unicodefasttest
+ *
+ * An iteration count can be given as the first parameter (Default 5000).
+ */
+
+/* The Ultibo timer_create conflicts with the POSIX declaration in the host headers */
+#define timer_create host_timer_create
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+#undef timer_create
+
+/* Newlib definitions used by the Ultibo headers */
+#define _ATTRIBUTE(x) __attribute__(x)
+#define __VALIST __gnuc_va_list
+
+#include "unicodefast.c"
+
+/* ============================================================================== */
+/* Host stubs */
+#define HOST_BUFFER_SIZE	20000
+
+/* Code page tables for the RTL model (Undefined bytes of 1252 map to the C1 controls as they do on Windows) */
+static const uint16_t host_cp1252[256] =
+{
+	0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+	0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+	0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+	0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+	0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+	0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+	0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+	0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+	0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+	0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178,
+	0x00A0, 0x00A1, 0x00A2, 0x00A3, 0x00A4, 0x00A5, 0x00A6, 0x00A7, 0x00A8, 0x00A9, 0x00AA, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x00AF,
+	0x00B0, 0x00B1, 0x00B2, 0x00B3, 0x00B4, 0x00B5, 0x00B6, 0x00B7, 0x00B8, 0x00B9, 0x00BA, 0x00BB, 0x00BC, 0x00BD, 0x00BE, 0x00BF,
+	0x00C0, 0x00C1, 0x00C2, 0x00C3, 0x00C4, 0x00C5, 0x00C6, 0x00C7, 0x00C8, 0x00C9, 0x00CA, 0x00CB, 0x00CC, 0x00CD, 0x00CE, 0x00CF,
+	0x00D0, 0x00D1, 0x00D2, 0x00D3, 0x00D4, 0x00D5, 0x00D6, 0x00D7, 0x00D8, 0x00D9, 0x00DA, 0x00DB, 0x00DC, 0x00DD, 0x00DE, 0x00DF,
+	0x00E0, 0x00E1, 0x00E2, 0x00E3, 0x00E4, 0x00E5, 0x00E6, 0x00E7, 0x00E8, 0x00E9, 0x00EA, 0x00EB, 0x00EC, 0x00ED, 0x00EE, 0x00EF,
+	0x00F0, 0x00F1, 0x00F2, 0x00F3, 0x00F4, 0x00F5, 0x00F6, 0x00F7, 0x00F8, 0x00F9, 0x00FA, 0x00FB, 0x00FC, 0x00FD, 0x00FE, 0x00FF
+};
+
+static const uint16_t host_cp437[256] =
+{
+	0x0000, 0x0001, 0x0002, 0x0003, 0x0004, 0x0005, 0x0006, 0x0007, 0x0008, 0x0009, 0x000A, 0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
+	0x0010, 0x0011, 0x0012, 0x0013, 0x0014, 0x0015, 0x0016, 0x0017, 0x0018, 0x0019, 0x001A, 0x001B, 0x001C, 0x001D, 0x001E, 0x001F,
+	0x0020, 0x0021, 0x0022, 0x0023, 0x0024, 0x0025, 0x0026, 0x0027, 0x0028, 0x0029, 0x002A, 0x002B, 0x002C, 0x002D, 0x002E, 0x002F,
+	0x0030, 0x0031, 0x0032, 0x0033, 0x0034, 0x0035, 0x0036, 0x0037, 0x0038, 0x0039, 0x003A, 0x003B, 0x003C, 0x003D, 0x003E, 0x003F,
+	0x0040, 0x0041, 0x0042, 0x0043, 0x0044, 0x0045, 0x0046, 0x0047, 0x0048, 0x0049, 0x004A, 0x004B, 0x004C, 0x004D, 0x004E, 0x004F,
+	0x0050, 0x0051, 0x0052, 0x0053, 0x0054, 0x0055, 0x0056, 0x0057, 0x0058, 0x0059, 0x005A, 0x005B, 0x005C, 0x005D, 0x005E, 0x005F,
+	0x0060, 0x0061, 0x0062, 0x0063, 0x0064, 0x0065, 0x0066, 0x0067, 0x0068, 0x0069, 0x006A, 0x006B, 0x006C, 0x006D, 0x006E, 0x006F,
+	0x0070, 0x0071, 0x0072, 0x0073, 0x0074, 0x0075, 0x0076, 0x0077, 0x0078, 0x0079, 0x007A, 0x007B, 0x007C, 0x007D, 0x007E, 0x007F,
+	0x00C7, 0x00FC, 0x00E9, 0x00E2, 0x00E4, 0x00E0, 0x00E5, 0x00E7, 0x00EA, 0x00EB, 0x00E8, 0x00EF, 0x00EE, 0x00EC, 0x00C4, 0x00C5,
+	0x00C9, 0x00E6, 0x00C6, 0x00F4, 0x00F6, 0x00F2, 0x00FB, 0x00F9, 0x00FF, 0x00D6, 0x00DC, 0x00A2, 0x00A3, 0x00A5, 0x20A7, 0x0192,
+	0x00E1, 0x00ED, 0x00F3, 0x00FA, 0x00F1, 0x00D1, 0x00AA, 0x00BA, 0x00BF, 0x2310, 0x00AC, 0x00BD, 0x00BC, 0x00A1, 0x00AB, 0x00BB,
+	0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x2561, 0x2562, 0x2556, 0x2555, 0x2563, 0x2551, 0x2557, 0x255D, 0x255C, 0x255B, 0x2510,
+	0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x255E, 0x255F, 0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x2567,
+	0x2568, 0x2564, 0x2565, 0x2559, 0x2558, 0x2552, 0x2553, 0x256B, 0x256A, 0x2518, 0x250C, 0x2588, 0x2584, 0x258C, 0x2590, 0x2580,
+	0x03B1, 0x00DF, 0x0393, 0x03C0, 0x03A3, 0x03C3, 0x00B5, 0x03C4, 0x03A6, 0x0398, 0x03A9, 0x03B4, 0x221E, 0x03C6, 0x03B5, 0x2229,
+	0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248, 0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0
+};
+
+static unsigned int host_acp = 1252;
+static unsigned int host_oemcp = 437;
+
+uint32_t STDCALL thread_yield(void)
+{
+	return ERROR_SUCCESS;
+}
+
+MUTEX_HANDLE STDCALL mutex_create(void)
+{
+	return 1;
+}
+
+uint32_t STDCALL mutex_lock(MUTEX_HANDLE mutex)
+{
+	return ERROR_SUCCESS;
+}
+
+uint32_t STDCALL mutex_unlock(MUTEX_HANDLE mutex)
+{
+	return ERROR_SUCCESS;
+}
+
+unsigned int STDCALL GetACP(void)
+{
+	return host_acp;
+}
+
+unsigned int STDCALL GetOEMCP(void)
+{
+	return host_oemcp;
+}
+
+static unsigned int host_resolve_page(unsigned int codepage)
+{
+	if (codepage == CP_ACP)
+		return host_acp;
+	if (codepage == CP_OEMCP)
+		return host_oemcp;
+
+	return codepage;
+}
+
+static const uint16_t *host_page_table(unsigned int codepage)
+{
+	switch (host_resolve_page(codepage))
+	{
+		case 1252:
+			return host_cp1252;
+		case 437:
+			return host_cp437;
+	}
+
+	return NULL;
+}
+
+/* Byte for a character in a code page table or -1 if not present */
+static int host_page_reverse(const uint16_t *table, uint32_t value)
+{
+	int byte;
+
+	for (byte = 0; byte < 256; byte++)
+	{
+		if (table[byte] == value)
+			return byte;
+	}
+
+	return -1;
+}
+
+BOOL STDCALL GetCPInfo(unsigned int codepage, CPINFO *lpcpinfo)
+{
+	memset(lpcpinfo, 0, sizeof(CPINFO));
+
+	if (host_page_table(codepage))
+	{
+		lpcpinfo->maxcharsize = 1;
+		lpcpinfo->defaultchar[0] = '?';
+		return TRUE;
+	}
+
+	if (host_resolve_page(codepage) == CP_UTF8)
+	{
+		lpcpinfo->maxcharsize = 4;
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Decode by reading the length from the lead byte then checking the range of the value (Written
+   independently of unicode_utf8_decode), returns the length or minus the number of bytes to skip */
+static int host_utf8_decode(const uint8_t *source, int count, uint32_t *value)
+{
+	static const uint32_t minimum[5] = {0, 0, 0x80, 0x800, 0x10000};
+	uint32_t result = source[0];
+	int length;
+	int index;
+
+	if (result < 0x80)
+	{
+		*value = result;
+		return 1;
+	}
+
+	if ((result & 0xE0) == 0xC0)
+	{
+		length = 2;
+		result &= 0x1F;
+	}
+	else if ((result & 0xF0) == 0xE0)
+	{
+		length = 3;
+		result &= 0x0F;
+	}
+	else if ((result & 0xF8) == 0xF0)
+	{
+		length = 4;
+		result &= 0x07;
+	}
+	else
+	{
+		return -1;
+	}
+
+	for (index = 1; index < length; index++)
+	{
+		if (index >= count || (source[index] & 0xC0) != 0x80)
+			return -index;
+
+		result = (result << 6) | (source[index] & 0x3F);
+	}
+
+	if (result < minimum[length] || result > 0x10FFFF || (result >= 0xD800 && result < 0xE000))
+		return -1;
+
+	*value = result;
+	return length;
+}
+
+/* Copy a complete result to the caller, a buffer that is too small returns 0 */
+static int host_copy_result(const void *source, int count, void *dest, int len, size_t size)
+{
+	if (len == 0)
+		return count;
+
+	memcpy(dest, source, (size_t)((count < len) ? count : len) * size);
+
+	return (count > len) ? 0 : count;
+}
+
+int STDCALL MultiByteToWideChar(unsigned int codepage, uint32_t dwflags, char *lpmultibytestr, int cbmultibyte, WCHAR *lpwidecharstr, int cchwidechar)
+{
+	static WCHAR result[HOST_BUFFER_SIZE * 2];
+	const uint8_t *source = (const uint8_t *)lpmultibytestr;
+	const uint16_t *table;
+	uint32_t value;
+	int count;
+	int index;
+	int output;
+	int size;
+
+	if (!lpmultibytestr || cbmultibyte == 0 || cbmultibyte < -1 || cchwidechar < 0)
+		return 0;
+
+	count = (cbmultibyte == -1) ? (int)strlen(lpmultibytestr) + 1 : cbmultibyte;
+	output = 0;
+
+	if (host_resolve_page(codepage) == CP_UTF8)
+	{
+		value = 0;
+		index = 0;
+		while (index < count)
+		{
+			size = host_utf8_decode(source + index, count - index, &value);
+			if (size < 0)
+			{
+				if (dwflags & MB_ERR_INVALID_CHARS)
+					return 0;
+
+				result[output++] = 0xFFFD;
+				index += -size;
+				continue;
+			}
+
+			if (value >= 0x10000)
+			{
+				value -= 0x10000;
+				result[output++] = 0xD800 + (value >> 10);
+				result[output++] = 0xDC00 + (value & 0x3FF);
+			}
+			else
+			{
+				result[output++] = value;
+			}
+			index += size;
+		}
+	}
+	else
+	{
+		table = host_page_table(codepage);
+		if (!table)
+			return 0;
+
+		for (index = 0; index < count; index++)
+			result[output++] = table[source[index]];
+	}
+
+	return host_copy_result(result, output, lpwidecharstr, cchwidechar, sizeof(WCHAR));
+}
+
+int STDCALL WideCharToMultiByte(unsigned int codepage, uint32_t dwflags, WCHAR *lpwidecharstr, int cchwidechar, char *lpmultibytestr, int cbmultibyte, char *lpdefaultchar, BOOL *lpuseddefaultchar)
+{
+	static uint8_t result[HOST_BUFFER_SIZE * 4];
+	const uint16_t *table;
+	uint32_t value;
+	BOOL used;
+	int count;
+	int index;
+	int output;
+	int byte;
+
+	if (!lpwidecharstr || cchwidechar == 0 || cchwidechar < -1 || cbmultibyte < 0)
+		return 0;
+
+	if (cchwidechar == -1)
+	{
+		for (count = 0; lpwidecharstr[count]; count++)
+			;
+		count++;
+	}
+	else
+	{
+		count = cchwidechar;
+	}
+	output = 0;
+
+	if (host_resolve_page(codepage) == CP_UTF8)
+	{
+		if (dwflags || lpdefaultchar || lpuseddefaultchar)
+			return 0;
+
+		for (index = 0; index < count; index++)
+		{
+			value = lpwidecharstr[index];
+			if (value >= 0xD800 && value < 0xDC00 && index + 1 < count && lpwidecharstr[index + 1] >= 0xDC00 && lpwidecharstr[index + 1] < 0xE000)
+			{
+				value = 0x10000 + ((value - 0xD800) << 10) + (lpwidecharstr[index + 1] - 0xDC00);
+				index++;
+			}
+			else if (value >= 0xD800 && value < 0xE000)
+			{
+				value = 0xFFFD;
+			}
+
+			if (value < 0x80)
+			{
+				result[output++] = value;
+			}
+			else if (value < 0x800)
+			{
+				result[output++] = 0xC0 | (value >> 6);
+				result[output++] = 0x80 | (value & 0x3F);
+			}
+			else if (value < 0x10000)
+			{
+				result[output++] = 0xE0 | (value >> 12);
+				result[output++] = 0x80 | ((value >> 6) & 0x3F);
+				result[output++] = 0x80 | (value & 0x3F);
+			}
+			else
+			{
+				result[output++] = 0xF0 | (value >> 18);
+				result[output++] = 0x80 | ((value >> 12) & 0x3F);
+				result[output++] = 0x80 | ((value >> 6) & 0x3F);
+				result[output++] = 0x80 | (value & 0x3F);
+			}
+		}
+	}
+	else
+	{
+		table = host_page_table(codepage);
+		if (!table)
+			return 0;
+
+		used = FALSE;
+		for (index = 0; index < count; index++)
+		{
+			value = lpwidecharstr[index];
+			byte = host_page_reverse(table, value);
+
+			/* Best fit mapping of Latin Extended-A which the fast path must leave to the RTL */
+			if (byte < 0 && !(dwflags & WC_NO_BEST_FIT_CHARS) && value >= 0x100 && value < 0x180)
+				byte = 'A';
+
+			if (byte < 0)
+			{
+				byte = lpdefaultchar ? (uint8_t)*lpdefaultchar : '?';
+				used = TRUE;
+			}
+
+			result[output++] = byte;
+		}
+
+		if (lpuseddefaultchar)
+			*lpuseddefaultchar = used;
+	}
+
+	return host_copy_result(result, output, lpmultibytestr, cbmultibyte, 1);
+}
+
+static uint8_t host_upper_1252(uint8_t value)
+{
+	if ((value >= 'a' && value <= 'z') || (value >= 0xE0 && value <= 0xFE && value != 0xF7))
+		return value - 0x20;
+
+	switch (value)
+	{
+		case 0x9A:
+			return 0x8A;
+		case 0x9C:
+			return 0x8C;
+		case 0x9E:
+			return 0x8E;
+		case 0xFF:
+			return 0x9F;
+	}
+
+	return value;
+}
+
+static uint8_t host_lower_1252(uint8_t value)
+{
+	if ((value >= 'A' && value <= 'Z') || (value >= 0xC0 && value <= 0xDE && value != 0xD7))
+		return value + 0x20;
+
+	switch (value)
+	{
+		case 0x8A:
+			return 0x9A;
+		case 0x8C:
+			return 0x9C;
+		case 0x8E:
+			return 0x9E;
+		case 0x9F:
+			return 0xFF;
+	}
+
+	return value;
+}
+
+/* Includes mappings out of U+0000 to U+00FF (eg U+00FF to U+0178) which the fast path must leave to the RTL */
+static WCHAR host_upper_wide(uint32_t value)
+{
+	if (value < 0x100)
+	{
+		if (value == 0xFF)
+			return 0x178;
+		if (value == 0xB5)
+			return 0x39C;
+		if ((value >= 'a' && value <= 'z') || (value >= 0xE0 && value <= 0xFE && value != 0xF7))
+			return value - 0x20;
+		return value;
+	}
+
+	if (value < 0x180)
+		return value & ~1U;
+	if ((value >= 0x3B1 && value <= 0x3C9 && value != 0x3C2) || (value >= 0x430 && value <= 0x44F))
+		return value - 0x20;
+
+	return value;
+}
+
+static WCHAR host_lower_wide(uint32_t value)
+{
+	if (value < 0x100)
+	{
+		if ((value >= 'A' && value <= 'Z') || (value >= 0xC0 && value <= 0xDE && value != 0xD7))
+			return value + 0x20;
+		return value;
+	}
+
+	if (value == 0x178)
+		return 0xFF;
+	if (value < 0x180)
+		return value | 1U;
+	if ((value >= 0x391 && value <= 0x3A9) || (value >= 0x410 && value <= 0x42F))
+		return value + 0x20;
+
+	return value;
+}
+
+uint32_t STDCALL CharUpperBuffA(char *lpsz, uint32_t cchlength)
+{
+	uint32_t index;
+
+	for (index = 0; index < cchlength; index++)
+		lpsz[index] = host_upper_1252(lpsz[index]);
+
+	return cchlength;
+}
+
+uint32_t STDCALL CharLowerBuffA(char *lpsz, uint32_t cchlength)
+{
+	uint32_t index;
+
+	for (index = 0; index < cchlength; index++)
+		lpsz[index] = host_lower_1252(lpsz[index]);
+
+	return cchlength;
+}
+
+uint32_t STDCALL CharUpperBuffW(WCHAR *lpsz, uint32_t cchlength)
+{
+	uint32_t index;
+
+	for (index = 0; index < cchlength; index++)
+		lpsz[index] = host_upper_wide(lpsz[index]);
+
+	return cchlength;
+}
+
+uint32_t STDCALL CharLowerBuffW(WCHAR *lpsz, uint32_t cchlength)
+{
+	uint32_t index;
+
+	for (index = 0; index < cchlength; index++)
+		lpsz[index] = host_lower_wide(lpsz[index]);
+
+	return cchlength;
+}
+
+static void host_translate(const uint16_t *from, const uint16_t *to, const char *source, char *dest, uint32_t count)
+{
+	uint32_t index;
+	int byte;
+
+	for (index = 0; index < count; index++)
+	{
+		byte = host_page_reverse(to, from[(uint8_t)source[index]]);
+		dest[index] = (byte < 0) ? '?' : byte;
+	}
+}
+
+BOOL STDCALL AnsiToOemBuff(char *lpszsrc, char *lpszdst, uint32_t cchdstlength)
+{
+	host_translate(host_cp1252, host_cp437, lpszsrc, lpszdst, cchdstlength);
+
+	return TRUE;
+}
+
+BOOL STDCALL OemToAnsiBuff(char *lpszsrc, char *lpszdst, uint32_t cchdstlength)
+{
+	host_translate(host_cp437, host_cp1252, lpszsrc, lpszdst, cchdstlength);
+
+	return TRUE;
+}
+
+/* ============================================================================== */
+/* Host test */
+#define HOST_KERNEL_MAXIMUM	300 // Longest buffer for the kernel checks
+#define HOST_ALIGNMENTS	16 // Offsets from an aligned buffer for the source and dest
+
+#define HOST_CHECK(condition, ...) do { checks++; if (!(condition)) { if (failures++ < 20) { printf("FAIL: "); printf(__VA_ARGS__); printf("\n"); } } } while (0)
+
+static uint32_t failures;
+static uint32_t checks;
+
+static uint32_t host_random(void)
+{
+	static uint64_t state = 88172645463325252ULL;
+
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+
+	return (uint32_t)state;
+}
+
+static void host_put_utf8(uint8_t *dest, int *count, uint32_t value)
+{
+	if (value < 0x80)
+	{
+		dest[(*count)++] = value;
+	}
+	else if (value < 0x800)
+	{
+		dest[(*count)++] = 0xC0 | (value >> 6);
+		dest[(*count)++] = 0x80 | (value & 0x3F);
+	}
+	else if (value < 0x10000)
+	{
+		dest[(*count)++] = 0xE0 | (value >> 12);
+		dest[(*count)++] = 0x80 | ((value >> 6) & 0x3F);
+		dest[(*count)++] = 0x80 | (value & 0x3F);
+	}
+	else
+	{
+		dest[(*count)++] = 0xF0 | (value >> 18);
+		dest[(*count)++] = 0x80 | ((value >> 12) & 0x3F);
+		dest[(*count)++] = 0x80 | ((value >> 6) & 0x3F);
+		dest[(*count)++] = 0x80 | (value & 0x3F);
+	}
+}
+
+/* Runs of ASCII mixed with 2, 3 and 4 byte sequences, invalid adds stray bytes, overlong forms, surrogates and truncation */
+static int host_gen_utf8(uint8_t *dest, int maximum, BOOL invalid)
+{
+	static const uint8_t sequences[8][4] = {{0xC0, 0x80}, {0xE0, 0x80, 0x80}, {0xED, 0xA0, 0x80}, {0xF4, 0x90, 0x80, 0x80}, {0xF0, 0x80, 0x80, 0x80}, {0xC2}, {0xE2, 0x82}, {0xF5, 0x80, 0x80, 0x80}};
+	uint32_t kind;
+	uint32_t run;
+	uint32_t index;
+	uint32_t sequence;
+	int count = 0;
+
+	while (count < maximum - 8)
+	{
+		kind = host_random() % 16;
+		if (kind < 8)
+		{
+			run = host_random() % 40;
+			while (run-- > 0 && count < maximum - 8)
+				dest[count++] = 0x20 + host_random() % 0x5F;
+		}
+		else if (kind < 10)
+		{
+			host_put_utf8(dest, &count, 0x80 + host_random() % 0x780);
+		}
+		else if (kind < 12)
+		{
+			host_put_utf8(dest, &count, 0x800 + host_random() % 0xF800);
+		}
+		else if (kind < 13)
+		{
+			host_put_utf8(dest, &count, 0x10000 + host_random() % 0x100000);
+		}
+		else if (kind < 14 && invalid)
+		{
+			dest[count++] = host_random() % 256;
+		}
+		else if (kind < 15 && invalid)
+		{
+			sequence = host_random() % 8;
+			for (index = 0; index < 4 && sequences[sequence][index]; index++)
+				dest[count++] = sequences[sequence][index];
+		}
+		else if (host_random() % 4 == 0)
+		{
+			break;
+		}
+	}
+
+	/* Surrogates generated above are left in to test the rejection of encoded surrogates */
+	if (invalid && count > 0 && host_random() % 8 == 0)
+		count--;
+
+	return count;
+}
+
+/* Runs of ASCII mixed with 2 and 3 byte characters and surrogate pairs, invalid adds unpaired surrogates */
+static int host_gen_utf16(WCHAR *dest, int maximum, BOOL invalid)
+{
+	uint32_t kind;
+	uint32_t run;
+	uint32_t value;
+	int count = 0;
+
+	while (count < maximum - 4)
+	{
+		kind = host_random() % 16;
+		if (kind < 8)
+		{
+			run = host_random() % 40;
+			while (run-- > 0 && count < maximum - 4)
+				dest[count++] = 0x20 + host_random() % 0x5F;
+		}
+		else if (kind < 10)
+		{
+			dest[count++] = 0x80 + host_random() % 0x780;
+		}
+		else if (kind < 12)
+		{
+			value = 0x800 + host_random() % 0xF800;
+			if (value >= 0xD800 && value < 0xE000)
+				value -= 0x1000;
+			dest[count++] = value;
+		}
+		else if (kind < 13)
+		{
+			value = host_random() % 0x100000;
+			dest[count++] = 0xD800 + (value >> 10);
+			dest[count++] = 0xDC00 + (value & 0x3FF);
+		}
+		else if (kind < 14 && invalid)
+		{
+			dest[count++] = 0xD800 + host_random() % 0x800;
+		}
+		else if (kind < 15)
+		{
+			dest[count++] = 0xA0 + host_random() % 0x60;
+		}
+		else if (host_random() % 4 == 0)
+		{
+			break;
+		}
+	}
+
+	return count;
+}
+
+/* Text for the single byte code pages, invalid adds characters that need a best fit or default character */
+static int host_gen_latin(WCHAR *dest, int maximum, BOOL invalid)
+{
+	static const WCHAR extra[9] = {0x20AC, 0x201C, 0x201D, 0x2022, 0x0152, 0x0160, 0x2591, 0x03B1, 0x03A3};
+	uint32_t kind;
+	int count = 0;
+
+	while (count < maximum)
+	{
+		kind = host_random() % 10;
+		if (kind < 6)
+			dest[count++] = 0x20 + host_random() % 0x5F;
+		else if (kind < 8)
+			dest[count++] = 0xA0 + host_random() % 0x60;
+		else if (kind < 9)
+			dest[count++] = extra[host_random() % 9];
+		else if (invalid)
+			dest[count++] = 0x100 + host_random() % 0x200;
+		else if (host_random() % 3 == 0)
+			break;
+	}
+
+	return count;
+}
+
+/* Mostly ASCII with the first character that stops a block function at a random position (Or none) */
+static void host_gen_ascii(uint8_t *dest, size_t count)
+{
+	size_t index;
+
+	for (index = 0; index < count; index++)
+		dest[index] = host_random() % 0x80;
+
+	if (count > 0 && host_random() % 4 != 0)
+		dest[host_random() % count] = 0x80 + host_random() % 0x80;
+}
+
+static void host_gen_ascii_w(WCHAR *dest, size_t count)
+{
+	static const WCHAR stops[6] = {0x0080, 0x00FF, 0x0100, 0xD800, 0xDBFF, 0xDFFF};
+	size_t index;
+
+	for (index = 0; index < count; index++)
+		dest[index] = host_random() % 0x80;
+
+	if (count > 0 && host_random() % 4 != 0)
+	{
+		index = host_random() % count;
+		dest[index] = (host_random() % 2) ? stops[host_random() % 6] : 0x80 + host_random() % 0xFF80;
+	}
+}
+
+/* Compare every block function of an implementation with the scalar version */
+static void host_kernels(const char *name, const UNICODE_KERNELS *kernels, uint32_t iterations)
+{
+	static uint8_t source8[HOST_KERNEL_MAXIMUM + HOST_ALIGNMENTS];
+	static uint8_t dest8[2][HOST_KERNEL_MAXIMUM + HOST_ALIGNMENTS];
+	static WCHAR source16[HOST_KERNEL_MAXIMUM + HOST_ALIGNMENTS];
+	static WCHAR dest16[2][HOST_KERNEL_MAXIMUM + HOST_ALIGNMENTS];
+	const UNICODE_KERNELS *scalar = &unicode_scalar_kernels;
+	uint32_t iteration;
+	size_t expected;
+	size_t count;
+	size_t source;
+	size_t dest;
+	BOOL upper;
+
+	for (iteration = 0; iteration < iterations; iteration++)
+	{
+		count = host_random() % ((iteration % 16 == 0) ? HOST_KERNEL_MAXIMUM : 40);
+		source = host_random() % HOST_ALIGNMENTS;
+		dest = host_random() % HOST_ALIGNMENTS;
+		upper = host_random() % 2;
+
+		/* Bytes */
+		host_gen_ascii(source8 + source, count);
+
+		expected = scalar->ascii_prefix(source8 + source, count);
+		HOST_CHECK(kernels->ascii_prefix(source8 + source, count) == expected, "%s ascii_prefix count %zu offset %zu", name, count, source);
+
+		memset(dest16, 0xAA, sizeof(dest16));
+		expected = scalar->ascii_widen(source8 + source, dest16[0] + dest, count);
+		HOST_CHECK(kernels->ascii_widen(source8 + source, dest16[1] + dest, count) == expected && memcmp(dest16[0], dest16[1], sizeof(dest16[0])) == 0, "%s ascii_widen count %zu offsets %zu %zu", name, count, source, dest);
+
+		memcpy(dest8[0] + dest, source8 + source, count);
+		memcpy(dest8[1] + dest, source8 + source, count);
+		expected = scalar->ascii_case(dest8[0] + dest, count, upper);
+		HOST_CHECK(kernels->ascii_case(dest8[1] + dest, count, upper) == expected && memcmp(dest8[0] + dest, dest8[1] + dest, count) == 0, "%s ascii_case count %zu offset %zu upper %d", name, count, dest, upper);
+
+		/* UTF-16 units */
+		host_gen_ascii_w(source16 + source, count);
+
+		memset(dest8, 0xAA, sizeof(dest8));
+		expected = scalar->ascii_narrow(source16 + source, dest8[0] + dest, count);
+		HOST_CHECK(kernels->ascii_narrow(source16 + source, dest8[1] + dest, count) == expected && memcmp(dest8[0], dest8[1], sizeof(dest8[0])) == 0, "%s ascii_narrow count %zu offsets %zu %zu", name, count, source, dest);
+
+		memcpy(dest16[0] + dest, source16 + source, count * sizeof(WCHAR));
+		memcpy(dest16[1] + dest, source16 + source, count * sizeof(WCHAR));
+		expected = scalar->ascii_case_w(dest16[0] + dest, count, upper);
+		HOST_CHECK(kernels->ascii_case_w(dest16[1] + dest, count, upper) == expected && memcmp(dest16[0] + dest, dest16[1] + dest, count * sizeof(WCHAR)) == 0, "%s ascii_case_w count %zu offset %zu upper %d", name, count, dest, upper);
+
+		expected = scalar->surrogate_scan(source16 + source, count);
+		HOST_CHECK(kernels->surrogate_scan(source16 + source, count) == expected, "%s surrogate_scan count %zu offset %zu", name, count, source);
+
+		/* UTF-8 validation, and lengths of valid text */
+		count = host_gen_utf8(source8 + source, (int)count + 8, iteration % 2);
+
+		expected = scalar->utf8_validate(source8 + source, count);
+		HOST_CHECK(kernels->utf8_validate(source8 + source, count) == (BOOL)expected, "%s utf8_validate count %zu offset %zu", name, count, source);
+
+		if (expected)
+		{
+			expected = scalar->utf8_length_w(source8 + source, count);
+			HOST_CHECK(kernels->utf8_length_w(source8 + source, count) == expected, "%s utf8_length_w count %zu offset %zu", name, count, source);
+		}
+
+		count = host_gen_utf16(source16 + source, (int)count + 4, FALSE);
+
+		expected = scalar->utf16_length_8(source16 + source, count);
+		HOST_CHECK(kernels->utf16_length_8(source16 + source, count) == expected, "%s utf16_length_8 count %zu offset %zu", name, count, source);
+	}
+}
+
+static void host_check_mb(unsigned int codepage, uint32_t flags, const char *source, int count)
+{
+	static WCHAR actual[HOST_BUFFER_SIZE];
+	static WCHAR expected[HOST_BUFFER_SIZE];
+	int lengths[4];
+	int results[2];
+	int needed;
+	int index;
+
+	needed = MultiByteToWideChar(codepage, flags, (char *)source, count, NULL, 0);
+
+	lengths[0] = 0;
+	lengths[1] = needed;
+	lengths[2] = (needed > 0) ? needed - 1 : 0;
+	lengths[3] = HOST_BUFFER_SIZE;
+
+	for (index = 0; index < 4; index++)
+	{
+		memset(actual, 0xAA, sizeof(actual));
+		memset(expected, 0xAA, sizeof(expected));
+
+		results[0] = unicode_multi_byte_to_wide_char(codepage, flags, source, count, lengths[index] ? actual : NULL, lengths[index]);
+		results[1] = MultiByteToWideChar(codepage, flags, (char *)source, count, lengths[index] ? expected : NULL, lengths[index]);
+
+		HOST_CHECK(results[0] == results[1] && (results[0] <= 0 || lengths[index] == 0 || memcmp(actual, expected, results[0] * sizeof(WCHAR)) == 0),
+			"multi_byte_to_wide_char codepage %u flags %u count %d length %d: %d expected %d", codepage, (unsigned int)flags, count, lengths[index], results[0], results[1]);
+	}
+}
+
+static void host_check_wc(unsigned int codepage, uint32_t flags, const WCHAR *source, int count, BOOL useddefault)
+{
+	static char actual[HOST_BUFFER_SIZE * 4];
+	static char expected[HOST_BUFFER_SIZE * 4];
+	int lengths[4];
+	int results[2];
+	BOOL used[2];
+	int needed;
+	int index;
+
+	needed = WideCharToMultiByte(codepage, flags, (WCHAR *)source, count, NULL, 0, NULL, NULL);
+
+	lengths[0] = 0;
+	lengths[1] = needed;
+	lengths[2] = (needed > 0) ? needed - 1 : 0;
+	lengths[3] = sizeof(actual);
+
+	for (index = 0; index < 4; index++)
+	{
+		memset(actual, 0xAA, sizeof(actual));
+		memset(expected, 0xAA, sizeof(expected));
+		used[0] = used[1] = 7;
+
+		results[0] = unicode_wide_char_to_multi_byte(codepage, flags, source, count, lengths[index] ? actual : NULL, lengths[index], NULL, useddefault ? &used[0] : NULL);
+		results[1] = WideCharToMultiByte(codepage, flags, (WCHAR *)source, count, lengths[index] ? expected : NULL, lengths[index], NULL, useddefault ? &used[1] : NULL);
+
+		HOST_CHECK(results[0] == results[1] && (results[0] <= 0 || lengths[index] == 0 || memcmp(actual, expected, results[0]) == 0) && (!useddefault || results[0] == 0 || used[0] == used[1]),
+			"wide_char_to_multi_byte codepage %u flags %u count %d length %d: %d expected %d (Used %d expected %d)", codepage, (unsigned int)flags, count, lengths[index], results[0], results[1], (int)used[0], (int)used[1]);
+	}
+}
+
+/* Expected result of unicode_utf16_validate (Every surrogate is part of a pair) */
+static BOOL host_utf16_valid(const WCHAR *source, int count)
+{
+	uint32_t value;
+	int index;
+
+	for (index = 0; index < count; index++)
+	{
+		value = source[index];
+		if (value >= 0xDC00 && value < 0xE000)
+			return FALSE;
+
+		if (value >= 0xD800 && value < 0xDC00)
+		{
+			if (index + 1 >= count || source[index + 1] < 0xDC00 || source[index + 1] >= 0xE000)
+				return FALSE;
+			index++;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Compare every unicode_* function with the RTL model using the current implementation */
+static void host_functions(uint32_t iterations)
+{
+	static uint8_t text8[HOST_BUFFER_SIZE];
+	static WCHAR text16[HOST_BUFFER_SIZE];
+	static WCHAR actual16[HOST_BUFFER_SIZE];
+	static WCHAR expected16[HOST_BUFFER_SIZE];
+	static char actual8[HOST_BUFFER_SIZE];
+	static char expected8[HOST_BUFFER_SIZE];
+	static char translated[2][HOST_BUFFER_SIZE];
+	uint32_t iteration;
+	BOOL invalid;
+	int maximum;
+	int offset;
+	int count;
+	int index;
+
+	for (iteration = 0; iteration < iterations; iteration++)
+	{
+		invalid = (iteration % 3 == 0);
+		maximum = 16 + host_random() % ((iteration % 50 == 0) ? 4000 : 300);
+		offset = host_random() % HOST_ALIGNMENTS;
+
+		/* UTF-8 and the single byte code pages to UTF-16 */
+		count = host_gen_utf8(text8 + offset, maximum, invalid);
+
+		host_check_mb(CP_UTF8, 0, (char *)text8 + offset, count);
+		host_check_mb(CP_UTF8, MB_ERR_INVALID_CHARS, (char *)text8 + offset, count);
+		host_check_mb(CP_ACP, 0, (char *)text8 + offset, count);
+		host_check_mb(CP_OEMCP, 0, (char *)text8 + offset, count);
+		host_check_mb(1252, MB_PRECOMPOSED, (char *)text8 + offset, count);
+
+		HOST_CHECK(unicode_utf8_validate((char *)text8 + offset, count) == (count == 0 || MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, (char *)text8 + offset, count, NULL, 0) != 0), "utf8_validate count %d", count);
+
+		text8[offset + count] = 0;
+		if (!memchr(text8 + offset, 0, count))
+			host_check_mb(CP_UTF8, 0, (char *)text8 + offset, -1);
+
+		/* UTF-16 to UTF-8 */
+		count = host_gen_utf16(text16 + offset, maximum, invalid);
+
+		host_check_wc(CP_UTF8, 0, text16 + offset, count, FALSE);
+
+		HOST_CHECK(unicode_utf16_validate(text16 + offset, count) == host_utf16_valid(text16 + offset, count), "utf16_validate count %d", count);
+
+		/* UTF-16 to the single byte code pages */
+		count = host_gen_latin(text16 + offset, maximum, invalid);
+
+		host_check_wc(CP_ACP, 0, text16 + offset, count, iteration % 2);
+		host_check_wc(437, 0, text16 + offset, count, TRUE);
+		host_check_wc(1252, WC_NO_BEST_FIT_CHARS, text16 + offset, count, TRUE);
+
+		text16[offset + count] = 0;
+		host_check_wc(1252, 0, text16 + offset, -1, FALSE);
+
+		/* Case mapping */
+		for (index = 0; index < count; index++)
+			actual8[offset + index] = expected8[offset + index] = (host_random() % 4) ? 0x20 + host_random() % 0x5F : host_random() % 256;
+
+		HOST_CHECK(unicode_char_upper_buff(actual8 + offset, count) == CharUpperBuffA(expected8 + offset, count) && memcmp(actual8 + offset, expected8 + offset, count) == 0, "char_upper_buff count %d", count);
+		HOST_CHECK(unicode_char_lower_buff(actual8 + offset, count) == CharLowerBuffA(expected8 + offset, count) && memcmp(actual8 + offset, expected8 + offset, count) == 0, "char_lower_buff count %d", count);
+
+		memcpy(actual16 + offset, text16 + offset, count * sizeof(WCHAR));
+		memcpy(expected16 + offset, text16 + offset, count * sizeof(WCHAR));
+
+		HOST_CHECK(unicode_char_upper_buff_w(actual16 + offset, count) == CharUpperBuffW(expected16 + offset, count) && memcmp(actual16 + offset, expected16 + offset, count * sizeof(WCHAR)) == 0, "char_upper_buff_w count %d", count);
+		HOST_CHECK(unicode_char_lower_buff_w(actual16 + offset, count) == CharLowerBuffW(expected16 + offset, count) && memcmp(actual16 + offset, expected16 + offset, count * sizeof(WCHAR)) == 0, "char_lower_buff_w count %d", count);
+
+		/* OEM and ANSI to a separate buffer and in place */
+		HOST_CHECK(unicode_ansi_to_oem_buff(actual8 + offset, translated[0], count) == AnsiToOemBuff(expected8 + offset, translated[1], count) && memcmp(translated[0], translated[1], count) == 0, "ansi_to_oem_buff count %d", count);
+		HOST_CHECK(unicode_oem_to_ansi_buff(actual8 + offset, actual8 + offset, count) == OemToAnsiBuff(expected8 + offset, expected8 + offset, count) && memcmp(actual8 + offset, expected8 + offset, count) == 0, "oem_to_ansi_buff count %d", count);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	static const uint32_t implementations[3] = {UNICODE_IMPL_SCALAR, UNICODE_IMPL_WORD, UNICODE_IMPL_NEON};
+	uint32_t iterations = 5000;
+	uint32_t startfailures;
+	uint32_t startchecks;
+	uint32_t index;
+	char name[32];
+
+	setvbuf(stdout, NULL, _IONBF, 0);
+
+	if (argc > 1)
+		iterations = strtoul(argv[1], NULL, 0);
+
+	for (index = 0; index < 3; index++)
+	{
+		unicode_implementation_to_string(implementations[index], name, sizeof(name));
+
+		if (unicode_set_implementation(implementations[index]) != ERROR_SUCCESS)
+		{
+			printf("%-20s not available\n", name);
+			continue;
+		}
+
+		startfailures = failures;
+		startchecks = checks;
+
+		host_kernels(name, unicodefast.kernels, iterations * 4);
+
+		host_functions(iterations);
+
+		printf("%-20s checks %u failures %u\n", name, (unsigned int)(checks - startchecks), (unsigned int)(failures - startfailures));
+	}
+
+	printf("checks %u failures %u\n", (unsigned int)checks, (unsigned int)failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+#
+# This file is part of the Ultibo project, https://ultibo.org/
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+# Host tool to symbolize the collapsed stack output of ultibo/profiler.h
+#
+# Reads the text written by profiler_export, profiler_export_file or
+# profiler_export_log and replaces each hex address with the function name
+# found by addr2line in the kernel ELF file. The result can be passed directly
+# to flamegraph.pl or loaded into speedscope.
+#
+# The last frame of each line is the interrupted PC, every other frame is a
+# return address so 1 is subtracted before the lookup to find the call site
+# rather than the instruction after it.
+#
+# Usage:
+#
+#  profiler_symbolize.py kernel.elf profile.txt > profile.folded
+#  profiler_symbolize.py --addr2line aarch64-none-elf-addr2line kernel.elf < profile.txt
+#
+
+import argparse
+import re
+import subprocess
+import sys
+
+ADDRESS = re.compile(r'^0x[0-9a-fA-F]+$')
+
+def parse(lines):
+    """Split each collapsed line into (frames, count), lines that do not parse are passed through"""
+    result = []
+    for line in lines:
+        line = line.rstrip('\r\n')
+        stack, _, count = line.rpartition(' ')
+        if not stack or not count.isdigit():
+            result.append((None, line))
+            continue
+        result.append((stack.split(';'), count))
+    return result
+
+def lookup_addresses(parsed):
+    """Collect the lookup address of every hex frame (Return addresses minus 1)"""
+    addresses = set()
+    for frames, _ in parsed:
+        if frames is None:
+            continue
+        last = len(frames) - 1
+        for index, frame in enumerate(frames):
+            if ADDRESS.match(frame):
+                value = int(frame, 16)
+                addresses.add(value if index == last else value - 1)
+    return sorted(addresses)
+
+def symbolize(addr2line, elf, addresses, inlines):
+    """Run addr2line once for all addresses, returns a map of address to name"""
+    names = {}
+    if not addresses:
+        return names
+
+    command = [addr2line, '-f', '-C', '-a', '-e', elf]
+    if inlines:
+        command.append('-i')
+
+    output = subprocess.run(command, input='\n'.join('0x%x' % a for a in addresses) + '\n',
+                            capture_output=True, text=True, check=True).stdout.splitlines()
+
+    # With -a each result starts with the address followed by function and file:line
+    # pairs (More than one pair with -i when the address is in inlined code)
+    current = None
+    functions = []
+    index = 0
+    while index < len(output):
+        line = output[index]
+        if line.startswith('0x') and ADDRESS.match(line):
+            if current is not None:
+                names[current] = functions
+            current = int(line, 16)
+            functions = []
+            index += 1
+            continue
+        functions.append(line)
+        index += 2
+    if current is not None:
+        names[current] = functions
+
+    # Inlined frames are listed innermost first, flame graphs want the caller first
+    return {address: ';'.join(reversed([f for f in functions if f != '??'])) for address, functions in names.items()}
+
+def main():
+    parser = argparse.ArgumentParser(description='Symbolize the collapsed stack output of the Ultibo profiler')
+    parser.add_argument('elf', help='kernel ELF file the profile was captured from')
+    parser.add_argument('input', nargs='?', help='collapsed stack text (Default stdin)')
+    parser.add_argument('--addr2line', default='arm-none-eabi-addr2line', help='addr2line to use (Default arm-none-eabi-addr2line)')
+    parser.add_argument('--inlines', action='store_true', help='expand inlined functions into separate frames')
+    args = parser.parse_args()
+
+    if args.input:
+        with open(args.input, 'r') as f:
+            parsed = parse(f)
+    else:
+        parsed = parse(sys.stdin)
+
+    names = symbolize(args.addr2line, args.elf, lookup_addresses(parsed), args.inlines)
+
+    for frames, count in parsed:
+        if frames is None:
+            print(count)
+            continue
+        last = len(frames) - 1
+        output = []
+        for index, frame in enumerate(frames):
+            if ADDRESS.match(frame):
+                value = int(frame, 16)
+                name = names.get(value if index == last else value - 1)
+                output.append(name if name else frame)
+            else:
+                output.append(frame.replace(';', '_'))
+        print('%s %s' % (';'.join(output), count))
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+#
+# This file is part of the Ultibo project, https://ultibo.org/
+#
+# The MIT License (MIT)
+#
+# Copyright (c) 2025 Garry Wood <garry@softoz.com.au>
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+# Host tool to convert a binary capture of ultibo/schedtrace.h to JSON
+#
+# Reads the capture written by sched_trace_export or sched_trace_export_file
+# (SCHED_TRACE_HEADER followed by SCHED_TRACE_EVENT records in time order) and
+# writes Chrome trace event JSON for chrome://tracing or ui.perfetto.dev in the
+# same layout as sched_trace_export_json on the device.
+#
+# Thread names are not part of the binary capture, threads are shown by handle
+# unless a names file is given with one "handle name" pair per line (eg from the
+# thread list of the web status page or a thread_snapshot_create loop).
+#
+# Both 32-bit and 64-bit captures are accepted, the size of the thread handles is
+# found from the event size in the header.
+#
+# Usage:
+#
+#  schedtrace_json.py trace.bin trace.json
+#  schedtrace_json.py --names threads.txt trace.bin > trace.json
+#
+
+import argparse
+import json
+import struct
+import sys
+
+SCHED_TRACE_SIGNATURE = 0x45434152
+SCHED_TRACE_VERSION = 1
+
+SCHED_TRACE_EVENT_SWITCH = 1
+SCHED_TRACE_EVENT_MIGRATE = 2
+SCHED_TRACE_EVENT_IRQ_ENTER = 3
+SCHED_TRACE_EVENT_IRQ_EXIT = 4
+SCHED_TRACE_EVENT_WAKE = 5
+SCHED_TRACE_EVENT_READY = 6
+SCHED_TRACE_EVENT_MIGRATE_REQUEST = 7
+SCHED_TRACE_EVENT_MARK = 8
+
+SCHED_TRACE_MAX_WAKES = 256
+
+HEADER = struct.Struct('<IIIIIIQ')
+
+# Event layout for each event size (Timestamp, Type, CPU, Data, Thread, Other)
+EVENTS = {
+    24: struct.Struct('<QHHIII'),
+    32: struct.Struct('<QHHIQQ'),
+}
+
+STATE_NAMES = {
+    1: 'running',
+    2: 'ready',
+    3: 'sleep',
+    4: 'suspended',
+    5: 'wait',
+    6: 'wait',
+    7: 'receive',
+    8: 'receive',
+    9: 'halted',
+    10: 'terminated',
+}
+
+REASON_NAMES = {
+    0: 'preempt',
+    1: 'inferred',
+}
+
+class ConvertError(Exception):
+    pass
+
+def read_capture(data):
+    """Parse the header and events of a binary capture"""
+    if len(data) < HEADER.size:
+        raise ConvertError('capture is shorter than the header')
+
+    signature, version, eventsize, cpucount, clockrate, eventcount, starttime = HEADER.unpack_from(data, 0)
+    if signature != SCHED_TRACE_SIGNATURE:
+        raise ConvertError('bad signature 0x%08x (Expected 0x%08x)' % (signature, SCHED_TRACE_SIGNATURE))
+    if version != SCHED_TRACE_VERSION:
+        raise ConvertError('unsupported version %u' % version)
+    if eventsize not in EVENTS:
+        raise ConvertError('unsupported event size %u' % eventsize)
+    if clockrate == 0:
+        raise ConvertError('clock rate is zero')
+
+    event = EVENTS[eventsize]
+    available = (len(data) - HEADER.size) // eventsize
+    if available < eventcount:
+        sys.stderr.write('warning: capture truncated, %u of %u events present\n' % (available, eventcount))
+        eventcount = available
+
+    events = [event.unpack_from(data, HEADER.size + index * eventsize) for index in range(eventcount)]
+
+    return {
+        'eventsize': eventsize,
+        'cpucount': cpucount,
+        'clockrate': clockrate,
+        'starttime': starttime,
+        'events': events,
+    }
+
+def read_names(filename):
+    """Read "handle name" pairs, handles are in hex with or without a 0x prefix"""
+    names = {}
+    with open(filename, 'r') as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            handle, _, name = line.partition(' ')
+            try:
+                names[int(handle, 16)] = name.strip()
+            except ValueError:
+                continue
+    return names
+
+def convert(capture, names):
+    """Build the trace event list, matching sched_trace_export_json"""
+    cpucount = capture['cpucount']
+    clockrate = capture['clockrate']
+    starttime = capture['starttime']
+    invalid = (1 << (8 * (capture['eventsize'] - 16) // 2)) - 1
+
+    def valid(thread):
+        return thread != 0 and thread != invalid
+
+    def name(thread):
+        return names.get(thread) or 'Thread 0x%08x' % thread
+
+    def timestamp(value):
+        return round(((value - starttime) * 1000000.0) / clockrate, 3)
+
+    output = [{'name': 'process_name', 'ph': 'M', 'pid': 0, 'args': {'name': 'Ultibo'}}]
+    for cpuid in range(cpucount):
+        output.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': cpuid, 'args': {'name': 'CPU %u' % cpuid}})
+
+    wakes = {}
+    maxlatency = [0] * cpucount
+    switches = [0] * cpucount
+    irqdepth = [0] * cpucount
+    threadopen = [False] * cpucount
+    lasttime = starttime
+
+    for time, eventtype, cpuid, data, thread, other in capture['events']:
+        if cpuid >= cpucount:
+            continue
+
+        lasttime = time
+        ts = timestamp(time)
+
+        if eventtype == SCHED_TRACE_EVENT_SWITCH:
+            # Close any interrupt slices left open by a lost exit, then the previous thread
+            while irqdepth[cpuid] > 0:
+                output.append({'ph': 'E', 'ts': ts, 'pid': 0, 'tid': cpuid})
+                irqdepth[cpuid] -= 1
+            if threadopen[cpuid]:
+                output.append({'ph': 'E', 'ts': ts, 'pid': 0, 'tid': cpuid, 'args': {'state': STATE_NAMES.get(data & 0xFF, 'unknown')}})
+
+            # Wakeup latency if the next thread has a pending wake
+            latency = 0
+            if other in wakes:
+                latency = ((time - wakes.pop(other)) * 1000000) // clockrate
+                maxlatency[cpuid] = max(maxlatency[cpuid], latency)
+
+            output.append({'name': name(other), 'cat': 'thread', 'ph': 'B', 'ts': ts, 'pid': 0, 'tid': cpuid,
+                           'args': {'handle': '0x%08x' % other, 'priority': (data >> 16) & 0xFF,
+                                    'reason': REASON_NAMES.get((data >> 24) & 0xFF, 'unknown'), 'wake_latency_us': latency}})
+            threadopen[cpuid] = True
+            switches[cpuid] += 1
+        elif eventtype == SCHED_TRACE_EVENT_IRQ_ENTER:
+            # Start the interrupted thread slice if the capture began during it
+            if not threadopen[cpuid] and valid(thread):
+                output.append({'name': name(thread), 'cat': 'thread', 'ph': 'B', 'ts': ts, 'pid': 0, 'tid': cpuid,
+                               'args': {'handle': '0x%08x' % thread}})
+                threadopen[cpuid] = True
+
+            output.append({'name': 'IRQ %u' % data, 'cat': 'irq', 'ph': 'B', 'ts': ts, 'pid': 0, 'tid': cpuid})
+            irqdepth[cpuid] += 1
+        elif eventtype == SCHED_TRACE_EVENT_IRQ_EXIT:
+            if irqdepth[cpuid] > 0:
+                output.append({'ph': 'E', 'ts': ts, 'pid': 0, 'tid': cpuid})
+                irqdepth[cpuid] -= 1
+        elif eventtype in (SCHED_TRACE_EVENT_WAKE, SCHED_TRACE_EVENT_READY):
+            # Remember the time for the wakeup latency (Oldest pending entry is replaced if full)
+            if thread not in wakes:
+                if len(wakes) >= SCHED_TRACE_MAX_WAKES:
+                    del wakes[min(wakes, key=wakes.get)]
+                wakes[thread] = time
+
+            label = 'Wake' if eventtype == SCHED_TRACE_EVENT_WAKE else 'Ready'
+            output.append({'name': '%s %s' % (label, name(thread)), 'cat': 'wake', 'ph': 'i', 's': 't', 'ts': ts, 'pid': 0, 'tid': cpuid,
+                           'args': {'handle': '0x%08x' % thread}})
+        elif eventtype in (SCHED_TRACE_EVENT_MIGRATE, SCHED_TRACE_EVENT_MIGRATE_REQUEST):
+            label = 'Migrate' if eventtype == SCHED_TRACE_EVENT_MIGRATE else 'Migrate Request'
+            output.append({'name': '%s %s' % (label, name(thread)), 'cat': 'migrate', 'ph': 'i', 's': 't', 'ts': ts, 'pid': 0, 'tid': cpuid,
+                           'args': {'handle': '0x%08x' % thread, 'cpu': data}})
+        elif eventtype == SCHED_TRACE_EVENT_MARK:
+            output.append({'name': 'Mark %u' % data, 'cat': 'mark', 'ph': 'i', 's': 't', 'ts': ts, 'pid': 0, 'tid': cpuid})
+
+    # Close any open slices at the time of the last event
+    ts = timestamp(lasttime)
+    for cpuid in range(cpucount):
+        for _ in range(irqdepth[cpuid]):
+            output.append({'ph': 'E', 'ts': ts, 'pid': 0, 'tid': cpuid})
+        if threadopen[cpuid]:
+            output.append({'ph': 'E', 'ts': ts, 'pid': 0, 'tid': cpuid})
+
+    # Drop counts are not part of the binary capture (See sched_trace_get_statistics)
+    other = {'clockrate': clockrate}
+    for cpuid in range(cpucount):
+        other['cpu%u_switches' % cpuid] = switches[cpuid]
+        other['cpu%u_max_wake_latency_us' % cpuid] = maxlatency[cpuid]
+
+    return {'traceEvents': output, 'displayTimeUnit': 'ns', 'otherData': other}
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert an Ultibo scheduler trace capture to Chrome trace event JSON')
+    parser.add_argument('input', help='binary capture from sched_trace_export or sched_trace_export_file')
+    parser.add_argument('output', nargs='?', help='JSON file to write (Default stdout)')
+    parser.add_argument('--names', help='file of "handle name" pairs to name threads')
+    args = parser.parse_args()
+
+    with open(args.input, 'rb') as f:
+        data = f.read()
+
+    try:
+        capture = read_capture(data)
+    except ConvertError as error:
+        sys.stderr.write('%s: %s\n' % (args.input, error))
+        return 1
+
+    trace = convert(capture, read_names(args.names) if args.names else {})
+
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(trace, f, separators=(',', ':'))
+    else:
+        json.dump(trace, sys.stdout, separators=(',', ':'))
+        sys.stdout.write('\n')
+
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())